@@ -13,12 +13,256 @@
 #include "vtkSlicerTransformLogic.h"
 
 // MRML includes
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLScene.h"
+#include "vtkMRMLTransformNode.h"
+#include "vtkTransformDisplacementFieldCache.h"
 
 // ITK includes
 #include <itkConfigure.h>
 #include <itkFactoryRegistration.h>
 
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkOrientedBSplineTransform.h>
+#include <vtkOrientedGridTransform.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+struct ProgressRecorder
+{
+  int NumberOfProgressEvents;
+  double LastProgress;
+  bool AbortOnFirstEvent;
+};
+
+//-----------------------------------------------------------------------------
+void RecordProgress(vtkObject* caller, unsigned long, void* clientData, void* callData)
+{
+  ProgressRecorder* recorder = static_cast<ProgressRecorder*>(clientData);
+  recorder->NumberOfProgressEvents++;
+  recorder->LastProgress = *static_cast<double*>(callData);
+  if (recorder->AbortOnFirstEvent)
+    {
+    vtkSlicerTransformLogic::SafeDownCast(caller)->SetAbortConversion(true);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool TestConversions(vtkSlicerTransformLogic* logic, vtkMRMLScene* scene, vtkMRMLTransformNode* transformNode)
+{
+  // Oblique reference volume with anisotropic spacing
+  vtkNew<vtkImageData> referenceImage;
+  referenceImage->SetDimensions(120, 100, 60);
+  referenceImage->AllocateScalars(VTK_SHORT, 1);
+  vtkNew<vtkMRMLScalarVolumeNode> referenceVolumeNode;
+  referenceVolumeNode->SetAndObserveImageData(referenceImage.GetPointer());
+  referenceVolumeNode->SetOrigin(-50., 30., -20.);
+  referenceVolumeNode->SetSpacing(1.5, 1.2, 2.5);
+  double directions[3][3] = {{0.8, -0.6, 0.}, {0.6, 0.8, 0.}, {0., 0., 1.}};
+  referenceVolumeNode->SetIJKToRASDirections(directions);
+  scene->AddNode(referenceVolumeNode.GetPointer());
+
+  vtkNew<vtkCallbackCommand> progressCallback;
+  ProgressRecorder recorder = {0, 0., false};
+  progressCallback->SetCallback(RecordProgress);
+  progressCallback->SetClientData(&recorder);
+  logic->AddObserver(vtkCommand::ProgressEvent, progressCallback.GetPointer());
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  vtkMRMLTransformNode* gridTransformNode = logic->ConvertToGridTransform(transformNode, referenceVolumeNode.GetPointer());
+  timer->StopTimer();
+  if (gridTransformNode == NULL)
+    {
+    std::cerr << "Line " << __LINE__ << ": conversion to grid transform failed" << std::endl;
+    return false;
+    }
+  std::cout << "Converted " << referenceImage->GetNumberOfPoints() << " voxels to a grid transform in "
+            << timer->GetElapsedTime() << "s" << std::endl;
+  if (recorder.NumberOfProgressEvents == 0 || recorder.LastProgress != 1.0)
+    {
+    std::cerr << "Line " << __LINE__ << ": progress is not reported" << std::endl;
+    return false;
+    }
+
+  // The grid transform reproduces the input transform within the volume
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformNode->GetTransformToWorld(transformToWorld.GetPointer());
+  vtkNew<vtkGeneralTransform> gridTransformToWorld;
+  gridTransformNode->GetTransformToWorld(gridTransformToWorld.GetPointer());
+  vtkNew<vtkMatrix4x4> ijkToRas;
+  referenceVolumeNode->GetIJKToRASMatrix(ijkToRas.GetPointer());
+  double point_IJK[4] = {37.5, 61.25, 22.5, 1.};
+  double point_RAS[4] = {0., 0., 0., 1.};
+  ijkToRas->MultiplyPoint(point_IJK, point_RAS);
+  double expectedPoint_RAS[3] = {0., 0., 0.};
+  transformToWorld->TransformPoint(point_RAS, expectedPoint_RAS);
+  double gridPoint_RAS[3] = {0., 0., 0.};
+  gridTransformToWorld->TransformPoint(point_RAS, gridPoint_RAS);
+  if (sqrt(vtkMath::Distance2BetweenPoints(expectedPoint_RAS, gridPoint_RAS)) > 1e-3)
+    {
+    std::cerr << "Line " << __LINE__ << ": grid transform differs from the input transform" << std::endl;
+    return false;
+    }
+
+  // Region of interest and output spacing
+  vtkNew<vtkPoints> roiPoints;
+  roiPoints->InsertNextPoint(-20., 50., 0.);
+  roiPoints->InsertNextPoint(10., 80., 40.);
+  vtkNew<vtkPolyData> roiPolyData;
+  roiPolyData->SetPoints(roiPoints.GetPointer());
+  vtkNew<vtkMRMLModelNode> roiNode;
+  roiNode->SetAndObservePolyData(roiPolyData.GetPointer());
+  scene->AddNode(roiNode.GetPointer());
+  double outputSpacing[3] = {3., 3., 3.};
+  vtkMRMLScalarVolumeNode* displacementVolumeNode = logic->CreateDisplacementVolumeFromTransform(
+    transformNode, referenceVolumeNode.GetPointer(), false, roiNode.GetPointer(), outputSpacing);
+  if (displacementVolumeNode == NULL || displacementVolumeNode->GetImageData() == NULL)
+    {
+    std::cerr << "Line " << __LINE__ << ": displacement volume of the region cannot be created" << std::endl;
+    return false;
+    }
+  double* spacing = displacementVolumeNode->GetSpacing();
+  int* dimensions = displacementVolumeNode->GetImageData()->GetDimensions();
+  if (fabs(spacing[0] - 3.) > 1e-6 || fabs(spacing[2] - 3.) > 1e-6
+    || dimensions[0] >= 30 || dimensions[1] >= 30 || dimensions[2] != 14)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong geometry of the region: spacing " << spacing[0] << ", dimensions "
+              << dimensions[0] << "x" << dimensions[1] << "x" << dimensions[2] << std::endl;
+    return false;
+    }
+  // The region starts at the bottom of the region of interest
+  if (fabs(displacementVolumeNode->GetOrigin()[2]) > 1e-6)
+    {
+    std::cerr << "Line " << __LINE__ << ": region is not within the region of interest" << std::endl;
+    return false;
+    }
+
+  // Cancellation
+  recorder.AbortOnFirstEvent = true;
+  int numberOfNodes = scene->GetNumberOfNodes();
+  if (logic->ConvertToGridTransform(transformNode, referenceVolumeNode.GetPointer()) != NULL
+    || scene->GetNumberOfNodes() != numberOfNodes)
+    {
+    std::cerr << "Line " << __LINE__ << ": conversion is not cancelled" << std::endl;
+    return false;
+    }
+
+  logic->RemoveObserver(progressCallback.GetPointer());
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+/// Harden the transform on a sphere model and return the largest distance
+/// of the hardened points from the exactly transformed points, -1 on failure
+double HardenSphere(vtkMRMLScene* scene, vtkMRMLTransformNode* transformNode, double displacementFieldSpacingMm,
+                    bool useDefaultSpacing = false)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(30.);
+  sphere->SetThetaResolution(300);
+  sphere->SetPhiResolution(300);
+  sphere->Update();
+  vtkNew<vtkPolyData> polyData;
+  polyData->DeepCopy(sphere->GetOutput());
+  vtkNew<vtkMRMLModelNode> modelNode;
+  modelNode->SetAndObservePolyData(polyData.GetPointer());
+  scene->AddNode(modelNode.GetPointer());
+  modelNode->SetAndObserveTransformNodeID(transformNode->GetID());
+
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformNode->GetTransformToWorld(transformToWorld.GetPointer());
+  vtkNew<vtkPoints> expectedPoints;
+  transformToWorld->TransformPoints(polyData->GetPoints(), expectedPoints.GetPointer());
+
+  bool success = (useDefaultSpacing ? vtkSlicerTransformLogic::hardenTransform(modelNode.GetPointer())
+    : vtkSlicerTransformLogic::hardenTransform(modelNode.GetPointer(), displacementFieldSpacingMm));
+  vtkPoints* hardenedPoints = modelNode->GetPolyData() ? modelNode->GetPolyData()->GetPoints() : NULL;
+  double maximumError = -1.;
+  if (success && modelNode->GetParentTransformNode() == NULL && hardenedPoints != NULL
+    && hardenedPoints->GetNumberOfPoints() == expectedPoints->GetNumberOfPoints())
+    {
+    maximumError = 0.;
+    for (vtkIdType i = 0; i < expectedPoints->GetNumberOfPoints(); ++i)
+      {
+      double expectedPoint[3] = {0., 0., 0.};
+      double hardenedPoint[3] = {0., 0., 0.};
+      expectedPoints->GetPoint(i, expectedPoint);
+      hardenedPoints->GetPoint(i, hardenedPoint);
+      maximumError = std::max(maximumError, sqrt(vtkMath::Distance2BetweenPoints(expectedPoint, hardenedPoint)));
+      }
+    }
+  scene->RemoveNode(modelNode.GetPointer());
+  return maximumError;
+}
+
+//-----------------------------------------------------------------------------
+bool TestHardening(vtkMRMLScene* scene)
+{
+  vtkNew<vtkOrientedBSplineTransform> bsplineTransform;
+  vtkMRMLCoreTestingUtilities::CreateBSplineTransform(bsplineTransform.GetPointer());
+  vtkNew<vtkMRMLTransformNode> transformNode;
+  transformNode->SetAndObserveTransformToParent(bsplineTransform.GetPointer());
+  scene->AddNode(transformNode.GetPointer());
+
+  // Hardening is exact by default
+  double defaultError = HardenSphere(scene, transformNode.GetPointer(), 0., true);
+  if (defaultError < 0. || defaultError > 1e-6)
+    {
+    std::cerr << "Line " << __LINE__ << ": default hardening is not exact, error: " << defaultError << "mm" << std::endl;
+    return false;
+    }
+  double exactError = HardenSphere(scene, transformNode.GetPointer(), 0.);
+  if (exactError < 0. || exactError > 1e-6)
+    {
+    std::cerr << "Line " << __LINE__ << ": exact hardening error: " << exactError << "mm" << std::endl;
+    return false;
+    }
+
+  // The sphere has more points than a 2mm displacement field around it has samples,
+  // the points are interpolated from the field
+  double approximationError = HardenSphere(scene, transformNode.GetPointer(), 2.);
+  std::cout << "Hardening through a 2mm displacement field, maximum error: " << approximationError << "mm" << std::endl;
+  if (approximationError < 0. || approximationError > 0.05)
+    {
+    std::cerr << "Line " << __LINE__ << ": approximate hardening error: " << approximationError << "mm" << std::endl;
+    return false;
+    }
+
+  // The field is kept by the transform node and reused for the next model it covers
+  vtkOrientedGridTransform* fieldTransform = transformNode->GetDisplacementFieldCache()->GetTransformToWorld();
+  double secondApproximationError = HardenSphere(scene, transformNode.GetPointer(), 2.);
+  if (fieldTransform == NULL || transformNode->GetDisplacementFieldCache()->GetTransformToWorld() != fieldTransform
+    || secondApproximationError != approximationError)
+    {
+    std::cerr << "Line " << __LINE__ << ": displacement field of the transform is not reused" << std::endl;
+    return false;
+    }
+
+  scene->RemoveNode(transformNode.GetPointer());
+  return true;
+}
+
+} // end of anonymous namespace
+
 //-----------------------------------------------------------------------------
 int vtkSlicerTransformLogicTest1(int argc, char * argv [])
 {
@@ -47,6 +291,16 @@ int vtkSlicerTransformLogicTest1(int argc, char * argv [])
     return EXIT_FAILURE;
     }
 
+  if (!TestConversions(transformModuleLogic, scene, transform))
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!TestHardening(scene))
+    {
+    return EXIT_FAILURE;
+    }
+
   transformModuleLogic->Delete();
   scene->Delete();
 
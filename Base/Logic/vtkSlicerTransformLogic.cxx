@@ -15,8 +15,10 @@
 #include "vtkCacheManager.h"
 #include "vtkMRMLBSplineTransformNode.h"
 #include "vtkMRMLColorNode.h"
+#include "vtkMRMLDisplayableNode.h"
 #include "vtkMRMLGridTransformNode.h"
 #include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLModelNode.h"
 #include "vtkMRMLScalarVolumeDisplayNode.h"
 #include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLScene.h"
@@ -24,6 +26,7 @@
 #include "vtkMRMLTransformDisplayNode.h"
 #include "vtkMRMLTransformStorageNode.h"
 #include "vtkMRMLVectorVolumeDisplayNode.h"
+#include "vtkTransformDisplacementFieldCache.h"
 
 // ITKsys includes
 #include <itksys/SystemTools.hxx>
@@ -31,6 +34,7 @@
 // VTK includes
 #include <vtkAppendPolyData.h>
 #include <vtkCollection.h>
+#include <vtkCommand.h>
 #include <vtkArrowSource.h>
 #include <vtkConeSource.h>
 #include <vtkContourFilter.h>
@@ -42,6 +46,7 @@
 #include <vtkLine.h>
 #include <vtkLookupTable.h>
 #include <vtkMath.h>
+#include <vtkMultiThreader.h>
 #include <vtkTransform.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
@@ -50,6 +55,8 @@
 #include <vtkPoints.h>
 #include <vtkPointSet.h>
 #include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSimpleCriticalSection.h>
 #include <vtkSphereSource.h>
 #include <vtkThinPlateSplineTransform.h>
 #include <vtkTransform.h>
@@ -75,11 +82,119 @@
 #include "itkTranslationTransform.h"
 #include "itkTransformFactory.h"
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Tiles of an image to fill with transform displacements, the threads take the next tile from the list
+struct DisplacementSamplingJob
+{
+  vtkAbstractTransform* Transform;
+  double IjkToRas[3][4];
+  int Dimensions[3];
+  bool Magnitude;
+  float* Voxels;
+  int RowsPerTile;
+  int TilesPerSlice;
+  int NumberOfTiles;
+  int NextTile;
+  int NumberOfCompletedTiles;
+  bool Aborted;
+  vtkSlicerTransformLogic* ProgressLogic;
+  vtkSimpleCriticalSection Lock;
+};
+
+//----------------------------------------------------------------------------
+void SampleDisplacementTile(DisplacementSamplingJob* job, int tile)
+{
+  int k = tile / job->TilesPerSlice;
+  int firstRow = (tile % job->TilesPerSlice) * job->RowsPerTile;
+  int lastRow = std::min(firstRow + job->RowsPerTile, job->Dimensions[1]);
+  int numberOfComponents = (job->Magnitude ? 1 : 3);
+  double (*ijkToRas)[4] = job->IjkToRas;
+
+  double point_RAS[3] = {0,0,0};
+  double transformedPoint_RAS[3] = {0,0,0};
+  for (int j = firstRow; j < lastRow; j++)
+    {
+    float* voxelPtr = job->Voxels + numberOfComponents * (static_cast<vtkIdType>(k) * job->Dimensions[1] + j) * job->Dimensions[0];
+    for (int i = 0; i < job->Dimensions[0]; i++)
+      {
+      for (int row = 0; row < 3; row++)
+        {
+        point_RAS[row] = ijkToRas[row][0]*i + ijkToRas[row][1]*j + ijkToRas[row][2]*k + ijkToRas[row][3];
+        }
+      job->Transform->InternalTransformPoint(point_RAS, transformedPoint_RAS);
+      double displacement_RAS[3] =
+        {
+        transformedPoint_RAS[0] - point_RAS[0],
+        transformedPoint_RAS[1] - point_RAS[1],
+        transformedPoint_RAS[2] - point_RAS[2]
+        };
+      if (job->Magnitude)
+        {
+        *(voxelPtr++) = static_cast<float>(vtkMath::Norm(displacement_RAS));
+        }
+      else
+        {
+        *(voxelPtr++) = static_cast<float>(displacement_RAS[0]);
+        *(voxelPtr++) = static_cast<float>(displacement_RAS[1]);
+        *(voxelPtr++) = static_cast<float>(displacement_RAS[2]);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Sample tiles until the list is exhausted or the sampling is aborted.
+/// The first thread runs in the calling thread, therefore it reports the progress.
+VTK_THREAD_RETURN_TYPE SampleDisplacementThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  DisplacementSamplingJob* job = static_cast<DisplacementSamplingJob*>(threadInfo->UserData);
+  bool reportProgress = (threadInfo->ThreadID == 0 && job->ProgressLogic != NULL);
+  while (true)
+    {
+    job->Lock.Lock();
+    int tile = job->NextTile++;
+    bool aborted = job->Aborted;
+    job->Lock.Unlock();
+    if (aborted || tile >= job->NumberOfTiles)
+      {
+      break;
+      }
+
+    SampleDisplacementTile(job, tile);
+
+    job->Lock.Lock();
+    double progress = double(++job->NumberOfCompletedTiles) / job->NumberOfTiles;
+    job->Lock.Unlock();
+    if (reportProgress)
+      {
+      job->ProgressLogic->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+      if (job->ProgressLogic->GetAbortConversion())
+        {
+        job->Lock.Lock();
+        job->Aborted = true;
+        job->Lock.Unlock();
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
 vtkStandardNewMacro(vtkSlicerTransformLogic);
 
 //----------------------------------------------------------------------------
 vtkSlicerTransformLogic::vtkSlicerTransformLogic()
 {
+  this->AbortConversion = false;
 }
 
 //----------------------------------------------------------------------------
@@ -88,7 +203,7 @@ vtkSlicerTransformLogic::~vtkSlicerTransformLogic()
 }
 
 //-----------------------------------------------------------------------------
-bool vtkSlicerTransformLogic::hardenTransform(vtkMRMLTransformableNode* transformableNode)
+bool vtkSlicerTransformLogic::hardenTransform(vtkMRMLTransformableNode* transformableNode, double displacementFieldSpacingMm/*=0.0*/)
 {
   vtkMRMLTransformNode* transformNode =
     transformableNode ? transformableNode->GetParentTransformNode() : 0;
@@ -104,9 +219,41 @@ bool vtkSlicerTransformLogic::hardenTransform(vtkMRMLTransformableNode* transfor
     }
   else
     {
-    vtkNew<vtkGeneralTransform> hardeningTransform;
-    transformNode->GetTransformToWorld(hardeningTransform.GetPointer());
-    transformableNode->ApplyTransform(hardeningTransform.GetPointer());
+    // Models are warped by the displacement field of the transform sampled around them,
+    // when the field has fewer samples than the model has points. The field is kept by
+    // the transform node and reused for the next models it covers.
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(transformableNode);
+    vtkPolyData* polyData = modelNode ? modelNode->GetPolyData() : NULL;
+    vtkOrientedGridTransform* fieldTransform = NULL;
+    if (polyData && polyData->GetNumberOfPoints() > 0 && displacementFieldSpacingMm > 0)
+      {
+      vtkTransformDisplacementFieldCache* displacementField = transformNode->GetDisplacementFieldCache();
+      displacementField->ComputeInverseOff();
+      double* modelBounds = polyData->GetBounds();
+      if (displacementField->GetSpacing() != displacementFieldSpacingMm
+        || !displacementField->ContainsBounds(modelBounds))
+        {
+        displacementField->SetBounds(modelBounds);
+        displacementField->SetSpacing(displacementFieldSpacingMm);
+        }
+      int fieldDimensions[3] = {0,0,0};
+      displacementField->GetFieldDimensions(fieldDimensions);
+      double numberOfFieldSamples = double(fieldDimensions[0])*fieldDimensions[1]*fieldDimensions[2];
+      if (numberOfFieldSamples < polyData->GetNumberOfPoints())
+        {
+        fieldTransform = displacementField->GetTransformToWorld();
+        }
+      }
+    if (fieldTransform)
+      {
+      transformableNode->ApplyTransform(fieldTransform);
+      }
+    else
+      {
+      vtkNew<vtkGeneralTransform> hardeningTransform;
+      transformNode->GetTransformToWorld(hardeningTransform.GetPointer());
+      transformableNode->ApplyTransform(hardeningTransform.GetPointer());
+      }
     }
 
   transformableNode->SetAndObserveTransformNodeID(NULL);
@@ -244,8 +391,6 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
   inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
 
   double point_RAS[4] = {0,0,0,1};
-  double transformedPoint_RAS[4] = {0,0,0,1};
-  double pointDislocationVector_RAS[4] = {0,0,0,1};
   double point_Grid[4]={0,0,0,1};
   int sampleIndex=0;
   for (point_Grid[2]=0; point_Grid[2]<gridSize[2]; point_Grid[2]++)
@@ -255,20 +400,27 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
       for (point_Grid[0]=0; point_Grid[0]<gridSize[0]; point_Grid[0]++)
         {
         gridToRAS->MultiplyPoint(point_Grid, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-        pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-        pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
-
         samplePositions_RAS->SetPoint(sampleIndex, point_RAS[0], point_RAS[1], point_RAS[2]);
-        sampleVectors_RAS->SetTuple3(sampleIndex,pointDislocationVector_RAS[0], pointDislocationVector_RAS[1], pointDislocationVector_RAS[2]);
         sampleIndex++;
         }
       }
     }
 
+  // The transform is evaluated on all the samples at once, by multiple threads
+  vtkNew<vtkPoints> transformedSamplePositions_RAS;
+  transformedSamplePositions_RAS->SetDataTypeToDouble();
+  vtkTransformDisplacementFieldCache::TransformPointsExact(inputTransform.GetPointer(),
+    samplePositions_RAS.GetPointer(), transformedSamplePositions_RAS.GetPointer());
+
+  double transformedPoint_RAS[3] = {0,0,0};
+  for (sampleIndex=0; sampleIndex<numOfSamples; sampleIndex++)
+    {
+    samplePositions_RAS->GetPoint(sampleIndex, point_RAS);
+    transformedSamplePositions_RAS->GetPoint(sampleIndex, transformedPoint_RAS);
+    sampleVectors_RAS->SetTuple3(sampleIndex,
+      transformedPoint_RAS[0] - point_RAS[0], transformedPoint_RAS[1] - point_RAS[1], transformedPoint_RAS[2] - point_RAS[2]);
+    }
+
   outputPointSet->SetPoints(samplePositions_RAS.GetPointer());
   vtkPointData* pointData = outputPointSet->GetPointData();
   pointData->SetVectors(sampleVectors_RAS.GetPointer());
@@ -340,82 +492,44 @@ void vtkSlicerTransformLogic::GetTransformedPointSamplesOnSlice(vtkPointSet* out
 //----------------------------------------------------------------------------
 void vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(vtkImageData* magnitudeImage, vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* ijkToRAS)
 {
-  if (!inputTransformNode)
-    {
-    return;
-    }
-  vtkNew<vtkGeneralTransform> inputTransform;
-  inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-
-  int* extent=magnitudeImage->GetExtent();
-  int imageSize[3]={extent[1]-extent[0]+1, extent[3]-extent[2]+1, extent[5]-extent[4]+1};
-
-  // The orientation of the volume cannot be set in the image
-  // therefore the volume will not appear in the correct position
-  // if the direction matrix is not identity.
-  magnitudeImage->AllocateScalars(VTK_FLOAT, 1);
-
-  double point_RAS[4] = {0,0,0,1};
-  double transformedPoint_RAS[4] = {0,0,0,1};
-  double pointDislocationVector_RAS[4] = {0,0,0,1};
-  double point_IJK[4]={0,0,0,1};
-  float* voxelPtr=static_cast<float*>(magnitudeImage->GetScalarPointer());
-  for (point_IJK[2]=0; point_IJK[2]<imageSize[2]; point_IJK[2]++)
-    {
-    for (point_IJK[1]=0; point_IJK[1]<imageSize[1]; point_IJK[1]++)
-      {
-      for (point_IJK[0]=0; point_IJK[0]<imageSize[0]; point_IJK[0]++)
-        {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-        pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-        pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
-
-        float mag=sqrt(
-          pointDislocationVector_RAS[0]*pointDislocationVector_RAS[0]+
-          pointDislocationVector_RAS[1]*pointDislocationVector_RAS[1]+
-          pointDislocationVector_RAS[2]*pointDislocationVector_RAS[2]);
-
-        *(voxelPtr++)=mag;
-        }
-      }
-    }
+  vtkSlicerTransformLogic::SampleDisplacementImage(magnitudeImage, inputTransformNode, ijkToRAS, true, NULL);
 }
 
 //----------------------------------------------------------------------------
-vtkMRMLScalarVolumeNode* vtkSlicerTransformLogic::CreateDisplacementVolumeFromTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode, bool magnitude/*=true*/)
+vtkMRMLScalarVolumeNode* vtkSlicerTransformLogic::CreateDisplacementVolumeFromTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode, bool magnitude/*=true*/,
+  vtkMRMLDisplayableNode* roiNode/*=NULL*/, double* outputSpacing/*=NULL*/)
 {
   if (inputTransformNode==NULL || referenceVolumeNode==NULL || referenceVolumeNode->GetImageData()==NULL)
     {
-    vtkErrorMacro("vtkSlicerTransformLogic::CreateDisplacementMagnitudeVolumeFromTransform failed: inputs are invalid");
+    vtkErrorMacro("vtkSlicerTransformLogic::CreateDisplacementVolumeFromTransform failed: inputs are invalid");
     return NULL;
     }
   vtkMRMLScene* scene=this->GetMRMLScene();
   if (scene==NULL)
     {
-    vtkErrorMacro("vtkSlicerTransformLogic::CreateDisplacementMagnitudeVolumeFromTransform failed: scene invalid");
+    vtkErrorMacro("vtkSlicerTransformLogic::CreateDisplacementVolumeFromTransform failed: scene invalid");
     return NULL;
     }
 
-  // Fill the volume
-  vtkNew<vtkImageData> outputVolume;
-  outputVolume->SetExtent(referenceVolumeNode->GetImageData()->GetExtent());
   vtkNew<vtkMatrix4x4> ijkToRas;
-  referenceVolumeNode->GetIJKToRASMatrix(ijkToRas.GetPointer());
-  std::string nodeName=inputTransformNode->GetName();
-  if (magnitude)
+  int extent[6]={0,-1,0,-1,0,-1};
+  if (!vtkSlicerTransformLogic::GetSamplingGeometry(referenceVolumeNode, roiNode, outputSpacing, ijkToRas.GetPointer(), extent))
     {
-    vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(outputVolume.GetPointer(), inputTransformNode, ijkToRas.GetPointer());
-    nodeName+=" displacement magnitude";
+    vtkErrorMacro("vtkSlicerTransformLogic::CreateDisplacementVolumeFromTransform failed: the sampled region is empty");
+    return NULL;
     }
-  else
+
+  // Fill the volume
+  this->AbortConversion = false;
+  vtkNew<vtkImageData> outputVolume;
+  outputVolume->SetExtent(extent);
+  std::string nodeName=inputTransformNode->GetName();
+  if (!vtkSlicerTransformLogic::SampleDisplacementImage(outputVolume.GetPointer(), inputTransformNode, ijkToRas.GetPointer(), magnitude, this))
     {
-    vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(outputVolume.GetPointer(), inputTransformNode, ijkToRas.GetPointer());
-    nodeName+=" displacement vectors";
+    vtkDebugMacro("vtkSlicerTransformLogic::CreateDisplacementVolumeFromTransform: conversion aborted");
+    return NULL;
     }
+  nodeName+=(magnitude ? " displacement magnitude" : " displacement vectors");
 
   // Create a volume node
   vtkNew<vtkMRMLScalarVolumeNode> outputVolumeNode;
@@ -444,7 +558,8 @@ vtkMRMLScalarVolumeNode* vtkSlicerTransformLogic::CreateDisplacementVolumeFromTr
 }
 
 //----------------------------------------------------------------------------
-vtkMRMLTransformNode* vtkSlicerTransformLogic::ConvertToGridTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode)
+vtkMRMLTransformNode* vtkSlicerTransformLogic::ConvertToGridTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode,
+  vtkMRMLDisplayableNode* roiNode/*=NULL*/, double* outputSpacing/*=NULL*/)
 {
   if (inputTransformNode==NULL || referenceVolumeNode==NULL || referenceVolumeNode->GetImageData()==NULL)
     {
@@ -458,12 +573,23 @@ vtkMRMLTransformNode* vtkSlicerTransformLogic::ConvertToGridTransform(vtkMRMLTra
     return NULL;
     }
 
+  vtkNew<vtkMatrix4x4> ijkToRas;
+  int extent[6]={0,-1,0,-1,0,-1};
+  if (!vtkSlicerTransformLogic::GetSamplingGeometry(referenceVolumeNode, roiNode, outputSpacing, ijkToRas.GetPointer(), extent))
+    {
+    vtkErrorMacro("vtkSlicerTransformLogic::ConvertToGridTransform failed: the sampled region is empty");
+    return NULL;
+    }
+
   // Fill the volume
+  this->AbortConversion = false;
   vtkNew<vtkImageData> outputVolume;
-  outputVolume->SetExtent(referenceVolumeNode->GetImageData()->GetExtent());
-  vtkNew<vtkMatrix4x4> ijkToRas;
-  referenceVolumeNode->GetIJKToRASMatrix(ijkToRas.GetPointer());
-  vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(outputVolume.GetPointer(), inputTransformNode, ijkToRas.GetPointer());
+  outputVolume->SetExtent(extent);
+  if (!vtkSlicerTransformLogic::SampleDisplacementImage(outputVolume.GetPointer(), inputTransformNode, ijkToRas.GetPointer(), false, this))
+    {
+    vtkDebugMacro("vtkSlicerTransformLogic::ConvertToGridTransform: conversion aborted");
+    return NULL;
+    }
 
   // Create a volume node
   vtkNew<vtkMRMLTransformNode> outputGridTransformNode;
@@ -473,11 +599,21 @@ vtkMRMLTransformNode* vtkSlicerTransformLogic::ConvertToGridTransform(vtkMRMLTra
   vtkNew<vtkOrientedGridTransform> outputGridTransform;
   // The output volume has unit spacing and zero origin (because ijkToRas contains origin, spacing, and directions)
   // so we have to set it here
-  outputVolume->SetOrigin(referenceVolumeNode->GetOrigin());
-  outputVolume->SetSpacing(referenceVolumeNode->GetSpacing());
-  // Volume cannot store directions, therefore that has to be set in the grid transform
+  double spacing[3]={0,0,0};
   vtkNew<vtkMatrix4x4> ijkToRasDirection; // normalized direction matrix
-  referenceVolumeNode->GetIJKToRASDirectionMatrix(ijkToRasDirection.GetPointer());
+  for (int column=0; column<3; column++)
+    {
+    spacing[column]=sqrt(ijkToRas->Element[0][column]*ijkToRas->Element[0][column]
+      +ijkToRas->Element[1][column]*ijkToRas->Element[1][column]
+      +ijkToRas->Element[2][column]*ijkToRas->Element[2][column]);
+    for (int row=0; row<3; row++)
+      {
+      ijkToRasDirection->SetElement(row, column, ijkToRas->Element[row][column]/spacing[column]);
+      }
+    }
+  outputVolume->SetOrigin(ijkToRas->Element[0][3], ijkToRas->Element[1][3], ijkToRas->Element[2][3]);
+  outputVolume->SetSpacing(spacing);
+  // Volume cannot store directions, therefore that has to be set in the grid transform
   outputGridTransform->SetGridDirectionMatrix(ijkToRasDirection.GetPointer());
   outputGridTransform->SetDisplacementGridData(outputVolume.GetPointer());
 
@@ -490,42 +626,162 @@ vtkMRMLTransformNode* vtkSlicerTransformLogic::ConvertToGridTransform(vtkMRMLTra
 //----------------------------------------------------------------------------
 void vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(vtkImageData* vectorImage, vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* ijkToRAS)
 {
-  if (!inputTransformNode)
+  vtkSlicerTransformLogic::SampleDisplacementImage(vectorImage, inputTransformNode, ijkToRAS, false, NULL);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformLogic::GetSamplingGeometry(vtkMRMLVolumeNode* referenceVolumeNode, vtkMRMLDisplayableNode* roiNode,
+  double* outputSpacing, vtkMatrix4x4* ijkToRAS, int extent[6])
+{
+  if (referenceVolumeNode==NULL || referenceVolumeNode->GetImageData()==NULL || ijkToRAS==NULL)
     {
-    return;
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> directions;
+  referenceVolumeNode->GetIJKToRASDirectionMatrix(directions.GetPointer());
+  double* origin=referenceVolumeNode->GetOrigin();
+  double* referenceSpacing=referenceVolumeNode->GetSpacing();
+  int* referenceExtent=referenceVolumeNode->GetImageData()->GetExtent();
+
+  // Sampled region in mm along the reference axes, from the reference origin
+  double region[6]={0,0,0,0,0,0};
+  for (int axis=0; axis<3; axis++)
+    {
+    region[2*axis]=referenceExtent[2*axis]*referenceSpacing[axis];
+    region[2*axis+1]=referenceExtent[2*axis+1]*referenceSpacing[axis];
+    }
+  if (roiNode)
+    {
+    double roiBounds_RAS[6]={0,-1,0,-1,0,-1};
+    roiNode->GetRASBounds(roiBounds_RAS);
+    if (roiBounds_RAS[0]>roiBounds_RAS[1] || roiBounds_RAS[2]>roiBounds_RAS[3] || roiBounds_RAS[4]>roiBounds_RAS[5])
+      {
+      return false;
+      }
+    double roiRegion[6]={VTK_DOUBLE_MAX,-VTK_DOUBLE_MAX,VTK_DOUBLE_MAX,-VTK_DOUBLE_MAX,VTK_DOUBLE_MAX,-VTK_DOUBLE_MAX};
+    for (int corner=0; corner<8; corner++)
+      {
+      double cornerOffset_RAS[3]=
+        {
+        roiBounds_RAS[(corner&1) ? 1 : 0]-origin[0],
+        roiBounds_RAS[(corner&2) ? 3 : 2]-origin[1],
+        roiBounds_RAS[(corner&4) ? 5 : 4]-origin[2]
+        };
+      for (int axis=0; axis<3; axis++)
+        {
+        double position=directions->Element[0][axis]*cornerOffset_RAS[0]
+          +directions->Element[1][axis]*cornerOffset_RAS[1]
+          +directions->Element[2][axis]*cornerOffset_RAS[2];
+        roiRegion[2*axis]=std::min(roiRegion[2*axis], position);
+        roiRegion[2*axis+1]=std::max(roiRegion[2*axis+1], position);
+        }
+      }
+    for (int axis=0; axis<3; axis++)
+      {
+      region[2*axis]=std::max(region[2*axis], roiRegion[2*axis]);
+      region[2*axis+1]=std::min(region[2*axis+1], roiRegion[2*axis+1]);
+      if (region[2*axis]>region[2*axis+1])
+        {
+        return false;
+        }
+      }
+    }
+
+  double spacing[3]={referenceSpacing[0], referenceSpacing[1], referenceSpacing[2]};
+  if (outputSpacing)
+    {
+    if (outputSpacing[0]<=0 || outputSpacing[1]<=0 || outputSpacing[2]<=0)
+      {
+      return false;
+      }
+    spacing[0]=outputSpacing[0];
+    spacing[1]=outputSpacing[1];
+    spacing[2]=outputSpacing[2];
+    }
+
+  ijkToRAS->Identity();
+  for (int row=0; row<3; row++)
+    {
+    double regionOrigin=origin[row];
+    for (int axis=0; axis<3; axis++)
+      {
+      ijkToRAS->SetElement(row, axis, directions->Element[row][axis]*spacing[axis]);
+      regionOrigin+=directions->Element[row][axis]*region[2*axis];
+      }
+    ijkToRAS->SetElement(row, 3, regionOrigin);
+    }
+  for (int axis=0; axis<3; axis++)
+    {
+    extent[2*axis]=0;
+    extent[2*axis+1]=static_cast<int>(floor((region[2*axis+1]-region[2*axis])/spacing[axis]+1e-6));
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTransformLogic::SampleDisplacementImage(vtkImageData* outputImage, vtkMRMLTransformNode* inputTransformNode,
+  vtkMatrix4x4* ijkToRAS, bool magnitude, vtkSlicerTransformLogic* progressLogic)
+{
+  if (!inputTransformNode || !outputImage || !ijkToRAS)
+    {
+    return false;
     }
   vtkNew<vtkGeneralTransform> inputTransform;
   inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
+  // The threads only evaluate the transform
+  inputTransform->Update();
 
-  int* extent=vectorImage->GetExtent();
-  int imageSize[3]={extent[1]-extent[0]+1, extent[3]-extent[2]+1, extent[5]-extent[4]+1};
+  int* extent=outputImage->GetExtent();
+  DisplacementSamplingJob job;
+  job.Dimensions[0]=extent[1]-extent[0]+1;
+  job.Dimensions[1]=extent[3]-extent[2]+1;
+  job.Dimensions[2]=extent[5]-extent[4]+1;
 
   // The orientation of the volume cannot be set in the image
   // therefore the volume will not appear in the correct position
   // if the direction matrix is not identity.
-  vectorImage->AllocateScalars(VTK_FLOAT, 3);
+  outputImage->AllocateScalars(VTK_FLOAT, magnitude ? 1 : 3);
+  if (job.Dimensions[0]<=0 || job.Dimensions[1]<=0 || job.Dimensions[2]<=0)
+    {
+    return true;
+    }
 
-  double point_RAS[4] = {0,0,0,1};
-  double transformedPoint_RAS[4] = {0,0,0,1};
-  double point_IJK[4]={0,0,0,1};
-  float* voxelPtr=static_cast<float*>(vectorImage->GetScalarPointer());
-  for (point_IJK[2]=0; point_IJK[2]<imageSize[2]; point_IJK[2]++)
+  job.Transform=inputTransform.GetPointer();
+  for (int row=0; row<3; row++)
     {
-    for (point_IJK[1]=0; point_IJK[1]<imageSize[1]; point_IJK[1]++)
+    for (int column=0; column<4; column++)
       {
-      for (point_IJK[0]=0; point_IJK[0]<imageSize[0]; point_IJK[0]++)
-        {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        // store the pointDislocationVector_RAS components in the image
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[0] - point_RAS[0]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[1] - point_RAS[1]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[2] - point_RAS[2]);
-        }
+      job.IjkToRas[row][column]=ijkToRAS->GetElement(row, column);
       }
     }
+  job.Magnitude=magnitude;
+  job.Voxels=static_cast<float*>(outputImage->GetScalarPointer());
+  // Tiles of about 16k voxels, so that the load is balanced and the progress is reported often
+  job.RowsPerTile=std::max(1, std::min(job.Dimensions[1], 16384/job.Dimensions[0]));
+  job.TilesPerSlice=(job.Dimensions[1]+job.RowsPerTile-1)/job.RowsPerTile;
+  job.NumberOfTiles=job.TilesPerSlice*job.Dimensions[2];
+  job.NextTile=0;
+  job.NumberOfCompletedTiles=0;
+  job.Aborted=false;
+  job.ProgressLogic=progressLogic;
+
+  int numberOfThreads=std::max(1, std::min(vtkMultiThreader::GetGlobalDefaultNumberOfThreads(), job.NumberOfTiles));
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(SampleDisplacementThread, &job);
+  threader->SingleMethodExecute();
+  outputImage->Modified();
+
+  // The first thread may not complete the last tile, the completion is reported here.
+  // The observers can still cancel the conversion.
+  if (progressLogic && !job.Aborted)
+    {
+    double progress=1.0;
+    progressLogic->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+    job.Aborted=progressLogic->GetAbortConversion();
+    }
+
+  return !job.Aborted;
 }
 
 //----------------------------------------------------------------------------
@@ -27,6 +27,7 @@
 #include <vtkMRMLAbstractLogic.h>
 
 // MRML includes
+class vtkMRMLDisplayableNode;
 class vtkMRMLScene;
 class vtkMRMLSliceNode;
 class vtkMRMLTransformableNode;
@@ -52,7 +53,12 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerTransformLogic : public vtkMRMLAbstr
 
   /// Apply the associated transform to the transformable node. Return true
   /// on success, false otherwise.
-  static bool hardenTransform(vtkMRMLTransformableNode* node);
+  /// By default (displacementFieldSpacingMm=0) the exact transform is applied to every point.
+  /// If displacementFieldSpacingMm is positive, a non-linear transform is applied to a model
+  /// through its displacement field sampled around the model with that spacing, if the field
+  /// has fewer samples than the model has points. The points are then interpolated instead of
+  /// evaluating the transform chain at each of them, which is faster but approximate.
+  static bool hardenTransform(vtkMRMLTransformableNode* node, double displacementFieldSpacingMm=0.0);
 
   ///
   /// Read transform from file
@@ -89,20 +95,38 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerTransformLogic : public vtkMRMLAbstr
   /// If magnitude is true then a scalar volume is created, each voxel containing the magnitude of the displacement.
   /// If magnitude is false then a 3-component scalar volume is created, each voxel containing the displacement vector.
   /// referenceVolumeNode specifies the volume origin, spacing, extent, and orientation
-  vtkMRMLScalarVolumeNode* CreateDisplacementVolumeFromTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode, bool magnitude=true);
+  /// If roiNode is specified then only the part of the reference volume within the RAS bounds of roiNode is sampled.
+  /// If outputSpacing is specified then it is used instead of the spacing of the reference volume.
+  /// The voxels are sampled by multiple threads, see AbortConversion for progress reporting and cancellation.
+  /// Returns NULL if the inputs are invalid, the region is empty, or the conversion is aborted.
+  vtkMRMLScalarVolumeNode* CreateDisplacementVolumeFromTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode, bool magnitude=true,
+    vtkMRMLDisplayableNode* roiNode=NULL, double* outputSpacing=NULL);
 
   /// Convert the input transform to a grid transform.
   /// referenceVolumeNode specifies the volume origin, spacing, extent, and orientation
-  vtkMRMLTransformNode* ConvertToGridTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode);
+  /// If roiNode is specified then only the part of the reference volume within the RAS bounds of roiNode is sampled.
+  /// If outputSpacing is specified then it is used instead of the spacing of the reference volume.
+  /// The voxels are sampled by multiple threads, see AbortConversion for progress reporting and cancellation.
+  /// Returns NULL if the inputs are invalid, the region is empty, or the conversion is aborted.
+  vtkMRMLTransformNode* ConvertToGridTransform(vtkMRMLTransformNode* inputTransformNode, vtkMRMLVolumeNode* referenceVolumeNode,
+    vtkMRMLDisplayableNode* roiNode=NULL, double* outputSpacing=NULL);
+
+  /// While CreateDisplacementVolumeFromTransform or ConvertToGridTransform samples the transform, the logic
+  /// invokes vtkCommand::ProgressEvent with the completed fraction (double*) as call data.
+  /// Setting AbortConversion to true from an observer cancels the conversion. It is reset when a conversion starts.
+  vtkGetMacro(AbortConversion, bool);
+  vtkSetMacro(AbortConversion, bool);
 
   /// Take samples from the displacement field and store the magnitude in an image volume
   /// The extents of the output image must be set before calling this method.
+  /// The image is split into tiles that are sampled by multiple threads.
   /// The origin and spacing attributes of the output image are ignored (origin, spacing, and axis directions
   /// are all specified by ijkToRAS).
   static void GetTransformedPointSamplesAsMagnitudeImage(vtkImageData* outputMagnitudeImage, vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* ijkToRAS);
 
   /// Take samples from the displacement field and store the vector components in an image volume
   /// The extents of the output image must be set before calling this method.
+  /// The image is split into tiles that are sampled by multiple threads.
   /// The origin and spacing attributes of the output image are ignored (origin, spacing, and axis directions
   /// are all specified by ijkToRAS).
   static void GetTransformedPointSamplesAsVectorImage(vtkImageData* outputVectorImage, vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* ijkToRAS);
@@ -126,9 +150,26 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerTransformLogic : public vtkMRMLAbstr
 protected:
   vtkSlicerTransformLogic();
   virtual ~vtkSlicerTransformLogic();
+
+  /// Compute the geometry of a volume sampled from a transform. The volume has the axis directions of the
+  /// reference volume and outputSpacing (or the reference spacing), and it covers the reference volume,
+  /// or its intersection with the RAS bounds of roiNode.
+  /// Return false if the inputs are invalid or the region is empty.
+  static bool GetSamplingGeometry(vtkMRMLVolumeNode* referenceVolumeNode, vtkMRMLDisplayableNode* roiNode,
+    double* outputSpacing, vtkMatrix4x4* ijkToRAS, int extent[6]);
+
+  /// Take samples from the displacement field into a float image, by multiple threads.
+  /// If progressLogic is specified then progress events are invoked on it and its AbortConversion flag is checked.
+  /// Return false if the sampling is aborted.
+  static bool SampleDisplacementImage(vtkImageData* outputImage, vtkMRMLTransformNode* inputTransformNode,
+    vtkMatrix4x4* ijkToRAS, bool magnitude, vtkSlicerTransformLogic* progressLogic);
+
   vtkSlicerTransformLogic(const vtkSlicerTransformLogic&);
   void operator=(const vtkSlicerTransformLogic&);
 
+  /// Flag telling whether the conversion in progress should be cancelled
+  bool AbortConversion;
+
   /// Generate glyph for 2D transform visualization
   /// \sa GetVisualization2d
   static void GetGlyphVisualization2d(vtkPolyData* output_RAS, vtkMRMLTransformDisplayNode* displayNode, vtkMatrix4x4* sliceToRAS, double* fieldOfViewOrigin, double* fieldOfViewSize);
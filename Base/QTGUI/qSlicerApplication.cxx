@@ -86,6 +86,7 @@
 #include <vtkSystemInformation.h>
 
 // MRML includes
+#include <vtkEventBroker.h>
 #include <vtkMRMLNode.h>
 #include <vtkMRMLScene.h>
 
@@ -182,6 +183,13 @@ void qSlicerApplicationPrivate::init()
 
   this->initStyle();
 
+  // The events that the displayable managers opted in for coalescing (e.g.
+  // markup point moves, slice node changes) are merged by the event broker
+  // and processed by the views right before they render a frame, the other
+  // events are still invoked synchronously.
+  // \sa vtkMRMLDisplayableManagerGroup
+  vtkEventBroker::GetInstance()->SetEventModeToFrameCoalesced();
+
   this->ToolTipTrapper = new ctkToolTipTrapper(q);
   this->ToolTipTrapper->setToolTipsTrapped(false);
   this->ToolTipTrapper->setToolTipsWordWrapped(true);
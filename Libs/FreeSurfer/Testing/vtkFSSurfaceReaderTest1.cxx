@@ -0,0 +1,256 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// FreeSurfer includes
+#include <vtkFSIO.h>
+#include <vtkFSSurfaceReader.h>
+#include <vtkFSSurfaceScalarReader.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Read a triangle surface file one value at a time, as the reader did
+// before it read the vertex and face lists by blocks.
+bool ReadTriangleSurfaceByValue(const std::string& fileName,
+                                std::vector<float>& locations,
+                                std::vector<int>& faceIndices)
+{
+  FILE* surfaceFile = fopen(fileName.c_str(), "rb");
+  if (!surfaceFile)
+    {
+    std::cerr << "Could not open " << fileName << std::endl;
+    return false;
+    }
+  int magicNumber = 0;
+  vtkFSIO::ReadInt3(surfaceFile, magicNumber);
+  if (magicNumber != vtkFSSurfaceReader::FS_TRIANGLE_FILE_MAGIC_NUMBER)
+    {
+    std::cerr << fileName << " is not a triangle file: magic number "
+              << magicNumber << std::endl;
+    fclose(surfaceFile);
+    return false;
+    }
+  char line[256];
+  char *skipchars = fgets(line, 200, surfaceFile);
+  int skip = fscanf(surfaceFile, "\n");
+  if (skipchars == NULL || skip > 0)
+    {
+    // trying to avoid unused var warnings while checking return values
+    }
+  int numVertices = 0;
+  int numFaces = 0;
+  vtkFSIO::ReadInt(surfaceFile, numVertices);
+  vtkFSIO::ReadInt(surfaceFile, numFaces);
+  if (numVertices <= 0 || numFaces <= 0)
+    {
+    std::cerr << numVertices << " vertices and " << numFaces
+              << " faces in " << fileName << std::endl;
+    fclose(surfaceFile);
+    return false;
+    }
+  locations.resize(3 * static_cast<size_t>(numVertices));
+  size_t numRead = 0;
+  for (size_t i = 0; i < locations.size(); ++i)
+    {
+    numRead += vtkFSIO::ReadFloat(surfaceFile, locations[i]);
+    }
+  faceIndices.resize(3 * static_cast<size_t>(numFaces));
+  for (size_t i = 0; i < faceIndices.size(); ++i)
+    {
+    numRead += vtkFSIO::ReadInt(surfaceFile, faceIndices[i]);
+    }
+  fclose(surfaceFile);
+  if (numRead != locations.size() + faceIndices.size())
+    {
+    std::cerr << "Unexpected end of file after " << numRead
+              << " values read from " << fileName << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int TestSurfaceReader(const std::string& fileName)
+{
+  std::vector<float> locations;
+  std::vector<int> faceIndices;
+  if (!ReadTriangleSurfaceByValue(fileName, locations, faceIndices))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkFSSurfaceReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  vtkPolyData* surface = reader->GetOutput();
+
+  vtkIdType numVertices = static_cast<vtkIdType>(locations.size() / 3);
+  if (!surface->GetPoints() || surface->GetNumberOfPoints() != numVertices)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << surface->GetNumberOfPoints()
+              << " points read instead of " << numVertices << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType vIndex = 0; vIndex < numVertices; ++vIndex)
+    {
+    double point[3];
+    surface->GetPoint(vIndex, point);
+    for (int i = 0; i < 3; ++i)
+      {
+      if (static_cast<float>(point[i]) != locations[3*vIndex+i])
+        {
+        std::cerr << "Line " << __LINE__ << ": vertex " << vIndex << " coordinate " << i
+                  << " is " << point[i] << " instead of " << locations[3*vIndex+i] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  vtkIdType numFaces = static_cast<vtkIdType>(faceIndices.size() / 3);
+  if (surface->GetNumberOfPolys() != numFaces)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << surface->GetNumberOfPolys()
+              << " faces read instead of " << numFaces << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkCellArray* faces = surface->GetPolys();
+  faces->InitTraversal();
+  vtkIdType numFaceVertices = 0;
+  vtkIdType* faceVertices = 0;
+  for (vtkIdType fIndex = 0; faces->GetNextCell(numFaceVertices, faceVertices); ++fIndex)
+    {
+    if (numFaceVertices != 3)
+      {
+      std::cerr << "Line " << __LINE__ << ": face " << fIndex << " has "
+                << numFaceVertices << " vertices instead of 3" << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (int fvIndex = 0; fvIndex < 3; ++fvIndex)
+      {
+      if (faceVertices[fvIndex] != faceIndices[3*fIndex+fvIndex])
+        {
+        std::cerr << "Line " << __LINE__ << ": vertex " << fvIndex << " of face " << fIndex
+                  << " is " << faceVertices[fvIndex] << " instead of "
+                  << faceIndices[3*fIndex+fvIndex] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestScalarReader(const std::string& fileName)
+{
+  // New style overlay: magic number, number of values, number of faces,
+  // values per point, then the values
+  FILE* scalarFile = fopen(fileName.c_str(), "rb");
+  if (!scalarFile)
+    {
+    std::cerr << "Could not open " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  int magicNumber = 0;
+  int numValues = 0;
+  int numFaces = 0;
+  int numValuesPerPoint = 0;
+  vtkFSIO::ReadInt3(scalarFile, magicNumber);
+  vtkFSIO::ReadInt(scalarFile, numValues);
+  vtkFSIO::ReadInt(scalarFile, numFaces);
+  vtkFSIO::ReadInt(scalarFile, numValuesPerPoint);
+  if (magicNumber != vtkFSSurfaceScalarReader::FS_NEW_SCALAR_MAGIC_NUMBER ||
+      numValues <= 0 || numValuesPerPoint != 1)
+    {
+    std::cerr << fileName << " is not a new style overlay" << std::endl;
+    fclose(scalarFile);
+    return EXIT_FAILURE;
+    }
+  std::vector<float> values(numValues);
+  int numRead = 0;
+  for (int vIndex = 0; vIndex < numValues; ++vIndex)
+    {
+    numRead += vtkFSIO::ReadFloat(scalarFile, values[vIndex]);
+    }
+  fclose(scalarFile);
+  if (numRead != numValues)
+    {
+    std::cerr << "Unexpected end of file after " << numRead
+              << " values read from " << fileName << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkFloatArray> scalars;
+  vtkNew<vtkFSSurfaceScalarReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->SetOutput(scalars.GetPointer());
+  if (reader->ReadFSScalars() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to read " << fileName << std::endl;
+    reader->SetOutput(NULL);
+    return EXIT_FAILURE;
+    }
+  reader->SetOutput(NULL);
+  if (scalars->GetNumberOfTuples() != numValues)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << scalars->GetNumberOfTuples()
+              << " values read instead of " << numValues << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int vIndex = 0; vIndex < numValues; ++vIndex)
+    {
+    if (scalars->GetValue(vIndex) != values[vIndex])
+      {
+      std::cerr << "Line " << __LINE__ << ": value " << vIndex << " is "
+                << scalars->GetValue(vIndex) << " instead of " << values[vIndex] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkFSSurfaceReaderTest1(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/TestData" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string dataPath(argv[1]);
+
+  // The block reads give the same surface and overlay as reading the values one by one
+  if (TestSurfaceReader(dataPath + "/lh.dart.orig") != EXIT_SUCCESS ||
+      TestScalarReader(dataPath + "/lh.dart.curv") != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
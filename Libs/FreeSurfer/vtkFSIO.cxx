@@ -18,6 +18,10 @@
 // VTK includes
 #include <vtkByteSwap.h>
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 //------------------------------------------------------------------------------
 int vtkFSIO::ReadShort (FILE* iFile, short& oShort) {
 
@@ -157,6 +161,50 @@ int vtkFSIO::ReadFloatZ (gzFile iFile, float& oFloat) {
   return result;
 }
 
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadIntBlock (FILE* iFile, int* oInts, size_t count) {
+
+  // Read all the ints, then swap them all if we need to.
+  size_t result = fread (oInts, sizeof(int), count, iFile);
+  vtkByteSwap::Swap4BERange (oInts, result);
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadInt3Block (FILE* iFile, int* oInts, size_t count) {
+
+  // Read the three byte ints by chunks and assemble them, the bytes are
+  // big endian whatever the platform.
+  const size_t chunkSize = 65536;
+  std::vector<unsigned char> bytes (3 * std::min(count, chunkSize));
+  size_t result = 0;
+  while (result < count) {
+    size_t toRead = std::min(count - result, chunkSize);
+    size_t read = fread (&bytes[0], 3, toRead, iFile);
+    const unsigned char* b = &bytes[0];
+    for (size_t i = 0; i < read; ++i, b += 3) {
+      oInts[result + i] = (b[0] << 16) | (b[1] << 8) | b[2];
+    }
+    result += read;
+    if (read != toRead) {
+      break;
+    }
+  }
+
+  return result;
+}
+
+//------------------------------------------------------------------------------
+size_t vtkFSIO::ReadFloatBlock (FILE* iFile, float* oFloats, size_t count) {
+
+  // Read all the floats, then swap them all if we need to.
+  size_t result = fread (oFloats, sizeof(float), count, iFile);
+  vtkByteSwap::Swap4BERange (oFloats, result);
+
+  return result;
+}
+
 //------------------------------------------------------------------------------
 // Utility methods for writing test files
 
@@ -43,6 +43,13 @@ namespace vtkFSIO {
   int VTK_FreeSurfer_EXPORT ReadInt2Z (gzFile iFile, int& oInt);
   int VTK_FreeSurfer_EXPORT ReadFloatZ (gzFile iFile, float& oFloat);
 
+  /// Read a block of \a count values at once, much faster than reading
+  /// them one by one for the vertex, face and value lists.
+  /// Return the number of values read.
+  size_t VTK_FreeSurfer_EXPORT ReadIntBlock (FILE* iFile, int* oInts, size_t count);
+  size_t VTK_FreeSurfer_EXPORT ReadInt3Block (FILE* iFile, int* oInts, size_t count);
+  size_t VTK_FreeSurfer_EXPORT ReadFloatBlock (FILE* iFile, float* oFloats, size_t count);
+
   /// For testing purposes
   int VTK_FreeSurfer_EXPORT WriteInt (FILE* iFile, int iInt);
   int VTK_FreeSurfer_EXPORT WriteInt3 (FILE* iFile, int iInt);
@@ -24,10 +24,6 @@
 /// Prints debugging info.
 #define FS_DEBUG 0
 
-/// This code can calc normals but it doesn't seem to do so very well
-/// (bug?) and vtkPolyDataNormals does it anyway.
-#define FS_CALC_NORMALS 0
-
 class vtkInformation;
 class vtkInformationVector;
 class vtkPolyData;
@@ -36,6 +32,8 @@ class vtkPolyData;
 ///
 /// Reads a surface file from FreeSurfer and output PolyData. Use the
 /// SetFileName function to specify the file name.
+/// The vertex and face blocks are read at once and copied directly into
+/// the points and cells, normals are left to vtkPolyDataNormals.
 class VTK_FreeSurfer_EXPORT vtkFSSurfaceReader : public vtkDataReader
 {
 public:
@@ -85,21 +83,4 @@ private:
 };
 
 
-/// If we're going to try to do normals, we need to keep some
-/// connectivity information for the verts and faces. Use these
-/// structures.
-#if FS_CALC_NORMALS
-typedef struct {
-  int numFaces;
-  int faces[FS_MAX_NUM_FACES_PER_VERTEX];
-  int indicesInFace[FS_MAX_NUM_FACES_PER_VERTEX];
-  float x, y, z;
-  float nx, ny, nz;
-} Vertex;
-
-typedef struct {
-  int vertices[FS_NUM_SIDES_IN_FACE];
-} Face;
-#endif
-
 #endif
@@ -137,41 +137,37 @@ int vtkFSSurfaceScalarReader::ReadFSScalars()
 
   // Make our float array.
   FSscalars = (float*) calloc (numValues, sizeof(float));
+  if (FSscalars == NULL) {
+    vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Couldn't allocate " << numValues << " values.");
+    fclose (scalarFile);
+    return 0;
+  }
 
-  // For each value, if it's a new style file read a float, otherwise
-  // read a two byte int and divide it by 100. Add this value to the
-  // array.
-  for (vIndex = 0; vIndex < numValues; vIndex ++ ) {
-
-    if (feof(scalarFile)) {
-      vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Unexpected EOF after " << vIndex << " values read.");
-      return 0;
-    }
-
-    if (this->FS_NEW_SCALAR_MAGIC_NUMBER == magicNumber) {
-      size_t retval = fread (&fvalue, sizeof(float), 1, scalarFile);
-      if (retval == 1)
-        {
-        vtkByteSwap::Swap4BE (&fvalue);
-        }
-      else
-        {
-        vtkErrorMacro("Error reading fvalue from file " << this->FileName);
-        }
-
-    } else {
-      vtkFSIO::ReadInt2 (scalarFile, ivalue);
+  // If it's a new style file read all the floats at once, otherwise
+  // read a two byte int and divide it by 100 for each value.
+  if (this->FS_NEW_SCALAR_MAGIC_NUMBER == magicNumber) {
+    vIndex = static_cast<int>(vtkFSIO::ReadFloatBlock (scalarFile, FSscalars, numValues));
+  } else {
+    for (vIndex = 0; vIndex < numValues && !feof(scalarFile); vIndex ++ ) {
+      if (vtkFSIO::ReadInt2 (scalarFile, ivalue) != 1) {
+        break;
+      }
       fvalue = ivalue / 100.0;
-    }
-
-    FSscalars[vIndex] = fvalue;
+      FSscalars[vIndex] = fvalue;
 
-    if (numValues < 10000 ||
-        (vIndex % 100) == 0)
-    {
-        this->UpdateProgress(1.0*vIndex/numValues);
+      if (numValues < 10000 ||
+          (vIndex % 100) == 0)
+      {
+          this->UpdateProgress(1.0*vIndex/numValues);
+      }
     }
+  }
 
+  if (vIndex != numValues) {
+    vtkErrorMacro (<< "vtkFSSurfaceScalarReader.cxx Execute: Unexpected EOF after " << vIndex << " values read.");
+    fclose (scalarFile);
+    free (FSscalars);
+    return 0;
   }
 
   this->SetProgressText("");
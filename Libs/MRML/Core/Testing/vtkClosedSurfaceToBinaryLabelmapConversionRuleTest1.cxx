@@ -0,0 +1,139 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkOrientedImageData.h"
+#include "vtkSegmentationConverter.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+
+//----------------------------------------------------------------------------
+int vtkClosedSurfaceToBinaryLabelmapConversionRuleTest1(int , char * [] )
+{
+  vtkNew<vtkClosedSurfaceToBinaryLabelmapConversionRule> rule;
+  EXERCISE_BASIC_OBJECT_METHODS(rule.GetPointer());
+
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(20.);
+  sphere->SetThetaResolution(64);
+  sphere->SetPhiResolution(64);
+  sphere->Update();
+  vtkPolyData* surface = sphere->GetOutput();
+
+  // 1 mm reference geometry around the sphere
+  vtkNew<vtkMatrix4x4> geometryMatrix;
+  geometryMatrix->SetElement(0, 3, -30.);
+  geometryMatrix->SetElement(1, 3, -30.);
+  geometryMatrix->SetElement(2, 3, -30.);
+  vtkNew<vtkImageData> geometryImageData;
+  geometryImageData->SetDimensions(61, 61, 61);
+  rule->SetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName(),
+    vtkSegmentationConverter::SerializeImageGeometry(geometryMatrix.GetPointer(), geometryImageData.GetPointer()));
+  rule->SetConversionParameter(vtkClosedSurfaceToBinaryLabelmapConversionRule::GetOversamplingFactorParameterName(), "2");
+
+  // Whole labelmap at once
+  vtkNew<vtkOrientedImageData> labelmap;
+  if (!rule->Convert(surface, labelmap.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": conversion failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Blocks of slices, the limit is above the labelmap size
+  rule->SetConversionParameter(vtkClosedSurfaceToBinaryLabelmapConversionRule::GetMemoryLimitParameterName(), "1");
+  vtkNew<vtkOrientedImageData> blockLabelmap;
+  if (!rule->Convert(surface, blockLabelmap.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": conversion in blocks failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (rule->GetConversionReports().size() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of reports: "
+              << rule->GetConversionReports().size() << std::endl;
+    return EXIT_FAILURE;
+    }
+  const vtkClosedSurfaceToBinaryLabelmapConversionRule::ConversionReport& report = rule->GetConversionReports()[0];
+  const vtkClosedSurfaceToBinaryLabelmapConversionRule::ConversionReport& blockReport = rule->GetConversionReports()[1];
+  std::cout << "Whole labelmap: " << report.Time << " s, " << report.PeakMemorySize << " bytes" << std::endl;
+  std::cout << "Blocks: " << blockReport.Time << " s, " << blockReport.PeakMemorySize << " bytes, "
+            << blockReport.NumberOfBlocks << " blocks" << std::endl;
+
+  // Same labelmap, with less memory
+  int extent[6] = {0,-1,0,-1,0,-1};
+  int blockExtent[6] = {0,-1,0,-1,0,-1};
+  labelmap->GetExtent(extent);
+  blockLabelmap->GetExtent(blockExtent);
+  for (int i = 0; i < 6; ++i)
+    {
+    if (extent[i] != blockExtent[i])
+      {
+      std::cerr << "Line " << __LINE__ << ": different extents" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  vtkIdType numberOfVoxels = labelmap->GetNumberOfPoints();
+  if (blockReport.OversamplingFactor != 2. || blockReport.NumberOfBlocks < 2 ||
+      blockReport.PeakMemorySize >= report.PeakMemorySize ||
+      blockReport.PeakMemorySize < numberOfVoxels ||
+      memcmp(labelmap->GetScalarPointer(), blockLabelmap->GetScalarPointer(), numberOfVoxels) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong conversion in blocks" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int numberOfForegroundVoxels = 0;
+  unsigned char* voxels = static_cast<unsigned char*>(blockLabelmap->GetScalarPointer());
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    numberOfForegroundVoxels += (voxels[i] == 1);
+    }
+  if (numberOfForegroundVoxels == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": empty labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The limit is below the oversampled labelmap size: the factor is lowered
+  rule->ClearConversionReports();
+  rule->SetConversionParameter(vtkClosedSurfaceToBinaryLabelmapConversionRule::GetMemoryLimitParameterName(), "0.2");
+  vtkNew<vtkOrientedImageData> limitedLabelmap;
+  if (!rule->Convert(surface, limitedLabelmap.GetPointer()) ||
+      rule->GetConversionReports().size() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": limited conversion failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const vtkClosedSurfaceToBinaryLabelmapConversionRule::ConversionReport& limitedReport = rule->GetConversionReports()[0];
+  if (limitedReport.RequestedOversamplingFactor != 2. ||
+      limitedReport.OversamplingFactor >= 2. ||
+      limitedReport.OversamplingFactor < 1. ||
+      limitedLabelmap->GetNumberOfPoints() > 0.2 * 1024 * 1024)
+    {
+    std::cerr << "Line " << __LINE__ << ": memory limit not respected: oversampling factor "
+              << limitedReport.OversamplingFactor << ", " << limitedLabelmap->GetNumberOfPoints()
+              << " voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkDataIOManager.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLModelStorageNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLVolumeArchetypeStorageNode.h"
+
+// ITK includes
+#include <itkConfigure.h>
+#include <itkFactoryRegistration.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct EventRecorder
+{
+  EventRecorder() : MainThreadID(vtkMultiThreader::GetCurrentThreadID()),
+    NumberOfEventsInOtherThreads(0) {}
+  vtkMultiThreaderIDType MainThreadID;
+  std::vector<int> Progress;
+  std::vector<unsigned long> Messages;
+  int NumberOfEventsInOtherThreads;
+};
+
+//----------------------------------------------------------------------------
+void RecordEvent(vtkObject* vtkNotUsed(caller), unsigned long eid,
+                 void *clientData, void *callData)
+{
+  EventRecorder* recorder = reinterpret_cast<EventRecorder*>(clientData);
+  if (!vtkMultiThreader::ThreadsEqual(recorder->MainThreadID,
+                                      vtkMultiThreader::GetCurrentThreadID()))
+    {
+    ++recorder->NumberOfEventsInOtherThreads;
+    }
+  if (eid == vtkCommand::ErrorEvent || eid == vtkCommand::WarningEvent)
+    {
+    recorder->Messages.push_back(eid);
+    }
+  else
+    {
+    recorder->Progress.push_back(static_cast<int>(reinterpret_cast<size_t>(callData)));
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class NodeType, class StorageNodeType>
+NodeType* AddNode(vtkMRMLScene* scene, const std::string& fileName)
+{
+  vtkNew<StorageNodeType> storageNode;
+  storageNode->SetFileName(fileName.c_str());
+  scene->AddNode(storageNode.GetPointer());
+  vtkNew<NodeType> node;
+  scene->AddNode(node.GetPointer());
+  node->SetAndObserveStorageNodeID(storageNode->GetID());
+  return node.GetPointer();
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkDataIOManagerTest1(int argc, char * argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/TestData" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::itkFactoryRegistration();
+  std::string dataPath(argv[1]);
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkDataIOManager> dataIOManager;
+  dataIOManager->SetNumberOfLocalIOThreads(4);
+
+  vtkNew<vtkCollection> nodes;
+  vtkMRMLModelNode* vtpModel = AddNode<vtkMRMLModelNode, vtkMRMLModelStorageNode>(
+    scene.GetPointer(), dataPath + "/cube.vtp");
+  nodes->AddItem(vtpModel);
+  vtkMRMLModelNode* vtkModel = AddNode<vtkMRMLModelNode, vtkMRMLModelStorageNode>(
+    scene.GetPointer(), dataPath + "/sphere.vtk");
+  nodes->AddItem(vtkModel);
+  vtkMRMLScalarVolumeNode* fixedVolume = AddNode<vtkMRMLScalarVolumeNode, vtkMRMLVolumeArchetypeStorageNode>(
+    scene.GetPointer(), dataPath + "/fixed.nrrd");
+  nodes->AddItem(fixedVolume);
+  vtkMRMLScalarVolumeNode* movingVolume = AddNode<vtkMRMLScalarVolumeNode, vtkMRMLVolumeArchetypeStorageNode>(
+    scene.GetPointer(), dataPath + "/moving.nrrd");
+  nodes->AddItem(movingVolume);
+  // not a volume file, the reader fails in the worker thread
+  vtkMRMLScalarVolumeNode* invalidVolume = AddNode<vtkMRMLScalarVolumeNode, vtkMRMLVolumeArchetypeStorageNode>(
+    scene.GetPointer(), dataPath + "/table.csv");
+  nodes->AddItem(invalidVolume);
+
+  EventRecorder recorder;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(RecordEvent);
+  callback->SetClientData(&recorder);
+  scene->AddObserver(vtkMRMLScene::StateEvent | vtkMRMLScene::ProgressEvent | vtkMRMLScene::ImportState,
+                     callback.GetPointer());
+  invalidVolume->GetStorageNode()->AddObserver(vtkCommand::ErrorEvent, callback.GetPointer());
+  invalidVolume->GetStorageNode()->AddObserver(vtkCommand::WarningEvent, callback.GetPointer());
+
+  CHECK_INT(dataIOManager->PrefetchLocalData(nodes.GetPointer(), scene.GetPointer()), 4);
+
+  // progress is reported on the main thread once the files are decoded, and
+  // the messages of the failed read are not reported from the worker threads
+  CHECK_INT(recorder.NumberOfEventsInOtherThreads, 0);
+  CHECK_INT(static_cast<int>(recorder.Messages.size()), 0);
+  CHECK_INT(static_cast<int>(recorder.Progress.size()), 5);
+  CHECK_INT(recorder.Progress.back(), 100);
+
+  // the prefetched data is set into the nodes by ReadData()
+  for (int i = 0; i < 4; ++i)
+    {
+    vtkMRMLStorableNode* node = vtkMRMLStorableNode::SafeDownCast(nodes->GetItemAsObject(i));
+    CHECK_INT(node->GetStorageNode()->ReadData(node), 1);
+    }
+  CHECK_NOT_NULL(vtpModel->GetPolyData());
+  CHECK_BOOL(vtpModel->GetPolyData()->GetNumberOfPoints() > 0, true);
+  CHECK_NOT_NULL(vtkModel->GetPolyData());
+  CHECK_BOOL(vtkModel->GetPolyData()->GetNumberOfPoints() > 0, true);
+  CHECK_NOT_NULL(fixedVolume->GetImageData());
+  CHECK_NOT_NULL(movingVolume->GetImageData());
+
+  // same data as a read on the main thread
+  vtkNew<vtkMRMLScalarVolumeNode> referenceVolume;
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> referenceStorageNode;
+  referenceStorageNode->SetFileName((dataPath + "/fixed.nrrd").c_str());
+  CHECK_INT(referenceStorageNode->ReadData(referenceVolume.GetPointer()), 1);
+  int dimensions[3] = {0, 0, 0};
+  int referenceDimensions[3] = {0, 0, 0};
+  fixedVolume->GetImageData()->GetDimensions(dimensions);
+  referenceVolume->GetImageData()->GetDimensions(referenceDimensions);
+  for (int i = 0; i < 3; ++i)
+    {
+    CHECK_INT(dimensions[i], referenceDimensions[i]);
+    }
+
+  // the prefetched data is not used if the file name has changed
+  CHECK_INT(dataIOManager->PrefetchLocalData(nodes.GetPointer(), scene.GetPointer()), 4);
+  vtpModel->GetStorageNode()->SetFileName((dataPath + "/sphere.vtk").c_str());
+  CHECK_INT(vtpModel->GetStorageNode()->ReadData(vtpModel), 1);
+  CHECK_INT(vtpModel->GetPolyData()->GetNumberOfPoints(), vtkModel->GetPolyData()->GetNumberOfPoints());
+
+  // the error of the failed read is reported by ReadData() on the main thread
+  CHECK_INT(invalidVolume->GetStorageNode()->ReadData(invalidVolume), 0);
+  CHECK_BOOL(recorder.Messages.size() > 0, true);
+  CHECK_INT(recorder.NumberOfEventsInOtherThreads, 0);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelNode.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+
+namespace
+{
+
+struct CallbackCounter
+{
+  CallbackCounter() : Count(0), LastCallData(0) {}
+  int Count;
+  void* LastCallData;
+};
+
+//----------------------------------------------------------------------------
+void CountCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                   void *clientData, void *callData)
+{
+  CallbackCounter* counter = reinterpret_cast<CallbackCounter*>(clientData);
+  ++counter->Count;
+  counter->LastCallData = callData;
+}
+
+//----------------------------------------------------------------------------
+bool CheckCount(const char* step, const CallbackCounter& counter, int expected)
+{
+  if (counter.Count != expected)
+    {
+    std::cerr << step << ": " << counter.Count << " invocations, "
+              << expected << " expected" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerTest1(int , char * [] )
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  broker->ResetEventCounters();
+
+  vtkNew<vtkMRMLModelNode> subject;
+  vtkNew<vtkMRMLModelNode> observer;
+  CallbackCounter counter;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountCallback);
+  callback->SetClientData(&counter);
+  broker->AddObservation(subject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), callback.GetPointer());
+
+  CallbackCounter pendingCounter;
+  vtkNew<vtkCallbackCommand> pendingCallback;
+  pendingCallback->SetCallback(CountCallback);
+  pendingCallback->SetClientData(&pendingCounter);
+  broker->AddObserver(vtkEventBroker::CoalescedEventsPendingEvent, pendingCallback.GetPointer());
+
+  // Synchronous by default
+  if (broker->GetEventMode() != vtkEventBroker::Synchronous)
+    {
+    std::cerr << "Unexpected default event mode: " << broker->GetEventModeAsString() << std::endl;
+    return EXIT_FAILURE;
+    }
+  subject->Modified();
+  subject->Modified();
+  if (!CheckCount("Synchronous", counter, 2))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Frame coalesced, the observer didn't opt in
+  broker->SetEventModeToFrameCoalesced();
+  subject->Modified();
+  if (!CheckCount("FrameCoalesced without opt-in", counter, 3) ||
+      broker->GetNumberOfQueuedEvents() != 0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Frame coalesced
+  broker->SetObservationEventCoalescing(subject.GetPointer(), observer.GetPointer(),
+                                        vtkCommand::ModifiedEvent, true);
+  if (!broker->GetObservationEventCoalescing(subject.GetPointer(), observer.GetPointer(),
+                                             vtkCommand::ModifiedEvent))
+    {
+    std::cerr << "SetObservationEventCoalescing failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int value = 1;
+  subject->Modified();
+  subject->InvokeEvent(vtkCommand::ModifiedEvent, &value);
+  subject->Modified();
+  if (!CheckCount("FrameCoalesced before processing", counter, 3) ||
+      !CheckCount("CoalescedEventsPendingEvent", pendingCounter, 1) ||
+      broker->GetNumberOfQueuedEvents() != 3 ||
+      broker->GetNumberOfDroppedEvents() != 2)
+    {
+    std::cerr << "Queued events: " << broker->GetNumberOfQueuedEvents()
+              << " Dropped events: " << broker->GetNumberOfDroppedEvents() << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->ProcessCoalescedEvents();
+  if (!CheckCount("FrameCoalesced after processing", counter, 4) ||
+      counter.LastCallData != 0 ||
+      broker->GetNumberOfQueuedObservations() != 0)
+    {
+    return EXIT_FAILURE;
+    }
+  broker->ProcessCoalescedEvents();
+  if (!CheckCount("FrameCoalesced empty frame", counter, 4))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The other subjects of the observer are not coalesced
+  vtkNew<vtkMRMLModelNode> otherSubject;
+  CallbackCounter otherCounter;
+  vtkNew<vtkCallbackCommand> otherCallback;
+  otherCallback->SetCallback(CountCallback);
+  otherCallback->SetClientData(&otherCounter);
+  broker->AddObservation(otherSubject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), otherCallback.GetPointer());
+  otherSubject->Modified();
+  otherSubject->Modified();
+  if (!CheckCount("FrameCoalesced subject not opted in", otherCounter, 2) ||
+      broker->GetNumberOfQueuedObservations() != 0)
+    {
+    return EXIT_FAILURE;
+    }
+  broker->RemoveObservations(otherSubject.GetPointer(), observer.GetPointer());
+
+  // A new frame is requested for the next events
+  subject->Modified();
+  if (!CheckCount("CoalescedEventsPendingEvent next frame", pendingCounter, 2))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Removed observations are not invoked
+  broker->RemoveObservations(subject.GetPointer(), observer.GetPointer());
+  broker->ProcessCoalescedEvents();
+  if (!CheckCount("FrameCoalesced removed observation", counter, 4))
+    {
+    return EXIT_FAILURE;
+    }
+
+  broker->RemoveObserverEventCoalescing(observer.GetPointer());
+  if (broker->GetObservationEventCoalescing(subject.GetPointer(), observer.GetPointer(),
+                                            vtkCommand::ModifiedEvent))
+    {
+    std::cerr << "RemoveObserverEventCoalescing failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->RemoveObserver(pendingCallback.GetPointer());
+  broker->SetEventModeToSynchronous();
+  broker->ResetEventCounters();
+
+  return EXIT_SUCCESS;
+}
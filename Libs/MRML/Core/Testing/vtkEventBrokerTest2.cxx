@@ -0,0 +1,147 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void ModifyClientDataCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                              void *clientData, void *vtkNotUsed(callData))
+{
+  // nested invocation
+  reinterpret_cast<vtkObject*>(clientData)->Modified();
+}
+
+//----------------------------------------------------------------------------
+void EmptyCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                   void *vtkNotUsed(clientData), void *vtkNotUsed(callData))
+{
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerTest2(int argc, char * argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkEventBrokerTest2 /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string traceFileName = std::string(argv[1]) + "/vtkEventBrokerTest2.json";
+
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+
+  vtkNew<vtkMRMLModelNode> subject;
+  vtkNew<vtkMRMLScalarVolumeNode> nestedSubject;
+  vtkNew<vtkMRMLModelNode> observer;
+
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(ModifyClientDataCallback);
+  callback->SetClientData(nestedSubject.GetPointer());
+  broker->AddObservation(subject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), callback.GetPointer());
+  vtkNew<vtkCallbackCommand> nestedCallback;
+  nestedCallback->SetCallback(EmptyCallback);
+  broker->AddObservation(nestedSubject.GetPointer(), vtkCommand::ModifiedEvent,
+                         observer.GetPointer(), nestedCallback.GetPointer());
+
+  // not profiled
+  subject->Modified();
+
+  broker->ProfilingOn();
+  broker->ProfilingTimelineOn();
+  for (int i = 0; i < 10; ++i)
+    {
+    subject->Modified();
+    }
+  broker->ProfilingOff();
+  subject->Modified();
+
+  std::stringstream report;
+  broker->PrintProfilingReport(report);
+  std::cout << report.str();
+  std::string line;
+  int numberOfLines = 0;
+  while (std::getline(report, line))
+    {
+    if (line.empty() || line[0] == '#')
+      {
+      continue;
+      }
+    ++numberOfLines;
+    std::stringstream fields(line);
+    int count = 0;
+    double selfTime = 0.;
+    double inclusiveTime = 0.;
+    fields >> count >> selfTime >> inclusiveTime;
+    if (count != 10 || selfTime < 0. || selfTime > inclusiveTime)
+      {
+      std::cerr << "Wrong profile: " << line << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (numberOfLines != 2 ||
+      report.str().find("vtkMRMLScalarVolumeNode\tModifiedEvent\tvtkMRMLModelNode") == std::string::npos)
+    {
+    std::cerr << "Wrong profile report" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (broker->WriteProfilingTrace(traceFileName.c_str()) != 0)
+    {
+    std::cerr << "Failed to write " << traceFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::ifstream traceFile(traceFileName.c_str());
+  std::stringstream trace;
+  trace << traceFile.rdbuf();
+  size_t numberOfTraceEvents = 0;
+  for (size_t pos = trace.str().find("\"ph\":\"X\""); pos != std::string::npos;
+       pos = trace.str().find("\"ph\":\"X\"", pos + 1))
+    {
+    ++numberOfTraceEvents;
+    }
+  if (trace.str().find("{\"traceEvents\":[") != 0 || numberOfTraceEvents != 20)
+    {
+    std::cerr << "Wrong trace: " << numberOfTraceEvents << " events" << std::endl
+              << trace.str() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  broker->ResetProfiling();
+  std::stringstream emptyReport;
+  broker->PrintProfilingReport(emptyReport);
+  if (emptyReport.str().find("0 invocations") == std::string::npos)
+    {
+    std::cerr << "ResetProfiling failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->ProfilingTimelineOff();
+  broker->RemoveObservations(observer.GetPointer());
+
+  return EXIT_SUCCESS;
+}
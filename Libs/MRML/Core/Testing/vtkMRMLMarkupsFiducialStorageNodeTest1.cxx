@@ -0,0 +1,296 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLMarkupsDisplayNode.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLMarkupsFiducialStorageNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCommand.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialNode* AddMarkupsNode(vtkMRMLScene* scene)
+{
+  vtkNew<vtkMRMLMarkupsFiducialNode> markupsNode;
+  scene->AddNode(markupsNode.GetPointer());
+  vtkNew<vtkMRMLMarkupsDisplayNode> displayNode;
+  scene->AddNode(displayNode.GetPointer());
+  markupsNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+  return markupsNode.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialStorageNode* AddStorageNode(vtkMRMLScene* scene, const std::string& fileName)
+{
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> storageNode;
+  scene->AddNode(storageNode.GetPointer());
+  storageNode->SetFileName(fileName.c_str());
+  return storageNode.GetPointer();
+}
+
+//----------------------------------------------------------------------------
+/// Markups with various positions, orientations, flags and strings
+/// (including commas and quotes, that need quoting in the CSV format)
+void CreateMarkups(vtkMRMLMarkupsNode* markupsNode, int numberOfMarkups)
+{
+  int wasModifying = markupsNode->StartModify();
+  vtkMath::RandomSeed(12345);
+  for (int i = 0; i < numberOfMarkups; ++i)
+    {
+    std::stringstream label;
+    label << "Seed-" << i;
+    if (i % 7 == 0)
+      {
+      label << ", trace \"" << i / 7 << "\"";
+      }
+    int markupIndex = markupsNode->AddMarkupWithNPoints(1, label.str());
+    markupsNode->SetMarkupPoint(markupIndex, 0,
+      vtkMath::Random(-150., 150.), vtkMath::Random(-150., 150.), vtkMath::Random(-150., 150.));
+    markupsNode->SetNthMarkupOrientation(markupIndex, vtkMath::Random(0., 180.), 0.0, 0.6, 0.8);
+    markupsNode->SetNthMarkupVisibility(markupIndex, i % 3 != 0);
+    markupsNode->SetNthMarkupSelected(markupIndex, i % 5 != 0);
+    markupsNode->SetNthMarkupLocked(markupIndex, i % 2 != 0);
+    markupsNode->SetNthMarkupWeight(markupIndex, static_cast<float>(i % 11) * 0.5f);
+    if (i % 4 == 0)
+      {
+      markupsNode->SetNthMarkupDescription(markupIndex, "planned entry, checked");
+      }
+    if (i % 9 == 0)
+      {
+      markupsNode->SetNthMarkupAssociatedNodeID(markupIndex, "vtkMRMLScalarVolumeNode1");
+      }
+    }
+  markupsNode->EndModify(wasModifying);
+}
+
+//----------------------------------------------------------------------------
+bool CompareMarkups(vtkMRMLMarkupsNode* markupsNode1, vtkMRMLMarkupsNode* markupsNode2,
+                    double tolerance, bool compareWeights)
+{
+  if (markupsNode1->GetNumberOfMarkups() != markupsNode2->GetNumberOfMarkups())
+    {
+    std::cerr << "Number of markups differs: " << markupsNode1->GetNumberOfMarkups()
+              << " != " << markupsNode2->GetNumberOfMarkups() << std::endl;
+    return false;
+    }
+  for (int i = 0; i < markupsNode1->GetNumberOfMarkups(); ++i)
+    {
+    double point1[3] = {0.0, 0.0, 0.0};
+    double point2[3] = {0.0, 0.0, 0.0};
+    markupsNode1->GetMarkupPoint(i, 0, point1);
+    markupsNode2->GetMarkupPoint(i, 0, point2);
+    double orientation1[4] = {0.0, 0.0, 0.0, 0.0};
+    double orientation2[4] = {0.0, 0.0, 0.0, 0.0};
+    markupsNode1->GetNthMarkupOrientation(i, orientation1);
+    markupsNode2->GetNthMarkupOrientation(i, orientation2);
+    bool same = sqrt(vtkMath::Distance2BetweenPoints(point1, point2)) <= tolerance;
+    for (int component = 0; component < 4; ++component)
+      {
+      same = same && fabs(orientation1[component] - orientation2[component]) <= tolerance;
+      }
+    same = same
+      && markupsNode1->GetNthMarkupID(i) == markupsNode2->GetNthMarkupID(i)
+      && markupsNode1->GetNthMarkupLabel(i) == markupsNode2->GetNthMarkupLabel(i)
+      && markupsNode1->GetNthMarkupDescription(i) == markupsNode2->GetNthMarkupDescription(i)
+      && markupsNode1->GetNthMarkupAssociatedNodeID(i) == markupsNode2->GetNthMarkupAssociatedNodeID(i)
+      && markupsNode1->GetNthMarkupVisibility(i) == markupsNode2->GetNthMarkupVisibility(i)
+      && markupsNode1->GetNthMarkupSelected(i) == markupsNode2->GetNthMarkupSelected(i)
+      && markupsNode1->GetNthMarkupLocked(i) == markupsNode2->GetNthMarkupLocked(i);
+    if (compareWeights)
+      {
+      same = same && markupsNode1->GetNthMarkupWeight(i) == markupsNode2->GetNthMarkupWeight(i);
+      }
+    if (!same)
+      {
+      std::cerr << "Markup " << i << " differs: " << markupsNode1->GetNthMarkupLabel(i)
+                << " != " << markupsNode2->GetNthMarkupLabel(i) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNodeTest1(int argc, char * argv[] )
+{
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> node1;
+  EXERCISE_BASIC_OBJECT_METHODS(node1.GetPointer());
+  EXERCISE_BASIC_STORAGE_MRML_METHODS(vtkMRMLMarkupsFiducialStorageNode, node1.GetPointer());
+
+  if (argc != 2)
+    {
+    std::cerr << "Line " << __LINE__
+              << " - Missing parameters !\n"
+              << "Usage: " << argv[0] << " /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  const char* tempDir = argv[1];
+  std::string binaryFileName = std::string(tempDir) + "/vtkMRMLMarkupsFiducialStorageNodeTest1.mrkb";
+  std::string csvFileName = std::string(tempDir) + "/vtkMRMLMarkupsFiducialStorageNodeTest1.fcsv";
+  std::string lpsFileName = std::string(tempDir) + "/vtkMRMLMarkupsFiducialStorageNodeTest1_LPS.mrkb";
+  std::string truncatedFileName = std::string(tempDir) + "/vtkMRMLMarkupsFiducialStorageNodeTest1_Truncated.mrkb";
+  std::string invalidHeaderFileName = std::string(tempDir) + "/vtkMRMLMarkupsFiducialStorageNodeTest1_InvalidHeader.mrkb";
+
+  vtkNew<vtkMRMLScene> scene;
+  const int numberOfMarkups = 100000;
+  vtkMRMLMarkupsFiducialNode* markupsNode = AddMarkupsNode(scene.GetPointer());
+  CreateMarkups(markupsNode, numberOfMarkups);
+  vtkNew<vtkTimerLog> timer;
+
+  // Binary round trip, everything is restored exactly
+  vtkMRMLMarkupsFiducialStorageNode* binaryStorageNode = AddStorageNode(scene.GetPointer(), binaryFileName);
+  timer->StartTimer();
+  if (!binaryStorageNode->WriteData(markupsNode))
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to write " << binaryFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  double binaryWriteTime = timer->GetElapsedTime();
+  vtkMRMLMarkupsFiducialNode* binaryMarkupsNode = AddMarkupsNode(scene.GetPointer());
+  vtkMRMLMarkupsFiducialStorageNode* binaryReadStorageNode = AddStorageNode(scene.GetPointer(), binaryFileName);
+  timer->StartTimer();
+  if (!binaryReadStorageNode->ReadData(binaryMarkupsNode))
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to read " << binaryFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  double binaryReadTime = timer->GetElapsedTime();
+  if (!CompareMarkups(markupsNode, binaryMarkupsNode, 0.0, true))
+    {
+    std::cerr << "Line " << __LINE__ << ": binary round trip changed the markups" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Reading again replaces the markups
+  if (!binaryReadStorageNode->ReadData(binaryMarkupsNode)
+    || !CompareMarkups(markupsNode, binaryMarkupsNode, 0.0, true))
+    {
+    std::cerr << "Line " << __LINE__ << ": reading into a non-empty list failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // CSV round trip for comparison, the CSV format does not store the weights
+  vtkMRMLMarkupsFiducialStorageNode* csvStorageNode = AddStorageNode(scene.GetPointer(), csvFileName);
+  timer->StartTimer();
+  if (!csvStorageNode->WriteData(markupsNode))
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to write " << csvFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  double csvWriteTime = timer->GetElapsedTime();
+  vtkMRMLMarkupsFiducialNode* csvMarkupsNode = AddMarkupsNode(scene.GetPointer());
+  vtkMRMLMarkupsFiducialStorageNode* csvReadStorageNode = AddStorageNode(scene.GetPointer(), csvFileName);
+  timer->StartTimer();
+  if (!csvReadStorageNode->ReadData(csvMarkupsNode))
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to read " << csvFileName << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  double csvReadTime = timer->GetElapsedTime();
+  if (!CompareMarkups(markupsNode, csvMarkupsNode, 1e-3, false))
+    {
+    std::cerr << "Line " << __LINE__ << ": CSV round trip changed the markups" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Storing " << numberOfMarkups << " markups: "
+            << "CSV write " << csvWriteTime << "s, read " << csvReadTime << "s, "
+            << "binary write " << binaryWriteTime << "s, read " << binaryReadTime << "s" << std::endl;
+
+  // The coordinate system is stored in the file
+  vtkMRMLMarkupsFiducialStorageNode* lpsStorageNode = AddStorageNode(scene.GetPointer(), lpsFileName);
+  lpsStorageNode->UseLPSOn();
+  vtkMRMLMarkupsFiducialNode* lpsMarkupsNode = AddMarkupsNode(scene.GetPointer());
+  vtkMRMLMarkupsFiducialStorageNode* lpsReadStorageNode = AddStorageNode(scene.GetPointer(), lpsFileName);
+  if (!lpsStorageNode->WriteData(markupsNode)
+    || !lpsReadStorageNode->ReadData(lpsMarkupsNode)
+    || !lpsReadStorageNode->GetUseLPS()
+    || !CompareMarkups(markupsNode, lpsMarkupsNode, 0.0, true))
+    {
+    std::cerr << "Line " << __LINE__ << ": LPS binary round trip failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A truncated file is rejected
+  {
+    std::ifstream binaryFile(binaryFileName.c_str(), std::ios::in | std::ios::binary);
+    std::vector<char> content(100000);
+    binaryFile.read(&content[0], content.size());
+    std::ofstream truncatedFile(truncatedFileName.c_str(), std::ios::out | std::ios::binary);
+    truncatedFile.write(&content[0], content.size());
+  }
+  vtkMRMLMarkupsFiducialNode* truncatedMarkupsNode = AddMarkupsNode(scene.GetPointer());
+  vtkMRMLMarkupsFiducialStorageNode* truncatedStorageNode = AddStorageNode(scene.GetPointer(), truncatedFileName);
+  vtkNew<vtkTest::ErrorObserver> errorObserver;
+  truncatedStorageNode->AddObserver(vtkCommand::ErrorEvent, errorObserver.GetPointer());
+  if (truncatedStorageNode->ReadData(truncatedMarkupsNode)
+    || !errorObserver->GetError()
+    || truncatedMarkupsNode->GetNumberOfMarkups() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": truncated binary file is not rejected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Files with version 0 or an unknown coordinate system are rejected.
+  // The version follows the 8 byte magic, the coordinate system the byte order mark.
+  const std::streamoff versionOffset = 8;
+  const std::streamoff coordinateSystemOffset = 16;
+  const vtkTypeUInt32 invalidValues[2] = {0, 3};
+  const std::streamoff invalidOffsets[2] = {versionOffset, coordinateSystemOffset};
+  for (int i = 0; i < 2; ++i)
+    {
+    {
+      std::ifstream binaryFile(lpsFileName.c_str(), std::ios::in | std::ios::binary);
+      std::vector<char> content((std::istreambuf_iterator<char>(binaryFile)), std::istreambuf_iterator<char>());
+      memcpy(&content[invalidOffsets[i]], &invalidValues[i], sizeof(vtkTypeUInt32));
+      std::ofstream invalidHeaderFile(invalidHeaderFileName.c_str(), std::ios::out | std::ios::binary);
+      invalidHeaderFile.write(&content[0], content.size());
+    }
+    vtkMRMLMarkupsFiducialNode* invalidHeaderMarkupsNode = AddMarkupsNode(scene.GetPointer());
+    vtkMRMLMarkupsFiducialStorageNode* invalidHeaderStorageNode = AddStorageNode(scene.GetPointer(), invalidHeaderFileName);
+    vtkNew<vtkTest::ErrorObserver> invalidHeaderErrorObserver;
+    invalidHeaderStorageNode->AddObserver(vtkCommand::ErrorEvent, invalidHeaderErrorObserver.GetPointer());
+    if (invalidHeaderStorageNode->ReadData(invalidHeaderMarkupsNode)
+      || !invalidHeaderErrorObserver->GetError()
+      || invalidHeaderMarkupsNode->GetNumberOfMarkups() != 0
+      || invalidHeaderStorageNode->GetUseLPS())
+      {
+      std::cerr << "Line " << __LINE__ << ": binary file with an invalid "
+                << (i == 0 ? "version" : "coordinate system") << " is not rejected" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
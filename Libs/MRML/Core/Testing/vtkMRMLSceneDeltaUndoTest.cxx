@@ -0,0 +1,385 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkSegment.h"
+#include "vtkSegmentationConverter.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+int SumOfVoxels(vtkImageData* image)
+{
+  int extent[6];
+  image->GetExtent(extent);
+  int sum = 0;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        sum += *static_cast<unsigned char*>(image->GetScalarPointer(i, j, k));
+        }
+      }
+    }
+  return sum;
+}
+
+//---------------------------------------------------------------------------
+void Paint(vtkImageData* image, int extent[6], unsigned char value)
+{
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        *static_cast<unsigned char*>(image->GetScalarPointer(i, j, k)) = value;
+        }
+      }
+    }
+  image->Modified();
+}
+
+//---------------------------------------------------------------------------
+int TestImageRegionUndo()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  scene->SetDeltaUndo(true);
+
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(100, 100, 10);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  int wholeExtent[6] = {0, 99, 0, 99, 0, 9};
+  Paint(image.GetPointer(), wholeExtent, 0);
+
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetAndObserveImageData(image.GetPointer());
+  scene->AddNode(volumeNode.GetPointer());
+
+  // first stroke: two overlapping dabs
+  int dab1[6] = {10, 19, 10, 19, 0, 0};
+  int dab2[6] = {15, 24, 15, 24, 0, 0};
+  scene->SaveImageRegionStateForUndo(image.GetPointer(), dab1, volumeNode.GetPointer(), true);
+  Paint(image.GetPointer(), dab1, 1);
+  scene->SaveImageRegionStateForUndo(image.GetPointer(), dab2, volumeNode.GetPointer());
+  Paint(image.GetPointer(), dab2, 1);
+  int afterFirstStroke = SumOfVoxels(image.GetPointer());
+
+  // second stroke
+  int dab3[6] = {50, 59, 50, 59, 0, 9};
+  scene->SaveImageRegionStateForUndo(image.GetPointer(), dab3, volumeNode.GetPointer(), true);
+  Paint(image.GetPointer(), dab3, 1);
+  int afterSecondStroke = SumOfVoxels(image.GetPointer());
+
+  if (scene->GetNumberOfUndoLevels() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of undo levels: "
+              << scene->GetNumberOfUndoLevels() << std::endl;
+    return EXIT_FAILURE;
+    }
+  // only the painted bricks are saved, not the whole image
+  if (scene->GetUndoMemorySize() == 0 ||
+      scene->GetUndoMemorySize() >= 2 * static_cast<unsigned long>(image->GetActualMemorySize()))
+    {
+    std::cerr << "Line " << __LINE__ << ": unexpected undo memory size: "
+              << scene->GetUndoMemorySize() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  scene->Undo();
+  if (SumOfVoxels(image.GetPointer()) != afterFirstStroke)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo of second stroke failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Undo();
+  if (SumOfVoxels(image.GetPointer()) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo of first stroke failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Redo();
+  if (SumOfVoxels(image.GetPointer()) != afterFirstStroke)
+    {
+    std::cerr << "Line " << __LINE__ << ": redo of first stroke failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Redo();
+  if (SumOfVoxels(image.GetPointer()) != afterSecondStroke)
+    {
+    std::cerr << "Line " << __LINE__ << ": redo of second stroke failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // memory budget: keep the most recent level only
+  scene->SetUndoMemoryLimit(1);
+  scene->SaveImageRegionStateForUndo(image.GetPointer(), dab1, volumeNode.GetPointer(), true);
+  if (scene->GetNumberOfUndoLevels() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": memory limit not applied: "
+              << scene->GetNumberOfUndoLevels() << " levels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the running total follows the discarded levels
+  scene->ClearUndoStack();
+  scene->ClearRedoStack();
+  if (scene->GetUndoMemorySize() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo memory size not reset: "
+              << scene->GetUndoMemorySize() << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestNodeSnapshotReuse()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  scene->SetDeltaUndo(true);
+  scene->SetUndoStackSize(3);
+
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode1;
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode2;
+  scene->AddNode(volumeNode1.GetPointer());
+  scene->AddNode(volumeNode2.GetPointer());
+  volumeNode1->SetName("Volume1");
+  volumeNode2->SetName("Volume2");
+
+  scene->SaveStateForUndo();
+  volumeNode1->SetName("Volume1-modified");
+  scene->SaveStateForUndo();
+  volumeNode1->SetName("Volume1-modified-again");
+
+  scene->Undo();
+  if (strcmp(volumeNode1->GetName(), "Volume1-modified") != 0 ||
+      strcmp(volumeNode2->GetName(), "Volume2") != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo failed: "
+              << volumeNode1->GetName() << " " << volumeNode2->GetName() << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Undo();
+  if (strcmp(volumeNode1->GetName(), "Volume1") != 0 ||
+      strcmp(volumeNode2->GetName(), "Volume2") != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo failed: "
+              << volumeNode1->GetName() << " " << volumeNode2->GetName() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // a removed node is restored with its snapshot shared with older levels
+  scene->SaveStateForUndo();
+  scene->SaveStateForUndo();
+  std::string removedID = volumeNode2->GetID();
+  scene->RemoveNode(volumeNode2.GetPointer());
+  scene->Undo();
+  vtkMRMLNode* restoredNode = scene->GetNodeByID(removedID.c_str());
+  if (!restoredNode || strcmp(restoredNode->GetName(), "Volume2") != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": removed node not restored" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // stack size
+  for (int i = 0; i < 5; ++i)
+    {
+    scene->SaveStateForUndo();
+    }
+  if (scene->GetNumberOfUndoLevels() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo stack size not applied: "
+              << scene->GetNumberOfUndoLevels() << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestRedoStackSize()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  scene->SetUndoStackSize(3);
+
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  scene->AddNode(volumeNode.GetPointer());
+  for (int i = 0; i < 3; ++i)
+    {
+    scene->SaveStateForUndo();
+    volumeNode->SetName("Volume");
+    }
+  for (int i = 0; i < 3; ++i)
+    {
+    scene->Undo();
+    }
+  if (scene->GetNumberOfRedoLevels() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of redo levels: "
+              << scene->GetNumberOfRedoLevels() << std::endl;
+    return EXIT_FAILURE;
+    }
+  // the redo levels are limited as well
+  scene->SetUndoStackSize(1);
+  scene->Redo();
+  if (scene->GetNumberOfUndoLevels() != 1 || scene->GetNumberOfRedoLevels() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo stack size not applied to the redo levels: "
+              << scene->GetNumberOfUndoLevels() << " undo levels, "
+              << scene->GetNumberOfRedoLevels() << " redo levels" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+// A segmentation snapshot deep copies the segments: it is counted once,
+// even when it is shared by several undo levels.
+int TestSegmentationSnapshotMemory()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  scene->SetDeltaUndo(true);
+
+  vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+  scene->AddNode(segmentationNode.GetPointer());
+  const char* surfaceName = vtkSegmentationConverter::GetSegmentationClosedSurfaceRepresentationName();
+  segmentationNode->GetSegmentation()->SetMasterRepresentationName(surfaceName);
+  vtkNew<vtkPoints> points;
+  for (int i = 0; i < 10000; ++i)
+    {
+    points->InsertNextPoint(i, 0., 0.);
+    }
+  vtkNew<vtkPolyData> surface;
+  surface->SetPoints(points.GetPointer());
+  vtkNew<vtkSegment> segment;
+  segment->AddRepresentation(surfaceName, surface.GetPointer());
+  segmentationNode->GetSegmentation()->AddSegment(segment.GetPointer());
+
+  scene->SaveStateForUndo();
+  unsigned long snapshotSize = scene->GetUndoMemorySize();
+  if (snapshotSize == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": segments not counted in the undo memory size" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->SaveStateForUndo();
+  scene->SaveStateForUndo();
+  if (scene->GetUndoMemorySize() != snapshotSize)
+    {
+    std::cerr << "Line " << __LINE__ << ": shared snapshot counted more than once: "
+              << scene->GetUndoMemorySize() << " instead of " << snapshotSize << std::endl;
+    return EXIT_FAILURE;
+    }
+  // a modified segment is copied again
+  surface->Modified();
+  scene->SaveStateForUndo();
+  if (scene->GetUndoMemorySize() <= snapshotSize)
+    {
+    std::cerr << "Line " << __LINE__ << ": modified segmentation not copied: "
+              << scene->GetUndoMemorySize() << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+// Seeds edited in PathPlan are saved with SaveStateForUndo(listNode) before
+// each addition or move. Markups have no bulk data, so the history of a
+// planning session must not count toward the undo memory budget.
+int TestSeedUndo()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  scene->SetDeltaUndo(true);
+
+  vtkNew<vtkMRMLMarkupsFiducialNode> seedsNode;
+  scene->AddNode(seedsNode.GetPointer());
+
+  for (int i = 0; i < 10; ++i)
+    {
+    scene->SaveStateForUndo(seedsNode.GetPointer());
+    seedsNode->AddFiducial(i, 0., 0.);
+    }
+  scene->SaveStateForUndo(seedsNode.GetPointer());
+  seedsNode->SetNthFiducialPosition(9, 9., 5., 0.);
+
+  if (scene->GetUndoMemorySize() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": unexpected undo memory size: "
+              << scene->GetUndoMemorySize() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  scene->Undo();
+  double position[3] = {0., 0., 0.};
+  seedsNode->GetNthFiducialPosition(9, position);
+  if (seedsNode->GetNumberOfFiducials() != 10 || position[1] != 0.)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo of seed move failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Undo();
+  if (seedsNode->GetNumberOfFiducials() != 9)
+    {
+    std::cerr << "Line " << __LINE__ << ": undo of seed addition failed: "
+              << seedsNode->GetNumberOfFiducials() << " seeds" << std::endl;
+    return EXIT_FAILURE;
+    }
+  scene->Redo();
+  if (seedsNode->GetNumberOfFiducials() != 10)
+    {
+    std::cerr << "Line " << __LINE__ << ": redo of seed addition failed: "
+              << seedsNode->GetNumberOfFiducials() << " seeds" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneDeltaUndoTest(
+  int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  if (TestImageRegionUndo() != EXIT_SUCCESS ||
+      TestNodeSnapshotReuse() != EXIT_SUCCESS ||
+      TestRedoStackSize() != EXIT_SUCCESS ||
+      TestSegmentationSnapshotMemory() != EXIT_SUCCESS ||
+      TestSeedUndo() != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
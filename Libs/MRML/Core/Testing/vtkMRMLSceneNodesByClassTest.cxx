@@ -0,0 +1,179 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLModelDisplayNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+bool CheckNodesByClass(vtkMRMLScene* scene, const char* className,
+                       const std::vector<vtkMRMLNode*>& expectedNodes,
+                       int line)
+{
+  // reference: linear search of the scene
+  std::vector<vtkMRMLNode*> sceneNodes;
+  for (int i = 0; i < scene->GetNumberOfNodes(); ++i)
+    {
+    if (scene->GetNthNode(i)->IsA(className))
+      {
+      sceneNodes.push_back(scene->GetNthNode(i));
+      }
+    }
+  if (sceneNodes != expectedNodes)
+    {
+    std::cerr << "Line " << line << ": unexpected test scene for "
+              << className << std::endl;
+    return false;
+    }
+
+  if (scene->GetNumberOfNodesByClass(className) != static_cast<int>(expectedNodes.size()))
+    {
+    std::cerr << "Line " << line << ": GetNumberOfNodesByClass(" << className
+              << ") failed: " << scene->GetNumberOfNodesByClass(className)
+              << " instead of " << expectedNodes.size() << std::endl;
+    return false;
+    }
+  std::vector<vtkMRMLNode*> nodes;
+  scene->GetNodesByClass(className, nodes);
+  if (nodes != expectedNodes)
+    {
+    std::cerr << "Line " << line << ": GetNodesByClass(" << className
+              << ", std::vector) failed" << std::endl;
+    return false;
+    }
+  vtkSmartPointer<vtkCollection> collection =
+    vtkSmartPointer<vtkCollection>::Take(scene->GetNodesByClass(className));
+  if (collection->GetNumberOfItems() != static_cast<int>(expectedNodes.size()))
+    {
+    std::cerr << "Line " << line << ": GetNodesByClass(" << className
+              << ") failed" << std::endl;
+    return false;
+    }
+  for (size_t i = 0; i < expectedNodes.size(); ++i)
+    {
+    if (scene->GetNthNodeByClass(static_cast<int>(i), className) != expectedNodes[i] ||
+        collection->GetItemAsObject(static_cast<int>(i)) != expectedNodes[i])
+      {
+      std::cerr << "Line " << line << ": GetNthNodeByClass(" << i << ", "
+                << className << ") failed" << std::endl;
+      return false;
+      }
+    }
+  if (scene->GetNthNodeByClass(static_cast<int>(expectedNodes.size()), className) != NULL)
+    {
+    std::cerr << "Line " << line << ": GetNthNodeByClass(" << expectedNodes.size()
+              << ", " << className << ") failed" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodesByClassTest(
+  int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  std::vector<vtkMRMLNode*> noNodes;
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", noNodes, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkMRMLModelNode> model1;
+  vtkNew<vtkMRMLScalarVolumeNode> volume1;
+  vtkNew<vtkMRMLModelDisplayNode> modelDisplay1;
+  scene->AddNode(model1.GetPointer());
+  scene->AddNode(volume1.GetPointer());
+  scene->AddNode(modelDisplay1.GetPointer());
+
+  // query the class lists to build the cache
+  std::vector<vtkMRMLNode*> displayableNodes;
+  displayableNodes.push_back(model1.GetPointer());
+  displayableNodes.push_back(volume1.GetPointer());
+  std::vector<vtkMRMLNode*> modelNodes;
+  modelNodes.push_back(model1.GetPointer());
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLDisplayableNode", displayableNodes, __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", modelNodes, __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLTransformNode", noNodes, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // the cached lists must follow AddNode
+  vtkNew<vtkMRMLModelNode> model2;
+  scene->AddNode(model2.GetPointer());
+  displayableNodes.push_back(model2.GetPointer());
+  modelNodes.push_back(model2.GetPointer());
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLDisplayableNode", displayableNodes, __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", modelNodes, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // ... and RemoveNode
+  scene->RemoveNode(model1.GetPointer());
+  displayableNodes.erase(displayableNodes.begin());
+  modelNodes.erase(modelNodes.begin());
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLDisplayableNode", displayableNodes, __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", modelNodes, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // InsertBeforeNode changes the order of the scene
+  scene->InsertBeforeNode(volume1.GetPointer(), model1.GetPointer());
+  displayableNodes.insert(displayableNodes.begin(), model1.GetPointer());
+  modelNodes.insert(modelNodes.begin(), model1.GetPointer());
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLDisplayableNode", displayableNodes, __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", modelNodes, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkSmartPointer<vtkCollection> namedNodes = vtkSmartPointer<vtkCollection>::Take(
+    scene->GetNodesByClassByName("vtkMRMLModelNode", model2->GetName()));
+  if (namedNodes->GetNumberOfItems() != 1 ||
+      namedNodes->GetItemAsObject(0) != model2.GetPointer())
+    {
+    std::cerr << "GetNodesByClassByName failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  scene->Clear(1);
+  if (!CheckNodesByClass(scene.GetPointer(), "vtkMRMLDisplayableNode", noNodes, __LINE__) ||
+      !CheckNodesByClass(scene.GetPointer(), "vtkMRMLModelNode", noNodes, __LINE__))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -175,6 +175,49 @@ int vtkMRMLVolumeNodeEventsTest(int , char * [] )
     }
   callback->ResetNumberOfEvents();
 
+  // Update a region of the new image data
+  imageData2->SetDimensions(10, 10, 10);
+  imageData2->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  callback->ResetNumberOfEvents();
+  int regionExtent[6] = {2, 4, 2, 4, 8, 12};
+  volumeNode->ImageDataRegionModified(regionExtent);
+
+  if (!callback->GetErrorString().empty() ||
+      callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) != 0 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 1 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataRegionModifiedEvent) != 1)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::ImageDataRegionModified failed: "
+              << callback->GetErrorString().c_str() << " "
+              << "Number of ModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkCommand::ModifiedEvent) << " "
+              << "Number of ImageDataModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) << " "
+              << "Number of ImageDataRegionModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataRegionModifiedEvent)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  callback->ResetNumberOfEvents();
+
+  // A region outside of the image does not modify anything
+  int outsideExtent[6] = {20, 30, 0, 9, 0, 9};
+  volumeNode->ImageDataRegionModified(outsideExtent);
+
+  if (!callback->GetErrorString().empty() ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) != 0 ||
+      callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataRegionModifiedEvent) != 0)
+    {
+    std::cerr << __LINE__ << ": vtkMRMLVolumeNode::ImageDataRegionModified failed: "
+              << "Number of ImageDataModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataModifiedEvent) << " "
+              << "Number of ImageDataRegionModifiedEvent: "
+              << callback->GetNumberOfEvents(vtkMRMLVolumeNode::ImageDataRegionModifiedEvent)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  callback->ResetNumberOfEvents();
+
   // Clear image data
   volumeNode->SetAndObserveImageData(0);
 
@@ -0,0 +1,222 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkOrientedImageData.h"
+#include "vtkOrientedImageDataResample.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageReslice.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Three labels in nested boxes and a ball, on an extent that does not start at 0
+void CreateLabelmap(vtkImageData* labelmap)
+{
+  labelmap->SetExtent(5, 164, -3, 146, 10, 129);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  int* extent = labelmap->GetExtent();
+  unsigned char* voxels = static_cast<unsigned char*>(labelmap->GetScalarPointer());
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+        {
+        double d = (i - 80.) * (i - 80.) + (j - 60.) * (j - 60.) + (k - 70.) * (k - 70.);
+        unsigned char label = 0;
+        if (d < 40. * 40.)
+          {
+          label = 3;
+          }
+        else if (i > 20 && i < 150 && j > 10 && j < 100 && k > 30)
+          {
+          label = (k < 90 ? 1 : 2);
+          }
+        *(voxels++) = label;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Nearest neighbor resampling through the vtkImageReslice pipeline
+void ResampleWithReslice(vtkImageData* input, vtkMatrix4x4* outputToInputIjkMatrix, int outputExtent[6], vtkImageData* output)
+{
+  vtkNew<vtkTransform> transform;
+  transform->SetMatrix(outputToInputIjkMatrix);
+  vtkNew<vtkImageReslice> reslice;
+  reslice->SetInputData(input);
+  reslice->SetOutputOrigin(0, 0, 0);
+  reslice->SetOutputSpacing(1, 1, 1);
+  reslice->SetOutputExtent(outputExtent);
+  reslice->SetResliceTransform(transform.GetPointer());
+  reslice->SetInterpolationModeToNearestNeighbor();
+  reslice->Update();
+  output->DeepCopy(reslice->GetOutput());
+}
+
+//----------------------------------------------------------------------------
+/// Number of voxels that differ between the two images
+vtkIdType CountDifferences(vtkImageData* image1, vtkImageData* image2)
+{
+  int* extent1 = image1->GetExtent();
+  int* extent2 = image2->GetExtent();
+  for (int i = 0; i < 6; ++i)
+    {
+    if (extent1[i] != extent2[i])
+      {
+      return image1->GetNumberOfPoints();
+      }
+    }
+  unsigned char* voxels1 = static_cast<unsigned char*>(image1->GetScalarPointer());
+  unsigned char* voxels2 = static_cast<unsigned char*>(image2->GetScalarPointer());
+  vtkIdType differences = 0;
+  for (vtkIdType i = 0; i < image1->GetNumberOfPoints(); ++i)
+    {
+    if (voxels1[i] != voxels2[i])
+      {
+      ++differences;
+      }
+    }
+  return differences;
+}
+
+//----------------------------------------------------------------------------
+/// Resample with both paths, print the timings and return the number of different voxels
+vtkIdType CompareWithReslice(const char* name, vtkImageData* input, vtkMatrix4x4* outputToInputIjkMatrix, int outputExtent[6])
+{
+  vtkNew<vtkTimerLog> timer;
+  vtkNew<vtkImageData> resliceOutput;
+  timer->StartTimer();
+  ResampleWithReslice(input, outputToInputIjkMatrix, outputExtent, resliceOutput.GetPointer());
+  timer->StopTimer();
+  double resliceTime = timer->GetElapsedTime();
+
+  vtkNew<vtkImageData> output;
+  timer->StartTimer();
+  if (!vtkOrientedImageDataResample::ResampleImageNearestNeighbor(input, outputToInputIjkMatrix, outputExtent, output.GetPointer()))
+    {
+    std::cerr << name << ": resampling failed" << std::endl;
+    return output->GetNumberOfPoints() + 1;
+    }
+  timer->StopTimer();
+  std::cout << name << ": reslice " << resliceTime << "s, nearest neighbor "
+            << timer->GetElapsedTime() << "s" << std::endl;
+  return CountDifferences(output.GetPointer(), resliceOutput.GetPointer());
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkOrientedImageDataResampleTest1(int , char * [] )
+{
+  vtkNew<vtkImageData> labelmap;
+  CreateLabelmap(labelmap.GetPointer());
+  int outputExtent[6] = { -10, 170, 0, 160, 0, 140 };
+
+  // Integer shift: block copy
+  vtkNew<vtkMatrix4x4> shiftMatrix;
+  shiftMatrix->SetElement(0, 3, 3.0);
+  shiftMatrix->SetElement(1, 3, -2.0);
+  shiftMatrix->SetElement(2, 3, 7.0);
+  if (!vtkOrientedImageDataResample::IsTransformIntegerShiftOrPermutation(shiftMatrix.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": integer shift not detected" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkIdType differences = CompareWithReslice("Integer shift", labelmap.GetPointer(), shiftMatrix.GetPointer(), outputExtent);
+  if (differences != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": integer shift differs from reslice in " << differences << " voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Axis permutation with a flip: strided block copy
+  vtkNew<vtkMatrix4x4> permutationMatrix;
+  permutationMatrix->Zero();
+  permutationMatrix->SetElement(0, 1, 1.0);
+  permutationMatrix->SetElement(1, 0, -1.0);
+  permutationMatrix->SetElement(1, 3, 150.0);
+  permutationMatrix->SetElement(2, 2, 1.0);
+  permutationMatrix->SetElement(2, 3, 4.0);
+  permutationMatrix->SetElement(3, 3, 1.0);
+  if (!vtkOrientedImageDataResample::IsTransformIntegerShiftOrPermutation(permutationMatrix.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": axis permutation not detected" << std::endl;
+    return EXIT_FAILURE;
+    }
+  differences = CompareWithReslice("Axis permutation", labelmap.GetPointer(), permutationMatrix.GetPointer(), outputExtent);
+  if (differences != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": axis permutation differs from reslice in " << differences << " voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // General linear transform: incremental stepping. Only voxels exactly half way between two
+  // input voxels may be rounded differently.
+  vtkNew<vtkTransform> generalTransform;
+  generalTransform->Translate(20.3, -5.7, 12.1);
+  generalTransform->RotateZ(17.0);
+  generalTransform->RotateX(-8.0);
+  generalTransform->Scale(0.9, 1.1, 1.3);
+  if (vtkOrientedImageDataResample::IsTransformIntegerShiftOrPermutation(generalTransform->GetMatrix()))
+    {
+    std::cerr << "Line " << __LINE__ << ": general transform detected as integer shift" << std::endl;
+    return EXIT_FAILURE;
+    }
+  differences = CompareWithReslice("General linear", labelmap.GetPointer(), generalTransform->GetMatrix(), outputExtent);
+  if (differences > labelmap->GetNumberOfPoints() / 1000)
+    {
+    std::cerr << "Line " << __LINE__ << ": general transform differs from reslice in " << differences << " voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Oriented image resampled to a shifted copy of its own geometry goes through the block copy
+  vtkNew<vtkOrientedImageData> orientedLabelmap;
+  orientedLabelmap->ShallowCopy(labelmap.GetPointer());
+  orientedLabelmap->SetSpacing(0.8, 0.8, 2.5);
+  orientedLabelmap->SetOrigin(-50.0, 20.0, 100.0);
+  vtkNew<vtkOrientedImageData> referenceImage;
+  referenceImage->SetExtent(0, 99, 0, 99, 0, 49);
+  referenceImage->SetSpacing(0.8, 0.8, 2.5);
+  referenceImage->SetOrigin(-50.0 + 0.8 * 10, 20.0, 100.0 - 2.5 * 3);
+  vtkNew<vtkOrientedImageData> resampledLabelmap;
+  if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+    orientedLabelmap.GetPointer(), referenceImage.GetPointer(), resampledLabelmap.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": oriented image resampling failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Reference voxel (i,j,k) is input voxel (i+10,j,k-3)
+  unsigned char* resampledVoxel = static_cast<unsigned char*>(resampledLabelmap->GetScalarPointer(70, 60, 43));
+  unsigned char* inputVoxel = static_cast<unsigned char*>(labelmap->GetScalarPointer(80, 60, 40));
+  int* resampledExtent = resampledLabelmap->GetExtent();
+  if ( resampledExtent[0] != 0 || resampledExtent[1] != 99 || resampledExtent[5] != 49
+    || !resampledVoxel || !inputVoxel || *resampledVoxel != *inputVoxel || *inputVoxel != 3 )
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong oriented image resampling" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,299 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkOrientedImageData.h"
+#include "vtkParallelLabelmapToSurfaceFilter.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMarchingCubes.h>
+#include <vtkMassProperties.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmoothPolyDataFilter.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <utility>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Two overlapping balls, on a grid with anisotropic spacing
+void CreateLabelmap(vtkImageData* labelmap)
+{
+  const int size = 64;
+  labelmap->SetDimensions(size, size, size);
+  labelmap->SetOrigin(-12., 5., 30.);
+  labelmap->SetSpacing(1., 1., 1.5);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* voxels = static_cast<unsigned char*>(labelmap->GetScalarPointer());
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        double d1 = (i - 25.) * (i - 25.) + (j - 30.) * (j - 30.) + (k - 28.) * (k - 28.);
+        double d2 = (i - 40.) * (i - 40.) + (j - 32.) * (j - 32.) + (k - 40.) * (k - 40.);
+        *(voxels++) = (d1 < 18. * 18. || d2 < 14. * 14.) ? 1 : 0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Every edge of a closed surface is shared by exactly two triangles
+bool IsClosed(vtkPolyData* surface)
+{
+  std::map<std::pair<vtkIdType, vtkIdType>, int> edgeCounts;
+  vtkCellArray* polys = surface->GetPolys();
+  vtkIdType numberOfPoints = 0;
+  vtkIdType* pointIds = NULL;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfPoints, pointIds); )
+    {
+    for (vtkIdType i = 0; i < numberOfPoints; ++i)
+      {
+      vtkIdType a = pointIds[i];
+      vtkIdType b = pointIds[(i + 1) % numberOfPoints];
+      ++edgeCounts[std::make_pair(std::min(a, b), std::max(a, b))];
+      }
+    }
+  for (std::map<std::pair<vtkIdType, vtkIdType>, int>::iterator edgeIt = edgeCounts.begin();
+       edgeIt != edgeCounts.end(); ++edgeIt)
+    {
+    if (edgeIt->second != 2)
+      {
+      return false;
+      }
+    }
+  return !edgeCounts.empty();
+}
+
+//----------------------------------------------------------------------------
+double ComputeVolume(vtkPolyData* surface)
+{
+  vtkNew<vtkMassProperties> massProperties;
+  massProperties->SetInputData(surface);
+  massProperties->Update();
+  return massProperties->GetVolume();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkParallelLabelmapToSurfaceFilterTest1(int , char * [] )
+{
+  vtkNew<vtkParallelLabelmapToSurfaceFilter> filter;
+  EXERCISE_BASIC_OBJECT_METHODS(filter.GetPointer());
+
+  vtkNew<vtkImageData> labelmap;
+  CreateLabelmap(labelmap.GetPointer());
+
+  // Reference: marching cubes on the whole labelmap
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  vtkNew<vtkMarchingCubes> marchingCubes;
+  marchingCubes->SetInputData(labelmap.GetPointer());
+  marchingCubes->SetValue(0, 0.5);
+  marchingCubes->ComputeScalarsOff();
+  marchingCubes->ComputeGradientsOff();
+  marchingCubes->ComputeNormalsOff();
+  marchingCubes->Update();
+  timer->StopTimer();
+  double serialTime = timer->GetElapsedTime();
+  vtkPolyData* reference = marchingCubes->GetOutput();
+
+  // Slabs of 8 slices, stitched
+  filter->SetInputLabelmap(labelmap.GetPointer());
+  filter->SetNumberOfThreads(4);
+  filter->SetMinimumSlabThickness(8);
+  timer->StartTimer();
+  if (!filter->Update())
+    {
+    std::cerr << "Line " << __LINE__ << ": surface extraction failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  std::cout << "Marching cubes: " << serialTime << "s, "
+            << "slabs: " << timer->GetElapsedTime() << "s" << std::endl;
+
+  vtkNew<vtkPolyData> surface;
+  surface->DeepCopy(filter->GetOutput());
+  if (surface->GetNumberOfPoints() != reference->GetNumberOfPoints() ||
+      surface->GetNumberOfPolys() != reference->GetNumberOfPolys())
+    {
+    std::cerr << "Line " << __LINE__ << ": seams not stitched: "
+              << surface->GetNumberOfPoints() << " points and "
+              << surface->GetNumberOfPolys() << " triangles instead of "
+              << reference->GetNumberOfPoints() << " points and "
+              << reference->GetNumberOfPolys() << " triangles" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!IsClosed(surface.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": surface is not closed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  double volume = ComputeVolume(surface.GetPointer());
+  double referenceVolume = ComputeVolume(reference);
+  if (fabs(volume - referenceVolume) > 1e-6 * referenceVolume)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong volume: " << volume
+              << " instead of " << referenceVolume << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The conversion rule extracts the slabs by default and keeps the serial Laplacian smoothing:
+  // same surface as marching cubes followed by vtkSmoothPolyDataFilter
+  vtkNew<vtkSmoothPolyDataFilter> referenceSmoothing;
+  referenceSmoothing->SetInputData(reference);
+  referenceSmoothing->SetRelaxationFactor(0.1);
+  referenceSmoothing->Update();
+  vtkNew<vtkOrientedImageData> orientedLabelmap;
+  orientedLabelmap->ShallowCopy(labelmap.GetPointer());
+  vtkNew<vtkBinaryLabelmapToClosedSurfaceConversionRule> conversionRule;
+  conversionRule->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetDecimationFactorParameterName(), "0.0");
+  conversionRule->SetConversionParameter(vtkBinaryLabelmapToClosedSurfaceConversionRule::GetSmoothingFactorParameterName(), "0.1");
+  vtkNew<vtkPolyData> convertedSurface;
+  double referenceSmoothedVolume = ComputeVolume(referenceSmoothing->GetOutput());
+  if (!conversionRule->Convert(orientedLabelmap.GetPointer(), convertedSurface.GetPointer()) ||
+      convertedSurface->GetNumberOfPoints() != reference->GetNumberOfPoints() ||
+      convertedSurface->GetNumberOfPolys() != reference->GetNumberOfPolys() ||
+      fabs(ComputeVolume(convertedSurface.GetPointer()) - referenceSmoothedVolume) > 1e-4 * referenceSmoothedVolume)
+    {
+    std::cerr << "Line " << __LINE__ << ": default conversion differs from marching cubes and Laplacian smoothing" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Smoothing moves the points but keeps the topology and the volume
+  filter->SetSmoothingFactor(0.5);
+  if (!filter->Update())
+    {
+    std::cerr << "Line " << __LINE__ << ": smoothing failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkPolyData* smoothedSurface = filter->GetOutput();
+  double smoothedVolume = ComputeVolume(smoothedSurface);
+  if (smoothedSurface->GetNumberOfPoints() != surface->GetNumberOfPoints() ||
+      !IsClosed(smoothedSurface) ||
+      fabs(smoothedVolume - volume) > 0.05 * volume)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong smoothing, volume " << smoothedVolume
+              << " instead of " << volume << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The threads must not change the smoothing
+  vtkNew<vtkParallelLabelmapToSurfaceFilter> serialFilter;
+  serialFilter->SetInputLabelmap(labelmap.GetPointer());
+  serialFilter->SetNumberOfThreads(1);
+  serialFilter->SetSmoothingFactor(0.5);
+  if (!serialFilter->Update() ||
+      serialFilter->GetOutput()->GetNumberOfPoints() != smoothedSurface->GetNumberOfPoints() ||
+      fabs(ComputeVolume(serialFilter->GetOutput()) - smoothedVolume) > 1e-6 * smoothedVolume)
+    {
+    std::cerr << "Line " << __LINE__ << ": different serial smoothing" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Decimation
+  filter->SetSmoothingFactor(0.);
+  filter->SetDecimationFactor(0.5);
+  if (!filter->Update() ||
+      filter->GetOutput()->GetNumberOfPolys() > 0.6 * surface->GetNumberOfPolys() ||
+      filter->GetOutput()->GetNumberOfPolys() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong decimation" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Changing the decimation reuses the slab surfaces
+  filter->SetDecimationFactor(0.);
+  if (!filter->Update() || filter->GetNumberOfExtractedSlabs() != 0 ||
+      filter->GetOutput()->GetNumberOfPoints() != surface->GetNumberOfPoints())
+    {
+    std::cerr << "Line " << __LINE__ << ": slab surfaces are not reused, "
+              << filter->GetNumberOfExtractedSlabs() << " slabs extracted" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Painting a block in the first slab only extracts that slab again
+  int paintedExtent[6] = {2, 10, 2, 10, 3, 6};
+  filter->InputRegionModified(paintedExtent);
+  for (int k = paintedExtent[4]; k <= paintedExtent[5]; ++k)
+    {
+    for (int j = paintedExtent[2]; j <= paintedExtent[3]; ++j)
+      {
+      for (int i = paintedExtent[0]; i <= paintedExtent[1]; ++i)
+        {
+        *static_cast<unsigned char*>(labelmap->GetScalarPointer(i, j, k)) = 1;
+        }
+      }
+    }
+  labelmap->GetPointData()->GetScalars()->Modified();
+  if (!filter->Update() || filter->GetNumberOfExtractedSlabs() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << filter->GetNumberOfExtractedSlabs()
+              << " slabs extracted after painting instead of 1" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkNew<vtkParallelLabelmapToSurfaceFilter> paintedReferenceFilter;
+  paintedReferenceFilter->SetInputLabelmap(labelmap.GetPointer());
+  paintedReferenceFilter->SetNumberOfThreads(4);
+  paintedReferenceFilter->SetMinimumSlabThickness(8);
+  if (!paintedReferenceFilter->Update() ||
+      filter->GetOutput()->GetNumberOfPoints() != paintedReferenceFilter->GetOutput()->GetNumberOfPoints() ||
+      filter->GetOutput()->GetNumberOfPolys() != paintedReferenceFilter->GetOutput()->GetNumberOfPolys() ||
+      !IsClosed(filter->GetOutput()) ||
+      fabs(ComputeVolume(filter->GetOutput()) - ComputeVolume(paintedReferenceFilter->GetOutput())) > 1e-6 * volume)
+    {
+    std::cerr << "Line " << __LINE__ << ": surface updated in the painted slab differs from the extracted surface" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A modification that is not reported extracts all the slabs
+  *static_cast<unsigned char*>(labelmap->GetScalarPointer(30, 30, 50)) = 0;
+  labelmap->GetPointData()->GetScalars()->Modified();
+  if (!filter->Update() || filter->GetNumberOfExtractedSlabs() != 4)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << filter->GetNumberOfExtractedSlabs()
+              << " slabs extracted after an unreported modification instead of 4" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Empty labelmap
+  vtkNew<vtkImageData> emptyLabelmap;
+  emptyLabelmap->SetDimensions(10, 10, 10);
+  emptyLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  memset(emptyLabelmap->GetScalarPointer(), 0, 1000);
+  filter->SetInputLabelmap(emptyLabelmap.GetPointer());
+  std::cout << "Expecting an error on the empty labelmap" << std::endl;
+  if (filter->Update())
+    {
+    std::cerr << "Line " << __LINE__ << ": surface extracted from an empty labelmap" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
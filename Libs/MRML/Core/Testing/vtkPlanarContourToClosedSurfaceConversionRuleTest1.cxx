@@ -0,0 +1,162 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkPlanarContourToClosedSurfaceConversionRule.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void AddCircle(vtkPoints* points, vtkCellArray* lines,
+               double centerX, double centerY, double radius, double z, int numberOfPoints)
+{
+  vtkIdType firstPointId = points->GetNumberOfPoints();
+  lines->InsertNextCell(numberOfPoints + 1);
+  for (int i = 0; i < numberOfPoints; ++i)
+    {
+    double angle = 2. * vtkMath::Pi() * i / numberOfPoints;
+    lines->InsertCellPoint(points->InsertNextPoint(
+      centerX + radius * cos(angle), centerY + radius * sin(angle), z));
+    }
+  // closed contour: the first point is repeated
+  lines->InsertCellPoint(firstPointId);
+}
+
+//----------------------------------------------------------------------------
+/// Stack of circles of varying radius, that branches into two circles
+/// in the upper half, the way an RT structure of a bifurcation does.
+void CreateContourStack(vtkPolyData* contours, int numberOfPlanes, int numberOfPointsPerContour)
+{
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> lines;
+  for (int plane = 0; plane < numberOfPlanes; ++plane)
+    {
+    double z = 2.5 * plane;
+    if (plane < numberOfPlanes / 2)
+      {
+      AddCircle(points.GetPointer(), lines.GetPointer(),
+                0., 0., 20. + 5. * sin(0.3 * plane), z, numberOfPointsPerContour);
+      }
+    else
+      {
+      AddCircle(points.GetPointer(), lines.GetPointer(),
+                -11., 0., 9. + sin(0.5 * plane), z, numberOfPointsPerContour);
+      AddCircle(points.GetPointer(), lines.GetPointer(),
+                11., 1., 8. + cos(0.5 * plane), z, numberOfPointsPerContour);
+      }
+    }
+  contours->SetPoints(points.GetPointer());
+  contours->SetLines(lines.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+bool Convert(vtkPolyData* contours, const char* numberOfThreads,
+             vtkPolyData* surface, double& time)
+{
+  vtkNew<vtkPlanarContourToClosedSurfaceConversionRule> rule;
+  rule->SetConversionParameter(
+    vtkPlanarContourToClosedSurfaceConversionRule::GetNumberOfThreadsParameterName(),
+    numberOfThreads);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  bool success = rule->Convert(contours, surface);
+  timer->StopTimer();
+  time = timer->GetElapsedTime();
+  return success;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkPlanarContourToClosedSurfaceConversionRuleTest1(int , char * [] )
+{
+  vtkNew<vtkPlanarContourToClosedSurfaceConversionRule> rule;
+  EXERCISE_BASIC_OBJECT_METHODS(rule.GetPointer());
+
+  vtkNew<vtkPolyData> contours;
+  CreateContourStack(contours.GetPointer(), 60, 400);
+
+  vtkNew<vtkPolyData> serialSurface;
+  double serialTime = 0.;
+  if (!Convert(contours.GetPointer(), "1", serialSurface.GetPointer(), serialTime))
+    {
+    std::cerr << "Line " << __LINE__ << ": serial conversion failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkPolyData> parallelSurface;
+  double parallelTime = 0.;
+  if (!Convert(contours.GetPointer(), "0", parallelSurface.GetPointer(), parallelTime))
+    {
+    std::cerr << "Line " << __LINE__ << ": parallel conversion failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Serial conversion: " << serialTime << "s, "
+            << "parallel conversion: " << parallelTime << "s" << std::endl;
+
+  if (serialSurface->GetNumberOfPolys() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": no triangles generated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The threads must not change the result
+  if (parallelSurface->GetNumberOfPoints() != serialSurface->GetNumberOfPoints() ||
+      parallelSurface->GetNumberOfPolys() != serialSurface->GetNumberOfPolys())
+    {
+    std::cerr << "Line " << __LINE__ << ": different surfaces: "
+              << parallelSurface->GetNumberOfPoints() << " points and "
+              << parallelSurface->GetNumberOfPolys() << " triangles instead of "
+              << serialSurface->GetNumberOfPoints() << " points and "
+              << serialSurface->GetNumberOfPolys() << " triangles" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkIdTypeArray* serialCells = serialSurface->GetPolys()->GetData();
+  vtkIdTypeArray* parallelCells = parallelSurface->GetPolys()->GetData();
+  if (parallelCells->GetNumberOfTuples() != serialCells->GetNumberOfTuples() ||
+      memcmp(parallelCells->GetPointer(0), serialCells->GetPointer(0),
+             serialCells->GetNumberOfTuples() * sizeof(vtkIdType)) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": different triangles" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType pointId = 0; pointId < serialSurface->GetNumberOfPoints(); ++pointId)
+    {
+    double serialPoint[3] = {0., 0., 0.};
+    double parallelPoint[3] = {0., 0., 0.};
+    serialSurface->GetPoint(pointId, serialPoint);
+    parallelSurface->GetPoint(pointId, parallelPoint);
+    if (vtkMath::Distance2BetweenPoints(serialPoint, parallelPoint) != 0.)
+      {
+      std::cerr << "Line " << __LINE__ << ": different point " << pointId << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLCoreTestingUtilities.h"
+#include "vtkMRMLTransformNode.h"
+#include "vtkTransformDisplacementFieldCache.h"
+
+// VTK includes
+#include <vtkGeneralTransform.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkOrientedBSplineTransform.h>
+#include <vtkOrientedGridTransform.h>
+#include <vtkPoints.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+double GetMaximumDistance(vtkPoints* points1, vtkPoints* points2)
+{
+  double maximumDistance = 0.0;
+  for (vtkIdType i = 0; i < points1->GetNumberOfPoints(); ++i)
+    {
+    double point1[3] = {0.0, 0.0, 0.0};
+    double point2[3] = {0.0, 0.0, 0.0};
+    points1->GetPoint(i, point1);
+    points2->GetPoint(i, point2);
+    maximumDistance = std::max(maximumDistance, sqrt(vtkMath::Distance2BetweenPoints(point1, point2)));
+    }
+  return maximumDistance;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkTransformDisplacementFieldCacheTest1(int , char * [] )
+{
+  vtkNew<vtkTransformDisplacementFieldCache> cache;
+  EXERCISE_BASIC_OBJECT_METHODS(cache.GetPointer());
+
+  vtkNew<vtkOrientedBSplineTransform> bsplineTransform;
+  vtkMRMLCoreTestingUtilities::CreateBSplineTransform(bsplineTransform.GetPointer());
+  vtkNew<vtkMRMLTransformNode> transformNode;
+  transformNode->SetAndObserveTransformToParent(bsplineTransform.GetPointer());
+
+  // Random points in the region of the field
+  const vtkIdType numberOfPoints = 200000;
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  vtkMath::RandomSeed(12345);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    points->SetPoint(i, vtkMath::Random(-40., 40.), vtkMath::Random(-40., 40.), vtkMath::Random(-40., 40.));
+    }
+
+  // Reference: one point at a time
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformNode->GetTransformToWorld(transformToWorld.GetPointer());
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  vtkNew<vtkPoints> expectedPoints;
+  expectedPoints->SetNumberOfPoints(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    expectedPoints->SetPoint(i, transformToWorld->TransformPoint(points->GetPoint(i)));
+    }
+  timer->StopTimer();
+  double serialTime = timer->GetElapsedTime();
+
+  // Exact transformation by multiple threads
+  vtkNew<vtkPoints> exactPoints;
+  timer->StartTimer();
+  vtkTransformDisplacementFieldCache::TransformPointsExact(transformToWorld.GetPointer(), points.GetPointer(), exactPoints.GetPointer());
+  timer->StopTimer();
+  double exactTime = timer->GetElapsedTime();
+  if (exactPoints->GetNumberOfPoints() != numberOfPoints
+    || GetMaximumDistance(exactPoints.GetPointer(), expectedPoints.GetPointer()) > 1e-9)
+    {
+    std::cerr << "Line " << __LINE__ << ": multithreaded exact transformation differs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Interpolation of the cached field
+  double bounds[6] = {-40., 40., -40., 40., -40., 40.};
+  cache->SetTransformNode(transformNode.GetPointer());
+  cache->SetBounds(bounds);
+  cache->SetSpacing(2.0);
+  timer->StartTimer();
+  if (!cache->Update())
+    {
+    std::cerr << "Line " << __LINE__ << ": displacement field cannot be computed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  double fieldTime = timer->GetElapsedTime();
+  vtkNew<vtkPoints> interpolatedPoints;
+  timer->StartTimer();
+  cache->TransformPoints(points.GetPointer(), interpolatedPoints.GetPointer());
+  timer->StopTimer();
+  double interpolationTime = timer->GetElapsedTime();
+  double interpolationError = GetMaximumDistance(interpolatedPoints.GetPointer(), expectedPoints.GetPointer());
+  if (interpolationError > 0.05)
+    {
+    std::cerr << "Line " << __LINE__ << ": interpolation error is " << interpolationError << "mm" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Transforming " << numberOfPoints << " points: serial " << serialTime << "s, "
+            << "multithreaded " << exactTime << "s, field sampling " << fieldTime << "s, "
+            << "interpolation " << interpolationTime << "s, maximum error " << interpolationError << "mm" << std::endl;
+
+  // The grid transform interpolates the same field
+  vtkOrientedGridTransform* fieldTransformToWorld = cache->GetTransformToWorld();
+  double testPoint[3] = {12.3, -7.1, 25.9};
+  double expectedPoint[3] = {0.0, 0.0, 0.0};
+  transformToWorld->TransformPoint(testPoint, expectedPoint);
+  double interpolatedPoint[3] = {0.0, 0.0, 0.0};
+  fieldTransformToWorld->TransformPoint(testPoint, interpolatedPoint);
+  if (sqrt(vtkMath::Distance2BetweenPoints(expectedPoint, interpolatedPoint)) > 0.05)
+    {
+    std::cerr << "Line " << __LINE__ << ": grid transform of the field is inaccurate" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The inverse field brings the points back
+  vtkNew<vtkPoints> inversePoints;
+  cache->TransformPoints(expectedPoints.GetPointer(), inversePoints.GetPointer(), true);
+  double inverseError = GetMaximumDistance(inversePoints.GetPointer(), points.GetPointer());
+  if (inverseError > 0.1)
+    {
+    std::cerr << "Line " << __LINE__ << ": inverse error is " << inverseError << "mm" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Points outside the field are transformed exactly
+  vtkNew<vtkPoints> outsidePoints;
+  outsidePoints->InsertNextPoint(60., 0., 0.);
+  outsidePoints->InsertNextPoint(-10., 20., -55.);
+  vtkNew<vtkPoints> transformedOutsidePoints;
+  cache->TransformPoints(outsidePoints.GetPointer(), transformedOutsidePoints.GetPointer());
+  for (vtkIdType i = 0; i < outsidePoints->GetNumberOfPoints(); ++i)
+    {
+    transformToWorld->TransformPoint(outsidePoints->GetPoint(i), expectedPoint);
+    if (sqrt(vtkMath::Distance2BetweenPoints(expectedPoint, transformedOutsidePoints->GetPoint(i))) > 1e-9)
+      {
+      std::cerr << "Line " << __LINE__ << ": point outside the field is not transformed exactly" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // The field is reused until the transform changes
+  if (cache->GetTransformToWorld() != fieldTransformToWorld)
+    {
+    std::cerr << "Line " << __LINE__ << ": unchanged field is sampled again" << std::endl;
+    return EXIT_FAILURE;
+    }
+  bsplineTransform->SetDisplacementScale(2.0);
+  if (cache->GetTransformToWorld() == fieldTransformToWorld)
+    {
+    std::cerr << "Line " << __LINE__ << ": field is not updated after the transform changed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  transformToWorld->Update();
+  transformToWorld->TransformPoint(testPoint, expectedPoint);
+  cache->GetTransformToWorld()->TransformPoint(testPoint, interpolatedPoint);
+  if (sqrt(vtkMath::Distance2BetweenPoints(expectedPoint, interpolatedPoint)) > 0.1)
+    {
+    std::cerr << "Line " << __LINE__ << ": updated field is inaccurate" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Without bounds every point is transformed exactly
+  vtkNew<vtkTransformDisplacementFieldCache> emptyCache;
+  emptyCache->SetTransformNode(transformNode.GetPointer());
+  if (emptyCache->GetTransformToWorld() != NULL
+    || !emptyCache->TransformPoints(points.GetPointer(), exactPoints.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong transformation without a field" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    expectedPoints->SetPoint(i, transformToWorld->TransformPoint(points->GetPoint(i)));
+    }
+  if (GetMaximumDistance(exactPoints.GetPointer(), expectedPoints.GetPointer()) > 1e-9)
+    {
+    std::cerr << "Line " << __LINE__ << ": points are not transformed exactly without a field" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The transform node keeps one cache, which does not reference the node
+  vtkTransformDisplacementFieldCache* nodeCache = transformNode->GetDisplacementFieldCache();
+  if (nodeCache == NULL || transformNode->GetDisplacementFieldCache() != nodeCache
+    || nodeCache->GetTransformNode() != transformNode.GetPointer()
+    || transformNode->GetReferenceCount() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": invalid displacement field cache of the transform node" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
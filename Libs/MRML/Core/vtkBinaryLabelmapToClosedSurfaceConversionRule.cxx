@@ -22,12 +22,12 @@
 #include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
 
 #include "vtkOrientedImageData.h"
+#include "vtkParallelLabelmapToSurfaceFilter.h"
 
 // VTK includes
 #include <vtkObjectFactory.h>
 #include <vtkPolyData.h>
 #include <vtkVersion.h>
-#include <vtkMarchingCubes.h>
 #include <vtkDecimatePro.h>
 #include <vtkSmoothPolyDataFilter.h>
 #include <vtkTransform.h>
@@ -42,7 +42,8 @@ vtkSegmentationConverterRuleNewMacro(vtkBinaryLabelmapToClosedSurfaceConversionR
 vtkBinaryLabelmapToClosedSurfaceConversionRule::vtkBinaryLabelmapToClosedSurfaceConversionRule()
 {
   this->ConversionParameters[GetDecimationFactorParameterName()] = std::make_pair("0.0", "Desired reduction in the total number of polygons (e.g., if set to 0.9, then reduce the data set to 10% of its original size)");
-  this->ConversionParameters[GetSmoothingFactorParameterName()] = std::make_pair("0.1", "Relaxation factor for Laplacian smoothing. Value of 0 results in no smoothing, while 1 means significant smoothing.");
+  this->ConversionParameters[GetSmoothingFactorParameterName()] = std::make_pair("0.1", "Relaxation factor for Laplacian smoothing, or pass band of 10^(-4*factor) for windowed sinc smoothing in the fused conversion. Value of 0 results in no smoothing, while 1 means significant smoothing.");
+  this->ConversionParameters[GetFusedConversionParameterName()] = std::make_pair("0", "If 1, then marching cubes runs on slabs of the labelmap in parallel, followed by quadric decimation (topology not preserved) and multithreaded windowed sinc smoothing. If 0 (default), then marching cubes, vtkDecimatePro and Laplacian smoothing run serially on the whole labelmap.");
 }
 
 //----------------------------------------------------------------------------
@@ -123,6 +124,8 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkDataObject* sour
     this->ConversionParameters[GetDecimationFactorParameterName()].first );
   double smoothingFactor = vtkSegmentationConverter::DeserializeFloatingPointConversionParameter(
     this->ConversionParameters[GetSmoothingFactorParameterName()].first );
+  bool fusedConversion = (vtkSegmentationConverter::DeserializeFloatingPointConversionParameter(
+    this->ConversionParameters[GetFusedConversionParameterName()].first) != 0.0);
 
   // Save geometry of oriented image data before conversion so that it can be applied on the poly data afterwards
   vtkSmartPointer<vtkMatrix4x4> labelmapImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
@@ -136,69 +139,45 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkDataObject* sour
   identityMatrix->Identity();
   binaryLabelmapWithIdentityGeometry->SetGeometryFromImageToWorldMatrix(identityMatrix);
 
-  // Run marching cubes
-  vtkSmartPointer<vtkMarchingCubes> marchingCubes = vtkSmartPointer<vtkMarchingCubes>::New();
-  marchingCubes->SetInputData(binaryLabelmapWithIdentityGeometry);
-  marchingCubes->SetNumberOfContours(1);
-  marchingCubes->SetValue(0, 0.5); //TODO: In the vtkLabelmapToModelFilter class this is LabelValue/2.0. If we know why, it would make sense to explain it here.
-  marchingCubes->ComputeScalarsOff();
-  marchingCubes->ComputeGradientsOff();
-  marchingCubes->ComputeNormalsOff();
-  try
+  // Marching cubes on slabs in parallel, the stitched surface is the same as the vtkMarchingCubes surface.
+  // The fused conversion also decimates (quadric) and smooths (windowed sinc) with multiple threads.
+  vtkSmartPointer<vtkParallelLabelmapToSurfaceFilter> surfaceFilter = vtkSmartPointer<vtkParallelLabelmapToSurfaceFilter>::New();
+  surfaceFilter->SetInputLabelmap(binaryLabelmapWithIdentityGeometry);
+  surfaceFilter->SetIsoValue(0.5); //TODO: In the vtkLabelmapToModelFilter class this is LabelValue/2.0. If we know why, it would make sense to explain it here.
+  if (fusedConversion)
   {
-    marchingCubes->Update();
+    surfaceFilter->SetDecimationFactor(decimationFactor);
+    surfaceFilter->SetSmoothingFactor(smoothingFactor);
   }
-  catch(...)
-  {
-    vtkErrorMacro("Convert: Error while running marching cubes!");
-    return false;
-  }
-  if (marchingCubes->GetOutput()->GetNumberOfPolys() == 0)
+  if (!surfaceFilter->Update())
   {
     vtkErrorMacro("Convert: No polygons can be created!");
+    if (paddingNecessary)
+    {
+      binaryLabelMap->Delete();
+    }
     return false;
   }
-
-  // Decimate if necessary
-  vtkSmartPointer<vtkDecimatePro> decimator = vtkSmartPointer<vtkDecimatePro>::New();
-  decimator->SetInputConnection(marchingCubes->GetOutputPort());
-  if (decimationFactor > 0.0)
+  vtkSmartPointer<vtkPolyData> surface = surfaceFilter->GetOutput();
+  if (!fusedConversion)
   {
-    decimator->SetFeatureAngle(60);
-    decimator->SplittingOff();
-    decimator->PreserveTopologyOn();
-    decimator->SetMaximumError(1);
-    decimator->SetTargetReduction(decimationFactor);
-    try
+    surface = vtkSmartPointer<vtkPolyData>::New();
+    if (!this->DecimateAndSmoothSurface(surfaceFilter->GetOutput(), decimationFactor, smoothingFactor, surface))
     {
-      decimator->Update();
-    }
-    catch(...)
-    {
-      vtkErrorMacro("Error decimating model");
+      if (paddingNecessary)
+      {
+        binaryLabelMap->Delete();
+      }
       return false;
     }
   }
 
-  // Perform smoothing using specified factor
-  vtkSmartPointer<vtkSmoothPolyDataFilter> smoothFilter = vtkSmartPointer<vtkSmoothPolyDataFilter>::New();
-  if (decimationFactor > 0.0)
-  {
-    smoothFilter->SetInputConnection(decimator->GetOutputPort());
-  }
-  else
-  {
-    smoothFilter->SetInputConnection(marchingCubes->GetOutputPort());
-  }
-  smoothFilter->SetRelaxationFactor(smoothingFactor);
-  smoothFilter->Update();
-
   // Transform the result surface from labelmap IJK to world coordinate system
   vtkSmartPointer<vtkTransform> labelmapGeometryTransform = vtkSmartPointer<vtkTransform>::New();
   labelmapGeometryTransform->SetMatrix(labelmapImageToWorldMatrix);
 
   vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyDataFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-  transformPolyDataFilter->SetInputConnection(smoothFilter->GetOutputPort());
+  transformPolyDataFilter->SetInputData(surface);
   transformPolyDataFilter->SetTransform(labelmapGeometryTransform);
   transformPolyDataFilter->Update();
 
@@ -217,7 +196,8 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkDataObject* sour
 
 
 
-bool vtkBinaryLabelmapToClosedSurfaceConversionRule::ConvertUseLabel(vtkDataObject* sourceRepresentation, vtkDataObject* targetRepresentation, int label)
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::ConvertUseLabel(vtkDataObject* sourceRepresentation, vtkDataObject* targetRepresentation, int label,
+	vtkParallelLabelmapToSurfaceFilter* surfaceFilter/*=NULL*/)
 {
 	// Check validity of source and target representation objects
 	vtkOrientedImageData* binaryLabelMap = vtkOrientedImageData::SafeDownCast(sourceRepresentation);
@@ -248,6 +228,8 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::ConvertUseLabel(vtkDataObje
 		this->ConversionParameters[GetDecimationFactorParameterName()].first);
 	double smoothingFactor = vtkSegmentationConverter::DeserializeFloatingPointConversionParameter(
 		this->ConversionParameters[GetSmoothingFactorParameterName()].first);
+	bool fusedConversion = (vtkSegmentationConverter::DeserializeFloatingPointConversionParameter(
+		this->ConversionParameters[GetFusedConversionParameterName()].first) != 0.0);
 
 	// Save geometry of oriented image data before conversion so that it can be applied on the poly data afterwards
 	vtkSmartPointer<vtkMatrix4x4> labelmapImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
@@ -261,69 +243,53 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::ConvertUseLabel(vtkDataObje
 	identityMatrix->Identity();
 	binaryLabelmapWithIdentityGeometry->SetGeometryFromImageToWorldMatrix(identityMatrix);
 
-	// Run marching cubes
-	vtkSmartPointer<vtkMarchingCubes> marchingCubes = vtkSmartPointer<vtkMarchingCubes>::New();
-	marchingCubes->SetInputData(binaryLabelmapWithIdentityGeometry);
-	marchingCubes->SetNumberOfContours(1);
-	marchingCubes->SetValue(0, 0.5*label); //TODO: In the vtkLabelmapToModelFilter class this is LabelValue/2.0. If we know why, it would make sense to explain it here.
-	marchingCubes->ComputeScalarsOff();
-	marchingCubes->ComputeGradientsOff();
-	marchingCubes->ComputeNormalsOff();
-	try
+	// Marching cubes on slabs in parallel, the stitched surface is the same as the vtkMarchingCubes surface.
+	// The fused conversion also decimates (quadric) and smooths (windowed sinc) with multiple threads.
+	// The slab surfaces of a filter kept by the caller are reused in the slabs that are not modified.
+	vtkSmartPointer<vtkParallelLabelmapToSurfaceFilter> slabFilter = surfaceFilter;
+	if (!slabFilter)
 	{
-		marchingCubes->Update();
+		slabFilter = vtkSmartPointer<vtkParallelLabelmapToSurfaceFilter>::New();
 	}
-	catch (...)
+	slabFilter->SetInputLabelmap(binaryLabelmapWithIdentityGeometry);
+	slabFilter->SetIsoValue(0.5*label); //TODO: In the vtkLabelmapToModelFilter class this is LabelValue/2.0. If we know why, it would make sense to explain it here.
+	slabFilter->SetDecimationFactor(fusedConversion ? decimationFactor : 0.0);
+	slabFilter->SetSmoothingFactor(fusedConversion ? smoothingFactor : 0.0);
+	bool success = slabFilter->Update();
+	// The filter must not keep the labelmap of the caller
+	slabFilter->SetInputLabelmap(NULL);
+	vtkSmartPointer<vtkPolyData> surface;
+	if (!success)
 	{
-		vtkErrorMacro("Convert: Error while running marching cubes!");
-		return false;
+		vtkErrorMacro("Convert: No polygons can be created!");
 	}
-	if (marchingCubes->GetOutput()->GetNumberOfPolys() == 0)
+	else if (fusedConversion)
 	{
-		vtkErrorMacro("Convert: No polygons can be created!");
-		return false;
+		surface = slabFilter->GetOutput();
 	}
-
-	// Decimate if necessary
-	vtkSmartPointer<vtkDecimatePro> decimator = vtkSmartPointer<vtkDecimatePro>::New();
-	decimator->SetInputConnection(marchingCubes->GetOutputPort());
-	if (decimationFactor > 0.0)
+	else
 	{
-		decimator->SetFeatureAngle(60);
-		decimator->SplittingOff();
-		decimator->PreserveTopologyOn();
-		decimator->SetMaximumError(1);
-		decimator->SetTargetReduction(decimationFactor);
-		try
+		surface = vtkSmartPointer<vtkPolyData>::New();
+		if (!this->DecimateAndSmoothSurface(slabFilter->GetOutput(), decimationFactor, smoothingFactor, surface))
 		{
-			decimator->Update();
-		}
-		catch (...)
-		{
-			vtkErrorMacro("Error decimating model");
-			return false;
+			surface = NULL;
 		}
 	}
-
-	// Perform smoothing using specified factor
-	vtkSmartPointer<vtkSmoothPolyDataFilter> smoothFilter = vtkSmartPointer<vtkSmoothPolyDataFilter>::New();
-	if (decimationFactor > 0.0)
+	if (!surface)
 	{
-		smoothFilter->SetInputConnection(decimator->GetOutputPort());
-	}
-	else
-	{
-		smoothFilter->SetInputConnection(marchingCubes->GetOutputPort());
+		if (paddingNecessary)
+		{
+			binaryLabelMap->Delete();
+		}
+		return false;
 	}
-	smoothFilter->SetRelaxationFactor(smoothingFactor);
-	smoothFilter->Update();
 
 	// Transform the result surface from labelmap IJK to world coordinate system
 	vtkSmartPointer<vtkTransform> labelmapGeometryTransform = vtkSmartPointer<vtkTransform>::New();
 	labelmapGeometryTransform->SetMatrix(labelmapImageToWorldMatrix);
 
 	vtkSmartPointer<vtkTransformPolyDataFilter> transformPolyDataFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-	transformPolyDataFilter->SetInputConnection(smoothFilter->GetOutputPort());
+	transformPolyDataFilter->SetInputData(surface);
 	transformPolyDataFilter->SetTransform(labelmapGeometryTransform);
 	transformPolyDataFilter->Update();
 
@@ -418,3 +384,44 @@ void vtkBinaryLabelmapToClosedSurfaceConversionRule::PadLabelmap(vtkOrientedImag
   padder->Update();
   binaryLabelMap->vtkImageData::DeepCopy(padder->GetOutput());
 }
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::DecimateAndSmoothSurface(vtkPolyData* surface,
+  double decimationFactor, double smoothingFactor, vtkPolyData* outputSurface)
+{
+  // Decimate if necessary
+  vtkSmartPointer<vtkDecimatePro> decimator = vtkSmartPointer<vtkDecimatePro>::New();
+  decimator->SetInputData(surface);
+  if (decimationFactor > 0.0)
+  {
+    decimator->SetFeatureAngle(60);
+    decimator->SplittingOff();
+    decimator->PreserveTopologyOn();
+    decimator->SetMaximumError(1);
+    decimator->SetTargetReduction(decimationFactor);
+    try
+    {
+      decimator->Update();
+    }
+    catch(...)
+    {
+      vtkErrorMacro("Error decimating model");
+      return false;
+    }
+  }
+
+  // Perform smoothing using specified factor
+  vtkSmartPointer<vtkSmoothPolyDataFilter> smoothFilter = vtkSmartPointer<vtkSmoothPolyDataFilter>::New();
+  if (decimationFactor > 0.0)
+  {
+    smoothFilter->SetInputConnection(decimator->GetOutputPort());
+  }
+  else
+  {
+    smoothFilter->SetInputData(surface);
+  }
+  smoothFilter->SetRelaxationFactor(smoothingFactor);
+  smoothFilter->Update();
+  outputSurface->ShallowCopy(smoothFilter->GetOutput());
+  return true;
+}
@@ -29,11 +29,15 @@
 
 #include "vtkMRMLWin32Header.h"
 
+class vtkParallelLabelmapToSurfaceFilter;
+class vtkPolyData;
+
 /// \ingroup SegmentationCore
 /// \brief Convert binary labelmap representation (vtkOrientedImageData type) to
 ///   closed surface representation (vtkPolyData type). The conversion algorithm
 ///   performs a marching cubes operation on the image data followed by an optional
-///   decimation step.
+///   decimation step. Marching cubes runs on slabs of the labelmap in parallel
+///   (see vtkParallelLabelmapToSurfaceFilter).
 class VTK_MRML_EXPORT vtkBinaryLabelmapToClosedSurfaceConversionRule
   : public vtkSegmentationConverterRule
 {
@@ -42,6 +46,12 @@ public:
   static const std::string GetDecimationFactorParameterName() { return "Decimation factor"; };
   /// Conversion parameter: smoothing factor
   static const std::string GetSmoothingFactorParameterName() { return "Smoothing factor"; };
+  /// Conversion parameter: fused conversion. Marching cubes always runs on slabs of the labelmap in
+  /// parallel (vtkParallelLabelmapToSurfaceFilter), which gives the same surface as vtkMarchingCubes.
+  /// If enabled then the filter also decimates the surface by vtkQuadricDecimation, which does not
+  /// preserve the topology, and smooths it by a multithreaded windowed sinc filter. Otherwise (default)
+  /// the surface is decimated by vtkDecimatePro and smoothed by Laplacian smoothing serially, as before.
+  static const std::string GetFusedConversionParameterName() { return "Fused conversion"; };
 
 public:
   static vtkBinaryLabelmapToClosedSurfaceConversionRule* New();
@@ -62,7 +72,11 @@ public:
   virtual bool Convert(vtkDataObject* sourceRepresentation, vtkDataObject* targetRepresentation);
 
   /// Update the target representation based on the source representation
-  bool ConvertUseLabel(vtkDataObject* sourceRepresentation, vtkDataObject* targetRepresentation, int label);
+  /// \param surfaceFilter Filter of the marching cubes slabs. A filter kept by the caller for the same labelmap
+  ///   (e.g. vtkSegment::GetLabelmapSurfaceFilter) only extracts the surface again in the slabs of the
+  ///   regions reported as modified. A new filter is used if NULL.
+  bool ConvertUseLabel(vtkDataObject* sourceRepresentation, vtkDataObject* targetRepresentation, int label,
+    vtkParallelLabelmapToSurfaceFilter* surfaceFilter=NULL);
 
   /// Get the cost of the conversion.
   virtual unsigned int GetConversionCost(vtkDataObject* sourceRepresentation=NULL, vtkDataObject* targetRepresentation=NULL);
@@ -85,6 +99,11 @@ protected:
   /// This function adds a 1 voxel padding to the labelmap in these cases.
   void PadLabelmap(vtkOrientedImageData* binaryLabelMap);
 
+  /// Decimate the marching cubes surface with vtkDecimatePro (topology preserved) and smooth it with
+  /// Laplacian smoothing, serially. Used when the fused conversion is off.
+  /// \return False if the decimation fails
+  bool DecimateAndSmoothSurface(vtkPolyData* surface, double decimationFactor, double smoothingFactor, vtkPolyData* outputSurface);
+
 protected:
   vtkBinaryLabelmapToClosedSurfaceConversionRule();
   ~vtkBinaryLabelmapToClosedSurfaceConversionRule();
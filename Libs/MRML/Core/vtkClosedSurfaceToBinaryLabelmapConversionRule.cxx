@@ -41,10 +41,21 @@
 #include <vtkStripper.h>
 #include <vtkTriangleFilter.h>
 #include <vtkPolyDataToImageStencil.h>
+#include <vtkImageStencilData.h>
+#include <vtkTimerLog.h>
 
 // STD includes
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 
+namespace
+{
+/// Each block of slices rasterized at once has at most this fraction of the memory limit in voxels,
+/// its stencil is a fraction of that.
+const double BLOCK_SIZE_FRACTION_OF_MEMORY_LIMIT = 1.0 / 16.0;
+}
+
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkClosedSurfaceToBinaryLabelmapConversionRule);
 
@@ -55,6 +66,14 @@ vtkClosedSurfaceToBinaryLabelmapConversionRule::vtkClosedSurfaceToBinaryLabelmap
   this->ConversionParameters[vtkSegmentationConverter::GetReferenceImageGeometryParameterName()] = std::make_pair("", "Image geometry description string determining the geometry of the labelmap that is created in course of conversion. Can be copied from a volume, using the button.");
   // Oversampling factor parameter
   this->ConversionParameters[GetOversamplingFactorParameterName()] = std::make_pair("1", "Determines the oversampling of the reference image geometry. If it's a number, then all segments are oversampled with the same value (value of 1 means no oversampling). If it has the value \"A\", then automatic oversampling is calculated.");
+  // Memory limit parameter
+  this->ConversionParameters[GetMemoryLimitParameterName()] = std::make_pair("0", "Maximum size of the labelmap of a segment in megabytes. If it's 0, then there is no limit. Otherwise the labelmap is rasterized in blocks of slices, and the oversampling factor is lowered if the labelmap would exceed the limit.");
+
+  this->CurrentConversionReport.RequestedOversamplingFactor = 1.0;
+  this->CurrentConversionReport.OversamplingFactor = 1.0;
+  this->CurrentConversionReport.NumberOfBlocks = 0;
+  this->CurrentConversionReport.PeakMemorySize = 0.0;
+  this->CurrentConversionReport.Time = 0.0;
 }
 
 //----------------------------------------------------------------------------
@@ -127,6 +146,14 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::Convert(vtkDataObject* sour
     return false;
   }
 
+  double checkpointStart = vtkTimerLog::GetUniversalTime();
+  this->CurrentConversionReport.RequestedOversamplingFactor = 1.0;
+  this->CurrentConversionReport.OversamplingFactor = 1.0;
+  this->CurrentConversionReport.NumberOfBlocks = 1;
+  this->CurrentConversionReport.PeakMemorySize = 0.0;
+  double memoryLimit = vtkSegmentationConverter::DeserializeFloatingPointConversionParameter(
+    this->ConversionParameters[GetMemoryLimitParameterName()].first );
+
   // Setup output labelmap
 
   // Compute output labelmap geometry based on poly data, an reference image
@@ -195,27 +222,102 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::Convert(vtkDataObject* sour
   polyDataToImageStencil->SetOutputOrigin(binaryLabelMap->GetOrigin());
   polyDataToImageStencil->SetOutputWholeExtent(binaryLabelMap->GetExtent());
 
-  // Convert stencil to image
-  vtkNew<vtkImageStencil> stencil;
-  stencil->SetInputData(binaryLabelMap);
-  stencil->SetStencilConnection(polyDataToImageStencil->GetOutputPort());
-  stencil->ReverseStencilOn();
-  stencil->SetBackgroundValue(1); // General foreground value is 1 (background value because of reverse stencil)
+  int extent[6] = {0,-1,0,-1,0,-1};
+  binaryLabelMap->GetExtent(extent);
+  double labelmapSize = static_cast<double>(binaryLabelMap->GetNumberOfPoints()) * binaryLabelMap->GetScalarSize();
 
-  // Save result to output
-  vtkNew<vtkImageCast> imageCast;
-  imageCast->SetInputConnection(stencil->GetOutputPort());
-  imageCast->SetOutputScalarTypeToUnsignedChar();
-  imageCast->Update();
-  binaryLabelMap->ShallowCopy(imageCast->GetOutput());
+  if (memoryLimit > 0.0)
+  {
+    // Rasterize the surface in blocks of slices directly into the labelmap, so that
+    // only the stencil of one block exists at a time besides the labelmap
+    stripper->Update();
+    double surfaceSize = stripper->GetOutput()->GetActualMemorySize() * 1024.0;
+
+    double sliceSize = static_cast<double>(extent[1]-extent[0]+1) * (extent[3]-extent[2]+1);
+    int numberOfSlicesPerBlock = std::max(1, static_cast<int>(
+      memoryLimit * 1024.0 * 1024.0 * BLOCK_SIZE_FRACTION_OF_MEMORY_LIMIT / std::max(sliceSize, 1.0) ));
+
+    double maximumStencilSize = 0.0;
+    this->CurrentConversionReport.NumberOfBlocks = 0;
+    for (int blockStart = extent[4]; blockStart <= extent[5]; blockStart += numberOfSlicesPerBlock)
+    {
+      int blockExtent[6] = { extent[0], extent[1], extent[2], extent[3],
+        blockStart, std::min(blockStart + numberOfSlicesPerBlock - 1, extent[5]) };
+      polyDataToImageStencil->SetOutputWholeExtent(blockExtent);
+      polyDataToImageStencil->Update();
+      double stencilSize = this->FillLabelmapFromStencil(polyDataToImageStencil->GetOutput(), blockExtent, binaryLabelMap);
+      maximumStencilSize = std::max(maximumStencilSize, stencilSize);
+      ++this->CurrentConversionReport.NumberOfBlocks;
+    }
+    this->CurrentConversionReport.PeakMemorySize = labelmapSize + surfaceSize + maximumStencilSize;
+  }
+  else
+  {
+    // Convert stencil to image
+    vtkNew<vtkImageStencil> stencil;
+    stencil->SetInputData(binaryLabelMap);
+    stencil->SetStencilConnection(polyDataToImageStencil->GetOutputPort());
+    stencil->ReverseStencilOn();
+    stencil->SetBackgroundValue(1); // General foreground value is 1 (background value because of reverse stencil)
+
+    // Save result to output
+    vtkNew<vtkImageCast> imageCast;
+    imageCast->SetInputConnection(stencil->GetOutputPort());
+    imageCast->SetOutputScalarTypeToUnsignedChar();
+    imageCast->Update();
+
+    // Input, stencil output and cast output labelmaps exist at the same time
+    this->CurrentConversionReport.PeakMemorySize = 3.0 * labelmapSize
+      + stripper->GetOutput()->GetActualMemorySize() * 1024.0
+      + polyDataToImageStencil->GetOutput()->GetActualMemorySize() * 1024.0;
+
+    binaryLabelMap->ShallowCopy(imageCast->GetOutput());
+  }
 
   // Restore geometry of the labelmap that we set to identity before conversion
   // (so that we can perform the stencil operations in IJK space)
   binaryLabelMap->SetGeometryFromImageToWorldMatrix(outputLabelmapImageToWorldMatrix);
-  
+
+  this->CurrentConversionReport.Time = vtkTimerLog::GetUniversalTime() - checkpointStart;
+  this->ConversionReports.push_back(this->CurrentConversionReport);
+  vtkDebugMacro("Convert: Conversion with oversampling factor " << this->CurrentConversionReport.OversamplingFactor
+    << " in " << this->CurrentConversionReport.NumberOfBlocks << " block(s) took " << this->CurrentConversionReport.Time
+    << " s, estimated peak memory: " << this->CurrentConversionReport.PeakMemorySize / (1024.0*1024.0) << " MB");
+
   return true;
 }
 
+//----------------------------------------------------------------------------
+double vtkClosedSurfaceToBinaryLabelmapConversionRule::FillLabelmapFromStencil(vtkImageStencilData* stencilData, int extent[6], vtkOrientedImageData* binaryLabelMap)
+{
+  if (!stencilData || !binaryLabelMap)
+  {
+    vtkErrorMacro("FillLabelmapFromStencil: Invalid input!");
+    return 0.0;
+  }
+
+  vtkIdType numberOfSubExtents = 0;
+  for (int z = extent[4]; z <= extent[5]; ++z)
+  {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+    {
+      int iter = 0;
+      int r1 = extent[0];
+      int r2 = extent[1];
+      while (stencilData->GetNextExtent(r1, r2, extent[0], extent[1], y, z, iter))
+      {
+        unsigned char* voxelsPointer = static_cast<unsigned char*>(binaryLabelMap->GetScalarPointer(r1, y, z));
+        memset(voxelsPointer, 1, r2-r1+1); // General foreground value is 1
+        ++numberOfSubExtents;
+      }
+    }
+  }
+
+  // The stencil stores the list of the sub-extents of each row
+  double numberOfRows = static_cast<double>(extent[3]-extent[2]+1) * (extent[5]-extent[4]+1);
+  return numberOfRows * (sizeof(int) + sizeof(int*)) + numberOfSubExtents * 2.0 * sizeof(int);
+}
+
 //----------------------------------------------------------------------------
 bool vtkClosedSurfaceToBinaryLabelmapConversionRule::CalculateOutputGeometry(vtkPolyData* closedSurfacePolyData, vtkOrientedImageData* geometryImageData)
 {
@@ -282,9 +384,52 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::CalculateOutputGeometry(vtk
     }
   }
 
+  this->CurrentConversionReport.RequestedOversamplingFactor = oversamplingFactor;
+
+  // Keep the reference geometry in case the oversampling factor needs to be lowered
+  vtkSmartPointer<vtkOrientedImageData> referenceGeometryImageData = vtkSmartPointer<vtkOrientedImageData>::New();
+  referenceGeometryImageData->DeepCopy(geometryImageData);
+
   // Apply oversampling if needed
   vtkCalculateOversamplingFactor::ApplyOversamplingOnImageGeometry(geometryImageData, oversamplingFactor);
+  this->CropGeometryToSurface(closedSurfacePolyData, geometryImageData);
+
+  // Lower the oversampling factor if the labelmap would exceed the memory limit
+  double memoryLimit = vtkSegmentationConverter::DeserializeFloatingPointConversionParameter(
+    this->ConversionParameters[GetMemoryLimitParameterName()].first ) * 1024.0 * 1024.0;
+  if (memoryLimit > 0.0)
+  {
+    double minimumOversamplingFactor = std::min(1.0, oversamplingFactor);
+    double labelmapSize = static_cast<double>(geometryImageData->GetNumberOfPoints()); // unsigned char voxels
+    while (labelmapSize > memoryLimit && oversamplingFactor > minimumOversamplingFactor)
+    {
+      // The size of the labelmap is proportional to the cube of the oversampling factor
+      oversamplingFactor = std::max(minimumOversamplingFactor,
+        0.95 * oversamplingFactor * pow(memoryLimit / labelmapSize, 1.0/3.0));
+      geometryImageData->DeepCopy(referenceGeometryImageData);
+      vtkCalculateOversamplingFactor::ApplyOversamplingOnImageGeometry(geometryImageData, oversamplingFactor);
+      this->CropGeometryToSurface(closedSurfacePolyData, geometryImageData);
+      labelmapSize = static_cast<double>(geometryImageData->GetNumberOfPoints());
+    }
+    if (labelmapSize > memoryLimit)
+    {
+      vtkWarningMacro("CalculateOutputGeometry: Labelmap of " << labelmapSize / (1024.0*1024.0)
+        << " MB exceeds the memory limit even without oversampling");
+    }
+    else if (oversamplingFactor != this->CurrentConversionReport.RequestedOversamplingFactor)
+    {
+      vtkInfoMacro("CalculateOutputGeometry: Oversampling factor lowered from " << this->CurrentConversionReport.RequestedOversamplingFactor
+        << " to " << oversamplingFactor << " to respect the memory limit");
+    }
+  }
+  this->CurrentConversionReport.OversamplingFactor = oversamplingFactor;
 
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkClosedSurfaceToBinaryLabelmapConversionRule::CropGeometryToSurface(vtkPolyData* closedSurfacePolyData, vtkOrientedImageData* geometryImageData)
+{
   // We need to apply inverse of direction matrix to the input poly data
   // so that we can expand the image in its IJK directions
   vtkSmartPointer<vtkMatrix4x4> geometryImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
@@ -315,8 +460,6 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::CalculateOutputGeometry(vtk
 
   // Set effective extent back to the image (less memory needed if the extent only covers the non-zero region)
   geometryImageData->SetExtent(surfaceExtent);
-
-  return true;
 }
 
 //----------------------------------------------------------------------------
@@ -28,6 +28,10 @@
 //#include "vtkSegmentationCoreConfigure.h"
 #include "vtkMRMLWin32Header.h"
 
+// STD includes
+#include <vector>
+
+class vtkImageStencilData;
 class vtkPolyData;
 
 /// \ingroup SegmentationCore
@@ -44,6 +48,27 @@ public:
   /// then automatic oversampling is calculated.
   static const std::string GetOversamplingFactorParameterName() { return "Oversampling factor"; };
 
+  /// Conversion parameter: memory limit
+  /// Maximum size of the labelmap of a segment in megabytes. If it is 0, then there is no limit and the
+  /// labelmap is rasterized at once. Otherwise the labelmap is rasterized in blocks of slices, and the
+  /// oversampling factor is lowered (but not below 1) if the oversampled labelmap would exceed the limit.
+  static const std::string GetMemoryLimitParameterName() { return "Memory limit (MB)"; };
+
+  /// Report of the conversion of a segment
+  struct ConversionReport
+  {
+    /// Oversampling factor given by the parameter (or calculated automatically)
+    double RequestedOversamplingFactor;
+    /// Oversampling factor actually used, lower than the requested one if the memory limit would be exceeded
+    double OversamplingFactor;
+    /// Number of blocks of slices rasterized one after the other (1 if there is no memory limit)
+    int NumberOfBlocks;
+    /// Estimated peak memory used by the conversion in bytes (labelmap, surface and stencil)
+    double PeakMemorySize;
+    /// Conversion time in seconds
+    double Time;
+  };
+
 public:
   static vtkClosedSurfaceToBinaryLabelmapConversionRule* New();
   vtkTypeMacro(vtkClosedSurfaceToBinaryLabelmapConversionRule, vtkSegmentationConverterRule);
@@ -74,6 +99,12 @@ public:
   /// Human-readable name of the target representation
   virtual const char* GetTargetRepresentationName() { return vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(); };
 
+  /// Reports of the successful conversions done by this rule, in the order of the conversions
+  /// (i.e. in the order the segments are converted)
+  const std::vector<ConversionReport>& GetConversionReports() { return this->ConversionReports; };
+  /// Remove all the conversion reports
+  void ClearConversionReports() { this->ConversionReports.clear(); };
+
 protected:
   /// Calculate actual geometry of the output labelmap volume by verifying that the reference image geometry
   /// encompasses the input surface model, and extending it to the proper directions if necessary.
@@ -82,6 +113,15 @@ protected:
   /// \return Success flag indicating sane calculated extents
   bool CalculateOutputGeometry(vtkPolyData* closedSurfacePolyData, vtkOrientedImageData* geometryImageData);
 
+  /// Set the extent of the image geometry to the bounding box of the surface in its IJK coordinates
+  /// \param closedSurfacePolyData Input closed surface poly data to convert
+  /// \param geometryImageData Image geometry, its extent is replaced
+  void CropGeometryToSurface(vtkPolyData* closedSurfacePolyData, vtkOrientedImageData* geometryImageData);
+
+  /// Set the voxels of the labelmap inside the stencil to 1 within the given extent
+  /// \return Estimated memory size of the stencil in bytes
+  double FillLabelmapFromStencil(vtkImageStencilData* stencilData, int extent[6], vtkOrientedImageData* binaryLabelMap);
+
   /// Get default image geometry string in case of absence of parameter.
   /// The default geometry has identity directions and 1 mm uniform spacing,
   /// with origin and extent defined using the argument poly data.
@@ -93,6 +133,12 @@ protected:
   vtkClosedSurfaceToBinaryLabelmapConversionRule();
   ~vtkClosedSurfaceToBinaryLabelmapConversionRule();
   void operator=(const vtkClosedSurfaceToBinaryLabelmapConversionRule&);
+
+protected:
+  /// Report of the conversion in progress, filled by CalculateOutputGeometry and Convert
+  ConversionReport CurrentConversionReport;
+  /// Reports of the successful conversions
+  std::vector<ConversionReport> ConversionReports;
 };
 
 #endif // __vtkClosedSurfaceToBinaryLabelmapConversionRule_h
@@ -3,15 +3,27 @@
 #include "vtkCacheManager.h"
 #include "vtkDataFileFormatHelper.h"
 #include "vtkDataTransfer.h"
+#include "vtkMRMLScene.h"
 #include "vtkMRMLStorageNode.h"
 #include "vtkMRMLStorableNode.h"
 
 // VTK includes
 #include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
+#include <vtkCommand.h>
+#include <vtkCriticalSection.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkOutputWindow.h>
+#include <vtkSmartPointer.h>
 
 // STD includes
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
 
 vtkStandardNewMacro ( vtkDataIOManager );
 vtkCxxSetObjectMacro(vtkDataIOManager, CacheManager, vtkCacheManager);
@@ -25,6 +37,8 @@ vtkDataIOManager::vtkDataIOManager()
   this->DataTransferCollection = vtkCollection::New();
   this->CacheManager = NULL;
   this->EnableAsynchronousIO = 0;
+  this->EnableConcurrentLocalIO = 1;
+  this->NumberOfLocalIOThreads = 0;
 
   //--- set up callback
   this->TransferUpdateCommand = vtkCallbackCommand::New();
@@ -100,6 +114,8 @@ void vtkDataIOManager::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "DataTransferCollection: " << this->GetDataTransferCollection() << "\n";
   os << indent << "CacheManager: " << this->GetCacheManager() << "\n";
   os << indent << "EnableAsynchronousIO: " << this->GetEnableAsynchronousIO() << "\n";
+  os << indent << "EnableConcurrentLocalIO: " << this->GetEnableConcurrentLocalIO() << "\n";
+  os << indent << "NumberOfLocalIOThreads: " << this->GetNumberOfLocalIOThreads() << "\n";
 
 }
 
@@ -314,6 +330,286 @@ void vtkDataIOManager::SetEnableAsynchronousIO ( int val )
 }
 
 
+//----------------------------------------------------------------------------
+namespace
+{
+/// Keeps the warnings and errors of one job, so that they are displayed on
+/// the main thread once the worker threads are joined. Each job has its own
+/// collector, only used by the thread that runs the job.
+class vtkLocalIOMessageCollector : public vtkCommand
+{
+public:
+  static vtkLocalIOMessageCollector *New()
+    {
+    return new vtkLocalIOMessageCollector;
+    }
+  virtual void Execute(vtkObject* vtkNotUsed(caller), unsigned long eventId, void* callData)
+    {
+    const char* message = static_cast<const char*>(callData);
+    this->Messages.push_back(std::make_pair(eventId, std::string(message ? message : "")));
+    // other observers of the storage node must not be invoked from a worker thread
+    this->SetAbortFlag(1);
+    }
+  std::vector<std::pair<unsigned long, std::string> > Messages;
+};
+
+struct LocalIOJob
+{
+  vtkMRMLStorageNode* StorageNode;
+  vtkMRMLStorableNode* Node;
+  int Result;
+  /// Data decoded by vtkMRMLStorageNode::ReadDataInThread()
+  vtkSmartPointer<vtkObject> Data;
+  vtkSmartPointer<vtkLocalIOMessageCollector> Messages;
+};
+
+struct LocalIOJobList
+{
+  std::vector<LocalIOJob> Jobs;
+  bool Write;
+  vtkSimpleCriticalSection Lock;
+  size_t NextJob;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE LocalIOThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  LocalIOJobList *jobList = static_cast<LocalIOJobList*>(threadInfo->UserData);
+  size_t numberOfJobs = jobList->Jobs.size();
+  while (true)
+    {
+    jobList->Lock.Lock();
+    size_t jobIndex = jobList->NextJob++;
+    jobList->Lock.Unlock();
+    if (jobIndex >= numberOfJobs)
+      {
+      break;
+      }
+    LocalIOJob& job = jobList->Jobs[jobIndex];
+    if (jobList->Write)
+      {
+      job.Result = job.StorageNode->WriteDataInThread(job.Node, job.Messages);
+      }
+    else
+      {
+      job.Data = job.StorageNode->ReadDataInThread(job.Node, job.Messages);
+      job.Result = (job.Data.GetPointer() != NULL);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Run the jobs in worker threads. Must be called on the main thread, no
+/// event is invoked on the scene while the jobs run.
+void RunLocalIOJobs(LocalIOJobList& jobList, int numberOfThreads)
+{
+  if (jobList.Jobs.empty())
+    {
+    return;
+    }
+  jobList.NextJob = 0;
+  vtkNew<vtkMultiThreader> threader;
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = threader->GetNumberOfThreads();
+    }
+  numberOfThreads = std::max(1, std::min(numberOfThreads,
+                                         static_cast<int>(jobList.Jobs.size())));
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(LocalIOThread, &jobList);
+  // vtkErrorMacro and vtkWarningMacro invoke the observers of the object
+  // instead of displaying the message when there are any: the messages of
+  // each storage node (and of the readers and writers it creates) go to the
+  // collector of its job.
+  std::vector<unsigned long> errorTags(jobList.Jobs.size());
+  std::vector<unsigned long> warningTags(jobList.Jobs.size());
+  for (size_t i = 0; i < jobList.Jobs.size(); ++i)
+    {
+    LocalIOJob& job = jobList.Jobs[i];
+    job.Messages = vtkSmartPointer<vtkLocalIOMessageCollector>::New();
+    errorTags[i] = job.StorageNode->AddObserver(vtkCommand::ErrorEvent, job.Messages, 1000.0);
+    warningTags[i] = job.StorageNode->AddObserver(vtkCommand::WarningEvent, job.Messages, 1000.0);
+    }
+  threader->SingleMethodExecute();
+  for (size_t i = 0; i < jobList.Jobs.size(); ++i)
+    {
+    jobList.Jobs[i].StorageNode->RemoveObserver(errorTags[i]);
+    jobList.Jobs[i].StorageNode->RemoveObserver(warningTags[i]);
+    }
+}
+
+//----------------------------------------------------------------------------
+/// Display the messages collected while the job ran, on the main thread.
+void DisplayLocalIOJobMessages(LocalIOJob& job)
+{
+  // the messages are already formatted by vtkErrorMacro or vtkWarningMacro,
+  // they are dispatched the same way as the macros do
+  std::vector<std::pair<unsigned long, std::string> >::const_iterator it;
+  for (it = job.Messages->Messages.begin(); it != job.Messages->Messages.end(); ++it)
+    {
+    if (job.StorageNode->HasObserver(it->first))
+      {
+      job.StorageNode->InvokeEvent(it->first, const_cast<char*>(it->second.c_str()));
+      }
+    else if (it->first == vtkCommand::ErrorEvent)
+      {
+      vtkOutputWindowDisplayErrorText(it->second.c_str());
+      }
+    else
+      {
+      vtkOutputWindowDisplayWarningText(it->second.c_str());
+      }
+    }
+  job.Messages->Messages.clear();
+}
+
+//----------------------------------------------------------------------------
+bool IsLocalStorageNode(vtkMRMLStorageNode* storageNode)
+{
+  return storageNode->GetFileName() != NULL &&
+    (storageNode->GetURI() == NULL || strlen(storageNode->GetURI()) == 0);
+}
+}
+
+//----------------------------------------------------------------------------
+int vtkDataIOManager::PrefetchLocalData ( vtkCollection *nodes, vtkMRMLScene *scene )
+{
+  if (!this->EnableConcurrentLocalIO || nodes == NULL)
+    {
+    return 0;
+    }
+  if (scene && scene->GetReadDataOnLoad() == 0)
+    {
+    return 0;
+    }
+
+  LocalIOJobList jobList;
+  jobList.Write = false;
+  vtkMRMLNode *node = NULL;
+  vtkCollectionSimpleIterator it;
+  for (nodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(nodes->GetNextItemAsObject(it))) ;)
+    {
+    vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(node);
+    if (!storableNode || !storableNode->GetAddToScene())
+      {
+      continue;
+      }
+    for (int i = 0; i < storableNode->GetNumberOfStorageNodes(); ++i)
+      {
+      vtkMRMLStorageNode* storageNode = storableNode->GetNthStorageNode(i);
+      if (storageNode && storageNode->SupportsThreadedRead() &&
+          IsLocalStorageNode(storageNode))
+        {
+        LocalIOJob job = {storageNode, storableNode, 0, NULL, NULL};
+        jobList.Jobs.push_back(job);
+        }
+      }
+    }
+  // a single file gains nothing from a worker thread
+  if (jobList.Jobs.size() < 2)
+    {
+    return 0;
+    }
+
+  vtkDebugMacro("PrefetchLocalData: decoding " << jobList.Jobs.size() << " files");
+  RunLocalIOJobs(jobList, this->NumberOfLocalIOThreads);
+
+  // hand the decoded data over to the storage nodes, ReadData() sets it
+  // into the nodes
+  int numberOfPrefetchedNodes = 0;
+  size_t numberOfJobs = jobList.Jobs.size();
+  for (size_t i = 0; i < numberOfJobs; ++i)
+    {
+    LocalIOJob& job = jobList.Jobs[i];
+    if (job.Result)
+      {
+      job.StorageNode->SetPrefetchedData(job.Data);
+      // failed jobs are read again by ReadData(), which reports the errors
+      DisplayLocalIOJobMessages(job);
+      ++numberOfPrefetchedNodes;
+      }
+    if (scene)
+      {
+      scene->ProgressState(vtkMRMLScene::ImportState,
+                           static_cast<int>(100 * (i + 1) / numberOfJobs));
+      }
+    }
+  return numberOfPrefetchedNodes;
+}
+
+//----------------------------------------------------------------------------
+int vtkDataIOManager::WriteLocalData ( vtkCollection *nodes, vtkMRMLScene *scene )
+{
+  if (nodes == NULL)
+    {
+    return 1;
+    }
+
+  LocalIOJobList jobList;
+  jobList.Write = true;
+  std::vector<LocalIOJob> mainThreadJobs;
+  vtkMRMLNode *node = NULL;
+  vtkCollectionSimpleIterator it;
+  for (nodes->InitTraversal(it);
+       (node = vtkMRMLNode::SafeDownCast(nodes->GetNextItemAsObject(it))) ;)
+    {
+    vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(node);
+    vtkMRMLStorageNode* storageNode = storableNode ? storableNode->GetStorageNode() : NULL;
+    if (!storageNode)
+      {
+      continue;
+      }
+    LocalIOJob job = {storageNode, storableNode, 0, NULL, NULL};
+    if (this->EnableConcurrentLocalIO && storageNode->SupportsThreadedWrite())
+      {
+      jobList.Jobs.push_back(job);
+      }
+    else
+      {
+      mainThreadJobs.push_back(job);
+      }
+    }
+
+  RunLocalIOJobs(jobList, this->NumberOfLocalIOThreads);
+
+  int success = 1;
+  // stage the written files and update the storage nodes on the main thread
+  size_t numberOfJobs = jobList.Jobs.size();
+  for (size_t i = 0; i < numberOfJobs; ++i)
+    {
+    LocalIOJob& job = jobList.Jobs[i];
+    if (job.Result)
+      {
+      DisplayLocalIOJobMessages(job);
+      job.StorageNode->FinishThreadedWrite(job.Node, job.Result);
+      }
+    else
+      {
+      // write again on the main thread to report the error
+      mainThreadJobs.push_back(job);
+      }
+    if (scene)
+      {
+      scene->ProgressState(vtkMRMLScene::SaveState,
+                           static_cast<int>(100 * (i + 1) / numberOfJobs));
+      }
+    }
+  for (std::vector<LocalIOJob>::iterator jobIt = mainThreadJobs.begin();
+       jobIt != mainThreadJobs.end(); ++jobIt)
+    {
+    if (!jobIt->StorageNode->WriteData(jobIt->Node))
+      {
+      vtkErrorMacro("WriteLocalData: failed to write " << jobIt->Node->GetID());
+      success = 0;
+      }
+    }
+  return success;
+}
+
 //----------------------------------------------------------------------------
 void vtkDataIOManager::QueueRead ( vtkMRMLNode *node )
 {
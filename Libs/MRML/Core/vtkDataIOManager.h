@@ -7,6 +7,7 @@ class vtkCacheManager;
 class vtkDataFileFormatHelper;
 class vtkDataTransfer;
 class vtkMRMLNode;
+class vtkMRMLScene;
 
 // VTK includes
 #include <vtkObject.h>
@@ -40,6 +41,43 @@ class VTK_MRML_EXPORT vtkDataIOManager : public vtkObject
 
   void SetEnableAsynchronousIO ( int );
 
+  ///
+  /// Read and write the files of local storage nodes concurrently in
+  /// worker threads (on by default). Only storage nodes supporting
+  /// threaded I/O are scheduled, the others are handled on the main thread.
+  /// \sa vtkMRMLStorageNode::SupportsThreadedRead(), PrefetchLocalData(),
+  /// WriteLocalData()
+  vtkGetMacro ( EnableConcurrentLocalIO, int );
+  vtkSetMacro ( EnableConcurrentLocalIO, int );
+  vtkBooleanMacro ( EnableConcurrentLocalIO, int );
+
+  ///
+  /// Number of worker threads for local I/O.
+  /// 0 (default) uses vtkMultiThreader's default number of threads.
+  vtkGetMacro ( NumberOfLocalIOThreads, int );
+  vtkSetClampMacro ( NumberOfLocalIOThreads, int, 0, VTK_INT_MAX );
+
+  ///
+  /// Decode the local files of the storable nodes in \a nodes concurrently.
+  /// Nothing is set into the nodes: once the worker threads are joined, the
+  /// decoded data is handed to the storage nodes and set into the storable
+  /// nodes by the following vtkMRMLStorageNode::ReadData() calls (e.g. from
+  /// vtkMRMLStorableNode::UpdateScene()). Progress is reported on \a scene
+  /// with vtkMRMLScene::ProgressState(vtkMRMLScene::ImportState) after the
+  /// join, the warnings of the decoded files are displayed then too.
+  /// Must be called from the main thread.
+  /// Return the number of storage nodes whose data was decoded.
+  int PrefetchLocalData ( vtkCollection *nodes, vtkMRMLScene *scene );
+
+  ///
+  /// Write the data of the storable nodes in \a nodes with their (first)
+  /// storage node. Storage nodes supporting threaded writes are written
+  /// concurrently, the others on the main thread. Progress is reported on
+  /// \a scene with vtkMRMLScene::ProgressState(vtkMRMLScene::SaveState).
+  /// Must be called from the main thread.
+  /// Return 1 if all the nodes were successfully written, 0 otherwise.
+  int WriteLocalData ( vtkCollection *nodes, vtkMRMLScene *scene );
+
   ///
   /// Creates and adds a new data transfer object to the collection
   vtkDataTransfer *AddNewDataTransfer ( );
@@ -112,6 +150,8 @@ class VTK_MRML_EXPORT vtkDataIOManager : public vtkObject
   vtkCollection *DataTransferCollection;
   vtkCacheManager *CacheManager;
   int EnableAsynchronousIO;
+  int EnableConcurrentLocalIO;
+  int NumberOfLocalIOThreads;
 
   vtkDataFileFormatHelper* FileFormatHelper;
 
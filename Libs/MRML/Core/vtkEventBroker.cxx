@@ -22,8 +22,152 @@
 #include <vtkObjectFactory.h>
 #include <vtkTimerLog.h>
 
+// STD includes
+#include <algorithm>
+#include <sstream>
+#include <string>
+
 vtkCxxSetObjectMacro(vtkEventBroker, TimerLog, vtkTimerLog);
 
+//----------------------------------------------------------------------------
+class vtkEventBroker::vtkInternal
+{
+public:
+  vtkInternal();
+
+  /// Durations are binned in powers of 2 microseconds: bin 0 is below 1us,
+  /// bin i is [2^(i-1), 2^i) us and the last bin is everything above.
+  enum { NumberOfHistogramBins = 24 };
+
+  /// The class names are the static strings returned by GetClassName(),
+  /// comparing their pointers is enough while recording.
+  struct ProfileKey
+    {
+    const char* SubjectClassName;
+    unsigned long EventId;
+    const char* ObserverClassName;
+    bool operator<(const ProfileKey& other)const
+      {
+      if (this->SubjectClassName != other.SubjectClassName)
+        {
+        return this->SubjectClassName < other.SubjectClassName;
+        }
+      if (this->EventId != other.EventId)
+        {
+        return this->EventId < other.EventId;
+        }
+      return this->ObserverClassName < other.ObserverClassName;
+      }
+    };
+
+  struct ProfileStatistics
+    {
+    ProfileStatistics();
+    void Add(double elapsedTime, double selfTime);
+    void Merge(const ProfileStatistics& other);
+    /// Upper bound in seconds of the duration below which \a fraction of
+    /// the invocations are
+    double GetPercentile(double fraction)const;
+
+    unsigned long Count;
+    double InclusiveTime;
+    double SelfTime;
+    double MaximumTime;
+    unsigned long Histogram[NumberOfHistogramBins];
+    };
+
+  struct TraceEvent
+    {
+    const char* SubjectClassName;
+    unsigned long EventId;
+    const char* ObserverClassName;
+    double StartTime;
+    double Duration;
+    };
+
+  typedef std::map<ProfileKey, ProfileStatistics> StatisticsMap;
+  StatisticsMap Statistics;
+  std::vector<TraceEvent> Trace;
+  /// Time spent in the nested invocations, one entry per nesting level
+  std::vector<double> ChildrenTime;
+
+  static std::string GetEventName(unsigned long eid);
+};
+
+//----------------------------------------------------------------------------
+vtkEventBroker::vtkInternal::vtkInternal()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkEventBroker::vtkInternal::ProfileStatistics::ProfileStatistics()
+  : Count(0)
+  , InclusiveTime(0.)
+  , SelfTime(0.)
+  , MaximumTime(0.)
+{
+  std::fill(this->Histogram, this->Histogram + NumberOfHistogramBins, 0);
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::vtkInternal::ProfileStatistics::Add(double elapsedTime, double selfTime)
+{
+  ++this->Count;
+  this->InclusiveTime += elapsedTime;
+  this->SelfTime += selfTime;
+  this->MaximumTime = std::max(this->MaximumTime, elapsedTime);
+  int bin = 0;
+  for (double bound = 1e-6; elapsedTime >= bound && bin < NumberOfHistogramBins - 1; bound *= 2.)
+    {
+    ++bin;
+    }
+  ++this->Histogram[bin];
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::vtkInternal::ProfileStatistics::Merge(const ProfileStatistics& other)
+{
+  this->Count += other.Count;
+  this->InclusiveTime += other.InclusiveTime;
+  this->SelfTime += other.SelfTime;
+  this->MaximumTime = std::max(this->MaximumTime, other.MaximumTime);
+  for (int bin = 0; bin < NumberOfHistogramBins; ++bin)
+    {
+    this->Histogram[bin] += other.Histogram[bin];
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkEventBroker::vtkInternal::ProfileStatistics::GetPercentile(double fraction)const
+{
+  unsigned long count = 0;
+  double bound = 1e-6;
+  for (int bin = 0; bin < NumberOfHistogramBins - 1; ++bin, bound *= 2.)
+    {
+    count += this->Histogram[bin];
+    if (count >= fraction * this->Count)
+      {
+      return std::min(bound, this->MaximumTime);
+      }
+    }
+  return this->MaximumTime;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkEventBroker::vtkInternal::GetEventName(unsigned long eid)
+{
+  std::stringstream name;
+  if (eid < vtkCommand::UserEvent)
+    {
+    name << vtkCommand::GetStringFromEventId(eid);
+    }
+  else
+    {
+    name << eid;
+    }
+  return name.str();
+}
+
 //----------------------------------------------------------------------------
 // The IO manager singleton.
 // This MUST be default initialized to zero by the compiler and is
@@ -99,6 +243,13 @@ vtkEventBroker::vtkEventBroker()
   this->LogFileName = NULL;
   this->ScriptHandler = NULL;
   this->ScriptHandlerClientData = NULL;
+  this->CoalescedEventsPending = false;
+  this->NumberOfQueuedEvents = 0;
+  this->NumberOfDroppedEvents = 0;
+  this->Profiling = 0;
+  this->ProfilingTimeline = 0;
+  this->MaximumNumberOfTraceEvents = 100000;
+  this->Internal = new vtkInternal;
 }
 
 //----------------------------------------------------------------------------
@@ -118,6 +269,7 @@ vtkEventBroker::~vtkEventBroker()
     {
     this->TimerLog->Delete();
     }
+  delete this->Internal;
   //cout << "vtkEventBroker singleton Deleted" << endl;
 }
 
@@ -572,6 +724,110 @@ int vtkEventBroker::GenerateGraphFile ( const char *graphFile )
   return 0;
 }
 
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetProfiling ()
+{
+  this->Internal->Statistics.clear();
+  this->Internal->Trace.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::PrintProfilingReport ( ostream& os )
+{
+  // the same class may have several class name pointers (one per library
+  // the inlined GetClassName() is compiled in), merge them by name
+  typedef std::map<std::string, vtkInternal::ProfileStatistics> NamedStatisticsMap;
+  NamedStatisticsMap namedStatistics;
+  double totalSelfTime = 0.;
+  unsigned long totalCount = 0;
+  for (vtkInternal::StatisticsMap::const_iterator it = this->Internal->Statistics.begin();
+       it != this->Internal->Statistics.end(); ++it)
+    {
+    std::string name = std::string(it->first.SubjectClassName) + "\t" +
+      vtkInternal::GetEventName(it->first.EventId) + "\t" + it->first.ObserverClassName;
+    namedStatistics[name].Merge(it->second);
+    totalSelfTime += it->second.SelfTime;
+    totalCount += it->second.Count;
+    }
+
+  // sort by decreasing self time
+  std::vector<std::pair<double, std::string> > sorted;
+  for (NamedStatisticsMap::const_iterator it = namedStatistics.begin();
+       it != namedStatistics.end(); ++it)
+    {
+    sorted.push_back(std::make_pair(-it->second.SelfTime, it->first));
+    }
+  std::sort(sorted.begin(), sorted.end());
+
+  os << "# Event broker profile: " << totalCount << " invocations, "
+     << totalSelfTime * 1000. << " ms\n";
+  os << "# Count\tSelf(ms)\tInclusive(ms)\tMean(ms)\tMax(ms)\tP50(ms)\tP95(ms)"
+     << "\tSubject\tEvent\tObserver\n";
+  for (size_t i = 0; i < sorted.size(); ++i)
+    {
+    const vtkInternal::ProfileStatistics& statistics = namedStatistics[sorted[i].second];
+    os << statistics.Count
+       << "\t" << statistics.SelfTime * 1000.
+       << "\t" << statistics.InclusiveTime * 1000.
+       << "\t" << statistics.InclusiveTime * 1000. / statistics.Count
+       << "\t" << statistics.MaximumTime * 1000.
+       << "\t" << statistics.GetPercentile(0.5) * 1000.
+       << "\t" << statistics.GetPercentile(0.95) * 1000.
+       << "\t" << sorted[i].second << "\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::WriteProfilingReport ( const char *reportFile )
+{
+  std::ofstream file;
+  file.open( reportFile, std::ios::out );
+  if ( file.fail() )
+    {
+    vtkErrorMacro( "could not write to " << reportFile );
+    return 1;
+    }
+  this->PrintProfilingReport( file );
+  file.close();
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::WriteProfilingTrace ( const char *traceFile )
+{
+  std::ofstream file;
+  file.open( traceFile, std::ios::out );
+  if ( file.fail() )
+    {
+    vtkErrorMacro( "could not write to " << traceFile );
+    return 1;
+    }
+
+  // complete ("X") events, timestamps in microseconds
+  // (invocations are recorded when they end, nested ones come first)
+  double origin = VTK_DOUBLE_MAX;
+  for (size_t i = 0; i < this->Internal->Trace.size(); ++i)
+    {
+    origin = std::min(origin, this->Internal->Trace[i].StartTime);
+    }
+  file << "{\"traceEvents\":[\n";
+  for (size_t i = 0; i < this->Internal->Trace.size(); ++i)
+    {
+    const vtkInternal::TraceEvent& event = this->Internal->Trace[i];
+    std::string eventName = vtkInternal::GetEventName(event.EventId);
+    file << (i ? ",\n" : "")
+         << "{\"name\":\"" << event.ObserverClassName << " " << eventName << "\","
+         << "\"cat\":\"" << eventName << "\","
+         << "\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+         << "\"ts\":" << (event.StartTime - origin) * 1e6 << ","
+         << "\"dur\":" << event.Duration * 1e6 << ","
+         << "\"args\":{\"subject\":\"" << event.SubjectClassName << "\"}}";
+    }
+  file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  file.close();
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::OpenLogFile ()
 {
@@ -690,6 +946,17 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
       {
       this->QueueObservation( observation, eid, callData );
       }
+    else if ( this->EventMode == vtkEventBroker::FrameCoalesced )
+      {
+      if ( this->IsEventCoalesced( observation, eid ) )
+        {
+        this->CoalesceObservation( observation, eid );
+        }
+      else
+        {
+        this->InvokeObservation( observation, eid, callData );
+        }
+      }
     else
       {
       vtkErrorMacro ( "Bad EventMode " << this->EventMode );
@@ -719,11 +986,13 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
     if ( caller == observation->GetSubject() )
       {
       // Remove all observations for this subject (0 matches all tags)
+      this->RemoveSubjectEventCoalescing (observation->GetSubject());
       this->RemoveObservationsForSubjectByTag (observation->GetSubject(), 0);
       }
     else if ( caller == observation->GetObserver() )
       {
       // Remove all observations for this observer
+      this->RemoveObserverEventCoalescing (observation->GetObserver());
       this->RemoveObservations (observation->GetObserver());
       }
     else
@@ -773,7 +1042,12 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
       {
       observation->GetCallDataList()->push_back( call );
       }
+    else
+      {
+      ++this->NumberOfDroppedEvents;
+      }
     }
+  ++this->NumberOfQueuedEvents;
 
   if ( !observation->GetInEventQueue() )
     {
@@ -813,6 +1087,18 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
 {
   this->EventNestingLevel++;
 
+  // the subject or observer may be deleted by the callback
+  bool profiling = (this->Profiling != 0);
+  const char* subjectClassName = 0;
+  const char* observerClassName = 0;
+  if (profiling)
+    {
+    subjectClassName = observation->GetSubject()->GetClassName();
+    observerClassName = observation->GetScript() ? "(script)" :
+      (observation->GetObserver() ? observation->GetObserver()->GetClassName() : "(none)");
+    this->Internal->ChildrenTime.push_back(0.);
+    }
+
   double startTime = this->TimerLog->GetUniversalTime();
 
   // Register so observation won't be deleted while callback is running
@@ -844,6 +1130,25 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
   observation->SetLastElapsedTime (elapsedTime);
   this->LogEvent (observation);
 
+  if (profiling)
+    {
+    double childrenTime = this->Internal->ChildrenTime.back();
+    this->Internal->ChildrenTime.pop_back();
+    if (!this->Internal->ChildrenTime.empty())
+      {
+      this->Internal->ChildrenTime.back() += elapsedTime;
+      }
+    vtkInternal::ProfileKey key = { subjectClassName, eid, observerClassName };
+    this->Internal->Statistics[key].Add(elapsedTime, elapsedTime - childrenTime);
+    if (this->ProfilingTimeline &&
+        static_cast<int>(this->Internal->Trace.size()) < this->MaximumNumberOfTraceEvents)
+      {
+      vtkInternal::TraceEvent traceEvent =
+        { subjectClassName, eid, observerClassName, startTime, elapsedTime };
+      this->Internal->Trace.push_back(traceEvent);
+      }
+    }
+
   // clear reference to observation (may cause delete)
   observation->Delete();
   this->EventNestingLevel--;
@@ -881,6 +1186,172 @@ void vtkEventBroker::ProcessEventQueue ()
     this->DequeueObservation();
     observation->Delete();
     }
+  this->CoalescedEventsPending = false;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::SetObservationEventCoalescing ( vtkObject *subject,
+                                                     vtkObject *observer,
+                                                     unsigned long event,
+                                                     bool coalesce )
+{
+  if ( subject == NULL || observer == NULL || event == vtkCommand::DeleteEvent )
+    {
+    return;
+    }
+  SubjectObserverPair key( subject, observer );
+  if ( coalesce )
+    {
+    this->CoalescedObservationEvents[key].insert( event );
+    return;
+    }
+  ObservationToEventsMap::iterator it = this->CoalescedObservationEvents.find( key );
+  if ( it == this->CoalescedObservationEvents.end() )
+    {
+    return;
+    }
+  it->second.erase( event );
+  if ( it->second.empty() )
+    {
+    this->CoalescedObservationEvents.erase( it );
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkEventBroker::GetObservationEventCoalescing ( vtkObject *subject,
+                                                     vtkObject *observer,
+                                                     unsigned long event )
+{
+  ObservationToEventsMap::const_iterator it =
+    this->CoalescedObservationEvents.find( SubjectObserverPair( subject, observer ) );
+  return it != this->CoalescedObservationEvents.end() &&
+    it->second.find( event ) != it->second.end();
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::RemoveObserverEventCoalescing ( vtkObject *observer )
+{
+  ObservationToEventsMap::iterator it = this->CoalescedObservationEvents.begin();
+  while ( it != this->CoalescedObservationEvents.end() )
+    {
+    if ( it->first.second == observer )
+      {
+      this->CoalescedObservationEvents.erase( it++ );
+      }
+    else
+      {
+      ++it;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::RemoveSubjectEventCoalescing ( vtkObject *subject )
+{
+  ObservationToEventsMap::iterator it = this->CoalescedObservationEvents.begin();
+  while ( it != this->CoalescedObservationEvents.end() )
+    {
+    if ( it->first.first == subject )
+      {
+      this->CoalescedObservationEvents.erase( it++ );
+      }
+    else
+      {
+      ++it;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkEventBroker::IsEventCoalesced ( vtkObservation *observation,
+                                        unsigned long eid )
+{
+  if ( this->CoalescedObservationEvents.empty() ||
+       observation->GetScript() != NULL ||
+       eid == vtkCommand::DeleteEvent )
+    {
+    return false;
+    }
+  return this->GetObservationEventCoalescing(
+    observation->GetSubject(), observation->GetObserver(), eid );
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::CoalesceObservation ( vtkObservation *observation,
+                                           unsigned long eid )
+{
+  ++this->NumberOfQueuedEvents;
+  //
+  // merge the event with the same event of the same subject already in the
+  // queue. The call data is not kept: it is usually a pointer to a
+  // temporary variable of the subject that is not valid anymore when the
+  // event is processed.
+  //
+  std::deque< vtkObservation::CallType > *callDataList = observation->GetCallDataList();
+  std::deque< vtkObservation::CallType >::const_iterator dataIter;
+  for (dataIter = callDataList->begin(); dataIter != callDataList->end(); ++dataIter)
+    {
+    if ( dataIter->EventID == eid )
+      {
+      break;
+      }
+    }
+  if ( dataIter != callDataList->end() )
+    {
+    ++this->NumberOfDroppedEvents;
+    }
+  else
+    {
+    callDataList->push_back( vtkObservation::CallType(eid, NULL) );
+    }
+
+  if ( !observation->GetInEventQueue() )
+    {
+    this->EventQueue.push_back( observation );
+    observation->SetInEventQueue(1);
+    }
+
+  if ( !this->CoalescedEventsPending )
+    {
+    // ask for a flush at the next frame
+    this->CoalescedEventsPending = true;
+    this->InvokeEvent( vtkEventBroker::CoalescedEventsPendingEvent );
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ProcessCoalescedEvents ()
+{
+  this->CoalescedEventsPending = false;
+  //
+  // only process the observations that are in the queue now, the events
+  // coalesced by their observers are for the next frame.
+  // - each observation is dequeued before being invoked so that the events
+  //   it triggers are queued again
+  // - stop invoking an observation as soon as it has been removed
+  //
+  size_t numberOfObservations = this->EventQueue.size();
+  for (size_t i = 0; i < numberOfObservations && !this->EventQueue.empty(); ++i)
+    {
+    vtkObservation *observation = this->DequeueObservation();
+    observation->Register( this );
+    std::deque< vtkObservation::CallType > calls;
+    calls.swap( *observation->GetCallDataList() );
+    for (std::deque< vtkObservation::CallType >::const_iterator callIter = calls.begin();
+         callIter != calls.end() && observation->GetEventTag() != 0;
+         ++callIter)
+      {
+      this->InvokeObservation( observation, callIter->EventID, callIter->CallData );
+      }
+    observation->Delete();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetEventCounters ()
+{
+  this->NumberOfQueuedEvents = 0;
+  this->NumberOfDroppedEvents = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -891,6 +1362,12 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "NumberOfObservations: " << this->GetNumberOfObservations() << "\n";
   os << indent << "NumberOfQueueObservations: " << this->GetNumberOfQueuedObservations() << "\n";
   os << indent << "EventMode: " << this->GetEventModeAsString() << "\n";
+  os << indent << "NumberOfCoalescedObservations: " << this->CoalescedObservationEvents.size() << "\n";
+  os << indent << "NumberOfQueuedEvents: " << this->NumberOfQueuedEvents << "\n";
+  os << indent << "NumberOfDroppedEvents: " << this->NumberOfDroppedEvents << "\n";
+  os << indent << "Profiling: " << this->Profiling << "\n";
+  os << indent << "ProfilingTimeline: " << this->ProfilingTimeline << "\n";
+  os << indent << "MaximumNumberOfTraceEvents: " << this->MaximumNumberOfTraceEvents << "\n";
   os << indent << "EventLogging: " << this->EventLogging << "\n";
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
   os << indent << "LogFileName: " <<
@@ -19,6 +19,7 @@
 #include "vtkMRML.h"
 
 // VTK includes
+#include <vtkCommand.h>
 #include <vtkObject.h>
 class vtkTimerLog;
 
@@ -173,15 +174,70 @@ public:
   /// Write out the current list of observations in graphviz format (.dot)
   int GenerateGraphFile ( const char *graphFile );
 
+  /// Profiling
+  ///
+  /// When Profiling is on, the wall time of each invocation is accumulated
+  /// per (subject class, event id, observer class) along with a histogram of
+  /// the durations. The inclusive time contains the nested invocations, the
+  /// self time does not.
+  /// Off by default.
+  vtkBooleanMacro (Profiling, int);
+  vtkSetMacro (Profiling, int);
+  vtkGetMacro (Profiling, int);
+
+  ///
+  /// When ProfilingTimeline is on (and Profiling is on), each invocation is
+  /// also recorded for WriteProfilingTrace(), up to
+  /// MaximumNumberOfTraceEvents invocations.
+  /// Off by default.
+  vtkBooleanMacro (ProfilingTimeline, int);
+  vtkSetMacro (ProfilingTimeline, int);
+  vtkGetMacro (ProfilingTimeline, int);
+  vtkSetMacro (MaximumNumberOfTraceEvents, int);
+  vtkGetMacro (MaximumNumberOfTraceEvents, int);
+
+  ///
+  /// Forget all the profiling measurements
+  void ResetProfiling();
+
+  ///
+  /// Write the profiling measurements sorted by decreasing self time.
+  /// Each line has the number of invocations, the self and inclusive times,
+  /// the mean and maximum inclusive times, the median and 95th percentile
+  /// estimated from the histogram.
+  void PrintProfilingReport(ostream& os);
+  /// Returns 0 on success, 1 if the file can't be written
+  int WriteProfilingReport(const char *reportFile);
+
+  ///
+  /// Write the recorded invocations in the Chrome trace event format
+  /// (chrome://tracing, Perfetto). Returns 0 on success, 1 if the file can't
+  /// be written.
+  int WriteProfilingTrace(const char *traceFile);
+
 
   /// Event Queue processing modes
   ///
   /// In synchronous mode, observations are invoked immediately when the
   /// event takes place.  In asynchronous mode, observations are added
   /// to the event queue for later invocation.
+  /// In frame coalesced mode, the events of the observations opted in with
+  /// SetObservationEventCoalescing() are added to the event queue and merged
+  /// per subject and event until the next call to ProcessCoalescedEvents()
+  /// (typically once per rendered frame), all the other events are invoked
+  /// immediately. The default mode is synchronous, the frame coalesced mode
+  /// must be explicitly set by the application.
   enum EventMode {
     Synchronous,
-    Asynchronous
+    Asynchronous,
+    FrameCoalesced
+  };
+
+  enum Events {
+    /// Invoked by the broker when a first event is coalesced after
+    /// ProcessCoalescedEvents() has been called. The application should
+    /// schedule a call to ProcessCoalescedEvents() for the next frame.
+    CoalescedEventsPendingEvent = vtkCommand::UserEvent + 1
   };
   vtkGetMacro(EventMode, int);
   void SetEventMode(int eventMode)
@@ -196,12 +252,44 @@ public:
 
   void SetEventModeToSynchronous() {this->SetEventMode(vtkEventBroker::Synchronous);};
   void SetEventModeToAsynchronous() {this->SetEventMode(vtkEventBroker::Asynchronous);};
+  void SetEventModeToFrameCoalesced() {this->SetEventMode(vtkEventBroker::FrameCoalesced);};
   const char * GetEventModeAsString() {
     if (this->EventMode == vtkEventBroker::Synchronous) return ("Synchronous");
     if (this->EventMode == vtkEventBroker::Asynchronous) return ("Asynchronous");
+    if (this->EventMode == vtkEventBroker::FrameCoalesced) return ("FrameCoalesced");
     return "Undefined";
   }
 
+  /// Frame coalescing
+  ///
+  /// Opt in (or out) the events \a event an observer receives from a
+  /// subject for being coalesced in FrameCoalesced mode. The events of the
+  /// other subjects of the observer are not coalesced. Coalesced events are
+  /// invoked once per subject and event id with a NULL call data, the same
+  /// way vtkMRMLNode::EndModify() invokes the pending modified events.
+  /// DeleteEvent is never coalesced.
+  void SetObservationEventCoalescing(vtkObject *subject, vtkObject *observer,
+                                     unsigned long event, bool coalesce);
+  bool GetObservationEventCoalescing(vtkObject *subject, vtkObject *observer,
+                                     unsigned long event);
+  /// Opt out all the events of the observer, for all its subjects
+  void RemoveObserverEventCoalescing(vtkObject *observer);
+  /// Opt out all the events of the subject, for all its observers
+  void RemoveSubjectEventCoalescing(vtkObject *subject);
+
+  ///
+  /// Invoke the coalesced events that have been queued before the call.
+  /// Events coalesced while processing are kept for the next call.
+  void ProcessCoalescedEvents();
+
+  ///
+  /// Event counters: number of events added to the event queue and number
+  /// of events that were dropped because they were merged with an event
+  /// already in the queue.
+  vtkGetMacro(NumberOfQueuedEvents, unsigned long);
+  vtkGetMacro(NumberOfDroppedEvents, unsigned long);
+  void ResetEventCounters();
+
 
   /// Event queue processing
 
@@ -286,6 +374,30 @@ protected:
   int EventMode;
   int CompressCallData;
 
+  /// Return true if the event of the observation must be coalesced
+  bool IsEventCoalesced(vtkObservation *observation, unsigned long eid);
+  /// Add the observation to the event queue, merging it with the same
+  /// event already in the queue
+  void CoalesceObservation(vtkObservation *observation, unsigned long eid);
+
+  typedef std::pair< vtkObject*, vtkObject* > SubjectObserverPair;
+  typedef std::map< SubjectObserverPair, std::set<unsigned long> > ObservationToEventsMap;
+  /// Events opted in for coalescing, per (subject, observer)
+  ObservationToEventsMap CoalescedObservationEvents;
+  /// True when CoalescedEventsPendingEvent has been invoked and
+  /// ProcessCoalescedEvents() not called yet
+  bool CoalescedEventsPending;
+
+  unsigned long NumberOfQueuedEvents;
+  unsigned long NumberOfDroppedEvents;
+
+  int Profiling;
+  int ProfilingTimeline;
+  int MaximumNumberOfTraceEvents;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
   std::ofstream LogFile;
 private:
   /// DetachObservations is a fast (but dangerous) method to delete all the
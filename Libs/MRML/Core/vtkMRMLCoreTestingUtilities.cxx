@@ -22,6 +22,15 @@
 #include "vtkMRMLCoreTestingUtilities.h"
 #include "vtkMRMLNode.h"
 #include "vtkMRMLScene.h"
+#include "vtkOrientedBSplineTransform.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
 
 namespace vtkMRMLCoreTestingUtilities
 {
@@ -188,4 +197,32 @@ bool CheckNodeIdAndName(int line, vtkMRMLNode* node,
   return true;
 }
 
+//----------------------------------------------------------------------------
+void CreateBSplineTransform(vtkOrientedBSplineTransform* bsplineTransform)
+{
+  const int size = 10;
+  vtkNew<vtkImageData> coefficients;
+  coefficients->SetDimensions(size, size, size);
+  coefficients->SetOrigin(-90., -90., -90.);
+  coefficients->SetSpacing(20., 20., 20.);
+  coefficients->AllocateScalars(VTK_DOUBLE, 3);
+  double* coefficient = static_cast<double*>(coefficients->GetScalarPointer());
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        *(coefficient++) = 3. * sin(i * 0.7 + j * 0.3);
+        *(coefficient++) = 2. * cos(j * 0.5 - k * 0.4);
+        *(coefficient++) = 2.5 * sin(k * 0.6 + i * 0.2);
+        }
+      }
+    }
+  vtkNew<vtkMatrix4x4> gridDirection;
+  bsplineTransform->SetGridDirectionMatrix(gridDirection.GetPointer());
+  bsplineTransform->SetCoefficientData(coefficients.GetPointer());
+  bsplineTransform->SetBorderModeToZero();
+}
+
 }
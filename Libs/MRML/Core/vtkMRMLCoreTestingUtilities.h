@@ -25,6 +25,7 @@
 #include <vtkMRML.h>
 class vtkMRMLNode;
 class vtkMRMLScene;
+class vtkOrientedBSplineTransform;
 
 // STD includes
 #include <sstream>
@@ -73,6 +74,11 @@ VTK_MRML_EXPORT
 bool CheckNodeIdAndName(int line, vtkMRMLNode* node,
                         const char* expectedID, const char* expectedName);
 
+/// Set up a smooth b-spline deformation of a few mm around the origin,
+/// for testing non-linear transforms
+VTK_MRML_EXPORT
+void CreateBSplineTransform(vtkOrientedBSplineTransform* bsplineTransform);
+
 template<typename Type>
 std::string ToString(Type value);
 
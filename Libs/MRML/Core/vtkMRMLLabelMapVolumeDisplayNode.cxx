@@ -76,6 +76,13 @@ void vtkMRMLLabelMapVolumeDisplayNode::SetInputImageDataConnection(vtkAlgorithmO
   this->MapToColors->SetInputConnection(imageDataConnection);
 }
 
+//---------------------------------------------------------------------------
+vtkAlgorithmOutput* vtkMRMLLabelMapVolumeDisplayNode::GetInputImageDataConnection()
+{
+  return this->MapToColors->GetNumberOfInputConnections(0) ?
+    this->MapToColors->GetInputConnection(0,0) : 0;
+}
+
 //---------------------------------------------------------------------------
 vtkImageData* vtkMRMLLabelMapVolumeDisplayNode::GetInputImageData()
 {
@@ -96,6 +103,12 @@ vtkAlgorithmOutput* vtkMRMLLabelMapVolumeDisplayNode::GetOutputImageDataConnecti
   return this->MapToColors->GetOutputPort();
 }
 
+//---------------------------------------------------------------------------
+vtkScalarsToColors* vtkMRMLLabelMapVolumeDisplayNode::GetLookupTable()
+{
+  return this->MapToColors->GetLookupTable();
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLLabelMapVolumeDisplayNode::UpdateImageDataPipeline()
 {
@@ -19,6 +19,7 @@
 
 class vtkImageAlgorithm;
 class vtkImageMapToColors;
+class vtkScalarsToColors;
 
 /// \brief MRML node for representing a volume display attributes.
 ///
@@ -49,6 +50,7 @@ class VTK_MRML_EXPORT vtkMRMLLabelMapVolumeDisplayNode : public vtkMRMLVolumeDis
   virtual void SetInputImageDataConnection(vtkAlgorithmOutput *imageDataConnection);
 
   /// Get the pipeline input
+  virtual vtkAlgorithmOutput* GetInputImageDataConnection();
   virtual vtkImageData* GetInputImageData();
 
   /// Gets the pipeline output
@@ -56,6 +58,11 @@ class VTK_MRML_EXPORT vtkMRMLLabelMapVolumeDisplayNode : public vtkMRMLVolumeDis
 
   virtual void UpdateImageDataPipeline();
 
+  ///
+  /// Lookup table used to map the labels to colors, its range matches the
+  /// number of colors.
+  vtkScalarsToColors* GetLookupTable();
+
 protected:
   vtkMRMLLabelMapVolumeDisplayNode();
   virtual ~vtkMRMLLabelMapVolumeDisplayNode();
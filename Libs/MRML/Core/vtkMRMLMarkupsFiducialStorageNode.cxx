@@ -24,9 +24,215 @@
 
 #include "vtkObjectFactory.h"
 #include "vtkStringArray.h"
+#include "vtkType.h"
 #include <vtksys/SystemTools.hxx>
 
+#include <cstring>
+#include <fstream>
 #include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Start of the binary markups fiducial files
+const char MARKUPS_BINARY_MAGIC[8] = {'M', 'R', 'K', 'B', 'I', 'N', '\0', '\0'};
+const vtkTypeUInt32 MARKUPS_BINARY_VERSION = 1;
+/// Written as is, reads differently on a platform with another byte order
+const vtkTypeUInt32 MARKUPS_BINARY_BYTE_ORDER_MARK = 0x01020304;
+/// id, label, description, associated node id
+const vtkTypeUInt32 MARKUPS_BINARY_STRINGS_PER_MARKUP = 4;
+
+/// Bits of the flag of a markup
+enum
+{
+  MARKUPS_BINARY_VISIBLE = 1,
+  MARKUPS_BINARY_SELECTED = 2,
+  MARKUPS_BINARY_LOCKED = 4
+};
+
+//----------------------------------------------------------------------------
+/// Fixed size header of the binary markups fiducial files
+struct MarkupsBinaryHeader
+{
+  char Magic[8];
+  vtkTypeUInt32 Version;
+  vtkTypeUInt32 ByteOrderMark;
+  vtkTypeUInt32 CoordinateSystem;
+  vtkTypeUInt32 NumberOfStringsPerMarkup;
+  vtkTypeUInt64 NumberOfMarkups;
+  vtkTypeUInt64 StringTableSize;
+};
+
+//----------------------------------------------------------------------------
+/// Offsets of the sections from the start of the file
+struct MarkupsBinaryLayout
+{
+  vtkTypeUInt64 Positions;
+  vtkTypeUInt64 Orientations;
+  vtkTypeUInt64 Weights;
+  vtkTypeUInt64 Flags;
+  vtkTypeUInt64 StringOffsets;
+  vtkTypeUInt64 Strings;
+  vtkTypeUInt64 FileSize;
+};
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 AlignSectionOffset(vtkTypeUInt64 offset)
+{
+  return (offset + 7) & ~static_cast<vtkTypeUInt64>(7);
+}
+
+//----------------------------------------------------------------------------
+MarkupsBinaryLayout GetMarkupsBinaryLayout(vtkTypeUInt64 numberOfMarkups, vtkTypeUInt64 stringTableSize)
+{
+  MarkupsBinaryLayout layout;
+  layout.Positions = AlignSectionOffset(sizeof(MarkupsBinaryHeader));
+  layout.Orientations = AlignSectionOffset(layout.Positions + numberOfMarkups * 3 * sizeof(double));
+  layout.Weights = AlignSectionOffset(layout.Orientations + numberOfMarkups * 4 * sizeof(double));
+  layout.Flags = AlignSectionOffset(layout.Weights + numberOfMarkups * sizeof(float));
+  layout.StringOffsets = AlignSectionOffset(layout.Flags + numberOfMarkups);
+  layout.Strings = AlignSectionOffset(layout.StringOffsets
+    + (numberOfMarkups * MARKUPS_BINARY_STRINGS_PER_MARKUP + 1) * sizeof(vtkTypeUInt32));
+  layout.FileSize = layout.Strings + stringTableSize;
+  return layout;
+}
+
+//----------------------------------------------------------------------------
+/// Read-only content of a file. The file is memory-mapped, or read
+/// into a buffer if it cannot be mapped.
+class MarkupsFileContent
+{
+public:
+  MarkupsFileContent()
+    : Data(NULL)
+    , Size(0)
+    , Mapped(false)
+  {
+  }
+
+  ~MarkupsFileContent()
+  {
+    if (this->Mapped)
+      {
+#ifdef _WIN32
+      UnmapViewOfFile(this->Data);
+#else
+      munmap(const_cast<char*>(this->Data), this->Size);
+#endif
+      }
+  }
+
+  bool Open(const std::string& fileName)
+  {
+    if (this->Map(fileName))
+      {
+      this->Mapped = true;
+      return true;
+      }
+    std::ifstream fileStream(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!fileStream.is_open())
+      {
+      return false;
+      }
+    fileStream.seekg(0, std::ios::end);
+    std::streamoff fileSize = fileStream.tellg();
+    fileStream.seekg(0, std::ios::beg);
+    if (fileSize < 0)
+      {
+      return false;
+      }
+    this->Buffer.resize(static_cast<size_t>(fileSize));
+    if (fileSize > 0 && !fileStream.read(&this->Buffer[0], fileSize))
+      {
+      return false;
+      }
+    this->Data = this->Buffer.empty() ? NULL : &this->Buffer[0];
+    this->Size = this->Buffer.size();
+    return true;
+  }
+
+  const char* GetData() const { return this->Data; }
+  size_t GetSize() const { return this->Size; }
+
+private:
+  bool Map(const std::string& fileName)
+  {
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+      OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+      {
+      return false;
+      }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0
+      || static_cast<unsigned long long>(fileSize.QuadPart) > static_cast<size_t>(-1))
+      {
+      CloseHandle(fileHandle);
+      return false;
+      }
+    HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(fileHandle);
+    if (mappingHandle == NULL)
+      {
+      return false;
+      }
+    // the view keeps the mapping alive
+    void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mappingHandle);
+    if (view == NULL)
+      {
+      return false;
+      }
+    this->Data = static_cast<const char*>(view);
+    this->Size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+#else
+    int fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+      {
+      return false;
+      }
+    struct stat fileStatus;
+    if (fstat(fileDescriptor, &fileStatus) != 0 || fileStatus.st_size <= 0
+      || static_cast<unsigned long long>(fileStatus.st_size) > static_cast<size_t>(-1))
+      {
+      close(fileDescriptor);
+      return false;
+      }
+    size_t fileSize = static_cast<size_t>(fileStatus.st_size);
+    void* view = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    // the mapping stays valid after the file is closed
+    close(fileDescriptor);
+    if (view == MAP_FAILED)
+      {
+      return false;
+      }
+    madvise(view, fileSize, MADV_SEQUENTIAL);
+    this->Data = static_cast<const char*>(view);
+    this->Size = fileSize;
+    return true;
+#endif
+  }
+
+  const char* Data;
+  size_t Size;
+  bool Mapped;
+  std::vector<char> Buffer;
+};
+
+} // end of anonymous namespace
 
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsFiducialStorageNode);
@@ -123,6 +329,10 @@ int vtkMRMLMarkupsFiducialStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     {
     parseAsAnnotationFiducial = true;
     }
+  else if (ext.compare(".mrkb") == 0)
+    {
+    return this->ReadBinaryDataInternal(markupsNode, fullName);
+    }
 
   // open the file for reading input
   fstream fstr;
@@ -481,6 +691,12 @@ int vtkMRMLMarkupsFiducialStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  std::string ext = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+  if (ext.compare(".mrkb") == 0)
+    {
+    return this->WriteBinaryDataInternal(markupsNode, fullName);
+    }
+
   // open the file for writing
   fstream of;
 
@@ -562,17 +778,248 @@ int vtkMRMLMarkupsFiducialStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
 
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNode::ReadBinaryDataInternal(vtkMRMLMarkupsNode *markupsNode, const std::string& fullName)
+{
+  MarkupsFileContent content;
+  if (!content.Open(fullName))
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: unable to open markups file " << fullName.c_str());
+    return 0;
+    }
+  const char* data = content.GetData();
+  const vtkTypeUInt64 fileSize = content.GetSize();
+
+  // check the header
+  MarkupsBinaryHeader header;
+  if (fileSize < sizeof(MarkupsBinaryHeader))
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: file " << fullName.c_str() << " is too short for a binary markups file");
+    return 0;
+    }
+  memcpy(&header, data, sizeof(MarkupsBinaryHeader));
+  if (memcmp(header.Magic, MARKUPS_BINARY_MAGIC, sizeof(MARKUPS_BINARY_MAGIC)) != 0)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: file " << fullName.c_str() << " is not a binary markups file");
+    return 0;
+    }
+  if (header.ByteOrderMark != MARKUPS_BINARY_BYTE_ORDER_MARK)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: file " << fullName.c_str() << " was written on a platform with a different byte order");
+    return 0;
+    }
+  if (header.Version < 1 || header.Version > MARKUPS_BINARY_VERSION
+    || header.NumberOfStringsPerMarkup != MARKUPS_BINARY_STRINGS_PER_MARKUP)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: unsupported binary markups file version " << header.Version
+                  << " in file " << fullName.c_str());
+    return 0;
+    }
+  // RAS, LPS and IJK are the known coordinate systems
+  if (header.CoordinateSystem > static_cast<vtkTypeUInt32>(vtkMRMLMarkupsStorageNode::IJK))
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: unknown coordinate system " << header.CoordinateSystem
+                  << " in file " << fullName.c_str());
+    return 0;
+    }
+  // each markup takes more than a byte, this also guards the layout computation against overflows
+  if (header.NumberOfMarkups > fileSize || header.NumberOfMarkups > static_cast<vtkTypeUInt64>(VTK_INT_MAX)
+    || header.StringTableSize > fileSize)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: invalid header in file " << fullName.c_str());
+    return 0;
+    }
+  const MarkupsBinaryLayout layout = GetMarkupsBinaryLayout(header.NumberOfMarkups, header.StringTableSize);
+  if (layout.FileSize > fileSize)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: file " << fullName.c_str() << " is truncated, expected "
+                  << layout.FileSize << " bytes, got " << fileSize);
+    return 0;
+    }
+
+  const int numberOfMarkups = static_cast<int>(header.NumberOfMarkups);
+  const double* positions = reinterpret_cast<const double*>(data + layout.Positions);
+  const double* orientations = reinterpret_cast<const double*>(data + layout.Orientations);
+  const float* weights = reinterpret_cast<const float*>(data + layout.Weights);
+  const unsigned char* flags = reinterpret_cast<const unsigned char*>(data + layout.Flags);
+  const vtkTypeUInt32* stringOffsets = reinterpret_cast<const vtkTypeUInt32*>(data + layout.StringOffsets);
+  const char* strings = data + layout.Strings;
+
+  // the strings of the markups follow each other in the string table
+  const vtkTypeUInt64 numberOfStringOffsets = header.NumberOfMarkups * MARKUPS_BINARY_STRINGS_PER_MARKUP + 1;
+  if (stringOffsets[0] != 0 || stringOffsets[numberOfStringOffsets - 1] != header.StringTableSize)
+    {
+    vtkErrorMacro("ReadBinaryDataInternal: invalid string table in file " << fullName.c_str());
+    return 0;
+    }
+  for (vtkTypeUInt64 i = 1; i < numberOfStringOffsets; ++i)
+    {
+    if (stringOffsets[i] < stringOffsets[i - 1])
+      {
+      vtkErrorMacro("ReadBinaryDataInternal: invalid string table in file " << fullName.c_str());
+      return 0;
+      }
+    }
+
+  this->SetCoordinateSystem(static_cast<int>(header.CoordinateSystem));
+  // IJK not implemented yet, assume RAS
+  const bool lps = (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::LPS);
+
+  // fill in the markups in place, the events are invoked once at the end
+  int wasModifying = markupsNode->StartModify();
+  if (markupsNode->GetNumberOfMarkups() > 0)
+    {
+    // clear out the list
+    markupsNode->RemoveAllMarkups();
+    }
+  std::vector<Markup>& markups = markupsNode->Markups;
+  markups.resize(numberOfMarkups);
+  for (int i = 0; i < numberOfMarkups; ++i)
+    {
+    Markup& markup = markups[i];
+
+    const double* position = positions + 3 * i;
+    vtkVector3d point;
+    point.SetX(lps ? -position[0] : position[0]);
+    point.SetY(lps ? -position[1] : position[1]);
+    point.SetZ(position[2]);
+    markup.points.assign(1, point);
+
+    memcpy(markup.OrientationWXYZ, orientations + 4 * i, 4 * sizeof(double));
+    markup.Weight = weights[i];
+    markup.Visibility = (flags[i] & MARKUPS_BINARY_VISIBLE) != 0;
+    markup.Selected = (flags[i] & MARKUPS_BINARY_SELECTED) != 0;
+    markup.Locked = (flags[i] & MARKUPS_BINARY_LOCKED) != 0;
+
+    const vtkTypeUInt32* markupStringOffsets = stringOffsets + MARKUPS_BINARY_STRINGS_PER_MARKUP * i;
+    markup.ID.assign(strings + markupStringOffsets[0], markupStringOffsets[1] - markupStringOffsets[0]);
+    markup.Label.assign(strings + markupStringOffsets[1], markupStringOffsets[2] - markupStringOffsets[1]);
+    markup.Description.assign(strings + markupStringOffsets[2], markupStringOffsets[3] - markupStringOffsets[2]);
+    markup.AssociatedNodeID.assign(strings + markupStringOffsets[3], markupStringOffsets[4] - markupStringOffsets[3]);
+    }
+  markupsNode->MaximumNumberOfMarkups += numberOfMarkups;
+  for (int i = 0; i < numberOfMarkups; ++i)
+    {
+    if (markups[i].ID.empty())
+      {
+      markupsNode->ResetNthMarkupID(i);
+      }
+    }
+
+  markupsNode->Modified();
+  if (numberOfMarkups > 0)
+    {
+    markupsNode->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::MarkupAddedEvent);
+    }
+  markupsNode->EndModify(wasModifying);
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNode::WriteBinaryDataInternal(vtkMRMLMarkupsNode *markupsNode, const std::string& fullName)
+{
+  const std::vector<Markup>& markups = markupsNode->Markups;
+  const int numberOfMarkups = static_cast<int>(markups.size());
+
+  // the string table size determines where the sections end
+  vtkTypeUInt64 stringTableSize = 0;
+  for (int i = 0; i < numberOfMarkups; ++i)
+    {
+    stringTableSize += markups[i].ID.size() + markups[i].Label.size()
+      + markups[i].Description.size() + markups[i].AssociatedNodeID.size();
+    }
+  if (stringTableSize > VTK_TYPE_UINT32_MAX)
+    {
+    vtkErrorMacro("WriteBinaryDataInternal: the labels and descriptions of the markups are too long for a binary markups file");
+    return 0;
+    }
+
+  MarkupsBinaryHeader header;
+  memcpy(header.Magic, MARKUPS_BINARY_MAGIC, sizeof(MARKUPS_BINARY_MAGIC));
+  header.Version = MARKUPS_BINARY_VERSION;
+  header.ByteOrderMark = MARKUPS_BINARY_BYTE_ORDER_MARK;
+  header.CoordinateSystem = this->GetCoordinateSystem();
+  header.NumberOfStringsPerMarkup = MARKUPS_BINARY_STRINGS_PER_MARKUP;
+  header.NumberOfMarkups = numberOfMarkups;
+  header.StringTableSize = stringTableSize;
+
+  // assemble the whole file in memory, the padding between the sections is zero
+  const MarkupsBinaryLayout layout = GetMarkupsBinaryLayout(header.NumberOfMarkups, header.StringTableSize);
+  std::vector<char> content(static_cast<size_t>(layout.FileSize), 0);
+  char* data = &content[0];
+  memcpy(data, &header, sizeof(MarkupsBinaryHeader));
+  double* positions = reinterpret_cast<double*>(data + layout.Positions);
+  double* orientations = reinterpret_cast<double*>(data + layout.Orientations);
+  float* weights = reinterpret_cast<float*>(data + layout.Weights);
+  unsigned char* flags = reinterpret_cast<unsigned char*>(data + layout.Flags);
+  vtkTypeUInt32* stringOffsets = reinterpret_cast<vtkTypeUInt32*>(data + layout.StringOffsets);
+  char* strings = data + layout.Strings;
+
+  // IJK not implemented yet, use RAS
+  const bool lps = (this->GetCoordinateSystem() == vtkMRMLMarkupsFiducialStorageNode::LPS);
+  vtkTypeUInt32 stringOffset = 0;
+  for (int i = 0; i < numberOfMarkups; ++i)
+    {
+    const Markup& markup = markups[i];
+
+    // 1 point per markup for a fiducial
+    double* position = positions + 3 * i;
+    if (!markup.points.empty())
+      {
+      position[0] = lps ? -markup.points[0].GetX() : markup.points[0].GetX();
+      position[1] = lps ? -markup.points[0].GetY() : markup.points[0].GetY();
+      position[2] = markup.points[0].GetZ();
+      }
+
+    memcpy(orientations + 4 * i, markup.OrientationWXYZ, 4 * sizeof(double));
+    weights[i] = markup.Weight;
+    flags[i] = (markup.Visibility ? MARKUPS_BINARY_VISIBLE : 0)
+      | (markup.Selected ? MARKUPS_BINARY_SELECTED : 0)
+      | (markup.Locked ? MARKUPS_BINARY_LOCKED : 0);
+
+    const std::string* markupStrings[MARKUPS_BINARY_STRINGS_PER_MARKUP] =
+      { &markup.ID, &markup.Label, &markup.Description, &markup.AssociatedNodeID };
+    for (vtkTypeUInt32 stringIndex = 0; stringIndex < MARKUPS_BINARY_STRINGS_PER_MARKUP; ++stringIndex)
+      {
+      const std::string* markupString = markupStrings[stringIndex];
+      *(stringOffsets++) = stringOffset;
+      memcpy(strings + stringOffset, markupString->data(), markupString->size());
+      stringOffset += static_cast<vtkTypeUInt32>(markupString->size());
+      }
+    }
+  *stringOffsets = stringOffset;
+
+  std::ofstream of(fullName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!of.is_open())
+    {
+    vtkErrorMacro("WriteBinaryDataInternal: unable to open file " << fullName.c_str() << " for writing");
+    return 0;
+    }
+  of.write(data, static_cast<std::streamsize>(content.size()));
+  of.close();
+  if (of.fail())
+    {
+    vtkErrorMacro("WriteBinaryDataInternal: unable to write file " << fullName.c_str());
+    return 0;
+    }
+
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialStorageNode::InitializeSupportedReadFileTypes()
 {
   this->SupportedReadFileTypes->InsertNextValue("Markups Fiducial CSV (.fcsv)");
   this->SupportedReadFileTypes->InsertNextValue("Annotation Fiducial CSV (.acsv)");
+  this->SupportedReadFileTypes->InsertNextValue("Markups Fiducial Binary (.mrkb)");
 }
 
 //----------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialStorageNode::InitializeSupportedWriteFileTypes()
 {
   this->SupportedWriteFileTypes->InsertNextValue("Markups Fiducial CSV (.fcsv)");
+  this->SupportedWriteFileTypes->InsertNextValue("Markups Fiducial Binary (.mrkb)");
 }
 
 //----------------------------------------------------------------------------
@@ -21,6 +21,10 @@
 ///
 /// vtkMRMLMarkupsFiducialStorageNode nodes describe the markups storage
 /// node that allows to read/write fiducial point data from/to file.
+/// Markups are stored in CSV (.fcsv) files by default, which is the format
+/// to use for interchange. Large lists can be stored in the binary (.mrkb)
+/// format, that holds the positions and orientations in contiguous arrays and
+/// the flags, weights and strings in compact tables, and is memory-mapped for reading.
 
 #ifndef __vtkMRMLMarkupsFiducialStorageNode_h
 #define __vtkMRMLMarkupsFiducialStorageNode_h
@@ -31,6 +35,8 @@
 
 #include "vtkMRMLMarkupsStorageNode.h"
 
+class vtkMRMLMarkupsNode;
+
 /// \ingroup Slicer_QtModules_Markups
 class VTK_MRML_EXPORT vtkMRMLMarkupsFiducialStorageNode : public vtkMRMLMarkupsStorageNode
 {
@@ -84,6 +90,23 @@ protected:
   /// label can have spaces, everything up to next comma is used, no quotes
   /// necessary, same with the description
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
+
+  /// Read a binary markups fiducial file (.mrkb) and replace the markups of
+  /// the markups node by its content.
+  /// The file starts with a fixed size header (magic string, version, byte
+  /// order mark, coordinate system, number of markups, size of the string table)
+  /// followed by sections starting at multiples of 8 bytes:
+  /// x,y,z of each markup (double), ow,ox,oy,oz of each markup (double),
+  /// weight of each markup (float), vis/sel/lock bits of each markup (byte),
+  /// offsets of the id,label,desc,associatedNodeID strings of each markup in
+  /// the string table (4 * number of markups + 1 unsigned 32 bit integers)
+  /// and the characters of the string table.
+  /// The file is memory-mapped and the markups are filled in directly from the sections.
+  int ReadBinaryDataInternal(vtkMRMLMarkupsNode *markupsNode, const std::string& fullName);
+
+  /// Write the markups of the markups node to a binary markups fiducial file (.mrkb)
+  /// \sa ReadBinaryDataInternal
+  int WriteBinaryDataInternal(vtkMRMLMarkupsNode *markupsNode, const std::string& fullName);
 };
 
 #endif
@@ -79,6 +79,15 @@ void vtkMRMLModelNode::Copy(vtkMRMLNode *anode)
   this->EndModify(disabledModify);
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLModelNode::GetUndoDataObjects(std::vector<vtkDataObject*>& dataObjects)
+{
+  if (this->GetPolyData())
+    {
+    dataObjects.push_back(this->GetPolyData());
+    }
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLModelNode::ProcessMRMLEvents ( vtkObject *caller,
                                            unsigned long event,
@@ -72,6 +72,9 @@ public:
   /// Return the input poly data
   /// \sa SetAndObservePolyData()
   virtual vtkPolyData* GetPolyData();
+
+  /// The poly data is the bulk data of the model.
+  virtual void GetUndoDataObjects(std::vector<vtkDataObject*>& dataObjects);
   /// Set and observe poly data pipeline.
   /// It is propagated to the display nodes.
   /// \sa GetPolyDataConnection()
@@ -18,17 +18,21 @@
 #include "vtkMRMLScene.h"
 
 // VTK includes
+#include <vtkAlgorithm.h>
 #include <vtkBYUReader.h>
 #include <vtkCellArray.h>
+#include <vtkCommand.h>
 #include <vtkDataSetSurfaceFilter.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkOBJReader.h>
 #include <vtkPLYReader.h>
 #include <vtkPLYWriter.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataReader.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkSTLReader.h>
+#include <vtkSmartPointer.h>
 #include <vtkSTLWriter.h>
 #include <vtkStringArray.h>
 #include <vtksys/SystemTools.hxx>
@@ -127,10 +131,18 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
   vtkDebugMacro("ReadDataInternal: extension = " << extension.c_str());
 
+  // Use the data decoded by ReadDataInThread() if it is for the same file
+  vtkSmartPointer<vtkAlgorithm> prefetchedReader =
+    vtkAlgorithm::SafeDownCast(this->TakePrefetchedData());
+
   int result = 1;
   try
     {
-    if ( extension == std::string(".g") || extension == std::string(".byu") )
+    if (prefetchedReader.GetPointer())
+      {
+      modelNode->SetPolyDataConnection(prefetchedReader->GetOutputPort());
+      }
+    else if ( extension == std::string(".g") || extension == std::string(".byu") )
       {
       vtkNew<vtkBYUReader> reader;
       reader->SetGeometryFileName(fullName.c_str());
@@ -290,8 +302,118 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   return result;
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+/// Route the warnings and errors of a reader or writer used in a worker thread
+void ObserveMessages(vtkObject* object, vtkCommand* messageObserver)
+{
+  if (messageObserver)
+    {
+    object->AddObserver(vtkCommand::ErrorEvent, messageObserver);
+    object->AddObserver(vtkCommand::WarningEvent, messageObserver);
+    }
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkObject> vtkMRMLModelStorageNode::ReadDataInThread(
+  vtkMRMLNode *refNode, vtkCommand* messageObserver)
+{
+  if (refNode == NULL || !this->CanReadInReferenceNode(refNode))
+    {
+    return NULL;
+    }
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty() || !vtksys::SystemTools::FileExists(fullName.c_str()))
+    {
+    return NULL;
+    }
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+
+  vtkSmartPointer<vtkAlgorithm> reader;
+  if ( extension == std::string(".g") || extension == std::string(".byu") )
+    {
+    vtkSmartPointer<vtkBYUReader> byuReader = vtkSmartPointer<vtkBYUReader>::New();
+    byuReader->SetGeometryFileName(fullName.c_str());
+    reader = byuReader;
+    }
+  else if (extension == std::string(".vtk"))
+    {
+    vtkSmartPointer<vtkPolyDataReader> polyDataReader = vtkSmartPointer<vtkPolyDataReader>::New();
+    polyDataReader->SetFileName(fullName.c_str());
+    if (!polyDataReader->IsFilePolyData())
+      {
+      return NULL;
+      }
+    reader = polyDataReader;
+    }
+  else if (extension == std::string(".vtp"))
+    {
+    vtkSmartPointer<vtkXMLPolyDataReader> xmlReader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    xmlReader->SetFileName(fullName.c_str());
+    reader = xmlReader;
+    }
+  else if (extension == std::string(".stl"))
+    {
+    vtkSmartPointer<vtkSTLReader> stlReader = vtkSmartPointer<vtkSTLReader>::New();
+    stlReader->SetFileName(fullName.c_str());
+    reader = stlReader;
+    }
+  else if (extension == std::string(".ply"))
+    {
+    vtkSmartPointer<vtkPLYReader> plyReader = vtkSmartPointer<vtkPLYReader>::New();
+    plyReader->SetFileName(fullName.c_str());
+    reader = plyReader;
+    }
+  else if (extension == std::string(".obj"))
+    {
+    vtkSmartPointer<vtkOBJReader> objReader = vtkSmartPointer<vtkOBJReader>::New();
+    objReader->SetFileName(fullName.c_str());
+    reader = objReader;
+    }
+  else
+    {
+    // read on the main thread by ReadDataInternal()
+    return NULL;
+    }
+  ObserveMessages(reader, messageObserver);
+
+  try
+    {
+    reader->Update();
+    }
+  catch (...)
+    {
+    return NULL;
+    }
+  if (vtkPolyData::SafeDownCast(reader->GetOutputDataObject(0)) == NULL)
+    {
+    return NULL;
+    }
+  // the reader may execute again on the main thread
+  reader->RemoveObserver(messageObserver);
+  return reader;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
+{
+  return this->WriteModel(refNode, NULL);
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::WriteDataInThread(vtkMRMLNode *refNode, vtkCommand* messageObserver)
+{
+  if (refNode == NULL || !this->CanWriteFromReferenceNode(refNode))
+    {
+    return 0;
+    }
+  return this->WriteModel(refNode, messageObserver);
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLModelStorageNode::WriteModel(vtkMRMLNode *refNode, vtkCommand* messageObserver)
 {
   vtkMRMLModelNode *modelNode = vtkMRMLModelNode::SafeDownCast(refNode);
 
@@ -311,6 +433,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     writer->SetFileName(fullName.c_str());
     writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
     writer->SetInputConnection( modelNode->GetPolyDataConnection() );
+    ObserveMessages(writer.GetPointer(), messageObserver);
     try
       {
       writer->Write();
@@ -329,6 +452,7 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     writer->SetDataMode(
       this->GetUseCompression() ? vtkXMLWriter::Appended : vtkXMLWriter::Ascii);
     writer->SetInputConnection( modelNode->GetPolyDataConnection() );
+    ObserveMessages(writer.GetPointer(), messageObserver);
     try
       {
       writer->Write();
@@ -346,6 +470,8 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
     triangulator->SetInputConnection( modelNode->GetPolyDataConnection() );
     writer->SetInputConnection( triangulator->GetOutputPort() );
+    ObserveMessages(triangulator.GetPointer(), messageObserver);
+    ObserveMessages(writer.GetPointer(), messageObserver);
     try
       {
       writer->Write();
@@ -363,6 +489,8 @@ int vtkMRMLModelStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     writer->SetFileType(this->GetUseCompression() ? VTK_BINARY : VTK_ASCII );
     triangulator->SetInputConnection( modelNode->GetPolyDataConnection() );
     writer->SetInputConnection( triangulator->GetOutputPort() );
+    ObserveMessages(triangulator.GetPointer(), messageObserver);
+    ObserveMessages(writer.GetPointer(), messageObserver);
     try
       {
       writer->Write();
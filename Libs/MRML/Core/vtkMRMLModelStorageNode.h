@@ -39,6 +39,15 @@ public:
   /// Return true if the reference node can be read in
   virtual bool CanReadInReferenceNode(vtkMRMLNode *refNode);
 
+  ///
+  /// Models can be decoded and written in worker threads.
+  /// ITK meta meshes and unstructured grids are always read on the main thread.
+  virtual bool SupportsThreadedRead() { return true; }
+  virtual vtkSmartPointer<vtkObject> ReadDataInThread(vtkMRMLNode* refNode,
+                                                      vtkCommand* messageObserver);
+  virtual bool SupportsThreadedWrite() { return true; }
+  virtual int WriteDataInThread(vtkMRMLNode* refNode, vtkCommand* messageObserver);
+
 protected:
   vtkMRMLModelStorageNode();
   ~vtkMRMLModelStorageNode();
@@ -57,6 +66,9 @@ protected:
   /// Write data from a  referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
+  /// Write the model with writers reporting their messages to
+  /// messageObserver (if not NULL).
+  int WriteModel(vtkMRMLNode *refNode, vtkCommand* messageObserver);
 };
 
 #endif
@@ -148,18 +148,6 @@ int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  vtkNew<vtkNRRDReader> reader;
-
-  // Set Reader member variables
-  if (this->CenterImage)
-    {
-    reader->SetUseNativeOriginOff();
-    }
-  else
-    {
-    reader->SetUseNativeOriginOn();
-    }
-
   if (volNode->GetImageData())
     {
     volNode->SetAndObserveImageData (NULL);
@@ -173,63 +161,12 @@ int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  reader->SetFileName(fullName.c_str());
-
-  // Check if this is a NRRD file that we can read
-  if (!reader->CanReadFile(fullName.c_str()))
+  vtkNew<vtkNRRDReader> reader;
+  if (!this->ExecuteReader(refNode, reader.GetPointer(), fullName))
     {
-    vtkErrorMacro("ReadData: This is not a nrrd file");
     return 0;
     }
 
-  // Read the header to see if the NRRD file corresponds to the
-  // MRML Node
-  reader->UpdateInformation();
-
-  // Check type
-  if ( refNode->IsA("vtkMRMLDiffusionTensorVolumeNode") )
-    {
-    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::TENSORS))
-      {
-      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }
-  else if ( refNode->IsA("vtkMRMLDiffusionWeightedVolumeNode"))
-    {
-    vtkDebugMacro("ReadData: Checking we have right info in file");
-    const char *value = reader->GetHeaderValue("modality");
-    if (value == NULL)
-      {
-      return 0;
-      }
-    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::SCALARS &&
-            !strcmp(value,"DWMRI") ) )
-      {
-      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }
-  else if ( refNode->IsA("vtkMRMLVectorVolumeNode") )
-    {
-    if (! (reader->GetPointDataType() == vtkDataSetAttributes::VECTORS
-           || reader->GetPointDataType() == vtkDataSetAttributes::NORMALS))
-      {
-      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }
-  else if ( refNode->IsA("vtkMRMLScalarVolumeNode") )
-    {
-    if (!(reader->GetPointDataType() == vtkDataSetAttributes::SCALARS &&
-        (reader->GetNumberOfComponents() == 1 || reader->GetNumberOfComponents()==3) ))
-      {
-      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }
-
-  reader->Update();
   // set volume attributes
   vtkMatrix4x4* mat = reader->GetRasToIjkMatrix();
   volNode->SetRASToIJKMatrix(mat);
@@ -296,6 +233,80 @@ int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLNRRDStorageNode::ExecuteReader(vtkMRMLNode *refNode, vtkNRRDReader* reader,
+                                          const std::string& fullName)
+{
+  // Set Reader member variables
+  if (this->CenterImage)
+    {
+    reader->SetUseNativeOriginOff();
+    }
+  else
+    {
+    reader->SetUseNativeOriginOn();
+    }
+
+  reader->SetFileName(fullName.c_str());
+
+  // Check if this is a NRRD file that we can read
+  if (!reader->CanReadFile(fullName.c_str()))
+    {
+    vtkErrorMacro("ReadData: This is not a nrrd file");
+    return 0;
+    }
+
+  // Read the header to see if the NRRD file corresponds to the
+  // MRML Node
+  reader->UpdateInformation();
+
+  // Check type
+  if ( refNode->IsA("vtkMRMLDiffusionTensorVolumeNode") )
+    {
+    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::TENSORS))
+      {
+      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
+      return 0;
+      }
+    }
+  else if ( refNode->IsA("vtkMRMLDiffusionWeightedVolumeNode"))
+    {
+    vtkDebugMacro("ReadData: Checking we have right info in file");
+    const char *value = reader->GetHeaderValue("modality");
+    if (value == NULL)
+      {
+      return 0;
+      }
+    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::SCALARS &&
+            !strcmp(value,"DWMRI") ) )
+      {
+      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
+      return 0;
+      }
+    }
+  else if ( refNode->IsA("vtkMRMLVectorVolumeNode") )
+    {
+    if (! (reader->GetPointDataType() == vtkDataSetAttributes::VECTORS
+           || reader->GetPointDataType() == vtkDataSetAttributes::NORMALS))
+      {
+      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
+      return 0;
+      }
+    }
+  else if ( refNode->IsA("vtkMRMLScalarVolumeNode") )
+    {
+    if (!(reader->GetPointDataType() == vtkDataSetAttributes::SCALARS &&
+        (reader->GetNumberOfComponents() == 1 || reader->GetNumberOfComponents()==3) ))
+      {
+      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
+      return 0;
+      }
+    }
+
+  reader->Update();
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLNRRDStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
 {
@@ -367,6 +378,9 @@ int vtkMRMLNRRDStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   writer->SetFileName(fullName.c_str());
   writer->SetInputConnection(volNode->GetImageDataConnection());
   writer->SetUseCompression(this->GetUseCompression());
+  writer->SetCompressionLevel(this->GetCompressionLevel());
+  // independent gzip members, still readable by any NRRD reader
+  writer->UseParallelCompressionOn();
 
   // set volume attributes
   writer->SetIJKToRASMatrix(ijkToRas.GetPointer());
@@ -397,7 +411,6 @@ int vtkMRMLNRRDStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     }
 
   this->StageWriteData(refNode);
-
   return writeFlag;
 }
 
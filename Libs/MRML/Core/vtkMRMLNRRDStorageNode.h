@@ -23,6 +23,8 @@ class vtkNRRDReader;
 ///
 /// vtkMRMLNRRDStorageNode nodes describe the archetybe based volume storage
 /// node that allows to read/write volume data from/to file using generic ITK mechanism.
+/// NRRD files are read and written by teem, which is not thread-safe, so
+/// this storage node does not support threaded reads and writes.
 class VTK_MRML_EXPORT vtkMRMLNRRDStorageNode : public vtkMRMLStorageNode
 {
   public:
@@ -88,6 +90,12 @@ protected:
   /// Write data from a  referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
+  /// Configure the reader for refNode, check the file kind matches the
+  /// node type and execute the reader.
+  /// Returns 1 on success, 0 otherwise.
+  int ExecuteReader(vtkMRMLNode *refNode, vtkNRRDReader* reader,
+                    const std::string& fullName);
+
   int CenterImage;
 
 };
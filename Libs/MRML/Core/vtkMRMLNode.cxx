@@ -18,6 +18,8 @@ Version:   $Revision: 1.11 $
 
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkDataObject.h>
+#include <vtkImageData.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 
@@ -223,6 +225,38 @@ void vtkMRMLNode::Reset()
   newNode->Delete();
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLNode::GetUndoDataObjects(std::vector<vtkDataObject*>& vtkNotUsed(dataObjects))
+{
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkMRMLNode::GetUndoContentMTime()
+{
+  unsigned long mtime = this->GetMTime();
+  std::vector<vtkDataObject*> dataObjects;
+  this->GetUndoDataObjects(dataObjects);
+  for (std::vector<vtkDataObject*>::iterator it = dataObjects.begin();
+       it != dataObjects.end(); ++it)
+    {
+    if (*it)
+      {
+      mtime = std::max(mtime, (*it)->GetMTime());
+      }
+    }
+  return mtime;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLNode::UndoImageRegionRestored(vtkImageData* image, int vtkNotUsed(extent)[6])
+{
+  if (image)
+    {
+    image->Modified();
+    }
+  this->Modified();
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLNode::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -29,6 +29,8 @@ class vtkMRMLScene;
 #include <vtkSmartPointer.h>
 #include <vtkWeakPointer.h>
 class vtkCallbackCommand;
+class vtkDataObject;
+class vtkImageData;
 
 // Slicer VTK add-on includes
 #include <vtkLoggingMacros.h>
@@ -237,6 +239,30 @@ public:
   /// \sa SetSingletonTag()
   virtual void Reset();
 
+  /// \brief Add the bulk data held by the node (e.g. image data, polydata)
+  /// to \a dataObjects.
+  ///
+  /// The scene measures the memory of the undo history with it.
+  /// None by default.
+  /// \sa GetUndoContentMTime(), vtkMRMLScene::GetUndoMemorySize()
+  virtual void GetUndoDataObjects(std::vector<vtkDataObject*>& dataObjects);
+
+  /// \brief Most recent modification time of the node and of its bulk data.
+  ///
+  /// In delta undo mode, the scene reuses the undo snapshot of a node whose
+  /// content modification time did not change. The maximum of GetMTime()
+  /// and of the modification times of GetUndoDataObjects() by default.
+  /// \sa vtkMRMLScene::SetDeltaUndo()
+  virtual unsigned long GetUndoContentMTime();
+
+  /// \brief Called by the scene when Undo() or Redo() copied saved voxels
+  /// back into \a image inside the IJK \a extent.
+  ///
+  /// \a image is the image given to vtkMRMLScene::SaveImageRegionStateForUndo()
+  /// with the node as owner. The image and the node are marked as modified
+  /// by default.
+  virtual void UndoImageRegionRestored(vtkImageData* image, int extent[6]);
+
   /// \brief Start modifying the node. Disable Modify events.
   ///
   /// Returns the previous state of \a DisableModifiedEvent flag
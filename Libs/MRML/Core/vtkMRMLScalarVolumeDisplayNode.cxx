@@ -193,8 +193,14 @@ vtkAlgorithmOutput* vtkMRMLScalarVolumeDisplayNode::GetBackgroundImageStencilDat
   // Input ports:
   // 0 = foreground image, 1 = background image, 2 = stencil
   const int stencilInputPort = 2;
-  return this->MultiplyAlpha->GetNumberOfInputConnections(0)>stencilInputPort ?
-    this->MultiplyAlpha->GetInputConnection(0,stencilInputPort) : 0;
+  return this->MultiplyAlpha->GetNumberOfInputConnections(stencilInputPort) ?
+    this->MultiplyAlpha->GetInputConnection(stencilInputPort,0) : 0;
+}
+
+//----------------------------------------------------------------------------
+vtkScalarsToColors* vtkMRMLScalarVolumeDisplayNode::GetLookupTable()
+{
+  return this->MapToColors->GetLookupTable();
 }
 
 //----------------------------------------------------------------------------
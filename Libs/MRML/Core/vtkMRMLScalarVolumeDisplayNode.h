@@ -31,6 +31,7 @@ class vtkImageStencil;
 class vtkImageThreshold;
 class vtkImageExtractComponents;
 class vtkImageMathematics;
+class vtkScalarsToColors;
 
 // STD includes
 #include <vector>
@@ -150,6 +151,10 @@ class VTK_MRML_EXPORT vtkMRMLScalarVolumeDisplayNode : public vtkMRMLVolumeDispl
   virtual void SetBackgroundImageStencilDataConnection(vtkAlgorithmOutput *imageDataConnection);
   virtual vtkAlgorithmOutput* GetBackgroundImageStencilDataConnection();
 
+  ///
+  /// Lookup table used to map the window/level values to colors
+  vtkScalarsToColors* GetLookupTable();
+
   ///
   /// Parse a string with window and level as double|double, and add a preset
   void AddWindowLevelPresetFromString(const char *preset);
@@ -84,8 +84,11 @@ Version:   $Revision: 1.18 $
 #include <vtkCollection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkErrorCode.h>
+#include <vtkImageData.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 #include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
 
 // VTKSYS includes
 #include <vtksys/RegularExpression.hxx>
@@ -102,6 +105,51 @@ Version:   $Revision: 1.18 $
 # include <vtkTimerLog.h>
 #endif
 
+namespace
+{
+/// Size (in voxels along each axis) of the image bricks saved by
+/// vtkMRMLScene::SaveImageRegionStateForUndo()
+const int UNDO_IMAGE_BRICK_SIZE = 32;
+
+//----------------------------------------------------------------------------
+/// Voxels of an image region saved in an undo or redo level, next to the
+/// node snapshots.
+class vtkMRMLSceneUndoImageRegion : public vtkObject
+{
+public:
+  static vtkMRMLSceneUndoImageRegion *New();
+  vtkTypeMacro(vtkMRMLSceneUndoImageRegion, vtkObject);
+
+  /// Image the region belongs to
+  vtkSmartPointer<vtkImageData> Image;
+  /// Saved voxels, the extent of the region is the extent of the image.
+  vtkSmartPointer<vtkImageData> Region;
+  /// Node to notify when the region is restored
+  vtkWeakPointer<vtkMRMLNode> Owner;
+
+protected:
+  vtkMRMLSceneUndoImageRegion() {}
+  ~vtkMRMLSceneUndoImageRegion() {}
+};
+vtkStandardNewMacro(vtkMRMLSceneUndoImageRegion);
+
+//----------------------------------------------------------------------------
+vtkMRMLSceneUndoImageRegion* NewUndoImageRegion(vtkImageData* image,
+                                                int extent[6],
+                                                vtkMRMLNode* owner)
+{
+  vtkMRMLSceneUndoImageRegion* region = vtkMRMLSceneUndoImageRegion::New();
+  region->Image = image;
+  region->Owner = owner;
+  region->Region = vtkSmartPointer<vtkImageData>::New();
+  region->Region->SetExtent(extent);
+  region->Region->AllocateScalars(image->GetScalarType(),
+                                  image->GetNumberOfScalarComponents());
+  region->Region->CopyAndCastFrom(image, extent);
+  return region;
+}
+}
+
 vtkCxxSetObjectMacro(vtkMRMLScene, CacheManager, vtkCacheManager)
 vtkCxxSetObjectMacro(vtkMRMLScene, DataIOManager, vtkDataIOManager)
 vtkCxxSetObjectMacro(vtkMRMLScene, UserTagTable, vtkTagTable)
@@ -111,6 +159,7 @@ vtkCxxSetObjectMacro(vtkMRMLScene, URIHandlerCollection, vtkCollection)
 vtkMRMLScene::vtkMRMLScene()
 {
   this->NodeIDsMTime = 0;
+  this->NodesByClassMTime = 0;
   this->SceneModifiedTime = 0;
 
   this->RegisteredNodeClasses.clear();
@@ -121,6 +170,9 @@ vtkMRMLScene::vtkMRMLScene()
   this->UndoStackSize = 100;
   this->UndoFlag = false;
   this->InUndo = false;
+  this->DeltaUndo = false;
+  this->UndoMemoryLimit = 0;
+  this->UndoMemorySize = 0;
 
   this->NodeReferences.clear();
   this->ReferencedIDChanges.clear();
@@ -718,6 +770,13 @@ int vtkMRMLScene::Import()
 
     this->InvokeEvent(vtkMRMLScene::NewSceneEvent, NULL);
 
+    // Decode the local data files concurrently, the data is set into the
+    // nodes by the UpdateScene() calls below.
+    if (this->DataIOManager)
+      {
+      this->DataIOManager->PrefetchLocalData(loadedNodes, this);
+      }
+
     // Notify the imported nodes about that all nodes are created
     // (so the observers can be attached to referenced nodes, etc.)
     // by calling UpdateScene on each node
@@ -1121,10 +1180,12 @@ vtkMRMLNode*  vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
     n->SetName(this->GenerateUniqueName(n).c_str());
     }
   n->SetScene( this );
+  bool classCacheUpToDate = this->IsClassCacheUpToDate();
   this->Nodes->vtkCollection::AddItem((vtkObject *)n);
 
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->AddNodeToClassCache(n, classCacheUpToDate);
 
   //n->OnNodeAddedToScene();
 
@@ -1251,10 +1312,12 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
     {
     n->SetScene(0);
     }
+  bool classCacheUpToDate = this->IsClassCacheUpToDate();
   this->Nodes->vtkCollection::RemoveItem((vtkObject *)n);
 
   std::string nid=n->GetID();
   this->RemoveNodeID(n->GetID());
+  this->RemoveNodeFromClassCache(n, classCacheUpToDate);
 
   this->InvokeEvent(vtkMRMLScene::NodeRemovedEvent, n);
 
@@ -1431,18 +1494,7 @@ int vtkMRMLScene::GetNumberOfNodesByClass(const char *className)
     vtkErrorMacro("GetNumberOfNodesByClass: class name is null.");
     return 0;
     }
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      num++;
-      }
-    }
-  return num;
+  return static_cast<int>(this->GetCachedNodesByClass(className).size());
 }
 
 //------------------------------------------------------------------------------
@@ -1453,16 +1505,8 @@ int vtkMRMLScene::GetNodesByClass(const char *className, std::vector<vtkMRMLNode
     vtkErrorMacro("GetNodesByClass: class name is null.");
     return 0;
     }
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      nodes.push_back(node);
-      }
-    }
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetCachedNodesByClass(className);
+  nodes.insert(nodes.end(), classNodes.begin(), classNodes.end());
   return static_cast<int>(nodes.size());
 }
 
@@ -1475,15 +1519,11 @@ vtkCollection* vtkMRMLScene::GetNodesByClass(const char *className)
     return 0;
     }
   vtkCollection* nodes = vtkCollection::New();
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetCachedNodesByClass(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator it = classNodes.begin();
+       it != classNodes.end(); ++it)
     {
-    if (node->IsA(className))
-      {
-      nodes->AddItem(node);
-      }
+    nodes->AddItem(*it);
     }
   return nodes;
 }
@@ -1611,22 +1651,12 @@ vtkMRMLNode* vtkMRMLScene::GetNthNodeByClass(int n, const char *className)
     return NULL;
     }
 
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetCachedNodesByClass(className);
+  if (n >= static_cast<int>(classNodes.size()))
     {
-    if (node->IsA(className))
-      {
-      if (num == n)
-        {
-        return node;
-        }
-      num++;
-      }
+    return NULL;
     }
-  return NULL;
+  return classNodes[n];
 }
 
 //------------------------------------------------------------------------------
@@ -1767,13 +1797,13 @@ vtkCollection* vtkMRMLScene::GetNodesByClassByName(const char* className, const
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  for (int n=0; n < this->Nodes->GetNumberOfItems(); n++)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetCachedNodesByClass(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator it = classNodes.begin();
+       it != classNodes.end(); ++it)
     {
-    node = (vtkMRMLNode*)this->Nodes->GetItemAsObject(n);
-    if (!strcmp(node->GetName(), name) && node->IsA(className))
+    if ((*it)->GetName() && !strcmp((*it)->GetName(), name))
       {
-      nodes->AddItem(node);
+      nodes->AddItem(*it);
       }
     }
 
@@ -2205,6 +2235,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkMRMLNode *node)
     {
     this->CopyNodeInUndoStack(node);
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2236,6 +2267,7 @@ void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> nodes)
       this->CopyNodeInUndoStack(node);
       }
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2275,6 +2307,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
       this->CopyNodeInUndoStack(node);
       }
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2319,8 +2352,9 @@ void vtkMRMLScene::PushIntoUndoStack()
       }
     }
 
-  //TODO check max stack size
   this->UndoStack.push_back(newScene);
+  // the new level has no saved image region yet
+  this->UndoImageBricks.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -2362,10 +2396,25 @@ void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
     return;
     }
 
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != NULL)
+  vtkMRMLNode *snode = this->DeltaUndo ? this->GetReusableUndoSnapshot(copyNode) : NULL;
+  bool newSnapshot = (snode == NULL);
+  if (!newSnapshot)
+    {
+    // the node did not change since the previous undo level, share the
+    // snapshot
+    snode->Register(this);
+    }
+  else
+    {
+    snode = copyNode->CreateNodeInstance();
+    if (snode != NULL)
+      {
+      snode->CopyWithScene(copyNode);
+      }
+    }
+  if (snode == NULL)
     {
-    snode->CopyWithScene(copyNode);
+    return;
     }
   vtkCollection* undoScene = dynamic_cast < vtkCollection *>( this->UndoStack.back() );
   int nnodes = undoScene->GetNumberOfItems();
@@ -2375,10 +2424,313 @@ void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
     if (node == copyNode)
       {
       undoScene->ReplaceItem (n, snode);
+      this->AddUndoItem(snode, copyNode);
+      if (newSnapshot && this->DeltaUndo)
+        {
+        this->UndoItems[snode].ContentMTime = copyNode->GetUndoContentMTime();
+        }
       break;
       }
     }
-  snode->Delete();
+  snode->UnRegister(this);
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLScene::GetReusableUndoSnapshot(vtkMRMLNode *node)
+{
+  if (this->UndoStack.size() < 2 || node->GetID() == NULL)
+    {
+    return NULL;
+    }
+  std::list< vtkCollection* >::reverse_iterator previousLevelIt = this->UndoStack.rbegin();
+  ++previousLevelIt;
+  vtkCollection* previousLevel = *previousLevelIt;
+  vtkMRMLNode* snapshot = NULL;
+  vtkCollectionSimpleIterator it;
+  for (previousLevel->InitTraversal(it);
+       (snapshot = vtkMRMLNode::SafeDownCast(previousLevel->GetNextItemAsObject(it))) ;)
+    {
+    if (snapshot != node && snapshot->GetID() && !strcmp(snapshot->GetID(), node->GetID()))
+      {
+      break;
+      }
+    }
+  if (snapshot == NULL)
+    {
+    return NULL;
+    }
+  std::map< vtkSmartPointer<vtkObject>, UndoItemInfo >::iterator itemIt =
+    this->UndoItems.find(snapshot);
+  if (itemIt == this->UndoItems.end() ||
+      itemIt->second.ContentMTime == 0 ||
+      itemIt->second.ContentMTime != node->GetUndoContentMTime())
+    {
+    return NULL;
+    }
+  return snapshot;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::SaveImageRegionStateForUndo(vtkImageData* image, int extent[6],
+                                               vtkMRMLNode* owner, bool newUndoLevel)
+{
+  if (!this->UndoFlag || this->InUndo || this->IsBatchProcessing())
+    {
+    return;
+    }
+  if (!image || !image->GetPointData() || !image->GetPointData()->GetScalars())
+    {
+    return;
+    }
+  int imageExtent[6];
+  image->GetExtent(imageExtent);
+  int regionExtent[6];
+  for (int i = 0; i < 3; ++i)
+    {
+    regionExtent[2*i] = std::max(extent[2*i], imageExtent[2*i]);
+    regionExtent[2*i+1] = std::min(extent[2*i+1], imageExtent[2*i+1]);
+    if (regionExtent[2*i] > regionExtent[2*i+1])
+      {
+      // nothing to save
+      return;
+      }
+    }
+
+  this->ClearRedoStack();
+  if (newUndoLevel || this->UndoStack.empty())
+    {
+    this->PushIntoUndoStack();
+    }
+  vtkCollection* undoScene = this->UndoStack.back();
+
+  // save the bricks that are not in the undo level yet
+  int firstBrick[3];
+  int lastBrick[3];
+  int numberOfBricks[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    firstBrick[i] = (regionExtent[2*i] - imageExtent[2*i]) / UNDO_IMAGE_BRICK_SIZE;
+    lastBrick[i] = (regionExtent[2*i+1] - imageExtent[2*i]) / UNDO_IMAGE_BRICK_SIZE;
+    numberOfBricks[i] = (imageExtent[2*i+1] - imageExtent[2*i]) / UNDO_IMAGE_BRICK_SIZE + 1;
+    }
+  for (int k = firstBrick[2]; k <= lastBrick[2]; ++k)
+    {
+    for (int j = firstBrick[1]; j <= lastBrick[1]; ++j)
+      {
+      for (int i = firstBrick[0]; i <= lastBrick[0]; ++i)
+        {
+        vtkIdType brickIndex = i + static_cast<vtkIdType>(numberOfBricks[0]) *
+          (j + static_cast<vtkIdType>(numberOfBricks[1]) * k);
+        if (!this->UndoImageBricks.insert(std::make_pair(image, brickIndex)).second)
+          {
+          // already saved
+          continue;
+          }
+        int brickExtent[6];
+        int brickIndices[3] = {i, j, k};
+        for (int axis = 0; axis < 3; ++axis)
+          {
+          brickExtent[2*axis] = imageExtent[2*axis] + brickIndices[axis] * UNDO_IMAGE_BRICK_SIZE;
+          brickExtent[2*axis+1] = std::min(brickExtent[2*axis] + UNDO_IMAGE_BRICK_SIZE - 1,
+                                           imageExtent[2*axis+1]);
+          }
+        vtkMRMLSceneUndoImageRegion* region = NewUndoImageRegion(image, brickExtent, owner);
+        undoScene->AddItem(region);
+        this->AddUndoItem(region);
+        region->Delete();
+        }
+      }
+    }
+  this->TrimUndoStack();
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::RestoreImageRegions(vtkCollection* level, vtkCollection* inverseLevel)
+{
+  // restored extent of each image, and owner to notify
+  typedef std::map< vtkImageData*, std::pair< vtkMRMLNode*, std::vector<int> > > RestoredImagesType;
+  RestoredImagesType restoredImages;
+  // restore in reverse order so that the earliest saved voxels win if a
+  // region was saved twice
+  for (int n = level->GetNumberOfItems() - 1; n >= 0; --n)
+    {
+    vtkMRMLSceneUndoImageRegion* region =
+      vtkMRMLSceneUndoImageRegion::SafeDownCast(level->GetItemAsObject(n));
+    if (!region)
+      {
+      continue;
+      }
+    int regionExtent[6];
+    int imageExtent[6];
+    region->Region->GetExtent(regionExtent);
+    region->Image->GetExtent(imageExtent);
+    if (region->Image->GetScalarType() != region->Region->GetScalarType() ||
+        regionExtent[0] < imageExtent[0] || regionExtent[1] > imageExtent[1] ||
+        regionExtent[2] < imageExtent[2] || regionExtent[3] > imageExtent[3] ||
+        regionExtent[4] < imageExtent[4] || regionExtent[5] > imageExtent[5])
+      {
+      vtkWarningMacro("RestoreImageRegions: image was reallocated, region can't be restored");
+      continue;
+      }
+    if (inverseLevel)
+      {
+      vtkMRMLSceneUndoImageRegion* currentRegion =
+        NewUndoImageRegion(region->Image, regionExtent, region->Owner);
+      inverseLevel->AddItem(currentRegion);
+      this->AddUndoItem(currentRegion);
+      currentRegion->Delete();
+      }
+    region->Image->CopyAndCastFrom(region->Region, regionExtent);
+    RestoredImagesType::iterator restoredIt = restoredImages.find(region->Image);
+    if (restoredIt == restoredImages.end())
+      {
+      restoredImages[region->Image] = std::make_pair(
+        region->Owner.GetPointer(), std::vector<int>(regionExtent, regionExtent + 6));
+      continue;
+      }
+    std::vector<int>& restoredExtent = restoredIt->second.second;
+    for (int i = 0; i < 3; ++i)
+      {
+      restoredExtent[2*i] = std::min(restoredExtent[2*i], regionExtent[2*i]);
+      restoredExtent[2*i+1] = std::max(restoredExtent[2*i+1], regionExtent[2*i+1]);
+      }
+    }
+  for (RestoredImagesType::iterator restoredIt = restoredImages.begin();
+       restoredIt != restoredImages.end(); ++restoredIt)
+    {
+    vtkMRMLNode* owner = restoredIt->second.first;
+    if (owner)
+      {
+      owner->UndoImageRegionRestored(restoredIt->first, &restoredIt->second.second[0]);
+      }
+    else
+      {
+      restoredIt->first->Modified();
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::DeleteUndoLevel(vtkCollection* level)
+{
+  if (!level)
+    {
+    return;
+    }
+  vtkObject *item = NULL;
+  vtkCollectionSimpleIterator it;
+  for (level->InitTraversal(it); (item = level->GetNextItemAsObject(it)) ;)
+    {
+    this->RemoveUndoItem(item);
+    }
+  level->RemoveAllItems();
+  level->Delete();
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::TrimUndoStack()
+{
+  int maxNumberOfLevels = std::max(this->UndoStackSize, 1);
+  while (static_cast<int>(this->UndoStack.size()) > maxNumberOfLevels)
+    {
+    this->DeleteUndoLevel(this->UndoStack.front());
+    this->UndoStack.pop_front();
+    }
+  // the front of the redo stack is the last state that can be redone
+  while (static_cast<int>(this->RedoStack.size()) > maxNumberOfLevels)
+    {
+    this->DeleteUndoLevel(this->RedoStack.front());
+    this->RedoStack.pop_front();
+    }
+  if (this->UndoMemoryLimit == 0)
+    {
+    return;
+    }
+  while (this->UndoStack.size() + this->RedoStack.size() > 1 &&
+         this->GetUndoMemorySize() > this->UndoMemoryLimit)
+    {
+    vtkDebugMacro("TrimUndoStack: undo memory limit reached, discard a level");
+    // the states that are the furthest from the current one go first
+    std::list< vtkCollection* >& stack =
+      (this->RedoStack.size() > this->UndoStack.size() ? this->RedoStack : this->UndoStack);
+    this->DeleteUndoLevel(stack.front());
+    stack.pop_front();
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::AddUndoItem(vtkObject* item, vtkMRMLNode* sceneNode)
+{
+  UndoItemInfo& info = this->UndoItems[item];
+  if (info.NumberOfLevels++ > 0)
+    {
+    // already accounted for by another level
+    return;
+    }
+  std::vector<vtkDataObject*> dataObjects;
+  vtkMRMLSceneUndoImageRegion* region = vtkMRMLSceneUndoImageRegion::SafeDownCast(item);
+  vtkMRMLNode* snapshot = vtkMRMLNode::SafeDownCast(item);
+  if (region)
+    {
+    dataObjects.push_back(region->Region);
+    }
+  else if (snapshot)
+    {
+    snapshot->GetUndoDataObjects(dataObjects);
+    }
+  // the data still used by the scene (e.g. image data shared by a volume
+  // snapshot) is not held by the history
+  std::vector<vtkDataObject*> sceneDataObjects;
+  if (sceneNode)
+    {
+    sceneNode->GetUndoDataObjects(sceneDataObjects);
+    }
+  for (std::vector<vtkDataObject*>::iterator dataIt = dataObjects.begin();
+       dataIt != dataObjects.end(); ++dataIt)
+    {
+    if (std::find(sceneDataObjects.begin(), sceneDataObjects.end(), *dataIt) !=
+        sceneDataObjects.end())
+      {
+      continue;
+      }
+    info.DataObjects.push_back(*dataIt);
+    std::pair<int, unsigned long>& dataSize = this->UndoDataObjectMemorySizes[*dataIt];
+    if (dataSize.first++ == 0)
+      {
+      dataSize.second = (*dataIt)->GetActualMemorySize();
+      this->UndoMemorySize += dataSize.second;
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::RemoveUndoItem(vtkObject* item)
+{
+  std::map< vtkSmartPointer<vtkObject>, UndoItemInfo >::iterator itemIt =
+    this->UndoItems.find(item);
+  if (itemIt == this->UndoItems.end())
+    {
+    // node of the scene, not held by the history
+    return;
+    }
+  if (--itemIt->second.NumberOfLevels > 0)
+    {
+    return;
+    }
+  std::vector< vtkSmartPointer<vtkDataObject> >& dataObjects = itemIt->second.DataObjects;
+  for (std::vector< vtkSmartPointer<vtkDataObject> >::iterator dataIt = dataObjects.begin();
+       dataIt != dataObjects.end(); ++dataIt)
+    {
+    std::map< vtkDataObject*, std::pair<int, unsigned long> >::iterator dataSizeIt =
+      this->UndoDataObjectMemorySizes.find(*dataIt);
+    if (dataSizeIt != this->UndoDataObjectMemorySizes.end() &&
+        --dataSizeIt->second.first == 0)
+      {
+      this->UndoMemorySize -= dataSizeIt->second.second;
+      this->UndoDataObjectMemorySizes.erase(dataSizeIt);
+      }
+    }
+  this->UndoItems.erase(itemIt);
 }
 
 //------------------------------------------------------------------------------
@@ -2404,6 +2756,7 @@ void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
     if (node == copyNode)
       {
       undoScene->ReplaceItem (n, snode);
+      this->AddUndoItem(snode, copyNode);
       break;
       }
     }
@@ -2468,6 +2821,8 @@ void vtkMRMLScene::Undo()
         undoNodes.push_back(node);
         }
       }
+    // copy back the saved voxels, the current ones go to the redo level
+    this->RestoreImageRegions(undoScene, this->RedoStack.back());
     }
 
   std::vector<std::string>::iterator iterID;
@@ -2510,7 +2865,26 @@ void vtkMRMLScene::Undo()
 
   for (nn=0; nn<addNodes.size(); nn++)
     {
-    this->AddNode(addNodes[nn]);
+    vtkMRMLNode* nodeToAdd = addNodes[nn];
+    std::map< vtkSmartPointer<vtkObject>, UndoItemInfo >::iterator snapshotIt =
+      this->UndoItems.find(nodeToAdd);
+    if (snapshotIt != this->UndoItems.end())
+      {
+      if (snapshotIt->second.NumberOfLevels > 1)
+        {
+        // the snapshot is shared with older undo levels (delta undo) and
+        // must stay untouched, add a copy of it instead
+        vtkSmartPointer<vtkMRMLNode> restoredNode =
+          vtkSmartPointer<vtkMRMLNode>::Take(nodeToAdd->CreateNodeInstance());
+        restoredNode->CopyWithScene(nodeToAdd);
+        restoredNode->SetID(nodeToAdd->GetID());
+        this->AddNode(restoredNode);
+        continue;
+        }
+      // the snapshot becomes a node of the scene, it can be modified
+      snapshotIt->second.ContentMTime = 0;
+      }
+    this->AddNode(nodeToAdd);
     }
   for (nn=0; nn<removeNodes.size(); nn++)
     {
@@ -2523,11 +2897,7 @@ void vtkMRMLScene::Undo()
       }
     }
 
-  if (undoScene)
-    {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
-    }
+  this->DeleteUndoLevel(undoScene);
 
   this->RemoveUnusedNodeReferences();
 
@@ -2535,6 +2905,9 @@ void vtkMRMLScene::Undo()
    {
    UndoStack.pop_back();
    }
+  // bricks saved in the new top undo level are unknown
+  this->UndoImageBricks.clear();
+  this->TrimUndoStack();
   this->Modified();
 
   this->InUndo = false;
@@ -2591,6 +2964,8 @@ void vtkMRMLScene::Redo()
         undoMap[node->GetID()] = node;
         }
       }
+    // copy back the undone voxels, the current ones go to the undo level
+    this->RestoreImageRegions(undoScene, this->UndoStack.back());
     }
 
   //std::hash_map<std::string, vtkMRMLNode*>::iterator iter;
@@ -2638,14 +3013,11 @@ void vtkMRMLScene::Redo()
     this->RemoveNode(removeNodes[nn]);
     }
 
-  if (undoScene)
-    {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
-    }
+  this->DeleteUndoLevel(undoScene);
 
   RedoStack.pop_back();
 
+  this->TrimUndoStack();
   this->Modified();
 }
 
@@ -2655,10 +3027,10 @@ void vtkMRMLScene::ClearUndoStack()
   std::list< vtkCollection* >::iterator iter;
   for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
     {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
+    this->DeleteUndoLevel(*iter);
     }
   this->UndoStack.clear();
+  this->UndoImageBricks.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -2667,8 +3039,7 @@ void vtkMRMLScene::ClearRedoStack()
   std::list< vtkCollection* >::iterator iter;
   for(iter=this->RedoStack.begin(); iter != this->RedoStack.end(); iter++)
     {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
+    this->DeleteUndoLevel(*iter);
     }
   this->RedoStack.clear();
 }
@@ -2995,6 +3366,89 @@ void vtkMRMLScene::ClearNodeIDs()
   }
 }
 
+//-----------------------------------------------------------------------------
+const std::vector<vtkMRMLNode*>& vtkMRMLScene::GetCachedNodesByClass(const char* className)
+{
+  if (!this->IsClassCacheUpToDate())
+    {
+    this->ClearClassCache();
+    }
+  std::map< std::string, std::vector<vtkMRMLNode*> >::iterator cacheIt =
+    this->NodesByClass.find(className);
+  if (cacheIt != this->NodesByClass.end())
+    {
+    return cacheIt->second;
+    }
+#ifdef MRMLSCENE_VERBOSE
+  std::cerr << "Compute node class cache for " << className << "..." << std::endl;
+#endif
+  std::vector<vtkMRMLNode*>& classNodes = this->NodesByClass[className];
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    if (node->IsA(className))
+      {
+      classNodes.push_back(node);
+      }
+    }
+  return classNodes;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeToClassCache(vtkMRMLNode* node, bool cacheUpToDate)
+{
+  if (!cacheUpToDate)
+    {
+    this->ClearClassCache();
+    return;
+    }
+  std::map< std::string, std::vector<vtkMRMLNode*> >::iterator cacheIt;
+  for (cacheIt = this->NodesByClass.begin(); cacheIt != this->NodesByClass.end(); ++cacheIt)
+    {
+    if (node->IsA(cacheIt->first.c_str()))
+      {
+      cacheIt->second.push_back(node);
+      }
+    }
+  this->NodesByClassMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeFromClassCache(vtkMRMLNode* node, bool cacheUpToDate)
+{
+  if (!cacheUpToDate)
+    {
+    this->ClearClassCache();
+    return;
+    }
+  std::map< std::string, std::vector<vtkMRMLNode*> >::iterator cacheIt;
+  for (cacheIt = this->NodesByClass.begin(); cacheIt != this->NodesByClass.end(); ++cacheIt)
+    {
+    if (node->IsA(cacheIt->first.c_str()))
+      {
+      std::vector<vtkMRMLNode*>& classNodes = cacheIt->second;
+      classNodes.erase(std::remove(classNodes.begin(), classNodes.end(), node),
+                       classNodes.end());
+      }
+    }
+  this->NodesByClassMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkMRMLScene::IsClassCacheUpToDate()const
+{
+  return this->Nodes && this->Nodes->GetMTime() <= this->NodesByClassMTime;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ClearClassCache()
+{
+  this->NodesByClass.clear();
+  this->NodesByClassMTime = this->Nodes ? this->Nodes->GetMTime() : 0;
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::AddURIHandler(vtkURIHandler *handler)
 {
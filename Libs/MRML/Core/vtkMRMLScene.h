@@ -39,7 +39,9 @@ class vtkTagTable;
 
 class vtkCallbackCommand;
 class vtkCollection;
+class vtkDataObject;
 class vtkGeneralTransform;
+class vtkImageData;
 class vtkURIHandler;
 class vtkMRMLNode;
 class vtkMRMLSceneViewNode;
@@ -292,6 +294,57 @@ public:
   void SaveStateForUndo(vtkCollection *nodes);
   void SaveStateForUndo(std::vector<vtkMRMLNode *> nodes);
 
+  /// \brief Save the voxels of \a image inside \a extent in the undo buffer.
+  ///
+  /// To be called before modifying the image in place (e.g. painting into a
+  /// labelmap): only the bricks of the image overlapping \a extent that have
+  /// not been saved yet in the current undo level are copied, so that a
+  /// whole paint stroke costs the size of the painted region and not the
+  /// size of the image. Undo() and Redo() copy the saved voxels back into
+  /// \a image and notify \a owner with the restored extent (see
+  /// vtkMRMLNode::UndoImageRegionRestored()), or call Modified() on \a image
+  /// if there is no owner.
+  /// If \a newUndoLevel is true (e.g. at the beginning of a stroke), a new
+  /// undo level is pushed first, otherwise the voxels are added to the
+  /// current undo level.
+  /// \sa GetDeltaUndo()
+  void SaveImageRegionStateForUndo(vtkImageData* image, int extent[6],
+                                   vtkMRMLNode* owner = 0,
+                                   bool newUndoLevel = false);
+
+  /// \brief Delta undo mode.
+  ///
+  /// When enabled, saving the state of a node whose properties and bulk data
+  /// (image, polydata, segments) have not changed since its snapshot in the
+  /// previous undo level reuses that snapshot instead of making a new copy.
+  /// Saving the whole scene (e.g. SaveStateForUndo()) then only copies the
+  /// nodes that were modified since the last undo level.
+  /// Disabled by default.
+  void SetDeltaUndo(bool enable) {DeltaUndo = enable;};
+  bool GetDeltaUndo() {return DeltaUndo;};
+
+  /// Maximum number of undo levels (and of redo levels), the oldest undo
+  /// levels and the last redo levels are discarded first. 100 by default.
+  void SetUndoStackSize(int size) {UndoStackSize = size;};
+  int GetUndoStackSize() {return UndoStackSize;};
+
+  /// \brief Approximate memory budget of the undo and redo history in kB.
+  ///
+  /// When the history exceeds the budget, the oldest undo levels are
+  /// discarded (the most recent level is always kept).
+  /// 0 (default) means no limit.
+  /// \sa GetUndoMemorySize()
+  void SetUndoMemoryLimit(unsigned long limit) {UndoMemoryLimit = limit;};
+  unsigned long GetUndoMemoryLimit() {return UndoMemoryLimit;};
+
+  /// Return the approximate memory in kB used by the bulk data (images,
+  /// polydata, segments) that the undo and redo history holds on its own.
+  /// The data of each snapshot and image region is measured when it enters
+  /// the history: data still used by the node of the scene at that time is
+  /// not counted, data shared by several snapshots is counted once.
+  /// \sa vtkMRMLNode::GetUndoDataObjects()
+  unsigned long GetUndoMemorySize() {return UndoMemorySize;};
+
   /// The Scene maintains a map (NodeReferences) to keep track of the relationship
   /// between node IDs and the nodes referencing those IDs.  Each
   /// node can use the call AddReferencedNodeID() to tell the scene
@@ -635,6 +688,31 @@ protected:
   void CopyNodeInUndoStack(vtkMRMLNode *node);
   void CopyNodeInRedoStack(vtkMRMLNode *node);
 
+  /// Return the snapshot of \a node in the undo level below the top one if
+  /// \a node did not change since that snapshot was taken, NULL otherwise.
+  /// \sa GetDeltaUndo()
+  vtkMRMLNode* GetReusableUndoSnapshot(vtkMRMLNode *node);
+
+  /// Copy the image regions saved in \a level back into their images, after
+  /// saving the current voxels of these regions into \a inverseLevel.
+  void RestoreImageRegions(vtkCollection* level, vtkCollection* inverseLevel);
+
+  /// Delete an undo or redo level.
+  void DeleteUndoLevel(vtkCollection* level);
+
+  /// Discard the undo and redo levels exceeding UndoStackSize, then the
+  /// oldest undo levels and the last redo levels exceeding UndoMemoryLimit.
+  void TrimUndoStack();
+
+  /// Account for \a item (node snapshot or image region) being added to an
+  /// undo or redo level. The bulk data of the item that is not used by
+  /// \a sceneNode (the node the snapshot was taken from) is added to the
+  /// undo memory size, each data object once even if shared by several items.
+  /// \sa GetUndoMemorySize(), vtkMRMLNode::GetUndoDataObjects()
+  void AddUndoItem(vtkObject* item, vtkMRMLNode* sceneNode = 0);
+  /// Account for \a item being removed from an undo or redo level.
+  void RemoveUndoItem(vtkObject* item);
+
   /// Add a node to the scene without invoking a vtkMRMLScene::NodeAddedEvent event.
   ///
   /// \warning Use with extreme caution as it might unsynchronize observer.
@@ -677,6 +755,29 @@ protected:
   /// Clear NodeIDs map used to speedup GetByID() method.
   void ClearNodeIDs();
 
+  /// \brief Return the nodes of the scene that are of class \a className
+  /// (IsA()), in scene order.
+  ///
+  /// The list is computed on the first request for \a className and then
+  /// kept up to date by AddNodeNoNotify() and RemoveNode(). Any other change
+  /// of the \a Nodes collection invalidates all the lists.
+  /// \sa NodesByClass
+  const std::vector<vtkMRMLNode*>& GetCachedNodesByClass(const char* className);
+
+  /// Append \a node to the cached class lists it belongs to, or clear the
+  /// cache if it was already out of date before adding the node.
+  void AddNodeToClassCache(vtkMRMLNode* node, bool cacheUpToDate);
+
+  /// Remove \a node from the cached class lists, or clear the cache if it
+  /// was already out of date before removing the node.
+  void RemoveNodeFromClassCache(vtkMRMLNode* node, bool cacheUpToDate);
+
+  /// Return true if the class lists are in sync with the \a Nodes collection.
+  bool IsClassCacheUpToDate()const;
+
+  /// Clear the class lists used to speedup the *ByClass() methods.
+  void ClearClassCache();
+
   /// Get a NodeReferences iterator for a node reference.
   NodeReferencesType::iterator FindNodeReference(const char* referencedId, vtkMRMLNode* referencingNode);
 
@@ -694,6 +795,28 @@ protected:
   int  UndoStackSize;
   bool UndoFlag;
   bool InUndo;
+  bool DeltaUndo;
+  unsigned long UndoMemoryLimit;
+  unsigned long UndoMemorySize;
+
+  /// Item (node snapshot or image region) held by undo and redo levels.
+  struct UndoItemInfo
+    {
+    UndoItemInfo() : NumberOfLevels(0), ContentMTime(0) {}
+    /// Number of undo and redo levels holding the item
+    int NumberOfLevels;
+    /// Content modification time of the node when the snapshot was taken,
+    /// 0 if the snapshot can't be reused by the next undo level.
+    unsigned long ContentMTime;
+    /// Bulk data of the item counted in UndoMemorySize
+    std::vector< vtkSmartPointer<vtkDataObject> > DataObjects;
+    };
+  std::map< vtkSmartPointer<vtkObject>, UndoItemInfo > UndoItems;
+  /// Bricks (image, brick index) already saved in the top undo level.
+  std::set< std::pair<vtkImageData*, vtkIdType> > UndoImageBricks;
+  /// Number of undo items holding a data object (key) and memory in kB of
+  /// the data object. The keys are kept alive by UndoItemInfo::DataObjects.
+  std::map< vtkDataObject*, std::pair<int, unsigned long> > UndoDataObjectMemorySizes;
 
   std::list< vtkCollection* >  UndoStack;
   std::list< vtkCollection* >  RedoStack;
@@ -724,6 +847,11 @@ protected:
 
   unsigned long NodeIDsMTime;
 
+  /// Nodes of the scene indexed by the class names they were requested with.
+  /// Nodes are not registered, the \a Nodes collection owns them.
+  std::map< std::string, std::vector<vtkMRMLNode*> > NodesByClass;
+  unsigned long NodesByClassMTime;
+
   void RemoveAllNodes(bool removeSingletons);
 
   char * Version;
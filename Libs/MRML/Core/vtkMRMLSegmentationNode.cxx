@@ -735,6 +735,47 @@ bool vtkMRMLSegmentationNode::GetModifiedSinceRead()
     || this->Segmentation->GetModifiedSinceRead();
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLSegmentationNode::GetUndoDataObjects(std::vector<vtkDataObject*>& dataObjects)
+{
+  // Avoid calling vtkMRMLVolumeNode::GetUndoDataObjects as GetImageData triggers merge
+  if (!this->Segmentation)
+  {
+    return;
+  }
+  vtkSegmentation::SegmentMap segmentMap = this->Segmentation->GetSegments();
+  for (vtkSegmentation::SegmentMap::iterator segmentIt = segmentMap.begin(); segmentIt != segmentMap.end(); ++segmentIt)
+  {
+    std::vector<std::string> representationNames;
+    segmentIt->second->GetContainedRepresentationNames(representationNames);
+    for (std::vector<std::string>::iterator nameIt = representationNames.begin(); nameIt != representationNames.end(); ++nameIt)
+    {
+      vtkDataObject* representation = segmentIt->second->GetRepresentation(*nameIt);
+      if (representation)
+      {
+        dataObjects.push_back(representation);
+      }
+    }
+  }
+}
+
+//---------------------------------------------------------------------------
+unsigned long vtkMRMLSegmentationNode::GetUndoContentMTime()
+{
+  unsigned long mtime = this->Superclass::GetUndoContentMTime();
+  if (!this->Segmentation)
+  {
+    return mtime;
+  }
+  mtime = std::max(mtime, this->Segmentation->GetMTime());
+  vtkSegmentation::SegmentMap segmentMap = this->Segmentation->GetSegments();
+  for (vtkSegmentation::SegmentMap::iterator segmentIt = segmentMap.begin(); segmentIt != segmentMap.end(); ++segmentIt)
+  {
+    mtime = std::max(mtime, segmentIt->second->GetMTime());
+  }
+  return mtime;
+}
+
 //---------------------------------------------------------------------------
 vtkImageData* vtkMRMLSegmentationNode::GetImageData()
 {
@@ -99,6 +99,14 @@ public:
   /// \sa vtkMRMLStorableNode::GetModifiedSinceRead()
   virtual bool GetModifiedSinceRead();
 
+  /// The representations of the segments are the bulk data of the segmentation.
+  /// The merged labelmap is not included, it is generated from the segments.
+  virtual void GetUndoDataObjects(std::vector<vtkDataObject*>& dataObjects);
+
+  /// Reimplemented to take into account the modified time of the segmentation
+  /// and of the segments.
+  virtual unsigned long GetUndoContentMTime();
+
   /// Function called from segmentation logic when UID is added in a subject hierarchy node.
   /// In case the newly added UID is a volume node referenced from this segmentation,
   /// its geometry will be set as image geometry conversion parameter.
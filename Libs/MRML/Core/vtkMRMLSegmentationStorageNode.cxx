@@ -30,6 +30,7 @@
 
 // VTK includes
 #include <vtkMRMLScene.h>
+#include <vtkCommand.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkDataObject.h>
@@ -40,6 +41,7 @@
 #include <vtkMultiBlockDataSet.h>
 #include <vtkXMLMultiBlockDataWriter.h>
 #include <vtkXMLMultiBlockDataReader.h>
+#include <vtkZLibDataCompressor.h>
 #include <vtksys/SystemTools.hxx>
 #include <vtkInformation.h>
 #include <vtkInformationIntegerVectorKey.h>
@@ -248,6 +250,34 @@ int vtkMRMLSegmentationStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
   }
 
+  // Use the segmentation decoded by ReadDataInThread() if it is for the same file
+  vtkSmartPointer<vtkSegmentation> prefetchedSegmentation =
+    vtkSegmentation::SafeDownCast(this->TakePrefetchedData());
+  if (prefetchedSegmentation.GetPointer())
+  {
+    vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+    if (!segmentation || segmentation->GetNumberOfSegments() > 0)
+    {
+      vtkErrorMacro("ReadDataInternal: Output segmentation must exist and must be empty!");
+      return 0;
+    }
+    // Move the decoded segments, the node is notified about each added segment
+    segmentation->SetMasterRepresentationName(prefetchedSegmentation->GetMasterRepresentationName());
+    segmentation->CopyConversionParameters(prefetchedSegmentation);
+    std::vector<std::string> segmentIDs;
+    prefetchedSegmentation->GetSegmentIDs(segmentIDs);
+    for (std::vector<std::string>::iterator segmentIdIt = segmentIDs.begin(); segmentIdIt != segmentIDs.end(); ++segmentIdIt)
+    {
+      segmentation->AddSegment(prefetchedSegmentation->GetSegment(*segmentIdIt), *segmentIdIt);
+    }
+    const char* masterRepresentation = segmentation->GetMasterRepresentationName();
+    if (masterRepresentation && strcmp(masterRepresentation, vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()))
+    {
+      this->AddPolyDataFileNames(fullName, segmentation);
+    }
+    return 1;
+  }
+
   // Try to read as labelmap first then as poly data
   if (this->ReadBinaryLabelmapRepresentation(segmentationNode->GetSegmentation(), fullName))
   {
@@ -255,6 +285,7 @@ int vtkMRMLSegmentationStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   }
   else if (this->ReadPolyDataRepresentation(segmentationNode->GetSegmentation(), fullName))
   {
+    this->AddPolyDataFileNames(fullName, segmentationNode->GetSegmentation());
     return 1;
   }
 
@@ -263,6 +294,36 @@ int vtkMRMLSegmentationStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   return 0;
 }
 
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkObject> vtkMRMLSegmentationStorageNode::ReadDataInThread(vtkMRMLNode *refNode, vtkCommand* messageObserver)
+{
+  if (!refNode || !this->CanReadInReferenceNode(refNode))
+  {
+    return NULL;
+  }
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty() || !vtksys::SystemTools::FileExists(fullName.c_str()))
+  {
+    return NULL;
+  }
+
+  // Decode into a segmentation that is not referenced by any MRML node
+  vtkSmartPointer<vtkSegmentation> segmentation = vtkSmartPointer<vtkSegmentation>::New();
+  if (messageObserver)
+  {
+    segmentation->AddObserver(vtkCommand::ErrorEvent, messageObserver);
+    segmentation->AddObserver(vtkCommand::WarningEvent, messageObserver);
+  }
+  if ( !this->ReadBinaryLabelmapRepresentation(segmentation, fullName)
+    && !this->ReadPolyDataRepresentation(segmentation, fullName, messageObserver) )
+  {
+    // Read again by ReadDataInternal(), which reports the error
+    return NULL;
+  }
+  segmentation->RemoveObserver(messageObserver);
+  return segmentation;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLSegmentationStorageNode::ReadBinaryLabelmapRepresentation(vtkSegmentation* segmentation, std::string path)
 {
@@ -433,7 +494,7 @@ int vtkMRMLSegmentationStorageNode::ReadBinaryLabelmapRepresentation(vtkSegmenta
 }
 
 //----------------------------------------------------------------------------
-int vtkMRMLSegmentationStorageNode::ReadPolyDataRepresentation(vtkSegmentation* segmentation, std::string path)
+int vtkMRMLSegmentationStorageNode::ReadPolyDataRepresentation(vtkSegmentation* segmentation, std::string path, vtkCommand* messageObserver/*=NULL*/)
 {
   if (!vtksys::SystemTools::FileExists(path.c_str()))
   {
@@ -448,11 +509,13 @@ int vtkMRMLSegmentationStorageNode::ReadPolyDataRepresentation(vtkSegmentation*
     return 0;
   }
 
-  // Add all files to storage node (multiblock dataset writes segments to individual files in a separate folder)
-  this->AddPolyDataFileNames(path, segmentation);
-
   // Read multiblock dataset from disk
   vtkSmartPointer<vtkXMLMultiBlockDataReader> reader = vtkSmartPointer<vtkXMLMultiBlockDataReader>::New();
+  if (messageObserver)
+  {
+    reader->AddObserver(vtkCommand::ErrorEvent, messageObserver);
+    reader->AddObserver(vtkCommand::WarningEvent, messageObserver);
+  }
   reader->SetFileName(path.c_str());
   reader->Update();
   vtkMultiBlockDataSet* multiBlockDataset = vtkMultiBlockDataSet::SafeDownCast(reader->GetOutput());
@@ -917,6 +980,11 @@ int vtkMRMLSegmentationStorageNode::WritePolyDataRepresentation(vtkSegmentation*
   {
     writer->SetDataModeToBinary();
     writer->SetCompressorTypeToZLib();
+    vtkZLibDataCompressor* compressor = vtkZLibDataCompressor::SafeDownCast(writer->GetCompressor());
+    if (compressor && this->CompressionLevel >= 0)
+    {
+      compressor->SetCompressionLevel(this->CompressionLevel);
+    }
   }
   else
   {
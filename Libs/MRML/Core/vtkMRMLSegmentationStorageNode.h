@@ -81,6 +81,11 @@ public:
   /// Reset supported write file types. Called when master representation is changed
   void ResetSupportedWriteFileTypes();
 
+  /// Segmentations are decoded into a standalone vtkSegmentation in worker threads,
+  /// its segments are moved into the segmentation node by ReadData()
+  virtual bool SupportsThreadedRead() { return true; }
+  virtual vtkSmartPointer<vtkObject> ReadDataInThread(vtkMRMLNode* refNode, vtkCommand* messageObserver);
+
 protected:
   /// Initialize all the supported read file types
   virtual void InitializeSupportedReadFileTypes();
@@ -107,7 +112,8 @@ protected:
   virtual int ReadBinaryLabelmapRepresentation(vtkSegmentation* segmentation, std::string path);
 
   /// Read a poly data representation to file
-  virtual int ReadPolyDataRepresentation(vtkSegmentation* segmentation, std::string path);
+  /// \param messageObserver Observer of the warnings and errors of the reader, if not NULL
+  virtual int ReadPolyDataRepresentation(vtkSegmentation* segmentation, std::string path, vtkCommand* messageObserver=NULL);
 
   /// Add all files corresponding to poly data representation to the storage node
   /// (multiblock dataset writes segments to individual files in a separate folder)
@@ -44,6 +44,7 @@ vtkMRMLStorageNode::vtkMRMLStorageNode()
   this->URI = NULL;
   this->URIHandler = NULL;
   this->UseCompression = 1;
+  this->CompressionLevel = -1;
   this->ReadState = this->Idle;
   this->WriteState = this->Idle;
   this->URIHandler = NULL;
@@ -183,6 +184,7 @@ void vtkMRMLStorageNode::WriteXML(ostream& of, int nIndent)
   std::stringstream ss;
   ss << this->UseCompression;
   of << indent << " useCompression=\"" << ss.str() << "\"";
+  of << indent << " compressionLevel=\"" << this->CompressionLevel << "\"";
 
   of << indent << " readState=\"" << this->ReadState <<  "\"";
   of << indent << " writeState=\"" << this->WriteState <<  "\"";
@@ -293,6 +295,14 @@ void vtkMRMLStorageNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->UseCompression;
       }
+    else if (!strcmp(attName, "compressionLevel"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      int level = -1;
+      ss >> level;
+      this->SetCompressionLevel(level);
+      }
     else if (!strcmp(attName, "readState"))
       {
       std::stringstream ss;
@@ -328,6 +338,7 @@ void vtkMRMLStorageNode::Copy(vtkMRMLNode *anode)
     this->AddURI(node->GetNthURI(i));
     }
   this->SetUseCompression(node->UseCompression);
+  this->SetCompressionLevel(node->CompressionLevel);
   this->SetReadState(node->ReadState);
   this->SetWriteState(node->WriteState);
 
@@ -353,6 +364,7 @@ void vtkMRMLStorageNode::PrintSelf(ostream& os, vtkIndent indent)
     os << indent << "URIListMember: " << this->GetNthURI(i) << "\n";
     }
   os << indent << "UseCompression:   " << this->UseCompression << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
   os << indent << "ReadState:  " << this->GetReadStateAsString() << "\n";
   os << indent << "WriteState: " << this->GetWriteStateAsString() << "\n";
   os << indent << "SupportedWriteFileTypes: \n";
@@ -1112,6 +1124,57 @@ int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
   return res;
 }
 
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkObject> vtkMRMLStorageNode::ReadDataInThread(
+  vtkMRMLNode* vtkNotUsed(refNode), vtkCommand* vtkNotUsed(messageObserver))
+{
+  return NULL;
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLStorageNode::SetPrefetchedData(vtkObject* data)
+{
+  this->PrefetchedData = data;
+  this->PrefetchedFileName = data ? this->GetFullNameFromFileName() : std::string();
+}
+
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkObject> vtkMRMLStorageNode::TakePrefetchedData()
+{
+  vtkSmartPointer<vtkObject> data;
+  if (this->PrefetchedData.GetPointer() &&
+      this->PrefetchedFileName == this->GetFullNameFromFileName())
+    {
+    data = this->PrefetchedData;
+    }
+  this->PrefetchedData = NULL;
+  this->PrefetchedFileName.clear();
+  return data;
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::WriteDataInThread(vtkMRMLNode* refNode,
+                                          vtkCommand* vtkNotUsed(messageObserver))
+{
+  if (refNode == NULL || !this->SupportsThreadedWrite() ||
+      !this->CanWriteFromReferenceNode(refNode))
+    {
+    return 0;
+    }
+  return this->WriteDataInternal(refNode);
+}
+
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::FinishThreadedWrite(vtkMRMLNode* refNode, int writeResult)
+{
+  if (writeResult)
+    {
+    this->StageWriteData(refNode);
+    this->StoredTime->Modified();
+    }
+  return writeResult;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::ReadDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
 {
@@ -20,6 +20,8 @@
 class vtkURIHandler;
 
 // VTK includes
+#include <vtkSmartPointer.h>
+class vtkCommand;
 class vtkStringArray;
 
 // STD includes
@@ -57,6 +59,62 @@ public:
   /// NOTE: Subclasses should implement this method
   virtual int WriteData(vtkMRMLNode *refNode);
 
+  ///
+  /// Threaded I/O support, used by vtkDataIOManager to read or write the
+  /// files of independent storable nodes concurrently.
+  /// Storage nodes returning true for SupportsThreadedRead() can decode
+  /// their file(s) with ReadDataInThread() in a worker thread; the decoded
+  /// data is handed back to the storage node with SetPrefetchedData() on the
+  /// main thread and set into the referenced node by the next ReadData() call.
+  /// Storage nodes relying on libraries that are not thread-safe must not
+  /// opt in.
+  /// False by default.
+  /// \sa ReadDataInThread(), vtkDataIOManager::PrefetchLocalData()
+  virtual bool SupportsThreadedRead() { return false; }
+
+  ///
+  /// Decode the file(s) of refNode without modifying any MRML object
+  /// (neither refNode nor this storage node). Can be called from any thread.
+  /// The warnings and errors of the objects created to decode the file must
+  /// be routed to messageObserver (vtkCommand::WarningEvent and
+  /// vtkCommand::ErrorEvent), the caller observes this storage node itself.
+  /// Return the decoded data (e.g. the executed reader), or NULL if
+  /// ReadData() must read the file itself.
+  /// Returns NULL by default.
+  /// \sa SetPrefetchedData()
+  virtual vtkSmartPointer<vtkObject> ReadDataInThread(vtkMRMLNode* refNode,
+                                                      vtkCommand* messageObserver);
+
+  ///
+  /// Keep the data returned by ReadDataInThread() until the next ReadData()
+  /// call, which uses it instead of reading the file if the file name has not
+  /// changed in the meantime. Must be called on the main thread.
+  void SetPrefetchedData(vtkObject* data);
+
+  ///
+  /// Storage nodes returning true for SupportsThreadedWrite() can write
+  /// the data of the referenced node with WriteDataInThread() in a worker
+  /// thread. FinishThreadedWrite() must then be called on the main thread.
+  /// The same restrictions as for SupportsThreadedRead() apply.
+  /// False by default.
+  /// \sa WriteDataInThread(), vtkDataIOManager::WriteLocalData()
+  virtual bool SupportsThreadedWrite() { return false; }
+
+  ///
+  /// Write the data of refNode without modifying any MRML object.
+  /// Can be called from any thread. messageObserver is used as in
+  /// ReadDataInThread().
+  /// By default, calls WriteDataInternal() which is expected to be
+  /// free of MRML modifications if SupportsThreadedWrite() is true.
+  /// Return 1 on success, 0 on failure.
+  virtual int WriteDataInThread(vtkMRMLNode* refNode, vtkCommand* messageObserver);
+
+  ///
+  /// Main thread counterpart of WriteDataInThread(): on success, stage the
+  /// written file and update the stored time as WriteData() does.
+  /// Return writeResult.
+  int FinishThreadedWrite(vtkMRMLNode* refNode, int writeResult);
+
   ///
   /// Write this node's information to a MRML file in XML format.
   virtual void WriteXML(ostream& of, int indent);
@@ -84,6 +142,13 @@ public:
   vtkGetMacro(UseCompression, int);
   vtkSetMacro(UseCompression, int);
 
+  ///
+  /// Compression level used on write when UseCompression is on, from 0
+  /// (fastest) to 9 (smallest file). -1 (default) lets the writer choose.
+  /// Only honored by storage nodes whose writer supports it.
+  vtkSetClampMacro(CompressionLevel, int, -1, 9);
+  vtkGetMacro(CompressionLevel, int);
+
   ///
   /// Location of the remote copy of this file.
   vtkSetStringMacro(URI);
@@ -301,11 +366,17 @@ protected:
   /// location specified by the URI
   void StageWriteData ( vtkMRMLNode *refNode );
 
+  ///
+  /// Return the data set by SetPrefetchedData() if it was decoded from the
+  /// current file name, NULL otherwise. The prefetched data is released.
+  vtkSmartPointer<vtkObject> TakePrefetchedData();
+
   char *FileName;
   char *TempFileName;
   char *URI;
   vtkURIHandler *URIHandler;
   int UseCompression;
+  int CompressionLevel;
   int ReadState;
   int WriteState;
 
@@ -335,6 +406,10 @@ protected:
   /// Can be reset with InvalidateFile.
   /// \sa InvalidateFile
   vtkTimeStamp* StoredTime;
+
+  /// Data decoded by ReadDataInThread() and the file it was decoded from
+  vtkSmartPointer<vtkObject> PrefetchedData;
+  std::string PrefetchedFileName;
 };
 
 #endif
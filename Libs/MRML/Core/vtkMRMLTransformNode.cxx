@@ -23,6 +23,7 @@ Version:   $Revision: 1.14 $
 #include "vtkMRMLTransformDisplayNode.h"
 #include "vtkOrientedBSplineTransform.h"
 #include "vtkOrientedGridTransform.h"
+#include "vtkTransformDisplacementFieldCache.h"
 
 // VTK includes
 #include <vtkCommand.h>
@@ -54,6 +55,8 @@ vtkMRMLTransformNode::vtkMRMLTransformNode()
 
   this->CachedMatrixTransformToParent=vtkMatrix4x4::New();
   this->CachedMatrixTransformFromParent=vtkMatrix4x4::New();
+
+  this->DisplacementFieldCache=NULL;
 }
 
 //----------------------------------------------------------------------------
@@ -66,6 +69,12 @@ vtkMRMLTransformNode::~vtkMRMLTransformNode()
   this->CachedMatrixTransformToParent=NULL;
   this->CachedMatrixTransformFromParent->Delete();
   this->CachedMatrixTransformFromParent=NULL;
+
+  if (this->DisplacementFieldCache)
+    {
+    this->DisplacementFieldCache->Delete();
+    this->DisplacementFieldCache=NULL;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -1106,6 +1115,17 @@ unsigned long vtkMRMLTransformNode::GetTransformToWorldMTime()
   return latestMTime;
 }
 
+//----------------------------------------------------------------------------
+vtkTransformDisplacementFieldCache* vtkMRMLTransformNode::GetDisplacementFieldCache()
+{
+  if (this->DisplacementFieldCache==NULL)
+    {
+    this->DisplacementFieldCache=vtkTransformDisplacementFieldCache::New();
+    this->DisplacementFieldCache->SetTransformNode(this);
+    }
+  return this->DisplacementFieldCache;
+}
+
 //----------------------------------------------------------------------------
 const char* vtkMRMLTransformNode::GetTransformToParentInfo()
 {
@@ -22,6 +22,7 @@ class vtkAbstractTransform;
 class vtkGeneralTransform;
 class vtkMatrix4x4;
 class vtkTransform;
+class vtkTransformDisplacementFieldCache;
 
 /// \brief MRML node for representing a transformation
 /// between this node space and a parent node space.
@@ -300,6 +301,12 @@ public:
   /// Get the latest modification time of the stored transform
   unsigned long GetTransformToWorldMTime();
 
+  /// Displacement field sampled from the transform to world of this node.
+  /// The field is kept with the node and reused by its users until the
+  /// transform to world changes (GetTransformToWorldMTime).
+  /// The cache is created on the first call.
+  vtkTransformDisplacementFieldCache* GetDisplacementFieldCache();
+
   /// Get a human-readable description of the transformation
   /// The returned string is stored in a shared buffer therefore the text has to be copied. This is a
   /// static-style function (the contents of the owner transform node is not used), but the returned
@@ -342,6 +349,8 @@ protected:
   /// GetMatrixTransformToParent and GetMatrixFromParent methods
   vtkMatrix4x4* CachedMatrixTransformToParent;
   vtkMatrix4x4* CachedMatrixTransformFromParent;
+
+  vtkTransformDisplacementFieldCache* DisplacementFieldCache;
 };
 
 #endif
@@ -161,7 +161,8 @@ bool vtkMRMLVolumeArchetypeStorageNode::CanWriteFromReferenceNode(vtkMRMLNode *r
 
 //----------------------------------------------------------------------------
 vtkITKArchetypeImageSeriesReader*
-vtkMRMLVolumeArchetypeStorageNode::InstantiateVectorVolumeReader(const std::string& fullName)
+vtkMRMLVolumeArchetypeStorageNode::InstantiateVectorVolumeReader(const std::string& fullName,
+                                                                 vtkCommand* messageObserver)
 {
 #ifdef MRML_USE_vtkTeem
   //
@@ -173,6 +174,11 @@ vtkMRMLVolumeArchetypeStorageNode::InstantiateVectorVolumeReader(const std::stri
 
   vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader =
       vtkSmartPointer<vtkITKArchetypeImageSeriesVectorReaderSeries>::New();
+  if (messageObserver)
+    {
+    reader->AddObserver(vtkCommand::ErrorEvent, messageObserver);
+    reader->AddObserver(vtkCommand::WarningEvent, messageObserver);
+    }
   reader->SetArchetype(fullName.c_str());
   reader->SetSingleFile( this->GetSingleFile() );
   reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
@@ -190,6 +196,11 @@ vtkMRMLVolumeArchetypeStorageNode::InstantiateVectorVolumeReader(const std::stri
   if ( numberOfFileNames == 1 )
     {
     reader = vtkSmartPointer<vtkITKArchetypeImageSeriesVectorReaderFile>::New();
+    if (messageObserver)
+      {
+      reader->AddObserver(vtkCommand::ErrorEvent, messageObserver);
+      reader->AddObserver(vtkCommand::WarningEvent, messageObserver);
+      }
     reader->SetArchetype(fullName.c_str());
     reader->SetSingleFile( this->GetSingleFile() );
     reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
@@ -213,6 +224,7 @@ vtkMRMLVolumeArchetypeStorageNode::InstantiateVectorVolumeReader(const std::stri
   return reader;
 #else
   (void)fullName;
+  (void)messageObserver;
   return false;
 #endif
 }
@@ -258,6 +270,104 @@ void ApplyImageSeriesReaderWorkaround(vtkMRMLVolumeArchetypeStorageNode * storag
 }
 } // end of anonymous namespace
 
+//----------------------------------------------------------------------------
+vtkITKArchetypeImageSeriesReader* vtkMRMLVolumeArchetypeStorageNode
+::InstantiateReader(vtkMRMLNode* refNode, const std::string& fullName,
+                    vtkCommand* messageObserver)
+{
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+
+  if (refNode->IsA("vtkMRMLVectorVolumeNode"))
+    {
+    reader.TakeReference(this->InstantiateVectorVolumeReader(fullName, messageObserver));
+    }
+  else if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+    {
+    reader = vtkSmartPointer<vtkITKArchetypeDiffusionTensorImageReaderFile>::New();
+    reader->SetSingleFile( this->GetSingleFile() );
+    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+    }
+  else
+    {
+    reader = vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
+    reader->SetSingleFile( this->GetSingleFile() );
+    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+    }
+
+  if (reader.GetPointer() == NULL)
+    {
+    return 0;
+    }
+
+  // the vector volume reader observes the messages since it is created
+  if (messageObserver && !reader->HasObserver(vtkCommand::ErrorEvent, messageObserver))
+    {
+    reader->AddObserver(vtkCommand::ErrorEvent, messageObserver);
+    reader->AddObserver(vtkCommand::WarningEvent, messageObserver);
+    }
+
+  // Set the list of file names on the reader
+  reader->ResetFileNames();
+  reader->SetArchetype(fullName.c_str());
+
+  // Workaround
+  ApplyImageSeriesReaderWorkaround(this, reader, fullName);
+
+  // Center image
+  reader->SetOutputScalarTypeToNative();
+  reader->SetDesiredCoordinateOrientationToNative();
+  if (this->CenterImage)
+    {
+    reader->SetUseNativeOriginOff();
+    }
+  else
+    {
+    reader->SetUseNativeOriginOn();
+    }
+
+  reader->Register(0);
+  return reader;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkObject> vtkMRMLVolumeArchetypeStorageNode::ReadDataInThread(
+  vtkMRMLNode* refNode, vtkCommand* messageObserver)
+{
+  if (vtkMRMLScalarVolumeNode::SafeDownCast(refNode) == NULL ||
+      !this->CanReadInReferenceNode(refNode))
+    {
+    return NULL;
+    }
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty())
+    {
+    return NULL;
+    }
+
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+  reader.TakeReference(this->InstantiateReader(refNode, fullName, messageObserver));
+  if (reader.GetPointer() == NULL)
+    {
+    return NULL;
+    }
+  try
+    {
+    reader->Update();
+    }
+  catch (...)
+    {
+    // read again by ReadDataInternal(), which reports the error
+    return NULL;
+    }
+  if (reader->GetOutput() == NULL || reader->GetOutput()->GetPointData() == NULL)
+    {
+    return NULL;
+    }
+  // the reader may execute again on the main thread
+  reader->RemoveObserver(messageObserver);
+  return reader;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -293,23 +403,12 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
-
-  if (refNode->IsA("vtkMRMLVectorVolumeNode"))
-    {
-    reader.TakeReference(this->InstantiateVectorVolumeReader(fullName));
-    }
-  else if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
-    {
-    reader = vtkSmartPointer<vtkITKArchetypeDiffusionTensorImageReaderFile>::New();
-    reader->SetSingleFile( this->GetSingleFile() );
-    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
-    }
-  else
+  // Use the reader executed by ReadDataInThread() if it is for the same file
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader =
+    vtkITKArchetypeImageSeriesReader::SafeDownCast(this->TakePrefetchedData());
+  if (reader.GetPointer() == NULL)
     {
-    reader = vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
-    reader->SetSingleFile( this->GetSingleFile() );
-    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+    reader.TakeReference(this->InstantiateReader(refNode, fullName));
     }
 
   if (reader.GetPointer() == NULL)
@@ -325,25 +424,6 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     volNode->SetAndObserveImageData(NULL);
     }
 
-  // Set the list of file names on the reader
-  reader->ResetFileNames();
-  reader->SetArchetype(fullName.c_str());
-
-  // Workaround
-  ApplyImageSeriesReaderWorkaround(this, reader, fullName);
-
-  // Center image
-  reader->SetOutputScalarTypeToNative();
-  reader->SetDesiredCoordinateOrientationToNative();
-  if (this->CenterImage)
-    {
-    reader->SetUseNativeOriginOff();
-    }
-  else
-    {
-    reader->SetUseNativeOriginOn();
-    }
-
   try
     {
     vtkDebugMacro("ReadData: right before reader update, reader num files = " << reader->GetNumberOfFileNames());
@@ -86,6 +86,12 @@ public:
   /// instance to turn off compression.
   virtual void ConfigureForDataExchange();
 
+  ///
+  /// Volumes are decoded by the ITK readers in worker threads.
+  virtual bool SupportsThreadedRead() { return true; }
+  virtual vtkSmartPointer<vtkObject> ReadDataInThread(vtkMRMLNode* refNode,
+                                                      vtkCommand* messageObserver);
+
 protected:
   vtkMRMLVolumeArchetypeStorageNode();
   ~vtkMRMLVolumeArchetypeStorageNode();
@@ -95,7 +101,15 @@ protected:
   /// Initialize all the supported write file types
   virtual void InitializeSupportedWriteFileTypes();
 
-  vtkITKArchetypeImageSeriesReader* InstantiateVectorVolumeReader(const std::string &fullName);
+  vtkITKArchetypeImageSeriesReader* InstantiateVectorVolumeReader(const std::string &fullName,
+                                                                  vtkCommand* messageObserver = 0);
+
+  /// Create and configure the reader of the file for the reference node type.
+  /// The warnings and errors of the reader are observed by messageObserver
+  /// if not NULL. The caller takes the ownership of the returned reader.
+  vtkITKArchetypeImageSeriesReader* InstantiateReader(vtkMRMLNode* refNode,
+                                                      const std::string &fullName,
+                                                      vtkCommand* messageObserver = 0);
 
   /// Read data and set it in the referenced node
   virtual int ReadDataInternal(vtkMRMLNode *refNode);
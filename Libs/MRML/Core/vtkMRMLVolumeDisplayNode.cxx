@@ -159,10 +159,12 @@ vtkAlgorithmOutput* vtkMRMLVolumeDisplayNode::GetBackgroundImageStencilDataConne
 //----------------------------------------------------------------------------
 vtkImageStencilData* vtkMRMLVolumeDisplayNode::GetBackgroundImageStencilData()
 {
-  vtkAlgorithmOutput* imageConnection = this->GetBackgroundImageStencilDataConnection();
-  vtkAlgorithm* producer = imageConnection ? imageConnection->GetProducer() : 0;
+  vtkAlgorithmOutput* stencilConnection = this->GetBackgroundImageStencilDataConnection();
+  vtkAlgorithm* producer = stencilConnection ? stencilConnection->GetProducer() : 0;
+  // the stencil is usually not the first output of its producer (e.g. the
+  // output port 1 of vtkImageReslice)
   return vtkImageStencilData::SafeDownCast(
-    producer ? producer->GetOutputDataObject(0) : 0);
+    producer ? producer->GetOutputDataObject(stencilConnection->GetIndex()) : 0);
 }
 
 //----------------------------------------------------------------------------
@@ -31,6 +31,7 @@ Version:   $Revision: 1.14 $
 #include <vtkMathUtilities.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
+#include <vtkPointData.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransform.h>
 #include <vtkTrivialProducer.h>
@@ -748,6 +749,55 @@ vtkImageData* vtkMRMLVolumeNode::GetImageData()
       this->ImageDataConnection->GetIndex()) : 0);
 }
 
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeNode::ImageDataRegionModified(int extent[6])
+{
+  vtkImageData* imageData = this->GetImageData();
+  if (!imageData)
+    {
+    return;
+    }
+  int imageExtent[6];
+  imageData->GetExtent(imageExtent);
+  int regionExtent[6];
+  for (int i = 0; i < 3; ++i)
+    {
+    regionExtent[2*i] = std::max(extent[2*i], imageExtent[2*i]);
+    regionExtent[2*i+1] = std::min(extent[2*i+1], imageExtent[2*i+1]);
+    if (regionExtent[2*i] > regionExtent[2*i+1])
+      {
+      // the region is outside of the image
+      return;
+      }
+    }
+  this->InvokeEvent(vtkMRMLVolumeNode::ImageDataRegionModifiedEvent, regionExtent);
+  if (imageData->GetPointData() && imageData->GetPointData()->GetScalars())
+    {
+    imageData->GetPointData()->GetScalars()->Modified();
+    }
+  imageData->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeNode::GetUndoDataObjects(std::vector<vtkDataObject*>& dataObjects)
+{
+  if (this->GetImageData())
+    {
+    dataObjects.push_back(this->GetImageData());
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLVolumeNode::UndoImageRegionRestored(vtkImageData* image, int extent[6])
+{
+  if (image && image == this->GetImageData())
+    {
+    this->ImageDataRegionModified(extent);
+    return;
+    }
+  this->Superclass::UndoImageRegionRestored(image, extent);
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLVolumeNode
 ::SetImageDataConnection(vtkAlgorithmOutput *newImageDataConnection)
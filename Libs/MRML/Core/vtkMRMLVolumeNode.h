@@ -170,11 +170,32 @@ public:
                                    void * /*callData*/ );
 
   /// ImageDataModifiedEvent is generated when image data is changed
+  /// ImageDataRegionModifiedEvent is generated by ImageDataRegionModified(),
+  /// the call data is the modified IJK extent (int[6]).
   enum
     {
-    ImageDataModifiedEvent = 18001
+    ImageDataModifiedEvent = 18001,
+    ImageDataRegionModifiedEvent = 18002
     };
 
+  /// \brief Notify that the voxels of the image data inside the IJK
+  /// \a extent were modified in place (e.g. by a paint brush).
+  ///
+  /// ImageDataRegionModifiedEvent is invoked with the extent (clamped to the
+  /// image extent) as call data, then the scalars and the image data are
+  /// marked as modified (which invokes ImageDataModifiedEvent).
+  /// Unlike calling Modified() on the node, observers that handle
+  /// ImageDataRegionModifiedEvent (e.g. vtkMRMLSliceLayerLogic) can update
+  /// only what depends on the modified region.
+  void ImageDataRegionModified(int extent[6]);
+
+  /// The image data is the bulk data of the volume.
+  virtual void GetUndoDataObjects(std::vector<vtkDataObject*>& dataObjects);
+
+  /// Reimplemented to call ImageDataRegionModified() when the voxels of the
+  /// image data are restored, so that only the restored region is updated.
+  virtual void UndoImageRegionRestored(vtkImageData* image, int extent[6]);
+
   ///
   /// Set/Get the ITK MetaDataDictionary
   void SetMetaDataDictionary( const itk::MetaDataDictionary& );
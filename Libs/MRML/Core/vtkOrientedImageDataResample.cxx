@@ -36,7 +36,175 @@
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkPlaneSource.h>
 #include <vtkAppendPolyData.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkPointData.h>
 
+// STD includes
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+/// Tolerance of the integer tests of the voxel index transform
+const double INTEGER_TOLERANCE = 1e-6;
+
+//----------------------------------------------------------------------------
+struct NearestNeighborResampleJob
+{
+  vtkImageData* Input;
+  vtkImageData* Output;
+  /// Output voxel index to input voxel index transform, first three rows
+  double OutputToInputIjk[3][4];
+  /// Rotation part is an axis permutation and translation is integer
+  bool BlockCopy;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void ResampleNearestNeighborSlices(NearestNeighborResampleJob* job, T*, int firstSlice, int lastSlice)
+{
+  int inputExtent[6] = {0,-1,0,-1,0,-1};
+  job->Input->GetExtent(inputExtent);
+  int outputExtent[6] = {0,-1,0,-1,0,-1};
+  job->Output->GetExtent(outputExtent);
+  int numberOfComponents = job->Input->GetNumberOfScalarComponents();
+  vtkIdType inputIncrements[3] = {0, 0, 0};
+  job->Input->GetIncrements(inputIncrements);
+  vtkIdType outputIncrements[3] = {0, 0, 0};
+  job->Output->GetIncrements(outputIncrements);
+  T* inputBasePtr = static_cast<T*>(job->Input->GetScalarPointer());
+  T* outputBasePtr = static_cast<T*>(job->Output->GetScalarPointer());
+  int rowLength = outputExtent[1] - outputExtent[0] + 1;
+  double (*matrix)[4] = job->OutputToInputIjk;
+
+  for (int k = firstSlice; k <= lastSlice; ++k)
+  {
+    for (int j = outputExtent[2]; j <= outputExtent[3]; ++j)
+    {
+      T* outputPtr = outputBasePtr + (j - outputExtent[2]) * outputIncrements[1] + (k - outputExtent[4]) * outputIncrements[2];
+
+      // Input index of the first voxel of the row, and its step along the row
+      double position[3] = {0.0, 0.0, 0.0};
+      double step[3] = {0.0, 0.0, 0.0};
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        position[axis] = matrix[axis][0] * outputExtent[0] + matrix[axis][1] * j + matrix[axis][2] * k + matrix[axis][3];
+        step[axis] = matrix[axis][0];
+      }
+
+      if (job->BlockCopy)
+      {
+        memset(outputPtr, 0, rowLength * numberOfComponents * sizeof(T));
+
+        // Range of the row that maps into the input extent
+        int firstIndex = 0;
+        int lastIndex = rowLength - 1;
+        int start[3] = {0, 0, 0};
+        int intStep[3] = {0, 0, 0};
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          start[axis] = static_cast<int>(floor(position[axis] + 0.5));
+          intStep[axis] = static_cast<int>(floor(step[axis] + 0.5));
+          if (intStep[axis] == 0)
+          {
+            if (start[axis] < inputExtent[2*axis] || start[axis] > inputExtent[2*axis+1])
+            {
+              lastIndex = -1;
+            }
+          }
+          else if (intStep[axis] > 0)
+          {
+            firstIndex = std::max(firstIndex, inputExtent[2*axis] - start[axis]);
+            lastIndex = std::min(lastIndex, inputExtent[2*axis+1] - start[axis]);
+          }
+          else
+          {
+            firstIndex = std::max(firstIndex, start[axis] - inputExtent[2*axis+1]);
+            lastIndex = std::min(lastIndex, start[axis] - inputExtent[2*axis]);
+          }
+        }
+        if (firstIndex > lastIndex)
+        {
+          continue;
+        }
+
+        T* inputPtr = inputBasePtr;
+        vtkIdType inputStep = 0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          inputPtr += (start[axis] + intStep[axis] * firstIndex - inputExtent[2*axis]) * inputIncrements[axis];
+          inputStep += intStep[axis] * inputIncrements[axis];
+        }
+        outputPtr += firstIndex * numberOfComponents;
+        if (inputStep == numberOfComponents)
+        {
+          // Same row direction in the input, copy the whole row at once
+          memcpy(outputPtr, inputPtr, (lastIndex - firstIndex + 1) * numberOfComponents * sizeof(T));
+        }
+        else
+        {
+          for (int index = firstIndex; index <= lastIndex; ++index, inputPtr += inputStep)
+          {
+            for (int component = 0; component < numberOfComponents; ++component)
+            {
+              *(outputPtr++) = inputPtr[component];
+            }
+          }
+        }
+      }
+      else
+      {
+        for (int index = 0; index < rowLength; ++index)
+        {
+          int inputIndex[3] = {0, 0, 0};
+          bool inside = true;
+          for (int axis = 0; axis < 3; ++axis)
+          {
+            inputIndex[axis] = static_cast<int>(floor(position[axis] + 0.5));
+            inside = inside && inputIndex[axis] >= inputExtent[2*axis] && inputIndex[axis] <= inputExtent[2*axis+1];
+            position[axis] += step[axis];
+          }
+          if (inside)
+          {
+            T* inputPtr = inputBasePtr + (inputIndex[0] - inputExtent[0]) * inputIncrements[0]
+              + (inputIndex[1] - inputExtent[2]) * inputIncrements[1] + (inputIndex[2] - inputExtent[4]) * inputIncrements[2];
+            for (int component = 0; component < numberOfComponents; ++component)
+            {
+              *(outputPtr++) = inputPtr[component];
+            }
+          }
+          else
+          {
+            for (int component = 0; component < numberOfComponents; ++component)
+            {
+              *(outputPtr++) = 0;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ResampleNearestNeighborThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  NearestNeighborResampleJob* job = static_cast<NearestNeighborResampleJob*>(threadInfo->UserData);
+  int* outputExtent = job->Output->GetExtent();
+  int numberOfSlices = outputExtent[5] - outputExtent[4] + 1;
+  int firstSlice = outputExtent[4] + numberOfSlices * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+  int lastSlice = outputExtent[4] + numberOfSlices * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads - 1;
+  switch (job->Input->GetScalarType())
+  {
+    vtkTemplateMacro(ResampleNearestNeighborSlices(job, static_cast<VTK_TT*>(NULL), firstSlice, lastSlice));
+  }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkOrientedImageDataResample);
 
 //----------------------------------------------------------------------------
@@ -90,6 +258,26 @@ bool vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage
   referenceImageToInputImageTransform->Concatenate(inputImageToReferenceImageTransform);
   referenceImageToInputImageTransform->Inverse();
 
+  // Nearest neighbor resampling does not need the reslice pipeline. If the geometries match then the
+  // voxels are block copied, otherwise the voxel index transform selects the block copy or the stepping.
+  if (!linearInterpolation)
+  {
+    vtkSmartPointer<vtkMatrix4x4> referenceToInputIjkMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (!vtkOrientedImageDataResample::DoGeometriesMatch(inputImage, referenceImage))
+    {
+      referenceToInputIjkMatrix->DeepCopy(referenceImageToInputImageTransform->GetMatrix());
+    }
+    vtkSmartPointer<vtkImageData> resampledImage = vtkSmartPointer<vtkImageData>::New();
+    if (vtkOrientedImageDataResample::ResampleImageNearestNeighbor(inputImage, referenceToInputIjkMatrix, unionExtent, resampledImage))
+    {
+      vtkSmartPointer<vtkMatrix4x4> referenceImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      referenceImage->GetImageToWorldMatrix(referenceImageToWorldMatrix);
+      outputImage->ShallowCopy(resampledImage);
+      outputImage->SetGeometryFromImageToWorldMatrix(referenceImageToWorldMatrix);
+      return true;
+    }
+  }
+
   // Create clone for input image that has an identity geometry
   //TODO: Creating a new vtkOrientedImageReslice class would be a better solution on the long run
   vtkSmartPointer<vtkMatrix4x4> identityMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
@@ -261,6 +449,18 @@ bool vtkOrientedImageDataResample::ResampleOrientedImageToReferenceGeometry(vtkO
     return false;
   }
 
+  // Nearest neighbor resampling does not need the reslice pipeline
+  if (!linearInterpolation)
+  {
+    vtkSmartPointer<vtkImageData> resampledImage = vtkSmartPointer<vtkImageData>::New();
+    if (vtkOrientedImageDataResample::ResampleImageNearestNeighbor(inputImage, inputImageToReferenceImageTransform->GetMatrix(), outputExtent, resampledImage))
+    {
+      outputImage->ShallowCopy(resampledImage);
+      outputImage->SetGeometryFromImageToWorldMatrix(referenceToWorldMatrix);
+      return true;
+    }
+  }
+
   // Create clone for input image that has an identity geometry
   //TODO: vtkOrientedImageReslice would be a better solution on the long run
   vtkSmartPointer<vtkMatrix4x4> identityMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
@@ -296,6 +496,85 @@ bool vtkOrientedImageDataResample::ResampleOrientedImageToReferenceGeometry(vtkO
   return true;
 }
 
+//-----------------------------------------------------------------------------
+bool vtkOrientedImageDataResample::ResampleImageNearestNeighbor(vtkImageData* inputImage, vtkMatrix4x4* outputToInputIjkMatrix, int outputExtent[6], vtkImageData* outputImage, int numberOfThreads/*=0*/)
+{
+  if (!inputImage || !inputImage->GetPointData()->GetScalars() || !outputToInputIjkMatrix || !outputImage)
+  {
+    return false;
+  }
+  if ( outputExtent[0] > outputExtent[1] || outputExtent[2] > outputExtent[3] || outputExtent[4] > outputExtent[5] )
+  {
+    return false;
+  }
+
+  NearestNeighborResampleJob job;
+  job.Input = inputImage;
+  job.Output = outputImage;
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int column = 0; column < 4; ++column)
+    {
+      job.OutputToInputIjk[row][column] = outputToInputIjkMatrix->GetElement(row, column);
+    }
+  }
+  job.BlockCopy = vtkOrientedImageDataResample::IsTransformIntegerShiftOrPermutation(outputToInputIjkMatrix);
+
+  outputImage->SetOrigin(0.0, 0.0, 0.0);
+  outputImage->SetSpacing(1.0, 1.0, 1.0);
+  outputImage->SetExtent(outputExtent);
+  outputImage->AllocateScalars(inputImage->GetScalarType(), inputImage->GetNumberOfScalarComponents());
+
+  int numberOfSlices = outputExtent[5] - outputExtent[4] + 1;
+  if (numberOfThreads <= 0)
+  {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+  numberOfThreads = std::max(1, std::min(numberOfThreads, numberOfSlices));
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ResampleNearestNeighborThread, &job);
+  threader->SingleMethodExecute();
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkOrientedImageDataResample::IsTransformIntegerShiftOrPermutation(vtkMatrix4x4* ijkToIjkMatrix)
+{
+  if (!ijkToIjkMatrix)
+  {
+    return false;
+  }
+
+  bool inputAxisUsed[3] = {false, false, false};
+  for (int row = 0; row < 3; ++row)
+  {
+    int numberOfNonZeroElements = 0;
+    for (int column = 0; column < 3; ++column)
+    {
+      double element = ijkToIjkMatrix->GetElement(row, column);
+      if (fabs(element) < INTEGER_TOLERANCE)
+      {
+        continue;
+      }
+      if (fabs(fabs(element) - 1.0) > INTEGER_TOLERANCE || inputAxisUsed[column])
+      {
+        return false;
+      }
+      inputAxisUsed[column] = true;
+      ++numberOfNonZeroElements;
+    }
+    double translation = ijkToIjkMatrix->GetElement(row, 3);
+    if (numberOfNonZeroElements != 1 || fabs(translation - floor(translation + 0.5)) > INTEGER_TOLERANCE)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
 //---------------------------------------------------------------------------
 bool vtkOrientedImageDataResample::IsEqual( const vtkMatrix4x4& lhs, const vtkMatrix4x4& rhs )
 {
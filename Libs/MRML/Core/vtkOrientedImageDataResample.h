@@ -30,6 +30,7 @@
 #include <algorithm>
 
 
+class vtkImageData;
 class vtkOrientedImageData;
 class vtkMatrix4x4;
 class vtkTransform;
@@ -64,6 +65,22 @@ public:
   /// \return Success flag
   static bool ResampleOrientedImageToReferenceOrientedImage(vtkOrientedImageData* inputImage, vtkOrientedImageData* referenceImage, vtkOrientedImageData* outputImage, bool linearInterpolation=false, bool padImage=false);
 
+  /// Resample image data with nearest neighbor interpolation, without the vtkImageReslice pipeline.
+  /// If the voxel index transform is an integer shift or an axis permutation (IsTransformIntegerShiftOrPermutation)
+  /// then the voxels are block copied, otherwise the input index is stepped incrementally along the output rows.
+  /// The output slices are split between the threads. Output voxels that map outside the input are 0.
+  /// \param inputImage Image to resample, its origin and spacing are ignored
+  /// \param outputToInputIjkMatrix Linear transform from the output voxel indices to the input voxel indices
+  /// \param outputExtent Extent of the output image
+  /// \param outputImage Output image, it has the scalar type and components of the input, origin 0 and spacing 1
+  /// \param numberOfThreads Number of threads, 0 uses the default number of threads of vtkMultiThreader
+  /// \return Success flag
+  static bool ResampleImageNearestNeighbor(vtkImageData* inputImage, vtkMatrix4x4* outputToInputIjkMatrix, int outputExtent[6], vtkImageData* outputImage, int numberOfThreads=0);
+
+  /// Determine if a voxel index transform maps voxels to voxels: its rotation part is an axis permutation
+  /// with optional flips and its translation is integer.
+  static bool IsTransformIntegerShiftOrPermutation(vtkMatrix4x4* ijkToIjkMatrix);
+
   /// Transform an oriented image data using a transform that can be linear or non-linear.
   /// Linear: simply multiply the geometry matrix with the applied matrix, extent stays the same
   /// Non-linear: calculate new extents and change only the extents when applying deformable transform
@@ -0,0 +1,750 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SegmentationCore includes
+#include "vtkParallelLabelmapToSurfaceFilter.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkMarchingCubes.h>
+#include <vtkMath.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkQuadricDecimation.h>
+#include <vtkSimpleCriticalSection.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace
+{
+/// Below this number of points per thread the smoothing iterations run serially
+const vtkIdType MINIMUM_NUMBER_OF_POINTS_PER_THREAD = 4096;
+
+//----------------------------------------------------------------------------
+/// In-plane coordinates of a point of a slice shared by two slabs. Both slabs interpolate
+/// them from the same voxels so they are bitwise equal, only Z may differ in the last bit.
+struct PointKey
+{
+  double X[3];
+  bool operator<(const PointKey& other) const
+  {
+    if (this->X[1] != other.X[1])
+    {
+      return this->X[1] < other.X[1];
+    }
+    return this->X[0] < other.X[0];
+  }
+};
+
+//----------------------------------------------------------------------------
+struct SlabJobList
+{
+  std::vector<vtkMarchingCubes*> MarchingCubes;
+  vtkSimpleCriticalSection Lock;
+  size_t NextSlab;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ExtractSlabsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SlabJobList* jobList = static_cast<SlabJobList*>(threadInfo->UserData);
+  while (true)
+  {
+    jobList->Lock.Lock();
+    size_t slabIndex = jobList->NextSlab++;
+    jobList->Lock.Unlock();
+    if (slabIndex >= jobList->MarchingCubes.size())
+    {
+      break;
+    }
+    // Each slab has its own pipeline, nothing is shared between the threads
+    jobList->MarchingCubes[slabIndex]->Update();
+  }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// One iteration of the windowed sinc filter: Next = 2*Current + Laplacian(Current) - Previous
+/// (Next = Current + Laplacian(Current)/2 for the first iteration), and Result += Coefficient * Next.
+struct SmoothingIteration
+{
+  vtkIdType NumberOfPoints;
+  /// Neighbors of the point i are Neighbors[NeighborStarts[i]] to Neighbors[NeighborStarts[i+1]-1]
+  const vtkIdType* NeighborStarts;
+  const vtkIdType* Neighbors;
+  const double* Previous;
+  const double* Current;
+  double* Next;
+  double* Result;
+  bool FirstIteration;
+  /// Coefficient of Current, only used in the first iteration
+  double CurrentCoefficient;
+  double NextCoefficient;
+};
+
+//----------------------------------------------------------------------------
+void SmoothPoints(const SmoothingIteration& iteration, vtkIdType firstPoint, vtkIdType lastPoint)
+{
+  for (vtkIdType pointId = firstPoint; pointId < lastPoint; ++pointId)
+  {
+    const double* current = iteration.Current + 3 * pointId;
+    double laplacian[3] = {0.0, 0.0, 0.0};
+    vtkIdType numberOfNeighbors = iteration.NeighborStarts[pointId + 1] - iteration.NeighborStarts[pointId];
+    if (numberOfNeighbors > 0)
+    {
+      for (vtkIdType i = iteration.NeighborStarts[pointId]; i < iteration.NeighborStarts[pointId + 1]; ++i)
+      {
+        const double* neighbor = iteration.Current + 3 * iteration.Neighbors[i];
+        laplacian[0] += neighbor[0];
+        laplacian[1] += neighbor[1];
+        laplacian[2] += neighbor[2];
+      }
+      for (int c = 0; c < 3; ++c)
+      {
+        laplacian[c] = laplacian[c] / numberOfNeighbors - current[c];
+      }
+    }
+
+    double* next = iteration.Next + 3 * pointId;
+    double* result = iteration.Result + 3 * pointId;
+    for (int c = 0; c < 3; ++c)
+    {
+      if (iteration.FirstIteration)
+      {
+        next[c] = current[c] + 0.5 * laplacian[c];
+        result[c] = iteration.CurrentCoefficient * current[c] + iteration.NextCoefficient * next[c];
+      }
+      else
+      {
+        next[c] = 2.0 * current[c] + laplacian[c] - iteration.Previous[3 * pointId + c];
+        result[c] += iteration.NextCoefficient * next[c];
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE SmoothPointsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  const SmoothingIteration* iteration = static_cast<const SmoothingIteration*>(threadInfo->UserData);
+  vtkIdType firstPoint = iteration->NumberOfPoints * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+  vtkIdType lastPoint = iteration->NumberOfPoints * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads;
+  SmoothPoints(*iteration, firstPoint, lastPoint);
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//----------------------------------------------------------------------------
+class vtkParallelLabelmapToSurfaceFilter::vtkInternal
+{
+public:
+  vtkInternal()
+  {
+    this->IsoValue = 0.0;
+    this->RegionPending = false;
+    this->AllSlabsModified = false;
+    this->ScalarsObserverTag = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+      this->Extent[2*i] = 0;
+      this->Extent[2*i+1] = -1;
+      this->Origin[i] = 0.0;
+      this->Spacing[i] = 1.0;
+    }
+  }
+
+  /// True if the slab surfaces were extracted from the same voxels with the same slabs
+  bool CanReuseSlabs(vtkDataArray* scalars, int extent[6], double origin[3], double spacing[3],
+    double isoValue, const std::vector<int>& slabStarts)
+  {
+    if (this->Scalars.GetPointer() != scalars || this->AllSlabsModified || this->IsoValue != isoValue
+      || this->SlabStarts != slabStarts || this->SlabSurfaces.size() + 1 != slabStarts.size())
+    {
+      return false;
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+      if (this->Extent[2*i] != extent[2*i] || this->Extent[2*i+1] != extent[2*i+1]
+        || this->Origin[i] != origin[i] || this->Spacing[i] != spacing[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// First slice of each slab, followed by the last slice of the last slab
+  std::vector<int> SlabStarts;
+  /// Marching cubes surface of each slab
+  std::vector<vtkSmartPointer<vtkPolyData> > SlabSurfaces;
+  /// Slabs that intersect a region modified since the last update
+  std::vector<bool> ModifiedSlabs;
+
+  /// Input the slab surfaces are extracted from
+  vtkWeakPointer<vtkDataArray> Scalars;
+  int Extent[6];
+  double Origin[3];
+  double Spacing[3];
+  double IsoValue;
+
+  /// A region is reported and the scalars are not modified yet
+  bool RegionPending;
+  /// The scalars are modified without a reported region
+  bool AllSlabsModified;
+
+  vtkSmartPointer<vtkCallbackCommand> ScalarsCallbackCommand;
+  unsigned long ScalarsObserverTag;
+};
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkParallelLabelmapToSurfaceFilter);
+
+//----------------------------------------------------------------------------
+vtkParallelLabelmapToSurfaceFilter::vtkParallelLabelmapToSurfaceFilter()
+{
+  this->InputLabelmap = NULL;
+  this->Output = vtkPolyData::New();
+  this->IsoValue = 0.5;
+  this->DecimationFactor = 0.0;
+  this->SmoothingFactor = 0.0;
+  this->NumberOfSmoothingIterations = 20;
+  this->NumberOfThreads = 0;
+  this->MinimumSlabThickness = 16;
+  this->NumberOfExtractedSlabs = 0;
+  this->Internal = new vtkInternal;
+  this->Internal->ScalarsCallbackCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+  this->Internal->ScalarsCallbackCommand->SetClientData(reinterpret_cast<void *>(this));
+  this->Internal->ScalarsCallbackCommand->SetCallback(vtkParallelLabelmapToSurfaceFilter::OnScalarsModified);
+}
+
+//----------------------------------------------------------------------------
+vtkParallelLabelmapToSurfaceFilter::~vtkParallelLabelmapToSurfaceFilter()
+{
+  this->SetInputLabelmap(NULL);
+  if (this->Output)
+  {
+    this->Output->Delete();
+    this->Output = NULL;
+  }
+  this->SetObservedScalars(NULL);
+  delete this->Internal;
+  this->Internal = NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkParallelLabelmapToSurfaceFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "InputLabelmap: " << this->InputLabelmap << "\n";
+  os << indent << "IsoValue: " << this->IsoValue << "\n";
+  os << indent << "DecimationFactor: " << this->DecimationFactor << "\n";
+  os << indent << "SmoothingFactor: " << this->SmoothingFactor << "\n";
+  os << indent << "NumberOfSmoothingIterations: " << this->NumberOfSmoothingIterations << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "MinimumSlabThickness: " << this->MinimumSlabThickness << "\n";
+  os << indent << "NumberOfExtractedSlabs: " << this->NumberOfExtractedSlabs << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkParallelLabelmapToSurfaceFilter::GetOutput()
+{
+  return this->Output;
+}
+
+//----------------------------------------------------------------------------
+void vtkParallelLabelmapToSurfaceFilter::InputRegionModified(int extent[6])
+{
+  vtkInternal* internal = this->Internal;
+  if (internal->SlabSurfaces.empty())
+  {
+    // Nothing is kept, all the slabs are extracted anyway
+    return;
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    if (extent[2*i] > internal->Extent[2*i+1] || extent[2*i+1] < internal->Extent[2*i]
+      || extent[2*i] > extent[2*i+1])
+    {
+      // The region is outside of the labelmap, the voxels are not modified
+      return;
+    }
+  }
+  // A voxel of a slice shared by two slabs is in both slabs
+  for (size_t slabIndex = 0; slabIndex < internal->SlabSurfaces.size(); ++slabIndex)
+  {
+    if (internal->SlabStarts[slabIndex] <= extent[5] && internal->SlabStarts[slabIndex + 1] >= extent[4])
+    {
+      internal->ModifiedSlabs[slabIndex] = true;
+    }
+  }
+  internal->RegionPending = true;
+}
+
+//----------------------------------------------------------------------------
+void vtkParallelLabelmapToSurfaceFilter::ClearSlabSurfaces()
+{
+  this->SetObservedScalars(NULL);
+  this->Internal->SlabStarts.clear();
+  this->Internal->SlabSurfaces.clear();
+  this->Internal->ModifiedSlabs.clear();
+  this->Internal->RegionPending = false;
+  this->Internal->AllSlabsModified = false;
+}
+
+//----------------------------------------------------------------------------
+void vtkParallelLabelmapToSurfaceFilter::SetObservedScalars(vtkDataArray* scalars)
+{
+  vtkInternal* internal = this->Internal;
+  if (internal->Scalars.GetPointer() == scalars)
+  {
+    return;
+  }
+  if (internal->Scalars)
+  {
+    internal->Scalars->RemoveObserver(internal->ScalarsObserverTag);
+  }
+  internal->Scalars = scalars;
+  internal->ScalarsObserverTag = 0;
+  if (scalars)
+  {
+    internal->ScalarsObserverTag = scalars->AddObserver(vtkCommand::ModifiedEvent, internal->ScalarsCallbackCommand);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkParallelLabelmapToSurfaceFilter::OnScalarsModified(vtkObject* vtkNotUsed(caller),
+  unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+{
+  vtkParallelLabelmapToSurfaceFilter* self = reinterpret_cast<vtkParallelLabelmapToSurfaceFilter*>(clientData);
+  if (!self)
+  {
+    return;
+  }
+  if (self->Internal->RegionPending)
+  {
+    // Modification of the reported region, its slabs are already marked
+    self->Internal->RegionPending = false;
+  }
+  else
+  {
+    self->Internal->AllSlabsModified = true;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vtkParallelLabelmapToSurfaceFilter::Update()
+{
+  this->Output->Initialize();
+  if (!this->InputLabelmap)
+  {
+    vtkErrorMacro("Update: Invalid input labelmap!");
+    return false;
+  }
+
+  int numberOfThreads = this->NumberOfThreads;
+  if (numberOfThreads <= 0)
+  {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+
+  if (!this->ExtractSurface(numberOfThreads))
+  {
+    return false;
+  }
+
+  // Quadric decimation needs the whole surface, decimating the slabs separately would
+  // leave their seams at full resolution and could open the surface
+  if (this->DecimationFactor > 0.0)
+  {
+    vtkSmartPointer<vtkQuadricDecimation> decimator = vtkSmartPointer<vtkQuadricDecimation>::New();
+    decimator->SetInputData(this->Output);
+    decimator->SetTargetReduction(this->DecimationFactor);
+    try
+    {
+      decimator->Update();
+    }
+    catch(...)
+    {
+      vtkErrorMacro("Update: Error decimating model");
+      return false;
+    }
+    this->Output->ShallowCopy(decimator->GetOutput());
+  }
+
+  if (this->SmoothingFactor > 0.0 && this->NumberOfSmoothingIterations > 0)
+  {
+    this->SmoothSurface(numberOfThreads);
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkParallelLabelmapToSurfaceFilter::ExtractSurface(int numberOfThreads)
+{
+  vtkImageData* labelmap = this->InputLabelmap;
+  vtkDataArray* scalars = labelmap->GetPointData()->GetScalars();
+  int extent[6] = {0,-1,0,-1,0,-1};
+  labelmap->GetExtent(extent);
+  if (!scalars || extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+  {
+    vtkErrorMacro("ExtractSurface: Empty input labelmap!");
+    return false;
+  }
+
+  // Slabs share their boundary slice, so that the cubes between two slabs are not lost
+  int numberOfCellSlices = extent[5] - extent[4];
+  int numberOfSlabs = std::min(numberOfThreads, numberOfCellSlices / std::max(this->MinimumSlabThickness, 1));
+  numberOfSlabs = std::max(numberOfSlabs, 1);
+
+  std::vector<int> slabStarts(numberOfSlabs + 1);
+  for (int slabIndex = 0; slabIndex <= numberOfSlabs; ++slabIndex)
+  {
+    slabStarts[slabIndex] = extent[4] + numberOfCellSlices * slabIndex / numberOfSlabs;
+  }
+
+  double origin[3] = {0.0, 0.0, 0.0};
+  double spacing[3] = {1.0, 1.0, 1.0};
+  labelmap->GetOrigin(origin);
+  labelmap->GetSpacing(spacing);
+
+  // Only the modified slabs are extracted if the surfaces of the others are up to date
+  vtkInternal* internal = this->Internal;
+  if (!internal->CanReuseSlabs(scalars, extent, origin, spacing, this->IsoValue, slabStarts))
+  {
+    internal->SlabSurfaces.assign(numberOfSlabs, vtkSmartPointer<vtkPolyData>());
+    internal->ModifiedSlabs.assign(numberOfSlabs, true);
+  }
+
+  // The slab images point to the voxels of the labelmap, nothing is copied
+  std::vector<vtkSmartPointer<vtkMarchingCubes> > marchingCubes(numberOfSlabs);
+  vtkIdType sliceSize = static_cast<vtkIdType>(extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1)
+    * scalars->GetNumberOfComponents();
+  SlabJobList jobList;
+  jobList.NextSlab = 0;
+  for (int slabIndex = 0; slabIndex < numberOfSlabs; ++slabIndex)
+  {
+    if (!internal->ModifiedSlabs[slabIndex] && internal->SlabSurfaces[slabIndex])
+    {
+      continue;
+    }
+    int slabStart = slabStarts[slabIndex];
+    int slabEnd = slabStarts[slabIndex + 1];
+
+    vtkSmartPointer<vtkDataArray> slabScalars = vtkSmartPointer<vtkDataArray>::Take(scalars->NewInstance());
+    slabScalars->SetNumberOfComponents(scalars->GetNumberOfComponents());
+    slabScalars->SetVoidArray(labelmap->GetScalarPointer(extent[0], extent[2], slabStart),
+      sliceSize * (slabEnd - slabStart + 1), 1);
+
+    vtkSmartPointer<vtkImageData> slabImage = vtkSmartPointer<vtkImageData>::New();
+    slabImage->SetOrigin(labelmap->GetOrigin());
+    slabImage->SetSpacing(labelmap->GetSpacing());
+    slabImage->SetExtent(extent[0], extent[1], extent[2], extent[3], slabStart, slabEnd);
+    slabImage->GetPointData()->SetScalars(slabScalars);
+
+    marchingCubes[slabIndex] = vtkSmartPointer<vtkMarchingCubes>::New();
+    marchingCubes[slabIndex]->SetInputData(slabImage);
+    marchingCubes[slabIndex]->SetNumberOfContours(1);
+    marchingCubes[slabIndex]->SetValue(0, this->IsoValue);
+    marchingCubes[slabIndex]->ComputeScalarsOff();
+    marchingCubes[slabIndex]->ComputeGradientsOff();
+    marchingCubes[slabIndex]->ComputeNormalsOff();
+    jobList.MarchingCubes.push_back(marchingCubes[slabIndex].GetPointer());
+  }
+
+  int numberOfJobs = static_cast<int>(jobList.MarchingCubes.size());
+  try
+  {
+    if (numberOfJobs == 1)
+    {
+      jobList.MarchingCubes[0]->Update();
+    }
+    else if (numberOfJobs > 1)
+    {
+      vtkNew<vtkMultiThreader> threader;
+      threader->SetNumberOfThreads(numberOfJobs);
+      threader->SetSingleMethod(ExtractSlabsThread, &jobList);
+      threader->SingleMethodExecute();
+    }
+  }
+  catch(...)
+  {
+    vtkErrorMacro("ExtractSurface: Error while running marching cubes!");
+    this->ClearSlabSurfaces();
+    return false;
+  }
+
+  // Keep the slab surfaces for the next update
+  for (int slabIndex = 0; slabIndex < numberOfSlabs; ++slabIndex)
+  {
+    if (marchingCubes[slabIndex])
+    {
+      // Detached from the pipeline, the surface must not keep the slab image
+      internal->SlabSurfaces[slabIndex] = vtkSmartPointer<vtkPolyData>::New();
+      internal->SlabSurfaces[slabIndex]->ShallowCopy(marchingCubes[slabIndex]->GetOutput());
+    }
+  }
+  internal->ModifiedSlabs.assign(numberOfSlabs, false);
+  internal->SlabStarts = slabStarts;
+  labelmap->GetExtent(internal->Extent);
+  labelmap->GetOrigin(internal->Origin);
+  labelmap->GetSpacing(internal->Spacing);
+  internal->IsoValue = this->IsoValue;
+  internal->RegionPending = false;
+  internal->AllSlabsModified = false;
+  this->SetObservedScalars(scalars);
+  this->NumberOfExtractedSlabs = numberOfJobs;
+
+  // Stitch the slabs: the points of the first slice of a slab are merged with
+  // the points of the last slice of the previous slab
+  // Only the points of the shared slice are candidates, the points interpolated on the edges
+  // along K are never that close to a slice unless the voxel value is the iso value
+  double seamTolerance = 1e-3 * fabs(spacing[2]);
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+  std::map<PointKey, vtkIdType> previousSeamPoints;
+  for (int slabIndex = 0; slabIndex < numberOfSlabs; ++slabIndex)
+  {
+    vtkPolyData* slabSurface = internal->SlabSurfaces[slabIndex];
+    double lowerSeamZ = origin[2] + spacing[2] * slabStarts[slabIndex];
+    double upperSeamZ = origin[2] + spacing[2] * slabStarts[slabIndex + 1];
+    bool lastSlab = (slabIndex == numberOfSlabs - 1);
+
+    vtkIdType numberOfSlabPoints = slabSurface->GetNumberOfPoints();
+    std::vector<vtkIdType> pointIds(numberOfSlabPoints);
+    std::map<PointKey, vtkIdType> seamPoints;
+    for (vtkIdType slabPointId = 0; slabPointId < numberOfSlabPoints; ++slabPointId)
+    {
+      PointKey key;
+      slabSurface->GetPoint(slabPointId, key.X);
+      vtkIdType pointId = -1;
+      if (slabIndex > 0 && fabs(key.X[2] - lowerSeamZ) < seamTolerance)
+      {
+        std::map<PointKey, vtkIdType>::iterator seamPointIt = previousSeamPoints.find(key);
+        if (seamPointIt != previousSeamPoints.end())
+        {
+          pointId = seamPointIt->second;
+        }
+      }
+      if (pointId < 0)
+      {
+        pointId = points->InsertNextPoint(key.X);
+      }
+      if (!lastSlab && fabs(key.X[2] - upperSeamZ) < seamTolerance)
+      {
+        seamPoints[key] = pointId;
+      }
+      pointIds[slabPointId] = pointId;
+    }
+
+    vtkCellArray* slabPolys = slabSurface->GetPolys();
+    vtkIdType numberOfCellPoints = 0;
+    vtkIdType* cellPointIds = NULL;
+    for (slabPolys->InitTraversal(); slabPolys->GetNextCell(numberOfCellPoints, cellPointIds); )
+    {
+      polys->InsertNextCell(numberOfCellPoints);
+      for (vtkIdType i = 0; i < numberOfCellPoints; ++i)
+      {
+        polys->InsertCellPoint(pointIds[cellPointIds[i]]);
+      }
+    }
+
+    previousSeamPoints.swap(seamPoints);
+  }
+
+  if (polys->GetNumberOfCells() == 0)
+  {
+    vtkErrorMacro("ExtractSurface: No polygons can be created!");
+    return false;
+  }
+
+  this->Output->SetPoints(points);
+  this->Output->SetPolys(polys);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkParallelLabelmapToSurfaceFilter::ComputeWindowedSincCoefficients(double passBand, int numberOfIterations, double* coefficients)
+{
+  const double pi = vtkMath::Pi();
+  double thetaPassBand = acos(1.0 - 0.5 * passBand);
+
+  // Hamming window
+  std::vector<double> window(numberOfIterations + 1);
+  for (int i = 0; i <= numberOfIterations; ++i)
+  {
+    window[i] = 0.54 + 0.46 * cos(i * pi / (numberOfIterations + 1));
+  }
+
+  // Newton search of the offset of the cut-off frequency so that the
+  // windowed filter passes the pass band frequency unchanged
+  double sigma = 0.0;
+  for (int searchIteration = 0; searchIteration < 100; ++searchIteration)
+  {
+    double theta = thetaPassBand + sigma;
+    double transfer = 0.0;
+    double transferDerivative = 0.0;
+    for (int i = 0; i <= numberOfIterations; ++i)
+    {
+      double chebyshev = cos(i * thetaPassBand);
+      coefficients[i] = (i == 0 ? theta / pi : 2.0 * sin(i * theta) / (i * pi));
+      double coefficientDerivative = (i == 0 ? 1.0 / pi : 2.0 * cos(i * theta) / pi);
+      transfer += window[i] * coefficients[i] * chebyshev;
+      transferDerivative += window[i] * coefficientDerivative * chebyshev;
+    }
+    if (fabs(transfer - 1.0) < 1e-3 || transferDerivative == 0.0)
+    {
+      break;
+    }
+    sigma += (1.0 - transfer) / transferDerivative;
+  }
+
+  // The sum of the coefficients is the response to a translation, it must be 1
+  double sum = 0.0;
+  for (int i = 0; i <= numberOfIterations; ++i)
+  {
+    coefficients[i] *= window[i];
+    sum += coefficients[i];
+  }
+  for (int i = 0; i <= numberOfIterations; ++i)
+  {
+    coefficients[i] /= sum;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkParallelLabelmapToSurfaceFilter::SmoothSurface(int numberOfThreads)
+{
+  vtkPoints* points = this->Output->GetPoints();
+  vtkCellArray* polys = this->Output->GetPolys();
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if (numberOfPoints == 0)
+  {
+    return;
+  }
+
+  // Neighbors of each point along the polygon edges
+  std::vector<vtkIdType> neighborStarts(numberOfPoints + 1, 0);
+  vtkIdType numberOfCellPoints = 0;
+  vtkIdType* cellPointIds = NULL;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPointIds); )
+  {
+    for (vtkIdType i = 0; i < numberOfCellPoints; ++i)
+    {
+      neighborStarts[cellPointIds[i] + 1] += 2;
+    }
+  }
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+  {
+    neighborStarts[pointId + 1] += neighborStarts[pointId];
+  }
+  std::vector<vtkIdType> neighbors(neighborStarts[numberOfPoints]);
+  std::vector<vtkIdType> neighborEnds(neighborStarts.begin(), neighborStarts.end() - 1);
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPointIds); )
+  {
+    for (vtkIdType i = 0; i < numberOfCellPoints; ++i)
+    {
+      vtkIdType pointId = cellPointIds[i];
+      neighbors[neighborEnds[pointId]++] = cellPointIds[(i + numberOfCellPoints - 1) % numberOfCellPoints];
+      neighbors[neighborEnds[pointId]++] = cellPointIds[(i + 1) % numberOfCellPoints];
+    }
+  }
+  // Each edge is shared by two polygons, keep every neighbor once
+  vtkIdType numberOfNeighbors = 0;
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+  {
+    std::vector<vtkIdType>::iterator first = neighbors.begin() + neighborStarts[pointId];
+    std::vector<vtkIdType>::iterator last = neighbors.begin() + neighborEnds[pointId];
+    std::sort(first, last);
+    last = std::unique(first, last);
+    neighborStarts[pointId] = numberOfNeighbors;
+    for (std::vector<vtkIdType>::iterator neighborIt = first; neighborIt != last; ++neighborIt)
+    {
+      neighbors[numberOfNeighbors++] = *neighborIt;
+    }
+  }
+  neighborStarts[numberOfPoints] = numberOfNeighbors;
+
+  std::vector<double> coefficients(this->NumberOfSmoothingIterations + 1);
+  double passBand = pow(10.0, -4.0 * this->SmoothingFactor);
+  ComputeWindowedSincCoefficients(passBand, this->NumberOfSmoothingIterations, &coefficients[0]);
+
+  // Three rotating buffers hold the previous, current and next iterates
+  std::vector<double> iterates[3];
+  for (int i = 0; i < 3; ++i)
+  {
+    iterates[i].resize(3 * numberOfPoints);
+  }
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+  {
+    points->GetPoint(pointId, &iterates[0][3 * pointId]);
+  }
+  std::vector<double> result(3 * numberOfPoints);
+
+  numberOfThreads = static_cast<int>(std::min(static_cast<vtkIdType>(numberOfThreads),
+    numberOfPoints / MINIMUM_NUMBER_OF_POINTS_PER_THREAD));
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::max(numberOfThreads, 1));
+
+  SmoothingIteration iteration;
+  iteration.NumberOfPoints = numberOfPoints;
+  iteration.NeighborStarts = &neighborStarts[0];
+  iteration.Neighbors = (numberOfNeighbors > 0 ? &neighbors[0] : NULL);
+  iteration.Result = &result[0];
+  iteration.CurrentCoefficient = coefficients[0];
+  for (int iterationIndex = 1; iterationIndex <= this->NumberOfSmoothingIterations; ++iterationIndex)
+  {
+    iteration.Previous = &iterates[(iterationIndex + 1) % 3][0];
+    iteration.Current = &iterates[(iterationIndex + 2) % 3][0];
+    iteration.Next = &iterates[iterationIndex % 3][0];
+    iteration.FirstIteration = (iterationIndex == 1);
+    iteration.NextCoefficient = coefficients[iterationIndex];
+    if (numberOfThreads <= 1)
+    {
+      SmoothPoints(iteration, 0, numberOfPoints);
+    }
+    else
+    {
+      threader->SetSingleMethod(SmoothPointsThread, &iteration);
+      threader->SingleMethodExecute();
+    }
+  }
+
+  vtkSmartPointer<vtkPoints> smoothedPoints = vtkSmartPointer<vtkPoints>::New();
+  smoothedPoints->SetDataType(points->GetDataType());
+  smoothedPoints->SetNumberOfPoints(numberOfPoints);
+  for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+  {
+    smoothedPoints->SetPoint(pointId, &result[3 * pointId]);
+  }
+  this->Output->SetPoints(smoothedPoints);
+}
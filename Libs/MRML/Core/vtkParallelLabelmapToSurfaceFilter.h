@@ -0,0 +1,146 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkParallelLabelmapToSurfaceFilter_h
+#define __vtkParallelLabelmapToSurfaceFilter_h
+
+// VTK includes
+#include <vtkObject.h>
+
+//#include "vtkSegmentationCoreConfigure.h"
+#include "vtkMRMLWin32Header.h"
+
+class vtkDataArray;
+class vtkImageData;
+class vtkPolyData;
+
+/// \ingroup SegmentationCore
+/// \brief Extract the surface of a labelmap using marching cubes on slabs of slices in parallel.
+///
+/// The labelmap is split along K into slabs that share their boundary slice. Marching cubes
+/// runs on each slab in its own thread, directly on the labelmap voxels. The slabs are then
+/// stitched by merging the points of the shared slices, which both slabs compute identically,
+/// so the surface is the same closed surface as the one of a single marching cubes.
+/// The surface is then optionally decimated (vtkQuadricDecimation) and smoothed with a
+/// windowed sinc filter whose iterations are split between the threads.
+///
+/// The marching cubes surfaces of the slabs are kept between updates. If the voxels of the
+/// input are modified and the modified region is reported by InputRegionModified() then the next
+/// update only runs marching cubes on the slabs that intersect the region, the other slabs are
+/// stitched from the previous update. Decimation and smoothing are global, they are applied on
+/// the whole stitched surface at each update.
+class VTK_MRML_EXPORT vtkParallelLabelmapToSurfaceFilter : public vtkObject
+{
+public:
+  static vtkParallelLabelmapToSurfaceFilter *New();
+  vtkTypeMacro(vtkParallelLabelmapToSurfaceFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Extract the surface of the input labelmap
+  /// \return False if the input is invalid or if no polygons can be created
+  bool Update();
+
+  /// Extracted surface, in the coordinate system of the input image data (origin and spacing)
+  vtkPolyData* GetOutput();
+
+  /// Report that the voxels of the input in the extent (IJK) are about to be modified.
+  /// The next ModifiedEvent of the input scalars is expected to be the modification of the region,
+  /// any other modification of the scalars makes the next update extract all the slabs again.
+  /// \sa vtkMRMLVolumeNode::ImageDataRegionModified
+  void InputRegionModified(int extent[6]);
+
+  /// Remove the slab surfaces kept from the previous update, the next update extracts all the slabs
+  void ClearSlabSurfaces();
+
+  /// Number of slabs whose surface was extracted by the last update (the other slabs were reused)
+  vtkGetMacro(NumberOfExtractedSlabs, int);
+
+public:
+  vtkGetObjectMacro(InputLabelmap, vtkImageData);
+  vtkSetObjectMacro(InputLabelmap, vtkImageData);
+
+  /// Value of the marching cubes isosurface. 0.5 by default.
+  vtkGetMacro(IsoValue, double);
+  vtkSetMacro(IsoValue, double);
+
+  /// Desired reduction in the number of triangles (e.g. 0.9 reduces the surface to 10% of its size).
+  /// 0 (default) means no decimation.
+  vtkGetMacro(DecimationFactor, double);
+  vtkSetClampMacro(DecimationFactor, double, 0.0, 1.0);
+
+  /// Smoothing factor between 0 (no smoothing, default) and 1 (strong smoothing).
+  /// The pass band of the windowed sinc filter is 10^(-4*SmoothingFactor).
+  vtkGetMacro(SmoothingFactor, double);
+  vtkSetClampMacro(SmoothingFactor, double, 0.0, 1.0);
+
+  /// Number of iterations of the windowed sinc filter. 20 by default.
+  vtkGetMacro(NumberOfSmoothingIterations, int);
+  vtkSetMacro(NumberOfSmoothingIterations, int);
+
+  /// Number of threads. 0 (default) uses the default number of threads of vtkMultiThreader.
+  vtkGetMacro(NumberOfThreads, int);
+  vtkSetMacro(NumberOfThreads, int);
+
+  /// Minimum number of slices of a slab, thinner labelmaps are split into fewer slabs. 16 by default.
+  vtkGetMacro(MinimumSlabThickness, int);
+  vtkSetMacro(MinimumSlabThickness, int);
+
+protected:
+  /// Run marching cubes on the slabs in parallel and stitch them into the output
+  bool ExtractSurface(int numberOfThreads);
+
+  /// Smooth the output with a windowed sinc filter, the vertices are split between the threads
+  void SmoothSurface(int numberOfThreads);
+
+  /// Observe the modifications of the input scalars, the slab surfaces are kept as long as
+  /// the modifications are reported by InputRegionModified()
+  void SetObservedScalars(vtkDataArray* scalars);
+
+  /// Called when the observed input scalars are modified
+  static void OnScalarsModified(vtkObject* caller, unsigned long eid, void* clientData, void* callData);
+
+  /// Coefficients of the windowed sinc filter for the pass band and number of iterations,
+  /// normalized so that the filter preserves the positions of flat regions.
+  static void ComputeWindowedSincCoefficients(double passBand, int numberOfIterations, double* coefficients);
+
+protected:
+  /// Input labelmap image data
+  vtkImageData* InputLabelmap;
+
+  /// Output surface
+  vtkPolyData* Output;
+
+  double IsoValue;
+  double DecimationFactor;
+  double SmoothingFactor;
+  int NumberOfSmoothingIterations;
+  int NumberOfThreads;
+  int MinimumSlabThickness;
+  int NumberOfExtractedSlabs;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+protected:
+  vtkParallelLabelmapToSurfaceFilter();
+  virtual ~vtkParallelLabelmapToSurfaceFilter();
+
+private:
+  vtkParallelLabelmapToSurfaceFilter(const vtkParallelLabelmapToSurfaceFilter&); // Not implemented
+  void operator=(const vtkParallelLabelmapToSurfaceFilter&);               // Not implemented
+};
+
+#endif
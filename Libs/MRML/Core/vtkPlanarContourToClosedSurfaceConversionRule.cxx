@@ -32,6 +32,167 @@
 #include <vtkMath.h>
 #include <vtkIdList.h>
 #include <vtkDelaunay2D.h>
+#include <vtkSimpleCriticalSection.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+/// Lines with fewer points are searched linearly for their closest points.
+const int MINIMUM_NUMBER_OF_POINTS_FOR_GRID = 64;
+
+//----------------------------------------------------------------------------
+/// Points of a line binned in a regular grid of the XY plane.
+/// The distances are computed in 3D, the grid only prunes the points that are
+/// further in XY than the closest point found so far, so the result is exact.
+/// On ties the point with the lowest index in the line is returned, the same
+/// as a linear search.
+class ClosestPointGrid
+{
+public:
+  ClosestPointGrid(vtkPolyData* inputROIPoints, vtkIdList* linePointIds, int numberOfPoints)
+  {
+    this->Coordinates.resize(3*numberOfPoints);
+    double bounds[4] = {VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+    for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+      double* point = &this->Coordinates[3*pointIndex];
+      inputROIPoints->GetPoint(linePointIds->GetId(pointIndex), point);
+      bounds[0] = std::min(bounds[0], point[0]);
+      bounds[1] = std::max(bounds[1], point[0]);
+      bounds[2] = std::min(bounds[2], point[1]);
+      bounds[3] = std::max(bounds[3], point[1]);
+    }
+
+    // About one bin per point along the contour
+    int binsPerAxis = std::max(1, static_cast<int>(std::sqrt(static_cast<double>(numberOfPoints))));
+    for (int axis = 0; axis < 2; ++axis)
+    {
+      double size = bounds[2*axis+1] - bounds[2*axis];
+      this->Origin[axis] = bounds[2*axis];
+      this->Dimensions[axis] = (size > 0 ? binsPerAxis : 1);
+      this->BinSize[axis] = (size > 0 ? size / binsPerAxis : 1.0);
+    }
+
+    // Sort the point indices by bin, in increasing order in each bin
+    std::vector<int> pointBins(numberOfPoints);
+    this->BinStarts.assign(this->Dimensions[0]*this->Dimensions[1]+1, 0);
+    for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+      int bin[2] = {0,0};
+      this->GetBin(&this->Coordinates[3*pointIndex], bin);
+      pointBins[pointIndex] = bin[1]*this->Dimensions[0] + bin[0];
+      ++this->BinStarts[pointBins[pointIndex]+1];
+    }
+    for (size_t binIndex = 1; binIndex < this->BinStarts.size(); ++binIndex)
+    {
+      this->BinStarts[binIndex] += this->BinStarts[binIndex-1];
+    }
+    this->BinPoints.resize(numberOfPoints);
+    std::vector<int> binEnds(this->BinStarts.begin(), this->BinStarts.end()-1);
+    for (int pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
+    {
+      this->BinPoints[binEnds[pointBins[pointIndex]]++] = pointIndex;
+    }
+  }
+
+  /// Index in the line of the point closest to the given point.
+  int FindClosestPoint(const double originalPoint[3]) const
+  {
+    int bin[2] = {0,0};
+    this->GetBin(originalPoint, bin);
+
+    double minimumDistance = VTK_DOUBLE_MAX;
+    int closestPointIndex = -1;
+    for (int ring = 0; ; ++ring)
+    {
+      int xMin = std::max(bin[0]-ring, 0);
+      int xMax = std::min(bin[0]+ring, this->Dimensions[0]-1);
+      int yMin = std::max(bin[1]-ring, 0);
+      int yMax = std::min(bin[1]+ring, this->Dimensions[1]-1);
+      for (int y = yMin; y <= yMax; ++y)
+      {
+        bool borderRow = (y == bin[1]-ring || y == bin[1]+ring);
+        for (int x = xMin; x <= xMax; ++x)
+        {
+          if (!borderRow && x != bin[0]-ring && x != bin[0]+ring)
+          {
+            // inside of the ring, already searched
+            continue;
+          }
+          int binIndex = y*this->Dimensions[0] + x;
+          for (int i = this->BinStarts[binIndex]; i < this->BinStarts[binIndex+1]; ++i)
+          {
+            int pointIndex = this->BinPoints[i];
+            double distance = vtkMath::Distance2BetweenPoints(originalPoint, &this->Coordinates[3*pointIndex]);
+            if (distance < minimumDistance || (distance == minimumDistance && pointIndex < closestPointIndex))
+            {
+              minimumDistance = distance;
+              closestPointIndex = pointIndex;
+            }
+          }
+        }
+      }
+
+      // Distance in XY from the point to the bins that are not searched yet
+      double remainingDistance = VTK_DOUBLE_MAX;
+      for (int axis = 0; axis < 2; ++axis)
+      {
+        double coordinate = (originalPoint[axis] - this->Origin[axis]) / this->BinSize[axis];
+        if (bin[axis]-ring > 0)
+        {
+          remainingDistance = std::min(remainingDistance, std::max(0.0, coordinate - (bin[axis]-ring)) * this->BinSize[axis]);
+        }
+        if (bin[axis]+ring < this->Dimensions[axis]-1)
+        {
+          remainingDistance = std::min(remainingDistance, std::max(0.0, (bin[axis]+ring+1) - coordinate) * this->BinSize[axis]);
+        }
+      }
+      if (remainingDistance == VTK_DOUBLE_MAX)
+      {
+        // all the bins are searched
+        break;
+      }
+      // Keep a margin for the rounding of the bin computation
+      remainingDistance = std::max(0.0, remainingDistance - 1e-6 * std::max(this->BinSize[0], this->BinSize[1]));
+      if (closestPointIndex >= 0 && remainingDistance*remainingDistance > minimumDistance)
+      {
+        break;
+      }
+    }
+    return closestPointIndex;
+  }
+
+protected:
+  void GetBin(const double point[3], int bin[2]) const
+  {
+    for (int axis = 0; axis < 2; ++axis)
+    {
+      double coordinate = (point[axis] - this->Origin[axis]) / this->BinSize[axis];
+      bin[axis] = (coordinate <= 0 ? 0 : std::min(static_cast<int>(coordinate), this->Dimensions[axis]-1));
+    }
+  }
+
+  std::vector<double> Coordinates;
+  double Origin[2];
+  double BinSize[2];
+  int Dimensions[2];
+  /// Points of the bin i are BinPoints[BinStarts[i]] to BinPoints[BinStarts[i+1]-1]
+  std::vector<int> BinStarts;
+  std::vector<int> BinPoints;
+};
+
+//----------------------------------------------------------------------------
+struct ContourPairJobList
+{
+  vtkPlanarContourToClosedSurfaceConversionRule* Rule;
+  vtkPolyData* InputROIPoints;
+  void* ContourPairs;
+  vtkSimpleCriticalSection Lock;
+  size_t NextPair;
+};
+}
 
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkPlanarContourToClosedSurfaceConversionRule);
@@ -39,7 +200,7 @@ vtkSegmentationConverterRuleNewMacro(vtkPlanarContourToClosedSurfaceConversionRu
 //----------------------------------------------------------------------------
 vtkPlanarContourToClosedSurfaceConversionRule::vtkPlanarContourToClosedSurfaceConversionRule()
 {
-  //this->ConversionParameters[GetXYParameterName()] = std::make_pair("value", "description");
+  this->ConversionParameters[GetNumberOfThreadsParameterName()] = std::make_pair("0", "Number of threads triangulating the contours of adjacent planes. Value of 0 uses all the processors, 1 triangulates serially. The result does not depend on the number of threads.");
 }
 
 //----------------------------------------------------------------------------
@@ -99,6 +260,9 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
     return false;
   }
 
+  int numberOfThreads = static_cast<int>(vtkSegmentationConverter::DeserializeFloatingPointConversionParameter(
+    this->ConversionParameters[GetNumberOfThreadsParameterName()].first ));
+
   vtkSmartPointer<vtkPolyData> inputContoursCopy = vtkSmartPointer<vtkPolyData>::New();
   inputContoursCopy->DeepCopy(planarContoursPolyData);
 
@@ -139,6 +303,9 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
     lineTriganulatedToBelow[i] = false;
   }
 
+  // Contour pairs to triangulate, they are independent from each other.
+  std::vector<ContourPair> contourPairs;
+
   // Get two consecutive planes.
   int firstLineOnPlane1Index = 0; // pointer to first line on plane 1.
   int numberOfLinesInPlane1 = this->GetNumberOfLinesOnPlane(inputContoursCopy, numberOfLines, 0);
@@ -242,10 +409,10 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
         {
           lineTriganulatedToAbove[line1Index] = true;
           lineTriganulatedToBelow[line2Index] = true;
-          this->TriangulateContours(inputContoursCopy,
-            dividedPointsInLine1, numberOfdividedPointsInLine1,
-            dividedPointsInLine2, numberOfdividedPointsInLine2,
-            outputPolygons);
+          ContourPair contourPair;
+          contourPair.Line1PointIds = dividedPointsInLine1;
+          contourPair.Line2PointIds = dividedPointsInLine2;
+          contourPairs.push_back(contourPair);
         }
 
       }
@@ -256,6 +423,8 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::Convert(vtkDataObject* sourc
     numberOfLinesInPlane1 = numberOfLinesInPlane2;
   }
 
+  this->TriangulateContourPairs(inputContoursCopy, contourPairs, numberOfThreads, outputPolygons);
+
   // Triangulate all contours which are exposed.
   this->SealMesh( inputContoursCopy, outputLines, outputPolygons, lineTriganulatedToAbove, lineTriganulatedToBelow);
 
@@ -295,23 +464,11 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
 
   // Closest point from line 1 to line 2
   std::vector< int > closest1;
-  for (int line1PointIndex = 0; line1PointIndex < numberOfPointsInLine1; ++line1PointIndex)
-  {
-    double line1Point[3] = {0,0,0};
-    inputROIPoints->GetPoint(pointsInLine1->GetId(line1PointIndex), line1Point);
-
-    closest1.push_back(this->GetClosestPoint(inputROIPoints, line1Point, pointsInLine2, numberOfPointsInLine2));
-  }
+  this->GetClosestPoints(inputROIPoints, pointsInLine1, numberOfPointsInLine1, pointsInLine2, numberOfPointsInLine2, closest1);
 
   // closest from line 2 to line 1
   std::vector< int > closest2;
-  for (int line2PointIndex = 0; line2PointIndex < numberOfPointsInLine2; ++line2PointIndex)
-  {
-    double line2Point[3] = {0,0,0};
-    inputROIPoints->GetPoint(pointsInLine2->GetId(line2PointIndex),line2Point);
-
-    closest2.push_back(this->GetClosestPoint(inputROIPoints, line2Point, pointsInLine1, numberOfPointsInLine1));
-  }
+  this->GetClosestPoints(inputROIPoints, pointsInLine2, numberOfPointsInLine2, pointsInLine1, numberOfPointsInLine1, closest2);
 
   // Orient loops.
   // Use the 0th point on line 1 and the closest point on line 2.
@@ -493,6 +650,102 @@ void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContours(vtkPolyD
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContourPairs(vtkPolyData* inputROIPoints, std::vector<ContourPair>& contourPairs, int numberOfThreads, vtkCellArray* outputPolygons)
+{
+  if (!inputROIPoints)
+  {
+    vtkErrorMacro("TriangulateContourPairs: Invalid vtkPolyData!");
+    return;
+  }
+
+  if (!outputPolygons)
+  {
+    vtkErrorMacro("TriangulateContourPairs: Invalid vtkCellArray!");
+    return;
+  }
+
+  if (numberOfThreads <= 0)
+  {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+  numberOfThreads = std::min(numberOfThreads, static_cast<int>(contourPairs.size()));
+
+  if (numberOfThreads <= 1)
+  {
+    for (size_t pairIndex = 0; pairIndex < contourPairs.size(); ++pairIndex)
+    {
+      ContourPair& contourPair = contourPairs[pairIndex];
+      this->TriangulateContours(inputROIPoints,
+        contourPair.Line1PointIds, contourPair.Line1PointIds->GetNumberOfIds(),
+        contourPair.Line2PointIds, contourPair.Line2PointIds->GetNumberOfIds(),
+        outputPolygons);
+    }
+    return;
+  }
+
+  // Each pair is triangulated into its own cell array. The threads only read
+  // the points and the point ids, which are not modified until all the pairs
+  // are triangulated.
+  for (size_t pairIndex = 0; pairIndex < contourPairs.size(); ++pairIndex)
+  {
+    contourPairs[pairIndex].Polygons = vtkSmartPointer<vtkCellArray>::New();
+  }
+
+  ContourPairJobList jobList;
+  jobList.Rule = this;
+  jobList.InputROIPoints = inputROIPoints;
+  jobList.ContourPairs = &contourPairs;
+  jobList.NextPair = 0;
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContourPairsThread, &jobList);
+  threader->SingleMethodExecute();
+
+  // Merge in the order of the pairs, the same order as the serial triangulation
+  for (size_t pairIndex = 0; pairIndex < contourPairs.size(); ++pairIndex)
+  {
+    vtkCellArray* pairPolygons = contourPairs[pairIndex].Polygons;
+    vtkIdType numberOfPoints = 0;
+    vtkIdType* pointIds = NULL;
+    for (pairPolygons->InitTraversal(); pairPolygons->GetNextCell(numberOfPoints, pointIds); )
+    {
+      outputPolygons->InsertNextCell(numberOfPoints, pointIds);
+    }
+    contourPairs[pairIndex].Polygons = NULL;
+  }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkPlanarContourToClosedSurfaceConversionRule::TriangulateContourPairsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ContourPairJobList* jobList = static_cast<ContourPairJobList*>(threadInfo->UserData);
+  std::vector<ContourPair>& contourPairs = *static_cast<std::vector<ContourPair>*>(jobList->ContourPairs);
+
+  while (true)
+  {
+    jobList->Lock.Lock();
+    size_t pairIndex = jobList->NextPair++;
+    jobList->Lock.Unlock();
+    if (pairIndex >= contourPairs.size())
+    {
+      break;
+    }
+
+    // Raw pointers, the reference counts of the shared objects are not touched in the threads
+    ContourPair& contourPair = contourPairs[pairIndex];
+    vtkIdList* pointsInLine1 = contourPair.Line1PointIds.GetPointer();
+    vtkIdList* pointsInLine2 = contourPair.Line2PointIds.GetPointer();
+    jobList->Rule->TriangulateContours(jobList->InputROIPoints,
+      pointsInLine1, pointsInLine1->GetNumberOfIds(),
+      pointsInLine2, pointsInLine2->GetNumberOfIds(),
+      contourPair.Polygons.GetPointer());
+  }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 //----------------------------------------------------------------------------
 int vtkPlanarContourToClosedSurfaceConversionRule::GetEndLoop(int startLoopIndex, int numberOfPoints, bool loopClosed)
 {
@@ -546,6 +799,40 @@ int vtkPlanarContourToClosedSurfaceConversionRule::GetClosestPoint(vtkPolyData*
   return closestPointIndex;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlanarContourToClosedSurfaceConversionRule::GetClosestPoints(vtkPolyData* inputROIPoints,
+                                                  vtkIdList* pointsInLine1, int numberOfPointsInLine1,
+                                                  vtkIdList* pointsInLine2, int numberOfPointsInLine2,
+                                                  std::vector<int>& closestPoints)
+{
+  closestPoints.clear();
+  if (!inputROIPoints || !pointsInLine1 || !pointsInLine2 || numberOfPointsInLine2 < 1)
+  {
+    vtkErrorMacro("GetClosestPoints: Invalid input!");
+    return;
+  }
+  closestPoints.reserve(numberOfPointsInLine1);
+
+  if (numberOfPointsInLine2 < MINIMUM_NUMBER_OF_POINTS_FOR_GRID)
+  {
+    for (int line1PointIndex = 0; line1PointIndex < numberOfPointsInLine1; ++line1PointIndex)
+    {
+      double line1Point[3] = {0,0,0};
+      inputROIPoints->GetPoint(pointsInLine1->GetId(line1PointIndex), line1Point);
+      closestPoints.push_back(this->GetClosestPoint(inputROIPoints, line1Point, pointsInLine2, numberOfPointsInLine2));
+    }
+    return;
+  }
+
+  ClosestPointGrid grid(inputROIPoints, pointsInLine2, numberOfPointsInLine2);
+  for (int line1PointIndex = 0; line1PointIndex < numberOfPointsInLine1; ++line1PointIndex)
+  {
+    double line1Point[3] = {0,0,0};
+    inputROIPoints->GetPoint(pointsInLine1->GetId(line1PointIndex), line1Point);
+    closestPoints.push_back(grid.FindClosestPoint(line1Point));
+  }
+}
+
 //----------------------------------------------------------------------------
 void vtkPlanarContourToClosedSurfaceConversionRule::FixKeyholes(vtkPolyData* inputROIPoints, int numberOfLines, double epsilon, int minimumSeperation)
 {
@@ -861,7 +1148,7 @@ bool vtkPlanarContourToClosedSurfaceConversionRule::DoLinesOverlap(vtkLine* line
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROIPoints, vtkIdList* points, int numberOfPoints, int currentLineIndex, std::vector< int > overlappingLines, std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists, vtkLine* outputLine)
+void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROIPoints, vtkIdList* points, int numberOfPoints, int currentLineIndex, const std::vector< int >& overlappingLines, const std::vector<vtkSmartPointer<vtkPointLocator> >& pointLocators, const std::vector<vtkSmartPointer<vtkIdList> >& lineIdLists, vtkLine* outputLine)
 {
   if (!inputROIPoints)
   {
@@ -922,7 +1209,7 @@ void vtkPlanarContourToClosedSurfaceConversionRule::Branch(vtkPolyData* inputROI
 }
 
 //----------------------------------------------------------------------------
-int vtkPlanarContourToClosedSurfaceConversionRule::GetClosestBranch(vtkPolyData* inputROIPoints, double* originalPoint, std::vector< int > overlappingLines,  std::vector<vtkSmartPointer<vtkPointLocator> > pointLocators, std::vector<vtkSmartPointer<vtkIdList> > lineIdLists)
+int vtkPlanarContourToClosedSurfaceConversionRule::GetClosestBranch(vtkPolyData* inputROIPoints, double* originalPoint, const std::vector< int >& overlappingLines, const std::vector<vtkSmartPointer<vtkPointLocator> >& pointLocators, const std::vector<vtkSmartPointer<vtkIdList> >& lineIdLists)
 {
   if (!inputROIPoints)
   {
@@ -961,7 +1248,7 @@ int vtkPlanarContourToClosedSurfaceConversionRule::GetClosestBranch(vtkPolyData*
 }
 
 //----------------------------------------------------------------------------
-void vtkPlanarContourToClosedSurfaceConversionRule::SealMesh(vtkPolyData* inputROIPoints, vtkCellArray* inputLines, vtkCellArray* outputPolygons, std::vector< bool > lineTriganulatedToAbove, std::vector< bool > lineTriganulatedToBelow)
+void vtkPlanarContourToClosedSurfaceConversionRule::SealMesh(vtkPolyData* inputROIPoints, vtkCellArray* inputLines, vtkCellArray* outputPolygons, const std::vector< bool >& lineTriganulatedToAbove, const std::vector< bool >& lineTriganulatedToBelow)
 {
   if (!inputROIPoints)
   {
@@ -32,6 +32,7 @@
 
 // VTK includes
 #include "vtkPointLocator.h"
+#include "vtkMultiThreader.h"
 
 class vtkPolyData;
 class vtkIdList;
@@ -55,6 +56,10 @@ public:
   vtkTypeMacro(vtkPlanarContourToClosedSurfaceConversionRule, vtkSegmentationConverterRule );
   virtual vtkSegmentationConverterRule* CreateRuleInstance();
 
+  /// Conversion parameter: number of threads triangulating the contours of adjacent planes.
+  /// 0 uses the default number of threads of vtkMultiThreader, 1 triangulates serially.
+  static const std::string GetNumberOfThreadsParameterName() { return "Number of threads"; };
+
   // /// Convert a set of contours into a surface mesh.
   // void ConvertContoursToMesh(vtkPolyData*, vtkPolyData*);
 
@@ -87,15 +92,36 @@ protected:
   vtkPlanarContourToClosedSurfaceConversionRule();
   virtual ~vtkPlanarContourToClosedSurfaceConversionRule();
 
+  /// Portions of two overlapping contours on adjacent planes, triangulated together.
+  struct ContourPair
+  {
+    vtkSmartPointer<vtkIdList> Line1PointIds;
+    vtkSmartPointer<vtkIdList> Line2PointIds;
+    vtkSmartPointer<vtkCellArray> Polygons;
+  };
+
   /// Construct a surface triangulation using a dynamic programming algorithm.
   void TriangulateContours(vtkPolyData*, vtkIdList*, int, vtkIdList*, int, vtkCellArray*);
 
+  /// Triangulate the contour pairs with the given number of threads and append
+  /// the triangles to the output polygons in the order of the pairs, so that
+  /// the result does not depend on the number of threads.
+  void TriangulateContourPairs(vtkPolyData*, std::vector<ContourPair>&, int, vtkCellArray*);
+
+  /// Thread method of TriangulateContourPairs, each thread takes the next pair until there is none left.
+  static VTK_THREAD_RETURN_TYPE TriangulateContourPairsThread(void*);
+
   /// Find the index of the last point in a contour.
   int GetEndLoop(int, int, bool);
 
   /// Find the point on the given line that is closest to the given point.
   int GetClosestPoint(vtkPolyData*, double*, vtkIdList*, int);
 
+  /// Find for each point of the first line the closest point of the second line.
+  /// Long lines are binned in a grid instead of being searched linearly, the
+  /// result is the same as GetClosestPoint.
+  void GetClosestPoints(vtkPolyData*, vtkIdList*, int, vtkIdList*, int, std::vector<int>&);
+
   /// Remove the keyholes from the contours.
   void FixKeyholes(vtkPolyData*, int, double, int);
 
@@ -115,13 +141,13 @@ protected:
   bool DoLinesOverlap(vtkLine*, vtkLine*);
 
   /// Create a branching pattern for overlapping contours.
-  void Branch(vtkPolyData*, vtkIdList*, int, int, std::vector< int >, std::vector<vtkSmartPointer<vtkPointLocator> >, std::vector<vtkSmartPointer<vtkIdList> >, vtkLine*);
+  void Branch(vtkPolyData*, vtkIdList*, int, int, const std::vector< int >&, const std::vector<vtkSmartPointer<vtkPointLocator> >&, const std::vector<vtkSmartPointer<vtkIdList> >&, vtkLine*);
   
   /// Find the branch closest from the point on the trunk
-  int GetClosestBranch(vtkPolyData*, double*, std::vector< int >, std::vector<vtkSmartPointer<vtkPointLocator> >, std::vector<vtkSmartPointer<vtkIdList> >);
+  int GetClosestBranch(vtkPolyData*, double*, const std::vector< int >&, const std::vector<vtkSmartPointer<vtkPointLocator> >&, const std::vector<vtkSmartPointer<vtkIdList> >&);
 
   /// Seal the exterior contours of the mesh.
-  void SealMesh(vtkPolyData*, vtkCellArray*, vtkCellArray*, std::vector< bool >, std::vector< bool >);
+  void SealMesh(vtkPolyData*, vtkCellArray*, vtkCellArray*, const std::vector< bool >&, const std::vector< bool >&);
 
   double GetSpacingBetweenLines(vtkPolyData*);
 
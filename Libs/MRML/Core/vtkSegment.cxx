@@ -25,6 +25,7 @@
 #include "vtkOrientedImageData.h"
 #include "vtkPolyData.h"
 #include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
+#include "vtkParallelLabelmapToSurfaceFilter.h"
 
 // VTK includes
 #include <vtkNew.h>
@@ -60,6 +61,8 @@ vtkSegment::vtkSegment()
   this->LabelMapImageCallbackCommand->SetClientData(reinterpret_cast<void *>(this));
   this->LabelMapImageCallbackCommand->SetCallback(vtkSegment::OnLabelMapImageModified);
 
+  this->LabelmapSurfaceFilter = NULL;
+
 }
 
 //----------------------------------------------------------------------------
@@ -74,6 +77,11 @@ vtkSegment::~vtkSegment()
 	  this->LabelMapImageCallbackCommand->Delete();
 	  this->LabelMapImageCallbackCommand = NULL;
   }
+  if (this->LabelmapSurfaceFilter)
+  {
+    this->LabelmapSurfaceFilter->Delete();
+    this->LabelmapSurfaceFilter = NULL;
+  }
 
 
 }
@@ -357,6 +365,25 @@ void vtkSegment::GetContainedRepresentationNames(std::vector<std::string>& repre
   }
 }
 
+//---------------------------------------------------------------------------
+vtkParallelLabelmapToSurfaceFilter* vtkSegment::GetLabelmapSurfaceFilter()
+{
+  if (!this->LabelmapSurfaceFilter)
+  {
+    this->LabelmapSurfaceFilter = vtkParallelLabelmapToSurfaceFilter::New();
+  }
+  return this->LabelmapSurfaceFilter;
+}
+
+//---------------------------------------------------------------------------
+void vtkSegment::LabelmapRegionModified(int extent[6])
+{
+  if (this->LabelmapSurfaceFilter)
+  {
+    this->LabelmapSurfaceFilter->InputRegionModified(extent);
+  }
+}
+
 //---------------------------------------------------------------------------
 void vtkSegment::AddTag(std::string tag)
 {
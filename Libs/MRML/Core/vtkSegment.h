@@ -34,6 +34,7 @@
 #include "vtkMRMLWin32Header.h"
 
 class vtkCallbackCommand;
+class vtkParallelLabelmapToSurfaceFilter;
 
 
 /// \ingroup SegmentationCore
@@ -102,6 +103,16 @@ public:
   /// Get representation names present in this segment in an output string vector
   void GetContainedRepresentationNames(std::vector<std::string>& representationNames);
 
+  /// Surface extraction filter of the closed surface representation. It keeps the surface
+  /// of each slab of the labelmap so that only the edited slabs are extracted again.
+  /// Created on first use.
+  vtkParallelLabelmapToSurfaceFilter* GetLabelmapSurfaceFilter();
+
+  /// Report that the voxels of the labelmap in the extent (IJK) are about to be modified,
+  /// so that the next closed surface conversion only extracts the slabs of this region.
+  /// \sa vtkParallelLabelmapToSurfaceFilter::InputRegionModified
+  void LabelmapRegionModified(int extent[6]);
+
 public:
   vtkGetStringMacro(Name);
   vtkSetStringMacro(Name);
@@ -131,6 +142,9 @@ protected:
   /// Command handling  LableMapImage modified events,the Master representation
   vtkCallbackCommand* LabelMapImageCallbackCommand;
 
+  /// Surface extraction filter reused by the closed surface conversions of this segment
+  vtkParallelLabelmapToSurfaceFilter* LabelmapSurfaceFilter;
+
   /// Name (e.g. segment label in DICOM Segmentation Object)
   /// This is the default identifier of the segment within segmentation, so needs to be unique within a segmentation
   char* Name;
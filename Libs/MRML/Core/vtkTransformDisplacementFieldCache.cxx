@@ -0,0 +1,445 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkMRMLTransformNode.h"
+#include "vtkTransformDisplacementFieldCache.h"
+
+// VTK includes
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkOrientedGridTransform.h>
+#include <vtkPoints.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Geometry and samples of a displacement field, the displacement vectors are stored X fastest
+struct DisplacementField
+{
+  double Origin[3];
+  double Spacing;
+  int Dimensions[3];
+  double* Displacements;
+};
+
+//----------------------------------------------------------------------------
+struct SampleFieldJob
+{
+  vtkAbstractTransform* Transform;
+  DisplacementField Field;
+};
+
+//----------------------------------------------------------------------------
+struct TransformPointsJob
+{
+  /// Exact transform, used for the points outside the field
+  vtkAbstractTransform* Transform;
+  /// Interpolated displacement field, NULL if all the points are transformed exactly
+  DisplacementField* Field;
+  vtkPoints* InputPoints;
+  vtkPoints* OutputPoints;
+};
+
+//----------------------------------------------------------------------------
+/// Trilinear interpolation of the displacement field
+/// \return False if the point is outside the field
+inline bool InterpolateDisplacement(const DisplacementField* field, const double point[3], double displacement[3])
+{
+  int baseIndex[3] = {0, 0, 0};
+  double fraction[3] = {0.0, 0.0, 0.0};
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    double index = (point[axis] - field->Origin[axis]) / field->Spacing;
+    if (index < 0.0 || index > field->Dimensions[axis] - 1)
+      {
+      return false;
+      }
+    baseIndex[axis] = std::min(static_cast<int>(index), field->Dimensions[axis] - 2);
+    fraction[axis] = index - baseIndex[axis];
+    }
+
+  vtkIdType rowIncrement = 3 * static_cast<vtkIdType>(field->Dimensions[0]);
+  vtkIdType sliceIncrement = rowIncrement * field->Dimensions[1];
+  const double* corner = field->Displacements
+    + baseIndex[2] * sliceIncrement + baseIndex[1] * rowIncrement + 3 * baseIndex[0];
+  double fx = fraction[0];
+  double fy = fraction[1];
+  double fz = fraction[2];
+  for (int component = 0; component < 3; ++component)
+    {
+    const double* c = corner + component;
+    double v00 = c[0] + fx * (c[3] - c[0]);
+    double v10 = c[rowIncrement] + fx * (c[rowIncrement + 3] - c[rowIncrement]);
+    double v01 = c[sliceIncrement] + fx * (c[sliceIncrement + 3] - c[sliceIncrement]);
+    double v11 = c[sliceIncrement + rowIncrement]
+      + fx * (c[sliceIncrement + rowIncrement + 3] - c[sliceIncrement + rowIncrement]);
+    double v0 = v00 + fy * (v10 - v00);
+    double v1 = v01 + fy * (v11 - v01);
+    displacement[component] = v0 + fz * (v1 - v0);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+/// Sample the displacement on the field rows assigned to the thread
+VTK_THREAD_RETURN_TYPE SampleFieldThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  SampleFieldJob* job = static_cast<SampleFieldJob*>(threadInfo->UserData);
+  DisplacementField& field = job->Field;
+  vtkIdType numberOfRows = static_cast<vtkIdType>(field.Dimensions[1]) * field.Dimensions[2];
+  vtkIdType firstRow = numberOfRows * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+  vtkIdType lastRow = numberOfRows * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads;
+
+  double point[3] = {0.0, 0.0, 0.0};
+  double transformedPoint[3] = {0.0, 0.0, 0.0};
+  for (vtkIdType row = firstRow; row < lastRow; ++row)
+    {
+    point[1] = field.Origin[1] + (row % field.Dimensions[1]) * field.Spacing;
+    point[2] = field.Origin[2] + (row / field.Dimensions[1]) * field.Spacing;
+    double* displacement = field.Displacements + 3 * row * field.Dimensions[0];
+    for (int i = 0; i < field.Dimensions[0]; ++i)
+      {
+      point[0] = field.Origin[0] + i * field.Spacing;
+      job->Transform->InternalTransformPoint(point, transformedPoint);
+      *(displacement++) = transformedPoint[0] - point[0];
+      *(displacement++) = transformedPoint[1] - point[1];
+      *(displacement++) = transformedPoint[2] - point[2];
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Transform the range of points assigned to the thread
+VTK_THREAD_RETURN_TYPE TransformPointsThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  TransformPointsJob* job = static_cast<TransformPointsJob*>(threadInfo->UserData);
+  vtkIdType numberOfPoints = job->InputPoints->GetNumberOfPoints();
+  vtkIdType firstPoint = numberOfPoints * threadInfo->ThreadID / threadInfo->NumberOfThreads;
+  vtkIdType lastPoint = numberOfPoints * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads;
+
+  double point[3] = {0.0, 0.0, 0.0};
+  double transformedPoint[3] = {0.0, 0.0, 0.0};
+  double displacement[3] = {0.0, 0.0, 0.0};
+  for (vtkIdType pointIndex = firstPoint; pointIndex < lastPoint; ++pointIndex)
+    {
+    job->InputPoints->GetPoint(pointIndex, point);
+    if (job->Field && InterpolateDisplacement(job->Field, point, displacement))
+      {
+      transformedPoint[0] = point[0] + displacement[0];
+      transformedPoint[1] = point[1] + displacement[1];
+      transformedPoint[2] = point[2] + displacement[2];
+      }
+    else
+      {
+      job->Transform->InternalTransformPoint(point, transformedPoint);
+      }
+    job->OutputPoints->SetPoint(pointIndex, transformedPoint);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void ExecuteTransformPoints(TransformPointsJob* job, int numberOfThreads)
+{
+  job->Transform->Update();
+  vtkIdType numberOfPoints = job->InputPoints->GetNumberOfPoints();
+  if (job->OutputPoints != job->InputPoints)
+    {
+    job->OutputPoints->SetNumberOfPoints(numberOfPoints);
+    }
+  if (numberOfPoints == 0)
+    {
+    return;
+    }
+
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  numberOfThreads = static_cast<int>(std::max<vtkIdType>(1, std::min<vtkIdType>(numberOfThreads, numberOfPoints)));
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(TransformPointsThread, job);
+  threader->SingleMethodExecute();
+  job->OutputPoints->Modified();
+}
+
+//----------------------------------------------------------------------------
+void GetDisplacementField(vtkImageData* image, DisplacementField& field)
+{
+  image->GetOrigin(field.Origin);
+  field.Spacing = image->GetSpacing()[0];
+  image->GetDimensions(field.Dimensions);
+  field.Displacements = static_cast<double*>(image->GetScalarPointer());
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkTransformDisplacementFieldCache);
+
+//----------------------------------------------------------------------------
+vtkTransformDisplacementFieldCache::vtkTransformDisplacementFieldCache()
+{
+  this->Bounds[0] = this->Bounds[2] = this->Bounds[4] = 0.0;
+  this->Bounds[1] = this->Bounds[3] = this->Bounds[5] = -1.0;
+  this->Spacing = 1.0;
+  this->ComputeInverse = true;
+  this->NumberOfThreads = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkTransformDisplacementFieldCache::~vtkTransformDisplacementFieldCache()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkTransformDisplacementFieldCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "TransformNode: " << this->TransformNode.GetPointer() << "\n";
+  os << indent << "Bounds: " << this->Bounds[0] << ", " << this->Bounds[1] << ", "
+     << this->Bounds[2] << ", " << this->Bounds[3] << ", "
+     << this->Bounds[4] << ", " << this->Bounds[5] << "\n";
+  os << indent << "Spacing: " << this->Spacing << "\n";
+  os << indent << "ComputeInverse: " << (this->ComputeInverse ? "true" : "false") << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkTransformDisplacementFieldCache::SetTransformNode(vtkMRMLTransformNode* transformNode)
+{
+  if (this->TransformNode == transformNode)
+    {
+    return;
+    }
+  this->TransformNode = transformNode;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLTransformNode* vtkTransformDisplacementFieldCache::GetTransformNode()
+{
+  return this->TransformNode;
+}
+
+//----------------------------------------------------------------------------
+bool vtkTransformDisplacementFieldCache::ContainsBounds(const double bounds[6])
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    if (this->Bounds[2 * axis] > this->Bounds[2 * axis + 1]
+      || bounds[2 * axis] < this->Bounds[2 * axis] || bounds[2 * axis + 1] > this->Bounds[2 * axis + 1])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkTransformDisplacementFieldCache::GetTransformNodeMTime()
+{
+  if (!this->TransformNode)
+    {
+    return 0;
+    }
+  return std::max(this->TransformNode->GetMTime(), this->TransformNode->GetTransformToWorldMTime());
+}
+
+//----------------------------------------------------------------------------
+void vtkTransformDisplacementFieldCache::GetFieldDimensions(int dimensions[3])
+{
+  for (int axis = 0; axis < 3; ++axis)
+    {
+    dimensions[axis] = 0;
+    double size = this->Bounds[2 * axis + 1] - this->Bounds[2 * axis];
+    if (size < 0.0 || this->Spacing <= 0.0)
+      {
+      continue;
+      }
+    // At least two samples, so that every point within the bounds is between samples
+    dimensions[axis] = std::max(2, static_cast<int>(ceil(size / this->Spacing - 1e-6)) + 1);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkTransformDisplacementFieldCache::SampleDisplacementField(vtkAbstractTransform* transform, vtkImageData* field)
+{
+  int dimensions[3] = {0, 0, 0};
+  this->GetFieldDimensions(dimensions);
+  field->SetDimensions(dimensions);
+  field->SetOrigin(this->Bounds[0], this->Bounds[2], this->Bounds[4]);
+  field->SetSpacing(this->Spacing, this->Spacing, this->Spacing);
+  field->AllocateScalars(VTK_DOUBLE, 3);
+
+  SampleFieldJob job;
+  job.Transform = transform;
+  GetDisplacementField(field, job.Field);
+  transform->Update();
+
+  int numberOfRows = dimensions[1] * dimensions[2];
+  int numberOfThreads = this->NumberOfThreads;
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  numberOfThreads = std::max(1, std::min(numberOfThreads, numberOfRows));
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(SampleFieldThread, &job);
+  threader->SingleMethodExecute();
+}
+
+//----------------------------------------------------------------------------
+bool vtkTransformDisplacementFieldCache::Update()
+{
+  if (!this->TransformNode)
+    {
+    vtkErrorMacro("Update: Transform node is not set");
+    return false;
+    }
+  int dimensions[3] = {0, 0, 0};
+  this->GetFieldDimensions(dimensions);
+  if (dimensions[0] == 0 || dimensions[1] == 0 || dimensions[2] == 0)
+    {
+    vtkDebugMacro("Update: Empty bounds or invalid spacing, no displacement field is sampled");
+    return false;
+    }
+
+  unsigned long latestMTime = std::max(this->GetMTime(), this->GetTransformNodeMTime());
+  if (this->ForwardField && this->BuildTime.GetMTime() > latestMTime)
+    {
+    return true;
+    }
+
+  // New images and transforms are created on each update so that the
+  // grid transforms returned earlier are not modified behind their users
+  this->ForwardField = vtkSmartPointer<vtkImageData>::New();
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  this->TransformNode->GetTransformToWorld(transformToWorld.GetPointer());
+  this->SampleDisplacementField(transformToWorld.GetPointer(), this->ForwardField);
+  this->ForwardTransform = vtkSmartPointer<vtkOrientedGridTransform>::New();
+  this->ForwardTransform->SetDisplacementGridData(this->ForwardField);
+  this->ForwardTransform->SetInterpolationModeToLinear();
+
+  this->InverseField = NULL;
+  this->InverseTransform = NULL;
+  if (this->ComputeInverse)
+    {
+    this->InverseField = vtkSmartPointer<vtkImageData>::New();
+    vtkNew<vtkGeneralTransform> transformFromWorld;
+    this->TransformNode->GetTransformFromWorld(transformFromWorld.GetPointer());
+    this->SampleDisplacementField(transformFromWorld.GetPointer(), this->InverseField);
+    this->InverseTransform = vtkSmartPointer<vtkOrientedGridTransform>::New();
+    this->InverseTransform->SetDisplacementGridData(this->InverseField);
+    this->InverseTransform->SetInterpolationModeToLinear();
+    }
+
+  this->BuildTime.Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedGridTransform* vtkTransformDisplacementFieldCache::GetTransformToWorld()
+{
+  if (!this->Update())
+    {
+    return NULL;
+    }
+  return this->ForwardTransform;
+}
+
+//----------------------------------------------------------------------------
+vtkOrientedGridTransform* vtkTransformDisplacementFieldCache::GetTransformFromWorld()
+{
+  if (!this->Update())
+    {
+    return NULL;
+    }
+  return this->InverseTransform;
+}
+
+//----------------------------------------------------------------------------
+bool vtkTransformDisplacementFieldCache::TransformPoints(vtkPoints* inputPoints, vtkPoints* outputPoints, bool inverse/*=false*/)
+{
+  if (!this->TransformNode)
+    {
+    vtkErrorMacro("TransformPoints: Transform node is not set");
+    return false;
+    }
+  if (!inputPoints || !outputPoints)
+    {
+    vtkErrorMacro("TransformPoints: Invalid points");
+    return false;
+    }
+
+  vtkNew<vtkGeneralTransform> exactTransform;
+  if (inverse)
+    {
+    this->TransformNode->GetTransformFromWorld(exactTransform.GetPointer());
+    }
+  else
+    {
+    this->TransformNode->GetTransformToWorld(exactTransform.GetPointer());
+    }
+
+  DisplacementField field;
+  TransformPointsJob job;
+  job.Transform = exactTransform.GetPointer();
+  job.Field = NULL;
+  job.InputPoints = inputPoints;
+  job.OutputPoints = outputPoints;
+  if (this->Update())
+    {
+    vtkImageData* fieldImage = (inverse ? this->InverseField.GetPointer() : this->ForwardField.GetPointer());
+    if (fieldImage)
+      {
+      GetDisplacementField(fieldImage, field);
+      job.Field = &field;
+      }
+    }
+
+  ExecuteTransformPoints(&job, this->NumberOfThreads);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkTransformDisplacementFieldCache::TransformPointsExact(vtkAbstractTransform* transform,
+  vtkPoints* inputPoints, vtkPoints* outputPoints, int numberOfThreads/*=0*/)
+{
+  if (!transform || !inputPoints || !outputPoints)
+    {
+    vtkGenericWarningMacro("vtkTransformDisplacementFieldCache::TransformPointsExact: Invalid input");
+    return;
+    }
+  TransformPointsJob job;
+  job.Transform = transform;
+  job.Field = NULL;
+  job.InputPoints = inputPoints;
+  job.OutputPoints = outputPoints;
+  ExecuteTransformPoints(&job, numberOfThreads);
+}
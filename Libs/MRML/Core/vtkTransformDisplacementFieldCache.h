@@ -0,0 +1,134 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkTransformDisplacementFieldCache_h
+#define __vtkTransformDisplacementFieldCache_h
+
+#include "vtkMRMLWin32Header.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
+#include <vtkWeakPointer.h>
+
+class vtkAbstractTransform;
+class vtkImageData;
+class vtkMRMLTransformNode;
+class vtkOrientedGridTransform;
+class vtkPoints;
+
+/// \brief Displacement field sampled from the transform to world of a transform node.
+///
+/// Evaluating a non-linear transform chain (b-spline, grid, thin plate spline, composite
+/// or inverse transforms) is expensive for each point, and the inverse of a warp transform is
+/// solved iteratively for each point. This class samples the displacement of the transform to world,
+/// and optionally of the transform from world, on a regular grid covering the Bounds with the
+/// given Spacing. The samples are computed once, in parallel, and are reused until the transform
+/// node, its transform to world or the sampling parameters change (GetTransformToWorldMTime).
+/// The fields are available as grid transforms that interpolate them, and points can be transformed
+/// in bulk by multiple threads. A coarser Spacing makes the field cheaper to compute at the price of
+/// the accuracy of the trilinear interpolation.
+/// Each transform node keeps a cache (vtkMRMLTransformNode::GetDisplacementFieldCache) so that
+/// the field is shared by the users of the same transform. The transform node is not referenced
+/// by the cache.
+class VTK_MRML_EXPORT vtkTransformDisplacementFieldCache : public vtkObject
+{
+public:
+  static vtkTransformDisplacementFieldCache *New();
+  vtkTypeMacro(vtkTransformDisplacementFieldCache, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Transform node whose transform to world is sampled
+  void SetTransformNode(vtkMRMLTransformNode* transformNode);
+  vtkMRMLTransformNode* GetTransformNode();
+
+  /// Region covered by the displacement field in world (RAS) coordinates (xmin, xmax, ymin, ymax, zmin, zmax)
+  vtkGetVector6Macro(Bounds, double);
+  vtkSetVector6Macro(Bounds, double);
+
+  /// Return true if the bounds are within the Bounds of the field
+  bool ContainsBounds(const double bounds[6]);
+
+  /// Distance between the samples of the displacement field in mm. 1 by default.
+  vtkGetMacro(Spacing, double);
+  vtkSetMacro(Spacing, double);
+
+  /// Sample the displacement of the transform from world as well. On by default.
+  vtkGetMacro(ComputeInverse, bool);
+  vtkSetMacro(ComputeInverse, bool);
+  vtkBooleanMacro(ComputeInverse, bool);
+
+  /// Number of threads. 0 (default) uses the default number of threads of vtkMultiThreader.
+  vtkGetMacro(NumberOfThreads, int);
+  vtkSetMacro(NumberOfThreads, int);
+
+  /// Sample the displacement fields if they are missing or out of date
+  /// \return False if there is no transform node or if the bounds are empty
+  bool Update();
+
+  /// Number of samples of the displacement field along each axis
+  /// that the current bounds and spacing result in
+  void GetFieldDimensions(int dimensions[3]);
+
+  /// Grid transform that interpolates the sampled transform to world.
+  /// The field is updated if needed. NULL if the field cannot be computed.
+  vtkOrientedGridTransform* GetTransformToWorld();
+
+  /// Grid transform that interpolates the sampled transform from world.
+  /// The field is updated if needed. NULL if the field cannot be computed or ComputeInverse is off.
+  vtkOrientedGridTransform* GetTransformFromWorld();
+
+  /// Transform points from the transform node coordinate system to world (or from world if inverse is true).
+  /// The displacement is interpolated from the cached field inside the bounds and the points outside
+  /// are transformed exactly. The points are split between the threads.
+  /// \return False if the transform node is not set
+  bool TransformPoints(vtkPoints* inputPoints, vtkPoints* outputPoints, bool inverse=false);
+
+  /// Transform points exactly by a transform, with the points split between the threads.
+  /// The transform is updated before the threads start, the threads only evaluate it.
+  /// \param numberOfThreads Number of threads, 0 uses the default number of threads
+  static void TransformPointsExact(vtkAbstractTransform* transform, vtkPoints* inputPoints, vtkPoints* outputPoints, int numberOfThreads=0);
+
+protected:
+  /// Time of the latest change of the transform node or of its transform to world
+  unsigned long GetTransformNodeMTime();
+
+  /// Sample the displacement of a transform on the field grid into a 3-component image.
+  /// The geometry of the field is set from the bounds and the spacing.
+  void SampleDisplacementField(vtkAbstractTransform* transform, vtkImageData* field);
+
+protected:
+  vtkWeakPointer<vtkMRMLTransformNode> TransformNode;
+  double Bounds[6];
+  double Spacing;
+  bool ComputeInverse;
+  int NumberOfThreads;
+
+  /// Sampled displacement fields and the grid transforms interpolating them
+  vtkSmartPointer<vtkImageData> ForwardField;
+  vtkSmartPointer<vtkImageData> InverseField;
+  vtkSmartPointer<vtkOrientedGridTransform> ForwardTransform;
+  vtkSmartPointer<vtkOrientedGridTransform> InverseTransform;
+
+  /// Time when the displacement fields were sampled
+  vtkTimeStamp BuildTime;
+
+protected:
+  vtkTransformDisplacementFieldCache();
+  virtual ~vtkTransformDisplacementFieldCache();
+
+private:
+  vtkTransformDisplacementFieldCache(const vtkTransformDisplacementFieldCache&); // Not implemented
+  void operator=(const vtkTransformDisplacementFieldCache&); // Not implemented
+};
+
+#endif
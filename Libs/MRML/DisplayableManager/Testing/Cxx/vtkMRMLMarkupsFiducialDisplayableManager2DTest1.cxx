@@ -0,0 +1,236 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLDisplayableManagerGroup.h>
+#include <vtkMRMLMarkupsFiducialDisplayableManager2D.h>
+
+// MRMLLogic includes
+#include <vtkMRMLApplicationLogic.h>
+
+// MRML includes
+#include <vtkMRMLMarkupsFiducialNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSliceNode.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Give access to the batch rendering methods
+class vtkTestMarkupsFiducialDisplayableManager2D
+  : public vtkMRMLMarkupsFiducialDisplayableManager2D
+{
+public:
+  static vtkTestMarkupsFiducialDisplayableManager2D *New();
+  vtkTypeMacro(vtkTestMarkupsFiducialDisplayableManager2D,
+               vtkMRMLMarkupsFiducialDisplayableManager2D);
+
+  using vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateActiveBatchMarkup;
+  using vtkMRMLMarkupsFiducialDisplayableManager2D::GetSeedIndex;
+  using vtkMRMLMarkupsFiducialDisplayableManager2D::GetBatchGlyphs;
+  using vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateBatchGlyphs;
+
+protected:
+  vtkTestMarkupsFiducialDisplayableManager2D() {}
+  ~vtkTestMarkupsFiducialDisplayableManager2D() {}
+};
+vtkStandardNewMacro(vtkTestMarkupsFiducialDisplayableManager2D);
+
+//----------------------------------------------------------------------------
+void WorldToDisplay(vtkMRMLSliceNode* sliceNode, double world[3], double display[2])
+{
+  vtkNew<vtkMatrix4x4> rasToXY;
+  vtkMatrix4x4::Invert(sliceNode->GetXYToRAS(), rasToXY.GetPointer());
+  double ras[4] = {world[0], world[1], world[2], 1.};
+  double xy[4];
+  rasToXY->MultiplyPoint(ras, xy);
+  display[0] = xy[0];
+  display[1] = xy[1];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType GetNumberOfGlyphPoints(vtkTestMarkupsFiducialDisplayableManager2D* displayableManager)
+{
+  displayableManager->UpdateBatchGlyphs();
+  return displayableManager->GetBatchGlyphs()->GetNumberOfPoints();
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager2DTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkRenderWindow> renderWindow;
+  vtkNew<vtkRenderWindowInteractor> renderWindowInteractor;
+  renderWindow->SetSize(600, 600);
+  renderWindow->SetMultiSamples(0);
+  renderWindow->AddRenderer(renderer.GetPointer());
+  renderWindow->SetInteractor(renderWindowInteractor.GetPointer());
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLApplicationLogic> applicationLogic;
+  applicationLogic->SetMRMLScene(scene.GetPointer());
+
+  // axial slice, 2 pixels per mm
+  vtkNew<vtkMRMLSliceNode> sliceNode;
+  sliceNode->SetLayoutName("Red");
+  sliceNode->SetOrientationToAxial();
+  sliceNode->SetDimensions(600, 600, 1);
+  sliceNode->SetFieldOfView(300., 300., 1.);
+  scene->AddNode(sliceNode.GetPointer());
+
+  vtkNew<vtkMRMLDisplayableManagerGroup> displayableManagerGroup;
+  displayableManagerGroup->SetRenderer(renderer.GetPointer());
+  displayableManagerGroup->SetMRMLDisplayableNode(sliceNode.GetPointer());
+
+  vtkNew<vtkTestMarkupsFiducialDisplayableManager2D> markupsDisplayableManager;
+  markupsDisplayableManager->SetMRMLApplicationLogic(applicationLogic.GetPointer());
+  markupsDisplayableManager->SetBatchRenderingThreshold(100);
+  displayableManagerGroup->AddDisplayableManager(markupsDisplayableManager.GetPointer());
+  displayableManagerGroup->GetInteractor()->Initialize();
+
+  // a 20x15 grid of seeds on the slice and a 10x10 grid 10 mm above, 10 mm apart
+  vtkNew<vtkMRMLMarkupsFiducialNode> fiducialNode;
+  scene->AddNode(fiducialNode.GetPointer());
+  fiducialNode->CreateDefaultDisplayNodes();
+  for (int j = 0; j < 15; ++j)
+    {
+    for (int i = 0; i < 20; ++i)
+      {
+      fiducialNode->AddFiducial(-95. + i * 10., -70. + j * 10., 0.);
+      }
+    }
+  for (int j = 0; j < 10; ++j)
+    {
+    for (int i = 0; i < 10; ++i)
+      {
+      fiducialNode->AddFiducial(-45. + i * 10., -45. + j * 10., 10.);
+      }
+    }
+  if (!markupsDisplayableManager->IsBatchRendered(fiducialNode.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": fiducials are not batch rendered" << std::endl;
+    return EXIT_FAILURE;
+    }
+  renderWindow->Render();
+
+  // only the seeds on the slice are drawn (slice projection is off)
+  vtkIdType onSlicePoints = GetNumberOfGlyphPoints(markupsDisplayableManager.GetPointer());
+  if (onSlicePoints == 0 || onSlicePoints % 300 != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << onSlicePoints
+              << " glyph points for 300 seeds on the slice" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkIdType pointsPerGlyph = onSlicePoints / 300;
+  sliceNode->SetSliceOffset(10.);
+  if (GetNumberOfGlyphPoints(markupsDisplayableManager.GetPointer()) != 100 * pointsPerGlyph)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << GetNumberOfGlyphPoints(markupsDisplayableManager.GetPointer())
+              << " glyph points for 100 seeds on the slice" << std::endl;
+    return EXIT_FAILURE;
+    }
+  sliceNode->SetSliceOffset(5.);
+  if (GetNumberOfGlyphPoints(markupsDisplayableManager.GetPointer()) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": glyphs drawn on an empty slice" << std::endl;
+    return EXIT_FAILURE;
+    }
+  sliceNode->SetSliceOffset(0.);
+
+  // hovering a seed makes it the active one, it is drawn by its handle
+  int activeIndex = 7 * 20 + 12;
+  double position[3];
+  double display[2];
+  fiducialNode->GetNthFiducialPosition(activeIndex, position);
+  WorldToDisplay(sliceNode.GetPointer(), position, display);
+  if (!markupsDisplayableManager->UpdateActiveBatchMarkup(display[0] + 1., display[1]) ||
+      markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), activeIndex) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": seed " << activeIndex
+              << " not activated under the cursor" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (GetNumberOfGlyphPoints(markupsDisplayableManager.GetPointer()) != 299 * pointsPerGlyph)
+    {
+    std::cerr << "Line " << __LINE__ << ": active seed " << activeIndex
+              << " is still drawn by the glyphs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the seeds above the slice cannot be activated
+  int offSliceIndex = 300 + 5 * 10 + 5;
+  fiducialNode->GetNthFiducialPosition(offSliceIndex, position);
+  WorldToDisplay(sliceNode.GetPointer(), position, display);
+  markupsDisplayableManager->UpdateActiveBatchMarkup(display[0], display[1]);
+  if (markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), offSliceIndex) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << ": seed " << offSliceIndex
+              << " activated out of the slice" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the active seed leaves the slice
+  sliceNode->SetSliceOffset(10.);
+  if (markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), activeIndex) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << ": seed " << activeIndex
+              << " is still active out of the slice" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // scroll through the slices
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  const int numberOfSlices = 200;
+  for (int slice = 0; slice < numberOfSlices; ++slice)
+    {
+    sliceNode->SetSliceOffset(-50. + slice * 0.5);
+    renderWindow->Render();
+    }
+  timer->StopTimer();
+  std::cout << numberOfSlices << " slices scrolled through "
+            << fiducialNode->GetNumberOfMarkups() << " batch rendered seeds: "
+            << timer->GetElapsedTime() << "s" << std::endl;
+
+  // below the threshold, each seed has a handle again
+  markupsDisplayableManager->SetBatchRenderingThreshold(1000);
+  sliceNode->SetSliceOffset(0.);
+  if (markupsDisplayableManager->IsBatchRendered(fiducialNode.GetPointer()) ||
+      GetNumberOfGlyphPoints(markupsDisplayableManager.GetPointer()) != 0 ||
+      markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), activeIndex) != activeIndex)
+    {
+    std::cerr << "Line " << __LINE__ << ": fiducials are still batch rendered" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  markupsDisplayableManager->SetMRMLApplicationLogic(0);
+  return EXIT_SUCCESS;
+}
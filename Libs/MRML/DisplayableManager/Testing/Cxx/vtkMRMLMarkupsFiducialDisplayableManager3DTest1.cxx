@@ -0,0 +1,220 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLDisplayableManagerGroup.h>
+#include <vtkMRMLMarkupsFiducialDisplayableManager3D.h>
+
+// MRMLLogic includes
+#include <vtkMRMLApplicationLogic.h>
+
+// MRML includes
+#include <vtkEventBroker.h>
+#include <vtkMRMLMarkupsFiducialNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLViewNode.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+/// Give access to the batch picking methods
+class vtkTestMarkupsFiducialDisplayableManager3D
+  : public vtkMRMLMarkupsFiducialDisplayableManager3D
+{
+public:
+  static vtkTestMarkupsFiducialDisplayableManager3D *New();
+  vtkTypeMacro(vtkTestMarkupsFiducialDisplayableManager3D,
+               vtkMRMLMarkupsFiducialDisplayableManager3D);
+
+  using vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateActiveBatchMarkup;
+  using vtkMRMLMarkupsFiducialDisplayableManager3D::GetSeedIndex;
+
+protected:
+  vtkTestMarkupsFiducialDisplayableManager3D() {}
+  ~vtkTestMarkupsFiducialDisplayableManager3D() {}
+};
+vtkStandardNewMacro(vtkTestMarkupsFiducialDisplayableManager3D);
+
+//----------------------------------------------------------------------------
+void WorldToDisplay(vtkRenderer* renderer, double world[3], double display[2])
+{
+  renderer->SetWorldPoint(world[0], world[1], world[2], 1.);
+  renderer->WorldToDisplay();
+  double* displayPoint = renderer->GetDisplayPoint();
+  display[0] = displayPoint[0];
+  display[1] = displayPoint[1];
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager3DTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkRenderWindow> renderWindow;
+  vtkNew<vtkRenderWindowInteractor> renderWindowInteractor;
+  renderWindow->SetSize(600, 600);
+  renderWindow->SetMultiSamples(0);
+  renderWindow->AddRenderer(renderer.GetPointer());
+  renderWindow->SetInteractor(renderWindowInteractor.GetPointer());
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLApplicationLogic> applicationLogic;
+  applicationLogic->SetMRMLScene(scene.GetPointer());
+
+  vtkNew<vtkMRMLViewNode> viewNode;
+  scene->AddNode(viewNode.GetPointer());
+
+  vtkNew<vtkMRMLDisplayableManagerGroup> displayableManagerGroup;
+  displayableManagerGroup->SetRenderer(renderer.GetPointer());
+  displayableManagerGroup->SetMRMLDisplayableNode(viewNode.GetPointer());
+
+  vtkNew<vtkTestMarkupsFiducialDisplayableManager3D> markupsDisplayableManager;
+  markupsDisplayableManager->SetMRMLApplicationLogic(applicationLogic.GetPointer());
+  markupsDisplayableManager->SetBatchRenderingThreshold(100);
+  displayableManagerGroup->AddDisplayableManager(markupsDisplayableManager.GetPointer());
+  displayableManagerGroup->GetInteractor()->Initialize();
+
+  // a 100x100 grid of seeds, 10 mm apart
+  vtkNew<vtkMRMLMarkupsFiducialNode> fiducialNode;
+  scene->AddNode(fiducialNode.GetPointer());
+  fiducialNode->CreateDefaultDisplayNodes();
+  const int gridSize = 100;
+  for (int j = 0; j < gridSize; ++j)
+    {
+    for (int i = 0; i < gridSize; ++i)
+      {
+      fiducialNode->AddFiducial(i * 10., j * 10., 0.);
+      }
+    }
+  if (!markupsDisplayableManager->IsBatchRendered(fiducialNode.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": fiducials are not batch rendered" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  renderer->ResetCamera();
+  renderWindow->Render();
+
+  // hovering a seed makes it the active one
+  int firstIndex = 55 * gridSize + 40;
+  double position[3];
+  double display[2];
+  fiducialNode->GetNthFiducialPosition(firstIndex, position);
+  WorldToDisplay(renderer.GetPointer(), position, display);
+  if (!markupsDisplayableManager->UpdateActiveBatchMarkup(display[0] + 1., display[1]) ||
+      markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), firstIndex) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": seed " << firstIndex
+              << " not activated under the cursor" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // moving over the active seed does not change anything
+  if (markupsDisplayableManager->UpdateActiveBatchMarkup(display[0], display[1]))
+    {
+    std::cerr << "Line " << __LINE__ << ": active seed changed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // another seed
+  int secondIndex = 10 * gridSize + 90;
+  fiducialNode->GetNthFiducialPosition(secondIndex, position);
+  WorldToDisplay(renderer.GetPointer(), position, display);
+  if (!markupsDisplayableManager->UpdateActiveBatchMarkup(display[0], display[1] - 1.) ||
+      markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), secondIndex) != 0 ||
+      markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), firstIndex) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << ": seed " << secondIndex
+              << " not activated under the cursor" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // a moved seed is found at its new position
+  int movedIndex = 20 * gridSize + 20;
+  fiducialNode->SetNthFiducialPosition(movedIndex, 5., 995., 0.);
+  double moved[3] = {5., 995., 0.};
+  WorldToDisplay(renderer.GetPointer(), moved, display);
+  if (!markupsDisplayableManager->UpdateActiveBatchMarkup(display[0], display[1]) ||
+      markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), movedIndex) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": moved seed " << movedIndex
+              << " not activated under the cursor" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // mouse moves over the view, the camera does not change
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  const int numberOfMoves = 1000;
+  int* size = renderer->GetSize();
+  for (int move = 0; move < numberOfMoves; ++move)
+    {
+    markupsDisplayableManager->UpdateActiveBatchMarkup(
+      (move * 7) % size[0], (move * 13) % size[1]);
+    }
+  timer->StopTimer();
+  std::cout << numberOfMoves << " mouse moves over " << gridSize * gridSize
+            << " batch rendered seeds: " << timer->GetElapsedTime() << "s" << std::endl;
+
+  // point moves are coalesced and processed when the view renders the next frame
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  broker->SetEventModeToFrameCoalesced();
+  broker->ResetEventCounters();
+  fiducialNode->GetNthFiducialPosition(secondIndex, position);
+  WorldToDisplay(renderer.GetPointer(), position, display);
+  markupsDisplayableManager->UpdateActiveBatchMarkup(display[0], display[1]);
+  const int numberOfDrags = 50;
+  for (int drag = 1; drag <= numberOfDrags; ++drag)
+    {
+    fiducialNode->SetNthFiducialPosition(movedIndex, 5. + drag, 995., 0.);
+    }
+  if (broker->GetNumberOfQueuedObservations() == 0 ||
+      broker->GetNumberOfDroppedEvents() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": point moves are not coalesced" << std::endl;
+    return EXIT_FAILURE;
+    }
+  renderWindow->Render();
+  if (broker->GetNumberOfQueuedObservations() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": coalesced events not processed by the render" << std::endl;
+    return EXIT_FAILURE;
+    }
+  double dragged[3] = {5. + numberOfDrags, 995., 0.};
+  WorldToDisplay(renderer.GetPointer(), dragged, display);
+  markupsDisplayableManager->UpdateActiveBatchMarkup(display[0], display[1]);
+  if (markupsDisplayableManager->GetSeedIndex(fiducialNode.GetPointer(), movedIndex) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": dragged seed " << movedIndex
+              << " not activated under the cursor" << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->SetEventModeToSynchronous();
+
+  markupsDisplayableManager->SetMRMLApplicationLogic(0);
+  return EXIT_SUCCESS;
+}
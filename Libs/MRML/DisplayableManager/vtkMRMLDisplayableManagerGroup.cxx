@@ -29,6 +29,7 @@
 #endif
 
 // MRML includes
+#include <vtkEventBroker.h>
 #include <vtkMRMLNode.h>
 
 // VTK includes
@@ -68,6 +69,8 @@ public:
       NameToDisplayableManagerMapIt;
 
   vtkSmartPointer<vtkCallbackCommand>   CallBackCommand;
+  // Observes the event broker and the renderer to process the coalesced events
+  vtkSmartPointer<vtkCallbackCommand>   FrameCallBackCommand;
   vtkMRMLDisplayableManagerFactory*     DisplayableManagerFactory;
   vtkMRMLNode*                          MRMLDisplayableNode;
   vtkRenderer*                          Renderer;
@@ -83,6 +86,7 @@ vtkMRMLDisplayableManagerGroup::vtkInternal::vtkInternal()
   this->MRMLDisplayableNode = 0;
   this->Renderer = 0;
   this->CallBackCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+  this->FrameCallBackCommand = vtkSmartPointer<vtkCallbackCommand>::New();
   this->DisplayableManagerFactory = 0;
   this->LightBoxRendererManagerProxy = 0;
 }
@@ -96,6 +100,10 @@ vtkMRMLDisplayableManagerGroup::vtkMRMLDisplayableManagerGroup()
   this->Internal = new vtkInternal;
   this->Internal->CallBackCommand->SetCallback(Self::DoCallback);
   this->Internal->CallBackCommand->SetClientData(this);
+  this->Internal->FrameCallBackCommand->SetCallback(Self::DoFrameCallback);
+  this->Internal->FrameCallBackCommand->SetClientData(this);
+  vtkEventBroker::GetInstance()->AddObserver(
+    vtkEventBroker::CoalescedEventsPendingEvent, this->Internal->FrameCallBackCommand);
 }
 
 //----------------------------------------------------------------------------
@@ -103,6 +111,7 @@ vtkMRMLDisplayableManagerGroup::~vtkMRMLDisplayableManagerGroup()
 {
   this->SetAndObserveDisplayableManagerFactory(0);
   this->SetMRMLDisplayableNode(0);
+  vtkEventBroker::GetInstance()->RemoveObserver(this->Internal->FrameCallBackCommand);
 
   for(size_t i=0; i < this->Internal->DisplayableManagers.size(); ++i)
     {
@@ -111,6 +120,7 @@ vtkMRMLDisplayableManagerGroup::~vtkMRMLDisplayableManagerGroup()
 
   if (this->Internal->Renderer)
     {
+    this->Internal->Renderer->RemoveObserver(this->Internal->FrameCallBackCommand);
     this->Internal->Renderer->UnRegister(this);
     }
 
@@ -312,6 +322,7 @@ void vtkMRMLDisplayableManagerGroup::SetRenderer(vtkRenderer* newRenderer)
 
   if (this->Internal->Renderer)
     {
+    this->Internal->Renderer->RemoveObserver(this->Internal->FrameCallBackCommand);
     this->Internal->Renderer->Delete();
     }
 
@@ -320,6 +331,8 @@ void vtkMRMLDisplayableManagerGroup::SetRenderer(vtkRenderer* newRenderer)
   if (this->Internal->Renderer)
     {
     this->Internal->Renderer->Register(this);
+    this->Internal->Renderer->AddObserver(
+      vtkCommand::StartEvent, this->Internal->FrameCallBackCommand);
     }
 
   vtkDebugMacro(<< this->GetClassName() << " (" << this << "): "
@@ -355,6 +368,27 @@ void vtkMRMLDisplayableManagerGroup::RequestRender()
   this->InvokeEvent(vtkCommand::UpdateEvent);
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLDisplayableManagerGroup::DoFrameCallback(vtkObject* vtkNotUsed(vtk_obj),
+                                                     unsigned long event,
+                                                     void* client_data,
+                                                     void* vtkNotUsed(call_data))
+{
+  vtkMRMLDisplayableManagerGroup* self =
+      reinterpret_cast<vtkMRMLDisplayableManagerGroup*>(client_data);
+  assert(self);
+  if (event == vtkEventBroker::CoalescedEventsPendingEvent)
+    {
+    // the events are processed when the next frame is rendered
+    self->RequestRender();
+    }
+  else if (event == vtkCommand::StartEvent)
+    {
+    // update the displayable managers of all the views before rendering
+    vtkEventBroker::GetInstance()->ProcessCoalescedEvents();
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkRenderer* vtkMRMLDisplayableManagerGroup::GetRenderer()
 {
@@ -40,6 +40,10 @@ class vtkRenderWindowInteractor;
 /// When the displayable managers in the group request the view to be
 /// refreshed, the group fires a vtkCommand::UpdateEvent event.
 /// This event can be observed and trigger a Render on the render window.
+/// In vtkEventBroker::FrameCoalesced mode, the group requests a render when
+/// events are coalesced by the event broker and the coalesced events are
+/// processed when the renderer starts rendering, so that the displayable
+/// managers are updated once per frame.
 class VTK_MRML_DISPLAYABLEMANAGER_EXPORT vtkMRMLDisplayableManagerGroup : public vtkObject
 {
 public:
@@ -125,6 +129,10 @@ protected:
   typedef vtkMRMLDisplayableManagerGroup Self;
   static void DoCallback(vtkObject* vtk_obj, unsigned long event,
                          void* client_data, void* call_data);
+  /// Process the coalesced events of the event broker when the renderer starts
+  /// rendering and request a render when events are coalesced
+  static void DoFrameCallback(vtkObject* vtk_obj, unsigned long event,
+                              void* client_data, void* call_data);
   /// Trigger upon a DisplayableManager is either registered or unregistered from
   /// the associated factory
   void onDisplayableManagerFactoryRegisteredEvent(const char* displayableManagerName);
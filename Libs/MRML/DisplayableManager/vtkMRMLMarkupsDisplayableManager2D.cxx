@@ -27,6 +27,7 @@
 #include <vtkMRMLModelDisplayableManager.h>
 
 // MRML includes
+#include <vtkEventBroker.h>
 #include <vtkMRMLApplicationLogic.h>
 #include <vtkMRMLInteractionNode.h>
 #include <vtkMRMLScene.h>
@@ -42,6 +43,7 @@
 #include <vtkCallbackCommand.h>
 #include <vtkCamera.h>
 #include <vtkHandleRepresentation.h>
+#include <vtkIdList.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -71,9 +73,51 @@ typedef void (*fp)(void);
 //---------------------------------------------------------------------------
 vtkStandardNewMacro (vtkMRMLMarkupsDisplayableManager2D);
 
+//---------------------------------------------------------------------------
+class vtkMRMLMarkupsDisplayableManager2D::vtkInternal
+{
+public:
+  vtkInternal();
+
+  /// Projection of the first point of all the markups of a node
+  struct MarkupsProjection
+    {
+    MarkupsProjection() : NodeMTime(0), TransformMTime(0)
+      {
+      this->Axis[0] = this->Axis[1] = this->Axis[2] = 0.;
+      }
+    unsigned long NodeMTime;
+    unsigned long TransformMTime;
+    /// World position of the first point of each markup (x, y, z, ...)
+    std::vector<double> WorldPositions;
+    /// Slice axis (third row of the world to display matrix without its
+    /// offset) the distances are computed along
+    double Axis[3];
+    /// Distance of each markup along the axis
+    std::vector<double> Distances;
+    /// (distance, markup index) sorted by distance
+    std::vector<std::pair<double, int> > SortedDistances;
+    };
+  typedef std::map<vtkMRMLMarkupsNode*, MarkupsProjection> ProjectionsMap;
+
+  ProjectionsMap Projections;
+
+  vtkNew<vtkMatrix4x4> WorldToDisplay;
+  vtkMatrix4x4* WorldToDisplaySource;
+  unsigned long WorldToDisplayMTime;
+};
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsDisplayableManager2D::vtkInternal::vtkInternal()
+  : WorldToDisplaySource(0)
+  , WorldToDisplayMTime(0)
+{
+}
+
 //---------------------------------------------------------------------------
 vtkMRMLMarkupsDisplayableManager2D::vtkMRMLMarkupsDisplayableManager2D()
 {
+  this->Internal = new vtkInternal;
   this->Helper = vtkMRMLMarkupsDisplayableManagerHelper::New();
   this->ClickCounter = vtkMRMLMarkupsClickCounter::New();
   this->DisableInteractorStyleEventsProcessing = 0;
@@ -104,8 +148,11 @@ vtkMRMLMarkupsDisplayableManager2D::~vtkMRMLMarkupsDisplayableManager2D()
 
   this->Helper->Delete();
   this->ClickCounter->Delete();
+  vtkEventBroker::GetInstance()->RemoveObserverEventCoalescing(this);
 
   this->SliceNode = 0;
+
+  delete this->Internal;
 }
 
 //---------------------------------------------------------------------------
@@ -128,6 +175,7 @@ void vtkMRMLMarkupsDisplayableManager2D::PrintSelf(ostream& os, vtkIndent indent
     os << indent << "Focus = " << this->Focus << std::endl;
     }
   os << indent << "ScaleFactor2D = " << this->ScaleFactor2D << std::endl;
+  os << indent << "Number of projected markups nodes = " << this->Internal->Projections.size() << std::endl;
 }
 
 //---------------------------------------------------------------------------
@@ -151,8 +199,23 @@ void vtkMRMLMarkupsDisplayableManager2D::SetAndObserveNode(vtkMRMLMarkupsNode *m
    {
    vtkUnObserveMRMLNodeMacro(markupsNode);
    vtkObserveMRMLNodeEventsMacro(markupsNode, nodeEvents.GetPointer());
+   // a burst of node modifications or point moves (e.g. from a tracker or
+   // while dragging) is processed once per frame when the event broker
+   // coalesces events
+   this->SetMarkupsNodeEventCoalescing(markupsNode, true);
    }
 }
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManager2D::SetMarkupsNodeEventCoalescing(vtkMRMLMarkupsNode *markupsNode, bool coalesce)
+{
+  // the events coalesced by the event broker are invoked without call data,
+  // the point modified event then updates all the points
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  broker->SetObservationEventCoalescing(markupsNode, this, vtkCommand::ModifiedEvent, coalesce);
+  broker->SetObservationEventCoalescing(markupsNode, this, vtkMRMLMarkupsNode::PointModifiedEvent, coalesce);
+  broker->SetObservationEventCoalescing(markupsNode, this, vtkMRMLTransformableNode::TransformModifiedEvent, coalesce);
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsDisplayableManager2D::SetAndObserveNodes()
 {
@@ -292,6 +355,12 @@ void vtkMRMLMarkupsDisplayableManager2D::SetMRMLSceneInternal(vtkMRMLScene* newS
   if (newScene)
     {
     this->AddObserversToInteractionNode();
+    // the markups are projected again once per frame while the slice moves
+    if (this->GetMRMLSliceNode())
+      {
+      vtkEventBroker::GetInstance()->SetObservationEventCoalescing(
+        this->GetMRMLSliceNode(), this, vtkCommand::ModifiedEvent, true);
+      }
     }
   else
     {
@@ -389,6 +458,7 @@ void vtkMRMLMarkupsDisplayableManager2D::OnMRMLSceneEndClose()
   vtkDebugMacro("OnMRMLSceneEndClose: remove observers?");
   // run through all nodes and remove node and widget
   this->Helper->RemoveAllWidgetsAndNodes();
+  this->Internal->Projections.clear();
 
   this->SetUpdateFromMRMLRequested(1);
   this->RequestRender();
@@ -509,9 +579,11 @@ void vtkMRMLMarkupsDisplayableManager2D::OnMRMLSceneNodeRemoved(vtkMRMLNode* nod
 
   // Remove the widget and the MRMLnode from the internal lists.
   this->Helper->RemoveWidgetAndNode(markupsNode);
+  this->InvalidateMarkupsProjection(markupsNode);
 
   // Refresh observers
   vtkUnObserveMRMLNodeMacro(markupsNode);
+  this->SetMarkupsNodeEventCoalescing(markupsNode, false);
 
   // and render again after seeds were removed
   this->RequestRender();
@@ -607,11 +679,18 @@ void vtkMRMLMarkupsDisplayableManager2D::OnMRMLMarkupsPointModifiedEvent(vtkMRML
     {
     return;
     }
+  // the point may have moved while the modified events were disabled
+  this->InvalidateMarkupsProjection(markupsNode);
   vtkAbstractWidget *widget = this->Helper->GetWidget(markupsNode);
   if (widget)
     {
-    // Update the standard settings of all widgets.
-    this->UpdateNthSeedPositionFromMRML(n, widget, markupsNode);
+    // Coalesced events have no point index, all the points are updated by
+    // PropagateMRMLToWidget
+    if (n >= 0)
+      {
+      // Update the standard settings of all widgets.
+      this->UpdateNthSeedPositionFromMRML(n, widget, markupsNode);
+      }
 
     // Propagate MRML changes to widget
     this->PropagateMRMLToWidget(markupsNode, widget);
@@ -635,6 +714,7 @@ void vtkMRMLMarkupsDisplayableManager2D::OnMRMLMarkupsNodeTransformModifiedEvent
     vtkErrorMacro("OnMRMLMarkupsNodeTransformModifiedEvent - Can not access node.")
     return;
     }
+  this->InvalidateMarkupsProjection(markupsNode);
 
   vtkAbstractWidget *widget = this->Helper->GetWidget(markupsNode);
   if (widget)
@@ -851,6 +931,12 @@ bool vtkMRMLMarkupsDisplayableManager2D::IsWidgetDisplayableOnSlice(vtkMRMLMarku
     }
 
   int numberOfControlPoints =  controlPointsNode->GetNumberOfPointsInNthMarkup(markupIndex);
+  if (numberOfControlPoints == 1 &&
+      this->IsMarkupOnSlice(controlPointsNode, markupIndex) == 0)
+    {
+    // most markups are away from the slice, skip the viewport checks
+    return false;
+    }
   for (int i=0; i < numberOfControlPoints; i++)
     {
     // we loop through all controlpoints of each node
@@ -1217,12 +1303,7 @@ void vtkMRMLMarkupsDisplayableManager2D::GetWorldToDisplayCoordinates(double r,
     }
 
   // we will get the transformation matrix to convert world coordinates to the display coordinates of the specific sliceNode
-
-  vtkMatrix4x4 * xyToRasMatrix = this->GetMRMLSliceNode()->GetXYToRAS();
-  vtkNew<vtkMatrix4x4> rasToXyMatrix;
-
-  // we need to invert this matrix
-  xyToRasMatrix->Invert(xyToRasMatrix, rasToXyMatrix.GetPointer());
+  vtkMatrix4x4 * rasToXyMatrix = this->GetWorldToDisplayMatrix();
 
   double worldCoordinates[4];
   worldCoordinates[0] = r;
@@ -1231,7 +1312,140 @@ void vtkMRMLMarkupsDisplayableManager2D::GetWorldToDisplayCoordinates(double r,
   worldCoordinates[3] = 1;
 
   rasToXyMatrix->MultiplyPoint(worldCoordinates,displayCoordinates);
-  xyToRasMatrix = NULL;
+}
+
+//---------------------------------------------------------------------------
+vtkMatrix4x4* vtkMRMLMarkupsDisplayableManager2D::GetWorldToDisplayMatrix()
+{
+  vtkMatrix4x4 * xyToRasMatrix = this->GetMRMLSliceNode() ?
+    this->GetMRMLSliceNode()->GetXYToRAS() : 0;
+  if (!xyToRasMatrix)
+    {
+    return this->Internal->WorldToDisplay.GetPointer();
+    }
+  // we need to invert this matrix, only when it changes
+  if (xyToRasMatrix != this->Internal->WorldToDisplaySource ||
+      xyToRasMatrix->GetMTime() != this->Internal->WorldToDisplayMTime)
+    {
+    vtkMatrix4x4::Invert(xyToRasMatrix, this->Internal->WorldToDisplay.GetPointer());
+    this->Internal->WorldToDisplaySource = xyToRasMatrix;
+    this->Internal->WorldToDisplayMTime = xyToRasMatrix->GetMTime();
+    }
+  return this->Internal->WorldToDisplay.GetPointer();
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsDisplayableManager2D::UpdateMarkupsProjection(vtkMRMLMarkupsNode* node)
+{
+  if (!node || !this->GetMRMLSliceNode() || this->IsInLightboxMode())
+    {
+    return false;
+    }
+  vtkInternal::MarkupsProjection& projection = this->Internal->Projections[node];
+
+  // world positions, in one pass over the markups
+  unsigned long transformMTime = node->GetParentTransformNode() ?
+    node->GetParentTransformNode()->GetMTime() : 0;
+  int numberOfMarkups = node->GetNumberOfMarkups();
+  bool positionsChanged = false;
+  if (projection.NodeMTime != node->GetMTime() ||
+      projection.TransformMTime != transformMTime ||
+      static_cast<int>(projection.Distances.size()) != numberOfMarkups)
+    {
+    projection.WorldPositions.resize(3 * numberOfMarkups);
+    for (int n = 0; n < numberOfMarkups; ++n)
+      {
+      double* position = &projection.WorldPositions[3 * n];
+      if (node->GetNumberOfPointsInNthMarkup(n) < 1)
+        {
+        // never on the slice
+        position[0] = position[1] = position[2] = VTK_DOUBLE_MAX;
+        continue;
+        }
+      double worldCoordinates[4];
+      node->GetMarkupPointWorld(n, 0, worldCoordinates);
+      position[0] = worldCoordinates[0];
+      position[1] = worldCoordinates[1];
+      position[2] = worldCoordinates[2];
+      }
+    projection.NodeMTime = node->GetMTime();
+    projection.TransformMTime = transformMTime;
+    positionsChanged = true;
+    }
+
+  // distances along the slice axis, only when the slice is rotated or the
+  // markups moved: scrolling just changes the offset of the axis
+  vtkMatrix4x4* worldToDisplay = this->GetWorldToDisplayMatrix();
+  double axis[3] = { worldToDisplay->GetElement(2, 0),
+                     worldToDisplay->GetElement(2, 1),
+                     worldToDisplay->GetElement(2, 2) };
+  if (positionsChanged ||
+      axis[0] != projection.Axis[0] ||
+      axis[1] != projection.Axis[1] ||
+      axis[2] != projection.Axis[2])
+    {
+    projection.Axis[0] = axis[0];
+    projection.Axis[1] = axis[1];
+    projection.Axis[2] = axis[2];
+    projection.Distances.resize(numberOfMarkups);
+    projection.SortedDistances.resize(numberOfMarkups);
+    for (int n = 0; n < numberOfMarkups; ++n)
+      {
+      const double* position = &projection.WorldPositions[3 * n];
+      double distance = (position[0] == VTK_DOUBLE_MAX) ? VTK_DOUBLE_MAX :
+        vtkMath::Dot(axis, position);
+      projection.Distances[n] = distance;
+      projection.SortedDistances[n] = std::make_pair(distance, n);
+      }
+    std::sort(projection.SortedDistances.begin(), projection.SortedDistances.end());
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManager2D::InvalidateMarkupsProjection(vtkMRMLMarkupsNode* node)
+{
+  this->Internal->Projections.erase(node);
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsDisplayableManager2D::GetMarkupsOnSlice(vtkMRMLMarkupsNode* node, vtkIdList* markupIndices)
+{
+  if (!markupIndices || !this->UpdateMarkupsProjection(node))
+    {
+    return false;
+    }
+  markupIndices->Reset();
+  const vtkInternal::MarkupsProjection& projection = this->Internal->Projections[node];
+  // the display z coordinate is the distance to the slice, see IsWidgetDisplayableOnSlice
+  double offset = this->GetWorldToDisplayMatrix()->GetElement(2, 3);
+  double maxDistance = 0.5 + (this->GetMRMLSliceNode()->GetDimensions()[2] - 1);
+  std::vector<std::pair<double, int> >::const_iterator it = std::lower_bound(
+    projection.SortedDistances.begin(), projection.SortedDistances.end(),
+    std::make_pair(-0.5 - offset, -1));
+  for (; it != projection.SortedDistances.end() && it->first + offset < maxDistance; ++it)
+    {
+    markupIndices->InsertNextId(it->second);
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsDisplayableManager2D::IsMarkupOnSlice(vtkMRMLMarkupsNode* node, int markupIndex)
+{
+  if (!this->UpdateMarkupsProjection(node))
+    {
+    return -1;
+    }
+  const vtkInternal::MarkupsProjection& projection = this->Internal->Projections[node];
+  if (markupIndex < 0 || markupIndex >= static_cast<int>(projection.Distances.size()))
+    {
+    return -1;
+    }
+  double distanceToSlice = projection.Distances[markupIndex] +
+    this->GetWorldToDisplayMatrix()->GetElement(2, 3);
+  double maxDistance = 0.5 + (this->GetMRMLSliceNode()->GetDimensions()[2] - 1);
+  return (distanceToSlice >= -0.5 && distanceToSlice < maxDistance) ? 1 : 0;
 }
 
 //---------------------------------------------------------------------------
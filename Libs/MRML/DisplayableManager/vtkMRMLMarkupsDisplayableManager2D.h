@@ -38,6 +38,8 @@ class vtkMRMLMarkupsNode;
 class vtkSlicerViewerWidget;
 class vtkMRMLMarkupsDisplayNode;
 class vtkAbstractWidget;
+class vtkIdList;
+class vtkMatrix4x4;
 
 /// \ingroup Slicer_QtModules_Markups
 class  VTK_MRML_DISPLAYABLEMANAGER_EXPORT vtkMRMLMarkupsDisplayableManager2D :
@@ -155,6 +157,10 @@ protected:
 
   /// Observe one node
   void SetAndObserveNode(vtkMRMLMarkupsNode *markupsNode);
+  /// Opt in (or out) the high rate events of the node (modified, point
+  /// modified and transform modified) for being coalesced once per frame
+  /// \sa vtkEventBroker::SetObservationEventCoalescing
+  void SetMarkupsNodeEventCoalescing(vtkMRMLMarkupsNode *markupsNode, bool coalesce);
   /// Observe all associated nodes.
   void SetAndObserveNodes();
 
@@ -208,6 +214,31 @@ protected:
   void GetDisplayToViewportCoordinates(double x, double y, double * viewportCoordinates);
   void GetDisplayToViewportCoordinates(double *displayCoordinates, double * viewportCoordinates);
 
+  /// Return the world to display matrix of the slice: the inverse of the
+  /// XYToRAS matrix of the slice node, only recomputed when it changes.
+  vtkMatrix4x4* GetWorldToDisplayMatrix();
+
+  //
+  // Batched projection of the markups on the slice
+  //
+
+  /// Project the first point of all the markups of the node in one pass.
+  /// The markups are kept sorted by their position along the slice normal:
+  /// scrolling only moves the slice along its normal, the markups close to
+  /// the slice are then found by binary search without re-projecting them.
+  /// Return false if the projection can't be used (no slice node or light
+  /// box mode).
+  bool UpdateMarkupsProjection(vtkMRMLMarkupsNode* node);
+  /// Discard the projection of the node, to be called when its points moved.
+  void InvalidateMarkupsProjection(vtkMRMLMarkupsNode* node);
+  /// Fill markupIndices with the markups of the node whose first point is
+  /// within the slab of the slice (same criterion as
+  /// IsWidgetDisplayableOnSlice). Return false if the projection can't be used.
+  bool GetMarkupsOnSlice(vtkMRMLMarkupsNode* node, vtkIdList* markupIndices);
+  /// Return 1 if the first point of the markup is within the slab of the
+  /// slice, 0 if not and -1 if the projection can't be used.
+  int IsMarkupOnSlice(vtkMRMLMarkupsNode* node, int markupIndex);
+
   //
   // Widget functionality
   //
@@ -261,6 +292,9 @@ private:
 
   /// Scale factor for 2d windows
   double ScaleFactor2D;
+
+  class vtkInternal;
+  vtkInternal * Internal;
 };
 
 #endif
@@ -27,6 +27,7 @@
 #include <vtkMRMLDisplayableManagerGroup.h>
 
 // MRML includes
+#include <vtkEventBroker.h>
 #include <vtkMRMLApplicationLogic.h>
 #include <vtkMRMLInteractionNode.h>
 #include <vtkMRMLScene.h>
@@ -97,6 +98,7 @@ vtkMRMLMarkupsDisplayableManager3D::~vtkMRMLMarkupsDisplayableManager3D()
 
   this->Helper->Delete();
   this->ClickCounter->Delete();
+  vtkEventBroker::GetInstance()->RemoveObserverEventCoalescing(this);
 
 }
 
@@ -133,8 +135,23 @@ void vtkMRMLMarkupsDisplayableManager3D::SetAndObserveNode(vtkMRMLMarkupsNode *m
    {
    vtkUnObserveMRMLNodeMacro(markupsNode);
    vtkObserveMRMLNodeEventsMacro(markupsNode, nodeEvents.GetPointer());
+   // a burst of node modifications or point moves (e.g. from a tracker or
+   // while dragging) is processed once per frame when the event broker
+   // coalesces events
+   this->SetMarkupsNodeEventCoalescing(markupsNode, true);
    }
 }
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManager3D::SetMarkupsNodeEventCoalescing(vtkMRMLMarkupsNode *markupsNode, bool coalesce)
+{
+  // the events coalesced by the event broker are invoked without call data,
+  // the point modified event then updates all the points
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  broker->SetObservationEventCoalescing(markupsNode, this, vtkCommand::ModifiedEvent, coalesce);
+  broker->SetObservationEventCoalescing(markupsNode, this, vtkMRMLMarkupsNode::PointModifiedEvent, coalesce);
+  broker->SetObservationEventCoalescing(markupsNode, this, vtkMRMLTransformableNode::TransformModifiedEvent, coalesce);
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsDisplayableManager3D::SetAndObserveNodes()
 {
@@ -502,6 +519,7 @@ void vtkMRMLMarkupsDisplayableManager3D::OnMRMLSceneNodeRemoved(vtkMRMLNode* nod
 
   // Refresh observers
   vtkUnObserveMRMLNodeMacro(markupsNode);
+  this->SetMarkupsNodeEventCoalescing(markupsNode, false);
 
   // and render again after seeds were removed
   this->RequestRender();
@@ -600,8 +618,13 @@ void vtkMRMLMarkupsDisplayableManager3D::OnMRMLMarkupsPointModifiedEvent(vtkMRML
   vtkAbstractWidget *widget = this->Helper->GetWidget(markupsNode);
   if (widget)
     {
-    // Update the standard settings of all widgets.
-    this->UpdateNthSeedPositionFromMRML(n, widget, markupsNode);
+    // Coalesced events have no point index, all the points are updated by
+    // PropagateMRMLToWidget
+    if (n >= 0)
+      {
+      // Update the standard settings of all widgets.
+      this->UpdateNthSeedPositionFromMRML(n, widget, markupsNode);
+      }
 
     // Propagate MRML changes to widget
     this->PropagateMRMLToWidget(markupsNode, widget);
@@ -115,6 +115,10 @@ protected:
 
   /// Observe one node
   void SetAndObserveNode(vtkMRMLMarkupsNode *markupsNode);
+  /// Opt in (or out) the high rate events of the node (modified, point
+  /// modified and transform modified) for being coalesced once per frame
+  /// \sa vtkEventBroker::SetObservationEventCoalescing
+  void SetMarkupsNodeEventCoalescing(vtkMRMLMarkupsNode *markupsNode, bool coalesce);
   /// Observe all associated nodes.
   void SetAndObserveNodes();
 
@@ -127,7 +131,7 @@ protected:
   void OnMRMLMarkupsNodeTransformModifiedEvent(vtkMRMLNode* node);
   void OnMRMLMarkupsNodeLockModifiedEvent(vtkMRMLNode* node);
   void OnMRMLMarkupsDisplayNodeModifiedEvent(vtkMRMLNode *node);
-  void OnMRMLMarkupsPointModifiedEvent(vtkMRMLNode *node, int n);
+  virtual void OnMRMLMarkupsPointModifiedEvent(vtkMRMLNode *node, int n);
   /// Subclasses need to react to new markups being added to or removed
   /// from a markups node or modified
   virtual void OnMRMLMarkupsNodeMarkupAddedEvent(vtkMRMLMarkupsNode * vtkNotUsed(markupsNode)) {};
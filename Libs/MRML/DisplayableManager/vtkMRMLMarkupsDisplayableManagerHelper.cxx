@@ -223,6 +223,14 @@ void vtkMRMLMarkupsDisplayableManagerHelper::UpdateLocked(vtkMRMLMarkupsNode *no
       {
       vtkDebugMacro("UpdateLocked: have a seed widget, list unlocked, checking seeds");
       int numMarkups = node->GetNumberOfMarkups();
+      vtkSeedRepresentation *seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
+      if (seedRepresentation && seedRepresentation->GetNumberOfSeeds() < numMarkups)
+        {
+        // batch rendered markups only have a handle for the active markup,
+        // its lock is set when the handle is updated
+        vtkDebugMacro("UpdateLocked: fewer seeds than markups, not checking seeds");
+        return;
+        }
       for (int i = 0; i < numMarkups; i++)
         {
         if (seedWidget->GetSeed(i) == NULL)
@@ -33,18 +33,29 @@
 #include <vtkMRMLInteractionNode.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSelectionNode.h>
+#include <vtkMRMLSliceNode.h>
 
 // VTK includes
 #include <vtkAbstractWidget.h>
+#include <vtkActor2D.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCamera.h>
+#include <vtkCellArray.h>
 #include <vtkFollower.h>
 #include <vtkHandleRepresentation.h>
+#include <vtkIdList.h>
 #include <vtkInteractorStyle.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkOrientedPolygonalHandleRepresentation3D.h>
 #include <vtkPickingManager.h>
+#include <vtkPointData.h>
 #include <vtkPointHandleRepresentation2D.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataMapper2D.h>
 #include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
@@ -53,10 +64,14 @@
 #include <vtkSeedRepresentation.h>
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
+#include <map>
 #include <sstream>
 #include <string>
+#include <vector>
 
 //---------------------------------------------------------------------------
 vtkStandardNewMacro (vtkMRMLMarkupsFiducialDisplayableManager2D);
@@ -108,7 +123,8 @@ public:
           this->Node->SetAttribute("Markups.MovingInSliceView", sliceNode->GetLayoutName());
           std::ostringstream seedNumber;
           unsigned int *n =  reinterpret_cast<unsigned int *>(callData);
-          seedNumber << *n;
+          // the seed of a batch rendered node is the active markup
+          seedNumber << this->DisplayableManager->GetMarkupIndex(this->Node, *n);
           this->Node->SetAttribute("Markups.MovingMarkupIndex", seedNumber.str().c_str());
           }
         else
@@ -194,24 +210,491 @@ public:
     {
     this->Node = n;
     }
-  void SetDisplayableManager(vtkMRMLMarkupsDisplayableManager2D * dm)
+  void SetDisplayableManager(vtkMRMLMarkupsFiducialDisplayableManager2D * dm)
     {
     this->DisplayableManager = dm;
     }
 
   vtkAbstractWidget * Widget;
   vtkMRMLMarkupsNode * Node;
-  vtkMRMLMarkupsDisplayableManager2D * DisplayableManager;
+  vtkMRMLMarkupsFiducialDisplayableManager2D * DisplayableManager;
 };
 
+//---------------------------------------------------------------------------
+class vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal
+{
+public:
+  /// State of a batch rendered markups node
+  struct BatchMarkups
+    {
+    BatchMarkups() : ActiveIndex(-1) {}
+    /// Index of the markup represented by the interactive handle, -1 if none
+    int ActiveIndex;
+    };
+  typedef std::map<vtkMRMLMarkupsNode*, BatchMarkups> BatchMarkupsMap;
+
+  vtkInternal(vtkMRMLMarkupsFiducialDisplayableManager2D* external);
+  ~vtkInternal();
+
+  /// Return the batch of the node, 0 if the node is not batch rendered
+  BatchMarkups* GetBatch(vtkMRMLMarkupsNode* node);
+  BatchMarkups* GetOrCreateBatch(vtkMRMLMarkupsNode* node);
+  void RemoveBatch(vtkMRMLMarkupsNode* node);
+  void RemoveAllBatches();
+
+  /// Rebuild the glyphs before the next render
+  void GlyphsModified() { this->GlyphsUpToDate = false; }
+  /// Rebuild the glyphs of all the batches if they are out of date
+  void UpdateGlyphs();
+  /// Append the glyphs of the markups of the node on the slice and the
+  /// projections of the other ones
+  void AppendGlyphs(vtkMRMLMarkupsFiducialNode* node, const BatchMarkups& batch);
+  /// Append a copy of the shape, scaled to size pixels and centered on the
+  /// display position
+  void AppendGlyph(vtkPolyData* shape, const double displayPosition[2],
+                   double size, const unsigned char color[4]);
+  /// Glyph of unit size, the glyph sources are only run once per shape
+  vtkPolyData* GetGlyphShape(int glyphType, bool filled, bool projection);
+  /// Number of pixels of a unit of the renderer world, the unit the handles
+  /// of the markups on the slice are scaled in
+  double GetPixelsPerWorldUnit();
+
+  static void RenderStartCallback(vtkObject* caller, unsigned long eid,
+                                  void* clientData, void* callData);
+
+  vtkMRMLMarkupsFiducialDisplayableManager2D* External;
+  BatchMarkupsMap Batches;
+  /// Glyphs of all the batches, in display coordinates
+  vtkSmartPointer<vtkPolyData> Glyphs;
+  vtkSmartPointer<vtkUnsignedCharArray> GlyphColors;
+  vtkSmartPointer<vtkActor2D> Actor;
+  std::map<int, vtkSmartPointer<vtkPolyData> > GlyphShapes;
+  vtkSmartPointer<vtkCallbackCommand> RenderCallback;
+  vtkWeakPointer<vtkRenderer> ObservedRenderer;
+  bool GlyphsUpToDate;
+  /// Renderer size the glyphs were built for
+  int GlyphsRendererSize[2];
+};
+
+//---------------------------------------------------------------------------
+// vtkInternal methods
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal
+::vtkInternal(vtkMRMLMarkupsFiducialDisplayableManager2D* external)
+  : External(external)
+  , GlyphsUpToDate(false)
+{
+  this->GlyphsRendererSize[0] = this->GlyphsRendererSize[1] = 0;
+  this->RenderCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+  this->RenderCallback->SetClientData(this);
+  this->RenderCallback->SetCallback(vtkInternal::RenderStartCallback);
+
+  this->GlyphColors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  this->GlyphColors->SetName("Colors");
+  this->GlyphColors->SetNumberOfComponents(4);
+  this->Glyphs = vtkSmartPointer<vtkPolyData>::New();
+  vtkNew<vtkPoints> points;
+  this->Glyphs->SetPoints(points.GetPointer());
+  vtkNew<vtkCellArray> verts;
+  this->Glyphs->SetVerts(verts.GetPointer());
+  vtkNew<vtkCellArray> lines;
+  this->Glyphs->SetLines(lines.GetPointer());
+  vtkNew<vtkCellArray> polys;
+  this->Glyphs->SetPolys(polys.GetPointer());
+  this->Glyphs->GetPointData()->SetScalars(this->GlyphColors);
+
+  vtkNew<vtkPolyDataMapper2D> mapper;
+  mapper->SetInputData(this->Glyphs);
+  mapper->ScalarVisibilityOn();
+  mapper->SetScalarModeToUsePointData();
+  this->Actor = vtkSmartPointer<vtkActor2D>::New();
+  this->Actor->SetMapper(mapper.GetPointer());
+  // markups are picked by the handle of the active markup
+  this->Actor->PickableOff();
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::~vtkInternal()
+{
+  this->RemoveAllBatches();
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::BatchMarkups*
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::GetBatch(vtkMRMLMarkupsNode* node)
+{
+  BatchMarkupsMap::iterator it = this->Batches.find(node);
+  return it != this->Batches.end() ? &it->second : 0;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::BatchMarkups*
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::GetOrCreateBatch(vtkMRMLMarkupsNode* node)
+{
+  BatchMarkups* existingBatch = this->GetBatch(node);
+  if (existingBatch)
+    {
+    return existingBatch;
+    }
+  BatchMarkups& batch = this->Batches[node];
+  this->GlyphsModified();
+
+  vtkRenderer* renderer = this->External->GetRenderer();
+  if (renderer && this->ObservedRenderer.GetPointer() != renderer)
+    {
+    renderer->AddActor2D(this->Actor);
+    // after the coalesced events are processed (see vtkMRMLDisplayableManagerGroup)
+    renderer->AddObserver(vtkCommand::StartEvent, this->RenderCallback, -1.0);
+    this->ObservedRenderer = renderer;
+    }
+  return &batch;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::RemoveBatch(vtkMRMLMarkupsNode* node)
+{
+  BatchMarkupsMap::iterator it = this->Batches.find(node);
+  if (it == this->Batches.end())
+    {
+    return;
+    }
+  this->Batches.erase(it);
+  this->GlyphsModified();
+  if (this->Batches.empty() && this->ObservedRenderer)
+    {
+    this->ObservedRenderer->RemoveActor2D(this->Actor);
+    this->ObservedRenderer->RemoveObserver(this->RenderCallback);
+    this->ObservedRenderer = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::RemoveAllBatches()
+{
+  while (!this->Batches.empty())
+    {
+    this->RemoveBatch(this->Batches.begin()->first);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::UpdateGlyphs()
+{
+  vtkRenderer* renderer = this->External->GetRenderer();
+  int* size = renderer ? renderer->GetSize() : 0;
+  if (this->GlyphsUpToDate && size &&
+      size[0] == this->GlyphsRendererSize[0] &&
+      size[1] == this->GlyphsRendererSize[1])
+    {
+    return;
+    }
+  this->Glyphs->GetPoints()->Reset();
+  this->Glyphs->GetVerts()->Reset();
+  this->Glyphs->GetLines()->Reset();
+  this->Glyphs->GetPolys()->Reset();
+  this->GlyphColors->Reset();
+  for (BatchMarkupsMap::iterator it = this->Batches.begin(); it != this->Batches.end(); ++it)
+    {
+    vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+    if (fiducialNode)
+      {
+      this->AppendGlyphs(fiducialNode, it->second);
+      }
+    }
+  this->Glyphs->GetPoints()->Modified();
+  this->Glyphs->GetVerts()->Modified();
+  this->Glyphs->GetLines()->Modified();
+  this->Glyphs->GetPolys()->Modified();
+  this->GlyphColors->Modified();
+  this->Glyphs->DeleteCells();
+  this->Glyphs->Modified();
+
+  this->GlyphsUpToDate = true;
+  this->GlyphsRendererSize[0] = size ? size[0] : 0;
+  this->GlyphsRendererSize[1] = size ? size[1] : 0;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal
+::AppendGlyphs(vtkMRMLMarkupsFiducialNode* node, const BatchMarkups& batch)
+{
+  vtkMRMLMarkupsDisplayNode* displayNode = node->GetMarkupsDisplayNode();
+  vtkMRMLSliceNode* sliceNode = this->External->GetMRMLSliceNode();
+  if (!displayNode || !sliceNode || displayNode->GetVisibility() == 0 ||
+      displayNode->GetVisibility(sliceNode->GetID()) == 0)
+    {
+    return;
+    }
+  vtkNew<vtkIdList> onSliceIndices;
+  if (!this->External->GetMarkupsOnSlice(node, onSliceIndices.GetPointer()))
+    {
+    return;
+    }
+  int numberOfMarkups = node->GetNumberOfMarkups();
+  std::vector<bool> onSlice(numberOfMarkups, false);
+  for (vtkIdType i = 0; i < onSliceIndices->GetNumberOfIds(); ++i)
+    {
+    onSlice[onSliceIndices->GetId(i)] = true;
+    }
+
+  // 3D glyphs are drawn as their 2D counterpart, same as the handles (see SetNthSeed)
+  int glyphType = displayNode->GetGlyphType();
+  if (glyphType == vtkMRMLMarkupsDisplayNode::Sphere3D)
+    {
+    glyphType = vtkMRMLMarkupsDisplayNode::Circle2D;
+    }
+  else if (glyphType == vtkMRMLMarkupsDisplayNode::Diamond3D)
+    {
+    glyphType = vtkMRMLMarkupsDisplayNode::Diamond2D;
+    }
+  else if (displayNode->GlyphTypeIs3D())
+    {
+    glyphType = vtkMRMLMarkupsDisplayNode::StarBurst2D;
+    }
+
+  unsigned char colors[2][4];
+  double* nodeColors[2] = { displayNode->GetColor(), displayNode->GetSelectedColor() };
+  for (int selected = 0; selected < 2; ++selected)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      colors[selected][i] = static_cast<unsigned char>(
+        vtkMath::ClampValue(nodeColors[selected][i], 0., 1.) * 255.);
+      }
+    colors[selected][3] = static_cast<unsigned char>(
+      vtkMath::ClampValue(displayNode->GetOpacity(), 0., 1.) * 255.);
+    }
+
+  // markups on the slice, same size as the handles
+  vtkMatrix4x4* worldToDisplay = this->External->GetWorldToDisplayMatrix();
+  vtkPolyData* shape = this->GetGlyphShape(glyphType, true, false);
+  double size = displayNode->GetGlyphScale() * this->External->GetScaleFactor2D() *
+    this->GetPixelsPerWorldUnit();
+  for (vtkIdType i = 0; i < onSliceIndices->GetNumberOfIds(); ++i)
+    {
+    int n = static_cast<int>(onSliceIndices->GetId(i));
+    if (n == batch.ActiveIndex || !node->GetNthFiducialVisibility(n))
+      {
+      continue;
+      }
+    double worldCoordinates[4];
+    node->GetMarkupPointWorld(n, 0, worldCoordinates);
+    worldCoordinates[3] = 1.;
+    double displayCoordinates[4];
+    worldToDisplay->MultiplyPoint(worldCoordinates, displayCoordinates);
+    this->AppendGlyph(shape, displayCoordinates, size,
+                      colors[node->GetNthFiducialSelected(n) ? 1 : 0]);
+    }
+
+  // projection of the other markups, the trace markup is always projected
+  bool projected = (displayNode->GetSliceProjection() & vtkMRMLMarkupsDisplayNode::ProjectionOn) != 0;
+  int traceIndex = node->GetMarkupIndexByByLabel(vtkMRMLMarkupsNode::GetRealTraceMarkupLabel());
+  if (!projected && traceIndex < 0)
+    {
+    return;
+    }
+  unsigned char projectionColor[4];
+  double sliceProjectionColor[3];
+  displayNode->GetSliceProjectionColor(sliceProjectionColor);
+  for (int i = 0; i < 3; ++i)
+    {
+    projectionColor[i] = static_cast<unsigned char>(
+      vtkMath::ClampValue(sliceProjectionColor[i], 0., 1.) * 255.);
+    }
+  int firstIndex = projected ? 0 : traceIndex;
+  int lastIndex = projected ? numberOfMarkups - 1 : traceIndex;
+  for (int n = firstIndex; n <= lastIndex; ++n)
+    {
+    if (onSlice[n] || !node->GetNthFiducialVisibility(n))
+      {
+      continue;
+      }
+    bool trace = (n == traceIndex);
+    double worldCoordinates[4];
+    node->GetMarkupPointWorld(n, 0, worldCoordinates);
+    worldCoordinates[3] = 1.;
+    double displayCoordinates[4];
+    worldToDisplay->MultiplyPoint(worldCoordinates, displayCoordinates);
+
+    double projectionSize = displayNode->GetGlyphScale() * 2.0 * (trace ? 2.0 : 1.0);
+    double projectionOpacity = displayNode->GetSliceProjectionOpacity();
+    bool filled = true;
+    if (displayNode->GetSliceProjectionOutlinedBehindSlicePlane())
+      {
+      static const double threshold = 0.5;
+      if (displayCoordinates[2] < 0)
+        {
+        // outlined crosses and dashes extend to the edges of the viewer
+        filled = (glyphType == vtkMRMLMarkupsDisplayNode::Dash2D ||
+                  glyphType == vtkMRMLMarkupsDisplayNode::Cross2D);
+        }
+      if (fabs(displayCoordinates[2]) < threshold)
+        {
+        projectionOpacity = 1.0;
+        }
+      }
+    unsigned char* color = projectionColor;
+    if (displayNode->GetSliceProjectionUseFiducialColor())
+      {
+      color = colors[node->GetNthFiducialSelected(n) ? 1 : 0];
+      }
+    unsigned char rgba[4] = { color[0], color[1], color[2],
+      static_cast<unsigned char>(vtkMath::ClampValue(projectionOpacity, 0., 1.) * 255.) };
+    this->AppendGlyph(this->GetGlyphShape(glyphType, filled, true),
+                      displayCoordinates, projectionSize, rgba);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal
+::AppendGlyph(vtkPolyData* shape, const double displayPosition[2],
+              double size, const unsigned char color[4])
+{
+  vtkPoints* shapePoints = shape ? shape->GetPoints() : 0;
+  if (!shapePoints)
+    {
+    return;
+    }
+  vtkPoints* points = this->Glyphs->GetPoints();
+  vtkIdType offset = points->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < shapePoints->GetNumberOfPoints(); ++i)
+    {
+    double* point = shapePoints->GetPoint(i);
+    points->InsertNextPoint(displayPosition[0] + size * point[0],
+                            displayPosition[1] + size * point[1], 0.);
+    this->GlyphColors->InsertNextTupleValue(color);
+    }
+  vtkCellArray* shapeCells[3] = { shape->GetVerts(), shape->GetLines(), shape->GetPolys() };
+  vtkCellArray* cells[3] = { this->Glyphs->GetVerts(), this->Glyphs->GetLines(), this->Glyphs->GetPolys() };
+  for (int type = 0; type < 3; ++type)
+    {
+    vtkIdType npts = 0;
+    vtkIdType* pts = 0;
+    for (shapeCells[type]->InitTraversal(); shapeCells[type]->GetNextCell(npts, pts);)
+      {
+      cells[type]->InsertNextCell(npts);
+      for (vtkIdType i = 0; i < npts; ++i)
+        {
+        cells[type]->InsertCellPoint(pts[i] + offset);
+        }
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+vtkPolyData* vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal
+::GetGlyphShape(int glyphType, bool filled, bool projection)
+{
+  int key = 4 * glyphType + (filled ? 1 : 0) + (projection ? 2 : 0);
+  vtkSmartPointer<vtkPolyData>& shape = this->GlyphShapes[key];
+  if (!shape)
+    {
+    vtkNew<vtkMarkupsGlyphSource2D> glyphSource;
+    glyphSource->SetGlyphType(glyphType);
+    glyphSource->SetScale(1.0);
+    if (projection)
+      {
+      // same as the projection handles, see SetNthSeed
+      glyphSource->SetScale2(1.0);
+      }
+    glyphSource->SetFilled(filled ? 1 : 0);
+    glyphSource->Update();
+    shape = glyphSource->GetOutput();
+    }
+  return shape;
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::GetPixelsPerWorldUnit()
+{
+  vtkRenderer* renderer = this->External->GetRenderer();
+  if (!renderer || !renderer->IsActiveCameraCreated())
+    {
+    return 1.;
+    }
+  // height of the view in the focal plane, where the handles are placed
+  vtkCamera* camera = renderer->GetActiveCamera();
+  double worldHeight = camera->GetParallelProjection() ?
+    2. * camera->GetParallelScale() :
+    2. * camera->GetDistance() * tan(vtkMath::RadiansFromDegrees(camera->GetViewAngle()) / 2.);
+  return worldHeight > 0. ? renderer->GetSize()[1] / worldHeight : 1.;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal
+::RenderStartCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                      void* clientData, void* vtkNotUsed(callData))
+{
+  vtkInternal* self = reinterpret_cast<vtkInternal*>(clientData);
+  self->UpdateGlyphs();
+}
+
 //---------------------------------------------------------------------------
 // vtkMRMLMarkupsFiducialDisplayableManager2D methods
 
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkMRMLMarkupsFiducialDisplayableManager2D()
+{
+  this->Focus = "vtkMRMLMarkupsFiducialNode";
+  this->BatchRenderingThreshold = 100;
+  this->Internal = new vtkInternal(this);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::~vtkMRMLMarkupsFiducialDisplayableManager2D()
+{
+  delete this->Internal;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialDisplayableManager2D::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
   this->Helper->PrintSelf(os, indent);
+  os << indent << "BatchRenderingThreshold: " << this->BatchRenderingThreshold << "\n";
+  os << indent << "Number of batch rendered nodes: " << this->Internal->Batches.size() << "\n";
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager2D::IsBatchRendered(vtkMRMLMarkupsNode* node)
+{
+  return node && this->BatchRenderingThreshold > 0 && !this->IsInLightboxMode() &&
+         node->GetNumberOfMarkups() >= this->BatchRenderingThreshold;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager2D::GetSeedIndex(vtkMRMLMarkupsNode* node, int n)
+{
+  vtkInternal::BatchMarkups* batch = this->Internal->GetBatch(node);
+  if (!batch)
+    {
+    return n;
+    }
+  return (n == batch->ActiveIndex) ? 0 : -1;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager2D::GetMarkupIndex(vtkMRMLMarkupsNode* node, int seedIndex)
+{
+  vtkInternal::BatchMarkups* batch = this->Internal->GetBatch(node);
+  if (!batch)
+    {
+    return seedIndex;
+    }
+  return (seedIndex == 0) ? batch->ActiveIndex : -1;
+}
+
+//---------------------------------------------------------------------------
+vtkPolyData* vtkMRMLMarkupsFiducialDisplayableManager2D::GetBatchGlyphs()
+{
+  return this->Internal->Glyphs;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateBatchGlyphs()
+{
+  this->Internal->UpdateGlyphs();
 }
 
 //---------------------------------------------------------------------------
@@ -352,7 +835,10 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthMarkupPositionFromWidg
     {
     return false;
     }
-  if (n > pointsNode->GetNumberOfMarkups())
+  // the seed of a batch rendered node is the active markup
+  int seedIndex = n;
+  n = this->GetMarkupIndex(pointsNode, seedIndex);
+  if (n < 0 || n > pointsNode->GetNumberOfMarkups())
     {
     return false;
     }
@@ -380,7 +866,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthMarkupPositionFromWidg
 
   this->GetWorldToDisplayCoordinates(pointTransformed,displayCoordinates1);
 
-  seedRepresentation->GetSeedDisplayPosition(n,displayCoordinatesBuffer1);
+  seedRepresentation->GetSeedDisplayPosition(seedIndex,displayCoordinatesBuffer1);
 
   if (this->GetDisplayCoordinatesChanged(displayCoordinates1,displayCoordinatesBuffer1))
     {
@@ -416,6 +902,17 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthSeedPositionFromMRML(i
     {
     return false;
     }
+  int seedIndex = this->GetSeedIndex(pointsNode, n);
+  if (seedIndex < 0)
+    {
+    // batch rendered markup without handle, its glyph is rebuilt
+    this->Internal->GlyphsModified();
+    return false;
+    }
+  if (seedIndex >= seedRepresentation->GetNumberOfSeeds())
+    {
+    return false;
+    }
   bool positionChanged = false;
 
 //  std::cout << "UpdateNthSeedPositionFromMRML: n = " << n << std::endl;
@@ -431,7 +928,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthSeedPositionFromMRML(i
 
   this->GetWorldToDisplayCoordinates(pointTransformed,displayCoordinates1);
 
-  seedRepresentation->GetSeedDisplayPosition(n,displayCoordinatesBuffer1);
+  seedRepresentation->GetSeedDisplayPosition(seedIndex,displayCoordinatesBuffer1);
 
   if (this->GetDisplayCoordinatesChanged(displayCoordinates1,displayCoordinatesBuffer1))
     {
@@ -444,7 +941,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthSeedPositionFromMRML(i
     if (seedRepresentation->GetRenderer() != NULL &&
         seedRepresentation->GetRenderer()->IsActiveCameraCreated())
       {
-      seedRepresentation->SetSeedDisplayPosition(n,displayCoordinates1);
+      seedRepresentation->SetSeedDisplayPosition(seedIndex,displayCoordinates1);
       positionChanged = true;
       }
     else
@@ -484,12 +981,24 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
     return;
     }
 
+  // batch rendered markups are glyphs, only the active one has a handle
+  vtkInternal::BatchMarkups* batch = this->Internal->GetBatch(fiducialNode);
+  if (batch)
+    {
+    this->Internal->GlyphsModified();
+    }
+  int seedIndex = this->GetSeedIndex(fiducialNode, n);
+  if (seedIndex < 0)
+    {
+    return;
+    }
+
   int numberOfHandles = seedRepresentation->GetNumberOfSeeds();
-  vtkDebugMacro("SetNthSeed, n = " << n << ", number of handles = " << numberOfHandles);
+  vtkDebugMacro("SetNthSeed, n = " << n << ", seed index = " << seedIndex << ", number of handles = " << numberOfHandles);
 
   // does this handle need to be created?
   bool createdNewHandle = false;
-  if (n >= numberOfHandles)
+  if (seedIndex >= numberOfHandles)
     {
     // create a new handle
     vtkHandleWidget* newhandle = seedWidget->CreateNewHandle();
@@ -521,10 +1030,10 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
 
   // can have a 3d or 2d handle depending on if in light box mode or not
   vtkOrientedPolygonalHandleRepresentation3D *handleRep =
-    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(seedRepresentation->GetHandleRepresentation(n));
+    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(seedRepresentation->GetHandleRepresentation(seedIndex));
   // might be in lightbox mode where using a 2d point handle
   vtkPointHandleRepresentation2D *pointHandleRep =
-    vtkPointHandleRepresentation2D::SafeDownCast(seedRepresentation->GetHandleRepresentation(n));
+    vtkPointHandleRepresentation2D::SafeDownCast(seedRepresentation->GetHandleRepresentation(seedIndex));
 
   // update the postion
   bool positionChanged = this->UpdateNthSeedPositionFromMRML(n, seedWidget, fiducialNode);
@@ -539,7 +1048,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
               << ", number of seeds = "
               <<  seedRepresentation->GetNumberOfSeeds()
               << ", handle rep = "
-              << (seedRepresentation->GetHandleRepresentation(n) ? seedRepresentation->GetHandleRepresentation(n)->GetClassName() : "null"));
+              << (seedRepresentation->GetHandleRepresentation(seedIndex) ? seedRepresentation->GetHandleRepresentation(seedIndex)->GetClassName() : "null"));
     return;
     }
 
@@ -556,7 +1065,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
   if (handleRep)
     {
     // set the glyph type if a new handle was created, or the glyph type changed
-    int oldGlyphType = this->Helper->GetNodeGlyphType(displayNode, n);
+    int oldGlyphType = this->Helper->GetNodeGlyphType(displayNode, seedIndex);
     if (createdNewHandle ||
         oldGlyphType != displayNode->GetGlyphType())
       {
@@ -599,7 +1108,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
         }
       // TBD: keep with the assumption of one glyph type per markups node,
       // that each seed has to have the same type, but update if necessary
-      this->Helper->SetNodeGlyphType(displayNode, displayNode->GetGlyphType(), n);
+      this->Helper->SetNodeGlyphType(displayNode, displayNode->GetGlyphType(), seedIndex);
       }  // end of glyph type
 
     // set the color
@@ -675,7 +1184,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
         {
         handleRep->LabelVisibilityOn();
         }
-      seedWidget->GetSeed(n)->EnabledOn();
+      seedWidget->GetSeed(seedIndex)->EnabledOn();
       // if the fiducial is visible, turn off projection
       vtkSeedWidget* fiducialSeed = vtkSeedWidget::SafeDownCast(this->Helper->GetPointProjectionWidget(fiducialNode->GetNthMarkupID(n)));
       if (fiducialSeed && fiducialSeed->GetSeed(0))
@@ -702,7 +1211,8 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
         }
 
       // if the widget is not shown on the slice, show the intersection
-      if (fiducialNode &&
+      // (the projections of batch rendered markups are glyphs)
+      if (!batch && fiducialNode &&
           fiducialNode->GetDisplayNode())
         {
         double transformedP1[4];
@@ -889,11 +1399,11 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
       }
     if (listLocked || seedLocked || persistentPlaceMode)
       {
-      seedWidget->GetSeed(n)->ProcessEventsOff();
+      seedWidget->GetSeed(seedIndex)->ProcessEventsOff();
       }
     else
       {
-      seedWidget->GetSeed(n)->ProcessEventsOn();
+      seedWidget->GetSeed(seedIndex)->ProcessEventsOn();
       }
 
     }
@@ -914,7 +1424,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
     // update visibility and enabled (if the point handle is still enabled
     // while invisible, mousing near it will show it)
     pointHandleRep->SetVisibility(fidVisible);
-    seedWidget->GetSeed(n)->SetEnabled(fidVisible);
+    seedWidget->GetSeed(seedIndex)->SetEnabled(fidVisible);
     }
 }
 
@@ -1072,10 +1582,76 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::PropagateMRMLToWidget(vtkMRMLMa
       }
     }
 
-  for (int n = 0; n < numberOfFiducials; n++)
+  // large lists are drawn by the batch glyphs, with only one handle
+  if (this->IsBatchRendered(fiducialNode) && displayNode)
     {
-    // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
-    this->SetNthSeed(n, fiducialNode, seedWidget);
+    bool newBatch = (this->Internal->GetBatch(fiducialNode) == 0);
+    vtkInternal::BatchMarkups* batch = this->Internal->GetOrCreateBatch(fiducialNode);
+    if (newBatch)
+      {
+      // the markups were handles and projection widgets so far
+      for (int seed = seedRepresentation->GetNumberOfSeeds() - 1; seed >= 0; --seed)
+        {
+        seedWidget->DeleteSeed(seed);
+        }
+      for (int n = 0; n < numberOfFiducials; n++)
+        {
+        vtkMRMLMarkupsDisplayableManagerHelper::WidgetPointProjectionsIt projectionIt =
+          this->Helper->WidgetPointProjections.find(fiducialNode->GetNthMarkupID(n));
+        if (projectionIt != this->Helper->WidgetPointProjections.end())
+          {
+          projectionIt->second->Off();
+          projectionIt->second->Delete();
+          this->Helper->WidgetPointProjections.erase(projectionIt);
+          }
+        }
+      }
+    // the glyphs are rebuilt before the next render
+    this->Internal->GlyphsModified();
+    if (batch->ActiveIndex >= numberOfFiducials ||
+        (batch->ActiveIndex >= 0 && this->IsMarkupOnSlice(fiducialNode, batch->ActiveIndex) == 0))
+      {
+      // the active markup left the slice
+      this->SetActiveBatchMarkup(fiducialNode, seedWidget, -1);
+      }
+    else if (batch->ActiveIndex >= 0)
+      {
+      this->SetNthSeed(batch->ActiveIndex, fiducialNode, seedWidget);
+      }
+    }
+  else
+    {
+    this->Internal->RemoveBatch(fiducialNode);
+
+    // find the fiducials close to the slice in one pass, the other ones only
+    // need updating if they're still shown or projected onto the slice
+    vtkNew<vtkIdList> onSliceIndices;
+    bool haveOnSlice = this->GetMarkupsOnSlice(fiducialNode, onSliceIndices.GetPointer());
+    std::vector<bool> onSlice(numberOfFiducials, !haveOnSlice);
+    for (vtkIdType i = 0; i < onSliceIndices->GetNumberOfIds(); ++i)
+      {
+      onSlice[onSliceIndices->GetId(i)] = true;
+      }
+    bool projected = displayNode &&
+      (displayNode->GetSliceProjection() & displayNode->ProjectionOn);
+
+    for (int n = 0; n < numberOfFiducials; n++)
+      {
+      // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
+      if (!onSlice[n] && !projected &&
+          fiducialNode->GetNthMarkupLabel(n).compare(
+            vtkMRMLMarkupsNode::GetRealTraceMarkupLabel()) != 0)
+        {
+        vtkHandleWidget *offSliceSeed = seedWidget->GetSeed(n);
+        if (offSliceSeed && offSliceSeed->GetHandleRepresentation() &&
+            !offSliceSeed->GetHandleRepresentation()->GetVisibility())
+          {
+          // already hidden
+          continue;
+          }
+        }
+      this->SetNthSeed(n, fiducialNode, seedWidget);
+      }
     }
 
 
@@ -1149,14 +1725,20 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::PropagateWidgetToMRML(vtkAbstra
   int numberOfSeeds = seedRepresentation->GetNumberOfSeeds();
 
   bool atLeastOnePositionChanged = false;
-  for (int n = 0; n < numberOfSeeds; n++)
+  for (int seed = 0; seed < numberOfSeeds; seed++)
     {
+    // the only seed of a batch rendered node is the active markup
+    int n = this->GetMarkupIndex(fiducialNode, seed);
+    if (n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+      {
+      continue;
+      }
     double worldCoordinates1[4];
     bool thisPositionChanged = false;
     // 2D widget was changed
 
     double displayCoordinates1[4];
-    seedRepresentation->GetSeedDisplayPosition(n,displayCoordinates1);
+    seedRepresentation->GetSeedDisplayPosition(seed,displayCoordinates1);
     vtkDebugMacro("PropagateWidgetToMRML: 2d DM: widget display coords = "
           << displayCoordinates1[0] << ", " << displayCoordinates1[1]
           << ", " << displayCoordinates1[2]);
@@ -1340,6 +1922,8 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::AdditionnalInitializeStep()
   // don't add the key press event, as it triggers a crash on start up
   //vtkDebugMacro("Adding an observer on the key press event");
   this->AddInteractorStyleObservableEvent(vtkCommand::KeyPressEvent);
+  // the handle of batch rendered markups follows the mouse
+  this->AddInteractorStyleObservableEvent(vtkCommand::MouseMoveEvent);
 }
 
 
@@ -1382,6 +1966,105 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnInteractorStyleEvent(int even
     {
     vtkDebugMacro("Got a key release event");
     }
+  else if (eventid == vtkCommand::MouseMoveEvent)
+    {
+    int *eventPosition = this->GetInteractor()->GetEventPosition();
+    if (this->UpdateActiveBatchMarkup(eventPosition[0], eventPosition[1]))
+      {
+      this->RequestRender();
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::SetActiveBatchMarkup(
+  vtkMRMLMarkupsFiducialNode* fiducialNode, vtkSeedWidget *seedWidget, int n)
+{
+  vtkInternal::BatchMarkups* batch = this->Internal->GetBatch(fiducialNode);
+  if (!batch || n == batch->ActiveIndex)
+    {
+    return;
+    }
+  batch->ActiveIndex = n;
+  // the previous active markup is a glyph again, the new one is not
+  this->Internal->GlyphsModified();
+  if (n < 0)
+    {
+    if (vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation())->GetNumberOfSeeds() > 0)
+      {
+      seedWidget->DeleteSeed(0);
+      }
+    return;
+    }
+  // moves the handle to the markup
+  this->SetNthSeed(n, fiducialNode, seedWidget);
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateActiveBatchMarkup(double x, double y)
+{
+  vtkMRMLSliceNode* sliceNode = this->GetMRMLSliceNode();
+  if (!sliceNode)
+    {
+    return false;
+    }
+  bool activeMarkupChanged = false;
+  for (vtkInternal::BatchMarkupsMap::iterator it = this->Internal->Batches.begin();
+       it != this->Internal->Batches.end(); ++it)
+    {
+    vtkInternal::BatchMarkups& batch = it->second;
+    vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+    vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(this->Helper->GetWidget(it->first));
+    vtkMRMLMarkupsDisplayNode* displayNode = fiducialNode ? fiducialNode->GetMarkupsDisplayNode() : 0;
+    if (!seedWidget || !displayNode ||
+        displayNode->GetVisibility() == 0 ||
+        displayNode->GetVisibility(sliceNode->GetID()) == 0 ||
+        seedWidget->GetWidgetState() == vtkSeedWidget::MovingSeed)
+      {
+      continue;
+      }
+    // same pixel tolerance as the handle
+    double tolerance = 15.;
+    vtkSeedRepresentation* seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
+    if (seedRepresentation->GetNumberOfSeeds() > 0)
+      {
+      tolerance = seedRepresentation->GetHandleRepresentation(0)->GetTolerance();
+      }
+    // only the markups on the slice can be moved, they are found without
+    // projecting the other ones
+    vtkNew<vtkIdList> onSliceIndices;
+    if (!this->GetMarkupsOnSlice(fiducialNode, onSliceIndices.GetPointer()))
+      {
+      continue;
+      }
+    int closestIndex = -1;
+    double closestDistance2 = tolerance * tolerance;
+    for (vtkIdType i = 0; i < onSliceIndices->GetNumberOfIds(); ++i)
+      {
+      int n = static_cast<int>(onSliceIndices->GetId(i));
+      if (!fiducialNode->GetNthFiducialVisibility(n))
+        {
+        continue;
+        }
+      double worldCoordinates[4];
+      fiducialNode->GetMarkupPointWorld(n, 0, worldCoordinates);
+      double displayCoordinates[4];
+      this->GetWorldToDisplayCoordinates(worldCoordinates, displayCoordinates);
+      double distance2 = (displayCoordinates[0] - x) * (displayCoordinates[0] - x) +
+                         (displayCoordinates[1] - y) * (displayCoordinates[1] - y);
+      if (distance2 < closestDistance2)
+        {
+        closestDistance2 = distance2;
+        closestIndex = n;
+        }
+      }
+    if (closestIndex >= 0 && closestIndex != batch.ActiveIndex)
+      {
+      this->SetActiveBatchMarkup(fiducialNode, seedWidget, closestIndex);
+      activeMarkupChanged = true;
+      }
+    }
+  return activeMarkupChanged;
 }
 
 
@@ -1420,12 +2103,23 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdatePosition(vtkAbstractWidge
   // disable processing of modified events
   //this->Updating = 1;
   bool positionChanged = false;
-  int numberOfFiducials = pointsNode->GetNumberOfMarkups();
-  for (int n = 0; n < numberOfFiducials; n++)
+  vtkInternal::BatchMarkups* batch = this->Internal->GetBatch(pointsNode);
+  if (batch)
+    {
+    // only the active markup has a seed, the glyphs are rebuilt
+    this->Internal->GlyphsModified();
+    positionChanged = batch->ActiveIndex >= 0 &&
+      this->UpdateNthSeedPositionFromMRML(batch->ActiveIndex, seedWidget, pointsNode);
+    }
+  else
     {
-    if (this->UpdateNthSeedPositionFromMRML(n, seedWidget, pointsNode))
+    int numberOfFiducials = pointsNode->GetNumberOfMarkups();
+    for (int n = 0; n < numberOfFiducials; n++)
       {
-      positionChanged = true;
+      if (this->UpdateNthSeedPositionFromMRML(n, seedWidget, pointsNode))
+        {
+        positionChanged = true;
+        }
       }
     }
   // did any of the positions change?
@@ -1449,6 +2143,14 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLSceneEndClose()
 
   // clear out the map of glyph types
   this->Helper->ClearNodeGlyphTypes();
+  this->Internal->RemoveAllBatches();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  this->Internal->RemoveBatch(vtkMRMLMarkupsNode::SafeDownCast(node));
+  this->Superclass::OnMRMLSceneNodeRemoved(node);
 }
 
 //---------------------------------------------------------------------------
@@ -1475,6 +2177,11 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeNthMarkupModif
    return;
    }
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(node), seedWidget);
+  if (this->Internal->GetBatch(node))
+    {
+    // the glyphs are not rendered by the widget
+    this->RequestRender();
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -1501,10 +2208,23 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeMarkupAddedEve
    return;
    }
 
+  if (this->IsBatchRendered(markupsNode) != (this->Internal->GetBatch(markupsNode) != 0))
+    {
+    // switch between batch and per handle rendering
+    this->PropagateMRMLToWidget(markupsNode, seedWidget);
+    this->RequestRender();
+    return;
+    }
+
   // this call will create a new handle and set it
+  // (or rebuild the glyphs if the node is batch rendered)
   // std::cout << "OnMRMLMarkupsNodeMarkupAddedEvent: adding to markups node that currently has " << markupsNode->GetNumberOfMarkups() << std::endl;
   int n = markupsNode->GetNumberOfMarkups() - 1;
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget);
+  if (this->Internal->GetBatch(markupsNode))
+    {
+    this->RequestRender();
+    }
 
   vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
   seedRepresentation->NeedToRenderOn();
@@ -1529,6 +2249,12 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeMarkupRemovedE
     }
 
   // for now, recreate the widget
+  // (the indices of the batch rendered markups changed)
+  vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(widget);
+  if (seedWidget && this->Internal->GetBatch(markupsNode))
+    {
+    this->SetActiveBatchMarkup(vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget, -1);
+    }
   this->Helper->RemoveWidgetAndNode(markupsNode);
   this->AddWidget(markupsNode);
 }
@@ -30,6 +30,7 @@
 class vtkMRMLMarkupsFiducialNode;
 class vtkSlicerViewerWidget;
 class vtkMRMLMarkupsDisplayNode;
+class vtkPolyData;
 class vtkTextWidget;
 
 /// \ingroup Slicer_QtModules_Markups
@@ -45,13 +46,32 @@ public:
   /// Update a single seed position from the node, return true if the position changed
   virtual bool UpdateNthSeedPositionFromMRML(int n, vtkAbstractWidget *widget, vtkMRMLMarkupsNode *pointsNode);
 
-  /// Update a single markup position from the seed widget, return true if the position changed
+  /// Update a single markup position from the seed widget, return true if the position changed.
+  /// n is the index of the seed in the widget.
   virtual bool UpdateNthMarkupPositionFromWidget(int n, vtkMRMLMarkupsNode* pointsNode, vtkAbstractWidget * widget);
 
+  /// Markups nodes with at least this number of markups are rendered in
+  /// batch: the markups on the slice and the projections of the other ones
+  /// are drawn by a single polydata shared by all the batch rendered nodes
+  /// of the view, and only the markup under the mouse cursor gets an
+  /// interactive handle (with its label).
+  /// 0 disables batch rendering. Default is 100. Not used in light box mode.
+  /// Takes effect the next time the node's markups are added or removed.
+  vtkSetClampMacro(BatchRenderingThreshold, int, 0, VTK_INT_MAX);
+  vtkGetMacro(BatchRenderingThreshold, int);
+
+  /// Return true if the markups of the node are rendered in batch.
+  /// \sa BatchRenderingThreshold
+  bool IsBatchRendered(vtkMRMLMarkupsNode* node);
+
+  /// Return the index of the markup represented by the nth seed of the
+  /// widget of the node, -1 if there is none.
+  int GetMarkupIndex(vtkMRMLMarkupsNode* node, int seedIndex);
+
 protected:
 
-  vtkMRMLMarkupsFiducialDisplayableManager2D(){this->Focus="vtkMRMLMarkupsFiducialNode";}
-  virtual ~vtkMRMLMarkupsFiducialDisplayableManager2D(){}
+  vtkMRMLMarkupsFiducialDisplayableManager2D();
+  virtual ~vtkMRMLMarkupsFiducialDisplayableManager2D();
 
   /// Callback for click in RenderWindow
   virtual void OnClickInRenderWindow(double x, double y, const char *associatedNodeID);
@@ -69,6 +89,21 @@ protected:
 
   /// Update a single seed from MRML
   void SetNthSeed(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, vtkSeedWidget *seedWidget);
+  /// Return the index of the seed of the widget that represents the nth
+  /// markup, -1 if the markup has no seed (batch rendered markup that is not
+  /// active).
+  int GetSeedIndex(vtkMRMLMarkupsNode* node, int n);
+  /// Make the nth markup of a batch rendered node the one represented by the
+  /// interactive handle. n = -1 hides the handle.
+  void SetActiveBatchMarkup(vtkMRMLMarkupsFiducialNode* fiducialNode, vtkSeedWidget *seedWidget, int n);
+  /// Activate the batch rendered markup on the slice under the display
+  /// position (if any). Return true if the active markup changed.
+  bool UpdateActiveBatchMarkup(double x, double y);
+  /// Polydata of the glyphs of all the batch rendered markups of the view,
+  /// in display coordinates. Updated before the view renders.
+  vtkPolyData* GetBatchGlyphs();
+  /// Rebuild the batch glyphs now instead of before the next render.
+  void UpdateBatchGlyphs();
   /// Propagate properties of MRML node to widget.
   virtual void PropagateMRMLToWidget(vtkMRMLMarkupsNode* node, vtkAbstractWidget * widget);
 
@@ -85,12 +120,19 @@ protected:
 
   // Clean up when scene closes
   virtual void OnMRMLSceneEndClose();
+  /// Remove the batch glyphs of the removed node
+  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
 
 private:
 
   vtkMRMLMarkupsFiducialDisplayableManager2D(const vtkMRMLMarkupsFiducialDisplayableManager2D&); /// Not implemented
   void operator=(const vtkMRMLMarkupsFiducialDisplayableManager2D&); /// Not Implemented
 
+  int BatchRenderingThreshold;
+
+  class vtkInternal;
+  vtkInternal * Internal;
+
 };
 
 #endif
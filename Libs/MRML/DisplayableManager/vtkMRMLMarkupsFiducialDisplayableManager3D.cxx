@@ -38,14 +38,23 @@
 
 // VTK includes
 #include <vtkAbstractWidget.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCamera.h>
 #include <vtkFollower.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkHandleRepresentation.h>
+#include <vtkIdList.h>
 #include <vtkInteractorStyle.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkOrientedPolygonalHandleRepresentation3D.h>
 #include <vtkPickingManager.h>
+#include <vtkPointData.h>
+#include <vtkPointLocator.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
 #include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
@@ -54,6 +63,10 @@
 #include <vtkSmartPointer.h>
 #include <vtkSeedRepresentation.h>
 #include <vtkSphereSource.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkWeakPointer.h>
 
 #include <vtkConeSource.h>
 #include <vtkPolyDataMapper.h>
@@ -64,6 +77,7 @@
 
 
 // STD includes
+#include <map>
 #include <sstream>
 #include <string>
 
@@ -137,14 +151,443 @@ public:
   vtkMRMLMarkupsDisplayableManager3D * DisplayableManager;
 };
 
+//---------------------------------------------------------------------------
+class vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+{
+public:
+  /// Glyphs of all the markups of a batch rendered markups node
+  struct BatchGlyphs
+    {
+    BatchGlyphs() : GlyphType(-1), GlyphScale(-1.), ActiveIndex(-1),
+      DisplayLocatorCameraMTime(0), DisplayLocatorPointsMTime(0)
+      {
+      DisplayLocatorSize[0] = DisplayLocatorSize[1] = 0;
+      }
+    vtkSmartPointer<vtkPoints> Points;
+    vtkSmartPointer<vtkUnsignedCharArray> Colors;
+    /// 0 for the markups that are not drawn as glyphs (hidden, active or
+    /// trace markup)
+    vtkSmartPointer<vtkUnsignedCharArray> Mask;
+    vtkSmartPointer<vtkPolyData> PolyData;
+    /// Orients the glyph parallel to the view plane and scales it
+    vtkSmartPointer<vtkTransform> GlyphTransform;
+    vtkSmartPointer<vtkTransformPolyDataFilter> GlyphFilter;
+    vtkSmartPointer<vtkGlyph3DMapper> Mapper;
+    vtkSmartPointer<vtkActor> Actor;
+    int GlyphType;
+    double GlyphScale;
+    /// Index of the markup represented by the interactive handle, -1 if none
+    int ActiveIndex;
+    /// Display positions of the glyphs (same indices as Points), to find the
+    /// glyph under the mouse cursor without projecting every markup
+    vtkSmartPointer<vtkPolyData> DisplayPolyData;
+    vtkSmartPointer<vtkPointLocator> DisplayLocator;
+    /// Camera, glyph positions and renderer size the locator was built for
+    unsigned long DisplayLocatorCameraMTime;
+    unsigned long DisplayLocatorPointsMTime;
+    int DisplayLocatorSize[2];
+    };
+  typedef std::map<vtkMRMLMarkupsNode*, BatchGlyphs> BatchGlyphsMap;
+
+  vtkInternal(vtkMRMLMarkupsFiducialDisplayableManager3D* external);
+  ~vtkInternal();
+
+  /// Return the batch glyphs of the node, 0 if the node is not batch rendered
+  BatchGlyphs* GetBatch(vtkMRMLMarkupsNode* node);
+  BatchGlyphs* GetOrCreateBatch(vtkMRMLMarkupsNode* node);
+  void RemoveBatch(vtkMRMLMarkupsNode* node);
+  void RemoveAllBatches();
+
+  /// Set the number of glyphs of the batch
+  void SetNumberOfGlyphs(BatchGlyphs& batch, int numberOfGlyphs);
+  /// Update the glyph and the display properties shared by all the markups
+  void UpdateBatchDisplay(BatchGlyphs& batch, vtkMRMLMarkupsDisplayNode* displayNode, bool visible);
+  /// Update the position of the nth glyph, return true if it changed
+  bool UpdateNthBatchPoint(BatchGlyphs& batch, vtkMRMLMarkupsNode* node, int n);
+  /// Update the position, color and visibility of the nth glyph
+  void UpdateNthBatchGlyph(BatchGlyphs& batch, vtkMRMLMarkupsFiducialNode* node,
+                           int n, vtkMRMLMarkupsDisplayNode* displayNode);
+  /// Return the locator of the glyph display positions, rebuilt only if
+  /// the camera, the glyph positions or the renderer size changed.
+  vtkPointLocator* GetDisplayLocator(BatchGlyphs& batch);
+  /// Keep the glyphs parallel to the view plane when the camera changes.
+  void UpdateGlyphTransforms();
+  void UpdateGlyphTransform(BatchGlyphs& batch);
+
+  static void RenderStartCallback(vtkObject* caller, unsigned long eid,
+                                  void* clientData, void* callData);
+
+  vtkMRMLMarkupsFiducialDisplayableManager3D* External;
+  BatchGlyphsMap Batches;
+  vtkSmartPointer<vtkCallbackCommand> RenderCallback;
+  vtkWeakPointer<vtkRenderer> ObservedRenderer;
+  unsigned long CameraMTime;
+};
+
+//---------------------------------------------------------------------------
+// vtkInternal methods
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+::vtkInternal(vtkMRMLMarkupsFiducialDisplayableManager3D* external)
+  : External(external)
+  , CameraMTime(0)
+{
+  this->RenderCallback = vtkSmartPointer<vtkCallbackCommand>::New();
+  this->RenderCallback->SetClientData(this);
+  this->RenderCallback->SetCallback(vtkInternal::RenderStartCallback);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::~vtkInternal()
+{
+  this->RemoveAllBatches();
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::BatchGlyphs*
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::GetBatch(vtkMRMLMarkupsNode* node)
+{
+  BatchGlyphsMap::iterator it = this->Batches.find(node);
+  return it != this->Batches.end() ? &it->second : 0;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::BatchGlyphs*
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::GetOrCreateBatch(vtkMRMLMarkupsNode* node)
+{
+  BatchGlyphs* existingBatch = this->GetBatch(node);
+  if (existingBatch)
+    {
+    return existingBatch;
+    }
+  BatchGlyphs& batch = this->Batches[node];
+
+  batch.Points = vtkSmartPointer<vtkPoints>::New();
+  batch.Colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  batch.Colors->SetName("Colors");
+  batch.Colors->SetNumberOfComponents(3);
+  batch.Mask = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  batch.Mask->SetName("Mask");
+  batch.PolyData = vtkSmartPointer<vtkPolyData>::New();
+  batch.PolyData->SetPoints(batch.Points);
+  batch.PolyData->GetPointData()->SetScalars(batch.Colors);
+  batch.PolyData->GetPointData()->AddArray(batch.Mask);
+
+  batch.GlyphTransform = vtkSmartPointer<vtkTransform>::New();
+  batch.GlyphFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+  batch.GlyphFilter->SetTransform(batch.GlyphTransform);
+
+  // the glyph transform scales and orients the glyph, the mapper only
+  // translates the instances
+  batch.Mapper = vtkSmartPointer<vtkGlyph3DMapper>::New();
+  batch.Mapper->SetInputData(batch.PolyData);
+  batch.Mapper->SetSourceConnection(batch.GlyphFilter->GetOutputPort());
+  batch.Mapper->ScalingOff();
+  batch.Mapper->OrientOff();
+  batch.Mapper->MaskingOn();
+  batch.Mapper->SetMaskArray("Mask");
+
+  batch.Actor = vtkSmartPointer<vtkActor>::New();
+  batch.Actor->SetMapper(batch.Mapper);
+  // markups are picked by the handle of the active markup
+  batch.Actor->PickableOff();
+
+  vtkRenderer* renderer = this->External->GetRenderer();
+  if (renderer)
+    {
+    renderer->AddActor(batch.Actor);
+    if (this->ObservedRenderer.GetPointer() != renderer)
+      {
+      renderer->AddObserver(vtkCommand::StartEvent, this->RenderCallback);
+      this->ObservedRenderer = renderer;
+      }
+    }
+  return &batch;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::RemoveBatch(vtkMRMLMarkupsNode* node)
+{
+  BatchGlyphsMap::iterator it = this->Batches.find(node);
+  if (it == this->Batches.end())
+    {
+    return;
+    }
+  if (this->ObservedRenderer)
+    {
+    this->ObservedRenderer->RemoveActor(it->second.Actor);
+    }
+  this->Batches.erase(it);
+  if (this->Batches.empty() && this->ObservedRenderer)
+    {
+    this->ObservedRenderer->RemoveObserver(this->RenderCallback);
+    this->ObservedRenderer = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::RemoveAllBatches()
+{
+  while (!this->Batches.empty())
+    {
+    this->RemoveBatch(this->Batches.begin()->first);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+::SetNumberOfGlyphs(BatchGlyphs& batch, int numberOfGlyphs)
+{
+  if (batch.Points->GetNumberOfPoints() == numberOfGlyphs)
+    {
+    return;
+    }
+  // existing values are kept, the new glyphs are hidden until updated
+  vtkIdType oldNumberOfGlyphs = batch.Points->GetNumberOfPoints();
+  batch.Points->SetNumberOfPoints(numberOfGlyphs);
+  batch.Colors->SetNumberOfTuples(numberOfGlyphs);
+  batch.Mask->SetNumberOfTuples(numberOfGlyphs);
+  for (vtkIdType i = oldNumberOfGlyphs; i < numberOfGlyphs; ++i)
+    {
+    batch.Points->SetPoint(i, 0., 0., 0.);
+    batch.Mask->SetValue(i, 0);
+    }
+  batch.Points->Modified();
+  batch.Mask->Modified();
+  if (batch.ActiveIndex >= numberOfGlyphs)
+    {
+    batch.ActiveIndex = -1;
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+::UpdateBatchDisplay(BatchGlyphs& batch, vtkMRMLMarkupsDisplayNode* displayNode, bool visible)
+{
+  batch.Actor->SetVisibility(visible);
+  if (!displayNode)
+    {
+    return;
+    }
+  // same glyphs as the handles, see SetNthSeed
+  if (batch.GlyphType != displayNode->GetGlyphType())
+    {
+    batch.GlyphType = displayNode->GetGlyphType();
+    if (batch.GlyphType == vtkMRMLMarkupsDisplayNode::Sphere3D)
+      {
+      vtkNew<vtkSphereSource> sphereSource;
+      sphereSource->SetRadius(0.5);
+      sphereSource->SetPhiResolution(10);
+      sphereSource->SetThetaResolution(10);
+      sphereSource->Update();
+      batch.GlyphFilter->SetInputData(sphereSource->GetOutput());
+      }
+    else
+      {
+      // the 3d diamond isn't supported yet, use a 2d diamond for now
+      vtkNew<vtkMarkupsGlyphSource2D> glyphSource;
+      glyphSource->SetGlyphType(displayNode->GlyphTypeIs3D() ?
+        vtkMRMLMarkupsDisplayNode::Diamond2D : batch.GlyphType);
+      glyphSource->SetScale(1.0);
+      glyphSource->Update();
+      batch.GlyphFilter->SetInputData(glyphSource->GetOutput());
+      }
+    }
+  if (batch.GlyphScale != displayNode->GetGlyphScale())
+    {
+    batch.GlyphScale = displayNode->GetGlyphScale();
+    this->UpdateGlyphTransform(batch);
+    }
+
+  vtkProperty* prop = batch.Actor->GetProperty();
+  prop->SetOpacity(displayNode->GetOpacity());
+  prop->SetAmbient(displayNode->GetAmbient());
+  prop->SetDiffuse(displayNode->GetDiffuse());
+  prop->SetSpecular(displayNode->GetSpecular());
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+::UpdateNthBatchPoint(BatchGlyphs& batch, vtkMRMLMarkupsNode* node, int n)
+{
+  if (n >= batch.Points->GetNumberOfPoints())
+    {
+    this->SetNumberOfGlyphs(batch, n + 1);
+    }
+  double fidWorldCoord[4];
+  node->GetMarkupPointWorld(n, 0, fidWorldCoord);
+  double glyphWorldCoord[3];
+  batch.Points->GetPoint(n, glyphWorldCoord);
+  if (!this->External->GetWorldCoordinatesChanged(glyphWorldCoord, fidWorldCoord))
+    {
+    return false;
+    }
+  batch.Points->SetPoint(n, fidWorldCoord);
+  batch.Points->Modified();
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+::UpdateNthBatchGlyph(BatchGlyphs& batch, vtkMRMLMarkupsFiducialNode* node,
+                      int n, vtkMRMLMarkupsDisplayNode* displayNode)
+{
+  this->UpdateNthBatchPoint(batch, node, n);
+
+  double* color = node->GetNthFiducialSelected(n) ?
+    displayNode->GetSelectedColor() : displayNode->GetColor();
+  unsigned char rgb[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    rgb[i] = static_cast<unsigned char>(vtkMath::ClampValue(color[i], 0., 1.) * 255.);
+    }
+  batch.Colors->SetTupleValue(n, rgb);
+  batch.Colors->Modified();
+
+  // the active markup is drawn by the handle, the trace markup by the snake head
+  bool glyphVisible = node->GetNthFiducialVisibility(n) &&
+    n != batch.ActiveIndex &&
+    node->GetNthFiducialLabel(n).compare(vtkMRMLMarkupsNode::GetRealTraceMarkupLabel()) != 0;
+  batch.Mask->SetValue(n, glyphVisible ? 1 : 0);
+  batch.Mask->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::UpdateGlyphTransforms()
+{
+  vtkRenderer* renderer = this->External->GetRenderer();
+  if (!renderer || !renderer->GetActiveCamera() ||
+      renderer->GetActiveCamera()->GetMTime() == this->CameraMTime)
+    {
+    return;
+    }
+  this->CameraMTime = renderer->GetActiveCamera()->GetMTime();
+  for (BatchGlyphsMap::iterator it = this->Batches.begin(); it != this->Batches.end(); ++it)
+    {
+    this->UpdateGlyphTransform(it->second);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::UpdateGlyphTransform(BatchGlyphs& batch)
+{
+  vtkRenderer* renderer = this->External->GetRenderer();
+  if (!renderer || !renderer->GetActiveCamera())
+    {
+    return;
+    }
+  // the inverse of the view rotation maps the glyph plane to the view plane,
+  // only the glyph source is transformed so it doesn't depend on the number
+  // of markups
+  vtkMatrix4x4* viewMatrix = renderer->GetActiveCamera()->GetViewTransformMatrix();
+  vtkNew<vtkMatrix4x4> glyphMatrix;
+  for (int i = 0; i < 3; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      glyphMatrix->SetElement(i, j, viewMatrix->GetElement(j, i) * batch.GlyphScale);
+      }
+    }
+  batch.GlyphTransform->SetMatrix(glyphMatrix.GetPointer());
+}
+
+//---------------------------------------------------------------------------
+vtkPointLocator* vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+::GetDisplayLocator(BatchGlyphs& batch)
+{
+  vtkRenderer* renderer = this->External->GetRenderer();
+  if (!renderer || !renderer->GetActiveCamera())
+    {
+    return 0;
+    }
+  unsigned long cameraMTime = renderer->GetActiveCamera()->GetMTime();
+  int* size = renderer->GetSize();
+  if (batch.DisplayLocator &&
+      batch.DisplayLocatorCameraMTime == cameraMTime &&
+      batch.DisplayLocatorPointsMTime == batch.Points->GetMTime() &&
+      batch.DisplayLocatorSize[0] == size[0] &&
+      batch.DisplayLocatorSize[1] == size[1])
+    {
+    return batch.DisplayLocator;
+    }
+
+  vtkIdType numberOfGlyphs = batch.Points->GetNumberOfPoints();
+  vtkNew<vtkPoints> displayPoints;
+  displayPoints->SetNumberOfPoints(numberOfGlyphs);
+  for (vtkIdType n = 0; n < numberOfGlyphs; ++n)
+    {
+    double displayCoordinates[4];
+    this->External->GetWorldToDisplayCoordinates(batch.Points->GetPoint(n), displayCoordinates);
+    displayPoints->SetPoint(n, displayCoordinates[0], displayCoordinates[1], 0.);
+    }
+  if (!batch.DisplayPolyData)
+    {
+    batch.DisplayPolyData = vtkSmartPointer<vtkPolyData>::New();
+    batch.DisplayLocator = vtkSmartPointer<vtkPointLocator>::New();
+    }
+  batch.DisplayPolyData->SetPoints(displayPoints.GetPointer());
+  batch.DisplayLocator->SetDataSet(batch.DisplayPolyData);
+  batch.DisplayLocator->BuildLocator();
+
+  batch.DisplayLocatorCameraMTime = cameraMTime;
+  batch.DisplayLocatorPointsMTime = batch.Points->GetMTime();
+  batch.DisplayLocatorSize[0] = size[0];
+  batch.DisplayLocatorSize[1] = size[1];
+  return batch.DisplayLocator;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+::RenderStartCallback(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                      void* clientData, void* vtkNotUsed(callData))
+{
+  vtkInternal* self = reinterpret_cast<vtkInternal*>(clientData);
+  self->UpdateGlyphTransforms();
+}
+
 //---------------------------------------------------------------------------
 // vtkMRMLMarkupsFiducialDisplayableManager3D methods
 
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkMRMLMarkupsFiducialDisplayableManager3D()
+{
+  this->Focus = "vtkMRMLMarkupsFiducialNode";
+  this->BatchRenderingThreshold = 100;
+  this->Internal = new vtkInternal(this);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::~vtkMRMLMarkupsFiducialDisplayableManager3D()
+{
+  delete this->Internal;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialDisplayableManager3D::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
   this->Helper->PrintSelf(os, indent);
+  os << indent << "BatchRenderingThreshold: " << this->BatchRenderingThreshold << "\n";
+  os << indent << "Number of batch rendered nodes: " << this->Internal->Batches.size() << "\n";
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager3D::IsBatchRendered(vtkMRMLMarkupsNode* node)
+{
+  return node && this->BatchRenderingThreshold > 0 &&
+         node->GetNumberOfMarkups() >= this->BatchRenderingThreshold;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager3D::GetSeedIndex(vtkMRMLMarkupsNode* node, int n)
+{
+  vtkInternal::BatchGlyphs* batch = this->Internal->GetBatch(node);
+  if (!batch)
+    {
+    return n;
+    }
+  return (n == batch->ActiveIndex) ? 0 : -1;
 }
 
 //---------------------------------------------------------------------------
@@ -259,6 +702,17 @@ bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateNthSeedPositionFromMRML(i
     {
     return false;
     }
+  int seedIndex = this->GetSeedIndex(pointsNode, n);
+  if (seedIndex < 0)
+    {
+    // batch rendered markup without handle
+    vtkInternal::BatchGlyphs* batch = this->Internal->GetBatch(pointsNode);
+    return batch ? this->Internal->UpdateNthBatchPoint(*batch, pointsNode, n) : false;
+    }
+  if (seedIndex >= seedRepresentation->GetNumberOfSeeds())
+    {
+    return false;
+    }
   bool positionChanged = false;
 
   // transform fiducial point using parent transforms
@@ -267,7 +721,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateNthSeedPositionFromMRML(i
 
   // for 3d managers, compare world positions
   double seedWorldCoord[4];
-  seedRepresentation->GetSeedWorldPosition(n,seedWorldCoord);
+  seedRepresentation->GetSeedWorldPosition(seedIndex,seedWorldCoord);
 
   if (this->GetWorldCoordinatesChanged(seedWorldCoord, fidWorldCoord))
     {
@@ -279,7 +733,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateNthSeedPositionFromMRML(i
                   << fidWorldCoord[0] << ", "
                   << fidWorldCoord[1] << ", "
                   << fidWorldCoord[2]);
-    seedRepresentation->GetHandleRepresentation(n)->SetWorldPosition(fidWorldCoord);
+    seedRepresentation->GetHandleRepresentation(seedIndex)->SetWorldPosition(fidWorldCoord);
     positionChanged = true;
     }
   else
@@ -308,12 +762,33 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
     return;
     }
 
+  // batch rendered markups are glyphs, only the active one has a handle
+  vtkInternal::BatchGlyphs* batch = this->Internal->GetBatch(fiducialNode);
+  if (batch)
+    {
+    this->Internal->UpdateNthBatchGlyph(*batch, fiducialNode, n, displayNode);
+    }
+  int seedIndex = this->GetSeedIndex(fiducialNode, n);
+  if (seedIndex < 0)
+    {
+    if (fiducialNode->GetNthFiducialLabel(n).compare(vtkMRMLMarkupsNode::GetRealTraceMarkupLabel()) == 0)
+      {
+      // the trace markup is shown by the snake head
+      double centerPos[3];
+      fiducialNode->GetNthFiducialPosition(n, centerPos);
+      double parameters[4] = {1.0,0,0,0.6};
+      this->UpdateSnakeHeadParametersFromParametersNode(parameters);
+      this->PlaceSnakeHead(centerPos[0],centerPos[1], centerPos[2], parameters);
+      }
+    return;
+    }
+
   int numberOfHandles = seedRepresentation->GetNumberOfSeeds();
-  vtkDebugMacro("SetNthSeed, n = " << n << ", number of handles = " << numberOfHandles);
+  vtkDebugMacro("SetNthSeed, n = " << n << ", seed index = " << seedIndex << ", number of handles = " << numberOfHandles);
 
   // does this handle need to be created?
   bool createdNewHandle = false;
-  if (n >= numberOfHandles)
+  if (seedIndex >= numberOfHandles)
     {
     // create a new handle
     vtkHandleWidget* newhandle = seedWidget->CreateNewHandle();
@@ -342,14 +817,14 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
     }
 
   vtkOrientedPolygonalHandleRepresentation3D *handleRep =
-    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(seedRepresentation->GetHandleRepresentation(n));
+    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(seedRepresentation->GetHandleRepresentation(seedIndex));
   if (!handleRep)
     {
     vtkErrorMacro("Failed to get an oriented polygonal handle rep for n = "
           << n << ", number of seeds = "
           << seedRepresentation->GetNumberOfSeeds()
           << ", handle rep = "
-          << (seedRepresentation->GetHandleRepresentation(n) ? seedRepresentation->GetHandleRepresentation(n)->GetClassName() : "null"));
+          << (seedRepresentation->GetHandleRepresentation(seedIndex) ? seedRepresentation->GetHandleRepresentation(seedIndex)->GetClassName() : "null"));
     return;
     }
 
@@ -377,14 +852,14 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
       {
       handleRep->LabelVisibilityOn();
       }
-    seedWidget->GetSeed(n)->EnabledOn();
+    seedWidget->GetSeed(seedIndex)->EnabledOn();
     }
   else
     {
     handleRep->VisibilityOff();
     handleRep->HandleVisibilityOff();
     handleRep->LabelVisibilityOff();
-    seedWidget->GetSeed(n)->EnabledOff();
+    seedWidget->GetSeed(seedIndex)->EnabledOff();
     }
 
   // update locked
@@ -403,15 +878,15 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
     }
   if (listLocked || seedLocked || persistentPlaceMode)
     {
-    seedWidget->GetSeed(n)->ProcessEventsOff();
+    seedWidget->GetSeed(seedIndex)->ProcessEventsOff();
     }
   else
     {
-    seedWidget->GetSeed(n)->ProcessEventsOn();
+    seedWidget->GetSeed(seedIndex)->ProcessEventsOn();
     }
 
   // set the glyph type if a new handle was created, or the glyph type changed
-  int oldGlyphType = this->Helper->GetNodeGlyphType(displayNode, n);
+  int oldGlyphType = this->Helper->GetNodeGlyphType(displayNode, seedIndex);
   if (createdNewHandle ||
       oldGlyphType != displayNode->GetGlyphType())
     {
@@ -453,7 +928,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
       }
     // TBD: keep with the assumption of one glyph type per markups node,
     // but they may have different glyphs during update
-    this->Helper->SetNodeGlyphType(displayNode, displayNode->GetGlyphType(), n);
+    this->Helper->SetNodeGlyphType(displayNode, displayNode->GetGlyphType(), seedIndex);
     }  // end of glyph type
 
   // update the text display properties if there is text
@@ -803,6 +1278,31 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateMRMLToWidget(vtkMRMLMa
 
   vtkDebugMacro("Fids PropagateMRMLToWidget, node num markups = " << numberOfFiducials);
 
+  // large lists are drawn by a single glyph mapper, with only one handle
+  vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
+  if (this->IsBatchRendered(fiducialNode) && displayNode)
+    {
+    bool newBatch = (this->Internal->GetBatch(fiducialNode) == 0);
+    vtkInternal::BatchGlyphs* batch = this->Internal->GetOrCreateBatch(fiducialNode);
+    if (newBatch)
+      {
+      // the markups were handles so far
+      for (int seed = seedRepresentation->GetNumberOfSeeds() - 1; seed >= 0; --seed)
+        {
+        seedWidget->DeleteSeed(seed);
+        }
+      }
+    vtkMRMLViewNode *viewNode = this->GetMRMLViewNode();
+    bool visible = displayNode->GetVisibility() != 0 &&
+      (!viewNode || displayNode->GetVisibility(viewNode->GetID()) != 0);
+    this->Internal->SetNumberOfGlyphs(*batch, numberOfFiducials);
+    this->Internal->UpdateBatchDisplay(*batch, displayNode, visible);
+    }
+  else
+    {
+    this->Internal->RemoveBatch(fiducialNode);
+    }
+
   for (int n = 0; n < numberOfFiducials; n++)
     {
     // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
@@ -816,7 +1316,6 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateMRMLToWidget(vtkMRMLMa
   // std::cout << "PropagateMRMLToWidget: calling UpdateWidgetVisibility" << std::endl;
   this->UpdateWidgetVisibility(node);
 
-  vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
   seedRepresentation->NeedToRenderOn();
   seedWidget->Modified();
 
@@ -871,12 +1370,20 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateWidgetToMRML(vtkAbstra
   vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
   int numberOfSeeds = seedRepresentation->GetNumberOfSeeds();
 
+  // the only seed of a batch rendered node is the active markup
+  vtkInternal::BatchGlyphs* batch = this->Internal->GetBatch(fiducialNode);
+
   bool positionChanged = false;
-  for (int n = 0; n < numberOfSeeds; n++)
+  for (int seed = 0; seed < numberOfSeeds; seed++)
     {
+    int n = batch ? batch->ActiveIndex : seed;
+    if (n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+      {
+      continue;
+      }
     double worldCoordinates1[4];
-    seedRepresentation->GetSeedWorldPosition(n,worldCoordinates1);
-    vtkDebugMacro("PropagateWidgetToMRML: 3d: widget seed " << n
+    seedRepresentation->GetSeedWorldPosition(seed,worldCoordinates1);
+    vtkDebugMacro("PropagateWidgetToMRML: 3d: widget seed " << seed
           << " world coords = " << worldCoordinates1[0] << ", "
           << worldCoordinates1[1] << ", "<< worldCoordinates1[2]);
 
@@ -1043,6 +1550,8 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::AdditionnalInitializeStep()
   // don't add the key press event, as it triggers a crash on start up
   //vtkDebugMacro("Adding an observer on the key press event");
   this->AddInteractorStyleObservableEvent(vtkCommand::KeyPressEvent);
+  // the handle of batch rendered markups follows the mouse
+  this->AddInteractorStyleObservableEvent(vtkCommand::MouseMoveEvent);
 }
 
 //---------------------------------------------------------------------------
@@ -1084,6 +1593,101 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnInteractorStyleEvent(int even
     {
     vtkDebugMacro("Got a key release event");
     }
+  else if (eventid == vtkCommand::MouseMoveEvent)
+    {
+    int *eventPosition = this->GetInteractor()->GetEventPosition();
+    if (this->UpdateActiveBatchMarkup(eventPosition[0], eventPosition[1]))
+      {
+      this->RequestRender();
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::SetActiveBatchMarkup(
+  vtkMRMLMarkupsFiducialNode* fiducialNode, vtkSeedWidget *seedWidget, int n)
+{
+  vtkInternal::BatchGlyphs* batch = this->Internal->GetBatch(fiducialNode);
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  if (!batch || !displayNode || n == batch->ActiveIndex)
+    {
+    return;
+    }
+  int previousIndex = batch->ActiveIndex;
+  batch->ActiveIndex = n;
+  if (previousIndex >= 0 && previousIndex < fiducialNode->GetNumberOfMarkups())
+    {
+    // back to a glyph
+    this->Internal->UpdateNthBatchGlyph(*batch, fiducialNode, previousIndex, displayNode);
+    }
+  if (n < 0)
+    {
+    if (vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation())->GetNumberOfSeeds() > 0)
+      {
+      seedWidget->DeleteSeed(0);
+      }
+    return;
+    }
+  // moves the handle to the markup and hides its glyph
+  this->SetNthSeed(n, fiducialNode, seedWidget);
+}
+
+//---------------------------------------------------------------------------
+bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateActiveBatchMarkup(double x, double y)
+{
+  bool activeMarkupChanged = false;
+  for (vtkInternal::BatchGlyphsMap::iterator it = this->Internal->Batches.begin();
+       it != this->Internal->Batches.end(); ++it)
+    {
+    vtkInternal::BatchGlyphs& batch = it->second;
+    vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+    vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(this->Helper->GetWidget(it->first));
+    if (!fiducialNode || !seedWidget || !batch.Actor->GetVisibility() ||
+        seedWidget->GetWidgetState() == vtkSeedWidget::MovingSeed)
+      {
+      continue;
+      }
+    // same pixel tolerance as the handle
+    double tolerance = 15.;
+    vtkSeedRepresentation* seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
+    if (seedRepresentation->GetNumberOfSeeds() > 0)
+      {
+      tolerance = seedRepresentation->GetHandleRepresentation(0)->GetTolerance();
+      }
+    vtkPointLocator* locator = this->Internal->GetDisplayLocator(batch);
+    if (!locator)
+      {
+      continue;
+      }
+    // the glyphs within the tolerance, hidden markups are skipped
+    double displayPosition[3] = {x, y, 0.};
+    vtkNew<vtkIdList> glyphIds;
+    locator->FindPointsWithinRadius(tolerance, displayPosition, glyphIds.GetPointer());
+    int closestIndex = -1;
+    double closestDistance2 = tolerance * tolerance;
+    for (vtkIdType i = 0; i < glyphIds->GetNumberOfIds(); ++i)
+      {
+      vtkIdType n = glyphIds->GetId(i);
+      if (!batch.Mask->GetValue(n) && n != batch.ActiveIndex)
+        {
+        continue;
+        }
+      double* displayCoordinates = batch.DisplayPolyData->GetPoint(n);
+      double distance2 = (displayCoordinates[0] - x) * (displayCoordinates[0] - x) +
+                         (displayCoordinates[1] - y) * (displayCoordinates[1] - y);
+      if (distance2 < closestDistance2)
+        {
+        closestDistance2 = distance2;
+        closestIndex = static_cast<int>(n);
+        }
+      }
+    if (closestIndex >= 0 && closestIndex != batch.ActiveIndex)
+      {
+      this->SetActiveBatchMarkup(fiducialNode, seedWidget, closestIndex);
+      activeMarkupChanged = true;
+      }
+    }
+  return activeMarkupChanged;
 }
 
 //---------------------------------------------------------------------------
@@ -1140,6 +1744,34 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLSceneEndClose()
 {
   // clear out the map of glyph types
   this->Helper->ClearNodeGlyphTypes();
+  this->Internal->RemoveAllBatches();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  this->Internal->RemoveBatch(vtkMRMLMarkupsNode::SafeDownCast(node));
+  this->Superclass::OnMRMLSceneNodeRemoved(node);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsPointModifiedEvent(vtkMRMLNode *node, int n)
+{
+  vtkMRMLMarkupsFiducialNode *fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(node);
+  if (!fiducialNode || !this->Internal->GetBatch(fiducialNode) ||
+      n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+    {
+    this->Superclass::OnMRMLMarkupsPointModifiedEvent(node, n);
+    return;
+    }
+  vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(this->Helper->GetWidget(fiducialNode));
+  if (!seedWidget)
+    {
+    return;
+    }
+  // only the modified markup is updated
+  this->SetNthSeed(n, fiducialNode, seedWidget);
+  this->RequestRender();
 }
 
 //---------------------------------------------------------------------------
@@ -1166,6 +1798,11 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeNthMarkupModif
    return;
    }
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(node), seedWidget);
+  if (this->Internal->GetBatch(node))
+    {
+    // the glyphs are not rendered by the widget
+    this->RequestRender();
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -1192,9 +1829,22 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeMarkupAddedEve
    return;
    }
 
+  if (this->IsBatchRendered(markupsNode) != (this->Internal->GetBatch(markupsNode) != 0))
+    {
+    // switch between batch and per handle rendering
+    this->PropagateMRMLToWidget(markupsNode, seedWidget);
+    this->RequestRender();
+    return;
+    }
+
   // this call will create a new handle and set it
+  // (or append a glyph if the node is batch rendered)
   int n = markupsNode->GetNumberOfMarkups() - 1;
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget);
+  if (this->Internal->GetBatch(markupsNode))
+    {
+    this->RequestRender();
+    }
 
   vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
   seedRepresentation->NeedToRenderOn();
@@ -1219,6 +1869,12 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeMarkupRemovedE
     }
 
   // for now, recreate the widget
+  // (the indices of the batch rendered markups changed)
+  vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(widget);
+  if (seedWidget && this->Internal->GetBatch(markupsNode))
+    {
+    this->SetActiveBatchMarkup(vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget, -1);
+    }
   this->Helper->RemoveWidgetAndNode(markupsNode);
   this->AddWidget(markupsNode);
 
@@ -44,10 +44,22 @@ public:
   vtkTypeMacro(vtkMRMLMarkupsFiducialDisplayableManager3D, vtkMRMLMarkupsDisplayableManager3D);
   void PrintSelf(ostream& os, vtkIndent indent);
 
+  /// Markups nodes with at least this number of markups are rendered in
+  /// batch: all their markups are instances of a single glyph mapper and only
+  /// the markup under the mouse cursor gets an interactive handle.
+  /// 0 disables batch rendering. Default is 100.
+  /// Takes effect the next time the node's markups are added or removed.
+  vtkSetClampMacro(BatchRenderingThreshold, int, 0, VTK_INT_MAX);
+  vtkGetMacro(BatchRenderingThreshold, int);
+
+  /// Return true if the markups of the node are rendered in batch.
+  /// \sa BatchRenderingThreshold
+  bool IsBatchRendered(vtkMRMLMarkupsNode* node);
+
 protected:
 
-  vtkMRMLMarkupsFiducialDisplayableManager3D(){this->Focus="vtkMRMLMarkupsFiducialNode";}
-  virtual ~vtkMRMLMarkupsFiducialDisplayableManager3D(){}
+  vtkMRMLMarkupsFiducialDisplayableManager3D();
+  virtual ~vtkMRMLMarkupsFiducialDisplayableManager3D();
 
   /// Callback for click in RenderWindow
   virtual void OnClickInRenderWindow(double x, double y, const char *associatedNodeID);
@@ -65,6 +77,16 @@ protected:
 
   /// Update a single seed from MRML
   void SetNthSeed(int n, vtkMRMLMarkupsFiducialNode* fiducialNode, vtkSeedWidget *seedWidget);
+  /// Return the index of the seed of the widget that represents the nth
+  /// markup, -1 if the markup has no seed (batch rendered markup that is not
+  /// active).
+  int GetSeedIndex(vtkMRMLMarkupsNode* node, int n);
+  /// Make the nth markup of a batch rendered node the one represented by the
+  /// interactive handle. n = -1 hides the handle.
+  void SetActiveBatchMarkup(vtkMRMLMarkupsFiducialNode* fiducialNode, vtkSeedWidget *seedWidget, int n);
+  /// Activate the batch rendered markup under the display position (if any).
+  /// Return true if the active markup changed.
+  bool UpdateActiveBatchMarkup(double x, double y);
   /// Propagate properties of MRML node to widget.
   virtual void PropagateMRMLToWidget(vtkMRMLMarkupsNode* node, vtkAbstractWidget * widget);
 
@@ -80,9 +102,13 @@ protected:
   virtual bool UpdateNthSeedPositionFromMRML(int n, vtkAbstractWidget *widget, vtkMRMLMarkupsNode *pointsNode);
   /// Respond to control point modified events
   virtual void UpdatePosition(vtkAbstractWidget *widget, vtkMRMLNode *node);
+  /// Only update the modified point of batch rendered nodes
+  virtual void OnMRMLMarkupsPointModifiedEvent(vtkMRMLNode *node, int n);
 
   // Clean up when scene closes
   virtual void OnMRMLSceneEndClose();
+  /// Remove the batch glyphs of the removed node
+  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
 
   //update the snakeHead Parameters Frome ParametersNode,include( Direction, Opacity)
   void UpdateSnakeHeadParametersFromParametersNode(double* parameters);
@@ -100,6 +126,11 @@ private:
 
   vtkMRMLGeneralParametersNode * m_parametersNode = NULL;
 
+  int BatchRenderingThreshold;
+
+  class vtkInternal;
+  vtkInternal * Internal;
+
 };
 
 #endif
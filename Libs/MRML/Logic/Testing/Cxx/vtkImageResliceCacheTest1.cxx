@@ -0,0 +1,270 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkImageResliceCache.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageReslice.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkShortArray.h>
+#include <vtkTransform.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool CheckSlice(vtkImageResliceCache* cache, vtkImageData* volume, double offset)
+{
+  vtkImageReslice* reslice = cache->GetReslice();
+  vtkTransform::SafeDownCast(reslice->GetResliceTransform())->Identity();
+  vtkTransform::SafeDownCast(reslice->GetResliceTransform())->Translate(0., 0., offset);
+  cache->Update();
+
+  // the same slice resliced without cache
+  vtkNew<vtkImageReslice> expected;
+  expected->SetInputData(volume);
+  expected->SetResliceTransform(reslice->GetResliceTransform());
+  expected->SetOutputExtent(reslice->GetOutputExtent());
+  expected->SetInterpolationModeToLinear();
+  expected->Update();
+
+  vtkDataArray* scalars = cache->GetOutput()->GetPointData()->GetScalars();
+  vtkDataArray* expectedScalars = expected->GetOutput()->GetPointData()->GetScalars();
+  if (!scalars ||
+      scalars->GetNumberOfTuples() != expectedScalars->GetNumberOfTuples() ||
+      memcmp(scalars->GetVoidPointer(0), expectedScalars->GetVoidPointer(0),
+             scalars->GetNumberOfTuples() * scalars->GetDataTypeSize()) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong slice at offset " << offset << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageResliceCacheTest1(int , char * [] )
+{
+  vtkNew<vtkImageResliceCache> cache;
+  EXERCISE_BASIC_OBJECT_METHODS(cache.GetPointer());
+
+  vtkNew<vtkImageData> volume;
+  volume->SetDimensions(64, 64, 32);
+  volume->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(volume->GetScalarPointer());
+  for (int i = 0; i < 64 * 64 * 32; ++i)
+    {
+    voxels[i] = static_cast<short>(i % 1000);
+    }
+
+  vtkNew<vtkTransform> transform;
+  vtkNew<vtkImageReslice> reslice;
+  reslice->SetInputData(volume.GetPointer());
+  reslice->SetResliceTransform(transform.GetPointer());
+  reslice->SetOutputExtent(0, 63, 0, 63, 0, 0);
+  reslice->SetInterpolationModeToLinear();
+  reslice->GenerateStencilOutputOn();
+
+  cache->SetInputData(volume.GetPointer());
+  cache->SetReslice(reslice.GetPointer());
+  cache->PrefetchOff();
+
+  // Scroll forward: every slice is resliced
+  for (int i = 0; i < 10; ++i)
+    {
+    if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), i + 0.5))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  if (cache->GetNumberOfCacheMisses() != 10 ||
+      cache->GetNumberOfCacheHits() != 0 ||
+      cache->GetNumberOfCachedImages() != 10)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of misses: "
+              << cache->GetNumberOfCacheMisses() << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Scroll backward: every slice comes from the cache
+  for (int i = 9; i >= 0; --i)
+    {
+    if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), i + 0.5))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  if (cache->GetNumberOfCacheMisses() != 10 ||
+      cache->GetNumberOfCacheHits() != 10)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of hits: "
+              << cache->GetNumberOfCacheHits() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Modified voxels invalidate the cached slices
+  voxels[0] = 2000;
+  volume->Modified();
+  if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), 0.5) ||
+      cache->GetNumberOfCacheMisses() != 11 ||
+      cache->GetNumberOfCachedImages() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": modified volume not resliced or stale slices kept: "
+              << cache->GetNumberOfCachedImages() << " cached images" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // While the volume is edited, the slices are not cached
+  voxels[1] = 2000;
+  volume->Modified();
+  if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), 0.5) ||
+      cache->GetNumberOfCacheMisses() != 12 ||
+      cache->GetNumberOfCachedImages() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": slice of an edited volume cached" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Once the edits are done, the slices are cached again
+  if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), 1.5) ||
+      !CheckSlice(cache.GetPointer(), volume.GetPointer(), 0.5) ||
+      cache->GetNumberOfCacheMisses() != 14 ||
+      cache->GetNumberOfCachedImages() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << ": slices not cached after the edits" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Memory cap: only the most recent slices are kept
+  unsigned long sliceSize = cache->GetCacheSize() / cache->GetNumberOfCachedImages();
+  cache->SetMaximumCacheSize(sliceSize);
+  if (cache->GetNumberOfCachedImages() > 1 || cache->GetCacheSize() > sliceSize)
+    {
+    std::cerr << "Line " << __LINE__ << ": memory cap not respected: "
+              << cache->GetCacheSize() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Prefetch: after two slices, the next ones are resliced in the background
+  cache->ClearCache();
+  cache->SetMaximumCacheSize(64 * 1024);
+  cache->PrefetchOn();
+  cache->SetNumberOfPrefetchedSlices(2);
+  if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), 10.) ||
+      !CheckSlice(cache.GetPointer(), volume.GetPointer(), 11.))
+    {
+    return EXIT_FAILURE;
+    }
+  cache->WaitForPrefetch();
+  int misses = cache->GetNumberOfCacheMisses();
+  if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), 12.) ||
+      !CheckSlice(cache.GetPointer(), volume.GetPointer(), 13.))
+    {
+    return EXIT_FAILURE;
+    }
+  if (cache->GetNumberOfCacheMisses() != misses)
+    {
+    std::cerr << "Line " << __LINE__ << ": prefetched slices not used" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The prefetched slices are not used once the volume is modified in place
+  cache->WaitForPrefetch();
+  for (int i = 64 * 64 * 14; i < 64 * 64 * 16; ++i)
+    {
+    voxels[i] = 0;
+    }
+  volume->Modified();
+  if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), 14.) ||
+      cache->GetNumberOfCacheMisses() != misses + 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": stale prefetched slice used" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A modified region only removes the slices that sample it
+  cache->WaitForPrefetch();
+  cache->PrefetchOff();
+  cache->ClearCache();
+  for (int i = 0; i < 10; ++i)
+    {
+    if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), i + 0.5))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  int farRegion[6] = {0, 63, 0, 63, 20, 20};
+  cache->InputRegionModified(farRegion);
+  for (int i = 64 * 64 * 20; i < 64 * 64 * 21; ++i)
+    {
+    voxels[i] = 3000;
+    }
+  volume->Modified();
+  if (cache->GetNumberOfCachedImages() != 10)
+    {
+    std::cerr << "Line " << __LINE__ << ": slices far from the modified region removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  misses = cache->GetNumberOfCacheMisses();
+  for (int i = 0; i < 10; ++i)
+    {
+    if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), i + 0.5))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  if (cache->GetNumberOfCacheMisses() != misses)
+    {
+    std::cerr << "Line " << __LINE__ << ": cached slices not used after a region modification" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // the slices 0.5 to 5.5 interpolate the voxels of plane 3 (with a margin
+  // for the interpolation kernel)
+  int nearRegion[6] = {0, 63, 0, 63, 3, 3};
+  cache->InputRegionModified(nearRegion);
+  for (int i = 64 * 64 * 3; i < 64 * 64 * 4; ++i)
+    {
+    voxels[i] = 3000;
+    }
+  volume->Modified();
+  if (cache->GetNumberOfCachedImages() != 4)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of slices after a region modification: "
+              << cache->GetNumberOfCachedImages() << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CheckSlice(cache.GetPointer(), volume.GetPointer(), 9.5) ||
+      cache->GetNumberOfCacheMisses() != misses ||
+      !CheckSlice(cache.GetPointer(), volume.GetPointer(), 2.5) ||
+      cache->GetNumberOfCacheMisses() != misses + 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": modified slice not resliced" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // an unreported modification removes all the slices
+  voxels[64 * 64 * 9] = 3000;
+  volume->Modified();
+  if (cache->GetNumberOfCachedImages() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": slices kept after an unreported modification" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
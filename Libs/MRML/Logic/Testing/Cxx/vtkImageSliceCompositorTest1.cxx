@@ -0,0 +1,197 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkImageSliceCompositor.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageBlend.h>
+#include <vtkImageData.h>
+#include <vtkImageMapToColors.h>
+#include <vtkImageMapToWindowLevelColors.h>
+#include <vtkImageToImageStencil.h>
+#include <vtkLookupTable.h>
+#include <vtkNew.h>
+#include <vtkTrivialProducer.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+//----------------------------------------------------------------------------
+int vtkImageSliceCompositorTest1(int , char * [] )
+{
+  vtkNew<vtkImageSliceCompositor> compositor;
+  EXERCISE_BASIC_OBJECT_METHODS(compositor.GetPointer());
+
+  const int size = 32;
+
+  // Background: scalar volume mapped with window/level and a lookup table
+  vtkNew<vtkImageData> background;
+  background->SetDimensions(size, size, 1);
+  background->AllocateScalars(VTK_SHORT, 1);
+  // Foreground: already mapped to colors
+  vtkNew<vtkImageData> foreground;
+  foreground->SetDimensions(size, size, 1);
+  foreground->AllocateScalars(VTK_UNSIGNED_CHAR, 4);
+  // Label map
+  vtkNew<vtkImageData> label;
+  label->SetDimensions(size, size, 1);
+  label->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  // Background mask: left half
+  vtkNew<vtkImageData> mask;
+  mask->SetDimensions(size, size, 1);
+  mask->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int y = 0; y < size; ++y)
+    {
+    for (int x = 0; x < size; ++x)
+      {
+      *static_cast<short*>(background->GetScalarPointer(x, y, 0)) =
+        static_cast<short>(10 * x + y - 100);
+      unsigned char* color =
+        static_cast<unsigned char*>(foreground->GetScalarPointer(x, y, 0));
+      color[0] = static_cast<unsigned char>(8 * x);
+      color[1] = static_cast<unsigned char>(8 * y);
+      color[2] = 128;
+      color[3] = static_cast<unsigned char>(x + y < size ? 255 : 64);
+      *static_cast<unsigned char*>(label->GetScalarPointer(x, y, 0)) =
+        static_cast<unsigned char>((x / 4) % 6);
+      *static_cast<unsigned char*>(mask->GetScalarPointer(x, y, 0)) =
+        (x < size / 2) ? 1 : 0;
+      }
+    }
+
+  vtkNew<vtkLookupTable> backgroundLUT;
+  backgroundLUT->SetNumberOfTableValues(256);
+  backgroundLUT->SetRange(0, 255);
+  backgroundLUT->Build();
+
+  // 4 labels, the label 0 is transparent, the labels 4 and 5 are out of range
+  vtkNew<vtkLookupTable> labelLUT;
+  labelLUT->SetNumberOfTableValues(4);
+  labelLUT->SetTableRange(0, 3);
+  labelLUT->SetTableValue(0, 0., 0., 0., 0.);
+  labelLUT->SetTableValue(1, 1., 0., 0., 1.);
+  labelLUT->SetTableValue(2, 0., 1., 0., 1.);
+  labelLUT->SetTableValue(3, 0., 0., 1., 1.);
+
+  vtkNew<vtkTrivialProducer> backgroundProducer;
+  backgroundProducer->SetOutput(background.GetPointer());
+  vtkNew<vtkTrivialProducer> foregroundProducer;
+  foregroundProducer->SetOutput(foreground.GetPointer());
+  vtkNew<vtkTrivialProducer> labelProducer;
+  labelProducer->SetOutput(label.GetPointer());
+
+  // Reference: display node pipelines followed by vtkImageBlend
+  vtkNew<vtkImageMapToWindowLevelColors> windowLevel;
+  windowLevel->SetInputConnection(backgroundProducer->GetOutputPort());
+  windowLevel->SetOutputFormatToLuminance();
+  windowLevel->SetWindow(200.);
+  windowLevel->SetLevel(50.);
+  vtkNew<vtkImageMapToColors> backgroundColors;
+  backgroundColors->SetInputConnection(windowLevel->GetOutputPort());
+  backgroundColors->SetOutputFormatToRGBA();
+  backgroundColors->SetLookupTable(backgroundLUT.GetPointer());
+  vtkNew<vtkImageMapToColors> labelColors;
+  labelColors->SetInputConnection(labelProducer->GetOutputPort());
+  labelColors->SetOutputFormatToRGBA();
+  labelColors->SetLookupTable(labelLUT.GetPointer());
+  vtkNew<vtkImageBlend> blend;
+  blend->AddInputConnection(backgroundColors->GetOutputPort());
+  blend->AddInputConnection(foregroundProducer->GetOutputPort());
+  blend->AddInputConnection(labelColors->GetOutputPort());
+  blend->SetOpacity(0, 1.);
+  blend->SetOpacity(1, 0.7);
+  blend->SetOpacity(2, 0.5);
+  blend->Update();
+
+  compositor->SetNumberOfThreads(4);
+  compositor->SetNumberOfLayers(3);
+  compositor->SetLayerInputConnection(0, backgroundProducer->GetOutputPort());
+  compositor->SetLayerMode(0, vtkImageSliceCompositor::LayerWindowLevel);
+  compositor->SetLayerWindowLevel(0, 200., 50.);
+  compositor->SetLayerLookupTable(0, backgroundLUT.GetPointer());
+  compositor->SetLayerInputConnection(1, foregroundProducer->GetOutputPort());
+  compositor->SetLayerOpacity(1, 0.7);
+  compositor->SetLayerInputConnection(2, labelProducer->GetOutputPort());
+  compositor->SetLayerMode(2, vtkImageSliceCompositor::LayerLabelMap);
+  compositor->SetLayerLookupTable(2, labelLUT.GetPointer());
+  compositor->SetLayerOpacity(2, 0.5);
+  compositor->Update();
+
+  vtkImageData* output = compositor->GetOutput();
+  vtkImageData* expected = blend->GetOutput();
+  if (output->GetScalarType() != VTK_UNSIGNED_CHAR ||
+      output->GetNumberOfScalarComponents() != 4 ||
+      output->GetNumberOfPoints() != expected->GetNumberOfPoints())
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong output format" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int y = 0; y < size; ++y)
+    {
+    for (int x = 0; x < size; ++x)
+      {
+      unsigned char* color = static_cast<unsigned char*>(output->GetScalarPointer(x, y, 0));
+      unsigned char* expectedColor = static_cast<unsigned char*>(expected->GetScalarPointer(x, y, 0));
+      for (int c = 0; c < 4; ++c)
+        {
+        // vtkImageBlend rounds differently
+        if (abs(color[c] - expectedColor[c]) > 2)
+          {
+          std::cerr << "Line " << __LINE__ << ": wrong color at (" << x << ", " << y
+                    << ") component " << c << ": " << static_cast<int>(color[c])
+                    << " instead of " << static_cast<int>(expectedColor[c]) << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  // Threshold and stencil only change the alpha of the background
+  vtkNew<vtkImageToImageStencil> stencil;
+  stencil->SetInputData(mask.GetPointer());
+  stencil->ThresholdByUpper(0.5);
+  compositor->SetLayerThreshold(0, 0., 100., 1);
+  compositor->SetLayerStencilConnection(0, stencil->GetOutputPort());
+  compositor->Update();
+  output = compositor->GetOutput();
+  for (int y = 0; y < size; ++y)
+    {
+    for (int x = 0; x < size; ++x)
+      {
+      const int value = 10 * x + y - 100;
+      const int expectedAlpha = (x < size / 2 && value >= 0 && value <= 100) ? 255 : 0;
+      unsigned char* color = static_cast<unsigned char*>(output->GetScalarPointer(x, y, 0));
+      unsigned char* expectedColor = static_cast<unsigned char*>(expected->GetScalarPointer(x, y, 0));
+      if (color[3] != expectedAlpha || abs(color[0] - expectedColor[0]) > 2)
+        {
+        std::cerr << "Line " << __LINE__ << ": wrong alpha at (" << x << ", " << y
+                  << "): " << static_cast<int>(color[3]) << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // Changing the lookup table updates the output
+  unsigned long mTime = compositor->GetMTime();
+  labelLUT->SetTableValue(1, 0., 1., 1., 1.);
+  if (compositor->GetMTime() <= mTime)
+    {
+    std::cerr << "Line " << __LINE__ << ": lookup table not observed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Copyright (c) Kitware Inc.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkMRMLApplicationLogic.h"
+
+// MRML includes
+#include <vtkDataIOManager.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLModelStorageNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+
+// VTKSYS includes
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <set>
+#include <string>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+vtkMRMLModelNode* AddModel(vtkMRMLScene* scene, const char* name,
+                           const char* fileName, double radius)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(radius);
+  sphere->Update();
+
+  vtkNew<vtkMRMLModelStorageNode> storageNode;
+  if (fileName)
+    {
+    storageNode->SetFileName(fileName);
+    }
+  scene->AddNode(storageNode.GetPointer());
+
+  vtkNew<vtkMRMLModelNode> modelNode;
+  modelNode->SetName(name);
+  modelNode->SetAndObservePolyData(sphere->GetOutput());
+  modelNode->SetAndObserveStorageNodeID(storageNode->GetID());
+  scene->AddNode(modelNode.GetPointer());
+  return modelNode.GetPointer();
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+// Save a data bundle of nodes whose file names collide: the queued writes
+// must not be given the same file, even though the files do not exist yet.
+int vtkMRMLApplicationLogicTest2(int argc, char * argv [])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " temporary_directory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string bundleDir = std::string(argv[1]) + "/vtkMRMLApplicationLogicTest2";
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkDataIOManager> dataIOManager;
+  scene->SetDataIOManager(dataIOManager.GetPointer());
+  scene->SetRootDirectory(argv[1]);
+  scene->SetURL((std::string(argv[1]) + "/vtkMRMLApplicationLogicTest2.mrml").c_str());
+
+  vtkNew<vtkMRMLApplicationLogic> appLogic;
+  appLogic->SetMRMLScene(scene.GetPointer());
+
+  // same node names, no file names yet
+  vtkMRMLModelNode* model1 = AddModel(scene.GetPointer(), "Model", NULL, 1.);
+  vtkMRMLModelNode* model2 = AddModel(scene.GetPointer(), "Model", NULL, 2.);
+  // different directories, same file name
+  vtkMRMLModelNode* model3 = AddModel(scene.GetPointer(), "Other", "/a/Model.vtk", 3.);
+  vtkMRMLModelNode* model4 = AddModel(scene.GetPointer(), "Other", "/b/Model.vtk", 4.);
+
+  if (!appLogic->SaveSceneToSlicerDataBundleDirectory(bundleDir.c_str()))
+    {
+    std::cerr << "Line " << __LINE__
+              << " - SaveSceneToSlicerDataBundleDirectory failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the original file names are restored after saving, read back the bundle
+  std::string dataDir = bundleDir + "/Data";
+  vtksys::Directory directory;
+  std::set<std::string> writtenFiles;
+  if (directory.Load(dataDir.c_str()))
+    {
+    for (unsigned long i = 0; i < directory.GetNumberOfFiles(); ++i)
+      {
+      std::string file = directory.GetFile(i);
+      if (file != "." && file != "..")
+        {
+        writtenFiles.insert(file);
+        }
+      }
+    }
+  if (writtenFiles.size() != 4)
+    {
+    std::cerr << "Line " << __LINE__ << " - expected 4 distinct files in "
+              << dataDir << ", found " << writtenFiles.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // every model must have its own data: reload the files and compare radii
+  vtkMRMLModelNode* models[4] = {model1, model2, model3, model4};
+  std::set<int> radii;
+  for (std::set<std::string>::const_iterator it = writtenFiles.begin();
+       it != writtenFiles.end(); ++it)
+    {
+    vtkNew<vtkMRMLScene> readScene;
+    vtkNew<vtkMRMLModelStorageNode> storageNode;
+    storageNode->SetFileName((dataDir + "/" + *it).c_str());
+    readScene->AddNode(storageNode.GetPointer());
+    vtkNew<vtkMRMLModelNode> modelNode;
+    readScene->AddNode(modelNode.GetPointer());
+    if (!storageNode->ReadData(modelNode.GetPointer()) ||
+        !modelNode->GetPolyData())
+      {
+      std::cerr << "Line " << __LINE__ << " - failed to read " << *it << std::endl;
+      return EXIT_FAILURE;
+      }
+    double bounds[6];
+    modelNode->GetPolyData()->GetBounds(bounds);
+    radii.insert(static_cast<int>(bounds[5] + 0.5));
+    }
+  for (int i = 0; i < 4; ++i)
+    {
+    double bounds[6];
+    models[i]->GetPolyData()->GetBounds(bounds);
+    if (!radii.count(static_cast<int>(bounds[5] + 0.5)))
+      {
+      std::cerr << "Line " << __LINE__ << " - data of model " << i
+                << " was overwritten in the bundle" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  vtksys::SystemTools::RemoveADirectory(bundleDir.c_str());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include <vtkImageSliceCompositor.h>
+#include <vtkMRMLSliceLayerLogic.h>
+#include <vtkMRMLSliceLogic.h>
+
+// MRML includes
+#include <vtkMRMLColorTableNode.h>
+#include <vtkMRMLScalarVolumeDisplayNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLSliceCompositeNode.h>
+#include <vtkMRMLSliceNode.h>
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkImageData.h>
+#include <vtkImageStencilData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+vtkImageData* UpdateSliceImage(vtkMRMLSliceLogic* sliceLogic)
+{
+  sliceLogic->UpdatePipeline();
+  vtkAlgorithmOutput* connection = sliceLogic->GetImageDataConnection();
+  if (!connection || !connection->GetProducer())
+    {
+    return 0;
+    }
+  connection->GetProducer()->Update();
+  return vtkImageData::SafeDownCast(
+    connection->GetProducer()->GetOutputDataObject(connection->GetIndex()));
+}
+
+//-----------------------------------------------------------------------------
+bool CheckAlpha(vtkImageData* image, int x, int y, int expectedAlpha, const char* step)
+{
+  int alpha = static_cast<int>(image->GetScalarComponentAsDouble(x, y, 0, 3));
+  if (alpha != expectedAlpha)
+    {
+    std::cerr << step << ": alpha of pixel " << x << " " << y << " is "
+              << alpha << " instead of " << expectedAlpha << std::endl;
+    return false;
+    }
+  return true;
+}
+
+}
+
+//-----------------------------------------------------------------------------
+// The pixels of a slice outside of the background volume must be
+// transparent, with and without the fused compositing.
+int vtkMRMLSliceLogicTest6(int , char * [] )
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLSliceLogic> sliceLogic;
+  sliceLogic->SetName("Red");
+  sliceLogic->SetMRMLScene(scene.GetPointer());
+  vtkNew<vtkMRMLSliceLayerLogic> backgroundLayer;
+  sliceLogic->SetBackgroundLayer(backgroundLayer.GetPointer());
+
+  // 20x20x20 volume centered on the origin
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(20, 20, 20);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(imageData->GetScalarPointer());
+  for (int i = 0; i < 20 * 20 * 20; ++i)
+    {
+    voxels[i] = 100;
+    }
+
+  vtkNew<vtkMRMLColorTableNode> colorNode;
+  colorNode->SetTypeToGrey();
+  scene->AddNode(colorNode.GetPointer());
+
+  vtkNew<vtkMRMLScalarVolumeDisplayNode> displayNode;
+  displayNode->SetAutoWindowLevel(false);
+  displayNode->SetWindowLevel(100., 50.);
+  displayNode->SetInterpolate(false);
+  scene->AddNode(displayNode.GetPointer());
+  displayNode->SetAndObserveColorNodeID(colorNode->GetID());
+
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetOrigin(-10., -10., -10.);
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  scene->AddNode(volumeNode.GetPointer());
+  volumeNode->SetAndObserveDisplayNodeID(displayNode->GetID());
+
+  // 64x64 pixels slice 4 times as large as the volume
+  vtkMRMLSliceNode* sliceNode = sliceLogic->GetSliceNode();
+  sliceNode->SetDimensions(64, 64, 1);
+  sliceNode->SetFieldOfView(80., 80., 1.);
+  sliceNode->UpdateMatrices();
+  sliceLogic->GetSliceCompositeNode()->SetBackgroundVolumeID(volumeNode->GetID());
+
+  vtkImageData* image = UpdateSliceImage(sliceLogic.GetPointer());
+  if (!image)
+    {
+    std::cerr << "Line " << __LINE__ << ": no slice image" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the display node exposes the stencil of the reslice filter
+  if (!displayNode->GetBackgroundImageStencilDataConnection() ||
+      !displayNode->GetBackgroundImageStencilData())
+    {
+    std::cerr << "Line " << __LINE__ << ": no background stencil" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // fused compositing
+  if (sliceLogic->GetImageDataConnection() != sliceLogic->GetCompositor()->GetOutputPort() ||
+      sliceLogic->GetCompositor()->GetLayerMode(0) != vtkImageSliceCompositor::LayerWindowLevel)
+    {
+    std::cerr << "Line " << __LINE__ << ": the background layer is not composited" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (!CheckAlpha(image, 32, 32, 255, "Fused compositing") ||
+      !CheckAlpha(image, 2, 2, 0, "Fused compositing") ||
+      !CheckAlpha(image, 61, 32, 0, "Fused compositing"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // same result with vtkImageBlend
+  sliceLogic->SetUseFusedCompositing(0);
+  image = UpdateSliceImage(sliceLogic.GetPointer());
+  if (!image ||
+      !CheckAlpha(image, 32, 32, 255, "Blend") ||
+      !CheckAlpha(image, 2, 2, 0, "Blend") ||
+      !CheckAlpha(image, 61, 32, 0, "Blend"))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,863 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkImageResliceCache.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkConditionVariable.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkHomogeneousTransform.h>
+#include <vtkImageData.h>
+#include <vtkImageReslice.h>
+#include <vtkImageStencilData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkSmartPointer.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTransform.h>
+#include <vtkWeakPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <list>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageResliceCache);
+
+//----------------------------------------------------------------------------
+class vtkImageResliceCache::vtkInternal
+{
+public:
+  /// What the resliced image depends on
+  struct Key
+    {
+    double Matrix[16];
+    int Extent[6];
+    double Spacing[3];
+    double Origin[3];
+    int InterpolationMode;
+    /// Input voxels sampled by the slice (not part of the comparison)
+    int InputExtent[6];
+
+    /// Same slice up to a negligible fraction of a voxel
+    bool IsEqual(const Key& other)const
+      {
+      return this->IsSameOrientation(other) &&
+        std::fabs(this->Matrix[3] - other.Matrix[3]) < 1e-6 &&
+        std::fabs(this->Matrix[7] - other.Matrix[7]) < 1e-6 &&
+        std::fabs(this->Matrix[11] - other.Matrix[11]) < 1e-6;
+      }
+    /// Same slice except for the translation
+    bool IsSameOrientation(const Key& other)const
+      {
+      if (this->InterpolationMode != other.InterpolationMode ||
+          !std::equal(this->Extent, this->Extent + 6, other.Extent) ||
+          !std::equal(this->Spacing, this->Spacing + 3, other.Spacing) ||
+          !std::equal(this->Origin, this->Origin + 3, other.Origin))
+        {
+        return false;
+        }
+      for (int i = 0; i < 16; ++i)
+        {
+        if ((i % 4) != 3 && std::fabs(this->Matrix[i] - other.Matrix[i]) >= 1e-6)
+          {
+          return false;
+          }
+        }
+      return true;
+      }
+    /// True if the slice samples a voxel of the input region
+    bool IsInRegion(const int region[6])const
+      {
+      for (int i = 0; i < 3; ++i)
+        {
+        if (this->InputExtent[2*i] > region[2*i+1] ||
+            this->InputExtent[2*i+1] < region[2*i])
+          {
+          return false;
+          }
+        }
+      return true;
+      }
+    };
+
+  struct Entry
+    {
+    Key SliceKey;
+    vtkSmartPointer<vtkImageData> Image;
+    vtkSmartPointer<vtkImageStencilData> Stencil;
+    unsigned long Size;
+    };
+
+  struct PrefetchRequest
+    {
+    Key SliceKey;
+    vtkSmartPointer<vtkImageReslice> Reslice;
+    };
+
+  vtkInternal();
+
+  /// Compute the key of the current reslice parameters and input.
+  /// Return false if the output can't be cached.
+  static bool ComputeKey(vtkImageReslice* reslice, vtkImageData* input, Key& key);
+  /// Compute the input voxels sampled by the slice of the key.
+  static void ComputeInputExtent(vtkImageData* input, Key& key);
+
+  /// Observe the modifications of the input the entries are resliced from.
+  void SetObservedInput(vtkImageData* input);
+  static void InputModifiedCallback(vtkObject* caller, unsigned long eid,
+                                    void* clientData, void* callData);
+
+  /// The following methods must be called with the lock held.
+  /// Move the entry to the front if found.
+  bool FindEntry(const Key& key, Entry& entry);
+  bool HasEntry(const Key& key)const;
+  void AddEntry(const Key& key, vtkImageData* image, vtkImageStencilData* stencil);
+  void RemoveLeastRecentlyUsedEntries();
+  /// Remove the entries and the prefetch requests that sample the input
+  /// region, all of them if region is 0.
+  void RemoveEntries(const int* region);
+
+  /// Prefetch thread loop, the user data is the vtkInternal.
+  static VTK_THREAD_RETURN_TYPE PrefetchThread(void* arg);
+  void StartPrefetchThread();
+  void StopPrefetchThread();
+
+  std::list<Entry> Entries;
+  unsigned long Size;
+  unsigned long MaximumSize;
+
+  Key CurrentKey;
+  bool HasCurrentKey;
+  Key PreviousKey;
+  bool HasPreviousKey;
+  /// Input modified time of the last request, 0 if none
+  unsigned long LastInputMTime;
+
+  /// Input the entries are resliced from and its modified time they are up
+  /// to date with. Its voxels may be modified by the next ModifiedEvent only
+  /// in ModifiedRegion if HasModifiedRegion is true.
+  vtkWeakPointer<vtkImageData> ObservedInput;
+  unsigned long InputObserverTag;
+  vtkNew<vtkCallbackCommand> InputObserver;
+  unsigned long InputMTime;
+  bool HasModifiedRegion;
+  int ModifiedRegion[6];
+
+  vtkNew<vtkMutexLock> Lock;
+  vtkNew<vtkConditionVariable> Condition;
+  vtkNew<vtkMultiThreader> Threader;
+  int PrefetchThreadID;
+  std::deque<PrefetchRequest> PrefetchRequests;
+  bool Prefetching;
+  /// The slice being prefetched samples modified voxels
+  bool DiscardPrefetchedSlice;
+  Key PrefetchingKey;
+  bool StopPrefetch;
+};
+
+//----------------------------------------------------------------------------
+vtkImageResliceCache::vtkInternal::vtkInternal()
+{
+  this->Size = 0;
+  this->MaximumSize = 0;
+  this->HasCurrentKey = false;
+  this->HasPreviousKey = false;
+  this->LastInputMTime = 0;
+  this->InputObserverTag = 0;
+  this->InputObserver->SetCallback(&vtkInternal::InputModifiedCallback);
+  this->InputObserver->SetClientData(this);
+  this->InputMTime = 0;
+  this->HasModifiedRegion = false;
+  this->PrefetchThreadID = -1;
+  this->Prefetching = false;
+  this->DiscardPrefetchedSlice = false;
+  this->StopPrefetch = false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageResliceCache::vtkInternal::ComputeKey(vtkImageReslice* reslice,
+                                                   vtkImageData* input, Key& key)
+{
+  if (!reslice || !input || reslice->GetResliceAxes())
+    {
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> matrix;
+  vtkAbstractTransform* transform = reslice->GetResliceTransform();
+  if (transform)
+    {
+    vtkHomogeneousTransform* linearTransform = vtkHomogeneousTransform::SafeDownCast(transform);
+    if (!linearTransform)
+      {
+      return false;
+      }
+    linearTransform->GetMatrix(matrix.GetPointer());
+    }
+  for (int i = 0; i < 4; ++i)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      key.Matrix[4 * i + j] = matrix->GetElement(i, j);
+      }
+    }
+  reslice->GetOutputExtent(key.Extent);
+  reslice->GetOutputSpacing(key.Spacing);
+  reslice->GetOutputOrigin(key.Origin);
+  key.InterpolationMode = reslice->GetInterpolationMode();
+  ComputeInputExtent(input, key);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::vtkInternal::ComputeInputExtent(vtkImageData* input, Key& key)
+{
+  double inputSpacing[3];
+  double inputOrigin[3];
+  input->GetSpacing(inputSpacing);
+  input->GetOrigin(inputOrigin);
+  double bounds[6] = {VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX,
+                      -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+  // the slice is a box in the output space, its corners bound it in the input
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    double point[4] = {0., 0., 0., 1.};
+    for (int i = 0; i < 3; ++i)
+      {
+      point[i] = key.Origin[i] + key.Spacing[i] * key.Extent[2*i + ((corner >> i) & 1)];
+      }
+    double inputPoint[4] = {0., 0., 0., 0.};
+    for (int i = 0; i < 4; ++i)
+      {
+      for (int j = 0; j < 4; ++j)
+        {
+        inputPoint[i] += key.Matrix[4 * i + j] * point[j];
+        }
+      }
+    if (inputPoint[3] == 0. || inputSpacing[0] == 0. ||
+        inputSpacing[1] == 0. || inputSpacing[2] == 0.)
+      {
+      // can't be bounded, the slice depends on the whole input
+      for (int i = 0; i < 3; ++i)
+        {
+        key.InputExtent[2*i] = VTK_INT_MIN;
+        key.InputExtent[2*i+1] = VTK_INT_MAX;
+        }
+      return;
+      }
+    for (int i = 0; i < 3; ++i)
+      {
+      double ijk = (inputPoint[i] / inputPoint[3] - inputOrigin[i]) / inputSpacing[i];
+      bounds[2*i] = std::min(bounds[2*i], ijk);
+      bounds[2*i+1] = std::max(bounds[2*i+1], ijk);
+      }
+    }
+  // the interpolation kernel reaches up to 2 voxels away (cubic)
+  for (int i = 0; i < 3; ++i)
+    {
+    key.InputExtent[2*i] = static_cast<int>(std::max(
+      std::floor(bounds[2*i]) - 2., static_cast<double>(VTK_INT_MIN)));
+    key.InputExtent[2*i+1] = static_cast<int>(std::min(
+      std::ceil(bounds[2*i+1]) + 2., static_cast<double>(VTK_INT_MAX)));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::vtkInternal::SetObservedInput(vtkImageData* input)
+{
+  if (this->ObservedInput.GetPointer() == input)
+    {
+    return;
+    }
+  if (this->ObservedInput)
+    {
+    this->ObservedInput->RemoveObserver(this->InputObserverTag);
+    }
+  this->ObservedInput = input;
+  this->InputObserverTag = input ?
+    input->AddObserver(vtkCommand::ModifiedEvent, this->InputObserver.GetPointer()) : 0;
+  this->HasModifiedRegion = false;
+  this->Lock->Lock();
+  this->RemoveEntries(0);
+  this->InputMTime = input ? input->GetMTime() : 0;
+  this->Lock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::vtkInternal::InputModifiedCallback(
+  vtkObject* caller, unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+{
+  vtkInternal* self = static_cast<vtkInternal*>(clientData);
+  vtkImageData* input = vtkImageData::SafeDownCast(caller);
+  if (!input || input != self->ObservedInput.GetPointer())
+    {
+    return;
+    }
+  self->Lock->Lock();
+  // The slices that sample the modified region have already been removed
+  // by InputRegionModified(), the others are still up to date.
+  // Any other modification may have changed all the voxels.
+  if (!self->HasModifiedRegion)
+    {
+    self->RemoveEntries(0);
+    }
+  self->InputMTime = input->GetMTime();
+  self->Lock->Unlock();
+  self->HasModifiedRegion = false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageResliceCache::vtkInternal::FindEntry(const Key& key, Entry& entry)
+{
+  for (std::list<Entry>::iterator it = this->Entries.begin(); it != this->Entries.end(); ++it)
+    {
+    if (it->SliceKey.IsEqual(key))
+      {
+      this->Entries.splice(this->Entries.begin(), this->Entries, it);
+      entry = this->Entries.front();
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageResliceCache::vtkInternal::HasEntry(const Key& key)const
+{
+  for (std::list<Entry>::const_iterator it = this->Entries.begin(); it != this->Entries.end(); ++it)
+    {
+    if (it->SliceKey.IsEqual(key))
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::vtkInternal::AddEntry(const Key& key, vtkImageData* image,
+                                                 vtkImageStencilData* stencil)
+{
+  if (this->MaximumSize == 0 || this->HasEntry(key))
+    {
+    return;
+    }
+  Entry entry;
+  entry.SliceKey = key;
+  entry.Image = image;
+  entry.Stencil = stencil;
+  entry.Size = image->GetActualMemorySize() + (stencil ? stencil->GetActualMemorySize() : 0);
+  this->Entries.push_front(entry);
+  this->Size += entry.Size;
+  this->RemoveLeastRecentlyUsedEntries();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::vtkInternal::RemoveLeastRecentlyUsedEntries()
+{
+  while (!this->Entries.empty() && this->Size > this->MaximumSize)
+    {
+    this->Size -= this->Entries.back().Size;
+    this->Entries.pop_back();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::vtkInternal::RemoveEntries(const int* region)
+{
+  std::list<Entry>::iterator it = this->Entries.begin();
+  while (it != this->Entries.end())
+    {
+    if (!region || it->SliceKey.IsInRegion(region))
+      {
+      this->Size -= it->Size;
+      it = this->Entries.erase(it);
+      }
+    else
+      {
+      ++it;
+      }
+    }
+  std::deque<PrefetchRequest>::iterator requestIt = this->PrefetchRequests.begin();
+  while (requestIt != this->PrefetchRequests.end())
+    {
+    if (!region || requestIt->SliceKey.IsInRegion(region))
+      {
+      requestIt = this->PrefetchRequests.erase(requestIt);
+      }
+    else
+      {
+      ++requestIt;
+      }
+    }
+  // the thread may have read the voxels before or while they were modified
+  if (this->Prefetching && (!region || this->PrefetchingKey.IsInRegion(region)))
+    {
+    this->DiscardPrefetchedSlice = true;
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkImageResliceCache::vtkInternal::PrefetchThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkInternal* self = static_cast<vtkInternal*>(info->UserData);
+
+  self->Lock->Lock();
+  while (true)
+    {
+    while (self->PrefetchRequests.empty() && !self->StopPrefetch)
+      {
+      self->Condition->Wait(self->Lock.GetPointer());
+      }
+    if (self->StopPrefetch)
+      {
+      break;
+      }
+    PrefetchRequest request = self->PrefetchRequests.front();
+    self->PrefetchRequests.pop_front();
+    if (self->HasEntry(request.SliceKey))
+      {
+      continue;
+      }
+    self->Prefetching = true;
+    self->DiscardPrefetchedSlice = false;
+    self->PrefetchingKey = request.SliceKey;
+    self->Lock->Unlock();
+
+    request.Reslice->Update();
+    // the reslice output is reused on the next update, keep a copy
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->DeepCopy(request.Reslice->GetOutput());
+    vtkSmartPointer<vtkImageStencilData> stencil;
+    if (request.Reslice->GetGenerateStencilOutput())
+      {
+      stencil = vtkSmartPointer<vtkImageStencilData>::New();
+      stencil->DeepCopy(request.Reslice->GetStencilOutput());
+      }
+
+    self->Lock->Lock();
+    if (!self->DiscardPrefetchedSlice)
+      {
+      self->AddEntry(request.SliceKey, image, stencil);
+      }
+    self->Prefetching = false;
+    self->Condition->Broadcast();
+    }
+  self->Lock->Unlock();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::vtkInternal::StartPrefetchThread()
+{
+  if (this->PrefetchThreadID >= 0)
+    {
+    return;
+    }
+  this->StopPrefetch = false;
+  this->PrefetchThreadID = this->Threader->SpawnThread(
+    (vtkThreadFunctionType) &vtkInternal::PrefetchThread, this);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::vtkInternal::StopPrefetchThread()
+{
+  if (this->PrefetchThreadID < 0)
+    {
+    return;
+    }
+  this->Lock->Lock();
+  this->StopPrefetch = true;
+  this->PrefetchRequests.clear();
+  this->Condition->Broadcast();
+  this->Lock->Unlock();
+  // TerminateThread only waits for the thread to return
+  this->Threader->TerminateThread(this->PrefetchThreadID);
+  this->PrefetchThreadID = -1;
+  this->Prefetching = false;
+}
+
+//----------------------------------------------------------------------------
+vtkImageResliceCache::vtkImageResliceCache()
+{
+  this->Reslice = 0;
+  this->MaximumCacheSize = 64 * 1024;
+  this->Prefetch = 1;
+  this->NumberOfPrefetchedSlices = 2;
+  this->NumberOfCacheHits = 0;
+  this->NumberOfCacheMisses = 0;
+  this->Internal = new vtkInternal;
+  this->Internal->MaximumSize = this->MaximumCacheSize;
+
+  this->SetNumberOfOutputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkImageResliceCache::~vtkImageResliceCache()
+{
+  this->Internal->StopPrefetchThread();
+  this->Internal->SetObservedInput(0);
+  this->SetReslice(0);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Reslice: " << this->Reslice << "\n";
+  os << indent << "MaximumCacheSize: " << this->MaximumCacheSize << "\n";
+  os << indent << "Prefetch: " << this->Prefetch << "\n";
+  os << indent << "NumberOfPrefetchedSlices: " << this->NumberOfPrefetchedSlices << "\n";
+  os << indent << "NumberOfCachedImages: " << this->GetNumberOfCachedImages() << "\n";
+  os << indent << "CacheSize: " << this->GetCacheSize() << "\n";
+  os << indent << "NumberOfCacheHits: " << this->NumberOfCacheHits << "\n";
+  os << indent << "NumberOfCacheMisses: " << this->NumberOfCacheMisses << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkCxxSetObjectMacro(vtkImageResliceCache, Reslice, vtkImageReslice);
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::SetMaximumCacheSize(unsigned long size)
+{
+  if (this->MaximumCacheSize == size)
+    {
+    return;
+    }
+  this->MaximumCacheSize = size;
+  this->Internal->Lock->Lock();
+  this->Internal->MaximumSize = size;
+  this->Internal->RemoveLeastRecentlyUsedEntries();
+  this->Internal->Lock->Unlock();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::ClearCache()
+{
+  this->Internal->Lock->Lock();
+  this->Internal->PrefetchRequests.clear();
+  this->Internal->Entries.clear();
+  this->Internal->Size = 0;
+  this->Internal->Lock->Unlock();
+  this->Internal->HasPreviousKey = false;
+  this->Internal->LastInputMTime = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::InputRegionModified(int extent[6])
+{
+  vtkImageData* input = this->Internal->ObservedInput;
+  if (!input)
+    {
+    return;
+    }
+  this->Internal->Lock->Lock();
+  if (input->GetMTime() != this->Internal->InputMTime)
+    {
+    // modified since the last request without being reported: the entries
+    // are removed by the next request anyway
+    this->Internal->Lock->Unlock();
+    return;
+    }
+  this->Internal->RemoveEntries(extent);
+  this->Internal->Lock->Unlock();
+  if (this->Internal->HasModifiedRegion)
+    {
+    for (int i = 0; i < 3; ++i)
+      {
+      this->Internal->ModifiedRegion[2*i] = std::min(this->Internal->ModifiedRegion[2*i], extent[2*i]);
+      this->Internal->ModifiedRegion[2*i+1] = std::max(this->Internal->ModifiedRegion[2*i+1], extent[2*i+1]);
+      }
+    }
+  else
+    {
+    std::copy(extent, extent + 6, this->Internal->ModifiedRegion);
+    this->Internal->HasModifiedRegion = true;
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkImageResliceCache::GetNumberOfCachedImages()
+{
+  this->Internal->Lock->Lock();
+  int numberOfImages = static_cast<int>(this->Internal->Entries.size());
+  this->Internal->Lock->Unlock();
+  return numberOfImages;
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageResliceCache::GetCacheSize()
+{
+  this->Internal->Lock->Lock();
+  unsigned long size = this->Internal->Size;
+  this->Internal->Lock->Unlock();
+  return size;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::WaitForPrefetch()
+{
+  this->Internal->Lock->Lock();
+  while (this->Internal->PrefetchThreadID >= 0 &&
+         (!this->Internal->PrefetchRequests.empty() || this->Internal->Prefetching))
+    {
+    this->Internal->Condition->Wait(this->Internal->Lock.GetPointer());
+    }
+  this->Internal->Lock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageResliceCache::GetMTime()
+{
+  unsigned long mTime = this->Superclass::GetMTime();
+  if (this->Reslice)
+    {
+    mTime = std::max(mTime, this->Reslice->GetMTime());
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageResliceCache::FillOutputPortInformation(int port, vtkInformation* info)
+{
+  if (port == 1)
+    {
+    info->Set(vtkDataObject::DATA_TYPE_NAME(), "vtkImageStencilData");
+    return 1;
+    }
+  return this->Superclass::FillOutputPortInformation(port, info);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageResliceCache::RequestInformation(vtkInformation* vtkNotUsed(request),
+                                             vtkInformationVector** vtkNotUsed(inputVector),
+                                             vtkInformationVector* outputVector)
+{
+  if (!this->Reslice)
+    {
+    vtkErrorMacro("RequestInformation: no reslice filter");
+    return 0;
+    }
+  // the output is the output of the reslice filter
+  this->Reslice->UpdateInformation();
+  vtkInformation* resliceInfo = this->Reslice->GetOutputInformation(0);
+  for (int port = 0; port < 2; ++port)
+    {
+    vtkInformation* outInfo = outputVector->GetInformationObject(port);
+    outInfo->CopyEntry(resliceInfo, vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT());
+    outInfo->CopyEntry(resliceInfo, vtkDataObject::SPACING());
+    outInfo->CopyEntry(resliceInfo, vtkDataObject::ORIGIN());
+    }
+  vtkInformation* scalarInfo = vtkDataObject::GetActiveFieldInformation(
+    resliceInfo, vtkDataObject::FIELD_ASSOCIATION_POINTS, vtkDataSetAttributes::SCALARS);
+  if (scalarInfo)
+    {
+    vtkDataObject::SetPointDataActiveScalarInfo(outputVector->GetInformationObject(0),
+      scalarInfo->Get(vtkDataObject::FIELD_ARRAY_TYPE()),
+      scalarInfo->Get(vtkDataObject::FIELD_NUMBER_OF_COMPONENTS()));
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageResliceCache::RequestUpdateExtent(vtkInformation* vtkNotUsed(request),
+                                              vtkInformationVector** inputVector,
+                                              vtkInformationVector* vtkNotUsed(outputVector))
+{
+  // The whole input is needed to reslice any slice
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(),
+              inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()), 6);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageResliceCache::RequestData(vtkInformation* vtkNotUsed(request),
+                                      vtkInformationVector** inputVector,
+                                      vtkInformationVector* outputVector)
+{
+  vtkImageData* input = vtkImageData::GetData(inputVector[0]);
+  vtkImageData* output = vtkImageData::GetData(outputVector, 0);
+  vtkImageStencilData* stencilOutput = vtkImageStencilData::GetData(outputVector, 1);
+  if (!this->Reslice)
+    {
+    vtkErrorMacro("RequestData: no reslice filter");
+    return 0;
+    }
+
+  // The entries are up to date with the input as long as it is modified
+  // through InputRegionModified() only. Any other modification, observed
+  // or not (e.g. a Modified() on the scalars), removes all of them.
+  this->Internal->SetObservedInput(input);
+  this->Internal->HasModifiedRegion = false;
+  if (input && input->GetMTime() != this->Internal->InputMTime)
+    {
+    this->Internal->Lock->Lock();
+    this->Internal->RemoveEntries(0);
+    this->Internal->InputMTime = input->GetMTime();
+    this->Internal->Lock->Unlock();
+    }
+
+  vtkInternal::Key key;
+  bool cacheable = this->MaximumCacheSize > 0 &&
+    vtkInternal::ComputeKey(this->Reslice, input, key);
+
+  // The input is being edited (e.g. painted) when it is modified between
+  // two requests: the slice is likely to be modified again by the next
+  // request, it is not copied into the cache.
+  unsigned long inputMTime = input ? input->GetMTime() : 0;
+  bool inputEdited = this->Internal->LastInputMTime != 0 &&
+    inputMTime != this->Internal->LastInputMTime;
+  this->Internal->LastInputMTime = inputMTime;
+
+  vtkInternal::Entry entry;
+  bool found = false;
+  if (cacheable)
+    {
+    this->Internal->Lock->Lock();
+    found = this->Internal->FindEntry(key, entry);
+    this->Internal->Lock->Unlock();
+    }
+
+  if (found)
+    {
+    ++this->NumberOfCacheHits;
+    }
+  else
+    {
+    ++this->NumberOfCacheMisses;
+    this->Reslice->Update();
+    if (!cacheable || inputEdited)
+      {
+      output->ShallowCopy(this->Reslice->GetOutput());
+      if (stencilOutput && this->Reslice->GetGenerateStencilOutput())
+        {
+        stencilOutput->ShallowCopy(this->Reslice->GetStencilOutput());
+        }
+      this->Internal->HasCurrentKey = false;
+      this->Internal->HasPreviousKey = false;
+      return 1;
+      }
+    // the reslice output is reused on the next update, keep a copy
+    entry.Image = vtkSmartPointer<vtkImageData>::New();
+    entry.Image->DeepCopy(this->Reslice->GetOutput());
+    if (this->Reslice->GetGenerateStencilOutput())
+      {
+      entry.Stencil = vtkSmartPointer<vtkImageStencilData>::New();
+      entry.Stencil->DeepCopy(this->Reslice->GetStencilOutput());
+      }
+    this->Internal->Lock->Lock();
+    this->Internal->AddEntry(key, entry.Image, entry.Stencil);
+    this->Internal->Lock->Unlock();
+    }
+
+  output->ShallowCopy(entry.Image);
+  if (stencilOutput && entry.Stencil)
+    {
+    stencilOutput->ShallowCopy(entry.Stencil);
+    }
+
+  this->Internal->CurrentKey = key;
+  this->Internal->HasCurrentKey = true;
+  if (this->Prefetch)
+    {
+    this->PrefetchNextSlices(input);
+    }
+  this->Internal->PreviousKey = key;
+  this->Internal->HasPreviousKey = true;
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageResliceCache::PrefetchNextSlices(vtkImageData* input)
+{
+  if (!this->Internal->HasCurrentKey || !this->Internal->HasPreviousKey)
+    {
+    return;
+    }
+  const vtkInternal::Key& current = this->Internal->CurrentKey;
+  const vtkInternal::Key& previous = this->Internal->PreviousKey;
+  // only a scroll (translation of the same slice) can be extrapolated
+  if (!current.IsSameOrientation(previous) || current.IsEqual(previous))
+    {
+    return;
+    }
+  double step[3] = {current.Matrix[3] - previous.Matrix[3],
+                    current.Matrix[7] - previous.Matrix[7],
+                    current.Matrix[11] - previous.Matrix[11]};
+
+  // The prefetch thread works on its own reslice filter and on a shallow
+  // copy of the input: the voxels are not copied, the thread keeps a
+  // reference to them in case the input reallocates its scalars. A slice
+  // whose voxels are modified while the thread reads them is discarded.
+  vtkSmartPointer<vtkImageData> prefetchInput = vtkSmartPointer<vtkImageData>::New();
+  prefetchInput->ShallowCopy(input);
+
+  std::deque<vtkInternal::PrefetchRequest> requests;
+  for (int i = 1; i <= this->NumberOfPrefetchedSlices; ++i)
+    {
+    vtkInternal::PrefetchRequest request;
+    request.SliceKey = current;
+    request.SliceKey.Matrix[3] += i * step[0];
+    request.SliceKey.Matrix[7] += i * step[1];
+    request.SliceKey.Matrix[11] += i * step[2];
+    vtkInternal::ComputeInputExtent(input, request.SliceKey);
+
+    vtkNew<vtkTransform> transform;
+    transform->SetMatrix(request.SliceKey.Matrix);
+    request.Reslice = vtkSmartPointer<vtkImageReslice>::New();
+    request.Reslice->SetInputData(prefetchInput);
+    request.Reslice->SetResliceTransform(transform.GetPointer());
+    request.Reslice->SetOutputExtent(current.Extent);
+    request.Reslice->SetOutputSpacing(current.Spacing);
+    request.Reslice->SetOutputOrigin(current.Origin);
+    request.Reslice->SetOutputDimensionality(this->Reslice->GetOutputDimensionality());
+    request.Reslice->SetInterpolationMode(current.InterpolationMode);
+    request.Reslice->SetBackgroundColor(this->Reslice->GetBackgroundColor());
+    request.Reslice->SetOptimization(this->Reslice->GetOptimization());
+    request.Reslice->SetAutoCropOutput(this->Reslice->GetAutoCropOutput());
+    request.Reslice->SetGenerateStencilOutput(this->Reslice->GetGenerateStencilOutput());
+    // leave the other cores to the rendering
+    request.Reslice->SetNumberOfThreads(1);
+    requests.push_back(request);
+    }
+
+  this->Internal->Lock->Lock();
+  // the slices requested for a previous position are not needed anymore
+  this->Internal->PrefetchRequests.clear();
+  for (size_t i = 0; i < requests.size(); ++i)
+    {
+    if (!this->Internal->HasEntry(requests[i].SliceKey))
+      {
+      this->Internal->PrefetchRequests.push_back(requests[i]);
+      }
+    }
+  bool hasRequests = !this->Internal->PrefetchRequests.empty();
+  this->Internal->Condition->Broadcast();
+  this->Internal->Lock->Unlock();
+
+  if (hasRequests)
+    {
+    this->Internal->StartPrefetchThread();
+    }
+}
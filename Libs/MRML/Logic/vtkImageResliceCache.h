@@ -0,0 +1,136 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageResliceCache_h
+#define __vtkImageResliceCache_h
+
+// VTK includes
+#include <vtkImageAlgorithm.h>
+
+#include "vtkMRMLLogicWin32Header.h"
+
+class vtkImageReslice;
+
+/// \brief Keep the recent outputs of a vtkImageReslice in a LRU cache.
+///
+/// The filter outputs what \a Reslice outputs for the same input (port 0:
+/// resliced image, port 1: background stencil) but keeps the recently
+/// resliced images. Requesting again a slice that is in the cache (same
+/// input modified time, reslice matrix, output extent and interpolation)
+/// returns the cached image instead of reslicing the input again.
+/// Reslice defines the reslicing parameters and computes the cache misses,
+/// its input must be the same as the input of the cache.
+/// Only the linear reslice transforms are cached. A modification of the
+/// input removes all the slices from the cache, unless it is reported by
+/// InputRegionModified(): only the slices that sample the modified voxels
+/// are removed then. While the input is being edited (modified between two
+/// requests, e.g. by painting) the resliced slices are not cached.
+///
+/// When Prefetch is on and successive requests only differ by a
+/// translation (e.g. scrolling through the slices), the next slices in the
+/// same direction are resliced in a background thread. The thread reads
+/// the voxels of the input without copying them.
+/// \sa vtkMRMLSliceLayerLogic
+class VTK_MRML_LOGIC_EXPORT vtkImageResliceCache : public vtkImageAlgorithm
+{
+public:
+  static vtkImageResliceCache *New();
+  vtkTypeMacro(vtkImageResliceCache,vtkImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// The reslice filter that defines the reslicing parameters
+  virtual void SetReslice(vtkImageReslice* reslice);
+  vtkGetObjectMacro(Reslice, vtkImageReslice);
+
+  ///
+  /// Maximum memory used by the cached images, in kibibytes.
+  /// The least recently used images are removed first. 0 disables the
+  /// cache. 64MB by default.
+  void SetMaximumCacheSize(unsigned long size);
+  vtkGetMacro(MaximumCacheSize, unsigned long);
+
+  ///
+  /// Reslice the next slices in the scrolling direction ahead of time in a
+  /// background thread. On by default.
+  vtkSetMacro(Prefetch, int);
+  vtkGetMacro(Prefetch, int);
+  vtkBooleanMacro(Prefetch, int);
+
+  ///
+  /// Number of slices resliced ahead when prefetching. 2 by default.
+  vtkSetClampMacro(NumberOfPrefetchedSlices, int, 1, 16);
+  vtkGetMacro(NumberOfPrefetchedSlices, int);
+
+  ///
+  /// Remove all the images from the cache.
+  void ClearCache();
+
+  ///
+  /// Remove the slices that sample the voxels of the input in the extent
+  /// (IJK). Must be called before the input is modified, the other slices
+  /// are kept when the input modified event is invoked.
+  /// \sa vtkMRMLVolumeNode::ImageDataRegionModified
+  void InputRegionModified(int extent[6]);
+
+  ///
+  /// Number of images in the cache and memory they use in kibibytes.
+  int GetNumberOfCachedImages();
+  unsigned long GetCacheSize();
+
+  ///
+  /// Number of requests found in the cache (hits) or resliced (misses).
+  vtkGetMacro(NumberOfCacheHits, int);
+  vtkGetMacro(NumberOfCacheMisses, int);
+
+  ///
+  /// Block until the pending slices are prefetched.
+  void WaitForPrefetch();
+
+  ///
+  /// The modified time of Reslice is included
+  virtual unsigned long GetMTime();
+
+protected:
+  vtkImageResliceCache();
+  ~vtkImageResliceCache();
+
+  virtual int FillOutputPortInformation(int port, vtkInformation* info);
+
+  virtual int RequestInformation(vtkInformation* request,
+                                 vtkInformationVector** inputVector,
+                                 vtkInformationVector* outputVector);
+  virtual int RequestUpdateExtent(vtkInformation* request,
+                                  vtkInformationVector** inputVector,
+                                  vtkInformationVector* outputVector);
+  virtual int RequestData(vtkInformation* request,
+                          vtkInformationVector** inputVector,
+                          vtkInformationVector* outputVector);
+
+  /// Queue the slices after the requested one if the requests are scrolling
+  void PrefetchNextSlices(vtkImageData* input);
+
+  vtkImageReslice* Reslice;
+  unsigned long MaximumCacheSize;
+  int Prefetch;
+  int NumberOfPrefetchedSlices;
+  int NumberOfCacheHits;
+  int NumberOfCacheMisses;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkImageResliceCache(const vtkImageResliceCache&);  // Not implemented.
+  void operator=(const vtkImageResliceCache&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,697 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRMLLogic includes
+#include "vtkImageSliceCompositor.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkDataSetAttributes.h>
+#include <vtkImageData.h>
+#include <vtkImageStencilData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkScalarsToColors.h>
+#include <vtkSmartPointer.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageSliceCompositor);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct vtkImageSliceCompositorLayer
+{
+  vtkImageSliceCompositorLayer()
+    : Mode(vtkImageSliceCompositor::LayerRGBA)
+    , Opacity(1.)
+    , Window(256.)
+    , Level(128.)
+    , LowerThreshold(VTK_SHORT_MIN)
+    , UpperThreshold(VTK_SHORT_MAX)
+    , ApplyThreshold(0)
+    , StencilIndex(-1)
+    , Stencil(0)
+    , Skip(false)
+    , Shift(0.)
+    , Scale(1.)
+    , LowerValue(0.)
+    , UpperValue(0.)
+    , LowerIndex(0)
+    , UpperIndex(255)
+    , FirstLabel(0)
+    {}
+
+  int Mode;
+  double Opacity;
+  double Window;
+  double Level;
+  double LowerThreshold;
+  double UpperThreshold;
+  int ApplyThreshold;
+  vtkSmartPointer<vtkScalarsToColors> LookupTable;
+  vtkSmartPointer<vtkAlgorithmOutput> StencilConnection;
+
+  // Set by RequestData for the threads
+  int StencilIndex;
+  vtkImageStencilData* Stencil;
+  bool Skip;
+  double Shift;
+  double Scale;
+  double LowerValue;
+  double UpperValue;
+  int LowerIndex;
+  int UpperIndex;
+  /// RGBA colors of the window/level mapped values (256 entries) or of the
+  /// labels from FirstLabel
+  std::vector<unsigned char> Colors;
+  vtkIdType FirstLabel;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkImageSliceCompositorMapRow(const vtkImageSliceCompositorLayer& layer,
+                                   const T* inPtr, int numComps,
+                                   const unsigned char* mask, int count,
+                                   unsigned char* outPtr)
+{
+  if (layer.Mode == vtkImageSliceCompositor::LayerWindowLevel)
+    {
+    const unsigned char* colors = &layer.Colors[0];
+    for (int i = 0; i < count; ++i, inPtr += numComps, outPtr += 4)
+      {
+      const double value = static_cast<double>(*inPtr);
+      int index;
+      if (value <= layer.LowerValue)
+        {
+        index = layer.LowerIndex;
+        }
+      else if (value >= layer.UpperValue)
+        {
+        index = layer.UpperIndex;
+        }
+      else
+        {
+        index = static_cast<unsigned char>((value + layer.Shift) * layer.Scale);
+        }
+      const unsigned char* color = colors + 4 * index;
+      outPtr[0] = color[0];
+      outPtr[1] = color[1];
+      outPtr[2] = color[2];
+      const bool visible = color[3] != 0 &&
+        (!mask || mask[i]) &&
+        (!layer.ApplyThreshold ||
+         (value >= layer.LowerThreshold && value <= layer.UpperThreshold));
+      outPtr[3] = visible ? 255 : 0;
+      }
+    }
+  else if (layer.Mode == vtkImageSliceCompositor::LayerLabelMap)
+    {
+    const unsigned char* colors = &layer.Colors[0];
+    const vtkIdType lastIndex = static_cast<vtkIdType>(layer.Colors.size() / 4) - 1;
+    for (int i = 0; i < count; ++i, inPtr += numComps, outPtr += 4)
+      {
+      vtkIdType index = static_cast<vtkIdType>(*inPtr) - layer.FirstLabel;
+      index = std::max<vtkIdType>(0, std::min(index, lastIndex));
+      memcpy(outPtr, colors + 4 * index, 4);
+      }
+    }
+  else
+    {
+    for (int i = 0; i < count; ++i, inPtr += numComps, outPtr += 4)
+      {
+      switch (numComps)
+        {
+        case 1:
+          outPtr[0] = outPtr[1] = outPtr[2] = static_cast<unsigned char>(inPtr[0]);
+          outPtr[3] = 255;
+          break;
+        case 2:
+          outPtr[0] = outPtr[1] = outPtr[2] = static_cast<unsigned char>(inPtr[0]);
+          outPtr[3] = static_cast<unsigned char>(inPtr[1]);
+          break;
+        case 3:
+          outPtr[0] = static_cast<unsigned char>(inPtr[0]);
+          outPtr[1] = static_cast<unsigned char>(inPtr[1]);
+          outPtr[2] = static_cast<unsigned char>(inPtr[2]);
+          outPtr[3] = 255;
+          break;
+        default:
+          outPtr[0] = static_cast<unsigned char>(inPtr[0]);
+          outPtr[1] = static_cast<unsigned char>(inPtr[1]);
+          outPtr[2] = static_cast<unsigned char>(inPtr[2]);
+          outPtr[3] = static_cast<unsigned char>(inPtr[3]);
+          break;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Same as vtkImageBlend: the color is alpha blended, the alpha is unchanged
+void vtkImageSliceCompositorBlendRow(const unsigned char* inPtr, int count,
+                                     double opacity, unsigned char* outPtr)
+{
+  const double scale = opacity / 255.;
+  for (int i = 0; i < count; ++i, inPtr += 4, outPtr += 4)
+    {
+    const double alpha = scale * inPtr[3];
+    if (alpha <= 0.)
+      {
+      continue;
+      }
+    for (int c = 0; c < 3; ++c)
+      {
+      outPtr[c] = static_cast<unsigned char>(
+        outPtr[c] + alpha * (static_cast<int>(inPtr[c]) - outPtr[c]) + 0.5);
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkImageSliceCompositor::vtkInternal
+{
+public:
+  vtkImageSliceCompositorLayer* GetLayer(int layer)
+    {
+    return (layer >= 0 && layer < static_cast<int>(this->Layers.size())) ?
+      &this->Layers[layer] : 0;
+    }
+
+  std::vector<vtkImageSliceCompositorLayer> Layers;
+};
+
+//----------------------------------------------------------------------------
+vtkImageSliceCompositor::vtkImageSliceCompositor()
+{
+  this->Internal = new vtkInternal;
+  this->SetNumberOfInputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkImageSliceCompositor::~vtkImageSliceCompositor()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfLayers: " << this->GetNumberOfLayers() << "\n";
+  for (int i = 0; i < this->GetNumberOfLayers(); ++i)
+    {
+    const vtkImageSliceCompositorLayer& layer = this->Internal->Layers[i];
+    os << indent << "Layer " << i << ": Mode: " << layer.Mode
+       << ", Opacity: " << layer.Opacity
+       << ", Window: " << layer.Window
+       << ", Level: " << layer.Level
+       << ", Threshold: " << layer.LowerThreshold << " " << layer.UpperThreshold
+       << (layer.ApplyThreshold ? " (applied)" : "")
+       << ", LookupTable: " << layer.LookupTable.GetPointer()
+       << ", Stencil: " << layer.StencilConnection.GetPointer() << "\n";
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkImageSliceCompositor::FillInputPortInformation(int port, vtkInformation* info)
+{
+  if (port == 1)
+    {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageStencilData");
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    }
+  else
+    {
+    info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+    }
+  info->Set(vtkAlgorithm::INPUT_IS_REPEATABLE(), 1);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::SetNumberOfLayers(int number)
+{
+  number = std::max(number, 0);
+  if (number == this->GetNumberOfLayers())
+    {
+    return;
+    }
+  while (this->GetNumberOfInputConnections(0) > number)
+    {
+    this->RemoveInputConnection(0, this->GetNumberOfInputConnections(0) - 1);
+    }
+  this->Internal->Layers.resize(number);
+  this->UpdateStencilConnections();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageSliceCompositor::GetNumberOfLayers()
+{
+  return static_cast<int>(this->Internal->Layers.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::SetLayerInputConnection(int layer, vtkAlgorithmOutput* input)
+{
+  if (!this->Internal->GetLayer(layer))
+    {
+    vtkErrorMacro("SetLayerInputConnection: invalid layer " << layer);
+    return;
+    }
+  const int numberOfConnections = this->GetNumberOfInputConnections(0);
+  if (layer < numberOfConnections)
+    {
+    this->SetNthInputConnection(0, layer, input);
+    }
+  else if (layer == numberOfConnections)
+    {
+    this->AddInputConnection(0, input);
+    }
+  else
+    {
+    vtkErrorMacro("SetLayerInputConnection: layer " << layer
+                  << " must be connected after layer " << numberOfConnections);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::SetLayerMode(int layer, int mode)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  if (!layerPtr)
+    {
+    vtkErrorMacro("SetLayerMode: invalid layer " << layer);
+    return;
+    }
+  if (layerPtr->Mode == mode)
+    {
+    return;
+    }
+  layerPtr->Mode = mode;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkImageSliceCompositor::GetLayerMode(int layer)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  return layerPtr ? layerPtr->Mode : LayerRGBA;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::SetLayerOpacity(int layer, double opacity)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  if (!layerPtr)
+    {
+    vtkErrorMacro("SetLayerOpacity: invalid layer " << layer);
+    return;
+    }
+  opacity = std::max(0., std::min(opacity, 1.));
+  if (layerPtr->Opacity == opacity)
+    {
+    return;
+    }
+  layerPtr->Opacity = opacity;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+double vtkImageSliceCompositor::GetLayerOpacity(int layer)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  return layerPtr ? layerPtr->Opacity : 0.;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::SetLayerWindowLevel(int layer, double window, double level)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  if (!layerPtr)
+    {
+    vtkErrorMacro("SetLayerWindowLevel: invalid layer " << layer);
+    return;
+    }
+  if (layerPtr->Window == window && layerPtr->Level == level)
+    {
+    return;
+    }
+  layerPtr->Window = window;
+  layerPtr->Level = level;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::SetLayerThreshold(int layer, double lower, double upper, int apply)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  if (!layerPtr)
+    {
+    vtkErrorMacro("SetLayerThreshold: invalid layer " << layer);
+    return;
+    }
+  if (layerPtr->LowerThreshold == lower &&
+      layerPtr->UpperThreshold == upper &&
+      layerPtr->ApplyThreshold == apply)
+    {
+    return;
+    }
+  layerPtr->LowerThreshold = lower;
+  layerPtr->UpperThreshold = upper;
+  layerPtr->ApplyThreshold = apply;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::SetLayerLookupTable(int layer, vtkScalarsToColors* lookupTable)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  if (!layerPtr)
+    {
+    vtkErrorMacro("SetLayerLookupTable: invalid layer " << layer);
+    return;
+    }
+  if (layerPtr->LookupTable.GetPointer() == lookupTable)
+    {
+    return;
+    }
+  layerPtr->LookupTable = lookupTable;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkScalarsToColors* vtkImageSliceCompositor::GetLayerLookupTable(int layer)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  return layerPtr ? layerPtr->LookupTable.GetPointer() : 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::SetLayerStencilConnection(int layer, vtkAlgorithmOutput* stencil)
+{
+  vtkImageSliceCompositorLayer* layerPtr = this->Internal->GetLayer(layer);
+  if (!layerPtr)
+    {
+    vtkErrorMacro("SetLayerStencilConnection: invalid layer " << layer);
+    return;
+    }
+  if (layerPtr->StencilConnection.GetPointer() == stencil)
+    {
+    return;
+    }
+  layerPtr->StencilConnection = stencil;
+  this->UpdateStencilConnections();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::UpdateStencilConnections()
+{
+  std::vector<vtkAlgorithmOutput*> stencils;
+  for (std::vector<vtkImageSliceCompositorLayer>::iterator it =
+         this->Internal->Layers.begin(); it != this->Internal->Layers.end(); ++it)
+    {
+    it->StencilIndex = it->StencilConnection ? static_cast<int>(stencils.size()) : -1;
+    if (it->StencilConnection)
+      {
+      stencils.push_back(it->StencilConnection);
+      }
+    }
+  bool connected = (this->GetNumberOfInputConnections(1) == static_cast<int>(stencils.size()));
+  for (int i = 0; connected && i < static_cast<int>(stencils.size()); ++i)
+    {
+    connected = (this->GetInputConnection(1, i) == stencils[i]);
+    }
+  if (connected)
+    {
+    return;
+    }
+  this->SetInputConnection(1, 0);
+  for (std::vector<vtkAlgorithmOutput*>::iterator it = stencils.begin();
+       it != stencils.end(); ++it)
+    {
+    this->AddInputConnection(1, *it);
+    }
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkImageSliceCompositor::GetMTime()
+{
+  unsigned long mTime = this->Superclass::GetMTime();
+  for (std::vector<vtkImageSliceCompositorLayer>::iterator it =
+         this->Internal->Layers.begin(); it != this->Internal->Layers.end(); ++it)
+    {
+    if (it->LookupTable)
+      {
+      mTime = std::max(mTime, it->LookupTable->GetMTime());
+      }
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageSliceCompositor::RequestInformation(vtkInformation* vtkNotUsed(request),
+                                                vtkInformationVector** vtkNotUsed(inputVector),
+                                                vtkInformationVector* outputVector)
+{
+  // Extent, spacing and origin are the ones of the first layer
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_UNSIGNED_CHAR, 4);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageSliceCompositor::RequestUpdateExtent(vtkInformation* vtkNotUsed(request),
+                                                 vtkInformationVector** inputVector,
+                                                 vtkInformationVector* outputVector)
+{
+  int outExt[6];
+  outputVector->GetInformationObject(0)->Get(
+    vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), outExt);
+  for (int port = 0; port < 2; ++port)
+    {
+    for (int i = 0; i < this->GetNumberOfInputConnections(port); ++i)
+      {
+      vtkInformation* inInfo = inputVector[port]->GetInformationObject(i);
+      int inExt[6];
+      std::copy(outExt, outExt + 6, inExt);
+      if (inInfo->Has(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()))
+        {
+        int wholeExt[6];
+        inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExt);
+        for (int j = 0; j < 3; ++j)
+          {
+          inExt[2*j] = std::max(inExt[2*j], wholeExt[2*j]);
+          inExt[2*j+1] = std::min(inExt[2*j+1], wholeExt[2*j+1]);
+          // empty extents are not allowed
+          inExt[2*j+1] = std::max(inExt[2*j+1], inExt[2*j]);
+          }
+        }
+      inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), inExt, 6);
+      }
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageSliceCompositor::RequestData(vtkInformation* request,
+                                         vtkInformationVector** inputVector,
+                                         vtkInformationVector* outputVector)
+{
+  // Build the color tables once for all the threads
+  const int numberOfLayers = std::min(this->GetNumberOfLayers(),
+                                      this->GetNumberOfInputConnections(0));
+  for (int i = 0; i < numberOfLayers; ++i)
+    {
+    vtkImageSliceCompositorLayer& layer = this->Internal->Layers[i];
+    vtkImageData* input = vtkImageData::GetData(inputVector[0], i);
+    layer.Skip = (!input || !input->GetPointData()->GetScalars());
+    if (layer.Skip)
+      {
+      continue;
+      }
+    layer.Stencil = (layer.StencilIndex >= 0 &&
+                     layer.StencilIndex < this->GetNumberOfInputConnections(1)) ?
+      vtkImageStencilData::SafeDownCast(
+        inputVector[1]->GetInformationObject(layer.StencilIndex)->Get(vtkDataObject::DATA_OBJECT())) : 0;
+    vtkScalarsToColors* lookupTable = layer.LookupTable;
+    if (layer.Mode == LayerWindowLevel)
+      {
+      if (input->GetNumberOfScalarComponents() != 1)
+        {
+        vtkErrorMacro("RequestData: layer " << i << " must have a single component");
+        return 0;
+        }
+      // Same clamping as vtkImageMapToWindowLevelColors
+      const double window = (layer.Window != 0.) ? layer.Window : 1e-6;
+      layer.Shift = window / 2. - layer.Level;
+      layer.Scale = 255. / window;
+      layer.LowerValue = layer.Level - std::fabs(window) / 2.;
+      layer.UpperValue = layer.LowerValue + std::fabs(window);
+      layer.LowerIndex = static_cast<int>(std::max(0., std::min(
+        (layer.LowerValue + layer.Shift) * layer.Scale, 255.)));
+      layer.UpperIndex = static_cast<int>(std::max(0., std::min(
+        (layer.UpperValue + layer.Shift) * layer.Scale, 255.)));
+      layer.Colors.resize(256 * 4);
+      for (int value = 0; value < 256; ++value)
+        {
+        unsigned char* color = &layer.Colors[4 * value];
+        if (lookupTable)
+          {
+          memcpy(color, lookupTable->MapValue(value), 4);
+          }
+        else
+          {
+          color[0] = color[1] = color[2] = static_cast<unsigned char>(value);
+          color[3] = 255;
+          }
+        }
+      }
+    else if (layer.Mode == LayerLabelMap)
+      {
+      if (input->GetScalarType() == VTK_FLOAT || input->GetScalarType() == VTK_DOUBLE)
+        {
+        vtkErrorMacro("RequestData: layer " << i << " must be a label map of integer type");
+        return 0;
+        }
+      // One entry per label of the table range, plus one below and one above
+      // for the labels out of range.
+      double range[2] = {0., 255.};
+      if (lookupTable)
+        {
+        lookupTable->GetRange(range);
+        }
+      layer.FirstLabel = static_cast<vtkIdType>(std::floor(range[0])) - 1;
+      const vtkIdType lastLabel = std::min(
+        static_cast<vtkIdType>(std::ceil(range[1])) + 1, layer.FirstLabel + 65537);
+      layer.Colors.resize(4 * (lastLabel - layer.FirstLabel + 1));
+      for (vtkIdType label = layer.FirstLabel; label <= lastLabel; ++label)
+        {
+        unsigned char* color = &layer.Colors[4 * (label - layer.FirstLabel)];
+        if (lookupTable)
+          {
+          memcpy(color, lookupTable->MapValue(static_cast<double>(label)), 4);
+          }
+        else
+          {
+          color[0] = color[1] = color[2] =
+            static_cast<unsigned char>(std::max<vtkIdType>(0, std::min<vtkIdType>(label, 255)));
+          color[3] = 255;
+          }
+        }
+      }
+    else if (input->GetScalarType() != VTK_UNSIGNED_CHAR)
+      {
+      vtkErrorMacro("RequestData: layer " << i << " must be of type unsigned char");
+      return 0;
+      }
+    }
+  return this->Superclass::RequestData(request, inputVector, outputVector);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageSliceCompositor::ThreadedRequestData(vtkInformation* vtkNotUsed(request),
+                                                  vtkInformationVector** vtkNotUsed(inputVector),
+                                                  vtkInformationVector* vtkNotUsed(outputVector),
+                                                  vtkImageData*** inData,
+                                                  vtkImageData** outData,
+                                                  int outExt[6], int vtkNotUsed(threadId))
+{
+  const int width = outExt[1] - outExt[0] + 1;
+  if (width <= 0 || outExt[3] < outExt[2] || outExt[5] < outExt[4])
+    {
+    return;
+    }
+  const int numberOfLayers = std::min(this->GetNumberOfLayers(),
+                                      this->GetNumberOfInputConnections(0));
+  // A single row of colors and stencil mask per thread
+  std::vector<unsigned char> colors(4 * width);
+  std::vector<unsigned char> mask(width);
+
+  for (int z = outExt[4]; z <= outExt[5]; ++z)
+    {
+    for (int y = outExt[2]; y <= outExt[3]; ++y)
+      {
+      unsigned char* outRow = static_cast<unsigned char*>(
+        outData[0]->GetScalarPointer(outExt[0], y, z));
+      bool firstLayer = true;
+      for (int i = 0; i < numberOfLayers; ++i)
+        {
+        const vtkImageSliceCompositorLayer& layer = this->Internal->Layers[i];
+        vtkImageData* input = inData[0][i];
+        if (layer.Skip || !input)
+          {
+          continue;
+          }
+        const int* inExt = input->GetExtent();
+        const int x0 = std::max(outExt[0], inExt[0]);
+        const int x1 = std::min(outExt[1], inExt[1]);
+        if (x0 > x1 || y < inExt[2] || y > inExt[3] || z < inExt[4] || z > inExt[5])
+          {
+          continue;
+          }
+        const int count = x1 - x0 + 1;
+        const unsigned char* layerMask = 0;
+        if (layer.Stencil)
+          {
+          std::fill(mask.begin(), mask.begin() + count, 0);
+          int r1, r2, iter = 0;
+          while (layer.Stencil->GetNextExtent(r1, r2, x0, x1, y, z, iter))
+            {
+            for (int x = std::max(r1, x0); x <= std::min(r2, x1); ++x)
+              {
+              mask[x - x0] = 1;
+              }
+            }
+          layerMask = &mask[0];
+          }
+        if (firstLayer && count != width)
+          {
+          memset(outRow, 0, 4 * width);
+          }
+        unsigned char* mapped = firstLayer ? outRow + 4 * (x0 - outExt[0]) : &colors[0];
+        void* inPtr = input->GetScalarPointer(x0, y, z);
+        switch (input->GetScalarType())
+          {
+          vtkTemplateMacro(
+            vtkImageSliceCompositorMapRow(layer, static_cast<VTK_TT*>(inPtr),
+                                          input->GetNumberOfScalarComponents(),
+                                          layerMask, count, mapped));
+          default:
+            break;
+          }
+        if (!firstLayer)
+          {
+          vtkImageSliceCompositorBlendRow(mapped, count, layer.Opacity,
+                                          outRow + 4 * (x0 - outExt[0]));
+          }
+        firstLayer = false;
+        }
+      if (firstLayer)
+        {
+        memset(outRow, 0, 4 * width);
+        }
+      }
+    }
+}
@@ -0,0 +1,133 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageSliceCompositor_h
+#define __vtkImageSliceCompositor_h
+
+// VTK includes
+#include <vtkThreadedImageAlgorithm.h>
+
+#include "vtkMRMLLogicWin32Header.h"
+
+class vtkScalarsToColors;
+
+/// \brief Map and blend the slice layers in a single pass.
+///
+/// Each layer is an input connection of port 0, blended in the order of
+/// the connections into a RGBA unsigned char image, the same way
+/// vtkImageBlend does it: the first layer is copied, the next ones are
+/// alpha blended with their opacity and the output alpha is the alpha of
+/// the first layer.
+///
+/// A layer is either:
+/// - LayerRGBA: an unsigned char image already mapped to colors,
+/// - LayerWindowLevel: a single component scalar image mapped the same way
+/// as vtkMRMLScalarVolumeDisplayNode does it (window/level, lookup table,
+/// threshold and background stencil),
+/// - LayerLabelMap: an integer image mapped the same way as
+/// vtkMRMLLabelMapVolumeDisplayNode does it (1:1 lookup table).
+///
+/// The color mapping is done row by row directly into the output, no
+/// intermediate image is allocated.
+/// \sa vtkMRMLSliceLogic
+class VTK_MRML_LOGIC_EXPORT vtkImageSliceCompositor : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkImageSliceCompositor *New();
+  vtkTypeMacro(vtkImageSliceCompositor,vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  enum
+    {
+    LayerRGBA = 0,
+    LayerWindowLevel,
+    LayerLabelMap
+    };
+
+  ///
+  /// Number of layers. Extra layers are removed, missing layers are added
+  /// with no input.
+  void SetNumberOfLayers(int number);
+  int GetNumberOfLayers();
+
+  ///
+  /// Image of the layer, it is the input connection \a layer of port 0.
+  void SetLayerInputConnection(int layer, vtkAlgorithmOutput* input);
+
+  ///
+  /// How the layer image is mapped to colors. LayerRGBA by default.
+  void SetLayerMode(int layer, int mode);
+  int GetLayerMode(int layer);
+
+  ///
+  /// Opacity of the layer. The opacity of the first layer is ignored.
+  void SetLayerOpacity(int layer, double opacity);
+  double GetLayerOpacity(int layer);
+
+  ///
+  /// Window and level of a LayerWindowLevel layer.
+  void SetLayerWindowLevel(int layer, double window, double level);
+
+  ///
+  /// Threshold of a LayerWindowLevel layer: when \a apply is set, the pixels
+  /// outside of [lower, upper] are transparent.
+  void SetLayerThreshold(int layer, double lower, double upper, int apply);
+
+  ///
+  /// Lookup table of a LayerWindowLevel (used on the window/level mapped
+  /// values) or LayerLabelMap (used on the label values) layer.
+  void SetLayerLookupTable(int layer, vtkScalarsToColors* lookupTable);
+  vtkScalarsToColors* GetLayerLookupTable(int layer);
+
+  ///
+  /// Stencil of a LayerWindowLevel layer, the pixels outside of the
+  /// stencil are transparent. The stencils are connected to port 1.
+  void SetLayerStencilConnection(int layer, vtkAlgorithmOutput* stencil);
+
+  ///
+  /// The modified time of the lookup tables is included
+  virtual unsigned long GetMTime();
+
+protected:
+  vtkImageSliceCompositor();
+  ~vtkImageSliceCompositor();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info);
+
+  virtual int RequestInformation(vtkInformation* request,
+                                 vtkInformationVector** inputVector,
+                                 vtkInformationVector* outputVector);
+  virtual int RequestUpdateExtent(vtkInformation* request,
+                                  vtkInformationVector** inputVector,
+                                  vtkInformationVector* outputVector);
+  virtual int RequestData(vtkInformation* request,
+                          vtkInformationVector** inputVector,
+                          vtkInformationVector* outputVector);
+
+  virtual void ThreadedRequestData(vtkInformation* request,
+                                   vtkInformationVector** inputVector,
+                                   vtkInformationVector* outputVector,
+                                   vtkImageData*** inData,
+                                   vtkImageData** outData,
+                                   int outExt[6], int threadId);
+
+  /// Connect to port 1 the stencils of the layers that have one
+  void UpdateStencilConnections();
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkImageSliceCompositor(const vtkImageSliceCompositor&);  // Not implemented.
+  void operator=(const vtkImageSliceCompositor&);  // Not implemented.
+};
+
+#endif
@@ -29,6 +29,7 @@
 #include <vtkMRMLModelHierarchyLogic.h>
 
 // MRML includes
+#include <vtkDataIOManager.h>
 #include <vtkMRMLInteractionNode.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSelectionNode.h>
@@ -608,8 +609,12 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
   // write the new data as we go; save old values
   this->OriginalStorageNodeDirs.clear();
   this->OriginalStorageNodeFileNames.clear();
+  this->DataBundleFileNames.clear();
 
   std::map<std::string, vtkMRMLNode *> storableNodes;
+  // storable nodes of the main scene are written all at once, so that their
+  // files can be written concurrently
+  vtkNew<vtkCollection> deferredWrites;
 
   int numNodes = this->GetMRMLScene()->GetNumberOfNodes();
   for (int i = 0; i < numNodes; ++i)
@@ -626,7 +631,8 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
       // and store them in the map by ID to avoid duplicates for the scene views
       vtkMRMLStorableNode *storableNode = vtkMRMLStorableNode::SafeDownCast(mrmlNode);
 
-      this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir);
+      this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir,
+                                                        deferredWrites.GetPointer());
 
       storableNodes[std::string(storableNode->GetID())] = storableNode;
     }
@@ -645,9 +651,13 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
         if (storableNodes.find(std::string(storableNode->GetID())) == storableNodes.end())
           {
           // save only new storable nodes
+          // (the scene view node is only valid until SetAddToScene(0),
+          // write it and the queued nodes right away)
           storableNode->SetAddToScene(1);
           storableNode->UpdateScene(this->GetMRMLScene());
-          this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir);
+          this->SaveStorableNodeToSlicerDataBundleDirectory(storableNode, dataDir,
+                                                            deferredWrites.GetPointer());
+          this->WriteStorableNodes(deferredWrites.GetPointer());
 
           storableNodes[std::string(storableNode->GetID())] = storableNode;
           storableNode->SetAddToScene(0);
@@ -669,6 +679,7 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
         }
       }
   }
+  this->WriteStorableNodes(deferredWrites.GetPointer());
   //
   // create a scene view, using the snapshot passed in if any
   //
@@ -795,13 +806,15 @@ bool vtkMRMLApplicationLogic::SaveSceneToSlicerDataBundleDirectory(const char *s
 
   this->GetMRMLScene()->SetURL(origURL.c_str());
   this->GetMRMLScene()->SetRootDirectory(origRootDirectory.c_str());
+  this->DataBundleFileNames.clear();
 
   return true;
 }
 
 //----------------------------------------------------------------------------
 void vtkMRMLApplicationLogic::SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNode *storableNode,
-                                                                          std::string &dataDir)
+                                                                          std::string &dataDir,
+                                                                          vtkCollection *deferredWrites)
 {
   if (!storableNode || !storableNode->GetSaveWithScene())
     {
@@ -878,22 +891,85 @@ void vtkMRMLApplicationLogic::SaveStorableNodeToSlicerDataBundleDirectory(vtkMRM
     vtkDebugMacro("set data directory to "
       << dataDir.c_str() << ", storable node " << storableNode->GetID()
       << " file name is now: " << storageNode->GetFileName());
-    // deal with existing files by creating a numeric suffix
-    if (vtksys::SystemTools::FileExists(storageNode->GetFileName(), true))
+    // deal with existing files and with the files of the queued nodes,
+    // that are not written yet, by creating a numeric suffix
+    std::string storageFileName(storageNode->GetFileName());
+    if (vtksys::SystemTools::FileExists(storageFileName.c_str(), true) ||
+        this->DataBundleFileNames.count(storageFileName))
       {
-      vtkWarningMacro("file " << storageNode->GetFileName() << " already exists, renaming!");
+      vtkWarningMacro("file " << storageFileName << " already exists, renaming!");
 
-      std::string uniqueFileName = this->CreateUniqueFileName(fileName);
+      std::string uniqueFileName = this->CreateUniqueDataBundleFileName(storageFileName);
 
       vtkDebugMacro("found unique file name " << uniqueFileName.c_str());
       storageNode->SetFileName(uniqueFileName.c_str());
       }
+    this->DataBundleFileNames.insert(storageNode->GetFileName());
 
-    storageNode->WriteData(storableNode);
-
+    if (deferredWrites)
+      {
+      deferredWrites->AddItem(storableNode);
+      }
+    else
+      {
+      storageNode->WriteData(storableNode);
+      }
     }
  }
 
+//----------------------------------------------------------------------------
+std::string vtkMRMLApplicationLogic::CreateUniqueDataBundleFileName(const std::string& fileName)
+{
+  // keep double extensions such as .nii.gz
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fileName);
+  extension = fileName.substr(fileName.size() - extension.size());
+  std::string baseName = fileName.substr(0, fileName.size() - extension.size());
+
+  std::string uniqueFileName;
+  for (int v = 1; uniqueFileName.empty(); ++v)
+    {
+    std::stringstream ss;
+    ss << baseName << v << extension;
+    if (!vtksys::SystemTools::FileExists(ss.str().c_str(), true) &&
+        !this->DataBundleFileNames.count(ss.str()))
+      {
+      uniqueFileName = ss.str();
+      }
+    }
+  return uniqueFileName;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLApplicationLogic::WriteStorableNodes(vtkCollection *nodes)
+{
+  if (!nodes || nodes->GetNumberOfItems() == 0)
+    {
+    return;
+    }
+  vtkMRMLScene *scene = this->GetMRMLScene();
+  if (scene && scene->GetDataIOManager())
+    {
+    if (!scene->GetDataIOManager()->WriteLocalData(nodes, scene))
+      {
+      vtkErrorMacro("WriteStorableNodes: failed to write some of the nodes");
+      }
+    }
+  else
+    {
+    vtkMRMLStorableNode *storableNode = NULL;
+    vtkCollectionSimpleIterator it;
+    for (nodes->InitTraversal(it);
+         (storableNode = vtkMRMLStorableNode::SafeDownCast(nodes->GetNextItemAsObject(it))) ;)
+      {
+      if (storableNode->GetStorageNode())
+        {
+        storableNode->GetStorageNode()->WriteData(storableNode);
+        }
+      }
+    }
+  nodes->RemoveAllItems();
+}
+
 //----------------------------------------------------------------------------
 std::string vtkMRMLApplicationLogic::CreateUniqueFileName(std::string &filename)
 {
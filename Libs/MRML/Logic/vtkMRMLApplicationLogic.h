@@ -40,6 +40,7 @@ class vtkCollection;
 class vtkImageData;
 
 // STD includes
+#include <set>
 #include <vector>
 
 class VTK_MRML_LOGIC_EXPORT vtkMRMLApplicationLogic
@@ -207,8 +208,23 @@ protected:
   void SetSelectionNode(vtkMRMLSelectionNode* );
   void SetInteractionNode(vtkMRMLInteractionNode* );
 
+  /// Set the storage node file name of \a storableNode into \a dataDir and
+  /// write its data. If \a deferredWrites is not null, the node is appended
+  /// to it instead of being written, the caller is then responsible for
+  /// writing the collected nodes (see WriteStorableNodes()).
   void SaveStorableNodeToSlicerDataBundleDirectory(vtkMRMLStorableNode *storableNode,
-                                                 std::string &dataDir);
+                                                 std::string &dataDir,
+                                                 vtkCollection *deferredWrites = 0);
+
+  /// Write the data of the storable nodes in \a nodes, concurrently when the
+  /// scene has a data I/O manager (see vtkDataIOManager::WriteLocalData()).
+  /// The collection is emptied.
+  void WriteStorableNodes(vtkCollection *nodes);
+
+  /// Return a file name that is neither an existing file nor a file name
+  /// already given to a node of the data bundle being saved, by adding an
+  /// index after the base name of \a fileName.
+  std::string CreateUniqueDataBundleFileName(const std::string& fileName);
 
 
 
@@ -219,6 +235,9 @@ private:
   /// definition the GetFileName returned value, then the rest are at index n+1
   /// from GetNthFileName(n)
   std::map<vtkMRMLStorageNode*, std::vector<std::string> > OriginalStorageNodeFileNames;
+  /// File names given to the storable nodes of the data bundle being saved,
+  /// including the files that are queued but not written yet
+  std::set<std::string> DataBundleFileNames;
 
   vtkMRMLApplicationLogic(const vtkMRMLApplicationLogic&);
   void operator=(const vtkMRMLApplicationLogic&);
@@ -46,6 +46,7 @@
 
 //
 #include "vtkImageLabelOutline.h"
+#include "vtkImageResliceCache.h"
 
 // STD includes
 #include <algorithm>
@@ -114,6 +115,37 @@ void SnapToPermuteMatrix(vtkTransform* transform)
   }
 }
 
+// Return true if the IJK region of the volume (extent) may be visible in the
+// slice defined by its XY to IJK transform and XY dimensions.
+// The region is padded by one voxel to account for interpolation.
+//----------------------------------------------------------------------------
+bool IsImageRegionInSlice(int extent[6], vtkGeneralTransform* xyToIJK,
+                          int dimensions[3])
+{
+  vtkAbstractTransform* ijkToXY = xyToIJK->GetInverse();
+  double xyBounds[6] = {VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+                        VTK_DOUBLE_MAX, VTK_DOUBLE_MIN,
+                        VTK_DOUBLE_MAX, VTK_DOUBLE_MIN};
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    double ijk[3] = { (corner & 1) ? extent[1] + 1. : extent[0] - 1.,
+                      (corner & 2) ? extent[3] + 1. : extent[2] - 1.,
+                      (corner & 4) ? extent[5] + 1. : extent[4] - 1. };
+    double xy[3];
+    ijkToXY->TransformPoint(ijk, xy);
+    for (int i = 0; i < 3; ++i)
+      {
+      xyBounds[2*i] = std::min(xyBounds[2*i], xy[i]);
+      xyBounds[2*i+1] = std::max(xyBounds[2*i+1], xy[i]);
+      }
+    }
+  // the region is a convex box: the slices (z = 0 .. dimensions[2]-1)
+  // intersect it if they are within its z range.
+  return xyBounds[0] <= dimensions[0] - 1 + 0.5 && xyBounds[1] >= -0.5 &&
+         xyBounds[2] <= dimensions[1] - 1 + 0.5 && xyBounds[3] >= -0.5 &&
+         xyBounds[4] <= dimensions[2] - 1 + 0.5 && xyBounds[5] >= -0.5;
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
 {
@@ -138,6 +170,7 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   // Create the parts for the scalar layer pipeline
   this->Reslice = vtkImageReslice::New();
   this->ResliceUVW = vtkImageReslice::New();
+  this->ResliceCache = vtkImageResliceCache::New();
   this->LabelOutline = vtkImageLabelOutline::New();
   this->LabelOutlineUVW = vtkImageLabelOutline::New();
 
@@ -151,6 +184,7 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   this->Reslice->SetOutputSpacing( 1, 1, 1 );
   this->Reslice->SetOutputDimensionality( 3 );
   this->Reslice->GenerateStencilOutputOn();
+  this->ResliceCache->SetReslice(this->Reslice);
 
   this->ResliceUVW->SetBackgroundColor(0, 0, 0, 0); // only first two are used
   this->ResliceUVW->AutoCropOutputOff();
@@ -186,11 +220,13 @@ vtkMRMLSliceLayerLogic::~vtkMRMLSliceLayerLogic()
 
   this->Reslice->SetInputConnection( 0 );
   this->ResliceUVW->SetInputConnection( 0 );
+  this->ResliceCache->SetInputConnection( 0 );
   this->LabelOutline->SetInputConnection( 0 );
   this->LabelOutlineUVW->SetInputConnection( 0 );
 
   this->Reslice->Delete();
   this->ResliceUVW->Delete();
+  this->ResliceCache->Delete();
 
   this->LabelOutline->Delete();
   this->LabelOutlineUVW->Delete();
@@ -272,6 +308,12 @@ void vtkMRMLSliceLayerLogic::ProcessMRMLNodesEvents(vtkObject * caller,
         this->UpdateLogic();
         }
       break;
+    case vtkMRMLVolumeNode::ImageDataRegionModifiedEvent:
+      if (caller == this->VolumeNode && callData)
+        {
+        this->OnVolumeNodeImageRegionModified(static_cast<int*>(callData));
+        }
+      break;
     default:
       this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
       break;
@@ -298,6 +340,31 @@ void vtkMRMLSliceLayerLogic::OnMRMLNodeModified(vtkMRMLNode *node)
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::OnVolumeNodeImageRegionModified(int extent[6])
+{
+  // Only the voxels changed: the transforms and the display pipeline are
+  // still valid, the reslice filters re-execute on their next update because
+  // the image data is modified. The layer is modified only if the region is
+  // visible so that the views that don't show it are not re-rendered.
+  // The cached slices that don't sample the region are kept.
+  this->ResliceCache->InputRegionModified(extent);
+  if (!this->SliceNode)
+    {
+    this->Modified();
+    return;
+    }
+  int dimensions[3];
+  this->SliceNode->GetDimensions(dimensions);
+  int dimensionsUVW[3];
+  this->SliceNode->GetUVWDimensions(dimensionsUVW);
+  if (IsImageRegionInSlice(extent, this->XYToIJKTransform, dimensions) ||
+      IsImageRegionInSlice(extent, this->UVWToIJKTransform, dimensionsUVW))
+    {
+    this->Modified();
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLayerLogic::SetSliceNode(vtkMRMLSliceNode *sliceNode)
 {
@@ -327,10 +394,14 @@ void vtkMRMLSliceLayerLogic::SetVolumeNode(vtkMRMLVolumeNode *volumeNode)
 
   vtkIntArray *events = vtkIntArray::New();
   events->InsertNextValue(vtkMRMLTransformableNode::TransformModifiedEvent);
+  events->InsertNextValue(vtkMRMLVolumeNode::ImageDataRegionModifiedEvent);
   events->InsertNextValue(vtkCommand::ModifiedEvent);
   vtkSetAndObserveMRMLNodeEventsMacro(this->VolumeNode, volumeNode, events );
   events->Delete();
 
+  // the slices of the previous volume won't be requested anymore
+  this->ResliceCache->ClearCache();
+
   // Update the reslice transform to move this image into XY
   this->UpdateTransforms();
   this->UpdateImageDisplay();
@@ -663,6 +734,7 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
 
   unsigned long oldReSliceMTime = this->Reslice->GetMTime();
   unsigned long oldReSliceUVWMTime = this->ResliceUVW->GetMTime();
+  unsigned long oldReSliceCacheMTime = this->ResliceCache->GetMTime();
   unsigned long oldAssign = this->AssignAttributeTensorsToScalars->GetMTime();
   unsigned long oldLabel = this->LabelOutline->GetMTime();
   unsigned long oldLabelUVW = this->LabelOutlineUVW->GetMTime();
@@ -712,8 +784,9 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
         }
       this->Reslice->SetInputConnection( this->AssignAttributeTensorsToScalars->GetOutputPort() );
       this->ResliceUVW->SetInputConnection( this->AssignAttributeTensorsToScalars->GetOutputPort() );
+      this->ResliceCache->SetInputConnection( this->AssignAttributeTensorsToScalars->GetOutputPort() );
 
-      this->AssignAttributeScalarsToTensors->SetInputConnection(this->Reslice->GetOutputPort() );
+      this->AssignAttributeScalarsToTensors->SetInputConnection(this->ResliceCache->GetOutputPort() );
       // don't activate 3D UVW reslice pipeline if we use single 2D reslice pipeline
       if (this->SliceNode && this->SliceNode->GetSliceResolutionMode() != vtkMRMLSliceNode::SliceResolutionMatch2DView)
         {
@@ -753,6 +826,7 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
 //      }
     this->Reslice->SetInputData(volumeNode->GetImageData());
     this->ResliceUVW->SetInputData(volumeNode->GetImageData());
+    this->ResliceCache->SetInputData(volumeNode->GetImageData());
     // use the label outline if we have a label map volume, this is the label
     // layer (turned on in slice logic when the label layer is instantiated)
     // and the slice node is set to use it.
@@ -761,7 +835,7 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
         this->SliceNode && this->SliceNode->GetUseLabelOutline() )
       {
       vtkDebugMacro("UpdateImageDisplay: volume node (not diff tensor), using label outline");
-      this->LabelOutline->SetInputConnection( this->Reslice->GetOutputPort() );
+      this->LabelOutline->SetInputConnection( this->ResliceCache->GetOutputPort() );
       int outlineThickness = labelMapVolumeDisplayNode->GetSliceIntersectionThickness();
       this->LabelOutline->SetOutline(outlineThickness);
       // don't activate 3D UVW reslice pipeline if we use single 2D reslice pipeline
@@ -786,7 +860,7 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
     if (volumeNode != 0 && volumeNode->GetImageData() != 0)
       {
       volumeDisplayNode->SetInputImageDataConnection(this->GetSliceImageDataConnection());
-      volumeDisplayNode->SetBackgroundImageStencilDataConnection(this->Reslice->GetOutputPort(1));
+      volumeDisplayNode->SetBackgroundImageStencilDataConnection(this->ResliceCache->GetOutputPort(1));
       }
     }
   if (volumeDisplayNodeUVW)
@@ -802,6 +876,7 @@ void vtkMRMLSliceLayerLogic::UpdateImageDisplay()
 
   if ( oldReSliceMTime != this->Reslice->GetMTime() ||
        oldReSliceUVWMTime != this->ResliceUVW->GetMTime() ||
+       oldReSliceCacheMTime != this->ResliceCache->GetMTime() ||
        oldAssign != this->AssignAttributeTensorsToScalars->GetMTime() ||
        oldLabel != this->LabelOutline->GetMTime() ||
        oldLabelUVW != this->LabelOutlineUVW->GetMTime() ||
@@ -827,7 +902,7 @@ vtkAlgorithmOutput* vtkMRMLSliceLayerLogic::GetSliceImageDataConnection()
     {
     return this->AssignAttributeScalarsToTensors->GetOutputPort();
     }
-  return this->Reslice->GetOutputPort();
+  return this->ResliceCache->GetOutputPort();
 }
 
 //----------------------------------------------------------------------------
@@ -977,6 +1052,16 @@ void vtkMRMLSliceLayerLogic::PrintSelf(ostream& os, vtkIndent indent)
     os << indent << " (0)\n";
     }
 
+  os << indent << "ResliceCache:\n";
+  if (this->ResliceCache)
+    {
+    this->ResliceCache->PrintSelf(os, nextIndent);
+    }
+  else
+    {
+    os << indent << " (0)\n";
+    }
+
   os << indent << "ResliceUVW:\n";
   if (this->ResliceUVW)
     {
@@ -49,6 +49,7 @@
 
 class vtkAssignAttribute;
 class vtkImageReslice;
+class vtkImageResliceCache;
 class vtkGeneralTransform;
 
 // STL includes
@@ -89,6 +90,13 @@ public:
   vtkGetObjectMacro (Reslice, vtkImageReslice);
   vtkGetObjectMacro (ResliceUVW, vtkImageReslice);
 
+  ///
+  /// The cache of the recent outputs of Reslice. The slice pipeline reads
+  /// the resliced images from the cache so that scrolling back to a
+  /// previous slice doesn't reslice the volume again.
+  /// Its memory cap and prefetching can be configured here.
+  vtkGetObjectMacro (ResliceCache, vtkImageResliceCache);
+
   ///
   /// Select if this is a label layer or not (it currently determines if we use
   /// the label outline filter)
@@ -150,6 +158,10 @@ protected:
                                       void* callData);
   void UpdateLogic();
   virtual void OnMRMLNodeModified(vtkMRMLNode* node);
+  /// Called when the voxels of the volume node inside the IJK \a extent
+  /// were modified in place.
+  /// \sa vtkMRMLVolumeNode::ImageDataRegionModified()
+  void OnVolumeNodeImageRegionModified(int extent[6]);
   vtkAlgorithmOutput* GetSliceImageDataConnection();
   vtkAlgorithmOutput* GetSliceImageDataConnectionUVW();
 
@@ -168,6 +180,7 @@ protected:
   /// the VTK class instances that implement this Logic's operations
   vtkImageReslice *Reslice;
   vtkImageReslice *ResliceUVW;
+  vtkImageResliceCache *ResliceCache;
   vtkImageLabelOutline *LabelOutline;
   vtkImageLabelOutline *LabelOutlineUVW;
 
@@ -15,12 +15,14 @@
 // MRMLLogic includes
 #include "vtkMRMLSliceLogic.h"
 #include "vtkMRMLSliceLayerLogic.h"
+#include "vtkImageSliceCompositor.h"
 
 // MRML includes
 #include <vtkEventBroker.h>
 #include <vtkMRMLCrosshairNode.h>
 #include <vtkMRMLDiffusionTensorVolumeSliceDisplayNode.h>
 #include <vtkMRMLGlyphableVolumeDisplayNode.h>
+#include <vtkMRMLLabelMapVolumeDisplayNode.h>
 #include <vtkMRMLLinearTransformNode.h>
 #include <vtkMRMLModelNode.h>
 #include <vtkMRMLProceduralColorNode.h>
@@ -39,6 +41,7 @@
 #include <vtkImageMathematics.h>
 #include <vtkImageReslice.h>
 #include <vtkInformation.h>
+#include <vtkLookupTable.h>
 #include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
@@ -81,6 +84,9 @@ vtkMRMLSliceLogic::vtkMRMLSliceLogic()
   this->SliceCompositeNode = 0;
   this->Blend = vtkImageBlend::New();
   this->BlendUVW = vtkImageBlend::New();
+  this->Compositor = vtkImageSliceCompositor::New();
+  this->UseFusedCompositing = 1;
+  this->CompositorActive = false;
 
   this->ExtractModelTexture = vtkImageReslice::New();
   this->ExtractModelTexture->SetOutputDimensionality (2);
@@ -120,6 +126,11 @@ vtkMRMLSliceLogic::~vtkMRMLSliceLogic()
     this->BlendUVW->Delete();
     this->BlendUVW = 0;
     }
+  if (this->Compositor)
+    {
+    this->Compositor->Delete();
+    this->Compositor = 0;
+    }
   if (this->ExtractModelTexture)
     {
     this->ExtractModelTexture->Delete();
@@ -574,6 +585,13 @@ void vtkMRMLSliceLogic::ProcessMRMLLogicsEvents()
       }
     }
 
+  // The compositor reads the window/level, threshold and lookup table of the
+  // layer display nodes, keep it in sync even without slice model
+  if (this->SliceNode != 0 && this->SliceCompositeNode != 0)
+    {
+    this->UpdateImageData();
+    }
+
   // This is called when a slice layer is modified, so pass it on
   // to anyone interested in changes to this sub-pipeline
   this->Modified();
@@ -794,10 +812,13 @@ vtkAlgorithmOutput * vtkMRMLSliceLogic::GetImageDataConnection()
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::UpdateImageData ()
 {
+  this->CompositorActive = this->UpdateCompositor();
+  vtkAlgorithmOutput* blendPort = this->CompositorActive ?
+    this->Compositor->GetOutputPort() : this->Blend->GetOutputPort();
   if (this->SliceNode->GetSliceResolutionMode() == vtkMRMLSliceNode::SliceResolutionMatch2DView)
     {
-    this->ExtractModelTexture->SetInputConnection( this->Blend->GetOutputPort() );
-    this->ImageDataConnection = this->Blend->GetOutputPort();
+    this->ExtractModelTexture->SetInputConnection( blendPort );
+    this->ImageDataConnection = blendPort;
     }
   else
     {
@@ -810,9 +831,9 @@ void vtkMRMLSliceLogic::UpdateImageData ()
        (this->GetForegroundLayer() != 0 && this->GetForegroundLayer()->GetImageDataConnection() != 0) ||
        (this->GetLabelLayer() != 0 && this->GetLabelLayer()->GetImageDataConnection() != 0) )
     {
-    if (this->ImageDataConnection == 0 || this->Blend->GetOutputPort()->GetMTime() > this->ImageDataConnection->GetMTime())
+    if (this->ImageDataConnection != blendPort)
       {
-      this->ImageDataConnection = this->Blend->GetOutputPort();
+      this->ImageDataConnection = blendPort;
       }
     }
   else
@@ -829,6 +850,120 @@ void vtkMRMLSliceLogic::UpdateImageData ()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLogic::SetUseFusedCompositing(int use)
+{
+  if (this->UseFusedCompositing == use)
+    {
+    return;
+    }
+  this->UseFusedCompositing = use;
+  if (this->SliceNode && this->SliceCompositeNode)
+    {
+    this->UpdateImageData();
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSliceLogic::UpdateCompositor()
+{
+  // The layers are blended in the order of the Blend inputs, each input
+  // must be the output of a layer (the add/subtract compositing is not
+  // supported).
+  const int numberOfLayers = this->Blend->GetNumberOfInputConnections(0);
+  if (!this->UseFusedCompositing || numberOfLayers == 0)
+    {
+    return false;
+    }
+  vtkMRMLSliceLayerLogic* layers[3] =
+    { this->BackgroundLayer, this->ForegroundLayer, this->LabelLayer };
+  std::vector<vtkMRMLSliceLayerLogic*> blendLayers;
+  for (int i = 0; i < numberOfLayers; ++i)
+    {
+    vtkAlgorithmOutput* blendInput = this->Blend->GetInputConnection(0, i);
+    vtkMRMLSliceLayerLogic* blendLayer = 0;
+    for (int j = 0; j < 3 && !blendLayer; ++j)
+      {
+      if (layers[j] && blendInput && layers[j]->GetImageDataConnection() == blendInput)
+        {
+        blendLayer = layers[j];
+        }
+      }
+    if (!blendLayer)
+      {
+      return false;
+      }
+    blendLayers.push_back(blendLayer);
+    }
+
+  this->Compositor->SetNumberOfLayers(numberOfLayers);
+  for (int i = 0; i < numberOfLayers; ++i)
+    {
+    vtkMRMLVolumeDisplayNode* displayNode = blendLayers[i]->GetVolumeDisplayNode();
+    // Only the exact display node types are mapped by the compositor, the
+    // subclasses may change the pipeline
+    vtkMRMLScalarVolumeDisplayNode* scalarDisplayNode =
+      (displayNode && !strcmp(displayNode->GetClassName(), "vtkMRMLScalarVolumeDisplayNode")) ?
+      vtkMRMLScalarVolumeDisplayNode::SafeDownCast(displayNode) : 0;
+    vtkMRMLLabelMapVolumeDisplayNode* labelMapDisplayNode =
+      (displayNode && !strcmp(displayNode->GetClassName(), "vtkMRMLLabelMapVolumeDisplayNode")) ?
+      vtkMRMLLabelMapVolumeDisplayNode::SafeDownCast(displayNode) : 0;
+    vtkAlgorithmOutput* input = displayNode ? displayNode->GetInputImageDataConnection() : 0;
+    vtkInformation* inputInfo = 0;
+    if (input && input->GetProducer())
+      {
+      input->GetProducer()->UpdateInformation();
+      inputInfo = input->GetProducer()->GetOutputInformation(input->GetIndex());
+      }
+
+    int mode = vtkImageSliceCompositor::LayerRGBA;
+    if (scalarDisplayNode && inputInfo &&
+        scalarDisplayNode->GetLookupTable() &&
+        vtkImageData::GetNumberOfScalarComponents(inputInfo) == 1)
+      {
+      mode = vtkImageSliceCompositor::LayerWindowLevel;
+      }
+    else if (labelMapDisplayNode && inputInfo &&
+             vtkLookupTable::SafeDownCast(labelMapDisplayNode->GetLookupTable()) &&
+             vtkLookupTable::SafeDownCast(labelMapDisplayNode->GetLookupTable())->GetNumberOfTableValues() <= 65536 &&
+             vtkImageData::GetScalarType(inputInfo) != VTK_FLOAT &&
+             vtkImageData::GetScalarType(inputInfo) != VTK_DOUBLE)
+      {
+      mode = vtkImageSliceCompositor::LayerLabelMap;
+      }
+
+    this->Compositor->SetLayerMode(i, mode);
+    this->Compositor->SetLayerOpacity(i, this->Blend->GetOpacity(i));
+    if (mode == vtkImageSliceCompositor::LayerWindowLevel)
+      {
+      this->Compositor->SetLayerInputConnection(i, input);
+      this->Compositor->SetLayerWindowLevel(i,
+        scalarDisplayNode->GetWindow(), scalarDisplayNode->GetLevel());
+      this->Compositor->SetLayerThreshold(i,
+        scalarDisplayNode->GetLowerThreshold(), scalarDisplayNode->GetUpperThreshold(),
+        scalarDisplayNode->GetApplyThreshold());
+      this->Compositor->SetLayerLookupTable(i, scalarDisplayNode->GetLookupTable());
+      this->Compositor->SetLayerStencilConnection(i,
+        scalarDisplayNode->GetBackgroundImageStencilDataConnection());
+      }
+    else if (mode == vtkImageSliceCompositor::LayerLabelMap)
+      {
+      this->Compositor->SetLayerInputConnection(i, input);
+      this->Compositor->SetLayerLookupTable(i, labelMapDisplayNode->GetLookupTable());
+      this->Compositor->SetLayerStencilConnection(i, 0);
+      }
+    else
+      {
+      // already mapped to colors by the display node
+      this->Compositor->SetLayerInputConnection(i, this->Blend->GetInputConnection(0, i));
+      this->Compositor->SetLayerLookupTable(i, 0);
+      this->Compositor->SetLayerStencilConnection(i, 0);
+      }
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSliceLogic::UpdatePipeline()
 {
@@ -1076,7 +1211,12 @@ void vtkMRMLSliceLogic::UpdatePipeline()
       }
 
     //Models
+    unsigned long int oldCompositorMTime = this->Compositor->GetMTime();
     this->UpdateImageData();
+    if (this->Compositor->GetMTime() > oldCompositorMTime)
+      {
+      modified = 1;
+      }
     vtkMRMLDisplayNode* displayNode = this->SliceModelNode ? this->SliceModelNode->GetModelDisplayNode() : 0;
     if ( displayNode && this->SliceNode )
       {
@@ -1184,6 +1324,9 @@ void vtkMRMLSliceLogic::PrintSelf(ostream& os, vtkIndent indent)
     os << indent << "Blend: (none)\n";
     }
 
+  os << indent << "UseFusedCompositing: " << this->UseFusedCompositing << "\n";
+  os << indent << "CompositorActive: " << this->CompositorActive << "\n";
+
   if (this->BlendUVW)
     {
     os << indent << "BlendUVW: ";
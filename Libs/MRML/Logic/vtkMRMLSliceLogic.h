@@ -33,6 +33,7 @@ class vtkMRMLVolumeNode;
 class vtkAlgorithmOutput;
 class vtkCollection;
 class vtkImageBlend;
+class vtkImageSliceCompositor;
 class vtkTransform;
 class vtkImageData;
 class vtkImageReslice;
@@ -128,6 +129,18 @@ public:
   vtkGetObjectMacro(Blend, vtkImageBlend);
   vtkGetObjectMacro(BlendUVW, vtkImageBlend);
 
+  ///
+  /// Filter that maps and blends the layers of the 2D view in a single
+  /// multithreaded pass. It replaces the display node pipelines and Blend
+  /// when the layers are alpha blended.
+  vtkGetObjectMacro(Compositor, vtkImageSliceCompositor);
+
+  ///
+  /// Use Compositor instead of Blend when possible. On by default.
+  vtkGetMacro(UseFusedCompositing, int);
+  void SetUseFusedCompositing(int use);
+  vtkBooleanMacro(UseFusedCompositing, int);
+
   ///
   /// The offset to the correct slice for lightbox mode
   vtkGetObjectMacro(ActiveSliceTransform, vtkTransform);
@@ -157,6 +170,11 @@ public:
   /// Internally used by UpdatePipeline
   void UpdateImageData();
 
+  /// Configure Compositor from the inputs of Blend and the display nodes of
+  /// the layers. Returns true if Compositor can replace Blend.
+  /// Internally used by UpdateImageData
+  bool UpdateCompositor();
+
   /// Reimplemented to avoir calling ProcessMRMLSceneEvents when we are added the
   /// MRMLModelNode into the scene
   virtual bool EnterMRMLCallback()const;
@@ -384,6 +402,9 @@ protected:
 
   vtkImageBlend *   Blend;
   vtkImageBlend *   BlendUVW;
+  vtkImageSliceCompositor * Compositor;
+  int               UseFusedCompositing;
+  bool              CompositorActive;
   vtkImageReslice * ExtractModelTexture;
   vtkAlgorithmOutput *    ImageDataConnection;
   vtkTransform *    ActiveSliceTransform;
@@ -0,0 +1,141 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QPixmap>
+#include <QTimer>
+
+// qMRML includes
+#include "qMRMLChartPlotView.h"
+
+// MRML includes
+#include <vtkMRMLChartNode.h>
+#include <vtkMRMLDoubleArrayNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+vtkMRMLDoubleArrayNode* AddArrayNode(vtkMRMLScene* scene, int numberOfPoints)
+{
+  vtkNew<vtkMRMLDoubleArrayNode> arrayNode;
+  vtkDoubleArray* array = arrayNode->GetArray();
+  array->SetNumberOfComponents(3);
+  array->SetNumberOfTuples(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; ++i)
+    {
+    array->SetComponent(i, 0, i * 0.01);
+    array->SetComponent(i, 1, std::sin(i * 0.1));
+    array->SetComponent(i, 2, 0.);
+    }
+  scene->AddNode(arrayNode.GetPointer());
+  return arrayNode.GetPointer();
+}
+
+//-----------------------------------------------------------------------------
+void Paint(qMRMLChartPlotView& chartPlotView)
+{
+  QPixmap pixmap(chartPlotView.size());
+  chartPlotView.render(&pixmap);
+}
+
+}
+
+//-----------------------------------------------------------------------------
+int qMRMLChartPlotViewTest1(int argc, char * argv [] )
+{
+  QApplication app(argc, argv);
+
+  vtkNew<vtkMRMLScene> scene;
+  const int numberOfPoints = 100000;
+  vtkMRMLDoubleArrayNode* lineArrayNode = AddArrayNode(scene.GetPointer(), numberOfPoints);
+  vtkMRMLDoubleArrayNode* markerArrayNode = AddArrayNode(scene.GetPointer(), numberOfPoints);
+
+  vtkNew<vtkMRMLChartNode> chartNode;
+  chartNode->AddArray("Line", lineArrayNode->GetID());
+  chartNode->AddArray("Markers", markerArrayNode->GetID());
+  chartNode->SetProperty("default", "type", "Line");
+  chartNode->SetProperty("Markers", "showMarkers", "on");
+  scene->AddNode(chartNode.GetPointer());
+
+  qMRMLChartPlotView chartPlotView;
+  chartPlotView.setMRMLScene(scene.GetPointer());
+  chartPlotView.setMRMLChartNode(chartNode.GetPointer());
+  chartPlotView.resize(400, 300);
+  Paint(chartPlotView);
+
+  // the line only series is decimated to a few points per pixel column
+  int lineDrawnPoints = chartPlotView.numberOfDrawnPoints(0);
+  if (lineDrawnPoints <= 0 || lineDrawnPoints > 4 * (chartPlotView.width() + 2))
+    {
+    std::cerr << "Line " << __LINE__ << ": line series not decimated: "
+              << lineDrawnPoints << " points drawn" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // every marker is drawn
+  if (chartPlotView.numberOfDrawnPoints(1) != numberOfPoints)
+    {
+    std::cerr << "Line " << __LINE__ << ": marker series decimated: "
+              << chartPlotView.numberOfDrawnPoints(1) << " points drawn instead of "
+              << numberOfPoints << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // hiding the markers decimates the series
+  chartNode->SetProperty("Markers", "showMarkers", "off");
+  Paint(chartPlotView);
+  if (chartPlotView.numberOfDrawnPoints(1) != lineDrawnPoints)
+    {
+    std::cerr << "Line " << __LINE__ << ": series without markers not decimated: "
+              << chartPlotView.numberOfDrawnPoints(1) << " points drawn instead of "
+              << lineDrawnPoints << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // showing the markers again draws all the points
+  chartNode->SetProperty("Line", "showMarkers", "on");
+  Paint(chartPlotView);
+  if (chartPlotView.numberOfDrawnPoints(0) != numberOfPoints)
+    {
+    std::cerr << "Line " << __LINE__ << ": marker series decimated: "
+              << chartPlotView.numberOfDrawnPoints(0) << " points drawn instead of "
+              << numberOfPoints << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  if (chartPlotView.numberOfDrawnPoints(2) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << ": unexpected series" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  chartPlotView.show();
+  if (argc < 2 || QString(argv[1]) != "-I")
+    {
+    QTimer::singleShot(200, &app, SLOT(quit()));
+    }
+  return app.exec();
+}
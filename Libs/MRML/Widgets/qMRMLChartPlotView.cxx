@@ -0,0 +1,794 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QDebug>
+#include <QHash>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QPolygonF>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+// qMRML includes
+#include "qMRMLChartPlotView_p.h"
+
+// MRML includes
+#include <vtkMRMLChartNode.h>
+#include <vtkMRMLColorLogic.h>
+#include <vtkMRMLColorNode.h>
+#include <vtkMRMLDoubleArrayNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkStringArray.h>
+
+namespace
+{
+/// Distance in pixels under which a point is picked
+const double PickTolerance = 5.;
+
+//---------------------------------------------------------------------------
+bool isPropertyOn(vtkMRMLChartNode* chartNode, const char* name, const char* property)
+{
+  const char* value = chartNode->GetProperty(name, property);
+  return value && !strcmp(value, "on");
+}
+
+//---------------------------------------------------------------------------
+bool isPropertyOff(vtkMRMLChartNode* chartNode, const char* name, const char* property)
+{
+  const char* value = chartNode->GetProperty(name, property);
+  return value && !strcmp(value, "off");
+}
+
+//---------------------------------------------------------------------------
+double padProperty(vtkMRMLChartNode* chartNode, const char* property)
+{
+  // same default as jqPlot: the data range is multiplied by the pad
+  const char* value = chartNode->GetProperty("default", property);
+  return value ? QString(value).toDouble() : 1.2;
+}
+
+//---------------------------------------------------------------------------
+Qt::PenStyle penStyle(const char* linePattern, Qt::PenStyle defaultStyle)
+{
+  if (!linePattern)
+    {
+    return defaultStyle;
+    }
+  if (!strcmp(linePattern, "dashed"))
+    {
+    return Qt::DashLine;
+    }
+  if (!strcmp(linePattern, "dotted"))
+    {
+    return Qt::DotLine;
+    }
+  if (!strcmp(linePattern, "dashed-dotted"))
+    {
+    return Qt::DashDotLine;
+    }
+  return Qt::SolidLine;
+}
+
+}
+
+//--------------------------------------------------------------------------
+// qMRMLChartPlotViewPrivate methods
+
+//---------------------------------------------------------------------------
+qMRMLChartPlotViewPrivate::Series::Series()
+  : PenStyle(Qt::SolidLine)
+  , ShowLines(true)
+  , ShowMarkers(false)
+  , ArrayMTime(0)
+  , Monotonic(true)
+  , DecimatedXMin(0.)
+  , DecimatedXMax(0.)
+  , DecimatedWidth(0)
+{
+}
+
+//---------------------------------------------------------------------------
+qMRMLChartPlotViewPrivate::qMRMLChartPlotViewPrivate(qMRMLChartPlotView& object)
+  : q_ptr(&object)
+{
+  this->MRMLScene = 0;
+  this->MRMLChartNode = 0;
+  this->ColorLogic = 0;
+  this->ShowGrid = false;
+  this->ShowLegend = false;
+  this->XAxisPad = 1.2;
+  this->YAxisPad = 1.2;
+}
+
+//---------------------------------------------------------------------------
+qMRMLChartPlotViewPrivate::~qMRMLChartPlotViewPrivate()
+{
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartPlotViewPrivate::init()
+{
+  Q_Q(qMRMLChartPlotView);
+  q->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+  q->setAttribute(Qt::WA_OpaquePaintEvent);
+  q->setMouseTracking(true);
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartPlotViewPrivate::updateSeriesBounds(Series& series)
+{
+  vtkMRMLDoubleArrayNode* arrayNode = series.ArrayNode;
+  vtkDoubleArray* array = arrayNode ? arrayNode->GetArray() : 0;
+  unsigned long mtime = array ?
+    std::max(arrayNode->GetMTime(), array->GetMTime()) : 0;
+  if (mtime == series.ArrayMTime && mtime != 0)
+    {
+    return;
+    }
+  series.ArrayMTime = mtime;
+  series.Bounds = QRectF();
+  series.Monotonic = true;
+  series.DecimatedWidth = 0;
+  series.Points.clear();
+  series.PointIndices.clear();
+  if (!array || array->GetNumberOfTuples() == 0 || array->GetNumberOfComponents() < 2)
+    {
+    return;
+    }
+  // read the values in place
+  const int numberOfComponents = array->GetNumberOfComponents();
+  const vtkIdType numberOfPoints = array->GetNumberOfTuples();
+  const double* values = array->GetPointer(0);
+  double xMin = values[0];
+  double xMax = values[0];
+  double yMin = values[1];
+  double yMax = values[1];
+  for (vtkIdType i = 1; i < numberOfPoints; ++i)
+    {
+    const double x = values[i * numberOfComponents];
+    const double y = values[i * numberOfComponents + 1];
+    if (x < values[(i - 1) * numberOfComponents])
+      {
+      series.Monotonic = false;
+      }
+    xMin = std::min(xMin, x);
+    xMax = std::max(xMax, x);
+    yMin = std::min(yMin, y);
+    yMax = std::max(yMax, y);
+    }
+  series.Bounds = QRectF(QPointF(xMin, yMin), QPointF(xMax, yMax));
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartPlotViewPrivate::updateSeriesPoints(Series& series, double xMin, double xMax, int width)
+{
+  if (series.DecimatedWidth == width &&
+      series.DecimatedXMin == xMin &&
+      series.DecimatedXMax == xMax)
+    {
+    return;
+    }
+  series.DecimatedWidth = width;
+  series.DecimatedXMin = xMin;
+  series.DecimatedXMax = xMax;
+  series.Points.clear();
+  series.PointIndices.clear();
+
+  vtkMRMLDoubleArrayNode* arrayNode = series.ArrayNode;
+  vtkDoubleArray* array = arrayNode ? arrayNode->GetArray() : 0;
+  if (!array || array->GetNumberOfTuples() == 0 || array->GetNumberOfComponents() < 2)
+    {
+    return;
+    }
+  const int numberOfComponents = array->GetNumberOfComponents();
+  const int numberOfPoints = static_cast<int>(array->GetNumberOfTuples());
+  const double* values = array->GetPointer(0);
+
+  // markers, scattered or small enough: draw all the points. Only the
+  // polyline is unchanged by the decimation, every marker must be drawn.
+  if (series.ShowMarkers || !series.Monotonic ||
+      numberOfPoints <= 4 * width || xMax <= xMin)
+    {
+    series.Points.reserve(numberOfPoints);
+    series.PointIndices.reserve(numberOfPoints);
+    for (int i = 0; i < numberOfPoints; ++i)
+      {
+      series.Points.push_back(QPointF(values[i * numberOfComponents],
+                                      values[i * numberOfComponents + 1]));
+      series.PointIndices.push_back(i);
+      }
+    return;
+    }
+
+  // keep the first, minimum, maximum and last points of each pixel column,
+  // the polyline drawn through them covers the same pixels as the full one
+  series.Points.reserve(4 * (width + 2));
+  series.PointIndices.reserve(4 * (width + 2));
+  const double scale = width / (xMax - xMin);
+  int column = std::numeric_limits<int>::min();
+  int first = 0, minimum = 0, maximum = 0, last = 0;
+  for (int i = 0; i <= numberOfPoints; ++i)
+    {
+    int pointColumn = std::numeric_limits<int>::max();
+    if (i < numberOfPoints)
+      {
+      // points outside of the range fall in the columns on each side
+      double x = (values[i * numberOfComponents] - xMin) * scale;
+      pointColumn = static_cast<int>(std::floor(std::max(-1., std::min(x, static_cast<double>(width)))));
+      }
+    if (pointColumn == column)
+      {
+      const double y = values[i * numberOfComponents + 1];
+      if (y < values[minimum * numberOfComponents + 1])
+        {
+        minimum = i;
+        }
+      if (y > values[maximum * numberOfComponents + 1])
+        {
+        maximum = i;
+        }
+      last = i;
+      continue;
+      }
+    if (column != std::numeric_limits<int>::min())
+      {
+      int indices[4] = { first, std::min(minimum, maximum), std::max(minimum, maximum), last };
+      for (int k = 0; k < 4; ++k)
+        {
+        if (k > 0 && indices[k] == indices[k - 1])
+          {
+          continue;
+          }
+        series.Points.push_back(QPointF(values[indices[k] * numberOfComponents],
+                                        values[indices[k] * numberOfComponents + 1]));
+        series.PointIndices.push_back(indices[k]);
+        }
+      }
+    column = pointColumn;
+    first = minimum = maximum = last = i;
+    }
+}
+
+//---------------------------------------------------------------------------
+QRectF qMRMLChartPlotViewPrivate::dataRange()const
+{
+  QRectF range;
+  foreach(const Series& series, this->SeriesList)
+    {
+    if (series.Bounds.isNull())
+      {
+      continue;
+      }
+    range = range.isNull() ? series.Bounds : range.united(series.Bounds);
+    }
+  if (range.isNull())
+    {
+    return QRectF(0., 0., 1., 1.);
+    }
+  // QRectF::united ignores empty rectangles, e.g. constant series
+  double width = range.width() > 0. ? range.width() : 1.;
+  double height = range.height() > 0. ? range.height() : 1.;
+  double xPad = this->XAxisPad > 1. ? (this->XAxisPad - 1.) * 0.5 * width : 0.;
+  double yPad = this->YAxisPad > 1. ? (this->YAxisPad - 1.) * 0.5 * height : 0.;
+  return QRectF(range.left() - xPad, range.top() - yPad,
+                width + 2. * xPad, height + 2. * yPad);
+}
+
+//---------------------------------------------------------------------------
+QRectF qMRMLChartPlotViewPrivate::plotRect()const
+{
+  Q_Q(const qMRMLChartPlotView);
+  const int fontHeight = q->fontMetrics().height();
+  double left = 3 * fontHeight + (this->YAxisLabel.isEmpty() ? 0 : fontHeight + 4);
+  double top = (this->Title.isEmpty() ? fontHeight : 2 * fontHeight + 4);
+  double right = fontHeight;
+  double bottom = 2 * fontHeight + (this->XAxisLabel.isEmpty() ? 0 : fontHeight + 4);
+  return QRectF(left, top,
+                std::max(1., q->width() - left - right),
+                std::max(1., q->height() - top - bottom));
+}
+
+//---------------------------------------------------------------------------
+QPointF qMRMLChartPlotViewPrivate::toWidget(const QPointF& point, const QRectF& range, const QRectF& plot)const
+{
+  return QPointF(plot.left() + (point.x() - range.left()) / range.width() * plot.width(),
+                 plot.bottom() - (point.y() - range.top()) / range.height() * plot.height());
+}
+
+//---------------------------------------------------------------------------
+bool qMRMLChartPlotViewPrivate::pickPoint(const QPointF& position, int& seriesIndex, int& pointIndex)const
+{
+  const QRectF range = this->dataRange();
+  const QRectF plot = this->plotRect();
+  double closestDistance2 = PickTolerance * PickTolerance;
+  seriesIndex = -1;
+  pointIndex = -1;
+  for (int s = 0; s < this->SeriesList.count(); ++s)
+    {
+    const Series& series = this->SeriesList[s];
+    for (int i = 0; i < series.Points.count(); ++i)
+      {
+      QPointF delta = this->toWidget(series.Points[i], range, plot) - position;
+      double distance2 = delta.x() * delta.x() + delta.y() * delta.y();
+      if (distance2 < closestDistance2)
+        {
+        closestDistance2 = distance2;
+        seriesIndex = s;
+        pointIndex = i;
+        }
+      }
+    }
+  return seriesIndex >= 0;
+}
+
+//---------------------------------------------------------------------------
+QVector<double> qMRMLChartPlotViewPrivate::ticks(double min, double max, int maximumNumberOfTicks)
+{
+  QVector<double> values;
+  if (!(max > min) || maximumNumberOfTicks < 2)
+    {
+    return values;
+    }
+  // step of 1, 2 or 5 times a power of 10
+  double rawStep = (max - min) / (maximumNumberOfTicks - 1);
+  double magnitude = std::pow(10., std::floor(std::log10(rawStep)));
+  double step = magnitude;
+  if (rawStep > 5. * magnitude)
+    {
+    step = 10. * magnitude;
+    }
+  else if (rawStep > 2. * magnitude)
+    {
+    step = 5. * magnitude;
+    }
+  else if (rawStep > magnitude)
+    {
+    step = 2. * magnitude;
+    }
+  for (double value = std::ceil(min / step) * step; value <= max + step * 1e-6; value += step)
+    {
+    // avoid printing -0 or 1e-17
+    values.push_back(std::fabs(value) < step * 1e-6 ? 0. : value);
+    }
+  return values;
+}
+
+//---------------------------------------------------------------------------
+void qMRMLChartPlotViewPrivate::onArrayNodeModified(vtkObject* caller)
+{
+  Q_Q(qMRMLChartPlotView);
+  for (int s = 0; s < this->SeriesList.count(); ++s)
+    {
+    if (this->SeriesList[s].ArrayNode.GetPointer() == caller)
+      {
+      // force the update of this series only
+      this->SeriesList[s].ArrayMTime = 0;
+      }
+    }
+  q->update();
+}
+
+//--------------------------------------------------------------------------
+// qMRMLChartPlotView methods
+
+// --------------------------------------------------------------------------
+qMRMLChartPlotView::qMRMLChartPlotView(QWidget* _parent)
+  : Superclass(_parent)
+  , d_ptr(new qMRMLChartPlotViewPrivate(*this))
+{
+  Q_D(qMRMLChartPlotView);
+  d->init();
+}
+
+// --------------------------------------------------------------------------
+qMRMLChartPlotView::~qMRMLChartPlotView()
+{
+  this->setMRMLChartNode(0);
+}
+
+//------------------------------------------------------------------------------
+void qMRMLChartPlotView::setMRMLScene(vtkMRMLScene* newScene)
+{
+  Q_D(qMRMLChartPlotView);
+  if (newScene == d->MRMLScene)
+    {
+    return;
+    }
+  d->MRMLScene = newScene;
+  if (d->MRMLChartNode && newScene != d->MRMLChartNode->GetScene())
+    {
+    this->setMRMLChartNode(0);
+    }
+  this->updateFromMRML();
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLScene* qMRMLChartPlotView::mrmlScene()const
+{
+  Q_D(const qMRMLChartPlotView);
+  return d->MRMLScene;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLChartPlotView::setMRMLChartNode(vtkMRMLChartNode* newChartNode)
+{
+  Q_D(qMRMLChartPlotView);
+  if (newChartNode == d->MRMLChartNode)
+    {
+    return;
+    }
+  d->qvtkReconnect(d->MRMLChartNode, newChartNode,
+                   vtkCommand::ModifiedEvent, this, SLOT(updateFromMRML()));
+  d->MRMLChartNode = newChartNode;
+  this->updateFromMRML();
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLChartNode* qMRMLChartPlotView::mrmlChartNode()const
+{
+  Q_D(const qMRMLChartPlotView);
+  return d->MRMLChartNode;
+}
+
+//------------------------------------------------------------------------------
+void qMRMLChartPlotView::setColorLogic(vtkMRMLColorLogic* colorLogic)
+{
+  Q_D(qMRMLChartPlotView);
+  d->ColorLogic = colorLogic;
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLColorLogic* qMRMLChartPlotView::colorLogic()const
+{
+  Q_D(const qMRMLChartPlotView);
+  return d->ColorLogic;
+}
+
+//------------------------------------------------------------------------------
+bool qMRMLChartPlotView::canDrawChart(vtkMRMLChartNode* chartNode)
+{
+  if (!chartNode)
+    {
+    return false;
+    }
+  const char* type = chartNode->GetProperty("default", "type");
+  if (type && strcmp(type, "Line") && strcmp(type, "Scatter"))
+    {
+    return false;
+    }
+  const char* xAxisType = chartNode->GetProperty("default", "xAxisType");
+  if (xAxisType && (!strcmp(xAxisType, "categorical") || !strcmp(xAxisType, "date")))
+    {
+    return false;
+    }
+  const char* yAxisType = chartNode->GetProperty("default", "yAxisType");
+  if (yAxisType && !strcmp(yAxisType, "categorical"))
+    {
+    return false;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+int qMRMLChartPlotView::numberOfDrawnPoints(int index)const
+{
+  Q_D(const qMRMLChartPlotView);
+  if (index < 0 || index >= d->SeriesList.count())
+    {
+    return -1;
+    }
+  return d->SeriesList[index].Points.count();
+}
+
+//------------------------------------------------------------------------------
+void qMRMLChartPlotView::updateFromMRML()
+{
+  Q_D(qMRMLChartPlotView);
+
+  // keep the cached series of the arrays still in the chart
+  QHash<QString, qMRMLChartPlotViewPrivate::Series> previousSeries;
+  foreach(const qMRMLChartPlotViewPrivate::Series& series, d->SeriesList)
+    {
+    d->qvtkDisconnect(series.ArrayNode, vtkCommand::ModifiedEvent,
+                      d, SLOT(onArrayNodeModified(vtkObject*)));
+    previousSeries[series.ArrayID] = series;
+    }
+  d->SeriesList.clear();
+
+  vtkMRMLChartNode* cn = d->MRMLChartNode;
+  if (!cn || !d->MRMLScene)
+    {
+    this->update();
+    return;
+    }
+
+  const char* title = cn->GetProperty("default", "title");
+  d->Title = isPropertyOff(cn, "default", "showTitle") || !title ? QString() : QString(title);
+  const char* xAxisLabel = cn->GetProperty("default", "xAxisLabel");
+  d->XAxisLabel = isPropertyOff(cn, "default", "showXAxisLabel") || !xAxisLabel ? QString() : QString(xAxisLabel);
+  const char* yAxisLabel = cn->GetProperty("default", "yAxisLabel");
+  d->YAxisLabel = isPropertyOff(cn, "default", "showYAxisLabel") || !yAxisLabel ? QString() : QString(yAxisLabel);
+  d->ShowGrid = isPropertyOn(cn, "default", "showGrid");
+  d->ShowLegend = isPropertyOn(cn, "default", "showLegend");
+  d->XAxisPad = padProperty(cn, "xAxisPad");
+  d->YAxisPad = padProperty(cn, "yAxisPad");
+
+  // same defaults as the jqPlot charts of qMRMLChartView
+  const char* type = cn->GetProperty("default", "type");
+  bool scatter = type && !strcmp(type, "Scatter");
+  bool defaultLines = !scatter && !isPropertyOff(cn, "default", "showLines");
+  bool defaultMarkers = scatter || isPropertyOn(cn, "default", "showMarkers");
+  Qt::PenStyle defaultPenStyle = penStyle(cn->GetProperty("default", "linePattern"), Qt::SolidLine);
+
+  const char* defaultChartColorNodeID =
+    d->ColorLogic ? d->ColorLogic->GetDefaultChartColorNodeID() : 0;
+  vtkMRMLColorNode* colorNode = vtkMRMLColorNode::SafeDownCast(
+    d->MRMLScene->GetNodeByID(defaultChartColorNodeID));
+  const char* lookupTable = cn->GetProperty("default", "lookupTable");
+  if (lookupTable)
+    {
+    colorNode = vtkMRMLColorNode::SafeDownCast(d->MRMLScene->GetNodeByID(lookupTable));
+    }
+
+  vtkStringArray* arrayIDs = cn->GetArrays();
+  vtkStringArray* arrayNames = cn->GetArrayNames();
+  for (int idx = 0; idx < arrayIDs->GetNumberOfValues(); ++idx)
+    {
+    QString arrayID = QString::fromStdString(arrayIDs->GetValue(idx));
+    vtkMRMLDoubleArrayNode* arrayNode = vtkMRMLDoubleArrayNode::SafeDownCast(
+      d->MRMLScene->GetNodeByID(arrayIDs->GetValue(idx).c_str()));
+    if (!arrayNode)
+      {
+      continue;
+      }
+    qMRMLChartPlotViewPrivate::Series series = previousSeries.value(arrayID);
+    if (series.ArrayNode.GetPointer() != arrayNode)
+      {
+      series = qMRMLChartPlotViewPrivate::Series();
+      }
+    series.ArrayNode = arrayNode;
+    series.ArrayID = arrayID;
+    std::string name = idx < arrayNames->GetNumberOfValues() ? arrayNames->GetValue(idx) : std::string();
+    series.Name = QString::fromStdString(name);
+    series.ShowLines = isPropertyOn(cn, name.c_str(), "showLines") ||
+      (defaultLines && !isPropertyOff(cn, name.c_str(), "showLines"));
+    bool showMarkers = isPropertyOn(cn, name.c_str(), "showMarkers") ||
+      (defaultMarkers && !isPropertyOff(cn, name.c_str(), "showMarkers"));
+    if (showMarkers != series.ShowMarkers)
+      {
+      // line only series are decimated, the others are not
+      series.DecimatedWidth = 0;
+      }
+    series.ShowMarkers = showMarkers;
+    series.PenStyle = penStyle(cn->GetProperty(name.c_str(), "linePattern"), defaultPenStyle);
+    const char* color = cn->GetProperty(name.c_str(), "color");
+    if (color)
+      {
+      series.Color = QColor(color);
+      }
+    else if (colorNode && colorNode->GetNumberOfColors() > 0)
+      {
+      double c[4];
+      colorNode->GetColor(idx % colorNode->GetNumberOfColors(), c);
+      series.Color.setRgbF(c[0], c[1], c[2]);
+      }
+    else
+      {
+      series.Color = Qt::black;
+      }
+    d->qvtkConnect(arrayNode, vtkCommand::ModifiedEvent,
+                   d, SLOT(onArrayNodeModified(vtkObject*)));
+    d->SeriesList.push_back(series);
+    }
+  this->update();
+}
+
+//------------------------------------------------------------------------------
+void qMRMLChartPlotView::paintEvent(QPaintEvent* event)
+{
+  Q_D(qMRMLChartPlotView);
+  Q_UNUSED(event);
+
+  QPainter painter(this);
+  painter.fillRect(this->rect(), Qt::white);
+  if (!d->MRMLChartNode)
+    {
+    return;
+    }
+
+  for (int s = 0; s < d->SeriesList.count(); ++s)
+    {
+    d->updateSeriesBounds(d->SeriesList[s]);
+    }
+  const QRectF range = d->dataRange();
+  const QRectF plot = d->plotRect();
+  const int fontHeight = this->fontMetrics().height();
+
+  // grid and ticks
+  QVector<double> xTicks = d->ticks(range.left(), range.right(),
+                                    std::max(2, static_cast<int>(plot.width() / (5 * fontHeight))));
+  QVector<double> yTicks = d->ticks(range.top(), range.bottom(),
+                                    std::max(2, static_cast<int>(plot.height() / (2 * fontHeight))));
+  painter.setPen(QPen(QColor(220, 220, 220), 0));
+  if (d->ShowGrid)
+    {
+    foreach(double x, xTicks)
+      {
+      double px = d->toWidget(QPointF(x, range.top()), range, plot).x();
+      painter.drawLine(QPointF(px, plot.top()), QPointF(px, plot.bottom()));
+      }
+    foreach(double y, yTicks)
+      {
+      double py = d->toWidget(QPointF(range.left(), y), range, plot).y();
+      painter.drawLine(QPointF(plot.left(), py), QPointF(plot.right(), py));
+      }
+    }
+  painter.setPen(QPen(Qt::black, 0));
+  painter.drawRect(plot);
+  foreach(double x, xTicks)
+    {
+    double px = d->toWidget(QPointF(x, range.top()), range, plot).x();
+    painter.drawLine(QPointF(px, plot.bottom()), QPointF(px, plot.bottom() + 4));
+    painter.drawText(QRectF(px - 3 * fontHeight, plot.bottom() + 4, 6 * fontHeight, fontHeight),
+                     Qt::AlignHCenter | Qt::AlignTop, QString::number(x, 'g', 4));
+    }
+  foreach(double y, yTicks)
+    {
+    double py = d->toWidget(QPointF(range.left(), y), range, plot).y();
+    painter.drawLine(QPointF(plot.left() - 4, py), QPointF(plot.left(), py));
+    painter.drawText(QRectF(plot.left() - 3 * fontHeight - 6, py - fontHeight / 2., 3 * fontHeight, fontHeight),
+                     Qt::AlignRight | Qt::AlignVCenter, QString::number(y, 'g', 4));
+    }
+
+  // title and axis labels
+  if (!d->Title.isEmpty())
+    {
+    QFont titleFont = painter.font();
+    titleFont.setBold(true);
+    painter.save();
+    painter.setFont(titleFont);
+    painter.drawText(QRectF(plot.left(), 2, plot.width(), plot.top() - 4),
+                     Qt::AlignCenter, d->Title);
+    painter.restore();
+    }
+  if (!d->XAxisLabel.isEmpty())
+    {
+    painter.drawText(QRectF(plot.left(), plot.bottom() + fontHeight + 6, plot.width(), fontHeight + 4),
+                     Qt::AlignCenter, d->XAxisLabel);
+    }
+  if (!d->YAxisLabel.isEmpty())
+    {
+    painter.save();
+    painter.translate(2, plot.center().y());
+    painter.rotate(-90);
+    painter.drawText(QRectF(-plot.height() / 2., 0, plot.height(), fontHeight + 4),
+                     Qt::AlignCenter, d->YAxisLabel);
+    painter.restore();
+    }
+
+  // series
+  painter.save();
+  painter.setClipRect(plot.adjusted(-4, -4, 4, 4));
+  painter.setRenderHint(QPainter::Antialiasing, true);
+  const int width = std::max(1, static_cast<int>(plot.width()));
+  for (int s = 0; s < d->SeriesList.count(); ++s)
+    {
+    qMRMLChartPlotViewPrivate::Series& series = d->SeriesList[s];
+    d->updateSeriesPoints(series, range.left(), range.right(), width);
+    QPolygonF polyline(series.Points.count());
+    for (int i = 0; i < series.Points.count(); ++i)
+      {
+      polyline[i] = d->toWidget(series.Points[i], range, plot);
+      }
+    if (series.ShowLines)
+      {
+      painter.setPen(QPen(series.Color, 2., series.PenStyle));
+      painter.drawPolyline(polyline);
+      }
+    if (series.ShowMarkers)
+      {
+      painter.setPen(QPen(series.Color, 1.));
+      painter.setBrush(series.Color);
+      foreach(const QPointF& point, polyline)
+        {
+        painter.drawEllipse(point, 3., 3.);
+        }
+      painter.setBrush(Qt::NoBrush);
+      }
+    }
+  painter.restore();
+
+  // legend
+  if (d->ShowLegend && !d->SeriesList.isEmpty())
+    {
+    int legendWidth = 0;
+    foreach(const qMRMLChartPlotViewPrivate::Series& series, d->SeriesList)
+      {
+      legendWidth = std::max(legendWidth, this->fontMetrics().width(series.Name));
+      }
+    QRectF legend(plot.right() - legendWidth - 2.5 * fontHeight - 8, plot.top() + 8,
+                  legendWidth + 2.5 * fontHeight, d->SeriesList.count() * fontHeight + 8);
+    painter.setPen(QPen(Qt::gray, 0));
+    painter.setBrush(QColor(255, 255, 255, 220));
+    painter.drawRect(legend);
+    painter.setBrush(Qt::NoBrush);
+    for (int s = 0; s < d->SeriesList.count(); ++s)
+      {
+      const qMRMLChartPlotViewPrivate::Series& series = d->SeriesList[s];
+      double y = legend.top() + 4 + (s + 0.5) * fontHeight;
+      painter.setPen(QPen(series.Color, 2., series.PenStyle));
+      painter.drawLine(QPointF(legend.left() + 4, y), QPointF(legend.left() + 4 + 1.5 * fontHeight, y));
+      painter.setPen(QPen(Qt::black, 0));
+      painter.drawText(QRectF(legend.left() + 2 * fontHeight, y - fontHeight / 2., legendWidth + 4, fontHeight),
+                       Qt::AlignLeft | Qt::AlignVCenter, series.Name);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLChartPlotView::mouseMoveEvent(QMouseEvent* event)
+{
+  Q_D(qMRMLChartPlotView);
+  int seriesIndex = -1;
+  int pointIndex = -1;
+  if (d->pickPoint(event->pos(), seriesIndex, pointIndex))
+    {
+    const qMRMLChartPlotViewPrivate::Series& series = d->SeriesList[seriesIndex];
+    const QPointF& point = series.Points[pointIndex];
+    emit dataMouseOver(series.ArrayID.toLatin1().constData(),
+                       series.PointIndices[pointIndex], point.x(), point.y());
+    this->setToolTip(QString("%1: %2, %3").arg(series.Name)
+                     .arg(point.x(), 0, 'g', 3).arg(point.y(), 0, 'g', 3));
+    }
+  else
+    {
+    this->setToolTip(QString());
+    }
+  this->Superclass::mouseMoveEvent(event);
+}
+
+//------------------------------------------------------------------------------
+void qMRMLChartPlotView::mousePressEvent(QMouseEvent* event)
+{
+  Q_D(qMRMLChartPlotView);
+  int seriesIndex = -1;
+  int pointIndex = -1;
+  if (d->pickPoint(event->pos(), seriesIndex, pointIndex))
+    {
+    const qMRMLChartPlotViewPrivate::Series& series = d->SeriesList[seriesIndex];
+    const QPointF& point = series.Points[pointIndex];
+    emit dataPointClicked(series.ArrayID.toLatin1().constData(),
+                          series.PointIndices[pointIndex], point.x(), point.y());
+    }
+  this->Superclass::mousePressEvent(event);
+}
+
+//---------------------------------------------------------------------------
+QSize qMRMLChartPlotView::sizeHint()const
+{
+  // return a default size hint (invalid size)
+  return QSize();
+}
@@ -0,0 +1,108 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __qMRMLChartPlotView_h
+#define __qMRMLChartPlotView_h
+
+// Qt includes
+#include <QWidget>
+
+#include "qMRMLWidgetsExport.h"
+
+class qMRMLChartPlotViewPrivate;
+
+// MRML includes
+class vtkMRMLChartNode;
+class vtkMRMLColorLogic;
+class vtkMRMLScene;
+
+/// \brief qMRMLChartPlotView draws the line and scatter charts of a
+/// vtkMRMLChartNode natively with QPainter.
+///
+/// The arrays are read directly from the vtkMRMLDoubleArrayNodes. The
+/// series drawn with lines only are decimated to the pixel width of the
+/// plot: for each pixel column, the first, minimum, maximum and last points
+/// are kept so that the drawn curve is the same as the full resolution one.
+/// All the points of the series drawn with markers are kept. Each series is cached and only
+/// recomputed when its array node is modified or the plot is resized.
+/// \sa qMRMLChartView
+class QMRML_WIDGETS_EXPORT qMRMLChartPlotView : public QWidget
+{
+  Q_OBJECT
+public:
+  /// Superclass typedef
+  typedef QWidget Superclass;
+
+  /// Constructors
+  explicit qMRMLChartPlotView(QWidget* parent = 0);
+  virtual ~qMRMLChartPlotView();
+
+  /// Return a pointer on the current MRML scene
+  vtkMRMLScene* mrmlScene() const;
+
+  /// Get the chart node drawn by the view.
+  vtkMRMLChartNode* mrmlChartNode()const;
+
+  /// Set the application color logic for the default series colors.
+  void setColorLogic(vtkMRMLColorLogic* colorLogic);
+  vtkMRMLColorLogic* colorLogic()const;
+
+  /// Return true if the chart node can be drawn by the view:
+  /// line and scatter charts with a quantitative x axis.
+  static bool canDrawChart(vtkMRMLChartNode* chartNode);
+
+  /// Number of points drawn for the series \a index after decimation.
+  /// Return -1 if there is no such series.
+  int numberOfDrawnPoints(int index)const;
+
+  /// Redefine the sizeHint so layouts work properly.
+  virtual QSize sizeHint() const;
+
+public slots:
+
+  /// Set the MRML \a scene the array nodes are looked up in
+  void setMRMLScene(vtkMRMLScene* newScene);
+
+  /// Set the chart node to draw
+  void setMRMLChartNode(vtkMRMLChartNode* newChartNode);
+
+  /// Read the chart properties and array list from the chart node again
+  void updateFromMRML();
+
+signals:
+
+  /// Signal emitted when mouse moves over a data point. Returns the
+  /// id of the MRMLDoubleArrayNode, the index of the point, and the values
+  void dataMouseOver(const char *mrmlArrayID, int pointidx, double x, double y);
+
+  /// Signal emitted when a data point has been clicked. Returns the
+  /// id of the MRMLDoubleArrayNode, the index of the point, and the values
+  void dataPointClicked(const char *mrmlArrayID, int pointidx, double x, double y);
+
+protected:
+  virtual void paintEvent(QPaintEvent* event);
+  virtual void mouseMoveEvent(QMouseEvent* event);
+  virtual void mousePressEvent(QMouseEvent* event);
+
+  QScopedPointer<qMRMLChartPlotViewPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(qMRMLChartPlotView);
+  Q_DISABLE_COPY(qMRMLChartPlotView);
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __qMRMLChartPlotView_p_h
+#define __qMRMLChartPlotView_p_h
+
+// Qt includes
+#include <QColor>
+#include <QList>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+
+// CTK includes
+#include <ctkPimpl.h>
+#include <ctkVTKObject.h>
+
+// qMRML includes
+#include "qMRMLChartPlotView.h"
+
+// VTK includes
+#include <vtkWeakPointer.h>
+
+class vtkMRMLChartNode;
+class vtkMRMLColorLogic;
+class vtkMRMLDoubleArrayNode;
+class vtkObject;
+
+//-----------------------------------------------------------------------------
+class qMRMLChartPlotViewPrivate: public QObject
+{
+  Q_OBJECT
+  QVTK_OBJECT
+  Q_DECLARE_PUBLIC(qMRMLChartPlotView);
+protected:
+  qMRMLChartPlotView* const q_ptr;
+public:
+  qMRMLChartPlotViewPrivate(qMRMLChartPlotView& object);
+  ~qMRMLChartPlotViewPrivate();
+
+  virtual void init();
+
+  /// One curve of the chart
+  struct Series
+    {
+    Series();
+
+    vtkWeakPointer<vtkMRMLDoubleArrayNode> ArrayNode;
+    QString ArrayID;
+    QString Name;
+    QColor Color;
+    Qt::PenStyle PenStyle;
+    bool ShowLines;
+    bool ShowMarkers;
+
+    /// Array modified time the bounds and decimation were computed for
+    unsigned long ArrayMTime;
+    /// Bounds of the data (xmin, xmax, ymin, ymax), invalid if empty
+    QRectF Bounds;
+    /// True if the x values never decrease, decimation needs it
+    bool Monotonic;
+
+    /// Decimated points in data coordinates and their index in the array
+    QVector<QPointF> Points;
+    QVector<int> PointIndices;
+    /// Plot x range and width in pixels the points are decimated for
+    double DecimatedXMin;
+    double DecimatedXMax;
+    int DecimatedWidth;
+    };
+
+  /// Recompute the bounds of a series if its array changed.
+  void updateSeriesBounds(Series& series);
+
+  /// Decimate a series for the x range and the pixel width if needed.
+  void updateSeriesPoints(Series& series, double xMin, double xMax, int width);
+
+  /// Data range of all the series, with the axis pads applied
+  QRectF dataRange()const;
+
+  /// Rectangle of the plot area in widget coordinates
+  QRectF plotRect()const;
+
+  /// Convert between data and widget coordinates
+  QPointF toWidget(const QPointF& point, const QRectF& range, const QRectF& plot)const;
+
+  /// Find the drawn point the closest to \a position (in widget
+  /// coordinates) within a few pixels. Return false if there is none.
+  bool pickPoint(const QPointF& position, int& seriesIndex, int& pointIndex)const;
+
+  /// Nice tick values covering [min, max]
+  static QVector<double> ticks(double min, double max, int maximumNumberOfTicks);
+
+public slots:
+  /// Called when an array node is modified, only its series is updated
+  void onArrayNodeModified(vtkObject* caller);
+
+public:
+  vtkMRMLScene*                      MRMLScene;
+  vtkMRMLChartNode*                  MRMLChartNode;
+  vtkWeakPointer<vtkMRMLColorLogic>  ColorLogic;
+
+  QList<Series>                      SeriesList;
+
+  QString                            Title;
+  QString                            XAxisLabel;
+  QString                            YAxisLabel;
+  bool                               ShowGrid;
+  bool                               ShowLegend;
+  /// Padding factor of the axes, 0 for no padding
+  double                             XAxisPad;
+  double                             YAxisPad;
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include <QEvent>
 #include <QFileInfo>
 #include <QHBoxLayout>
+#include <QResizeEvent>
 #include <QToolButton>
 
 #include <QWebChannel>
@@ -36,6 +37,7 @@
 #include <ctkPopupWidget.h>
 
 // qMRML includes
+#include "qMRMLChartPlotView.h"
 #include "qMRMLColors.h"
 #include "qMRMLChartView_p.h"
 
@@ -94,6 +96,7 @@ qMRMLChartViewPrivate::qMRMLChartViewPrivate(qMRMLChartView& object)
   this->ColorLogic = 0;
   this->PinButton = 0;
   this->PopupWidget = 0;
+  this->NativePlot = 0;
 }
 
 //---------------------------------------------------------------------------
@@ -129,6 +132,15 @@ void qMRMLChartViewPrivate::init()
   popupLayout->addWidget(new QToolButton);
   this->PopupWidget->setLayout(popupLayout);
 
+  // Line and scatter charts are drawn natively over the web view, large
+  // arrays are too slow to convert to javascript and to draw with jqPlot
+  this->NativePlot = new qMRMLChartPlotView(q);
+  this->NativePlot->hide();
+  QObject::connect(this->NativePlot, SIGNAL(dataMouseOver(const char*,int,double,double)),
+                   q, SIGNAL(dataMouseOver(const char*,int,double,double)));
+  QObject::connect(this->NativePlot, SIGNAL(dataPointClicked(const char*,int,double,double)),
+                   q, SIGNAL(dataPointClicked(const char*,int,double,double)));
+
   q->setHtml("");
   //q->show();
 }
@@ -151,6 +163,7 @@ void qMRMLChartViewPrivate::setMRMLScene(vtkMRMLScene* newScene)
     vtkMRMLScene::EndBatchProcessEvent, this, SLOT(endProcessing()));
 
   this->MRMLScene = newScene;
+  this->NativePlot->setMRMLScene(newScene);
 }
 
 
@@ -216,6 +229,8 @@ void qMRMLChartViewPrivate::updateWidgetFromMRML()
 
   if (!chartnodeid)
     {
+    this->NativePlot->hide();
+    this->NativePlot->setMRMLChartNode(0);
     q->setHtml("");
     //q->show();
     return;
@@ -225,11 +240,30 @@ void qMRMLChartViewPrivate::updateWidgetFromMRML()
 
   if (!cn)
     {
+    this->NativePlot->hide();
+    this->NativePlot->setMRMLChartNode(0);
     q->setHtml("");
     //q->show();
     return;
     }
 
+  if (qMRMLChartPlotView::canDrawChart(cn))
+    {
+    // the native plot observes the chart and array nodes itself
+    if (this->NativePlot->isHidden())
+      {
+      q->setHtml("");
+      }
+    this->NativePlot->setColorLogic(this->ColorLogic);
+    this->NativePlot->setMRMLChartNode(cn);
+    this->NativePlot->setGeometry(q->rect());
+    this->NativePlot->show();
+    this->NativePlot->raise();
+    return;
+    }
+  this->NativePlot->hide();
+  this->NativePlot->setMRMLChartNode(0);
+
 
   // Generate javascript for the data, ticks, options
   //
@@ -1771,6 +1805,7 @@ void qMRMLChartView::setColorLogic(vtkMRMLColorLogic* colorLogic)
 {
   Q_D(qMRMLChartView);
   d->ColorLogic = colorLogic;
+  d->NativePlot->setColorLogic(colorLogic);
 }
 
 //---------------------------------------------------------------------------
@@ -1780,6 +1815,14 @@ vtkMRMLColorLogic* qMRMLChartView::colorLogic()const
   return d->ColorLogic;
 }
 
+//---------------------------------------------------------------------------
+void qMRMLChartView::resizeEvent(QResizeEvent* event)
+{
+  Q_D(qMRMLChartView);
+  this->Superclass::resizeEvent(event);
+  d->NativePlot->setGeometry(QRect(QPoint(0, 0), event->size()));
+}
+
 //---------------------------------------------------------------------------
 QSize qMRMLChartView::sizeHint()const
 {
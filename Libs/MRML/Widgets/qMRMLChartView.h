@@ -88,6 +88,9 @@ signals:
   void mrmlSceneChanged(vtkMRMLScene*);
 
 protected:
+  /// Keep the native plot the size of the view
+  virtual void resizeEvent(QResizeEvent* event);
+
   QScopedPointer<qMRMLChartViewPrivate> d_ptr;
 
 private:
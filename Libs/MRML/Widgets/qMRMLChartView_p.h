@@ -14,6 +14,7 @@
 
 // Qt includes
 class QToolButton;
+class qMRMLChartPlotView;
 
 // VTK includes
 #include <vtkWeakPointer.h>
@@ -183,6 +184,9 @@ protected:
 
   QToolButton*                       PinButton;
   ctkPopupWidget*                    PopupWidget;
+
+  /// Native plot drawn over the web view for line and scatter charts
+  qMRMLChartPlotView*                NativePlot;
 };
 
 #endif
@@ -0,0 +1,372 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkLabelmapMarginFilter.h"
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <cmath>
+#include <vector>
+
+namespace
+{
+/// Squared distance of the voxels that have no voxel of interest on their lines so far
+const float FAR_DISTANCE = 1e20f;
+
+/// The voxels at exactly the margin distance are within the margin
+const double MARGIN_TOLERANCE = 1e-6;
+
+//----------------------------------------------------------------------------
+/// Lines of one axis of the distance map, split between the threads
+struct DistanceLineJob
+{
+  float* DistanceMap;
+  int Dimensions[3];
+  int Axis;
+  double Weight;
+};
+
+//----------------------------------------------------------------------------
+/// Lower envelope of the parabolas weight*(q-p)^2 + f(p) of the finite samples of a line
+void ComputeDistanceAlongLine(float* line, vtkIdType stride, int numberOfSamples, double weight,
+  double* f, int* parabolaSamples, double* parabolaBounds)
+{
+  int firstSample = -1;
+  for (int q = 0; q < numberOfSamples; ++q)
+  {
+    f[q] = line[q * stride];
+    if (firstSample < 0 && f[q] < FAR_DISTANCE)
+    {
+      firstSample = q;
+    }
+  }
+  if (firstSample < 0)
+  {
+    // Nothing on this line, the distances along the other axes are unchanged
+    return;
+  }
+
+  int k = 0;
+  parabolaSamples[0] = firstSample;
+  parabolaBounds[0] = -VTK_DOUBLE_MAX;
+  parabolaBounds[1] = VTK_DOUBLE_MAX;
+  for (int q = firstSample + 1; q < numberOfSamples; ++q)
+  {
+    if (f[q] >= FAR_DISTANCE)
+    {
+      continue;
+    }
+    double s = 0.0;
+    while (true)
+    {
+      int p = parabolaSamples[k];
+      s = ((f[q] + weight * q * q) - (f[p] + weight * p * p)) / (2.0 * weight * (q - p));
+      if (s > parabolaBounds[k])
+      {
+        break;
+      }
+      --k;
+    }
+    ++k;
+    parabolaSamples[k] = q;
+    parabolaBounds[k] = s;
+    parabolaBounds[k + 1] = VTK_DOUBLE_MAX;
+  }
+
+  k = 0;
+  for (int q = 0; q < numberOfSamples; ++q)
+  {
+    while (parabolaBounds[k + 1] < q)
+    {
+      ++k;
+    }
+    int p = parabolaSamples[k];
+    double distance = weight * (q - p) * (q - p) + f[p];
+    line[q * stride] = (distance < FAR_DISTANCE ? static_cast<float>(distance) : FAR_DISTANCE);
+  }
+}
+
+//----------------------------------------------------------------------------
+void ComputeDistanceAlongLines(const DistanceLineJob& job, vtkIdType firstLine, vtkIdType lastLine)
+{
+  const int* dimensions = job.Dimensions;
+  int numberOfSamples = dimensions[job.Axis];
+  vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+  vtkIdType stride = (job.Axis == 0 ? 1 : (job.Axis == 1 ? dimensions[0] : sliceSize));
+
+  std::vector<double> f(numberOfSamples);
+  std::vector<int> parabolaSamples(numberOfSamples);
+  std::vector<double> parabolaBounds(numberOfSamples + 1);
+  for (vtkIdType lineIndex = firstLine; lineIndex < lastLine; ++lineIndex)
+  {
+    vtkIdType lineStart = 0;
+    if (job.Axis == 0)
+    {
+      lineStart = lineIndex * dimensions[0];
+    }
+    else if (job.Axis == 1)
+    {
+      lineStart = (lineIndex % dimensions[0]) + (lineIndex / dimensions[0]) * sliceSize;
+    }
+    else
+    {
+      lineStart = lineIndex;
+    }
+    ComputeDistanceAlongLine(job.DistanceMap + lineStart, stride, numberOfSamples, job.Weight,
+      &f[0], &parabolaSamples[0], &parabolaBounds[0]);
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType GetNumberOfLines(const DistanceLineJob& job)
+{
+  vtkIdType numberOfVoxels = static_cast<vtkIdType>(job.Dimensions[0]) * job.Dimensions[1] * job.Dimensions[2];
+  return numberOfVoxels / job.Dimensions[job.Axis];
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ComputeDistanceAlongLinesThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  const DistanceLineJob* job = static_cast<const DistanceLineJob*>(threadInfo->UserData);
+  vtkIdType numberOfLines = GetNumberOfLines(*job);
+  ComputeDistanceAlongLines(*job,
+    numberOfLines * threadInfo->ThreadID / threadInfo->NumberOfThreads,
+    numberOfLines * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Set 0 at the voxels the margin is measured from, the structure when expanding
+/// and the background (including the padding around the input) when shrinking
+template <class T>
+void InitializeDistanceMap(T* inputPtr, int inputExtent[6], int workExtent[6], bool shrink, float* distanceMap)
+{
+  int inputDimensions[3] = { inputExtent[1]-inputExtent[0]+1, inputExtent[3]-inputExtent[2]+1, inputExtent[5]-inputExtent[4]+1 };
+  float* distancePtr = distanceMap;
+  for (int k = workExtent[4]; k <= workExtent[5]; ++k)
+  {
+    for (int j = workExtent[2]; j <= workExtent[3]; ++j)
+    {
+      bool lineInInput = (k >= inputExtent[4] && k <= inputExtent[5] && j >= inputExtent[2] && j <= inputExtent[3]);
+      T* inputLinePtr = NULL;
+      if (lineInInput)
+      {
+        inputLinePtr = inputPtr + (j - inputExtent[2]) * static_cast<vtkIdType>(inputDimensions[0])
+          + (k - inputExtent[4]) * static_cast<vtkIdType>(inputDimensions[0]) * inputDimensions[1];
+      }
+      for (int i = workExtent[0]; i <= workExtent[1]; ++i)
+      {
+        bool foreground = (lineInInput && i >= inputExtent[0] && i <= inputExtent[1] && inputLinePtr[i - inputExtent[0]] != 0);
+        *(distancePtr++) = (foreground != shrink ? 0.0f : FAR_DISTANCE);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void WriteOutput(float* distanceMap, int workExtent[6], bool shrink, T labelValue, vtkImageData* output)
+{
+  int outputExtent[6] = {0,-1,0,-1,0,-1};
+  output->GetExtent(outputExtent);
+  vtkIdType workDimensions[3] = { workExtent[1]-workExtent[0]+1, workExtent[3]-workExtent[2]+1, workExtent[5]-workExtent[4]+1 };
+  T* outputPtr = static_cast<T*>(output->GetScalarPointer());
+  for (int k = outputExtent[4]; k <= outputExtent[5]; ++k)
+  {
+    for (int j = outputExtent[2]; j <= outputExtent[3]; ++j)
+    {
+      float* distancePtr = distanceMap + (outputExtent[0] - workExtent[0])
+        + workDimensions[0] * ((j - workExtent[2]) + workDimensions[1] * (k - workExtent[4]));
+      for (int i = outputExtent[0]; i <= outputExtent[1]; ++i)
+      {
+        bool withinMargin = (*(distancePtr++) <= 1.0 + MARGIN_TOLERANCE);
+        *(outputPtr++) = (withinMargin != shrink ? labelValue : 0);
+      }
+    }
+  }
+}
+}
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapMarginFilter);
+
+//----------------------------------------------------------------------------
+vtkLabelmapMarginFilter::vtkLabelmapMarginFilter()
+{
+  this->InputLabelmap = NULL;
+
+  this->OutputLabelmap = NULL;
+  vtkSmartPointer<vtkImageData> outputLabelmap = vtkSmartPointer<vtkImageData>::New();
+  this->SetOutputLabelmap(outputLabelmap);
+
+  this->MarginSize[0] = this->MarginSize[1] = this->MarginSize[2] = 0.0;
+  this->Operation = Expand;
+  this->LabelValue = 1.0;
+  this->NumberOfThreads = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapMarginFilter::~vtkLabelmapMarginFilter()
+{
+  this->SetInputLabelmap(NULL);
+  this->SetOutputLabelmap(NULL);
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapMarginFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "MarginSize: " << this->MarginSize[0] << " " << this->MarginSize[1] << " " << this->MarginSize[2] << "\n";
+  os << indent << "Operation: " << (this->Operation == Shrink ? "Shrink" : "Expand") << "\n";
+  os << indent << "LabelValue: " << this->LabelValue << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkLabelmapMarginFilter::GetOutput()
+{
+  return this->OutputLabelmap;
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapMarginFilter::Update()
+{
+  if (!this->InputLabelmap || !this->InputLabelmap->GetPointData()->GetScalars() || !this->OutputLabelmap)
+  {
+    vtkErrorMacro("Update: Input labelmap and output image data have to be initialized!");
+    return;
+  }
+  if (this->InputLabelmap->GetNumberOfScalarComponents() != 1)
+  {
+    vtkErrorMacro("Update: Input labelmap has to have one scalar component!");
+    return;
+  }
+
+  int inputExtent[6] = {0,-1,0,-1,0,-1};
+  this->InputLabelmap->GetExtent(inputExtent);
+  if (inputExtent[0] > inputExtent[1] || inputExtent[2] > inputExtent[3] || inputExtent[4] > inputExtent[5])
+  {
+    vtkErrorMacro("Update: Input labelmap is empty!");
+    return;
+  }
+  bool shrink = (this->Operation == Shrink);
+
+  // Squared distances are in units of the margin, the weight of an axis is (spacing/margin)^2.
+  // There is no margin along the axes with a zero margin size, their distance pass is skipped.
+  double spacing[3] = {1.0, 1.0, 1.0};
+  this->InputLabelmap->GetSpacing(spacing);
+  double weights[3] = {0.0, 0.0, 0.0};
+  int workExtent[6] = {0,-1,0,-1,0,-1};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    double marginSize = fabs(this->MarginSize[axis]);
+    double axisSpacing = fabs(spacing[axis]);
+    int padding = 0;
+    if (marginSize > 0.0 && axisSpacing > 0.0)
+    {
+      weights[axis] = (axisSpacing / marginSize) * (axisSpacing / marginSize);
+      // Expanding needs room for the margin, shrinking needs the background around the input
+      padding = (shrink ? 1 : static_cast<int>(floor(marginSize / axisSpacing + MARGIN_TOLERANCE)));
+    }
+    workExtent[2*axis] = inputExtent[2*axis] - padding;
+    workExtent[2*axis+1] = inputExtent[2*axis+1] + padding;
+  }
+  int workDimensions[3] = { workExtent[1]-workExtent[0]+1, workExtent[3]-workExtent[2]+1, workExtent[5]-workExtent[4]+1 };
+
+  std::vector<float> distanceMap(static_cast<size_t>(workDimensions[0]) * workDimensions[1] * workDimensions[2]);
+  switch (this->InputLabelmap->GetScalarType())
+  {
+    vtkTemplateMacro(InitializeDistanceMap(static_cast<VTK_TT*>(this->InputLabelmap->GetScalarPointer()),
+      inputExtent, workExtent, shrink, &distanceMap[0]));
+  default:
+    vtkErrorMacro("Update: Unsupported input labelmap scalar type!");
+    return;
+  }
+
+  vtkLabelmapMarginFilter::ComputeSquaredDistanceMap(&distanceMap[0], workDimensions, weights, this->NumberOfThreads);
+
+  // The shrunk structure is within the input extent
+  vtkSmartPointer<vtkImageData> outputLabelmap = vtkSmartPointer<vtkImageData>::New();
+  outputLabelmap->SetOrigin(this->InputLabelmap->GetOrigin());
+  outputLabelmap->SetSpacing(this->InputLabelmap->GetSpacing());
+  outputLabelmap->SetExtent(shrink ? inputExtent : workExtent);
+  outputLabelmap->AllocateScalars(this->InputLabelmap->GetScalarType(), 1);
+  switch (outputLabelmap->GetScalarType())
+  {
+    vtkTemplateMacro(WriteOutput(&distanceMap[0], workExtent, shrink,
+      static_cast<VTK_TT>(this->LabelValue), outputLabelmap.GetPointer()));
+  }
+
+  this->OutputLabelmap->ShallowCopy(outputLabelmap);
+}
+
+//----------------------------------------------------------------------------
+float vtkLabelmapMarginFilter::GetFarDistance()
+{
+  return FAR_DISTANCE;
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapMarginFilter::ComputeSquaredDistanceMap(float* distanceMap, int dimensions[3], double weights[3], int numberOfThreads)
+{
+  if (numberOfThreads <= 0)
+  {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    if (weights[axis] > 0.0)
+    {
+      vtkLabelmapMarginFilter::ComputeDistanceAlongAxis(distanceMap, dimensions, axis, weights[axis], numberOfThreads);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapMarginFilter::ComputeDistanceAlongAxis(float* distanceMap, int dimensions[3], int axis, double weight, int numberOfThreads)
+{
+  DistanceLineJob job;
+  job.DistanceMap = distanceMap;
+  job.Dimensions[0] = dimensions[0];
+  job.Dimensions[1] = dimensions[1];
+  job.Dimensions[2] = dimensions[2];
+  job.Axis = axis;
+  job.Weight = weight;
+
+  vtkIdType numberOfLines = GetNumberOfLines(job);
+  if (numberOfThreads > numberOfLines)
+  {
+    numberOfThreads = static_cast<int>(numberOfLines);
+  }
+  if (numberOfThreads <= 1)
+  {
+    ComputeDistanceAlongLines(job, 0, numberOfLines);
+    return;
+  }
+
+  // The lines are independent, each thread writes its own lines
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ComputeDistanceAlongLinesThread, &job);
+  threader->SingleMethodExecute();
+}
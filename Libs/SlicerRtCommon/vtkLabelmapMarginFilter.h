@@ -0,0 +1,112 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkLabelmapMarginFilter - Expands or shrinks a binary labelmap by a margin in mm
+// .SECTION Description
+
+#ifndef __vtkLabelmapMarginFilter_h
+#define __vtkLabelmapMarginFilter_h
+
+// VTK includes
+#include <vtkImageData.h>
+
+#include "vtkSlicerRtCommonWin32Header.h"
+
+/// \ingroup SlicerRt_SlicerRtCommon
+/// \brief Expand or shrink a binary labelmap by an ellipsoidal margin.
+///
+/// A voxel is within the margin of the structure if the distance to the closest voxel of the
+/// structure is at most 1 in the metric where the margin size of each axis is the unit length.
+/// With equal margin sizes this is a spherical margin. The distances are computed by an exact
+/// Euclidean distance transform that processes the axes one after the other (Felzenszwalb and
+/// Huttenlocher), with the lines of each axis split between the threads. The run time is linear
+/// in the number of voxels and does not depend on the margin size.
+/// Shrinking expands the background, the voxels outside the input extent are background.
+class VTK_SLICERRTCOMMON_EXPORT vtkLabelmapMarginFilter : public vtkObject
+{
+public:
+  enum MarginOperation
+  {
+    Expand = 0,
+    Shrink
+  };
+
+public:
+  static vtkLabelmapMarginFilter *New();
+  vtkTypeMacro(vtkLabelmapMarginFilter, vtkObject );
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Output labelmap. It has the scalar type of the input. When expanding, its extent
+  /// is the input extent padded by the margin so that the expanded structure is not cropped.
+  virtual vtkImageData* GetOutput();
+
+  virtual void Update();
+
+  /// Binary labelmap, all the non-zero voxels belong to the structure
+  vtkSetObjectMacro(InputLabelmap, vtkImageData);
+
+  /// Margin size along each axis in mm (physical units of the spacing). 0 means no margin along the axis.
+  vtkGetVector3Macro(MarginSize, double);
+  vtkSetVector3Macro(MarginSize, double);
+
+  vtkGetMacro(Operation, int);
+  vtkSetMacro(Operation, int);
+  void SetOperationToExpand() { this->SetOperation(Expand); };
+  void SetOperationToShrink() { this->SetOperation(Shrink); };
+
+  /// Value of the structure voxels in the output. 1 by default.
+  vtkGetMacro(LabelValue, double);
+  vtkSetMacro(LabelValue, double);
+
+  /// Number of threads. 0 (default) uses the default number of threads of vtkMultiThreader.
+  vtkGetMacro(NumberOfThreads, int);
+  vtkSetMacro(NumberOfThreads, int);
+
+  /// Exact squared Euclidean distance transform of a voxel array (X fastest), in place.
+  /// On input the voxels the distances are measured from are 0 and the others are GetFarDistance(),
+  /// on output each voxel contains the squared distance to the closest of those voxels.
+  /// \param weights Squared length of a voxel step along each axis, the axes with a zero weight are skipped
+  /// \param numberOfThreads Number of threads, 0 uses the default number of threads
+  static void ComputeSquaredDistanceMap(float* distanceMap, int dimensions[3], double weights[3], int numberOfThreads);
+
+  /// Squared distance of the voxels that are not reached by the distance transform
+  static float GetFarDistance();
+
+protected:
+  vtkSetObjectMacro(OutputLabelmap, vtkImageData);
+
+  /// Compute the squared distances in place along one axis, where distanceMap contains
+  /// the squared distances along the previous axes. The lines are split between the threads.
+  static void ComputeDistanceAlongAxis(float* distanceMap, int dimensions[3], int axis, double weight, int numberOfThreads);
+
+protected:
+  vtkImageData* InputLabelmap;
+  vtkImageData* OutputLabelmap;
+  double MarginSize[3];
+  int Operation;
+  double LabelValue;
+  int NumberOfThreads;
+
+protected:
+  vtkLabelmapMarginFilter();
+  virtual ~vtkLabelmapMarginFilter();
+
+private:
+  vtkLabelmapMarginFilter(const vtkLabelmapMarginFilter&); // Not implemented
+  void operator=(const vtkLabelmapMarginFilter&);               // Not implemented
+};
+
+#endif
@@ -20,6 +20,9 @@
 
 #include "vtkLabelmapToModelFilter.h"
 
+// SegmentationCore includes
+#include "vtkParallelLabelmapToSurfaceFilter.h"
+
 // VTK includes
 #include <vtkVersion.h>
 #include <vtkObjectFactory.h>
@@ -45,6 +48,7 @@ vtkLabelmapToModelFilter::vtkLabelmapToModelFilter()
 
   this->SetDecimateTargetReduction(0.0);
   this->SetLabelValue(1.0);
+  this->UseParallelSurfaceExtraction = true;
 }
 
 //----------------------------------------------------------------------------
@@ -58,6 +62,7 @@ vtkLabelmapToModelFilter::~vtkLabelmapToModelFilter()
 void vtkLabelmapToModelFilter::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "UseParallelSurfaceExtraction: " << (this->UseParallelSurfaceExtraction ? "true" : "false") << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -75,32 +80,50 @@ void vtkLabelmapToModelFilter::Update()
     return;
   }
 
-  // Run marching cubes
-  vtkSmartPointer<vtkMarchingCubes> marchingCubes = vtkSmartPointer<vtkMarchingCubes>::New();
-  marchingCubes->SetInputData(this->InputLabelmap);
-  marchingCubes->SetNumberOfContours(1);
-  marchingCubes->SetValue(0, this->LabelValue/2.0);
-  marchingCubes->ComputeScalarsOff();
-  marchingCubes->ComputeGradientsOff();
-  marchingCubes->ComputeNormalsOff();
-  try
-  {
-    marchingCubes->Update();
-  }
-  catch(...)
+  vtkSmartPointer<vtkPolyData> surface;
+  if (this->UseParallelSurfaceExtraction)
   {
-    vtkErrorMacro("Error while running marching cubes!");
-    return;
+    // Marching cubes runs on slabs of the labelmap in parallel, without decimation
+    vtkSmartPointer<vtkParallelLabelmapToSurfaceFilter> surfaceFilter = vtkSmartPointer<vtkParallelLabelmapToSurfaceFilter>::New();
+    surfaceFilter->SetInputLabelmap(this->InputLabelmap);
+    surfaceFilter->SetIsoValue(this->LabelValue/2.0);
+    if (!surfaceFilter->Update())
+    {
+      vtkErrorMacro("Update: No polygons can be created!");
+      return;
+    }
+    surface = surfaceFilter->GetOutput();
   }
-  if (marchingCubes->GetOutput()->GetNumberOfPolys() == 0)
+  else
   {
-    vtkErrorMacro("No polygons can be created!");
-    return;
+    // Run marching cubes
+    vtkSmartPointer<vtkMarchingCubes> marchingCubes = vtkSmartPointer<vtkMarchingCubes>::New();
+    marchingCubes->SetInputData(this->InputLabelmap);
+    marchingCubes->SetNumberOfContours(1);
+    marchingCubes->SetValue(0, this->LabelValue/2.0);
+    marchingCubes->ComputeScalarsOff();
+    marchingCubes->ComputeGradientsOff();
+    marchingCubes->ComputeNormalsOff();
+    try
+    {
+      marchingCubes->Update();
+    }
+    catch(...)
+    {
+      vtkErrorMacro("Error while running marching cubes!");
+      return;
+    }
+    if (marchingCubes->GetOutput()->GetNumberOfPolys() == 0)
+    {
+      vtkErrorMacro("No polygons can be created!");
+      return;
+    }
+    surface = marchingCubes->GetOutput();
   }
 
   // Decimate
   vtkSmartPointer<vtkDecimatePro> decimator = vtkSmartPointer<vtkDecimatePro>::New();
-  decimator->SetInputData(marchingCubes->GetOutput() );
+  decimator->SetInputData(surface);
   decimator->SetFeatureAngle(60);
   decimator->SplittingOff();
   decimator->PreserveTopologyOn();
@@ -117,4 +140,4 @@ void vtkLabelmapToModelFilter::Update()
   }
 
   this->OutputModel->ShallowCopy(decimator->GetOutput());
-} 
\ No newline at end of file
+}
@@ -55,6 +55,13 @@ public:
   vtkGetMacro(LabelValue, double);
   vtkSetMacro(LabelValue, double);
 
+  /// If on (default), then marching cubes runs on slabs of the labelmap in parallel
+  /// (see vtkParallelLabelmapToSurfaceFilter). The stitched surface is the same as the
+  /// vtkMarchingCubes surface. In both cases the surface is decimated by vtkDecimatePro.
+  vtkGetMacro(UseParallelSurfaceExtraction, bool);
+  vtkSetMacro(UseParallelSurfaceExtraction, bool);
+  vtkBooleanMacro(UseParallelSurfaceExtraction, bool);
+
 protected:
   vtkSetObjectMacro(OutputModel, vtkPolyData);
 
@@ -64,6 +71,8 @@ protected:
   double DecimateTargetReduction;
   /// Use this value for the marching cubes
   double LabelValue;
+  /// Run marching cubes with vtkParallelLabelmapToSurfaceFilter
+  bool UseParallelSurfaceExtraction;
 
 protected:
   vtkLabelmapToModelFilter();
@@ -0,0 +1,213 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkDiffusionTensorMathematics.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Random symmetric positive definite tensor: R diag(l) R^T, with
+// eigenvalues between 0.1 and 2 times scale
+void RandomTensor(float* t, double scale = 1.)
+{
+  double axis[3] = {vtkMath::Random(-1., 1.), vtkMath::Random(-1., 1.), vtkMath::Random(-1., 1.)};
+  vtkMath::Normalize(axis);
+  double angle = vtkMath::Random(0., vtkMath::Pi());
+  double q[4] = {cos(angle / 2.), sin(angle / 2.) * axis[0],
+                 sin(angle / 2.) * axis[1], sin(angle / 2.) * axis[2]};
+  double r[3][3];
+  vtkMath::QuaternionToMatrix3x3(q, r);
+  double l[3] = {vtkMath::Random(0.1, 2.) * scale, vtkMath::Random(0.1, 2.) * scale,
+                 vtkMath::Random(0.1, 2.) * scale};
+  // one tensor out of ten is (almost) isotropic
+  if (vtkMath::Random() < 0.1)
+    {
+    l[1] = l[2] = l[0];
+    }
+  for (int i = 0; i < 3; ++i)
+    {
+    for (int j = 0; j < 3; ++j)
+      {
+      t[3 * i + j] = static_cast<float>(
+        r[i][0] * l[0] * r[j][0] + r[i][1] * l[1] * r[j][1] + r[i][2] * l[2] * r[j][2]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool Compare(const char* name, double expected, double value, int voxel,
+             double scale = 1.)
+{
+  if (std::fabs(expected - value) > 1e-3 * (scale + std::fabs(expected)))
+    {
+    std::cerr << name << " differs at voxel " << voxel << ": "
+              << value << " instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorMathematicsTest2(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  vtkMath::RandomSeed(7);
+
+  // Closed form eigenvalues against the teem eigen solver, for unit
+  // tensors and for diffusion tensors in mm^2/s
+  const int numberOfTensors = 1000;
+  const double scales[2] = {1., 1e-3};
+  for (int s = 0; s < 2; ++s)
+    {
+    float tensors[9 * numberOfTensors];
+    for (int i = 0; i < numberOfTensors; ++i)
+      {
+      RandomTensor(tensors + 9 * i, scales[s]);
+      }
+    double w[3 * numberOfTensors];
+    vtkDiffusionTensorMathematics::ClosedFormEigenvalues(tensors, numberOfTensors, w);
+    double *m[3], *v[3];
+    double m0[3], m1[3], m2[3], v0[3], v1[3], v2[3];
+    m[0] = m0; m[1] = m1; m[2] = m2;
+    v[0] = v0; v[1] = v1; v[2] = v2;
+    for (int i = 0; i < numberOfTensors; ++i)
+      {
+      for (int j = 0; j < 3; ++j)
+        {
+        for (int k = 0; k < 3; ++k)
+          {
+          m[k][j] = tensors[9 * i + 3 * j + k];
+          }
+        }
+      double expected[3];
+      vtkDiffusionTensorMathematics::TeemEigenSolver(m, expected, v);
+      for (int k = 0; k < 3; ++k)
+        {
+        if (!Compare("Eigenvalue", expected[k], w[3 * i + k], i, scales[s]))
+          {
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  // Image of random tensors, with a row length that is not a multiple of
+  // the block size
+  vtkNew<vtkImageData> tensorImage;
+  int dimensions[3] = {13, 7, 5};
+  tensorImage->SetDimensions(dimensions);
+  const int numberOfVoxels = dimensions[0] * dimensions[1] * dimensions[2];
+  vtkNew<vtkFloatArray> tensorArray;
+  tensorArray->SetNumberOfComponents(9);
+  tensorArray->SetName("tensors");
+  tensorArray->SetNumberOfTuples(numberOfVoxels);
+  for (int i = 0; i < numberOfVoxels; ++i)
+    {
+    RandomTensor(tensorArray->GetPointer(9 * i));
+    }
+  tensorImage->GetPointData()->SetTensors(tensorArray.GetPointer());
+
+  const int measures[3] = {
+    vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY,
+    vtkDiffusionTensorMathematics::VTK_TENS_TRACE,
+    vtkDiffusionTensorMathematics::VTK_TENS_MODE};
+
+  // Reference values computed one operation at a time with teem
+  vtkNew<vtkDiffusionTensorMathematics> reference;
+  reference->SetInputData(tensorImage.GetPointer());
+  reference->UseClosedFormEigenvaluesOff();
+  vtkNew<vtkFloatArray> expected[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    reference->SetOperation(measures[i]);
+    reference->Update();
+    expected[i]->DeepCopy(reference->GetOutput()->GetPointData()->GetScalars());
+    }
+
+  // All the measures in one pass with the closed form eigenvalues
+  vtkNew<vtkDiffusionTensorMathematics> filter;
+  filter->SetInputData(tensorImage.GetPointer());
+  filter->SetOperation(measures[0]);
+  filter->AddOutputMeasure(measures[1]);
+  filter->AddOutputMeasure(measures[2]);
+  // adding twice the same measure is a no-op
+  filter->AddOutputMeasure(measures[2]);
+  // non scalar operations are rejected
+  filter->AddOutputMeasure(vtkDiffusionTensorMathematics::VTK_TENS_COLOR_ORIENTATION);
+  if (filter->GetNumberOfOutputMeasures() != 2)
+    {
+    std::cerr << "Wrong number of output measures: "
+              << filter->GetNumberOfOutputMeasures() << std::endl;
+    return EXIT_FAILURE;
+    }
+  filter->Update();
+
+  vtkPointData* outputPointData = filter->GetOutput()->GetPointData();
+  vtkDataArray* results[3] = {
+    outputPointData->GetScalars(),
+    outputPointData->GetArray(vtkDiffusionTensorMathematics::GetOperationName(measures[1])),
+    outputPointData->GetArray(vtkDiffusionTensorMathematics::GetOperationName(measures[2]))};
+  for (int i = 0; i < 3; ++i)
+    {
+    if (!results[i] || results[i]->GetNumberOfTuples() != numberOfVoxels)
+      {
+      std::cerr << "Missing output for "
+                << vtkDiffusionTensorMathematics::GetOperationName(measures[i]) << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (int voxel = 0; voxel < numberOfVoxels; ++voxel)
+      {
+      double expectedValue = expected[i]->GetValue(voxel);
+      // mode is ill-conditioned for (almost) isotropic tensors
+      if (measures[i] == vtkDiffusionTensorMathematics::VTK_TENS_MODE &&
+          outputPointData->GetScalars()->GetTuple1(voxel) < 0.01)
+        {
+        continue;
+        }
+      if (!Compare(vtkDiffusionTensorMathematics::GetOperationName(measures[i]),
+                   expectedValue, results[i]->GetTuple1(voxel), voxel))
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // Removing the measures removes the arrays
+  filter->RemoveAllOutputMeasures();
+  filter->Update();
+  if (filter->GetOutput()->GetPointData()->GetArray(
+        vtkDiffusionTensorMathematics::GetOperationName(measures[1])) != 0)
+    {
+    std::cerr << "Output measure not removed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
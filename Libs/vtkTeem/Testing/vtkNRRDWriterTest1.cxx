@@ -0,0 +1,124 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkNRRDReader.h>
+#include <vtkNRRDWriter.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool ReadAndCompare(const std::string& fileName, vtkImageData* expected,
+                    bool parallelDecompression)
+{
+  vtkNew<vtkNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->SetUseParallelDecompression(parallelDecompression);
+  reader->Update();
+
+  vtkImageData* output = reader->GetOutput();
+  int* expectedDims = expected->GetDimensions();
+  int* dims = output->GetDimensions();
+  if (dims[0] != expectedDims[0] || dims[1] != expectedDims[1] || dims[2] != expectedDims[2])
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong dimensions reading " << fileName << std::endl;
+    return false;
+    }
+  if (reader->GetHeaderValue(vtkNRRDReader::GetGzipMemberSizesKey()) != NULL)
+    {
+    std::cerr << "Line " << __LINE__ << ": gzip block table exposed as a header key" << std::endl;
+    return false;
+    }
+  short* expectedPtr = static_cast<short*>(expected->GetScalarPointer());
+  short* ptr = static_cast<short*>(output->GetScalarPointer());
+  vtkIdType numberOfVoxels = expected->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    if (ptr[i] != expectedPtr[i])
+      {
+      std::cerr << "Line " << __LINE__ << ": voxel " << i << " differs reading "
+                << fileName << ": " << ptr[i] << " != " << expectedPtr[i] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkNRRDWriterTest1(int argc, char * argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkNRRDWriterTest1 <temporary directory>" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(61, 47, 33);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  vtkIdType numberOfVoxels = image->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    ptr[i] = static_cast<short>((i * 7) % 1000 - 500);
+    }
+
+  const char* extensions[2] = {".nrrd", ".nhdr"};
+  for (int ext = 0; ext < 2; ++ext)
+    {
+    std::string fileName = tempDir + "/vtkNRRDWriterTest1" + extensions[ext];
+
+    vtkNew<vtkNRRDWriter> writer;
+    writer->SetInputData(image.GetPointer());
+    writer->SetFileName(fileName.c_str());
+    writer->UseCompressionOn();
+    writer->UseParallelCompressionOn();
+    writer->SetCompressionLevel(1);
+    // force many gzip members
+    writer->SetCompressionBlockSize(4096);
+    writer->SetNumberOfThreads(4);
+    writer->Write();
+    if (writer->GetWriteError())
+      {
+      std::cerr << "Line " << __LINE__ << ": failed to write " << fileName << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // parallel decompression with the block table
+    if (!ReadAndCompare(fileName, image.GetPointer(), true))
+      {
+      return EXIT_FAILURE;
+      }
+    // teem sequential decompression of the concatenated gzip members
+    if (!ReadAndCompare(fileName, image.GetPointer(), false))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkSeedTracts.h>
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkTrivialProducer.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool RunTractography(vtkAlgorithmOutput* tensors, vtkAlgorithmOutput* roi,
+                     bool parallel, int numberOfThreads, vtkPolyData* fibers)
+{
+  vtkNew<vtkSeedTracts> seedTracts;
+  seedTracts->SetInputTensorFieldConnection(tensors);
+  seedTracts->SetInputROIConnection(roi);
+  seedTracts->SetInputROIValue(1);
+  // only the vtkHyperStreamlineDTMRI streamlines are seeded in parallel
+  seedTracts->UseVtkHyperStreamlinePoints();
+  seedTracts->SetMinimumPathLength(2.);
+  seedTracts->SetUseParallelSeeding(parallel ? 1 : 0);
+  seedTracts->SetNumberOfThreads(numberOfThreads);
+  seedTracts->SeedStreamlinesInROI();
+  if (seedTracts->GetStreamlines()->GetNumberOfItems() == 0)
+    {
+    std::cerr << "No streamline seeded (parallel: " << parallel << ")" << std::endl;
+    return false;
+    }
+  seedTracts->TransformStreamlinesToRASAndAppendToPolyData(fibers);
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkSeedTractsTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Tensors elongated along x, slightly rotating with z
+  const int dimension = 24;
+  vtkNew<vtkImageData> tensorImage;
+  tensorImage->SetDimensions(dimension, dimension, dimension);
+  vtkNew<vtkFloatArray> tensors;
+  tensors->SetNumberOfComponents(9);
+  tensors->SetNumberOfTuples(dimension * dimension * dimension);
+  tensorImage->GetPointData()->SetTensors(tensors.GetPointer());
+  float* ptr = tensors->GetPointer(0);
+  for (int z = 0; z < dimension; ++z)
+    {
+    for (int y = 0; y < dimension; ++y)
+      {
+      for (int x = 0; x < dimension; ++x, ptr += 9)
+        {
+        float shear = 0.01f * z;
+        ptr[0] = 1.f;
+        ptr[4] = ptr[8] = 0.1f;
+        ptr[1] = ptr[3] = shear;
+        ptr[2] = ptr[5] = ptr[6] = ptr[7] = 0.f;
+        }
+      }
+    }
+  vtkNew<vtkTrivialProducer> tensorProducer;
+  tensorProducer->SetOutput(tensorImage.GetPointer());
+
+  // ROI in the center of the volume
+  vtkNew<vtkImageData> roiImage;
+  roiImage->SetDimensions(dimension, dimension, dimension);
+  roiImage->AllocateScalars(VTK_SHORT, 1);
+  short* roiPtr = static_cast<short*>(roiImage->GetScalarPointer());
+  for (int z = 0; z < dimension; ++z)
+    {
+    for (int y = 0; y < dimension; ++y)
+      {
+      for (int x = 0; x < dimension; ++x, ++roiPtr)
+        {
+        bool inside = x >= 8 && x < 16 && y >= 8 && y < 16 && z >= 8 && z < 16;
+        *roiPtr = inside ? 1 : 0;
+        }
+      }
+    }
+  vtkNew<vtkTrivialProducer> roiProducer;
+  roiProducer->SetOutput(roiImage.GetPointer());
+
+  vtkNew<vtkPolyData> sequentialFibers;
+  if (!RunTractography(tensorProducer->GetOutputPort(), roiProducer->GetOutputPort(),
+                       false, 1, sequentialFibers.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The parallel results must not depend on the number of threads
+  const int numberOfThreads[3] = {1, 3, 8};
+  for (int i = 0; i < 3; ++i)
+    {
+    vtkNew<vtkPolyData> parallelFibers;
+    if (!RunTractography(tensorProducer->GetOutputPort(), roiProducer->GetOutputPort(),
+                         true, numberOfThreads[i], parallelFibers.GetPointer()))
+      {
+      return EXIT_FAILURE;
+      }
+    if (parallelFibers->GetNumberOfPoints() != sequentialFibers->GetNumberOfPoints() ||
+        parallelFibers->GetNumberOfLines() != sequentialFibers->GetNumberOfLines())
+      {
+      std::cerr << "Line " << __LINE__ << " - " << numberOfThreads[i] << " threads: "
+                << parallelFibers->GetNumberOfLines() << " lines, "
+                << parallelFibers->GetNumberOfPoints() << " points, expected "
+                << sequentialFibers->GetNumberOfLines() << " lines, "
+                << sequentialFibers->GetNumberOfPoints() << " points" << std::endl;
+      return EXIT_FAILURE;
+      }
+    for (vtkIdType pointId = 0; pointId < sequentialFibers->GetNumberOfPoints(); ++pointId)
+      {
+      double expected[3];
+      double point[3];
+      sequentialFibers->GetPoint(pointId, expected);
+      parallelFibers->GetPoint(pointId, point);
+      if (point[0] != expected[0] || point[1] != expected[1] || point[2] != expected[2])
+        {
+        std::cerr << "Line " << __LINE__ << " - " << numberOfThreads[i] << " threads: point "
+                  << pointId << " differs from the sequential tractography" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    double expectedTensor[9];
+    double tensor[9];
+    vtkIdType lastId = sequentialFibers->GetNumberOfPoints() - 1;
+    sequentialFibers->GetPointData()->GetTensors()->GetTuple(lastId, expectedTensor);
+    parallelFibers->GetPointData()->GetTensors()->GetTuple(lastId, tensor);
+    for (int c = 0; c < 9; ++c)
+      {
+      if (tensor[c] != expectedTensor[c])
+        {
+        std::cerr << "Line " << __LINE__ << " - " << numberOfThreads[i]
+                  << " threads: tensors differ" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -19,6 +19,7 @@
 
 // But, if you are on VS6.0 you don't get the define...
 #include "vtkDataArray.h"
+#include "vtkFloatArray.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
 #include "vtkImageData.h"
@@ -36,6 +37,8 @@ extern "C" {
 #include "teem/ten.h"
 }
 
+#include <algorithm>
+#include <cmath>
 #include <ctime>
 #include <limits>
 
@@ -66,6 +69,11 @@ vtkDiffusionTensorMathematics::vtkDiffusionTensorMathematics()
   this->MaskWithScalars = 0;
   this->FixNegativeEigenvalues = 1;
   this->MaskLabelValue = 1;
+  this->UseClosedFormEigenvalues = 1;
+  for (int i = 0; i < 6; ++i)
+    {
+    this->OutputMeasureExtent[i] = 0;
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -143,6 +151,25 @@ int vtkDiffusionTensorMathematics
 ::RequestData(vtkInformation* request, vtkInformationVector** inputVector,
               vtkInformationVector* outputVector)
 {
+  // The measure arrays are allocated here so that the threads can fill them
+  this->OutputMeasureArrays.clear();
+  if (!this->OutputMeasures.empty())
+    {
+    vtkInformation* outInfo = outputVector->GetInformationObject(0);
+    outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), this->OutputMeasureExtent);
+    vtkIdType numberOfTuples =
+      static_cast<vtkIdType>(this->OutputMeasureExtent[1] - this->OutputMeasureExtent[0] + 1) *
+      (this->OutputMeasureExtent[3] - this->OutputMeasureExtent[2] + 1) *
+      (this->OutputMeasureExtent[5] - this->OutputMeasureExtent[4] + 1);
+    for (size_t i = 0; i < this->OutputMeasures.size(); ++i)
+      {
+      vtkSmartPointer<vtkFloatArray> array = vtkSmartPointer<vtkFloatArray>::New();
+      array->SetName(vtkDiffusionTensorMathematics::GetOperationName(this->OutputMeasures[i]));
+      array->SetNumberOfTuples(std::max(numberOfTuples, static_cast<vtkIdType>(0)));
+      this->OutputMeasureArrays.push_back(array);
+      }
+    }
+
   int res = this->Superclass::RequestData(request, inputVector, outputVector);
   for (int i = 0; i < this->GetNumberOfOutputPorts(); ++i)
     {
@@ -150,10 +177,128 @@ int vtkDiffusionTensorMathematics
     vtkImageData *outData = static_cast<vtkImageData *>(
       info->Get(vtkDataObject::DATA_OBJECT()));
     outData->GetPointData()->SetTensors(NULL);
+    if (i == 0)
+      {
+      for (size_t j = 0; j < this->OutputMeasureArrays.size(); ++j)
+        {
+        outData->GetPointData()->AddArray(this->OutputMeasureArrays[j]);
+        }
+      }
     }
+  this->OutputMeasureArrays.clear();
   return res;
 }
 
+//----------------------------------------------------------------------------
+void vtkDiffusionTensorMathematics::AddOutputMeasure(int operation)
+{
+  if (!vtkDiffusionTensorMathematics::IsScalarMeasure(operation))
+    {
+    vtkErrorMacro(<< "AddOutputMeasure: operation " << operation << " is not a scalar measure");
+    return;
+    }
+  if (std::find(this->OutputMeasures.begin(), this->OutputMeasures.end(), operation)
+      != this->OutputMeasures.end())
+    {
+    return;
+    }
+  this->OutputMeasures.push_back(operation);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkDiffusionTensorMathematics::RemoveAllOutputMeasures()
+{
+  if (this->OutputMeasures.empty())
+    {
+    return;
+    }
+  this->OutputMeasures.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorMathematics::GetNumberOfOutputMeasures()
+{
+  return static_cast<int>(this->OutputMeasures.size());
+}
+
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorMathematics::GetOutputMeasure(int index)
+{
+  if (index < 0 || index >= static_cast<int>(this->OutputMeasures.size()))
+    {
+    vtkErrorMacro(<< "GetOutputMeasure: index " << index << " out of range");
+    return -1;
+    }
+  return this->OutputMeasures[index];
+}
+
+//----------------------------------------------------------------------------
+bool vtkDiffusionTensorMathematics::IsScalarMeasure(int operation)
+{
+  switch (operation)
+    {
+    case VTK_TENS_TRACE:
+    case VTK_TENS_DETERMINANT:
+    case VTK_TENS_D11:
+    case VTK_TENS_D22:
+    case VTK_TENS_D33:
+    case VTK_TENS_RELATIVE_ANISOTROPY:
+    case VTK_TENS_FRACTIONAL_ANISOTROPY:
+    case VTK_TENS_MAX_EIGENVALUE:
+    case VTK_TENS_MID_EIGENVALUE:
+    case VTK_TENS_MIN_EIGENVALUE:
+    case VTK_TENS_LINEAR_MEASURE:
+    case VTK_TENS_PLANAR_MEASURE:
+    case VTK_TENS_SPHERICAL_MEASURE:
+    case VTK_TENS_MODE:
+    case VTK_TENS_PARALLEL_DIFFUSIVITY:
+    case VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
+      return true;
+    default:
+      return false;
+    }
+}
+
+//----------------------------------------------------------------------------
+const char* vtkDiffusionTensorMathematics::GetOperationName(int operation)
+{
+  switch (operation)
+    {
+    case VTK_TENS_TRACE: return "Trace";
+    case VTK_TENS_DETERMINANT: return "Determinant";
+    case VTK_TENS_RELATIVE_ANISOTROPY: return "RelativeAnisotropy";
+    case VTK_TENS_FRACTIONAL_ANISOTROPY: return "FractionalAnisotropy";
+    case VTK_TENS_MAX_EIGENVALUE: return "MaxEigenvalue";
+    case VTK_TENS_MID_EIGENVALUE: return "MidEigenvalue";
+    case VTK_TENS_MIN_EIGENVALUE: return "MinEigenvalue";
+    case VTK_TENS_LINEAR_MEASURE: return "LinearMeasure";
+    case VTK_TENS_PLANAR_MEASURE: return "PlanarMeasure";
+    case VTK_TENS_SPHERICAL_MEASURE: return "SphericalMeasure";
+    case VTK_TENS_COLOR_ORIENTATION: return "ColorOrientation";
+    case VTK_TENS_D11: return "D11";
+    case VTK_TENS_D22: return "D22";
+    case VTK_TENS_D33: return "D33";
+    case VTK_TENS_MODE: return "Mode";
+    case VTK_TENS_COLOR_MODE: return "ColorMode";
+    case VTK_TENS_MAX_EIGENVALUE_PROJX: return "MaxEigenvalueProjectionX";
+    case VTK_TENS_MAX_EIGENVALUE_PROJY: return "MaxEigenvalueProjectionY";
+    case VTK_TENS_MAX_EIGENVALUE_PROJZ: return "MaxEigenvalueProjectionZ";
+    case VTK_TENS_RAI_MAX_EIGENVEC_PROJX: return "RAIMaxEigenvecX";
+    case VTK_TENS_RAI_MAX_EIGENVEC_PROJY: return "RAIMaxEigenvecY";
+    case VTK_TENS_RAI_MAX_EIGENVEC_PROJZ: return "RAIMaxEigenvecZ";
+    case VTK_TENS_MAX_EIGENVEC_PROJX: return "MaxEigenvecX";
+    case VTK_TENS_MAX_EIGENVEC_PROJY: return "MaxEigenvecY";
+    case VTK_TENS_MAX_EIGENVEC_PROJZ: return "MaxEigenvecZ";
+    case VTK_TENS_PARALLEL_DIFFUSIVITY: return "ParallelDiffusivity";
+    case VTK_TENS_PERPENDICULAR_DIFFUSIVITY: return "PerpendicularDiffusivity";
+    case VTK_TENS_COLOR_ORIENTATION_MIDDLE_EIGENVECTOR: return "ColorOrientationMiddleEigenvector";
+    case VTK_TENS_COLOR_ORIENTATION_MIN_EIGENVECTOR: return "ColorOrientationMinEigenvector";
+    default: return NULL;
+    }
+}
+
 //----------------------------------------------------------------------------
 static void GetContinuousIncrements(vtkImageData* img, int extent[6], vtkIdType &incX,
                                     vtkIdType &incY, vtkIdType &incZ)
@@ -798,6 +943,270 @@ static void vtkDiffusionTensorMathematicsExecute1Eigen(vtkDiffusionTensorMathema
 #endif
 }
 
+//----------------------------------------------------------------------------
+// Number of voxels whose eigenvalues are computed together
+static const int vtkDiffusionTensorMathematicsBlockSize = 8;
+
+//----------------------------------------------------------------------------
+// Scalar measure of a tensor (9 floats) and its sorted eigenvalues
+static double vtkDiffusionTensorMathematicsMeasure(int op, double w[3], const float *t)
+{
+  switch (op)
+    {
+    case vtkDiffusionTensorMathematics::VTK_TENS_TRACE:
+      return static_cast<double>(t[0]) + t[4] + t[8];
+    case vtkDiffusionTensorMathematics::VTK_TENS_DETERMINANT:
+      {
+      double D[3][3] = {{t[0], t[1], t[2]}, {t[3], t[4], t[5]}, {t[6], t[7], t[8]}};
+      return vtkDiffusionTensorMathematics::Determinant(D);
+      }
+    case vtkDiffusionTensorMathematics::VTK_TENS_D11:
+      return t[0];
+    case vtkDiffusionTensorMathematics::VTK_TENS_D22:
+      return t[4];
+    case vtkDiffusionTensorMathematics::VTK_TENS_D33:
+      return t[8];
+    case vtkDiffusionTensorMathematics::VTK_TENS_RELATIVE_ANISOTROPY:
+      return vtkDiffusionTensorMathematics::RelativeAnisotropy(w);
+    case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
+      return vtkDiffusionTensorMathematics::FractionalAnisotropy(w);
+    case vtkDiffusionTensorMathematics::VTK_TENS_MAX_EIGENVALUE:
+      return w[0];
+    case vtkDiffusionTensorMathematics::VTK_TENS_MID_EIGENVALUE:
+      return w[1];
+    case vtkDiffusionTensorMathematics::VTK_TENS_MIN_EIGENVALUE:
+      return w[2];
+    case vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE:
+      return vtkDiffusionTensorMathematics::LinearMeasure(w);
+    case vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE:
+      return vtkDiffusionTensorMathematics::PlanarMeasure(w);
+    case vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE:
+      return vtkDiffusionTensorMathematics::SphericalMeasure(w);
+    case vtkDiffusionTensorMathematics::VTK_TENS_MODE:
+      return vtkDiffusionTensorMathematics::Mode(w);
+    case vtkDiffusionTensorMathematics::VTK_TENS_PARALLEL_DIFFUSIVITY:
+      return vtkDiffusionTensorMathematics::ParallelDiffusivity(w);
+    case vtkDiffusionTensorMathematics::VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
+      return vtkDiffusionTensorMathematics::PerpendicularDiffusivity(w);
+    }
+  return 0.;
+}
+
+//----------------------------------------------------------------------------
+// Computes the scalar measures (the Operation if outPtr is not NULL, and the
+// OutputMeasures) in one pass. The eigenvalues are computed once per voxel,
+// by blocks of voxels of a row.
+static void vtkDiffusionTensorMathematicsExecuteMeasures(vtkDiffusionTensorMathematics *self,
+                          vtkImageData *in1Data,
+                          vtkImageData *outData,
+                          float *outPtr,
+                          int outExt[6], int id,
+                          const std::vector<int>& measures,
+                          const std::vector<float*>& measurePtrs,
+                          const int measureExtent[6])
+{
+  // image variables
+  int idxR, idxY, idxZ;
+  int maxY, maxZ;
+  vtkIdType outIncX = 0, outIncY = 0, outIncZ = 0;
+  vtkIdType inIncX, inIncY, inIncZ;
+  int rowLength;
+  // progress
+  unsigned long count = 0;
+  unsigned long target;
+  // scaling
+  double scaleFactor = self->GetScaleFactor();
+  int op = self->GetOperation();
+
+  vtkDataArray *inTensors = in1Data->GetPointData()->GetTensors();
+  if ( !inTensors || in1Data->GetNumberOfPoints() < 1 )
+    {
+    vtkGenericWarningMacro(<<"No input tensor data to filter!");
+    return;
+    }
+  if (self->GetScalarMask() && self->GetScalarMask()->GetScalarType() != VTK_SHORT)
+    {
+    vtkGenericWarningMacro(<<"scalr type for mask must be short!");
+    return;
+    }
+
+  // find the output region to loop over
+  rowLength = (outExt[1] - outExt[0]+1);
+  maxY = outExt[3] - outExt[2];
+  maxZ = outExt[5] - outExt[4];
+  target = (unsigned long)((maxZ+1)*(maxY+1)/50.0);
+  target++;
+
+  if (outPtr)
+    {
+    outData->GetContinuousIncrements(outExt, outIncX, outIncY, outIncZ);
+    }
+  GetContinuousIncrements(in1Data, outExt, inIncX, inIncY, inIncZ);
+  float* inPtr = reinterpret_cast<float*>(in1Data->GetArrayPointerForExtent(inTensors, outExt));
+
+  // measure arrays cover measureExtent
+  const vtkIdType measureRowLength = measureExtent[1] - measureExtent[0] + 1;
+  const vtkIdType measureSliceSize = measureRowLength * (measureExtent[3] - measureExtent[2] + 1);
+  const size_t numberOfMeasures = measures.size();
+
+  bool doMasking = false;
+  short * inMaskPtr = 0;
+  vtkIdType maskIncX = 0;
+  vtkIdType maskIncY = 0;
+  vtkIdType maskIncZ = 0;
+  if (self->GetMaskWithScalars() && self->GetScalarMask())
+    {
+    self->GetScalarMask()->GetContinuousIncrements(outExt, maskIncX, maskIncY, maskIncZ);
+    inMaskPtr = reinterpret_cast<short *>(self->GetScalarMask()->GetScalarPointerForExtent(outExt));
+    doMasking = self->GetScalarMask()->GetPointData()->GetScalars() != 0;
+    }
+  const int maskLabelValue = self->GetMaskLabelValue();
+  const bool closedForm = self->GetExtractEigenvalues() && self->GetUseClosedFormEigenvalues();
+  const int fixNegativeEigenvalues = self->GetFixNegativeEigenvalues();
+
+  // working matrices for the teem eigen solver
+  double *m[3], *v[3];
+  double m0[3], m1[3], m2[3];
+  double v0[3], v1[3], v2[3];
+  m[0] = m0; m[1] = m1; m[2] = m2;
+  v[0] = v0; v[1] = v1; v[2] = v2;
+  double w[3 * vtkDiffusionTensorMathematicsBlockSize];
+
+  for (idxZ = 0; idxZ <= maxZ; idxZ++)
+    {
+    for (idxY = 0; idxY <= maxY; idxY++)
+      {
+      if (!id)
+        {
+        if (!(count%target))
+          {
+          self->UpdateProgress(count/(50.0*target));
+          }
+        count++;
+        }
+
+      vtkIdType measureRowStart =
+        (outExt[4] + idxZ - measureExtent[4]) * measureSliceSize +
+        (outExt[2] + idxY - measureExtent[2]) * measureRowLength +
+        (outExt[0] - measureExtent[0]);
+
+      for (idxR = 0; idxR < rowLength; idxR += vtkDiffusionTensorMathematicsBlockSize)
+        {
+        const int blockSize = std::min(vtkDiffusionTensorMathematicsBlockSize, rowLength - idxR);
+        const float *blockPtr = inPtr + 9 * idxR;
+
+        // eigenvalues of the block, sorted in decreasing order
+        if (closedForm)
+          {
+          vtkDiffusionTensorMathematics::ClosedFormEigenvalues(blockPtr, blockSize, w);
+          }
+        else
+          {
+          for (int i = 0; i < blockSize; ++i)
+            {
+            const float *t = blockPtr + 9 * i;
+            if (self->GetExtractEigenvalues())
+              {
+              for (int j = 0; j < 3; j++)
+                {
+                for (int k = 0; k < 3; k++)
+                  {
+                  // transpose
+                  m[k][j] = t[3 * j + k];
+                  }
+                }
+              vtkDiffusionTensorMathematics::TeemEigenSolver(m, w + 3 * i, v);
+              }
+            else
+              {
+              // tensor columns are evectors scaled by evals
+              for (int k = 0; k < 3; k++)
+                {
+                v0[k] = t[3 * k];
+                v1[k] = t[3 * k + 1];
+                v2[k] = t[3 * k + 2];
+                }
+              w[3 * i] = vtkMath::Normalize(v0);
+              w[3 * i + 1] = vtkMath::Normalize(v1);
+              w[3 * i + 2] = vtkMath::Normalize(v2);
+              }
+            }
+          }
+
+        for (int i = 0; i < blockSize; ++i)
+          {
+          double *wi = w + 3 * i;
+          const vtkIdType voxel = measureRowStart + idxR + i;
+          if (doMasking && inMaskPtr[idxR + i] != maskLabelValue)
+            {
+            if (outPtr)
+              {
+              outPtr[idxR + i] = 0;
+              }
+            for (size_t k = 0; k < numberOfMeasures; ++k)
+              {
+              measurePtrs[k][voxel] = 0;
+              }
+            continue;
+            }
+          // same correction of negative eigenvalues as the teem path
+          if (fixNegativeEigenvalues == 1)
+            {
+            const double min_eval = MIN3(wi[0], wi[1], wi[2]);
+            if (min_eval < 0)
+              {
+              const double add_to_eval = -min_eval + VTK_EPS;
+              wi[0] += add_to_eval;
+              wi[1] += add_to_eval;
+              wi[2] += add_to_eval;
+              }
+            }
+          else
+            {
+            for (int k = 0; k < 3; ++k)
+              {
+              if (wi[k] < 0)
+                {
+                wi[k] = DOUBLE_NAN;
+                }
+              }
+            }
+          const float *t = blockPtr + 9 * i;
+          if (outPtr)
+            {
+            outPtr[idxR + i] = static_cast<float>(
+              scaleFactor * vtkDiffusionTensorMathematicsMeasure(op, wi, t));
+            }
+          for (size_t k = 0; k < numberOfMeasures; ++k)
+            {
+            measurePtrs[k][voxel] = static_cast<float>(
+              scaleFactor * vtkDiffusionTensorMathematicsMeasure(measures[k], wi, t));
+            }
+          }
+        }
+
+      inPtr += 9 * rowLength + inIncY;
+      if (outPtr)
+        {
+        outPtr += rowLength + outIncY;
+        }
+      if (doMasking)
+        {
+        inMaskPtr += rowLength + maskIncY;
+        }
+      }
+    inPtr += inIncZ;
+    if (outPtr)
+      {
+      outPtr += outIncZ;
+      }
+    if (doMasking)
+      {
+      inMaskPtr += maskIncZ;
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 // This method computes the increments from the MemoryOrder and the extent.
 void vtkDiffusionTensorMathematics::ComputeTensorIncrements(vtkImageData *imageData, vtkIdType incr[3])
@@ -850,6 +1259,34 @@ void vtkDiffusionTensorMathematics::ThreadedRequestData(
   // single input only for now
   vtkDebugMacro ("In Threaded Execute. scalar type is " << inData[0][0]->GetScalarType() << "op is: " << this->Operation);
 
+  std::vector<float*> measurePtrs;
+  for (size_t i = 0; i < this->OutputMeasureArrays.size(); ++i)
+    {
+    measurePtrs.push_back(this->OutputMeasureArrays[i]->GetPointer(0));
+    }
+  std::vector<int> measures(this->OutputMeasures.begin(),
+                            this->OutputMeasures.begin() + measurePtrs.size());
+
+  // Scalar measures are computed together by blocks of voxels
+  bool eigenvalueMeasure = IsScalarMeasure(this->Operation) &&
+    this->Operation != VTK_TENS_TRACE && this->Operation != VTK_TENS_DETERMINANT &&
+    this->Operation != VTK_TENS_D11 && this->Operation != VTK_TENS_D22 &&
+    this->Operation != VTK_TENS_D33;
+  if (IsScalarMeasure(this->Operation) &&
+      outData[0]->GetScalarType() == VTK_FLOAT &&
+      (!measures.empty() ||
+       (eigenvalueMeasure && this->ExtractEigenvalues && this->UseClosedFormEigenvalues)))
+    {
+    vtkDiffusionTensorMathematicsExecuteMeasures(this, inData[0][0], outData[0],
+      static_cast<float*>(outPtr), outExt, id, measures, measurePtrs, this->OutputMeasureExtent);
+    return;
+    }
+  if (!measures.empty())
+    {
+    vtkDiffusionTensorMathematicsExecuteMeasures(this, inData[0][0], outData[0],
+      NULL, outExt, id, measures, measurePtrs, this->OutputMeasureExtent);
+    }
+
   switch (this->GetOperation())
     {
 
@@ -1149,6 +1586,13 @@ void vtkDiffusionTensorMathematics::PrintSelf(ostream& os, vtkIndent indent)
   this->Superclass::PrintSelf(os,indent);
 
   os << indent << "Operation: " << this->Operation << "\n";
+  os << indent << "UseClosedFormEigenvalues: " << this->UseClosedFormEigenvalues << "\n";
+  os << indent << "OutputMeasures:";
+  for (size_t i = 0; i < this->OutputMeasures.size(); ++i)
+    {
+    os << " " << GetOperationName(this->OutputMeasures[i]);
+    }
+  os << "\n";
 }
 
 // Colormap: convert our mode value (-1..1) to RGB
@@ -1354,3 +1798,64 @@ int vtkDiffusionTensorMathematics::TeemEigenSolver(double **m, double *w, double
     return res;
 
 }
+
+//----------------------------------------------------------------------------
+void vtkDiffusionTensorMathematics::ClosedFormEigenvalues(const float* tensors,
+                                                         int numberOfTensors,
+                                                         double* w)
+{
+  // The loops over a block have no branches nor dependencies between the
+  // voxels so that the compiler can vectorize them.
+  const int blockSize = vtkDiffusionTensorMathematicsBlockSize;
+  const double twoThirdsPi = 2. * vtkMath::Pi() / 3.;
+  double q[vtkDiffusionTensorMathematicsBlockSize];
+  double p[vtkDiffusionTensorMathematicsBlockSize];
+  double phi[vtkDiffusionTensorMathematicsBlockSize];
+  for (int first = 0; first < numberOfTensors; first += blockSize)
+    {
+    const int n = std::min(blockSize, numberOfTensors - first);
+    const float *t = tensors + 9 * first;
+    for (int i = 0; i < n; ++i)
+      {
+      // same components as TeemEigenSolver (upper triangle of the transpose)
+      const double a00 = t[9 * i];
+      const double a11 = t[9 * i + 4];
+      const double a22 = t[9 * i + 8];
+      const double a01 = t[9 * i + 3];
+      const double a02 = t[9 * i + 6];
+      const double a12 = t[9 * i + 7];
+      const double mean = (a00 + a11 + a22) / 3.;
+      const double d0 = a00 - mean;
+      const double d1 = a11 - mean;
+      const double d2 = a22 - mean;
+      const double offDiagonal = a01 * a01 + a02 * a02 + a12 * a12;
+      const double scale = sqrt((d0 * d0 + d1 * d1 + d2 * d2 + 2. * offDiagonal) / 6.);
+      // determinant of (A - mean I)
+      const double det = d0 * (d1 * d2 - a12 * a12)
+                       - a01 * (a01 * d2 - a12 * a02)
+                       + a02 * (a01 * a12 - d1 * a02);
+      const double scale3 = scale * scale * scale;
+      // isotropic tensors have a single eigenvalue, any angle works. The
+      // threshold is relative to the trace: diffusion tensors in mm^2/s
+      // have eigenvalues around 1e-3.
+      const double r = scale > VTK_EPS * (fabs(3. * mean) + scale) ?
+        det / (2. * scale3) : 0.;
+      q[i] = mean;
+      p[i] = scale;
+      phi[i] = std::max(-1., std::min(1., r));
+      }
+    for (int i = 0; i < n; ++i)
+      {
+      phi[i] = acos(phi[i]) / 3.;
+      }
+    double *wi = w + 3 * first;
+    for (int i = 0; i < n; ++i)
+      {
+      const double e0 = q[i] + 2. * p[i] * cos(phi[i]);
+      const double e2 = q[i] + 2. * p[i] * cos(phi[i] + twoThirdsPi);
+      wi[3 * i] = e0;
+      wi[3 * i + 1] = 3. * q[i] - e0 - e2;
+      wi[3 * i + 2] = e2;
+      }
+    }
+}
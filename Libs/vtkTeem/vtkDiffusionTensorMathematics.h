@@ -30,8 +30,13 @@
 #include "vtkTeemConfigure.h"
 
 // VTK includes
+#include <vtkSmartPointer.h>
 #include <vtkThreadedImageAlgorithm.h>
 
+// STD includes
+#include <vector>
+
+class vtkFloatArray;
 class vtkMatrix4x4;
 class vtkImageData;
 class VTK_Teem_EXPORT vtkDiffusionTensorMathematics : public vtkThreadedImageAlgorithm
@@ -186,6 +191,42 @@ public:
   vtkBooleanMacro(ExtractEigenvalues,int);
   vtkGetMacro(ExtractEigenvalues,int);
 
+  ///
+  /// If on (default), the eigenvalues needed by the scalar measures are
+  /// computed in closed form on blocks of voxels instead of one voxel at a
+  /// time with the teem eigen solver. Operations that need the eigenvectors
+  /// (colors and projections) always use the teem eigen solver.
+  vtkSetMacro(UseClosedFormEigenvalues,int);
+  vtkBooleanMacro(UseClosedFormEigenvalues,int);
+  vtkGetMacro(UseClosedFormEigenvalues,int);
+
+  ///
+  /// Scalar measures computed in the same pass as Operation. Each measure
+  /// is added to the output point data as a float array named after the
+  /// operation (see GetOperationName()), the eigenvalues are computed only
+  /// once per voxel for all of them.
+  /// Only the operations accepted by IsScalarMeasure() are supported.
+  void AddOutputMeasure(int operation);
+  void RemoveAllOutputMeasures();
+  int GetNumberOfOutputMeasures();
+  int GetOutputMeasure(int index);
+
+  ///
+  /// Return true if the operation outputs one value per voxel that only
+  /// depends on the tensor components or its eigenvalues.
+  static bool IsScalarMeasure(int operation);
+
+  ///
+  /// Name of the operation, e.g. "FractionalAnisotropy". NULL if unknown.
+  static const char* GetOperationName(int operation);
+
+  ///
+  /// Eigenvalues of symmetric tensors (9 floats each, as in the tensor
+  /// arrays) computed with the trigonometric closed form, sorted in
+  /// decreasing order in \a w (3 values per tensor).
+  static void ClosedFormEigenvalues(const float* tensors, int numberOfTensors,
+                                    double* w);
+
   /// Description
   /// This matrix is only used for ColorByOrientation.
   /// We transform the tensor orientation by this matrix
@@ -284,6 +325,12 @@ protected:
   vtkMatrix4x4 *TensorRotationMatrix;
   int FixNegativeEigenvalues;
 
+  int UseClosedFormEigenvalues;
+  std::vector<int> OutputMeasures;
+  /// Arrays of the OutputMeasures on the update extent, filled by the threads
+  std::vector<vtkSmartPointer<vtkFloatArray> > OutputMeasureArrays;
+  int OutputMeasureExtent[6];
+
   virtual int RequestInformation (vtkInformation*,
                                   vtkInformationVector**,
                                   vtkInformationVector*);
@@ -39,6 +39,8 @@
 #include "vtkIntArray.h"
 #include "vtkLongArray.h"
 #include "vtkMath.h"
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
 #include "vtkObjectFactory.h"
 #include "vtkShortArray.h"
 #include <vtkStreamingDemandDrivenPipeline.h>
@@ -47,6 +49,12 @@
 #include "vtkUnsignedIntArray.h"
 #include "vtkUnsignedLongArray.h"
 #include <vtksys/SystemTools.hxx>
+#include <vtk_zlib.h>
+
+// STD includes
+#include <algorithm>
+#include <limits>
+#include <sstream>
 
 // Teem includes
 #include "teem/ten.h"
@@ -66,6 +74,9 @@ vtkNRRDReader::vtkNRRDReader()
   PointDataType = -1;
   DataType = -1;
   NumberOfComponents = -1;
+  UseParallelDecompression = 1;
+  NumberOfThreads = 0;
+  GzipBlockSize = 0;
 }
 
 vtkNRRDReader::~vtkNRRDReader()
@@ -272,6 +283,8 @@ void vtkNRRDReader::ExecuteInformation()
 
 
    HeaderKeyValue.clear();
+   GzipBlockSize = 0;
+   GzipMemberSizes.clear();
 
    if (this->RasToIjkMatrix) {
      this->RasToIjkMatrix->Delete();
@@ -588,7 +601,24 @@ void vtkNRRDReader::ExecuteInformation()
    // Push extra key/value pair data into std::map
    for (i=0; (unsigned int)i < nrrdKeyValueSize(this->nrrd); i++) {
      nrrdKeyValueIndex(this->nrrd, &key, &val, i);
-     HeaderKeyValue[std::string(key)] = std::string(val);
+     if (!strcmp(key, vtkNRRDReader::GetGzipBlockSizeKey()))
+       {
+       std::stringstream ss(val);
+       ss >> GzipBlockSize;
+       }
+     else if (!strcmp(key, vtkNRRDReader::GetGzipMemberSizesKey()))
+       {
+       std::stringstream ss(val);
+       size_t memberSize = 0;
+       while (ss >> memberSize)
+         {
+         GzipMemberSizes.push_back(memberSize);
+         }
+       }
+     else
+       {
+       HeaderKeyValue[std::string(key)] = std::string(val);
+       }
      free(key);  // key and val point to malloc'd data!!
      free(val);
      key = val = NULL;
@@ -852,6 +882,186 @@ vtkNRRDReader::tenSpaceDirectionReduce(Nrrd *nout, const Nrrd *nin, double SD[9]
 }
 
 
+//----------------------------------------------------------------------------
+namespace
+{
+struct GunzipBlocksInfo
+{
+  const unsigned char *Compressed;
+  std::vector<size_t> MemberOffsets;
+  std::vector<size_t> MemberSizes;
+  unsigned char *Output;
+  size_t OutputSize;
+  size_t BlockSize;
+  std::vector<int> Errors;
+};
+
+//----------------------------------------------------------------------------
+// Inflate one complete gzip member into a block of known size
+bool DecompressGzipMember(const unsigned char *in, size_t inSize,
+                          unsigned char *out, size_t outSize)
+{
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  // 15 + 16: maximum window size, gzip wrapper only
+  if (inflateInit2(&strm, 15 + 16) != Z_OK)
+    {
+    return false;
+    }
+  // zlib counts the available bytes in uInt, blocks of 4 GB or more are
+  // passed in chunks
+  const size_t maxChunkSize = std::numeric_limits<uInt>::max();
+  strm.next_in = const_cast<Bytef*>(in);
+  strm.next_out = out;
+  size_t inRemaining = inSize;
+  size_t outRemaining = outSize;
+  int res = Z_OK;
+  while (res == Z_OK)
+    {
+    if (strm.avail_in == 0 && inRemaining > 0)
+      {
+      size_t chunkSize = std::min(inRemaining, maxChunkSize);
+      strm.avail_in = static_cast<uInt>(chunkSize);
+      inRemaining -= chunkSize;
+      }
+    if (strm.avail_out == 0 && outRemaining > 0)
+      {
+      size_t chunkSize = std::min(outRemaining, maxChunkSize);
+      strm.avail_out = static_cast<uInt>(chunkSize);
+      outRemaining -= chunkSize;
+      }
+    res = inflate(&strm, Z_NO_FLUSH);
+    }
+  bool success = (res == Z_STREAM_END && strm.avail_out == 0 && outRemaining == 0
+                  && strm.avail_in == 0 && inRemaining == 0);
+  inflateEnd(&strm);
+  return success;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE DecompressGzipBlocksThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  GunzipBlocksInfo *info = static_cast<GunzipBlocksInfo*>(threadInfo->UserData);
+  size_t numberOfBlocks = info->MemberSizes.size();
+  for (size_t block = threadInfo->ThreadID; block < numberOfBlocks;
+       block += threadInfo->NumberOfThreads)
+    {
+    size_t start = block * info->BlockSize;
+    size_t size = std::min(info->BlockSize, info->OutputSize - start);
+    if (!DecompressGzipMember(info->Compressed + info->MemberOffsets[block],
+                              info->MemberSizes[block],
+                              info->Output + start, size))
+      {
+      info->Errors[block] = 1;
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//----------------------------------------------------------------------------
+bool vtkNRRDReader::ReadParallelGzip()
+{
+  if (!this->UseParallelDecompression ||
+      this->GzipBlockSize == 0 || this->GzipMemberSizes.empty())
+    {
+    return false;
+    }
+
+  // Read the header and keep the data file open right at the data
+  NrrdIoState *nio = nrrdIoStateNew();
+  nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+  nrrdIoStateSet(nio, nrrdIoStateKeepNrrdDataFileOpen, 1);
+  if (nrrdLoad(this->nrrd, this->GetFileName(), nio) != 0)
+    {
+    char *err = biffGetDone(NRRD);
+    free(err);
+    nio = nrrdIoStateNix(nio);
+    return false;
+    }
+
+  size_t numberOfBlocks = this->GzipMemberSizes.size();
+  size_t dataSize = nrrdElementSize(this->nrrd) * nrrdElementNumber(this->nrrd);
+  size_t compressedSize = 0;
+  for (size_t block = 0; block < numberOfBlocks; ++block)
+    {
+    compressedSize += this->GzipMemberSizes[block];
+    }
+  bool success = nio->encoding == nrrdEncodingGzip
+    && nio->dataFile != NULL
+    && nio->byteSkip == 0 && nio->lineSkip == 0
+    && numberOfBlocks == (dataSize + this->GzipBlockSize - 1) / this->GzipBlockSize;
+
+  std::vector<unsigned char> compressed;
+  if (success)
+    {
+    compressed.resize(compressedSize);
+    success = (fread(&compressed[0], 1, compressedSize, nio->dataFile) == compressedSize);
+    }
+  if (nio->dataFile)
+    {
+    nio->dataFile = airFclose(nio->dataFile);
+    }
+  if (success)
+    {
+    size_t sizes[NRRD_DIM_MAX];
+    for (unsigned int axi = 0; axi < this->nrrd->dim; ++axi)
+      {
+      sizes[axi] = this->nrrd->axis[axi].size;
+      }
+    success = (nrrdMaybeAlloc_nva(this->nrrd, this->nrrd->type, this->nrrd->dim, sizes) == 0);
+    if (!success)
+      {
+      char *err = biffGetDone(NRRD);
+      vtkErrorMacro("Read: Cannot allocate data for " << this->GetFileName() << ": " << err);
+      free(err);
+      }
+    }
+  if (success)
+    {
+    GunzipBlocksInfo info;
+    info.Compressed = &compressed[0];
+    info.MemberSizes = this->GzipMemberSizes;
+    info.MemberOffsets.resize(numberOfBlocks, 0);
+    for (size_t block = 1; block < numberOfBlocks; ++block)
+      {
+      info.MemberOffsets[block] = info.MemberOffsets[block - 1] + info.MemberSizes[block - 1];
+      }
+    info.Output = static_cast<unsigned char*>(this->nrrd->data);
+    info.OutputSize = dataSize;
+    info.BlockSize = this->GzipBlockSize;
+    info.Errors.resize(numberOfBlocks, 0);
+
+    vtkNew<vtkMultiThreader> threader;
+    int numberOfThreads = this->NumberOfThreads > 0 ?
+      this->NumberOfThreads : threader->GetNumberOfThreads();
+    numberOfThreads = std::max(1, std::min(numberOfThreads,
+                                           static_cast<int>(numberOfBlocks)));
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(DecompressGzipBlocksThread, &info);
+    threader->SingleMethodExecute();
+    success = std::find(info.Errors.begin(), info.Errors.end(), 1) == info.Errors.end();
+    if (!success)
+      {
+      vtkWarningMacro("Read: Corrupted gzip block table in " << this->GetFileName()
+                      << ", falling back to sequential decompression");
+      }
+    }
+  if (success && nio->endian != airEndianUnknown && nio->endian != airMyEndian()
+      && nrrdElementSize(this->nrrd) > 1)
+    {
+    nrrdSwapEndian(this->nrrd);
+    }
+  if (!success)
+    {
+    nrrdEmpty(this->nrrd);
+    }
+  nio = nrrdIoStateNix(nio);
+  return success;
+}
+
 //----------------------------------------------------------------------------
 // This function reads a data from a file.  The datas extent/axes
 // are assumed to be the same as the file extent/order.
@@ -869,7 +1079,8 @@ void vtkNRRDReader::ExecuteDataWithInformation(vtkDataObject *output, vtkInforma
 
   // Read in the nrrd.  Yes, this means that the header is being read
   // twice: once by ExecuteInformation, and once here
-  if ( nrrdLoad(this->nrrd, this->GetFileName(), NULL) != 0 )
+  if ( !this->ReadParallelGzip() &&
+       nrrdLoad(this->nrrd, this->GetFileName(), NULL) != 0 )
     {
     char *err =  biffGetDone(NRRD); // would be nice to free(err)
     vtkErrorMacro("Read: Error reading "
@@ -31,6 +31,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <iostream>
 
 #include "vtkTeemConfigure.h"
@@ -121,6 +122,26 @@ public:
   vtkGetMacro(NumberOfComponents,int);
 
 
+  ///
+  /// If on (default), files written by vtkNRRDWriter with parallel
+  /// compression are decompressed block by block in multiple threads.
+  /// Other gzip encoded files are always read by teem in a single thread.
+  vtkSetMacro(UseParallelDecompression,int);
+  vtkGetMacro(UseParallelDecompression,int);
+  vtkBooleanMacro(UseParallelDecompression,int);
+
+  ///
+  /// Number of threads used for parallel decompression.
+  /// 0 (default) uses vtkMultiThreader's default number of threads.
+  vtkSetClampMacro(NumberOfThreads,int,0,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
+  ///
+  /// Header keys of the gzip block table written by vtkNRRDWriter
+  /// in parallel compression mode. They are not reported as header keys.
+  static const char* GetGzipBlockSizeKey() { return "SRPlan_gzip_block_size"; }
+  static const char* GetGzipMemberSizesKey() { return "SRPlan_gzip_member_sizes"; }
+
   ///
   /// Use image origin from the file
   void SetUseNativeOriginOn()
@@ -243,14 +264,26 @@ protected:
   int DataType;
   int NumberOfComponents;
   bool UseNativeOrigin;
+  int UseParallelDecompression;
+  int NumberOfThreads;
 
   std::map <std::string, std::string> HeaderKeyValue;
 
+  /// Gzip block table read from the header, empty if the file was not
+  /// written with parallel compression
+  size_t GzipBlockSize;
+  std::vector<size_t> GzipMemberSizes;
+
   virtual void ExecuteInformation();
   virtual void ExecuteDataWithInformation(vtkDataObject *output, vtkInformation* outInfo);
 
   int tenSpaceDirectionReduce(Nrrd *nout, const Nrrd *nin, double SD[9]);
 
+  /// Load this->nrrd decompressing the gzip members in parallel.
+  /// Return false if the file has no usable block table, in which case
+  /// the caller must fall back to nrrdLoad.
+  bool ReadParallelGzip();
+
 private:
   vtkNRRDReader(const vtkNRRDReader&);  /// Not implemented.
   void operator=(const vtkNRRDReader&);  /// Not implemented.
@@ -1,5 +1,10 @@
+#include <algorithm>
+#include <limits>
 #include <map>
+#include <sstream>
+#include <vector>
 
+#include "vtkNRRDReader.h"
 #include "vtkNRRDWriter.h"
 
 
@@ -7,7 +12,10 @@
 #include "vtkPointData.h"
 #include "vtkObjectFactory.h"
 #include "vtkInformation.h"
+#include <vtkNew.h>
 #include <vtkVersion.h>
+#include <vtk_zlib.h>
+#include <vtksys/SystemTools.hxx>
 
 class AttributeMapType: public std::map<std::string, std::string> {};
 
@@ -22,6 +30,10 @@ vtkNRRDWriter::vtkNRRDWriter()
   this->IJKToRASMatrix = vtkMatrix4x4::New();
   this->MeasurementFrameMatrix = vtkMatrix4x4::New();
   this->UseCompression = 1;
+  this->CompressionLevel = -1;
+  this->UseParallelCompression = 0;
+  this->CompressionBlockSize = 1 << 20;
+  this->NumberOfThreads = 0;
   this->DiffusionWeigthedData = 0;
   this->FileType = VTK_BINARY;
   this->WriteErrorOff();
@@ -184,6 +196,181 @@ int vtkNRRDWriter::VTKToNrrdPixelType( const int vtkPixelType )
   }
 
 
+//----------------------------------------------------------------------------
+namespace
+{
+struct GzipBlocksInfo
+{
+  const unsigned char *Buffer;
+  size_t BufferSize;
+  size_t BlockSize;
+  int Level;
+  std::vector< std::vector<unsigned char> > Members;
+  std::vector<int> Errors;
+};
+
+//----------------------------------------------------------------------------
+// Compress one block as a complete gzip member (header, deflate stream and
+// trailer) so that members can simply be concatenated.
+bool CompressGzipMember(const unsigned char *in, size_t inSize, int level,
+                        std::vector<unsigned char> &out)
+{
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  // 15 + 16: maximum window size with a gzip wrapper
+  if (deflateInit2(&strm, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    return false;
+    }
+  if (inSize <= static_cast<size_t>(std::numeric_limits<uLong>::max()))
+    {
+    out.resize(deflateBound(&strm, static_cast<uLong>(inSize)) + 32);
+    }
+  else
+    {
+    out.resize(inSize + inSize / 1000 + 1024);
+    }
+  // zlib counts the available bytes in uInt, blocks of 4 GB or more are
+  // passed in chunks
+  const size_t maxChunkSize = std::numeric_limits<uInt>::max();
+  strm.next_in = const_cast<Bytef*>(in);
+  size_t consumed = 0;
+  size_t written = 0;
+  int res = Z_OK;
+  while (res == Z_OK)
+    {
+    if (strm.avail_in == 0 && consumed < inSize)
+      {
+      size_t chunkSize = std::min(inSize - consumed, maxChunkSize);
+      strm.avail_in = static_cast<uInt>(chunkSize);
+      consumed += chunkSize;
+      }
+    if (written == out.size())
+      {
+      // the bound was exceeded, which zlib only allows for chunked input
+      out.resize(out.size() + out.size() / 2 + 1024);
+      }
+    size_t outChunkSize = std::min(out.size() - written, maxChunkSize);
+    strm.next_out = &out[written];
+    strm.avail_out = static_cast<uInt>(outChunkSize);
+    res = deflate(&strm, consumed == inSize ? Z_FINISH : Z_NO_FLUSH);
+    written += outChunkSize - strm.avail_out;
+    }
+  deflateEnd(&strm);
+  if (res != Z_STREAM_END)
+    {
+    return false;
+    }
+  out.resize(written);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE CompressGzipBlocksThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  GzipBlocksInfo *info = static_cast<GzipBlocksInfo*>(threadInfo->UserData);
+  size_t numberOfBlocks = info->Members.size();
+  for (size_t block = threadInfo->ThreadID; block < numberOfBlocks;
+       block += threadInfo->NumberOfThreads)
+    {
+    size_t start = block * info->BlockSize;
+    size_t size = std::min(info->BlockSize, info->BufferSize - start);
+    if (!CompressGzipMember(info->Buffer + start, size, info->Level,
+                            info->Members[block]))
+      {
+      info->Errors[block] = 1;
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//----------------------------------------------------------------------------
+bool vtkNRRDWriter::WriteParallelGzip(Nrrd *nrrd, NrrdIoState *nio, void *buffer)
+{
+  GzipBlocksInfo info;
+  info.Buffer = static_cast<const unsigned char*>(buffer);
+  info.BufferSize = nrrdElementSize(nrrd) * nrrdElementNumber(nrrd);
+  info.BlockSize = static_cast<size_t>(this->CompressionBlockSize);
+  info.Level = this->CompressionLevel;
+  size_t numberOfBlocks = (info.BufferSize + info.BlockSize - 1) / info.BlockSize;
+  info.Members.resize(numberOfBlocks);
+  info.Errors.resize(numberOfBlocks, 0);
+
+  vtkNew<vtkMultiThreader> threader;
+  int numberOfThreads = this->NumberOfThreads > 0 ?
+    this->NumberOfThreads : threader->GetNumberOfThreads();
+  numberOfThreads = std::max(1, std::min(numberOfThreads,
+                                         static_cast<int>(numberOfBlocks)));
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(CompressGzipBlocksThread, &info);
+  threader->SingleMethodExecute();
+
+  std::stringstream memberSizes;
+  for (size_t block = 0; block < numberOfBlocks; ++block)
+    {
+    if (info.Errors[block])
+      {
+      vtkErrorMacro("Write: Error compressing block " << block << " of "
+                    << this->GetFileName());
+      return false;
+      }
+    memberSizes << (block ? " " : "") << info.Members[block].size();
+    }
+  std::stringstream blockSize;
+  blockSize << info.BlockSize;
+  nrrdKeyValueAdd(nrrd, vtkNRRDReader::GetGzipBlockSizeKey(), blockSize.str().c_str());
+  nrrdKeyValueAdd(nrrd, vtkNRRDReader::GetGzipMemberSizesKey(), memberSizes.str().c_str());
+
+  // Let teem write the header only, the data is appended below
+  nio->encoding = nrrdEncodingGzip;
+  nrrdIoStateSet(nio, nrrdIoStateSkipData, AIR_TRUE);
+  if (nrrdSave(this->GetFileName(), nrrd, nio))
+    {
+    char *err = biffGetDone(NRRD); // would be nice to free(err)
+    vtkErrorMacro("Write: Error writing "
+                      << this->GetFileName() << ":\n" << err);
+    return false;
+    }
+
+  // Attached header: data follows the header in the same file.
+  // Detached header: teem names the data file, it is relative to the header.
+  std::string dataFileName = this->GetFileName();
+  if (nio->detachedHeader)
+    {
+    if (nio->dataFNArr->len != 1)
+      {
+      vtkErrorMacro("Write: Unexpected number of data files for " << this->GetFileName());
+      return false;
+      }
+    dataFileName = nio->dataFN[0];
+    if (!vtksys::SystemTools::FileIsFullPath(dataFileName.c_str()))
+      {
+      dataFileName = vtksys::SystemTools::GetFilenamePath(this->GetFileName())
+        + "/" + dataFileName;
+      }
+    }
+  FILE *file = fopen(dataFileName.c_str(), nio->detachedHeader ? "wb" : "ab");
+  if (!file)
+    {
+    vtkErrorMacro("Write: Cannot open " << dataFileName << " for writing");
+    return false;
+    }
+  bool success = true;
+  for (size_t block = 0; block < numberOfBlocks && success; ++block)
+    {
+    const std::vector<unsigned char> &member = info.Members[block];
+    success = (fwrite(&member[0], 1, member.size(), file) == member.size());
+    }
+  if (fclose(file) != 0 || !success)
+    {
+    vtkErrorMacro("Write: Error writing compressed data to " << dataFileName);
+    return false;
+    }
+  return true;
+}
 
 //----------------------------------------------------------------------------
 // Writes all the data from the input.
@@ -272,6 +459,12 @@ void vtkNRRDWriter::WriteData()
   AttributeMapType::iterator ait;
   for (ait = this->Attributes->begin(); ait != this->Attributes->end(); ++ait)
     {
+    // block table of a previously read file is stale, never write it back
+    if (ait->first == vtkNRRDReader::GetGzipBlockSizeKey() ||
+        ait->first == vtkNRRDReader::GetGzipMemberSizesKey())
+      {
+      continue;
+      }
     nrrdKeyValueAdd(nrrd, (*ait).first.c_str(), (*ait).second.c_str());
     }
 
@@ -326,11 +519,27 @@ void vtkNRRDWriter::WriteData()
       }
     }
 
+  // set endianness as unknown of output
+  nio->endian = airEndianUnknown;
+
+  if ( this->GetUseCompression() && this->GetUseParallelCompression() )
+    {
+    if (!this->WriteParallelGzip(nrrd, nio, buffer))
+      {
+      this->WriteErrorOn();
+      }
+    // Free the nrrd struct but don't touch nrrd->data
+    nrrd = nrrdNix(nrrd);
+    nio = nrrdIoStateNix(nio);
+    return;
+    }
+
   // set encoding for data: compressed (raw), (uncompressed) raw, or ascii
   if ( this->GetUseCompression() && nrrdEncodingGzip->available() )
     {
     // this is necessarily gzip-compressed *raw* data
     nio->encoding = nrrdEncodingGzip;
+    nio->zlibLevel = this->CompressionLevel;
     }
   else
     {
@@ -347,9 +556,6 @@ void vtkNRRDWriter::WriteData()
       }
     }
 
-  // set endianness as unknown of output
-  nio->endian = airEndianUnknown;
-
   // Write the nrrd to file.
   if (nrrdSave(this->GetFileName(), nrrd, nio))
     {
@@ -372,6 +578,11 @@ void vtkNRRDWriter::PrintSelf(ostream& os, vtkIndent indent)
      this->IJKToRASMatrix->PrintSelf(os,indent);
   os << indent << "Measurement frame: ";
      this->MeasurementFrameMatrix->PrintSelf(os,indent);
+  os << indent << "UseCompression: " << this->UseCompression << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
+  os << indent << "UseParallelCompression: " << this->UseParallelCompression << "\n";
+  os << indent << "CompressionBlockSize: " << this->CompressionBlockSize << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
 
 void vtkNRRDWriter::SetAttribute(const std::string& name, const std::string& value)
@@ -6,6 +6,7 @@
 
 #include "vtkMatrix4x4.h"
 #include "vtkDoubleArray.h"
+#include "vtkMultiThreader.h"
 #include "teem/nrrd.h"
 
 #include "vtkTeemConfigure.h"
@@ -53,6 +54,34 @@ public:
   vtkGetMacro(UseCompression,int);
   vtkBooleanMacro(UseCompression,int);
 
+  ///
+  /// Compression level passed to zlib, from 0 (no compression) to 9
+  /// (best compression). -1 selects the zlib default (6).
+  vtkSetClampMacro(CompressionLevel,int,-1,9);
+  vtkGetMacro(CompressionLevel,int);
+
+  ///
+  /// If on (and UseCompression is on), the voxel buffer is split into
+  /// blocks of CompressionBlockSize bytes that are gzip-compressed
+  /// concurrently and written as consecutive gzip members. The result
+  /// is a regular gzip stream that any NRRD reader can decode; the
+  /// size of each member is stored in the header so that vtkNRRDReader
+  /// can decompress the blocks in parallel too.
+  vtkSetMacro(UseParallelCompression,int);
+  vtkGetMacro(UseParallelCompression,int);
+  vtkBooleanMacro(UseParallelCompression,int);
+
+  ///
+  /// Number of uncompressed bytes per gzip member (default 1MB).
+  vtkSetClampMacro(CompressionBlockSize,vtkIdType,4096,VTK_ID_MAX);
+  vtkGetMacro(CompressionBlockSize,vtkIdType);
+
+  ///
+  /// Number of threads used for parallel compression.
+  /// 0 (default) uses vtkMultiThreader's default number of threads.
+  vtkSetClampMacro(NumberOfThreads,int,0,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
   vtkSetClampMacro(FileType,int,VTK_ASCII,VTK_BINARY);
   vtkGetMacro(FileType,int);
   void SetFileTypeToASCII() {this->SetFileType(VTK_ASCII);};
@@ -90,6 +119,10 @@ protected:
   vtkMatrix4x4 *MeasurementFrameMatrix;
 
   int UseCompression;
+  int CompressionLevel;
+  int UseParallelCompression;
+  vtkIdType CompressionBlockSize;
+  int NumberOfThreads;
   int FileType;
 
   AttributeMapType *Attributes;
@@ -99,6 +132,10 @@ private:
   void operator=(const vtkNRRDWriter&);  /// Not implemented.
   void vtkImageDataInfoToNrrdInfo(vtkImageData *in, int &nrrdKind, size_t &numComp, int &vtkType, void **buffer);
   int VTKToNrrdPixelType( const int vtkPixelType );
+  /// Compress buffer in independent gzip members, write the block
+  /// table into the header and append the members after it.
+  /// Return false if the data could not be written.
+  bool WriteParallelGzip(Nrrd *nrrd, NrrdIoState *nio, void *buffer);
   int DiffusionWeigthedData;
 };
 
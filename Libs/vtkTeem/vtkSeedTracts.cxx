@@ -20,6 +20,9 @@
 #include <vtkAlgorithmOutput.h>
 #include <vtkCellArray.h>
 #include <vtkCommand.h>
+#include <vtkCriticalSection.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
 #include <vtkInformation.h>
 #include <vtkMath.h>
 #include <vtkNew.h>
@@ -31,6 +34,7 @@
 #include <vtkVersion.h>
 
 // STD includes
+#include <algorithm>
 #include <sstream>
 
 //----------------------------------------------------------------------------
@@ -79,6 +83,9 @@ vtkSeedTracts::vtkSeedTracts()
   this->FilePrefix = NULL;
   this->UseStartingThreshold = 0;
   this->StartingThreshold = 0;
+
+  this->UseParallelSeeding = 1;
+  this->NumberOfThreads = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -463,6 +470,251 @@ void vtkSeedTracts::SeedStreamlineFromPoint(double x,
   //newStreamline->Delete();
 }
 
+namespace
+{
+/// Number of seeds a thread takes from the pool at once
+const size_t SeedsPerChunk = 16;
+
+//----------------------------------------------------------------------------
+struct IntegrateSeedsInfo
+{
+  vtkSeedTracts *Self;
+  const std::vector<double> *Seeds;
+  std::vector<vtkHyperStreamlineDTMRI*> *Streamlines;
+  std::vector<vtkImageData*> TensorFields;
+
+  bool IntersectWithROI2;
+  const short *ROI2Scalars;
+  int ROI2Extent[6];
+  vtkIdType ROI2Increments[3];
+  int ROI2Value;
+  /// Tensor scaled ijk to ROI2 ijk
+  double TensorToROI2[4][4];
+
+  vtkSimpleCriticalSection Lock;
+  size_t NextSeed;
+};
+
+//----------------------------------------------------------------------------
+bool StreamlineIntersectsROI2(vtkPolyData *path, const IntegrateSeedsInfo *info)
+{
+  vtkPoints *points = path->GetPoints();
+  if (!points || !info->ROI2Scalars)
+    {
+    return false;
+    }
+  const double (*m)[4] = info->TensorToROI2;
+  double point[3];
+  for (vtkIdType ptidx = 0; ptidx < points->GetNumberOfPoints(); ++ptidx)
+    {
+    points->GetPoint(ptidx, point);
+    int pt[3];
+    bool inside = true;
+    for (int i = 0; i < 3; ++i)
+      {
+      double x = m[i][0] * point[0] + m[i][1] * point[1] + m[i][2] * point[2] + m[i][3];
+      pt[i] = static_cast<int>(floor(x + 0.5));
+      inside = inside && pt[i] >= info->ROI2Extent[2 * i] && pt[i] <= info->ROI2Extent[2 * i + 1];
+      }
+    if (!inside)
+      {
+      continue;
+      }
+    const short *value = info->ROI2Scalars
+      + (pt[0] - info->ROI2Extent[0]) * info->ROI2Increments[0]
+      + (pt[1] - info->ROI2Extent[2]) * info->ROI2Increments[1]
+      + (pt[2] - info->ROI2Extent[4]) * info->ROI2Increments[2];
+    if (*value == info->ROI2Value)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+struct AppendStreamlinesInfo
+{
+  std::vector<vtkPolyData*> Paths;
+  /// Offsets of each path in the output points and connectivity
+  std::vector<vtkIdType> PointOffsets;
+  std::vector<vtkIdType> ConnectivityOffsets;
+  double PointTransform[4][4];
+  double TensorRotation[3][3];
+  float *Points;
+  vtkIdType *Connectivity;
+  float *Tensors;
+};
+}
+
+//----------------------------------------------------------------------------
+int vtkSeedTracts::GetNumberOfThreadsToUse(int numberOfItems)
+{
+  int numberOfThreads = this->NumberOfThreads > 0 ?
+    this->NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  return std::max(1, std::min(numberOfThreads, numberOfItems));
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSeedTracts::IntegrateSeedsThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  IntegrateSeedsInfo *info = static_cast<IntegrateSeedsInfo*>(threadInfo->UserData);
+  vtkSeedTracts *self = info->Self;
+  vtkImageData *tensorField = info->TensorFields[threadInfo->ThreadID];
+  const std::vector<double>& seeds = *info->Seeds;
+  const size_t numberOfSeeds = seeds.size() / 3;
+
+  while (true)
+    {
+    size_t first, last;
+    info->Lock.Lock();
+    first = info->NextSeed;
+    last = std::min(first + SeedsPerChunk, numberOfSeeds);
+    info->NextSeed = last;
+    info->Lock.Unlock();
+    if (first >= numberOfSeeds)
+      {
+      break;
+      }
+    // the first thread runs in the calling thread, it reports progress
+    if (threadInfo->ThreadID == 0)
+      {
+      double progress = static_cast<double>(first) / numberOfSeeds;
+      self->InvokeEvent(vtkCommand::ProgressEvent, (void *)&progress);
+      }
+    for (size_t seed = first; seed < last; ++seed)
+      {
+      info->Lock.Lock();
+      vtkHyperStreamline *createdStreamline = self->CreateHyperStreamline();
+      info->Lock.Unlock();
+      vtkHyperStreamlineDTMRI *newStreamline =
+        vtkHyperStreamlineDTMRI::SafeDownCast(createdStreamline);
+      if (!newStreamline)
+        {
+        // only the vtkHyperStreamlineDTMRI streamlines are seeded in parallel
+        if (createdStreamline)
+          {
+          createdStreamline->Delete();
+          }
+        continue;
+        }
+
+      // Each thread integrates in its own copy of the tensor field, the
+      // cells returned by vtkImageData::GetCell are not shared.
+      newStreamline->SetInputData(tensorField);
+      newStreamline->SetStartPosition(seeds[3 * seed], seeds[3 * seed + 1], seeds[3 * seed + 2]);
+      if (!info->IntersectWithROI2)
+        {
+        newStreamline->OutputTensorsOn();
+        newStreamline->OneTrajectoryPerSeedPointOn();
+        }
+      newStreamline->Update();
+
+      bool keep = false;
+      if (info->IntersectWithROI2)
+        {
+        keep = StreamlineIntersectsROI2(newStreamline->GetOutput(), info);
+        }
+      else
+        {
+        double length =
+          (newStreamline->GetOutput()->GetNumberOfPoints() - 1) *
+          newStreamline->GetIntegrationStepLength();
+        keep = (length > self->MinimumPathLength);
+        }
+      if (keep)
+        {
+        (*info->Streamlines)[seed] = newStreamline;
+        }
+      else
+        {
+        newStreamline->Delete();
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkSeedTracts::IntegrateSeedsInParallel(const std::vector<double>& seeds,
+                                             bool intersectWithROI2,
+                                             std::vector<vtkHyperStreamlineDTMRI*>& streamlines)
+{
+  const int numberOfSeeds = static_cast<int>(seeds.size() / 3);
+  streamlines.assign(numberOfSeeds, static_cast<vtkHyperStreamlineDTMRI*>(NULL));
+  if (numberOfSeeds == 0)
+    {
+    return;
+    }
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+
+  IntegrateSeedsInfo info;
+  info.Self = this;
+  info.Seeds = &seeds;
+  info.Streamlines = &streamlines;
+  info.NextSeed = 0;
+  info.IntersectWithROI2 = intersectWithROI2;
+  info.ROI2Scalars = NULL;
+  info.ROI2Value = this->InputROI2Value;
+  if (intersectWithROI2)
+    {
+    vtkImageData* inputROI2 = vtkImageData::SafeDownCast(this->InputROIConnection2->GetProducer()->GetOutputDataObject(0));
+    inputROI2->GetExtent(info.ROI2Extent);
+    inputROI2->GetIncrements(info.ROI2Increments);
+    info.ROI2Scalars = static_cast<short*>(inputROI2->GetScalarPointer());
+
+    vtkNew<vtkMatrix4x4> worldToROI2;
+    vtkMatrix4x4::Invert(this->ROI2ToWorld->GetMatrix(), worldToROI2.GetPointer());
+    vtkNew<vtkMatrix4x4> tensorToWorld;
+    vtkMatrix4x4::Invert(this->WorldToTensorScaledIJK->GetMatrix(), tensorToWorld.GetPointer());
+    vtkNew<vtkMatrix4x4> tensorToROI2;
+    vtkMatrix4x4::Multiply4x4(worldToROI2.GetPointer(), tensorToWorld.GetPointer(), tensorToROI2.GetPointer());
+    for (int i = 0; i < 4; ++i)
+      {
+      for (int j = 0; j < 4; ++j)
+        {
+        info.TensorToROI2[i][j] = tensorToROI2->GetElement(i, j);
+        }
+      }
+    }
+
+  // The input is updated once here, the threads only read its arrays
+  vtkAlgorithm* producer = this->InputTensorFieldConnection->GetProducer();
+  producer->Update();
+  vtkImageData* inputTensorField = vtkImageData::SafeDownCast(producer->GetOutputDataObject(0));
+
+  int numberOfThreads = this->GetNumberOfThreadsToUse(
+    (numberOfSeeds + static_cast<int>(SeedsPerChunk) - 1) / static_cast<int>(SeedsPerChunk));
+  for (int thread = 0; thread < numberOfThreads; ++thread)
+    {
+    vtkImageData *tensorField = vtkImageData::New();
+    tensorField->ShallowCopy(inputTensorField);
+    info.TensorFields.push_back(tensorField);
+    }
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(vtkSeedTracts::IntegrateSeedsThread, &info);
+  threader->SingleMethodExecute();
+
+  // the kept streamlines hold a reference to their copy
+  for (int thread = 0; thread < numberOfThreads; ++thread)
+    {
+    info.TensorFields[thread]->Delete();
+    }
+
+  double progress = 1.;
+  this->InvokeEvent(vtkCommand::ProgressEvent, (void *)&progress);
+
+  timer->StopTimer();
+  vtkDebugMacro("Integrated " << numberOfSeeds << " seeds with " << numberOfThreads
+                << " threads in " << timer->GetElapsedTime() << "s");
+}
+
 // Seed in an ROI using a continous grid with the resolution given by
 //this->IsotropicSeedingResolution.
 //----------------------------------------------------------------------------
@@ -574,6 +826,12 @@ void vtkSeedTracts::SeedStreamlinesInROI()
 
   vtkImageData* inputROI = vtkImageData::SafeDownCast(this->InputROIConnection->GetProducer()->GetOutputDataObject(0));
 
+  // In parallel, the seeds are collected first and integrated afterwards
+  bool parallel = this->UseParallelSeeding &&
+    this->TypeOfHyperStreamline == USE_VTK_HYPERSTREAMLINE_POINTS &&
+    this->GetNumberOfThreadsToUse(VTK_INT_MAX) > 1;
+  std::vector<double> seeds;
+
   for (idxZ = 0; idxZ <= maxZ; idxZ+=gridIncZ)
     {
       // just output (fractional or integer) current slice number
@@ -665,6 +923,12 @@ void vtkSeedTracts::SeedStreamlinesInROI()
                         }
                       } // end if (UseStartingThreshold)
 
+                      if (parallel)
+                        {
+                        seeds.insert(seeds.end(), point, point + 3);
+                        continue;
+                        }
+
                       // Report progress
                       if (numLabelVoxels && progressCount == progressCountMax)
                         {
@@ -741,6 +1005,43 @@ void vtkSeedTracts::SeedStreamlinesInROI()
 
     }
 
+  if (!parallel)
+    {
+    return;
+    }
+
+  // Keep the streamlines in seed order, as they would be sequentially
+  std::vector<vtkHyperStreamlineDTMRI*> streamlines;
+  this->IntegrateSeedsInParallel(seeds, false, streamlines);
+  for (size_t seed = 0; seed < streamlines.size(); ++seed)
+    {
+    newStreamline = streamlines[seed];
+    if (!newStreamline)
+      {
+      continue;
+      }
+    if (this->FileDirectoryName)
+      {
+      if (this->FilePrefix == NULL)
+        {
+        this->SetFilePrefix("line");
+        }
+      transformer->SetInputConnection(newStreamline->GetOutputPort());
+      writer->SetInputConnection(transformer->GetOutputPort());
+      writer->SetFileType(2);
+
+      std::stringstream fileNameStr;
+      fileNameStr << FileDirectoryName << "/" << FilePrefix << '_' << idx << ".vtk";
+      writer->SetFileName(fileNameStr.str().c_str());
+      writer->Write();
+      newStreamline->Delete();
+      }
+    else
+      {
+      this->Streamlines->AddItem((vtkObject *) newStreamline);
+      }
+    idx++;
+    }
 }
 
 
@@ -788,6 +1089,97 @@ void vtkSeedTracts::SeedStreamlinesInROIWithMultipleValues()
   this->InputROIValue = initialROIValue;
 }
 
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSeedTracts::AppendStreamlinesThread(void *arg)
+{
+  vtkMultiThreader::ThreadInfo *threadInfo =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  AppendStreamlinesInfo *info = static_cast<AppendStreamlinesInfo*>(threadInfo->UserData);
+  const double (*m)[4] = info->PointTransform;
+  const double (*r)[3] = info->TensorRotation;
+  double rotationTranspose[3][3];
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      rotationTranspose[row][col] = r[col][row];
+      }
+    }
+
+  // each path is written at its own offsets, the threads never overlap
+  for (size_t path = threadInfo->ThreadID; path < info->Paths.size();
+       path += threadInfo->NumberOfThreads)
+    {
+    vtkPolyData *streamline = info->Paths[path];
+    vtkPoints *points = streamline->GetPoints();
+    vtkIdType numPts = points ? points->GetNumberOfPoints() : 0;
+    vtkIdType pointOffset = info->PointOffsets[path];
+
+    // transform the points to RAS
+    double point[3];
+    float *outPoint = info->Points + 3 * pointOffset;
+    for (vtkIdType k = 0; k < numPts; k++, outPoint += 3)
+      {
+      points->GetPoint(k, point);
+      for (int i = 0; i < 3; i++)
+        {
+        outPoint[i] = static_cast<float>(
+          m[i][0] * point[0] + m[i][1] * point[1] + m[i][2] * point[2] + m[i][3]);
+        }
+      }
+
+    // copy the lines, shifting the point ids
+    vtkIdTypeArray *lines = streamline->GetLines()->GetData();
+    const vtkIdType *inCell = lines->GetPointer(0);
+    vtkIdType size = lines->GetNumberOfTuples();
+    vtkIdType *outCell = info->Connectivity + info->ConnectivityOffsets[path];
+    for (vtkIdType k = 0; k < size; )
+      {
+      vtkIdType npts = inCell[k];
+      outCell[k] = npts;
+      for (vtkIdType j = 1; j <= npts; j++)
+        {
+        outCell[k + j] = inCell[k + j] + pointOffset;
+        }
+      k += npts + 1;
+      }
+
+    // rotate the tensors into the same (world) coordinate system: R T R'
+    vtkDataArray *oldTensors = streamline->GetPointData()->GetTensors();
+    double tensor[9];
+    double tensor3x3[3][3];
+    double temp3x3[3][3];
+    float *outTensor = info->Tensors + 9 * pointOffset;
+    for (vtkIdType ii = 0; ii < numPts; ii++, outTensor += 9)
+      {
+      if (!oldTensors)
+        {
+        std::fill(outTensor, outTensor + 9, 0.f);
+        continue;
+        }
+      oldTensors->GetTuple(ii, tensor);
+      for (int row = 0; row < 3; row++)
+        {
+        for (int col = 0; col < 3; col++)
+          {
+          tensor3x3[row][col] = tensor[3 * row + col];
+          }
+        }
+      vtkMath::Multiply3x3(r, tensor3x3, temp3x3);
+      vtkMath::Multiply3x3(temp3x3, rotationTranspose, tensor3x3);
+      for (int row = 0; row < 3; row++)
+        {
+        for (int col = 0; col < 3; col++)
+          {
+          outTensor[3 * row + col] = static_cast<float>(tensor3x3[row][col]);
+          }
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
 void vtkSeedTracts::TransformStreamlinesToRASAndAppendToPolyData(vtkPolyData *outFibers)
   {
 
@@ -797,132 +1189,74 @@ void vtkSeedTracts::TransformStreamlinesToRASAndAppendToPolyData(vtkPolyData *ou
     return;
     }
 
-  // Create transformation matrix to place actors in scene
-  // This is used to transform the models before writing them to disk
-  vtkNew<vtkTransform> transform;
-  transform->SetMatrix(this->WorldToTensorScaledIJK->GetMatrix());
-  transform->Inverse();
-
-  vtkNew<vtkTransformPolyDataFilter> transformer;
-  transformer->SetTransform(transform.GetPointer());
+  AppendStreamlinesInfo info;
 
   vtkHyperStreamline *streamline;
-  int npts = 0;
-  int ncells = 0;
+  vtkIdType npts = 0;
+  vtkIdType ncells = 0;
+  vtkIdType nconnectivity = 0;
   //Loop through the collection and gather total number of points
   for (int i=0; i<this->Streamlines->GetNumberOfItems(); i++)
     {
     streamline = static_cast<vtkHyperStreamline*> (this->Streamlines->GetItemAsObject(i));
-    npts += streamline->GetOutput()->GetNumberOfPoints();
-    ncells += streamline->GetOutput()->GetNumberOfLines();
+    streamline->Update();
+    vtkPolyData *path = streamline->GetOutput();
+    info.Paths.push_back(path);
+    info.PointOffsets.push_back(npts);
+    info.ConnectivityOffsets.push_back(nconnectivity);
+    npts += path->GetNumberOfPoints();
+    ncells += path->GetNumberOfLines();
+    nconnectivity += path->GetLines()->GetData()->GetNumberOfTuples();
     }
   if (npts == 0 || ncells == 0)
     {
     return;
     }
 
-  //Preallocate PolyData elements
+  // Create transformation matrix to place actors in scene
+  vtkNew<vtkMatrix4x4> tensorToWorld;
+  vtkMatrix4x4::Invert(this->WorldToTensorScaledIJK->GetMatrix(), tensorToWorld.GetPointer());
+  for (int row = 0; row < 4; row++)
+    {
+    for (int col = 0; col < 4; col++)
+      {
+      info.PointTransform[row][col] = tensorToWorld->GetElement(row, col);
+      }
+    }
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      info.TensorRotation[row][col] = this->TensorRotationMatrix->GetElement(row, col);
+      }
+    }
+
+  //Preallocate PolyData elements, each streamline is then written at its
+  //offset so the output does not depend on the number of threads
   vtkNew<vtkPoints> points;
+  points->SetDataTypeToFloat();
+  points->SetNumberOfPoints(npts);
   outFibers->SetPoints(points.GetPointer());
-  //outFibers->GetPoints()->SetNumberOfPoints(npts);
+  info.Points = static_cast<vtkFloatArray*>(points->GetData())->GetPointer(0);
 
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfTuples(nconnectivity);
   vtkNew<vtkCellArray> outFibersCellArray;
+  outFibersCellArray->SetCells(ncells, connectivity.GetPointer());
   outFibers->SetLines(outFibersCellArray.GetPointer());
-  outFibersCellArray->SetNumberOfCells(this->Streamlines->GetNumberOfItems());
-
-  vtkIdTypeArray *cellArray = outFibersCellArray->GetData();
-  cellArray->SetNumberOfTuples(npts+ncells);
+  info.Connectivity = connectivity->GetPointer(0);
 
   vtkNew<vtkFloatArray> newTensors;
   newTensors->SetNumberOfComponents(9);
-  newTensors->Allocate(9*npts);
+  newTensors->SetNumberOfTuples(npts);
   outFibers->GetPointData()->SetTensors(newTensors.GetPointer());
+  info.Tensors = newTensors->GetPointer(0);
 
-  int ptId=0;
-  int cellId=0;
-  int ptOffset = 0;
-  vtkIdType cellIndex;
-  for (int i=0; i<this->Streamlines->GetNumberOfItems(); i++)
-    {
-    streamline = static_cast<vtkHyperStreamline*> (this->Streamlines->GetItemAsObject(i));
-    transformer->SetInputConnection(streamline->GetOutputPort());
-    transformer->Update();
-
-    // Fill points and cells
-    for (int k=0; k<transformer->GetOutput()->GetNumberOfPoints(); k++)
-      {
-      outFibers->GetPoints()->InsertNextPoint(transformer->GetOutput()->GetPoint(k));
-      ptId++;
-      }
-    vtkIdTypeArray *cellArrayTransf = transformer->GetOutput()->GetLines()->GetData();
-    cellIndex = cellArrayTransf->GetNumberOfTuples()-1;
-    cellArray->SetTupleValue(cellId, &cellIndex);
-    cellId++;
-    for (int k=1; k<cellArrayTransf->GetNumberOfTuples(); k++)
-      {
-      //cellArray->InsertNextValue(ptOffset+cellArrayTransf->GetValue(k));
-      cellIndex = ptOffset+cellArrayTransf->GetValue(k);
-      cellArray->SetTupleValue(cellId, &cellIndex);
-      cellId++;
-      }
-    ptOffset += transformer->GetOutput()->GetNumberOfPoints();
-
-    // transform any tensors as well (rotate them)
-    // this should be a vtk class but leave that for slicer3/vtk5
-    // Here we rotate the tensors into the same (world) coordinate system.
-    // -------------------------------------------------
-    vtkDebugMacro("Rotating tensors");
-    int numPts = transformer->GetOutput()->GetNumberOfPoints();
-
-    vtkDebugMacro("Rotating tensors: init");
-    double (*matrix)[4] = this->TensorRotationMatrix->Element;
-    double tensor[9];
-    double tensor3x3[3][3];
-    double temp3x3[3][3];
-    double matrix3x3[3][3];
-    double matrixTranspose3x3[3][3];
-    for (int row = 0; row < 3; row++)
-      {
-      for (int col = 0; col < 3; col++)
-        {
-          matrix3x3[row][col] = matrix[row][col];
-          matrixTranspose3x3[row][col] = matrix[col][row];
-        }
-      }
-
-     vtkDebugMacro("Rotating tensors: get tensors from probe");
-     vtkDataArray *oldTensors = transformer->GetOutput()->GetPointData()->GetTensors();
-     vtkDebugMacro("Rotating tensors: rotate");
-     for (vtkIdType ii = 0; ii < numPts; ii++)
-       {
-         oldTensors->GetTuple(ii,tensor);
-         int idx = 0;
-         for (int row = 0; row < 3; row++)
-           {
-             for (int col = 0; col < 3; col++)
-               {
-                 tensor3x3[row][col] = tensor[idx];
-                 idx++;
-               }
-           }
-         // rotate by our matrix
-         // R T R'
-         vtkMath::Multiply3x3(matrix3x3,tensor3x3,temp3x3);
-         vtkMath::Multiply3x3(temp3x3,matrixTranspose3x3,tensor3x3);
-         idx =0;
-         for (int row = 0; row < 3; row++)
-           {
-             for (int col = 0; col < 3; col++)
-                {
-                  tensor[idx] = tensor3x3[row][col];
-                  idx++;
-                }
-            }
-          newTensors->InsertNextTuple(tensor);
-        }
-    // End of tensor rotation code.
-    // -------------------------------------------------
-    }
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(this->GetNumberOfThreadsToUse(
+    static_cast<int>(info.Paths.size())));
+  threader->SetSingleMethod(vtkSeedTracts::AppendStreamlinesThread, &info);
+  threader->SingleMethodExecute();
 
   // Remove the scalars if any, we don't need
   // to save anything but the tensors
@@ -1017,6 +1351,12 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
   // testing for seeding at a certain resolution.
   int increment = 1;
 
+  // In parallel, the seeds are collected first and integrated afterwards
+  bool parallel = this->UseParallelSeeding &&
+    this->TypeOfHyperStreamline == USE_VTK_HYPERSTREAMLINE_POINTS &&
+    this->GetNumberOfThreadsToUse(VTK_INT_MAX) > 1;
+  std::vector<double> seeds;
+
   for (idxZ = 0; idxZ <= maxZ; idxZ++)
     {
       //for (idxY = 0; !this->AbortExecute && idxY <= maxY; idxY++)
@@ -1042,7 +1382,14 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
                   this->WorldToTensorScaledIJK->TransformPoint(point2,point);
 
                   // make sure it is within the bounds of the tensor dataset
-                  if (this->PointWithinTensorData(point,point2))
+                  if (parallel)
+                    {
+                      if (this->PointWithinTensorData(point,point2))
+                        {
+                          seeds.insert(seeds.end(), point, point + 3);
+                        }
+                    }
+                  else if (this->PointWithinTensorData(point,point2))
                     {
                       // Now create a streamline.
                       newStreamline=(vtkHyperStreamlineDTMRI *) this->CreateHyperStreamline();
@@ -1159,6 +1506,41 @@ void vtkSeedTracts::SeedStreamlinesFromROIIntersectWithROI2()
       inPtr += inIncZ;
     }
 
+  if (parallel)
+    {
+    // Keep the streamlines in seed order, as they would be sequentially
+    std::vector<vtkHyperStreamlineDTMRI*> streamlines;
+    this->IntegrateSeedsInParallel(seeds, true, streamlines);
+    for (size_t seed = 0; seed < streamlines.size(); ++seed)
+      {
+      newStreamline = streamlines[seed];
+      if (!newStreamline)
+        {
+        continue;
+        }
+      if (this->FileDirectoryName)
+        {
+        if (this->FilePrefix == NULL)
+          {
+          this->SetFilePrefix("line");
+          }
+        transformer->SetInputConnection(newStreamline->GetOutputPort());
+        writer->SetInputConnection(transformer->GetOutputPort());
+        writer->SetFileType(2);
+
+        std::stringstream fileNameStr;
+        fileNameStr << FileDirectoryName << "/" << FilePrefix << '_' << this->Streamlines->GetNumberOfItems()-1 << ".vtk";
+        writer->SetFileName(fileNameStr.str().c_str());
+        writer->Write();
+        }
+      else
+        {
+        this->Streamlines->AddItem((vtkObject *)newStreamline);
+        }
+      newStreamline->Delete();
+      }
+    }
+
   timer->StopTimer();
   std::cout << "Tractography in ROI time: " << timer->GetElapsedTime() << endl;
 }
@@ -25,6 +25,7 @@
 #include "vtkTransform.h"
 #include "vtkCollection.h"
 #include "vtkShortArray.h"
+#include "vtkMultiThreader.h"
 
 #include "vtkHyperStreamline.h"
 #include "vtkHyperStreamlineDTMRI.h"
@@ -36,6 +37,8 @@
 #define USE_VTK_PRECISE_HYPERSTREAMLINE_POINTS 2
 #define USE_VTK_HYPERSTREAMLINE_TEEM 3
 
+#include <vector>
+
 /// Individual streamlines can be started at a point, or
 /// many can be started inside a region of interest.
 class VTK_Teem_EXPORT vtkSeedTracts : public vtkObject
@@ -249,6 +252,22 @@ public:
   vtkGetMacro(UseStartingThreshold,int)
   vtkBooleanMacro(UseStartingThreshold,int)
 
+  ///
+  /// If on (default), the streamlines seeded in an ROI are integrated by a
+  /// pool of threads, each with its own copy of the tensor field. The
+  /// results are merged in seed order, so they do not depend on the number
+  /// of threads. Teem streamlines are always integrated in a single thread.
+  vtkSetMacro(UseParallelSeeding,int);
+  vtkGetMacro(UseParallelSeeding,int);
+  vtkBooleanMacro(UseParallelSeeding,int);
+
+  ///
+  /// Number of threads used for parallel seeding and for appending the
+  /// streamlines to a polydata.
+  /// 0 (default) uses vtkMultiThreader's default number of threads.
+  vtkSetClampMacro(NumberOfThreads,int,0,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
   ///
   /// A file directory name for lines
   vtkSetStringMacro(FileDirectoryName);
@@ -316,6 +335,24 @@ protected:
   void UpdateHyperStreamlinePointsSettings( vtkHyperStreamlineDTMRI *currHSP);
   void UpdateHyperStreamlineTeemSettings( vtkHyperStreamlineTeem *currHST);
 
+  int UseParallelSeeding;
+  int NumberOfThreads;
+
+  /// Number of threads to use for \a numberOfItems work items
+  int GetNumberOfThreadsToUse(int numberOfItems);
+
+  /// Integrate a streamline from each seed (3 scaled ijk coordinates of the
+  /// tensor field per seed) in parallel. The kept streamlines are returned
+  /// in seed order, NULL for the rejected ones. If \a intersectWithROI2
+  /// is true, streamlines are kept if they pass through InputROI2Value in
+  /// InputROI2, otherwise if they are longer than MinimumPathLength.
+  void IntegrateSeedsInParallel(const std::vector<double>& seeds,
+                                bool intersectWithROI2,
+                                std::vector<vtkHyperStreamlineDTMRI*>& streamlines);
+
+  static VTK_THREAD_RETURN_TYPE IntegrateSeedsThread(void *arg);
+  static VTK_THREAD_RETURN_TYPE AppendStreamlinesThread(void *arg);
+
 };
 
 #endif
@@ -1324,6 +1324,10 @@ void qSRPlanPathPlanModuleWidget::onAddMarkupPushButtonClicked()
 		// for debug added by zoulian
 		char * snakePathID = listNode->GetID();  
 		// for now, assume a fiducial  
+		if (listNode->GetScene())
+		  {
+		  listNode->GetScene()->SaveStateForUndo(listNode);
+		  }
 		listNode->AddMarkupWithNPoints(1);
     }
 
@@ -2648,7 +2652,10 @@ void qSRPlanPathPlanModuleWidget::onActiveMarkupTableCellChanged(int row, int co
       vtkMRMLMarkupsFiducialNode *fidList = vtkMRMLMarkupsFiducialNode::SafeDownCast(listNode);
       if (fidList)
         {
-        
+          if (fidList->GetScene())
+            {
+            fidList->GetScene()->SaveStateForUndo(fidList);
+            }
           fidList->SetNthFiducialPositionFromArray(n, newPoint);
          
         }
@@ -90,6 +90,7 @@ QStringList qSlicerMarkupsReader::extensions()const
 {
   return QStringList()
     << "Markups Fiducials (*.fcsv)"
+    << "Markups Fiducials Binary (*.mrkb)"
     << " Annotation Fiducial (*.acsv)";
 }
 
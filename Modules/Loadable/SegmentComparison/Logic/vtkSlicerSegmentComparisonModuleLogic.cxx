@@ -32,6 +32,7 @@
 // SlicerRT includes
 #include "PlmCommon.h"
 #include "SlicerRtCommon.h"
+#include "vtkLabelmapMarginFilter.h"
 
 // Plastimatch includes
 #include "dice_statistics.h"
@@ -43,13 +44,259 @@
 // MRML includes
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
 
 // VTK includes
 #include <vtkNew.h>
+#include <vtkDoubleArray.h>
 #include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkPointData.h>
+#include <vtkSimpleCriticalSection.h>
+#include <vtkStringArray.h>
+#include <vtkTable.h>
 #include <vtkTimerLog.h>
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+const unsigned char REFERENCE_BIT = 1;
+const unsigned char COMPARE_BIT = 2;
+const unsigned char REFERENCE_BOUNDARY_BIT = 4;
+const unsigned char COMPARE_BOUNDARY_BIT = 8;
+
+//----------------------------------------------------------------------------
+/// Set the bit in the mask voxels where the labelmap is non-zero. The labelmap extent is within the mask extent.
+template <class T>
+void AddSegmentToMask(T* labelmapPtr, int labelmapExtent[6], int maskExtent[6], unsigned char bit, unsigned char* mask)
+{
+  vtkIdType maskDimensions[3] = { maskExtent[1]-maskExtent[0]+1, maskExtent[3]-maskExtent[2]+1, maskExtent[5]-maskExtent[4]+1 };
+  for (int k = labelmapExtent[4]; k <= labelmapExtent[5]; ++k)
+  {
+    for (int j = labelmapExtent[2]; j <= labelmapExtent[3]; ++j)
+    {
+      unsigned char* maskPtr = mask + (labelmapExtent[0] - maskExtent[0])
+        + maskDimensions[0] * ((j - maskExtent[2]) + maskDimensions[1] * (k - maskExtent[4]));
+      for (int i = labelmapExtent[0]; i <= labelmapExtent[1]; ++i, ++maskPtr)
+      {
+        if (*(labelmapPtr++) != 0)
+        {
+          *maskPtr |= bit;
+        }
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+/// Maximum, mean and 95th percentile of distances. The order of the distances is changed.
+void ComputeDistanceStatistics(std::vector<float>& distances, double& maximum, double& average, double& percent95)
+{
+  maximum = average = percent95 = 0.0;
+  if (distances.empty())
+  {
+    return;
+  }
+  double sum = 0.0;
+  for (std::vector<float>::iterator distanceIt = distances.begin(); distanceIt != distances.end(); ++distanceIt)
+  {
+    sum += (*distanceIt);
+    maximum = std::max(maximum, static_cast<double>(*distanceIt));
+  }
+  average = sum / distances.size();
+  std::vector<float>::iterator percentileIt = distances.begin() + static_cast<size_t>(floor(0.95 * (distances.size() - 1)));
+  std::nth_element(distances.begin(), percentileIt, distances.end());
+  percent95 = (*percentileIt);
+}
+
+const unsigned char SEGMENT_BIT = 1;
+const unsigned char SEGMENT_BOUNDARY_BIT = 2;
+
+//----------------------------------------------------------------------------
+/// Segment of a batch comparison, on the common grid of all the segments
+struct BatchSegment
+{
+  std::string SegmentID;
+  std::string Name;
+  /// Extent of the segment labelmap, Voxels covers it with the SEGMENT_BIT and SEGMENT_BOUNDARY_BIT set
+  int Extent[6];
+  std::vector<unsigned char> Voxels;
+  vtkIdType NumberOfVoxels;
+};
+
+//----------------------------------------------------------------------------
+/// Distances from the voxels of one segment to another segment
+struct DirectedDistances
+{
+  double Maximum;
+  double Average;
+  double Percent95;
+};
+
+//----------------------------------------------------------------------------
+/// Reference and compare segment pair of a batch comparison
+struct BatchPair
+{
+  size_t ReferenceIndex;
+  size_t CompareIndex;
+  vtkIdType TruePositives;
+  /// Reference to compare and compare to reference distances, for the volume then for the boundary
+  DirectedDistances Distances[4];
+};
+
+//----------------------------------------------------------------------------
+bool IsExtentEmpty(const int extent[6])
+{
+  return (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5]);
+}
+
+//----------------------------------------------------------------------------
+/// Number of voxels that are in both segments
+vtkIdType CountOverlap(const BatchSegment& segment1, const BatchSegment& segment2)
+{
+  int extent[6] = {0,-1,0,-1,0,-1};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    extent[2*axis] = std::max(segment1.Extent[2*axis], segment2.Extent[2*axis]);
+    extent[2*axis+1] = std::min(segment1.Extent[2*axis+1], segment2.Extent[2*axis+1]);
+  }
+  if (segment1.NumberOfVoxels == 0 || segment2.NumberOfVoxels == 0 || IsExtentEmpty(extent))
+  {
+    return 0;
+  }
+  const BatchSegment* segments[2] = { &segment1, &segment2 };
+  vtkIdType dimensions[2][2] = { {0, 0}, {0, 0} };
+  for (int segmentIndex = 0; segmentIndex < 2; ++segmentIndex)
+  {
+    dimensions[segmentIndex][0] = segments[segmentIndex]->Extent[1] - segments[segmentIndex]->Extent[0] + 1;
+    dimensions[segmentIndex][1] = segments[segmentIndex]->Extent[3] - segments[segmentIndex]->Extent[2] + 1;
+  }
+  vtkIdType overlap = 0;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+    {
+      const unsigned char* voxelPtrs[2] = { NULL, NULL };
+      for (int segmentIndex = 0; segmentIndex < 2; ++segmentIndex)
+      {
+        const int* segmentExtent = segments[segmentIndex]->Extent;
+        voxelPtrs[segmentIndex] = &segments[segmentIndex]->Voxels[0] + (extent[0] - segmentExtent[0])
+          + dimensions[segmentIndex][0] * ((j - segmentExtent[2]) + dimensions[segmentIndex][1] * (k - segmentExtent[4]));
+      }
+      for (int i = extent[0]; i <= extent[1]; ++i, ++voxelPtrs[0], ++voxelPtrs[1])
+      {
+        if ((*voxelPtrs[0] & SEGMENT_BIT) && (*voxelPtrs[1] & SEGMENT_BIT))
+        {
+          ++overlap;
+        }
+      }
+    }
+  }
+  return overlap;
+}
+
+//----------------------------------------------------------------------------
+struct OverlapJobList
+{
+  std::vector<BatchSegment>* Segments;
+  std::vector<BatchPair>* Pairs;
+  vtkSimpleCriticalSection Lock;
+  size_t NextPair;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE CountOverlapThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  OverlapJobList* jobList = static_cast<OverlapJobList*>(threadInfo->UserData);
+  while (true)
+  {
+    jobList->Lock.Lock();
+    size_t pairIndex = jobList->NextPair++;
+    jobList->Lock.Unlock();
+    if (pairIndex >= jobList->Pairs->size())
+    {
+      break;
+    }
+    BatchPair& pair = (*jobList->Pairs)[pairIndex];
+    pair.TruePositives = CountOverlap((*jobList->Segments)[pair.ReferenceIndex], (*jobList->Segments)[pair.CompareIndex]);
+  }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Gather the distances of a squared distance map at the voxels of the partner segments
+struct DistanceJobList
+{
+  const float* DistanceMap;
+  int MapExtent[6];
+  unsigned char SourceBit;
+  std::vector<const BatchSegment*> Sources;
+  std::vector<DirectedDistances*> Results;
+  vtkSimpleCriticalSection Lock;
+  size_t NextSource;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE GatherDistancesThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  DistanceJobList* jobList = static_cast<DistanceJobList*>(threadInfo->UserData);
+  vtkIdType mapDimensions[2] = { jobList->MapExtent[1]-jobList->MapExtent[0]+1, jobList->MapExtent[3]-jobList->MapExtent[2]+1 };
+  std::vector<float> distances;
+  while (true)
+  {
+    jobList->Lock.Lock();
+    size_t sourceIndex = jobList->NextSource++;
+    jobList->Lock.Unlock();
+    if (sourceIndex >= jobList->Sources.size())
+    {
+      break;
+    }
+    const BatchSegment* source = jobList->Sources[sourceIndex];
+    distances.clear();
+    const unsigned char* voxelPtr = &source->Voxels[0];
+    for (int k = source->Extent[4]; k <= source->Extent[5]; ++k)
+    {
+      for (int j = source->Extent[2]; j <= source->Extent[3]; ++j)
+      {
+        const float* distancePtr = jobList->DistanceMap + (source->Extent[0] - jobList->MapExtent[0])
+          + mapDimensions[0] * ((j - jobList->MapExtent[2]) + mapDimensions[1] * (k - jobList->MapExtent[4]));
+        for (int i = source->Extent[0]; i <= source->Extent[1]; ++i, ++distancePtr)
+        {
+          if (*(voxelPtr++) & jobList->SourceBit)
+          {
+            distances.push_back(sqrt(*distancePtr));
+          }
+        }
+      }
+    }
+    DirectedDistances* result = jobList->Results[sourceIndex];
+    ComputeDistanceStatistics(distances, result->Maximum, result->Average, result->Percent95);
+  }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Run a job list thread function on as many threads as there are jobs, at most the default number of threads
+void ExecuteJobs(vtkThreadFunctionType threadFunction, void* jobList, size_t numberOfJobs)
+{
+  int numberOfThreads = static_cast<int>(std::min(numberOfJobs,
+    static_cast<size_t>(vtkMultiThreader::GetGlobalDefaultNumberOfThreads())));
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::max(numberOfThreads, 1));
+  threader->SetSingleMethod(threadFunction, jobList);
+  threader->SingleMethodExecute();
+}
+}
+
 //-----------------------------------------------------------------------------
 /// \ingroup SlicerRt_QtModules_SegmentComparison
 class vtkSlicerSegmentComparisonModuleLogicPrivate : public vtkObject
@@ -58,6 +305,45 @@ public:
   static vtkSlicerSegmentComparisonModuleLogicPrivate *New();
   vtkTypeMacro(vtkSlicerSegmentComparisonModuleLogicPrivate,vtkObject);
 
+  /// Dice statistics of two segments
+  struct DiceResults
+  {
+    double DiceCoefficient;
+    double TruePositivesPercent;
+    double TrueNegativesPercent;
+    double FalsePositivesPercent;
+    double FalseNegativesPercent;
+    double ReferenceCenter[3];
+    double CompareCenter[3];
+    double ReferenceVolumeCc;
+    double CompareVolumeCc;
+  };
+
+  /// Directed distances of two segments, both ways combined. Volume distances are measured from all
+  /// the voxels of a segment to the other segment, boundary distances between the boundary voxels.
+  struct HausdorffResults
+  {
+    double MaximumForVolumeMm;
+    double AverageForVolumeMm;
+    double Percent95ForVolumeMm;
+    double MaximumForBoundaryMm;
+    double AverageForBoundaryMm;
+    double Percent95ForBoundaryMm;
+  };
+
+public:
+  /// Get the selected input segments as binary labelmaps, transformed into a common coordinate system
+  /// \return Error message, empty string if no error
+  std::string GetInputSegmentLabelmaps(
+    vtkSmartPointer<vtkOrientedImageData>& referenceSegmentLabelmap,
+    vtkSmartPointer<vtkOrientedImageData>& compareSegmentLabelmap );
+
+  /// Get the binary labelmap of a segment, converted if necessary. The labelmap is a copy that can be modified.
+  /// \param applyParentTransform Transform the labelmap with the parent transform of the segmentation node
+  /// \return Error message, empty string if no error
+  std::string GetSegmentLabelmap(vtkMRMLSegmentationNode* segmentationNode, const std::string& segmentID,
+    bool applyParentTransform, vtkSmartPointer<vtkOrientedImageData>& segmentLabelmap);
+
   /// Get input segments as labelmaps, then convert them to Plm_image volumes
   /// \return Error message, empty string if no error
   std::string GetInputSegmentsAsPlmVolumes(
@@ -65,6 +351,30 @@ public:
     Plm_image::Pointer& plmCmpSegmentLabelmap,
     double &checkpointItkConvertStart);
 
+  /// Create a mask on the union of the extents of the two labelmaps, where each voxel has the
+  /// REFERENCE_BIT and COMPARE_BIT set if it belongs to the corresponding segment. The compare
+  /// labelmap is resampled to the geometry of the reference labelmap if the geometries differ.
+  /// \return Error message, empty string if no error
+  std::string CreateSegmentMask(vtkOrientedImageData* referenceSegmentLabelmap, vtkOrientedImageData* compareSegmentLabelmap,
+    std::vector<unsigned char>& mask, int maskExtent[6]);
+
+  /// Compute the Dice statistics directly on the segment labelmaps, in one pass over the segment mask
+  /// \return Error message, empty string if no error
+  std::string ComputeDiceStatistics(vtkOrientedImageData* referenceSegmentLabelmap, vtkOrientedImageData* compareSegmentLabelmap,
+    DiceResults& results);
+
+  /// Compute the Hausdorff distances directly on the segment labelmaps. The distances to each segment
+  /// and to its boundary are computed by the multithreaded Euclidean distance transform of vtkLabelmapMarginFilter.
+  /// \return Error message, empty string if no error
+  std::string ComputeHausdorffDistances(vtkOrientedImageData* referenceSegmentLabelmap, vtkOrientedImageData* compareSegmentLabelmap,
+    HausdorffResults& results);
+
+  /// Compare the segments of two segmentations pairwise and write the results into a table.
+  /// See vtkSlicerSegmentComparisonModuleLogic::ComputeSegmentComparisonTable
+  /// \return Error message, empty string if no error
+  std::string ComputeSegmentComparisonTable(vtkMRMLSegmentationNode* referenceSegmentationNode,
+    vtkMRMLSegmentationNode* compareSegmentationNode, vtkMRMLTableNode* tableNode, bool matchingNamesOnly);
+
   void SetLogic(vtkSlicerSegmentComparisonModuleLogic* logic) { this->Logic = logic; };
 
 protected:
@@ -93,15 +403,14 @@ vtkSlicerSegmentComparisonModuleLogicPrivate::~vtkSlicerSegmentComparisonModuleL
 }
 
 //---------------------------------------------------------------------------
-std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmVolumes(
-  Plm_image::Pointer& plmRefSegmentLabelmap,
-  Plm_image::Pointer& plmCmpSegmentLabelmap,
-  double &checkpointItkConvertStart )
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentLabelmaps(
+  vtkSmartPointer<vtkOrientedImageData>& referenceSegmentLabelmap,
+  vtkSmartPointer<vtkOrientedImageData>& compareSegmentLabelmap )
 {
   if (!this->Logic->GetSegmentComparisonNode() || !this->Logic->GetMRMLScene())
   {
     std::string errorMessage("Invalid MRML scene or parameter set node");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
 
@@ -114,13 +423,13 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
   if (!referenceSegmentationNode || !referenceSegmentID)
   {
     std::string errorMessage("Invalid reference segment selection");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
   if (!compareSegmentationNode || !compareSegmentID)
   {
     std::string errorMessage("Invalid compare segment selection");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
 
@@ -132,12 +441,11 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
   if (!referenceSegment || !compareSegment)
   {
     std::string errorMessage("Failed to get selected segments");
-    vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+    vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
     return errorMessage;
   }
 
   // Get binary labelmap representations of the reference segment
-  vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap;
   if ( referenceSegmentation->ContainsRepresentation(
     vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) )
   {
@@ -155,13 +463,12 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
     if (!referenceSegmentLabelmap.GetPointer())
     {
       std::string errorMessage("Failed to convert reference segment into binary labelmap\nPlease convert it in Segmentations module using Advanced conversion");
-      vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+      vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
       return errorMessage;
     }
   }
 
   // Get binary labelmap representations of the compare segment
-  vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap;
   if ( compareSegmentation->ContainsRepresentation(
     vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) )
   {
@@ -179,7 +486,7 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
     if (!referenceSegmentLabelmap.GetPointer())
     {
       std::string errorMessage("Failed to convert compare segment into binary labelmap\nPlease convert it in Segmentations module using Advanced conversion");
-      vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+      vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
       return errorMessage;
     }
   }
@@ -191,17 +498,34 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
     if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(referenceSegmentationNode, referenceSegmentLabelmap))
     {
       std::string errorMessage("Failed to apply parent transformation to compare segment!");
-      vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+      vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
       return errorMessage;
     }
     if (!vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(compareSegmentationNode, compareSegmentLabelmap))
     {
       std::string errorMessage("Failed to apply parent transformation to reference segment!");
-      vtkErrorMacro("GetInputSegmentsAsPlmVolumes: " << errorMessage);
+      vtkErrorMacro("GetInputSegmentLabelmaps: " << errorMessage);
       return errorMessage;
     }
   }
 
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmVolumes(
+  Plm_image::Pointer& plmRefSegmentLabelmap,
+  Plm_image::Pointer& plmCmpSegmentLabelmap,
+  double &checkpointItkConvertStart )
+{
+  vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap;
+  vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap;
+  std::string errorMessage = this->GetInputSegmentLabelmaps(referenceSegmentLabelmap, compareSegmentLabelmap);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+
   // Convert inputs to ITK images
   vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
   checkpointItkConvertStart = timer->GetUniversalTime();
@@ -225,6 +549,655 @@ std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetInputSegmentsAsPlmV
   return "";
 }
 
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::CreateSegmentMask(
+  vtkOrientedImageData* referenceSegmentLabelmap, vtkOrientedImageData* compareSegmentLabelmap,
+  std::vector<unsigned char>& mask, int maskExtent[6] )
+{
+  if (!referenceSegmentLabelmap || !compareSegmentLabelmap)
+  {
+    std::string errorMessage("Invalid segment labelmaps");
+    vtkErrorMacro("CreateSegmentMask: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Voxels of the two labelmaps can only be compared on the same grid
+  vtkSmartPointer<vtkOrientedImageData> compareLabelmapOnReferenceGrid = compareSegmentLabelmap;
+  if (!vtkOrientedImageDataResample::DoGeometriesMatch(referenceSegmentLabelmap, compareSegmentLabelmap))
+  {
+    compareLabelmapOnReferenceGrid = vtkSmartPointer<vtkOrientedImageData>::New();
+    if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+      compareSegmentLabelmap, referenceSegmentLabelmap, compareLabelmapOnReferenceGrid, false, true))
+    {
+      std::string errorMessage("Failed to resample compare segment labelmap to the reference geometry");
+      vtkErrorMacro("CreateSegmentMask: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
+  vtkOrientedImageData* labelmaps[2] = { referenceSegmentLabelmap, compareLabelmapOnReferenceGrid.GetPointer() };
+  unsigned char bits[2] = { REFERENCE_BIT, COMPARE_BIT };
+  int extents[2][6] = { {0,-1,0,-1,0,-1}, {0,-1,0,-1,0,-1} };
+  bool maskExtentValid = false;
+  for (int labelmapIndex = 0; labelmapIndex < 2; ++labelmapIndex)
+  {
+    if (!labelmaps[labelmapIndex]->GetPointData()->GetScalars() || labelmaps[labelmapIndex]->GetNumberOfScalarComponents() != 1)
+    {
+      continue;
+    }
+    int* extent = extents[labelmapIndex];
+    labelmaps[labelmapIndex]->GetExtent(extent);
+    if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+      continue;
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      maskExtent[2*axis] = (maskExtentValid ? std::min(maskExtent[2*axis], extent[2*axis]) : extent[2*axis]);
+      maskExtent[2*axis+1] = (maskExtentValid ? std::max(maskExtent[2*axis+1], extent[2*axis+1]) : extent[2*axis+1]);
+    }
+    maskExtentValid = true;
+  }
+  if (!maskExtentValid)
+  {
+    std::string errorMessage("Both segment labelmaps are empty");
+    vtkErrorMacro("CreateSegmentMask: " << errorMessage);
+    return errorMessage;
+  }
+
+  mask.assign( static_cast<size_t>(maskExtent[1]-maskExtent[0]+1) * (maskExtent[3]-maskExtent[2]+1)
+    * (maskExtent[5]-maskExtent[4]+1), 0 );
+  for (int labelmapIndex = 0; labelmapIndex < 2; ++labelmapIndex)
+  {
+    int* extent = extents[labelmapIndex];
+    if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+      continue;
+    }
+    switch (labelmaps[labelmapIndex]->GetScalarType())
+    {
+      vtkTemplateMacro(AddSegmentToMask(static_cast<VTK_TT*>(labelmaps[labelmapIndex]->GetScalarPointer()),
+        extent, maskExtent, bits[labelmapIndex], &mask[0]));
+    default:
+      {
+        std::string errorMessage("Unsupported segment labelmap scalar type");
+        vtkErrorMacro("CreateSegmentMask: " << errorMessage);
+        return errorMessage;
+      }
+    }
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::ComputeDiceStatistics(
+  vtkOrientedImageData* referenceSegmentLabelmap, vtkOrientedImageData* compareSegmentLabelmap, DiceResults& results )
+{
+  std::vector<unsigned char> mask;
+  int maskExtent[6] = {0,-1,0,-1,0,-1};
+  std::string errorMessage = this->CreateSegmentMask(referenceSegmentLabelmap, compareSegmentLabelmap, mask, maskExtent);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+
+  // Count the overlap classes and accumulate the centroids in one pass
+  vtkIdType truePositives = 0;
+  vtkIdType trueNegatives = 0;
+  vtkIdType falsePositives = 0;
+  vtkIdType falseNegatives = 0;
+  double referenceSum[3] = {0.0, 0.0, 0.0};
+  double compareSum[3] = {0.0, 0.0, 0.0};
+  unsigned char* maskPtr = &mask[0];
+  for (int k = maskExtent[4]; k <= maskExtent[5]; ++k)
+  {
+    for (int j = maskExtent[2]; j <= maskExtent[3]; ++j)
+    {
+      for (int i = maskExtent[0]; i <= maskExtent[1]; ++i)
+      {
+        unsigned char voxel = *(maskPtr++);
+        bool inReference = ((voxel & REFERENCE_BIT) != 0);
+        bool inCompare = ((voxel & COMPARE_BIT) != 0);
+        if (inReference)
+        {
+          referenceSum[0] += i;
+          referenceSum[1] += j;
+          referenceSum[2] += k;
+        }
+        if (inCompare)
+        {
+          compareSum[0] += i;
+          compareSum[1] += j;
+          compareSum[2] += k;
+        }
+        if (inReference && inCompare)
+        {
+          ++truePositives;
+        }
+        else if (inReference)
+        {
+          ++falseNegatives;
+        }
+        else if (inCompare)
+        {
+          ++falsePositives;
+        }
+        else
+        {
+          ++trueNegatives;
+        }
+      }
+    }
+  }
+
+  vtkIdType referenceVoxelCount = truePositives + falseNegatives;
+  vtkIdType compareVoxelCount = truePositives + falsePositives;
+  double numberOfVoxels = static_cast<double>(mask.size());
+  results.DiceCoefficient = (referenceVoxelCount + compareVoxelCount > 0
+    ? 2.0 * truePositives / static_cast<double>(referenceVoxelCount + compareVoxelCount) : 0.0);
+  results.TruePositivesPercent = truePositives * 100.0 / numberOfVoxels;
+  results.TrueNegativesPercent = trueNegatives * 100.0 / numberOfVoxels;
+  results.FalsePositivesPercent = falsePositives * 100.0 / numberOfVoxels;
+  results.FalseNegativesPercent = falseNegatives * 100.0 / numberOfVoxels;
+
+  // Centers are computed in IJK and transformed to RAS with the reference geometry
+  vtkSmartPointer<vtkMatrix4x4> referenceImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  referenceSegmentLabelmap->GetImageToWorldMatrix(referenceImageToWorldMatrix);
+  double referenceCenterIjk[4] = {0.0, 0.0, 0.0, 1.0};
+  double compareCenterIjk[4] = {0.0, 0.0, 0.0, 1.0};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    referenceCenterIjk[axis] = (referenceVoxelCount > 0 ? referenceSum[axis] / referenceVoxelCount : 0.0);
+    compareCenterIjk[axis] = (compareVoxelCount > 0 ? compareSum[axis] / compareVoxelCount : 0.0);
+  }
+  double referenceCenterRas[4] = {0.0, 0.0, 0.0, 1.0};
+  double compareCenterRas[4] = {0.0, 0.0, 0.0, 1.0};
+  referenceImageToWorldMatrix->MultiplyPoint(referenceCenterIjk, referenceCenterRas);
+  referenceImageToWorldMatrix->MultiplyPoint(compareCenterIjk, compareCenterRas);
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    results.ReferenceCenter[axis] = referenceCenterRas[axis];
+    results.CompareCenter[axis] = compareCenterRas[axis];
+  }
+
+  double spacing[3] = {1.0, 1.0, 1.0};
+  referenceSegmentLabelmap->GetSpacing(spacing);
+  double voxelVolumeCc = fabs(spacing[0] * spacing[1] * spacing[2]) / 1000.0;
+  results.ReferenceVolumeCc = referenceVoxelCount * voxelVolumeCc;
+  results.CompareVolumeCc = compareVoxelCount * voxelVolumeCc;
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::ComputeHausdorffDistances(
+  vtkOrientedImageData* referenceSegmentLabelmap, vtkOrientedImageData* compareSegmentLabelmap, HausdorffResults& results )
+{
+  std::vector<unsigned char> mask;
+  int maskExtent[6] = {0,-1,0,-1,0,-1};
+  std::string errorMessage = this->CreateSegmentMask(referenceSegmentLabelmap, compareSegmentLabelmap, mask, maskExtent);
+  if (!errorMessage.empty())
+  {
+    return errorMessage;
+  }
+  int maskDimensions[3] = { maskExtent[1]-maskExtent[0]+1, maskExtent[3]-maskExtent[2]+1, maskExtent[5]-maskExtent[4]+1 };
+  vtkIdType sliceSize = static_cast<vtkIdType>(maskDimensions[0]) * maskDimensions[1];
+
+  // Mark the boundary voxels: segment voxels with a 6-neighbor outside the segment or outside the mask
+  bool referenceEmpty = true;
+  bool compareEmpty = true;
+  vtkIdType voxelIndex = 0;
+  for (int k = 0; k < maskDimensions[2]; ++k)
+  {
+    for (int j = 0; j < maskDimensions[1]; ++j)
+    {
+      for (int i = 0; i < maskDimensions[0]; ++i, ++voxelIndex)
+      {
+        unsigned char voxel = mask[voxelIndex];
+        unsigned char neighborsCommon = REFERENCE_BIT | COMPARE_BIT;
+        neighborsCommon &= (i > 0 ? mask[voxelIndex-1] : 0);
+        neighborsCommon &= (i < maskDimensions[0]-1 ? mask[voxelIndex+1] : 0);
+        neighborsCommon &= (j > 0 ? mask[voxelIndex-maskDimensions[0]] : 0);
+        neighborsCommon &= (j < maskDimensions[1]-1 ? mask[voxelIndex+maskDimensions[0]] : 0);
+        neighborsCommon &= (k > 0 ? mask[voxelIndex-sliceSize] : 0);
+        neighborsCommon &= (k < maskDimensions[2]-1 ? mask[voxelIndex+sliceSize] : 0);
+        if ((voxel & REFERENCE_BIT) && !(neighborsCommon & REFERENCE_BIT))
+        {
+          mask[voxelIndex] |= REFERENCE_BOUNDARY_BIT;
+        }
+        if ((voxel & COMPARE_BIT) && !(neighborsCommon & COMPARE_BIT))
+        {
+          mask[voxelIndex] |= COMPARE_BOUNDARY_BIT;
+        }
+        referenceEmpty = referenceEmpty && !(voxel & REFERENCE_BIT);
+        compareEmpty = compareEmpty && !(voxel & COMPARE_BIT);
+      }
+    }
+  }
+  if (referenceEmpty || compareEmpty)
+  {
+    errorMessage = "Hausdorff distances cannot be computed for an empty segment";
+    vtkErrorMacro("ComputeHausdorffDistances: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Squared distance map to the voxels with the target bit, gathered at the voxels with the source bit.
+  // The mask extent contains both segments, so the distances within the mask are exact.
+  double spacing[3] = {1.0, 1.0, 1.0};
+  referenceSegmentLabelmap->GetSpacing(spacing);
+  double weights[3] = { spacing[0]*spacing[0], spacing[1]*spacing[1], spacing[2]*spacing[2] };
+  std::vector<float> distanceMap(mask.size());
+  unsigned char directions[4][2] = {
+    { COMPARE_BIT, REFERENCE_BIT },
+    { REFERENCE_BIT, COMPARE_BIT },
+    { COMPARE_BOUNDARY_BIT, REFERENCE_BOUNDARY_BIT },
+    { REFERENCE_BOUNDARY_BIT, COMPARE_BOUNDARY_BIT } };
+  double maximum[4] = {0.0, 0.0, 0.0, 0.0};
+  double average[4] = {0.0, 0.0, 0.0, 0.0};
+  double percent95[4] = {0.0, 0.0, 0.0, 0.0};
+  std::vector<float> distances;
+  for (int direction = 0; direction < 4; ++direction)
+  {
+    unsigned char targetBit = directions[direction][0];
+    unsigned char sourceBit = directions[direction][1];
+    for (size_t index = 0; index < mask.size(); ++index)
+    {
+      distanceMap[index] = ((mask[index] & targetBit) ? 0.0f : vtkLabelmapMarginFilter::GetFarDistance());
+    }
+    vtkLabelmapMarginFilter::ComputeSquaredDistanceMap(&distanceMap[0], maskDimensions, weights, 0);
+
+    distances.clear();
+    for (size_t index = 0; index < mask.size(); ++index)
+    {
+      if (mask[index] & sourceBit)
+      {
+        distances.push_back(sqrt(distanceMap[index]));
+      }
+    }
+    ComputeDistanceStatistics(distances, maximum[direction], average[direction], percent95[direction]);
+  }
+
+  results.MaximumForVolumeMm = std::max(maximum[0], maximum[1]);
+  results.AverageForVolumeMm = (average[0] + average[1]) / 2.0;
+  results.Percent95ForVolumeMm = std::max(percent95[0], percent95[1]);
+  results.MaximumForBoundaryMm = std::max(maximum[2], maximum[3]);
+  results.AverageForBoundaryMm = (average[2] + average[3]) / 2.0;
+  results.Percent95ForBoundaryMm = std::max(percent95[2], percent95[3]);
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::GetSegmentLabelmap(
+  vtkMRMLSegmentationNode* segmentationNode, const std::string& segmentID,
+  bool applyParentTransform, vtkSmartPointer<vtkOrientedImageData>& segmentLabelmap )
+{
+  vtkSegmentation* segmentation = segmentationNode->GetSegmentation();
+  vtkSegment* segment = segmentation->GetSegment(segmentID);
+  if (!segment)
+  {
+    std::string errorMessage = "Failed to get segment " + segmentID;
+    vtkErrorMacro("GetSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+
+  if ( segmentation->ContainsRepresentation(
+    vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) )
+  {
+    // Temporarily duplicate segment, as it may be transformed
+    segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+    segmentLabelmap->DeepCopy( vtkOrientedImageData::SafeDownCast(
+      segment->GetRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) ) );
+  }
+  else // Need to convert
+  {
+    // Temporarily duplicate selected segment to only convert them, not the whole segmentation (to save time)
+    segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::Take( vtkOrientedImageData::SafeDownCast(
+      vtkSlicerSegmentationsModuleLogic::CreateRepresentationForOneSegment( segmentation, segmentID,
+        vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) ) );
+    if (!segmentLabelmap.GetPointer())
+    {
+      std::string errorMessage = "Failed to convert segment " + segmentID + " into binary labelmap\nPlease convert it in Segmentations module using Advanced conversion";
+      vtkErrorMacro("GetSegmentLabelmap: " << errorMessage);
+      return errorMessage;
+    }
+  }
+
+  if ( applyParentTransform
+    && !vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(segmentationNode, segmentLabelmap) )
+  {
+    std::string errorMessage = "Failed to apply parent transformation to segment " + segmentID;
+    vtkErrorMacro("GetSegmentLabelmap: " << errorMessage);
+    return errorMessage;
+  }
+
+  return "";
+}
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogicPrivate::ComputeSegmentComparisonTable(
+  vtkMRMLSegmentationNode* referenceSegmentationNode, vtkMRMLSegmentationNode* compareSegmentationNode,
+  vtkMRMLTableNode* tableNode, bool matchingNamesOnly )
+{
+  // Reference segments come first in the segment list, then the compare segments
+  std::vector<std::string> referenceSegmentIDs;
+  referenceSegmentationNode->GetSegmentation()->GetSegmentIDs(referenceSegmentIDs);
+  std::vector<std::string> compareSegmentIDs;
+  compareSegmentationNode->GetSegmentation()->GetSegmentIDs(compareSegmentIDs);
+  std::vector<BatchSegment> segments(referenceSegmentIDs.size() + compareSegmentIDs.size());
+  for (size_t segmentIndex = 0; segmentIndex < segments.size(); ++segmentIndex)
+  {
+    bool reference = (segmentIndex < referenceSegmentIDs.size());
+    vtkMRMLSegmentationNode* segmentationNode = (reference ? referenceSegmentationNode : compareSegmentationNode);
+    segments[segmentIndex].SegmentID = (reference ? referenceSegmentIDs[segmentIndex]
+      : compareSegmentIDs[segmentIndex - referenceSegmentIDs.size()]);
+    const char* name = segmentationNode->GetSegmentation()->GetSegment(segments[segmentIndex].SegmentID)->GetName();
+    segments[segmentIndex].Name = (name ? name : "");
+    segments[segmentIndex].NumberOfVoxels = 0;
+  }
+
+  std::vector<BatchPair> pairs;
+  std::vector<bool> segmentInPair(segments.size(), false);
+  for (size_t referenceIndex = 0; referenceIndex < referenceSegmentIDs.size(); ++referenceIndex)
+  {
+    for (size_t compareIndex = referenceSegmentIDs.size(); compareIndex < segments.size(); ++compareIndex)
+    {
+      if (matchingNamesOnly && segments[referenceIndex].Name != segments[compareIndex].Name)
+      {
+        continue;
+      }
+      BatchPair pair;
+      pair.ReferenceIndex = referenceIndex;
+      pair.CompareIndex = compareIndex;
+      pair.TruePositives = 0;
+      pairs.push_back(pair);
+      segmentInPair[referenceIndex] = segmentInPair[compareIndex] = true;
+    }
+  }
+  if (pairs.empty())
+  {
+    std::string errorMessage("No segment pairs to compare");
+    vtkErrorMacro("ComputeSegmentComparisonTable: " << errorMessage);
+    return errorMessage;
+  }
+
+  // Get the segment labelmaps on the geometry of the first one, each segment is resampled at most once.
+  // Only the mask of the segment is kept, with its boundary voxels marked.
+  bool applyParentTransforms = ( referenceSegmentationNode != compareSegmentationNode
+    && referenceSegmentationNode->GetParentTransformNode() != compareSegmentationNode->GetParentTransformNode() );
+  vtkSmartPointer<vtkOrientedImageData> commonGeometry;
+  double spacing[3] = {1.0, 1.0, 1.0};
+  for (size_t segmentIndex = 0; segmentIndex < segments.size(); ++segmentIndex)
+  {
+    BatchSegment& segment = segments[segmentIndex];
+    int* extent = segment.Extent;
+    extent[0] = extent[2] = extent[4] = 0;
+    extent[1] = extent[3] = extent[5] = -1;
+    if (!segmentInPair[segmentIndex])
+    {
+      continue;
+    }
+    vtkSmartPointer<vtkOrientedImageData> segmentLabelmap;
+    std::string errorMessage = this->GetSegmentLabelmap( (segmentIndex < referenceSegmentIDs.size() ? referenceSegmentationNode : compareSegmentationNode),
+      segment.SegmentID, applyParentTransforms, segmentLabelmap );
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+    if ( !segmentLabelmap->GetPointData()->GetScalars() || segmentLabelmap->GetNumberOfScalarComponents() != 1
+      || IsExtentEmpty(segmentLabelmap->GetExtent()) )
+    {
+      continue;
+    }
+
+    if (!commonGeometry.GetPointer())
+    {
+      vtkSmartPointer<vtkMatrix4x4> imageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      segmentLabelmap->GetImageToWorldMatrix(imageToWorldMatrix);
+      commonGeometry = vtkSmartPointer<vtkOrientedImageData>::New();
+      commonGeometry->SetExtent(segmentLabelmap->GetExtent());
+      commonGeometry->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+      commonGeometry->GetSpacing(spacing);
+    }
+    else if (!vtkOrientedImageDataResample::DoGeometriesMatch(commonGeometry, segmentLabelmap))
+    {
+      vtkSmartPointer<vtkOrientedImageData> resampledSegmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      if (!vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(
+        segmentLabelmap, commonGeometry, resampledSegmentLabelmap, false, true))
+      {
+        errorMessage = "Failed to resample segment " + segment.SegmentID + " to the common geometry";
+        vtkErrorMacro("ComputeSegmentComparisonTable: " << errorMessage);
+        return errorMessage;
+      }
+      segmentLabelmap = resampledSegmentLabelmap;
+    }
+
+    segmentLabelmap->GetExtent(extent);
+    int dimensions[3] = { extent[1]-extent[0]+1, extent[3]-extent[2]+1, extent[5]-extent[4]+1 };
+    segment.Voxels.assign(static_cast<size_t>(dimensions[0]) * dimensions[1] * dimensions[2], 0);
+    switch (segmentLabelmap->GetScalarType())
+    {
+      vtkTemplateMacro(AddSegmentToMask(static_cast<VTK_TT*>(segmentLabelmap->GetScalarPointer()),
+        extent, extent, SEGMENT_BIT, &segment.Voxels[0]));
+    default:
+      errorMessage = "Unsupported scalar type of segment " + segment.SegmentID;
+      vtkErrorMacro("ComputeSegmentComparisonTable: " << errorMessage);
+      return errorMessage;
+    }
+
+    // Boundary voxels have a 6-neighbor outside the segment, the voxels outside the extent are background
+    vtkIdType sliceSize = static_cast<vtkIdType>(dimensions[0]) * dimensions[1];
+    vtkIdType voxelIndex = 0;
+    for (int k = 0; k < dimensions[2]; ++k)
+    {
+      for (int j = 0; j < dimensions[1]; ++j)
+      {
+        for (int i = 0; i < dimensions[0]; ++i, ++voxelIndex)
+        {
+          if (!(segment.Voxels[voxelIndex] & SEGMENT_BIT))
+          {
+            continue;
+          }
+          ++segment.NumberOfVoxels;
+          if ( i == 0 || i == dimensions[0]-1 || j == 0 || j == dimensions[1]-1 || k == 0 || k == dimensions[2]-1
+            || !(segment.Voxels[voxelIndex-1] & SEGMENT_BIT) || !(segment.Voxels[voxelIndex+1] & SEGMENT_BIT)
+            || !(segment.Voxels[voxelIndex-dimensions[0]] & SEGMENT_BIT) || !(segment.Voxels[voxelIndex+dimensions[0]] & SEGMENT_BIT)
+            || !(segment.Voxels[voxelIndex-sliceSize] & SEGMENT_BIT) || !(segment.Voxels[voxelIndex+sliceSize] & SEGMENT_BIT) )
+          {
+            segment.Voxels[voxelIndex] |= SEGMENT_BOUNDARY_BIT;
+          }
+        }
+      }
+    }
+    if (segment.NumberOfVoxels == 0)
+    {
+      // Empty segments do not take part in the distance computations
+      std::vector<unsigned char>().swap(segment.Voxels);
+      extent[0] = extent[2] = extent[4] = 0;
+      extent[1] = extent[3] = extent[5] = -1;
+    }
+  }
+
+  // Overlap of the pairs
+  {
+    OverlapJobList jobList;
+    jobList.Segments = &segments;
+    jobList.Pairs = &pairs;
+    jobList.NextPair = 0;
+    ExecuteJobs(CountOverlapThread, &jobList, pairs.size());
+  }
+
+  // The distance maps cover all the segments, so that the distances to a segment are exact at the voxels of all its partners
+  int mapExtent[6] = {0,-1,0,-1,0,-1};
+  bool mapExtentValid = false;
+  for (size_t segmentIndex = 0; segmentIndex < segments.size(); ++segmentIndex)
+  {
+    const int* extent = segments[segmentIndex].Extent;
+    if (IsExtentEmpty(extent))
+    {
+      continue;
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+      mapExtent[2*axis] = (mapExtentValid ? std::min(mapExtent[2*axis], extent[2*axis]) : extent[2*axis]);
+      mapExtent[2*axis+1] = (mapExtentValid ? std::max(mapExtent[2*axis+1], extent[2*axis+1]) : extent[2*axis+1]);
+    }
+    mapExtentValid = true;
+  }
+
+  // Each segment is the target of two distance maps, one to its voxels and one to its boundary.
+  // Each map is computed once and the distances of all the partner segments are gathered from it concurrently.
+  std::vector<float> distanceMap;
+  if (mapExtentValid)
+  {
+    int mapDimensions[3] = { mapExtent[1]-mapExtent[0]+1, mapExtent[3]-mapExtent[2]+1, mapExtent[5]-mapExtent[4]+1 };
+    distanceMap.resize(static_cast<size_t>(mapDimensions[0]) * mapDimensions[1] * mapDimensions[2]);
+    double weights[3] = { spacing[0]*spacing[0], spacing[1]*spacing[1], spacing[2]*spacing[2] };
+    unsigned char targetBits[2] = { SEGMENT_BIT, SEGMENT_BOUNDARY_BIT };
+    for (size_t targetIndex = 0; targetIndex < segments.size(); ++targetIndex)
+    {
+      const BatchSegment& target = segments[targetIndex];
+      if (target.NumberOfVoxels == 0)
+      {
+        continue;
+      }
+      bool targetIsReference = (targetIndex < referenceSegmentIDs.size());
+      for (int mapType = 0; mapType < 2; ++mapType)
+      {
+        DistanceJobList jobList;
+        jobList.DistanceMap = &distanceMap[0];
+        std::copy(mapExtent, mapExtent + 6, jobList.MapExtent);
+        jobList.SourceBit = targetBits[mapType];
+        jobList.NextSource = 0;
+        for (std::vector<BatchPair>::iterator pairIt = pairs.begin(); pairIt != pairs.end(); ++pairIt)
+        {
+          if ((targetIsReference ? pairIt->ReferenceIndex : pairIt->CompareIndex) != targetIndex)
+          {
+            continue;
+          }
+          const BatchSegment* source = &segments[targetIsReference ? pairIt->CompareIndex : pairIt->ReferenceIndex];
+          if (source->NumberOfVoxels > 0)
+          {
+            jobList.Sources.push_back(source);
+            // Distances from the reference voxels to the compare segment are the first
+            jobList.Results.push_back(&pairIt->Distances[2*mapType + (targetIsReference ? 1 : 0)]);
+          }
+        }
+        if (jobList.Sources.empty())
+        {
+          continue;
+        }
+
+        std::fill(distanceMap.begin(), distanceMap.end(), vtkLabelmapMarginFilter::GetFarDistance());
+        const unsigned char* voxelPtr = &target.Voxels[0];
+        for (int k = target.Extent[4]; k <= target.Extent[5]; ++k)
+        {
+          for (int j = target.Extent[2]; j <= target.Extent[3]; ++j)
+          {
+            float* distancePtr = &distanceMap[0] + (target.Extent[0] - mapExtent[0])
+              + static_cast<vtkIdType>(mapDimensions[0]) * ((j - mapExtent[2]) + static_cast<vtkIdType>(mapDimensions[1]) * (k - mapExtent[4]));
+            for (int i = target.Extent[0]; i <= target.Extent[1]; ++i, ++distancePtr)
+            {
+              if (*(voxelPtr++) & targetBits[mapType])
+              {
+                *distancePtr = 0.0f;
+              }
+            }
+          }
+        }
+        vtkLabelmapMarginFilter::ComputeSquaredDistanceMap(&distanceMap[0], mapDimensions, weights, 0);
+
+        ExecuteJobs(GatherDistancesThread, &jobList, jobList.Sources.size());
+      }
+    }
+  }
+
+  // Write the table, same columns as the fields of the single segment comparison
+  const char* metricNames[] = {
+    "Dice coefficient", "True positives (%)", "True negatives (%)", "False positives (%)", "False negatives (%)",
+    "Reference volume (cc)", "Compare volume (cc)",
+    "Maximum Hausdorff distance for volume (mm)", "Maximum Hausdorff distance for boundary (mm)",
+    "Average Hausdorff distance for volume (mm)", "Average Hausdorff distance for boundary (mm)",
+    "95% Hausdorff distance for volume (mm)", "95% Hausdorff distance for boundary (mm)" };
+  const int numberOfMetrics = sizeof(metricNames) / sizeof(metricNames[0]);
+  vtkSmartPointer<vtkTable> table = vtkSmartPointer<vtkTable>::New();
+  vtkSmartPointer<vtkStringArray> referenceSegmentColumn = vtkSmartPointer<vtkStringArray>::New();
+  referenceSegmentColumn->SetName("Reference segment");
+  referenceSegmentColumn->SetNumberOfValues(pairs.size());
+  table->AddColumn(referenceSegmentColumn);
+  vtkSmartPointer<vtkStringArray> compareSegmentColumn = vtkSmartPointer<vtkStringArray>::New();
+  compareSegmentColumn->SetName("Compare segment");
+  compareSegmentColumn->SetNumberOfValues(pairs.size());
+  table->AddColumn(compareSegmentColumn);
+  std::vector<vtkDoubleArray*> metricColumns;
+  for (int metricIndex = 0; metricIndex < numberOfMetrics; ++metricIndex)
+  {
+    vtkSmartPointer<vtkDoubleArray> metricColumn = vtkSmartPointer<vtkDoubleArray>::New();
+    metricColumn->SetName(metricNames[metricIndex]);
+    metricColumn->SetNumberOfValues(pairs.size());
+    table->AddColumn(metricColumn);
+    metricColumns.push_back(metricColumn);
+  }
+
+  double voxelVolumeCc = fabs(spacing[0] * spacing[1] * spacing[2]) / 1000.0;
+  for (size_t pairIndex = 0; pairIndex < pairs.size(); ++pairIndex)
+  {
+    const BatchPair& pair = pairs[pairIndex];
+    const BatchSegment& referenceSegment = segments[pair.ReferenceIndex];
+    const BatchSegment& compareSegment = segments[pair.CompareIndex];
+    referenceSegmentColumn->SetValue(pairIndex, referenceSegment.Name);
+    compareSegmentColumn->SetValue(pairIndex, compareSegment.Name);
+
+    // Voxels are counted in the union of the extents of the two segments, as for a single comparison
+    double numberOfVoxels = 0.0;
+    if (referenceSegment.NumberOfVoxels > 0 || compareSegment.NumberOfVoxels > 0)
+    {
+      numberOfVoxels = 1.0;
+      for (int axis = 0; axis < 3; ++axis)
+      {
+        int minimum = std::min( (referenceSegment.NumberOfVoxels > 0 ? referenceSegment.Extent[2*axis] : VTK_INT_MAX),
+          (compareSegment.NumberOfVoxels > 0 ? compareSegment.Extent[2*axis] : VTK_INT_MAX) );
+        int maximum = std::max( (referenceSegment.NumberOfVoxels > 0 ? referenceSegment.Extent[2*axis+1] : VTK_INT_MIN),
+          (compareSegment.NumberOfVoxels > 0 ? compareSegment.Extent[2*axis+1] : VTK_INT_MIN) );
+        numberOfVoxels *= (maximum - minimum + 1);
+      }
+    }
+    vtkIdType falseNegatives = referenceSegment.NumberOfVoxels - pair.TruePositives;
+    vtkIdType falsePositives = compareSegment.NumberOfVoxels - pair.TruePositives;
+    double trueNegatives = numberOfVoxels - pair.TruePositives - falseNegatives - falsePositives;
+    double percentFactor = (numberOfVoxels > 0.0 ? 100.0 / numberOfVoxels : 0.0);
+    vtkIdType segmentVoxels = referenceSegment.NumberOfVoxels + compareSegment.NumberOfVoxels;
+
+    double metrics[numberOfMetrics] = {
+      (segmentVoxels > 0 ? 2.0 * pair.TruePositives / segmentVoxels : 0.0),
+      pair.TruePositives * percentFactor, trueNegatives * percentFactor,
+      falsePositives * percentFactor, falseNegatives * percentFactor,
+      referenceSegment.NumberOfVoxels * voxelVolumeCc, compareSegment.NumberOfVoxels * voxelVolumeCc,
+      vtkMath::Nan(), vtkMath::Nan(), vtkMath::Nan(), vtkMath::Nan(), vtkMath::Nan(), vtkMath::Nan() };
+    if (referenceSegment.NumberOfVoxels > 0 && compareSegment.NumberOfVoxels > 0)
+    {
+      // Same assignment as the maximum Hausdorff distance fields of the single comparison
+      metrics[7] = std::max(pair.Distances[2].Maximum, pair.Distances[3].Maximum);
+      metrics[8] = std::max(pair.Distances[0].Maximum, pair.Distances[1].Maximum);
+      metrics[9] = (pair.Distances[0].Average + pair.Distances[1].Average) / 2.0;
+      metrics[10] = (pair.Distances[2].Average + pair.Distances[3].Average) / 2.0;
+      metrics[11] = std::max(pair.Distances[0].Percent95, pair.Distances[1].Percent95);
+      metrics[12] = std::max(pair.Distances[2].Percent95, pair.Distances[3].Percent95);
+    }
+    for (int metricIndex = 0; metricIndex < numberOfMetrics; ++metricIndex)
+    {
+      metricColumns[metricIndex]->SetValue(pairIndex, metrics[metricIndex]);
+    }
+  }
+
+  tableNode->SetAndObserveTable(table);
+  tableNode->SetUseColumnNameAsColumnHeader(true);
+  tableNode->SetUseFirstColumnAsRowHeader(false);
+
+  return "";
+}
+
 //-----------------------------------------------------------------------------
 // vtkSlicerSegmentComparisonModuleLogic methods
 
@@ -244,6 +1217,7 @@ vtkSlicerSegmentComparisonModuleLogic::vtkSlicerSegmentComparisonModuleLogic()
   this->SetLogicPrivate(logicPrivate);
 
   this->LogSpeedMeasurementsOff();
+  this->UseNativeComputationOn();
 }
 
 //----------------------------------------------------------------------------
@@ -375,6 +1349,48 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeDiceStatistics()
   UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
   double checkpointItkConvertStart = 0.0;
 
+  if (this->UseNativeComputation)
+  {
+    vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap;
+    vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap;
+    std::string errorMessage = this->LogicPrivate->GetInputSegmentLabelmaps(referenceSegmentLabelmap, compareSegmentLabelmap);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+
+    double checkpointDiceStart = timer->GetUniversalTime();
+    UNUSED_VARIABLE(checkpointDiceStart); // Although it is used later, a warning is logged so needs to be suppressed
+    vtkSlicerSegmentComparisonModuleLogicPrivate::DiceResults dice;
+    errorMessage = this->LogicPrivate->ComputeDiceStatistics(referenceSegmentLabelmap, compareSegmentLabelmap, dice);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+
+    this->SegmentComparisonNode->SetDiceCoefficient(dice.DiceCoefficient);
+    this->SegmentComparisonNode->SetTruePositivesPercent(dice.TruePositivesPercent);
+    this->SegmentComparisonNode->SetTrueNegativesPercent(dice.TrueNegativesPercent);
+    this->SegmentComparisonNode->SetFalsePositivesPercent(dice.FalsePositivesPercent);
+    this->SegmentComparisonNode->SetFalseNegativesPercent(dice.FalseNegativesPercent);
+    this->SegmentComparisonNode->SetReferenceCenter(dice.ReferenceCenter);
+    this->SegmentComparisonNode->SetCompareCenter(dice.CompareCenter);
+    this->SegmentComparisonNode->SetReferenceVolumeCc(dice.ReferenceVolumeCc);
+    this->SegmentComparisonNode->SetCompareVolumeCc(dice.CompareVolumeCc);
+    this->SegmentComparisonNode->DiceResultsValidOn();
+
+    if (this->LogSpeedMeasurements)
+    {
+      double checkpointEnd = timer->GetUniversalTime();
+      UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
+      vtkDebugMacro("ComputeDiceStatistics: Total Dice computation time: " << checkpointEnd-checkpointStart << " s\n"
+        << "\tApplying transforms: " << checkpointDiceStart-checkpointStart << " s\n"
+        << "\tDice computation: " << checkpointEnd-checkpointDiceStart << " s");
+    }
+
+    return "";
+  }
+
   // Convert input images to the format Plastimatch can use
   Plm_image::Pointer plmRefSegmentLabelmap;
   Plm_image::Pointer plmCmpSegmentLabelmap;
@@ -449,6 +1465,46 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances()
   UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
   double checkpointItkConvertStart = 0.0;
 
+  if (this->UseNativeComputation)
+  {
+    vtkSmartPointer<vtkOrientedImageData> referenceSegmentLabelmap;
+    vtkSmartPointer<vtkOrientedImageData> compareSegmentLabelmap;
+    std::string errorMessage = this->LogicPrivate->GetInputSegmentLabelmaps(referenceSegmentLabelmap, compareSegmentLabelmap);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+
+    double checkpointHausdorffStart = timer->GetUniversalTime();
+    UNUSED_VARIABLE(checkpointHausdorffStart); // Although it is used later, a warning is logged so needs to be suppressed
+    vtkSlicerSegmentComparisonModuleLogicPrivate::HausdorffResults hausdorff;
+    errorMessage = this->LogicPrivate->ComputeHausdorffDistances(referenceSegmentLabelmap, compareSegmentLabelmap, hausdorff);
+    if (!errorMessage.empty())
+    {
+      return errorMessage;
+    }
+
+    // Same assignment as for the plastimatch results below, so that the fields keep their meaning
+    this->SegmentComparisonNode->SetMaximumHausdorffDistanceForVolumeMm(hausdorff.MaximumForBoundaryMm);
+    this->SegmentComparisonNode->SetMaximumHausdorffDistanceForBoundaryMm(hausdorff.MaximumForVolumeMm);
+    this->SegmentComparisonNode->SetAverageHausdorffDistanceForVolumeMm(hausdorff.AverageForVolumeMm);
+    this->SegmentComparisonNode->SetAverageHausdorffDistanceForBoundaryMm(hausdorff.AverageForBoundaryMm);
+    this->SegmentComparisonNode->SetPercent95HausdorffDistanceForVolumeMm(hausdorff.Percent95ForVolumeMm);
+    this->SegmentComparisonNode->SetPercent95HausdorffDistanceForBoundaryMm(hausdorff.Percent95ForBoundaryMm);
+    this->SegmentComparisonNode->HausdorffResultsValidOn();
+
+    if (this->LogSpeedMeasurements)
+    {
+      double checkpointEnd = timer->GetUniversalTime();
+      UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
+      vtkDebugMacro("ComputeHausdorffDistances: Total Hausdorff computation time: " << checkpointEnd-checkpointStart << " s\n"
+        << "\tApplying transforms: " << checkpointHausdorffStart-checkpointStart << " s\n"
+        << "\tHausdorff computation: " << checkpointEnd-checkpointHausdorffStart << " s");
+    }
+
+    return "";
+  }
+
   // Convert input images to the format Plastimatch can use
   Plm_image::Pointer plmRefSegmentLabelmap;
   Plm_image::Pointer plmCmpSegmentLabelmap;
@@ -489,3 +1545,34 @@ std::string vtkSlicerSegmentComparisonModuleLogic::ComputeHausdorffDistances()
 
   return "";
 }
+
+//---------------------------------------------------------------------------
+std::string vtkSlicerSegmentComparisonModuleLogic::ComputeSegmentComparisonTable(
+  vtkMRMLSegmentationNode* referenceSegmentationNode, vtkMRMLSegmentationNode* compareSegmentationNode,
+  vtkMRMLTableNode* tableNode, bool matchingNamesOnly/*=false*/ )
+{
+  if ( !referenceSegmentationNode || !referenceSegmentationNode->GetSegmentation()
+    || !compareSegmentationNode || !compareSegmentationNode->GetSegmentation() || !tableNode )
+  {
+    std::string errorMessage("Invalid segmentation or table node");
+    vtkErrorMacro("ComputeSegmentComparisonTable: " << errorMessage);
+    return errorMessage;
+  }
+
+  vtkSmartPointer<vtkTimerLog> timer = vtkSmartPointer<vtkTimerLog>::New();
+  double checkpointStart = timer->GetUniversalTime();
+  UNUSED_VARIABLE(checkpointStart); // Although it is used later, a warning is logged so needs to be suppressed
+
+  std::string errorMessage = this->LogicPrivate->ComputeSegmentComparisonTable(
+    referenceSegmentationNode, compareSegmentationNode, tableNode, matchingNamesOnly );
+
+  if (this->LogSpeedMeasurements && errorMessage.empty())
+  {
+    double checkpointEnd = timer->GetUniversalTime();
+    UNUSED_VARIABLE(checkpointEnd); // Although it is used just below, a warning is logged so needs to be suppressed
+    vtkDebugMacro("ComputeSegmentComparisonTable: Total comparison time for "
+      << tableNode->GetTable()->GetNumberOfRows() << " segment pairs: " << checkpointEnd-checkpointStart << " s");
+  }
+
+  return errorMessage;
+}
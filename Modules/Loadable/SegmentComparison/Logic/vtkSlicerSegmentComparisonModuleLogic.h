@@ -33,6 +33,8 @@
 #include "vtkSlicerSegmentComparisonModuleLogicExport.h"
 
 class vtkMRMLSegmentComparisonNode;
+class vtkMRMLSegmentationNode;
+class vtkMRMLTableNode;
 class vtkSlicerSegmentComparisonModuleLogicPrivate;
 
 /// \ingroup SlicerRt_QtModules_SegmentComparison
@@ -53,6 +55,16 @@ public:
   /// \return Error message, empty string if no error
   std::string ComputeHausdorffDistances();
 
+  /// Compare every segment of the reference segmentation with every segment of the compare segmentation
+  /// in one operation. Each segment is resampled to the common geometry once, the distance maps of a segment
+  /// are shared by all of its pairs, and the pairs are processed concurrently. The table gets one row per
+  /// segment pair, with the Dice statistics and the Hausdorff distances of the single comparison in the columns.
+  /// The Hausdorff distances of a pair containing an empty segment are NaN.
+  /// \param matchingNamesOnly Only compare the segments that have the same name in both segmentations
+  /// \return Error message, empty string if no error
+  std::string ComputeSegmentComparisonTable(vtkMRMLSegmentationNode* referenceSegmentationNode,
+    vtkMRMLSegmentationNode* compareSegmentationNode, vtkMRMLTableNode* tableNode, bool matchingNamesOnly=false);
+
 public:
   void SetAndObserveSegmentComparisonNode(vtkMRMLSegmentComparisonNode* node);
   vtkGetObjectMacro(SegmentComparisonNode, vtkMRMLSegmentComparisonNode);
@@ -61,6 +73,12 @@ public:
   vtkSetMacro(LogSpeedMeasurements, bool);
   vtkBooleanMacro(LogSpeedMeasurements, bool);
 
+  /// Compute the metrics directly on the segment labelmaps (default). If disabled, then the
+  /// labelmaps are converted to plastimatch images and the plastimatch routines are used.
+  vtkGetMacro(UseNativeComputation, bool);
+  vtkSetMacro(UseNativeComputation, bool);
+  vtkBooleanMacro(UseNativeComputation, bool);
+
 protected:
   /// Set private logic implementation
   void SetLogicPrivate(vtkSlicerSegmentComparisonModuleLogicPrivate* logicPrivate);
@@ -91,6 +109,9 @@ protected:
   /// Flag telling whether the speed measurements are logged on standard output
   bool LogSpeedMeasurements;
 
+  /// Flag telling whether the metrics are computed natively or by plastimatch
+  bool UseNativeComputation;
+
   /// Private implementation class for the logic
   vtkSlicerSegmentComparisonModuleLogicPrivate* LogicPrivate;
 };
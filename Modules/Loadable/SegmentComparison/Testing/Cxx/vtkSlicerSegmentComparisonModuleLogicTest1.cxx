@@ -24,6 +24,7 @@
 
 // Segmentations includes
 #include "vtkMRMLSegmentationNode.h"
+#include "vtkSegment.h"
 #include "vtkSlicerSegmentationsModuleLogic.h"
 
 // SlicerRt includes
@@ -42,12 +43,15 @@
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLLinearTransformNode.h>
 #include <vtkMRMLScene.h>
+#include <vtkMRMLTableNode.h>
 
 // VTK includes
 #include <vtkNew.h>
 #include <vtkImageData.h>
 #include <vtkImageAccumulate.h>
 #include <vtkImageMathematics.h>
+#include <vtkMath.h>
+#include <vtkTable.h>
 
 // ITK includes
 #include "itkFactoryRegistration.h"
@@ -56,6 +60,9 @@
 #include <vtksys/SystemTools.hxx>
 
 bool CheckIfResultIsWithinOneTenthPercentFromBaseline(double result, double baseline);
+void AddCubeSegment(vtkSegmentation* segmentation, const char* name, int cubeExtent[6]);
+int CheckComparisonTableRow(vtkTable* table, vtkIdType row, const char* referenceName, const char* compareName,
+  double diceCoefficient, bool hausdorffValid);
 
 //-----------------------------------------------------------------------------
 int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
@@ -432,7 +439,8 @@ int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
   segmentComparisonLogic->SetMRMLScene(mrmlScene);
   segmentComparisonLogic->SetAndObserveSegmentComparisonNode(paramNode);
 
-  // Compute Dice and Hausdorff
+  // Compute Dice and Hausdorff with plastimatch, which the baselines were created with
+  segmentComparisonLogic->UseNativeComputationOff();
   std::string errorMessageDice = segmentComparisonLogic->ComputeDiceStatistics();
   std::string errorMessageHausdorff = segmentComparisonLogic->ComputeHausdorffDistances();
 
@@ -497,9 +505,260 @@ int vtkSlicerSegmentComparisonModuleLogicTest1( int argc, char * argv[] )
     result = EXIT_FAILURE;
   }
 
+  // Compute Dice and Hausdorff natively on the segment labelmaps
+  segmentComparisonLogic->UseNativeComputationOn();
+  errorMessageDice = segmentComparisonLogic->ComputeDiceStatistics();
+  errorMessageHausdorff = segmentComparisonLogic->ComputeHausdorffDistances();
+  if (!paramNode->GetHausdorffResultsValid() || !paramNode->GetDiceResultsValid())
+  {
+    std::cerr << "Failed to compute results natively: " << errorMessageDice << " " << errorMessageHausdorff << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The Dice coefficient does not depend on the extent the voxels are counted in
+  double nativeDiceCoefficient = paramNode->GetDiceCoefficient();
+  if (fabs(nativeDiceCoefficient - resultDiceCoefficient) > 0.01 * resultDiceCoefficient)
+  {
+    std::cerr << "Native Dice coefficient mismatch: " << nativeDiceCoefficient << " instead of " << resultDiceCoefficient << std::endl;
+    result = EXIT_FAILURE;
+  }
+  double nativePercentSum = paramNode->GetTruePositivesPercent() + paramNode->GetTrueNegativesPercent()
+    + paramNode->GetFalsePositivesPercent() + paramNode->GetFalseNegativesPercent();
+  if (fabs(nativePercentSum - 100.0) > 0.0001)
+  {
+    std::cerr << "Native Dice percentages sum up to " << nativePercentSum << " instead of 100" << std::endl;
+    result = EXIT_FAILURE;
+  }
+
+  // The native and the plastimatch Hausdorff distances use different boundary voxel definitions,
+  // the native distances have to match the plastimatch baselines within one voxel diagonal of the reference
+  vtkOrientedImageData* referenceImageData = vtkOrientedImageData::SafeDownCast(
+    referenceSegmentationNode->GetSegmentation()->GetSegment(referenceSegmentID)->GetRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
+  if (!referenceImageData)
+  {
+    std::cerr << "Failed to retrieve binary labelmap representation from the reference segmentation!" << std::endl;
+    return EXIT_FAILURE;
+  }
+  double referenceSpacing[3] = {1.0, 1.0, 1.0};
+  referenceImageData->GetSpacing(referenceSpacing);
+  double voxelDiagonalMm = sqrt( referenceSpacing[0]*referenceSpacing[0]
+    + referenceSpacing[1]*referenceSpacing[1] + referenceSpacing[2]*referenceSpacing[2] );
+
+  double nativeHausdorffMaximumMm = paramNode->GetMaximumHausdorffDistanceForBoundaryMm();
+  if (fabs(nativeHausdorffMaximumMm - hausdorffMaximumMm) > voxelDiagonalMm)
+  {
+    std::cerr << "Native Hausdorff maximum (mm) mismatch: " << nativeHausdorffMaximumMm << " instead of " << hausdorffMaximumMm
+      << " (tolerance: " << voxelDiagonalMm << ")" << std::endl;
+    result = EXIT_FAILURE;
+  }
+  double nativeHausdorffAverageMm = paramNode->GetAverageHausdorffDistanceForBoundaryMm();
+  if (fabs(nativeHausdorffAverageMm - hausdorffAverageMm) > voxelDiagonalMm)
+  {
+    std::cerr << "Native Hausdorff average (mm) mismatch: " << nativeHausdorffAverageMm << " instead of " << hausdorffAverageMm
+      << " (tolerance: " << voxelDiagonalMm << ")" << std::endl;
+    result = EXIT_FAILURE;
+  }
+  double nativeHausdorff95PercentMm = paramNode->GetPercent95HausdorffDistanceForBoundaryMm();
+  if (fabs(nativeHausdorff95PercentMm - hausdorff95PercentMm) > voxelDiagonalMm)
+  {
+    std::cerr << "Native Hausdorff 95% (mm) mismatch: " << nativeHausdorff95PercentMm << " instead of " << hausdorff95PercentMm
+      << " (tolerance: " << voxelDiagonalMm << ")" << std::endl;
+    result = EXIT_FAILURE;
+  }
+
+  // The batch comparison of the two single-segment segmentations gives the results of the native comparison
+  vtkSmartPointer<vtkMRMLTableNode> comparisonTableNode = vtkSmartPointer<vtkMRMLTableNode>::New();
+  mrmlScene->AddNode(comparisonTableNode);
+  std::string errorMessageTable = segmentComparisonLogic->ComputeSegmentComparisonTable(
+    referenceSegmentationNode, compareSegmentationNode, comparisonTableNode );
+  vtkTable* comparisonTable = comparisonTableNode->GetTable();
+  if (!errorMessageTable.empty() || comparisonTable->GetNumberOfRows() != 1)
+  {
+    std::cerr << "Failed to compute comparison table: " << errorMessageTable << std::endl;
+    return EXIT_FAILURE;
+  }
+  double tableDiceCoefficient = comparisonTable->GetValueByName(0, "Dice coefficient").ToDouble();
+  if (fabs(tableDiceCoefficient - nativeDiceCoefficient) > 1e-6)
+  {
+    std::cerr << "Comparison table Dice coefficient mismatch: " << tableDiceCoefficient << " instead of " << nativeDiceCoefficient << std::endl;
+    result = EXIT_FAILURE;
+  }
+  double tableHausdorffMaximumMm = comparisonTable->GetValueByName(0, "Maximum Hausdorff distance for boundary (mm)").ToDouble();
+  if (fabs(tableHausdorffMaximumMm - nativeHausdorffMaximumMm) > 1e-6)
+  {
+    std::cerr << "Comparison table Hausdorff maximum mismatch: " << tableHausdorffMaximumMm << " instead of " << nativeHausdorffMaximumMm << std::endl;
+    result = EXIT_FAILURE;
+  }
+
+  // Batch comparison of multiple segments: cubes of 10 voxels on a 30 voxel grid, and an empty segment in each segmentation.
+  // Compare cube A is shifted by 2 voxels along X from reference cube A, reference cube B touches compare cube A on 2 slices,
+  // compare cube C does not overlap any reference cube.
+  int referenceCubeAExtent[6] = {5,14, 5,14, 5,14};
+  int referenceCubeBExtent[6] = {15,24, 5,14, 5,14};
+  int compareCubeAExtent[6] = {7,16, 5,14, 5,14};
+  int compareCubeCExtent[6] = {5,14, 15,24, 5,14};
+  int emptyExtent[6] = {0,-1, 0,-1, 0,-1};
+  vtkSmartPointer<vtkMRMLSegmentationNode> referenceCubesSegmentationNode = vtkSmartPointer<vtkMRMLSegmentationNode>::New();
+  mrmlScene->AddNode(referenceCubesSegmentationNode);
+  AddCubeSegment(referenceCubesSegmentationNode->GetSegmentation(), "A", referenceCubeAExtent);
+  AddCubeSegment(referenceCubesSegmentationNode->GetSegmentation(), "B", referenceCubeBExtent);
+  AddCubeSegment(referenceCubesSegmentationNode->GetSegmentation(), "Empty", emptyExtent);
+  vtkSmartPointer<vtkMRMLSegmentationNode> compareCubesSegmentationNode = vtkSmartPointer<vtkMRMLSegmentationNode>::New();
+  mrmlScene->AddNode(compareCubesSegmentationNode);
+  AddCubeSegment(compareCubesSegmentationNode->GetSegmentation(), "A", compareCubeAExtent);
+  AddCubeSegment(compareCubesSegmentationNode->GetSegmentation(), "C", compareCubeCExtent);
+  AddCubeSegment(compareCubesSegmentationNode->GetSegmentation(), "Empty", emptyExtent);
+
+  // Every reference segment against every compare segment, in the order of the reference segments
+  errorMessageTable = segmentComparisonLogic->ComputeSegmentComparisonTable(
+    referenceCubesSegmentationNode, compareCubesSegmentationNode, comparisonTableNode );
+  comparisonTable = comparisonTableNode->GetTable();
+  if (!errorMessageTable.empty() || comparisonTable->GetNumberOfRows() != 9)
+  {
+    std::cerr << "Failed to compute comparison table of all segment pairs: " << errorMessageTable
+      << " (" << comparisonTable->GetNumberOfRows() << " rows instead of 9)" << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char* referenceNames[3] = { "A", "B", "Empty" };
+  const char* compareNames[3] = { "A", "C", "Empty" };
+  // Dice coefficients: 2*800/2000 for the shifted cubes, 2*200/2000 for the cubes touching on 2 slices
+  double diceCoefficients[3][3] = { {0.8, 0.0, 0.0}, {0.2, 0.0, 0.0}, {0.0, 0.0, 0.0} };
+  for (int referenceIndex = 0; referenceIndex < 3; ++referenceIndex)
+  {
+    for (int compareIndex = 0; compareIndex < 3; ++compareIndex)
+    {
+      // The Hausdorff distances of the pairs with an empty segment are NaN
+      if (CheckComparisonTableRow(comparisonTable, 3*referenceIndex + compareIndex,
+        referenceNames[referenceIndex], compareNames[compareIndex], diceCoefficients[referenceIndex][compareIndex],
+        referenceIndex < 2 && compareIndex < 2) != EXIT_SUCCESS)
+      {
+        result = EXIT_FAILURE;
+      }
+    }
+  }
+
+  // The row of the shifted cubes gives the results of the single native comparison
+  paramNode->SetAndObserveReferenceSegmentationNode(referenceCubesSegmentationNode);
+  paramNode->SetReferenceSegmentID("A");
+  paramNode->SetAndObserveCompareSegmentationNode(compareCubesSegmentationNode);
+  paramNode->SetCompareSegmentID("A");
+  errorMessageDice = segmentComparisonLogic->ComputeDiceStatistics();
+  errorMessageHausdorff = segmentComparisonLogic->ComputeHausdorffDistances();
+  if (!paramNode->GetHausdorffResultsValid() || !paramNode->GetDiceResultsValid())
+  {
+    std::cerr << "Failed to compare the cube segments natively: " << errorMessageDice << " " << errorMessageHausdorff << std::endl;
+    return EXIT_FAILURE;
+  }
+  double cubesMetrics[4][2] = {
+    { comparisonTable->GetValueByName(0, "Dice coefficient").ToDouble(), paramNode->GetDiceCoefficient() },
+    { comparisonTable->GetValueByName(0, "Maximum Hausdorff distance for boundary (mm)").ToDouble(), paramNode->GetMaximumHausdorffDistanceForBoundaryMm() },
+    { comparisonTable->GetValueByName(0, "Average Hausdorff distance for boundary (mm)").ToDouble(), paramNode->GetAverageHausdorffDistanceForBoundaryMm() },
+    { comparisonTable->GetValueByName(0, "95% Hausdorff distance for boundary (mm)").ToDouble(), paramNode->GetPercent95HausdorffDistanceForBoundaryMm() } };
+  for (int metricIndex = 0; metricIndex < 4; ++metricIndex)
+  {
+    if (fabs(cubesMetrics[metricIndex][0] - cubesMetrics[metricIndex][1]) > 1e-6)
+    {
+      std::cerr << "Comparison table metric " << metricIndex << " mismatch for the cube segments: "
+        << cubesMetrics[metricIndex][0] << " instead of " << cubesMetrics[metricIndex][1] << std::endl;
+      result = EXIT_FAILURE;
+    }
+  }
+
+  // Only the segments with the same name are compared
+  errorMessageTable = segmentComparisonLogic->ComputeSegmentComparisonTable(
+    referenceCubesSegmentationNode, compareCubesSegmentationNode, comparisonTableNode, true );
+  comparisonTable = comparisonTableNode->GetTable();
+  if (!errorMessageTable.empty() || comparisonTable->GetNumberOfRows() != 2)
+  {
+    std::cerr << "Failed to compute comparison table of the segments with matching names: " << errorMessageTable
+      << " (" << comparisonTable->GetNumberOfRows() << " rows instead of 2)" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if ( CheckComparisonTableRow(comparisonTable, 0, "A", "A", 0.8, true) != EXIT_SUCCESS
+    || CheckComparisonTableRow(comparisonTable, 1, "Empty", "Empty", 0.0, false) != EXIT_SUCCESS )
+  {
+    result = EXIT_FAILURE;
+  }
+
+  // No pair if none of the names match
+  vtkSmartPointer<vtkMRMLSegmentationNode> otherNamesSegmentationNode = vtkSmartPointer<vtkMRMLSegmentationNode>::New();
+  mrmlScene->AddNode(otherNamesSegmentationNode);
+  AddCubeSegment(otherNamesSegmentationNode->GetSegmentation(), "D", compareCubeAExtent);
+  errorMessageTable = segmentComparisonLogic->ComputeSegmentComparisonTable(
+    referenceCubesSegmentationNode, otherNamesSegmentationNode, comparisonTableNode, true );
+  if (errorMessageTable.empty())
+  {
+    std::cerr << "Comparison table computed without segment pairs" << std::endl;
+    result = EXIT_FAILURE;
+  }
+
   return result;
 }
 
+//-----------------------------------------------------------------------------
+void AddCubeSegment(vtkSegmentation* segmentation, const char* name, int cubeExtent[6])
+{
+  vtkSmartPointer<vtkOrientedImageData> labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  labelmap->SetExtent(0, 29, 0, 29, 0, 29);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* voxelPtr = static_cast<unsigned char*>(labelmap->GetScalarPointer());
+  for (int k = 0; k < 30; ++k)
+  {
+    for (int j = 0; j < 30; ++j)
+    {
+      for (int i = 0; i < 30; ++i, ++voxelPtr)
+      {
+        bool inside = ( i >= cubeExtent[0] && i <= cubeExtent[1] && j >= cubeExtent[2] && j <= cubeExtent[3]
+          && k >= cubeExtent[4] && k <= cubeExtent[5] );
+        *voxelPtr = (inside ? 1 : 0);
+      }
+    }
+  }
+
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
+  vtkSmartPointer<vtkSegment> segment = vtkSmartPointer<vtkSegment>::New();
+  segment->SetName(name);
+  segment->AddRepresentation(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName(), labelmap);
+  segmentation->AddSegment(segment, name);
+}
+
+//-----------------------------------------------------------------------------
+int CheckComparisonTableRow(vtkTable* table, vtkIdType row, const char* referenceName, const char* compareName,
+  double diceCoefficient, bool hausdorffValid)
+{
+  std::string tableReferenceName = table->GetValueByName(row, "Reference segment").ToString();
+  std::string tableCompareName = table->GetValueByName(row, "Compare segment").ToString();
+  if (tableReferenceName != referenceName || tableCompareName != compareName)
+  {
+    std::cerr << "Comparison table row " << row << " compares " << tableReferenceName << " with " << tableCompareName
+      << " instead of " << referenceName << " with " << compareName << std::endl;
+    return EXIT_FAILURE;
+  }
+  double tableDiceCoefficient = table->GetValueByName(row, "Dice coefficient").ToDouble();
+  if (fabs(tableDiceCoefficient - diceCoefficient) > 1e-6)
+  {
+    std::cerr << "Comparison table Dice coefficient mismatch for " << referenceName << " and " << compareName << ": "
+      << tableDiceCoefficient << " instead of " << diceCoefficient << std::endl;
+    return EXIT_FAILURE;
+  }
+  const char* hausdorffNames[6] = {
+    "Maximum Hausdorff distance for volume (mm)", "Maximum Hausdorff distance for boundary (mm)",
+    "Average Hausdorff distance for volume (mm)", "Average Hausdorff distance for boundary (mm)",
+    "95% Hausdorff distance for volume (mm)", "95% Hausdorff distance for boundary (mm)" };
+  for (int hausdorffIndex = 0; hausdorffIndex < 6; ++hausdorffIndex)
+  {
+    double distance = table->GetValueByName(row, hausdorffNames[hausdorffIndex]).ToDouble();
+    if (vtkMath::IsNan(distance) == hausdorffValid || (hausdorffValid && distance < 0.0))
+    {
+      std::cerr << "Comparison table " << hausdorffNames[hausdorffIndex] << " for " << referenceName << " and " << compareName
+        << " is " << distance << ", " << (hausdorffValid ? "a distance" : "NaN") << " is expected" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
 //-----------------------------------------------------------------------------
 bool CheckIfResultIsWithinOneTenthPercentFromBaseline(double result, double baseline)
 {
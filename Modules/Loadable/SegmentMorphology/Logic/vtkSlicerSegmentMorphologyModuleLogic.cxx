@@ -31,6 +31,7 @@
 
 // SlicerRT includes
 #include "SlicerRtCommon.h"
+#include "vtkLabelmapMarginFilter.h"
 
 // MRML includes
 #include <vtkMRMLScene.h>
@@ -38,8 +39,6 @@
 // VTK includes
 #include <vtkGeneralTransform.h>
 #include <vtkImageAccumulate.h>
-#include <vtkImageContinuousDilate3D.h>
-#include <vtkImageContinuousErode3D.h>
 #include <vtkImageLogic.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
@@ -341,19 +340,11 @@ std::string vtkSlicerSegmentMorphologyModuleLogic::ApplyMorphologyOperation()
     imageB->vtkImageData::DeepCopy(padder->GetOutput());
   }
 
-  // Get kernel size
-  double spacingA[3] = {0.0,0.0,0.0};
-  imageA->GetSpacing(spacingA);
-
+  // Get margin size
   double xSize = this->GetSegmentMorphologyNode()->GetXSize();
   double ySize = this->GetSegmentMorphologyNode()->GetYSize();
   double zSize = this->GetSegmentMorphologyNode()->GetZSize();
 
-  int kernelSize[3] = {1,1,1};
-  kernelSize[0] = (int)( 2.0*(xSize/spacingA[0] + 0.5) );
-  kernelSize[1] = (int)( 2.0*(ySize/spacingA[1] + 0.5) );
-  kernelSize[2] = (int)( 2.0*(zSize/spacingA[2] + 0.5) );
-
   // Apply operation on image data
   vtkSmartPointer<vtkImageAccumulate> histogram = vtkSmartPointer<vtkImageAccumulate>::New();
   histogram->SetInputData(imageA);
@@ -363,36 +354,26 @@ std::string vtkSlicerSegmentMorphologyModuleLogic::ApplyMorphologyOperation()
   vtkSmartPointer<vtkImageData> tempOutputImageData = NULL;
   switch (operation) 
   {
-  // Expand
+  // Expand, Shrink
   case vtkMRMLSegmentMorphologyNode::Expand:
+  case vtkMRMLSegmentMorphologyNode::Shrink:
     {
-    // Pad image by expansion extent (extents are fitted to the structure, dilate will reach the edge of the image)
-    vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
-    padder->SetInputData(imageA);
-    int extent[6] = {0,-1,0,-1,0,-1};
-    imageA->GetExtent(extent);
-
-    // Now set the output extent to the new size
-    int expansionExtent[3] = { int(xSize/spacingA[0] + 1.0), int(ySize/spacingA[1] + 1.0), int(zSize/spacingA[2] + 1.0) }; // Rounding up
-    padder->SetOutputWholeExtent(extent[0]-expansionExtent[0], extent[1]+expansionExtent[0], extent[2]-expansionExtent[1], extent[3]+expansionExtent[1], extent[4]-expansionExtent[2], extent[5]+expansionExtent[2]);
-    padder->Update();
-
-    vtkSmartPointer<vtkImageContinuousDilate3D> dilateFilter = vtkSmartPointer<vtkImageContinuousDilate3D>::New();
-    dilateFilter->SetInputConnection(padder->GetOutputPort());
-    dilateFilter->SetKernelSize(kernelSize[0], kernelSize[1], kernelSize[2]);
-    dilateFilter->Update();
-    tempOutputImageData = dilateFilter->GetOutput();
-    break;
+    // Ellipsoidal margin computed from a distance map, the run time does not depend on the margin size.
+    // The expanded labelmap is padded by the margin so that the structure is not cropped.
+    vtkSmartPointer<vtkLabelmapMarginFilter> marginFilter = vtkSmartPointer<vtkLabelmapMarginFilter>::New();
+    marginFilter->SetInputLabelmap(imageA);
+    marginFilter->SetMarginSize(xSize, ySize, zSize);
+    if (operation == vtkMRMLSegmentMorphologyNode::Expand)
+    {
+      marginFilter->SetOperationToExpand();
     }
-
-  // Shrink
-  case vtkMRMLSegmentMorphologyNode::Shrink:
+    else
     {
-    vtkSmartPointer<vtkImageContinuousErode3D> erodeFilter = vtkSmartPointer<vtkImageContinuousErode3D>::New();
-    erodeFilter->SetInputData(imageA);
-    erodeFilter->SetKernelSize(kernelSize[0], kernelSize[1], kernelSize[2]);
-    erodeFilter->Update();
-    tempOutputImageData = erodeFilter->GetOutput();
+      marginFilter->SetOperationToShrink();
+    }
+    marginFilter->SetLabelValue(valueMax);
+    marginFilter->Update();
+    tempOutputImageData = marginFilter->GetOutput();
     break;
     }
 
@@ -0,0 +1,160 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SlicerRt includes
+#include "vtkLabelmapMarginFilter.h"
+
+// SegmentMorphology testing includes
+#include "vtkLabelmapMarginTestingUtilities.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+//----------------------------------------------------------------------------
+/// Random voxels around a solid block, so that shrinking leaves something
+void CreateLabelmap(vtkImageData* labelmap, int extent[6], double spacing[3])
+{
+  labelmap->SetExtent(extent);
+  labelmap->SetSpacing(spacing);
+  labelmap->SetOrigin(-5.0, 3.0, 10.0);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkMath::RandomSeed(44);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+    {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+      {
+        bool inBlock = (i > extent[0] + 3 && i < extent[1] - 3 && j > extent[2] + 2 && j < extent[3] - 2
+          && k > extent[4] + 1 && k < extent[5] - 1);
+        unsigned char* voxel = static_cast<unsigned char*>(labelmap->GetScalarPointer(i, j, k));
+        *voxel = (inBlock || vtkMath::Random() < 0.1 ? 1 : 0);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int TestMargin(vtkImageData* labelmap, double marginSize[3], int operation, int numberOfThreads)
+{
+  bool shrink = (operation == vtkLabelmapMarginFilter::Shrink);
+  const unsigned char labelValue = 2;
+
+  vtkNew<vtkLabelmapMarginFilter> marginFilter;
+  marginFilter->SetInputLabelmap(labelmap);
+  marginFilter->SetMarginSize(marginSize);
+  marginFilter->SetOperation(operation);
+  marginFilter->SetLabelValue(labelValue);
+  marginFilter->SetNumberOfThreads(numberOfThreads);
+  marginFilter->Update();
+  vtkImageData* output = marginFilter->GetOutput();
+
+  // The expanded labelmap is padded by the margin, the shrunk one keeps the input extent
+  vtkNew<vtkImageData> reference;
+  vtkLabelmapMarginTestingUtilities::ComputeMarginReference(labelmap, marginSize, shrink, reference.GetPointer());
+  int expectedExtent[6] = {0,-1,0,-1,0,-1};
+  reference->GetExtent(expectedExtent);
+  int outputExtent[6] = {0,-1,0,-1,0,-1};
+  output->GetExtent(outputExtent);
+  for (int i = 0; i < 6; ++i)
+  {
+    if (outputExtent[i] != expectedExtent[i])
+    {
+      std::cerr << "Line " << __LINE__ << ": unexpected output extent: "
+        << outputExtent[0] << " " << outputExtent[1] << " " << outputExtent[2] << " "
+        << outputExtent[3] << " " << outputExtent[4] << " " << outputExtent[5] << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (output->GetScalarType() != VTK_UNSIGNED_CHAR)
+  {
+    std::cerr << "Line " << __LINE__ << ": output scalar type is " << output->GetScalarTypeAsString() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  int numberOfStructureVoxels = 0;
+  for (int k = outputExtent[4]; k <= outputExtent[5]; ++k)
+  {
+    for (int j = outputExtent[2]; j <= outputExtent[3]; ++j)
+    {
+      for (int i = outputExtent[0]; i <= outputExtent[1]; ++i)
+      {
+        bool expectedStructure = (*static_cast<unsigned char*>(reference->GetScalarPointer(i, j, k)) != 0);
+        unsigned char value = *static_cast<unsigned char*>(output->GetScalarPointer(i, j, k));
+        if (value != (expectedStructure ? labelValue : 0))
+        {
+          std::cerr << "Line " << __LINE__ << ": " << (shrink ? "shrink" : "expand") << " with margin "
+            << marginSize[0] << " " << marginSize[1] << " " << marginSize[2] << " and " << numberOfThreads
+            << " threads: voxel " << i << " " << j << " " << k << " is " << (int)value << " instead of "
+            << (expectedStructure ? (int)labelValue : 0) << std::endl;
+          return EXIT_FAILURE;
+        }
+        if (expectedStructure)
+        {
+          ++numberOfStructureVoxels;
+        }
+      }
+    }
+  }
+  if (numberOfStructureVoxels == 0)
+  {
+    std::cerr << "Line " << __LINE__ << ": empty output, the test labelmap is too small" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+}
+
+//----------------------------------------------------------------------------
+int vtkLabelmapMarginFilterTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  // Small anisotropic volume with an extent that does not start at 0
+  vtkNew<vtkImageData> labelmap;
+  int extent[6] = {2, 21, -3, 12, 0, 9};
+  double spacing[3] = {0.7, 1.0, 2.5};
+  CreateLabelmap(labelmap.GetPointer(), extent, spacing);
+
+  // Anisotropic margins, with a margin that is a multiple of the spacing (voxels on the margin boundary)
+  double ellipsoidMargin[3] = {2.0, 3.0, 5.0};
+  // Spherical margin
+  double sphereMargin[3] = {2.6, 2.6, 2.6};
+  // No margin along Y
+  double planarMargin[3] = {1.5, 0.0, 2.5};
+  double* margins[3] = {ellipsoidMargin, sphereMargin, planarMargin};
+
+  int operations[2] = {vtkLabelmapMarginFilter::Expand, vtkLabelmapMarginFilter::Shrink};
+  for (int marginIndex = 0; marginIndex < 3; ++marginIndex)
+  {
+    for (int operationIndex = 0; operationIndex < 2; ++operationIndex)
+    {
+      // The lines of each axis are split between the threads, the result must not depend on them
+      if (TestMargin(labelmap.GetPointer(), margins[marginIndex], operations[operationIndex], 1) != EXIT_SUCCESS
+        || TestMargin(labelmap.GetPointer(), margins[marginIndex], operations[operationIndex], 4) != EXIT_SUCCESS)
+      {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkLabelmapMarginTestingUtilities_h
+#define __vtkLabelmapMarginTestingUtilities_h
+
+// VTK includes
+#include <vtkImageData.h>
+
+// STD includes
+#include <cmath>
+
+/// Brute force ellipsoidal margin that the Expand and Shrink outputs are compared to.
+/// A voxel is within the margin if the voxel offset scaled by spacing/margin is at most 1 long.
+namespace vtkLabelmapMarginTestingUtilities
+{
+
+/// Same tolerance as vtkLabelmapMarginFilter, the voxels at exactly the margin distance are within the margin
+const double MARGIN_TOLERANCE = 1e-6;
+
+//----------------------------------------------------------------------------
+/// True if the voxel is in the labelmap extent and not 0
+inline bool IsForeground(vtkImageData* labelmap, int i, int j, int k)
+{
+  int extent[6] = {0,-1,0,-1,0,-1};
+  labelmap->GetExtent(extent);
+  if (i < extent[0] || i > extent[1] || j < extent[2] || j > extent[3] || k < extent[4] || k > extent[5])
+  {
+    return false;
+  }
+  return labelmap->GetScalarComponentAsDouble(i, j, k, 0) != 0.0;
+}
+
+//----------------------------------------------------------------------------
+/// Number of voxels the margin reaches along an axis
+inline int GetMarginRadius(double marginSize, double spacing)
+{
+  return (marginSize > 0.0 ? static_cast<int>(floor(marginSize / fabs(spacing) + MARGIN_TOLERANCE)) : 0);
+}
+
+//----------------------------------------------------------------------------
+/// True if a structure voxel (expand) or a background voxel (shrink) is within the margin
+inline bool IsReachedByMargin(vtkImageData* labelmap, int i, int j, int k, double marginSize[3], bool shrink)
+{
+  double spacing[3] = {1.0, 1.0, 1.0};
+  labelmap->GetSpacing(spacing);
+  int radius[3] = { GetMarginRadius(marginSize[0], spacing[0]), GetMarginRadius(marginSize[1], spacing[1]),
+    GetMarginRadius(marginSize[2], spacing[2]) };
+  for (int dk = -radius[2]; dk <= radius[2]; ++dk)
+  {
+    for (int dj = -radius[1]; dj <= radius[1]; ++dj)
+    {
+      for (int di = -radius[0]; di <= radius[0]; ++di)
+      {
+        int offset[3] = {di, dj, dk};
+        double squaredDistance = 0.0;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+          if (offset[axis] != 0)
+          {
+            double distance = offset[axis] * spacing[axis] / marginSize[axis];
+            squaredDistance += distance * distance;
+          }
+        }
+        if (squaredDistance <= 1.0 + MARGIN_TOLERANCE && IsForeground(labelmap, i + di, j + dj, k + dk) != shrink)
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+/// Compute the expanded or shrunk labelmap into an unsigned char image with the spacing and origin of the input,
+/// structure voxels are 1. The expanded labelmap is padded by the margin, the voxels outside the input are background.
+/// The shrunk labelmap keeps the input extent.
+inline void ComputeMarginReference(vtkImageData* input, double marginSize[3], bool shrink, vtkImageData* reference)
+{
+  double spacing[3] = {1.0, 1.0, 1.0};
+  input->GetSpacing(spacing);
+  int inputExtent[6] = {0,-1,0,-1,0,-1};
+  input->GetExtent(inputExtent);
+  int extent[6] = {0,-1,0,-1,0,-1};
+  for (int axis = 0; axis < 3; ++axis)
+  {
+    int padding = (shrink ? 0 : GetMarginRadius(marginSize[axis], spacing[axis]));
+    extent[2*axis] = inputExtent[2*axis] - padding;
+    extent[2*axis+1] = inputExtent[2*axis+1] + padding;
+  }
+
+  reference->SetExtent(extent);
+  reference->SetSpacing(spacing);
+  reference->SetOrigin(input->GetOrigin());
+  reference->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int k = extent[4]; k <= extent[5]; ++k)
+  {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+    {
+      for (int i = extent[0]; i <= extent[1]; ++i)
+      {
+        bool reached = IsReachedByMargin(input, i, j, k, marginSize, shrink);
+        bool structure = (shrink ? IsForeground(input, i, j, k) && !reached : reached);
+        *static_cast<unsigned char*>(reference->GetScalarPointer(i, j, k)) = (structure ? 1 : 0);
+      }
+    }
+  }
+}
+
+}
+
+#endif
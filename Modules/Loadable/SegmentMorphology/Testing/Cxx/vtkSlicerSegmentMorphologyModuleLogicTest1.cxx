@@ -22,6 +22,7 @@
 // SegmentMorphology includes
 #include "vtkSlicerSegmentMorphologyModuleLogic.h"
 #include "vtkMRMLSegmentMorphologyNode.h"
+#include "vtkLabelmapMarginTestingUtilities.h"
 
 // SlicerRt includes
 #include "SlicerRtCommon.h"
@@ -46,6 +47,7 @@
 #include <vtkImageAccumulate.h>
 #include <vtkImageData.h>
 #include <vtkImageMathematics.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkTransform.h>
 
@@ -55,6 +57,9 @@
 // VTKSYS includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <cmath>
+
 #define MIN_VOLUME_DIFFERENCE_TOLERANCE_VOXEL 100
 
 //-----------------------------------------------------------------------------
@@ -406,37 +411,68 @@ int vtkSlicerSegmentMorphologyModuleLogicTest1( int argc, char * argv[] )
 
   mrmlScene->Commit();
 
-  // Load baseline segmentation for comparison
-  std::string baselineSegmentationFileName = std::string(dataDirectoryPath) + std::string(baselineSegmentationFile);
-  if (!vtksys::SystemTools::FileExists(baselineSegmentationFileName.c_str()))
-  {
-    std::cerr << "Loading segmentation from file '" << baselineSegmentationFileName << "' failed - the file does not exist!" << std::endl;
-  }
-  vtkMRMLSegmentationNode* baselineSegmentationNode = segmentationsLogic->LoadSegmentationFromFile(baselineSegmentationFileName.c_str());
-  if (!baselineSegmentationNode)
+  vtkOrientedImageData* outputImageData = vtkOrientedImageData::SafeDownCast(
+    outputSegmentationNode->GetSegmentation()->GetSegment(outputSegmentID)->GetRepresentation(
+      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
+
+  // Compare output to baseline. The Expand and Shrink operations are compared to a brute force
+  // ellipsoidal margin of segment A if no baseline file is given.
+  vtkOrientedImageData* baselineImageData = NULL;
+  vtkSmartPointer<vtkOrientedImageData> marginReferenceImageData = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (strlen(baselineSegmentationFile) == 0
+    && (operation == vtkMRMLSegmentMorphologyNode::Expand || operation == vtkMRMLSegmentMorphologyNode::Shrink))
   {
-    std::cerr << "Loading segmentation from existing file '" << baselineSegmentationFileName << "' failed!" << std::endl;
-    return EXIT_FAILURE;
+    if (applySimpleTransformToInput == 1)
+    {
+      std::cerr << "Margin reference cannot be computed for a transformed input segmentation!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    vtkOrientedImageData* inputImageData = vtkOrientedImageData::SafeDownCast(
+      inputSegmentationANode->GetSegmentation()->GetSegment(inputSegmentAID)->GetRepresentation(
+        vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
+    if (!inputImageData)
+    {
+      std::cerr << "Failed to retrieve binary labelmap representation from the input segmentation!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    double marginSize[3] = {morphologicalParameter, morphologicalParameter, morphologicalParameter};
+    vtkLabelmapMarginTestingUtilities::ComputeMarginReference(inputImageData, marginSize,
+      operation == vtkMRMLSegmentMorphologyNode::Shrink, marginReferenceImageData);
+    vtkSmartPointer<vtkMatrix4x4> inputImageToWorldMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    inputImageData->GetImageToWorldMatrix(inputImageToWorldMatrix);
+    marginReferenceImageData->SetGeometryFromImageToWorldMatrix(inputImageToWorldMatrix);
+    baselineImageData = marginReferenceImageData;
   }
-  // Get ID of only segment
-  if (baselineSegmentationNode->GetSegmentation()->GetNumberOfSegments() > 1)
+  else
   {
-    std::cerr << "Baseline segmentation should contain only one segment!" << std::endl;
-    return EXIT_FAILURE;
-  }
-  std::vector<std::string> baselineSegmentIDs;
-  baselineSegmentationNode->GetSegmentation()->GetSegmentIDs(baselineSegmentIDs);
-  std::string baselineSegmentID = baselineSegmentIDs[0];
+    // Load baseline segmentation for comparison
+    std::string baselineSegmentationFileName = std::string(dataDirectoryPath) + std::string(baselineSegmentationFile);
+    if (!vtksys::SystemTools::FileExists(baselineSegmentationFileName.c_str()))
+    {
+      std::cerr << "Loading segmentation from file '" << baselineSegmentationFileName << "' failed - the file does not exist!" << std::endl;
+    }
+    vtkMRMLSegmentationNode* baselineSegmentationNode = segmentationsLogic->LoadSegmentationFromFile(baselineSegmentationFileName.c_str());
+    if (!baselineSegmentationNode)
+    {
+      std::cerr << "Loading segmentation from existing file '" << baselineSegmentationFileName << "' failed!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    // Get ID of only segment
+    if (baselineSegmentationNode->GetSegmentation()->GetNumberOfSegments() > 1)
+    {
+      std::cerr << "Baseline segmentation should contain only one segment!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::vector<std::string> baselineSegmentIDs;
+    baselineSegmentationNode->GetSegmentation()->GetSegmentIDs(baselineSegmentIDs);
+    std::string baselineSegmentID = baselineSegmentIDs[0];
 
-  mrmlScene->Commit();
+    mrmlScene->Commit();
 
-  // Compare output to baseline
-  vtkOrientedImageData* baselineImageData = vtkOrientedImageData::SafeDownCast(
-    baselineSegmentationNode->GetSegmentation()->GetSegment(baselineSegmentID)->GetRepresentation(
-      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
-  vtkOrientedImageData* outputImageData = vtkOrientedImageData::SafeDownCast(
-    outputSegmentationNode->GetSegmentation()->GetSegment(outputSegmentID)->GetRepresentation(
-      vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
+    baselineImageData = vtkOrientedImageData::SafeDownCast(
+      baselineSegmentationNode->GetSegmentation()->GetSegment(baselineSegmentID)->GetRepresentation(
+        vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName() ) );
+  }
   if (!baselineImageData || !outputImageData)
   {
     std::cerr << "Failed to retrieve binary labelmap representation from the baseline or the output segmentation!" << std::endl;
@@ -447,15 +447,14 @@ vtkImageData* qMRMLEffect::GetScopedLayer(vtkMRMLSliceLayerLogic * layerLogic)
 		this->scopedSlicePaint->SetWorkingImage(imageData);
 		this->scopedSlicePaint->SetExtractImage(this->scopedImageBuffer);
 
-		QList<int*> * corners = new QList<int*>;
-		this->GetVisibleCorners(layerLogic, corners);
+		QList<QVector<int> > corners = this->GetVisibleCorners(layerLogic);
 
 	
 		//Set the scoped corners,and update
-		this->scopedSlicePaint->SetTopLeft(corners->value(0));
-		this->scopedSlicePaint->SetTopRight(corners->value(1));
-		this->scopedSlicePaint->SetBottomLeft(corners->value(2));
-		this->scopedSlicePaint->SetBottomRight(corners->value(3));
+		this->scopedSlicePaint->SetTopLeft(corners[0].data());
+		this->scopedSlicePaint->SetTopRight(corners[1].data());
+		this->scopedSlicePaint->SetBottomLeft(corners[2].data());
+		this->scopedSlicePaint->SetBottomRight(corners[3].data());
 
 		this->scopedSlicePaint->Paint();
 		return this->scopedImageBuffer;
@@ -494,8 +493,14 @@ void qMRMLEffect::ApplyScopedLabel()
 	vtkMRMLVolumeNode * volumeNode = layerLogic->GetVolumeNode();
 
 	vtkImageData * targetImage = volumeNode->GetImageData();
+	vtkMRMLScene * scene = volumeNode->GetScene();
+	bool saveUndo = scene && scene->GetUndoFlag();
 	if (this->effectScope == qMRMLEffect::All)
 	{
+		if (saveUndo)
+		{
+			scene->SaveImageRegionStateForUndo(targetImage, targetImage->GetExtent(), volumeNode, true);
+		}
 		targetImage->DeepCopy(this->scopedImageBuffer);
 	}
 	else if (this->effectScope == qMRMLEffect::Visible)
@@ -503,17 +508,27 @@ void qMRMLEffect::ApplyScopedLabel()
 		this->scopedSlicePaint->SetWorkingImage(targetImage);
 		this->scopedSlicePaint->SetExtractImage(this->scopedImageBuffer);
 
-		QList<int*> * corners = new QList<int*>;
-		this->GetVisibleCorners(layerLogic, corners);
+		QList<QVector<int> > corners = this->GetVisibleCorners(layerLogic);
 
 
 		//Set the scoped corners,and update
-		this->scopedSlicePaint->SetTopLeft(corners->value(0));
-		this->scopedSlicePaint->SetTopRight(corners->value(1));
-		this->scopedSlicePaint->SetBottomLeft(corners->value(2));
-		this->scopedSlicePaint->SetBottomRight(corners->value(3));
+		this->scopedSlicePaint->SetTopLeft(corners[0].data());
+		this->scopedSlicePaint->SetTopRight(corners[1].data());
+		this->scopedSlicePaint->SetBottomLeft(corners[2].data());
+		this->scopedSlicePaint->SetBottomRight(corners[3].data());
+
+		//only the voxels within the visible corners change, save them for undo
+		int scopedExtent[6];
+		this->scopedSlicePaint->GetPaintExtent(scopedExtent);
+		if (saveUndo)
+		{
+			scene->SaveImageRegionStateForUndo(targetImage, scopedExtent, volumeNode, true);
+		}
 
 		this->scopedSlicePaint->Paint();
+
+		this->editorLogic->markVolumeNodeRegionAsModified(volumeNode, scopedExtent);
+		return;
 	}
 	else
 	{
@@ -524,41 +539,32 @@ void qMRMLEffect::ApplyScopedLabel()
 
 }
 
-void qMRMLEffect::GetVisibleCorners(vtkMRMLSliceLayerLogic * layerLogic, QList<int*> * out_ijkCorners)
+QList<QVector<int> > qMRMLEffect::GetVisibleCorners(vtkMRMLSliceLayerLogic * layerLogic)
 {
 	vtkGeneralTransform * xyToIJK = layerLogic->GetXYToIJKTransform();
 
 	//w:dims[0],h:dims[1],d:dims[2]
 	int * dims = layerLogic->GetImageData()->GetDimensions();
 
-	//Initial the Corner's XY 
-    double  tlxyCorner[3] = { 0, 0, 0 };
-	double  trxyCorner[3] = {double(dims[0]),0,0};
-	double  blxyCorner[3] = {0,double(dims[1]),0};
-	double  brxyCorner[3] = {double(dims[0]),double(dims[1])};
-
-	//tlijkCorner[3], trijkCorner[3], blijkCorner[3], brijkCorner[3];
-	double * tlCorner, *trCorner, *blCorner, *brCorner;
-
-	tlCorner = xyToIJK->TransformDoublePoint(tlxyCorner);
-	
-	trCorner = xyToIJK->TransformDoublePoint(trxyCorner);
-
-	blCorner = xyToIJK->TransformDoublePoint(blxyCorner);
-	
-	brCorner = xyToIJK->TransformDoublePoint(brxyCorner);
- 
-	int tlijkCorner[3] = {int(round(tlCorner[0])), int(round(tlCorner[1])), int(round(tlCorner[2])) };
-	int	trijkCorner[3] = { int(round(trCorner[0])), int(round(trCorner[1])), int(round(trCorner[2])) };
-	int	blijkCorner[3] = { int(round(blCorner[0])), int(round(blCorner[1])), int(round(blCorner[2])) };
-	int brijkCorner[3] = { int(round(brCorner[0])), int(round(brCorner[1])), int(round(brCorner[2])) };
-
-
-	//QList<double*> ijkCorners;
-	out_ijkCorners->append(tlijkCorner);
-	out_ijkCorners->append(trijkCorner);
-	out_ijkCorners->append(blijkCorner);
-	out_ijkCorners->append(brijkCorner);
+	//Corner's XY, in the order TopLeft, TopRight, BottomLeft, BottomRight
+	double xyCorners[4][3] = {
+		{ 0, 0, 0 },
+		{ double(dims[0]), 0, 0 },
+		{ 0, double(dims[1]), 0 },
+		{ double(dims[0]), double(dims[1]), 0 } };
 
+	QList<QVector<int> > ijkCorners;
+	for (int c = 0; c < 4; c++)
+	{
+		//TransformDoublePoint returns an internal buffer, reused by the next call
+		double * ijkCorner = xyToIJK->TransformDoublePoint(xyCorners[c]);
+		QVector<int> corner(3);
+		for (int i = 0; i < 3; i++)
+		{
+			corner[i] = int(round(ijkCorner[i]));
+		}
+		ijkCorners.append(corner);
+	}
+	return ijkCorners;
 }
 
@@ -33,6 +33,10 @@
 
 class vtkMRMLScene;
 
+// Qt includes
+#include <QList>
+#include <QVector>
+
 
 // VTK includes
 
@@ -145,7 +149,7 @@ if a subclass provides a list of scope options then a selection menu will be pro
   void ApplyScopedLabel();
 
   //Corners' order: TopLeft(ijkCorners[0]),TopRight(ijkCorners[1]),BottomLeft(ijkCorners[2]),BottomRight(ijkCorners[3])
-  void GetVisibleCorners(vtkMRMLSliceLayerLogic * layerLogic, QList<int*> * out_ijkCorners );
+  QList<QVector<int> > GetVisibleCorners(vtkMRMLSliceLayerLogic * layerLogic);
 
   bool IsObserving();
 
@@ -351,9 +351,23 @@ void qMRMLLabelEffect::ApplyImageMask(vtkMatrix4x4*maskIJKToRAS, vtkImageData*ma
 	this->painter->SetPaintLabel(this->paintLabel);
 	this->painter->SetPaintOver(this->paintOver);
 
+	//# only the voxels within the corners change
+	int paintExtent[6];
+	for (int i = 0; i < 3; i++)
+	{
+		paintExtent[2 * i] = std::min(std::min(tl[i], tr[i]), std::min(bl[i], br[i]));
+		paintExtent[2 * i + 1] = std::max(std::max(tl[i], tr[i]), std::max(bl[i], br[i]));
+	}
+
+	//# save only these voxels for undo, one undo level per applied polygon
+	if (labelNode->GetScene() && labelNode->GetScene()->GetUndoFlag())
+	{
+		labelNode->GetScene()->SaveImageRegionStateForUndo(labelImage, paintExtent, labelNode, true);
+	}
+
 	this->painter->Paint();
 
-	this->editorLogic->markVolumeNodeAsModified(labelNode);
+	this->editorLogic->markVolumeNodeRegionAsModified(labelNode, paintExtent);
 
 }
 
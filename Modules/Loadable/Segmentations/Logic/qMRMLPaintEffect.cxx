@@ -64,6 +64,11 @@ qMRMLPaintEffect::qMRMLPaintEffect()
 	this->paintLabel = 9; //number 9 used for temp label paint
 	
 	this->paintCoordinates = vtkPoints2D::New();
+	for (int i = 0; i < 3; i++)
+	{
+		this->paintedExtent[2 * i] = VTK_INT_MAX;
+		this->paintedExtent[2 * i + 1] = VTK_INT_MIN;
+	}
 	this->feedbackActors = vtkActor2DCollection::New();
 
 	this->brushActor = NULL;
@@ -506,11 +511,17 @@ void qMRMLPaintEffect::PaintFeedback()
 
 void qMRMLPaintEffect::PaintApply(int label)
 {
+	for (int i = 0; i < 3; i++)
+	{
+		this->paintedExtent[2 * i] = VTK_INT_MAX;
+		this->paintedExtent[2 * i + 1] = VTK_INT_MIN;
+	}
 	int nCoordinates = this->paintCoordinates->GetNumberOfPoints();
 	for (int i = 0;i < nCoordinates; i++)
 	{
 		double * xy = this->paintCoordinates->GetPoint(i);
-		this->PaintBrush(xy[0], xy[1],label);
+		// one undo level per applied stroke
+		this->PaintBrush(xy[0], xy[1],label, i == 0);
 	}
 	this->paintCoordinates->Reset();
 	this->PaintFeedback();
@@ -522,7 +533,11 @@ void qMRMLPaintEffect::PaintApply(int label)
 		
 	vtkMRMLSliceLayerLogic *labelLogic = this->sliceLogic->GetLabelLayer();
 	vtkMRMLVolumeNode *	labelNode = labelLogic->GetVolumeNode();
-	this->editorLogic->markVolumeNodeAsModified(labelNode);
+	//# only the voxels under the brushes changed
+	if (labelNode && this->paintedExtent[0] <= this->paintedExtent[1])
+	{
+		this->editorLogic->markVolumeNodeRegionAsModified(labelNode, this->paintedExtent);
+	}
 
 }
 
@@ -530,7 +545,7 @@ void qMRMLPaintEffect::PaintApply(int label)
 //(could be streched or rotate when transformed to IJK)
 //- make sure to hit every pixel in IJK space
 //- apply the threshold if selected
-void qMRMLPaintEffect::PaintBrush(double x, double y, int label)
+void qMRMLPaintEffect::PaintBrush(double x, double y, int label, bool newUndoLevel)
 {
 	vtkMRMLSliceNode * sliceNode = this->sliceLogic->GetSliceNode();
 
@@ -691,6 +706,22 @@ void qMRMLPaintEffect::PaintBrush(double x, double y, int label)
 	//this->painter->SetThresholdPaint(paintThreshold);
 	//this->painter->SetThresholdPaintRange(paintThresholdMin, paintThresholdMax);
 
+	//# IJK extent covered by the brush
+	int paintExtent[6];
+	for (int i = 0; i < 3; i++)
+	{
+		paintExtent[2 * i] = std::min(std::min(tl[i], tr[i]), std::min(bl[i], br[i]));
+		paintExtent[2 * i + 1] = std::max(std::max(tl[i], tr[i]), std::max(bl[i], br[i]));
+		this->paintedExtent[2 * i] = std::min(this->paintedExtent[2 * i], paintExtent[2 * i]);
+		this->paintedExtent[2 * i + 1] = std::max(this->paintedExtent[2 * i + 1], paintExtent[2 * i + 1]);
+	}
+
+	//# save only the voxels under the brush for undo
+	if (labelNode->GetScene() && labelNode->GetScene()->GetUndoFlag())
+	{
+		labelNode->GetScene()->SaveImageRegionStateForUndo(labelImage, paintExtent, labelNode, newUndoLevel);
+	}
+
 	this->painter->Paint();
 }
 
@@ -125,7 +125,8 @@ public:
   void PaintApply(int label);
 
   //Paint the Brush in x,y position and use  the label value
-  void PaintBrush(double x, double y,int label);
+  //The painted voxels are first saved for undo, in a new undo level if newUndoLevel is true
+  void PaintBrush(double x, double y,int label, bool newUndoLevel = false);
 
 
   void PaintPixel(double x, double y);
@@ -155,6 +156,8 @@ protected:
 	double * position;
 	vtkActor2DCollection * feedbackActors;
 	vtkPoints2D * paintCoordinates;
+	//IJK extent painted by the brushes of the current PaintApply
+	int paintedExtent[6];
 
 	vtkPolyData* brush;
 	vtkActor2D * brushActor;
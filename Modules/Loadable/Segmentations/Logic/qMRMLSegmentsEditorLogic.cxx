@@ -14,6 +14,7 @@ Version:   $Revision$
 
 // MRMLLogic includes
 #include "qMRMLSegmentsEditorLogic.h"
+#include "vtkSegmentationConverter.h"
 #include "vtkMRMLSliceLayerLogic.h"
 #include "qSlicerApplication.h"
 #include "qSlicerLayoutManager.h"
@@ -731,3 +732,18 @@ void qMRMLSegmentsEditorLogic::markVolumeNodeAsModified(vtkMRMLVolumeNode* volum
 	volumeNode->Modified();
 
 }
+
+void qMRMLSegmentsEditorLogic::markVolumeNodeRegionAsModified(vtkMRMLVolumeNode* volumeNode, int extent[6])
+{
+	if (volumeNode->GetImageDataConnection())
+	{
+		volumeNode->GetImageDataConnection()->GetProducer()->Update();
+	}
+	// The closed surface of the edited segment is then only extracted again in the slabs of the region
+	if (this->CurrentSegment && volumeNode->GetImageData() && this->CurrentSegment->GetRepresentation(
+		vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName()) == volumeNode->GetImageData())
+	{
+		this->CurrentSegment->LabelmapRegionModified(extent);
+	}
+	volumeNode->ImageDataRegionModified(extent);
+}
@@ -146,6 +146,9 @@ public:
 	void ToggleCrosshair();
 	void ToggleForegroundBackground();
 	void markVolumeNodeAsModified(vtkMRMLVolumeNode* volumeNode);
+	//Mark only the voxels of the IJK extent as modified, so that the views
+	//not showing the region are not updated
+	void markVolumeNodeRegionAsModified(vtkMRMLVolumeNode* volumeNode, int extent[6]);
 
 
 
@@ -19,6 +19,9 @@
 #include <vtkObjectFactory.h>
 #include <vtkVersion.h>
 
+// STD includes
+#include <algorithm>
+
 
 vtkStandardNewMacro(vtkImageSlicePaint);
 
@@ -412,6 +415,31 @@ void vtkImageSlicePaint::Paint()
   return;
 }
 
+//----------------------------------------------------------------------------
+void vtkImageSlicePaint::GetPaintExtent(int extent[6])
+{
+  int *corners[4] = {this->TopLeft, this->TopRight, this->BottomLeft, this->BottomRight};
+  for (int i = 0; i < 3; i++)
+    {
+    extent[2*i] = corners[0][i];
+    extent[2*i+1] = corners[0][i];
+    for (int c = 1; c < 4; c++)
+      {
+      extent[2*i] = std::min(extent[2*i], corners[c][i]);
+      extent[2*i+1] = std::max(extent[2*i+1], corners[c][i]);
+      }
+    }
+  if (this->WorkingImage)
+    {
+    const int *workingExtent = this->WorkingImage->GetExtent();
+    for (int i = 0; i < 6; i += 2)
+      {
+      extent[i] = std::max(extent[i], workingExtent[i]);
+      extent[i+1] = std::min(extent[i+1], workingExtent[i+1]);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void vtkImageSlicePaint::PrintSelf(ostream& os, vtkIndent indent)
 {
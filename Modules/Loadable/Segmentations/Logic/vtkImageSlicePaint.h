@@ -141,6 +141,12 @@ public:
   /// Apply the paint operation
   void Paint();
 
+  ///
+  /// Get the IJK extent of the Working image that Paint() can modify: the
+  /// bounding box of the four corners, clipped to the Working image extent.
+  /// The extent is empty (min > max) if the region is outside the image.
+  void GetPaintExtent(int extent[6]);
+
 protected:
   vtkImageSlicePaint();
   ~vtkImageSlicePaint();
@@ -346,6 +346,13 @@ void vtkSlicerSegmentationsModuleLogic::SetMRMLSceneInternal(vtkMRMLScene* newSc
   events->InsertNextValue(vtkMRMLScene::EndImportEvent);
   this->SetAndObserveMRMLSceneEvents(newScene, events.GetPointer());
 
+  // Segmentation edits save the whole scene for undo: only copy the nodes
+  // that changed since the previous undo level
+  if (newScene)
+  {
+    newScene->SetDeltaUndo(true);
+  }
+
   //Setup the Scene of EditorLogic
   this->GetEditorLogic()->SetMRMLScene(newScene);
 
@@ -1315,11 +1322,20 @@ void vtkSlicerSegmentationsModuleLogic::UpdateClosedSurfaceFromLabelMapImageForS
 
 	
     vtkMRMLLabelMapVolumeNode * labelMapNode = GetLabelMapVolumeNodebyImageData(scene, labelImage);
+	if (!labelMapNode)
+	{
+		std::cerr << "vtkSlicerSegmentationsModuleLogic::UpdateClosedSurfaceFromLabelMapImageForSegment: No labelmap volume node for the segment!";
+		return;
+	}
 
-
-	vtkOrientedImageData* orientedimage = vtkSlicerSegmentationsModuleLogic::CreateOrientedImageDataFromVolumeNode(labelMapNode);
-
-
+	// Share the voxels of the labelmap node instead of copying them, so that the surface filter
+	// of the segment can tell which slabs were painted since the previous conversion
+	vtkSmartPointer<vtkOrientedImageData> orientedimage = vtkSmartPointer<vtkOrientedImageData>::New();
+	orientedimage->vtkImageData::ShallowCopy(labelImage);
+	vtkSmartPointer<vtkMatrix4x4> ijkToRasMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+	labelMapNode->GetIJKToRASMatrix(ijkToRasMatrix);
+	orientedimage->SetGeometryFromImageToWorldMatrix(ijkToRasMatrix);
+	vtkSlicerSegmentationsModuleLogic::ApplyParentTransformToOrientedImageData(labelMapNode, orientedimage);
 
 
 
@@ -1331,22 +1347,23 @@ void vtkSlicerSegmentationsModuleLogic::UpdateClosedSurfaceFromLabelMapImageForS
 
 	if (!closedSurface)
 	{
-		closedSurface = vtkPolyData::New();	
-		vtkSlicerSegmentationsModuleLogic::ConvertLabelmapToClosedSurface(orientedimage,closedSurface,label);
+		vtkSmartPointer<vtkPolyData> newClosedSurface = vtkSmartPointer<vtkPolyData>::New();
+		vtkSlicerSegmentationsModuleLogic::ConvertLabelmapToClosedSurface(orientedimage, newClosedSurface, label, segment->GetLabelmapSurfaceFilter());
 
-		segment->AddRepresentation(closedSurfaceName, closedSurface);
+		segment->AddRepresentation(closedSurfaceName, newClosedSurface);
 	}
 	else
 	{
-		vtkSlicerSegmentationsModuleLogic::ConvertLabelmapToClosedSurface(orientedimage, closedSurface, label);
+		vtkSlicerSegmentationsModuleLogic::ConvertLabelmapToClosedSurface(orientedimage, closedSurface, label, segment->GetLabelmapSurfaceFilter());
 	}
 
 }
 
-bool vtkSlicerSegmentationsModuleLogic::ConvertLabelmapToClosedSurface(vtkOrientedImageData* labelMapImage, vtkPolyData* closedSurface, int Label)
+bool vtkSlicerSegmentationsModuleLogic::ConvertLabelmapToClosedSurface(vtkOrientedImageData* labelMapImage, vtkPolyData* closedSurface, int Label,
+	vtkParallelLabelmapToSurfaceFilter* surfaceFilter/*=NULL*/)
 {
 
-	vtkBinaryLabelmapToClosedSurfaceConversionRule * conversionRule = vtkBinaryLabelmapToClosedSurfaceConversionRule::New();
+	vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule> conversionRule = vtkSmartPointer<vtkBinaryLabelmapToClosedSurfaceConversionRule>::New();
 
 	conversionRule->SetConversionParameter(conversionRule->GetDecimationFactorParameterName(),
 		"0.6", "Desired reduction in the total number of polygons (e.g., if set to 0.9, then reduce the data set to 10% of its original size)");
@@ -1354,7 +1371,8 @@ bool vtkSlicerSegmentationsModuleLogic::ConvertLabelmapToClosedSurface(vtkOrient
 	conversionRule->SetConversionParameter(conversionRule->GetSmoothingFactorParameterName(),
 		"0.3", "Relaxation factor for Laplacian smoothing. Value of 0 results in no smoothing, while 1 means significant smoothing.");
 
-	return conversionRule->ConvertUseLabel(labelMapImage, closedSurface, Label);
+	// The marching cubes slab surfaces of the filter are reused, decimation and smoothing run on the whole surface
+	return conversionRule->ConvertUseLabel(labelMapImage, closedSurface, Label, surfaceFilter);
 
 }
 
@@ -39,6 +39,7 @@ class vtkOrientedImageData;
 class vtkDataObject;
 class vtkGeneralTransform;
 class vtkPolyData;
+class vtkParallelLabelmapToSurfaceFilter;
 
 
 class vtkMRMLScalarVolumeNode;
@@ -232,7 +233,11 @@ public:
   //vtkSlicerVolumesLogic * GetVolumesLogic();
  // void SetVolumesLogic(vtkSlicerVolumesLogic * volumeslogic);
 
-  static bool ConvertLabelmapToClosedSurface(vtkOrientedImageData* labelMapImage, vtkPolyData* closedSurface, int Label =1);
+  /// Convert a labelmap to a closed surface with the default conversion parameters.
+  /// \param surfaceFilter Surface filter that keeps the surface of the slabs between conversions
+  ///   (e.g. vtkSegment::GetLabelmapSurfaceFilter), only the modified slabs are extracted again. Optional.
+  static bool ConvertLabelmapToClosedSurface(vtkOrientedImageData* labelMapImage, vtkPolyData* closedSurface, int Label =1,
+    vtkParallelLabelmapToSurfaceFilter* surfaceFilter=NULL);
 
 protected:
   virtual void SetMRMLSceneInternal(vtkMRMLScene * newScene);
@@ -0,0 +1,156 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Segmentations includes
+#include "vtkImageSlicePaint.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Replace the voxels of the slice given by the corners with 1 and check that
+// the extent reported by GetPaintExtent() covers every painted voxel.
+int TestPaintExtent(int topLeft[3], int topRight[3], int bottomLeft[3], int bottomRight[3],
+                    int expectedExtent[6])
+{
+  vtkNew<vtkImageData> workingImage;
+  workingImage->SetDimensions(30, 30, 20);
+  workingImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* voxels = static_cast<unsigned char*>(workingImage->GetScalarPointer());
+  vtkIdType numberOfVoxels = workingImage->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    voxels[i] = 0;
+    }
+
+  vtkNew<vtkImageSlicePaint> slicePaint;
+  slicePaint->SetWorkingImage(workingImage.GetPointer());
+  slicePaint->SetTopLeft(topLeft);
+  slicePaint->SetTopRight(topRight);
+  slicePaint->SetBottomLeft(bottomLeft);
+  slicePaint->SetBottomRight(bottomRight);
+
+  // extract the slice to get its size, the brush is empty
+  vtkNew<vtkImageData> sliceImage;
+  slicePaint->SetExtractImage(sliceImage.GetPointer());
+  slicePaint->Paint();
+  slicePaint->SetExtractImage(NULL);
+
+  // paint the whole slice back
+  unsigned char* sliceVoxels = static_cast<unsigned char*>(sliceImage->GetScalarPointer());
+  for (vtkIdType i = 0; i < sliceImage->GetNumberOfPoints(); ++i)
+    {
+    sliceVoxels[i] = 1;
+    }
+  slicePaint->SetReplaceImage(sliceImage.GetPointer());
+  slicePaint->Paint();
+
+  int paintExtent[6];
+  slicePaint->GetPaintExtent(paintExtent);
+  for (int i = 0; i < 6; ++i)
+    {
+    if (paintExtent[i] != expectedExtent[i])
+      {
+      std::cerr << "Line " << __LINE__ << ": unexpected paint extent: "
+                << paintExtent[0] << " " << paintExtent[1] << " "
+                << paintExtent[2] << " " << paintExtent[3] << " "
+                << paintExtent[4] << " " << paintExtent[5] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  int dims[3];
+  workingImage->GetDimensions(dims);
+  int numberOfPaintedVoxels = 0;
+  for (int k = 0; k < dims[2]; ++k)
+    {
+    for (int j = 0; j < dims[1]; ++j)
+      {
+      for (int i = 0; i < dims[0]; ++i)
+        {
+        if (*static_cast<unsigned char*>(workingImage->GetScalarPointer(i, j, k)) == 0)
+          {
+          continue;
+          }
+        ++numberOfPaintedVoxels;
+        if (i < paintExtent[0] || i > paintExtent[1] ||
+            j < paintExtent[2] || j > paintExtent[3] ||
+            k < paintExtent[4] || k > paintExtent[5])
+          {
+          std::cerr << "Line " << __LINE__ << ": painted voxel " << i << " " << j << " " << k
+                    << " is outside of the paint extent" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+  if (numberOfPaintedVoxels == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": nothing was painted" << std::endl;
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkImageSlicePaintTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv)[])
+{
+  // axial slice
+  int axialTopLeft[3] = {2, 3, 5};
+  int axialTopRight[3] = {25, 3, 5};
+  int axialBottomLeft[3] = {2, 27, 5};
+  int axialBottomRight[3] = {25, 27, 5};
+  int axialExtent[6] = {2, 25, 3, 27, 5, 5};
+  if (TestPaintExtent(axialTopLeft, axialTopRight, axialBottomLeft, axialBottomRight,
+                      axialExtent) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // oblique slice
+  int obliqueTopLeft[3] = {0, 0, 2};
+  int obliqueTopRight[3] = {20, 0, 12};
+  int obliqueBottomLeft[3] = {0, 20, 2};
+  int obliqueBottomRight[3] = {20, 20, 12};
+  int obliqueExtent[6] = {0, 20, 0, 20, 2, 12};
+  if (TestPaintExtent(obliqueTopLeft, obliqueTopRight, obliqueBottomLeft, obliqueBottomRight,
+                      obliqueExtent) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  // slice larger than the image (zoomed out view), clipped to the image
+  int largeTopLeft[3] = {-10, -10, 7};
+  int largeTopRight[3] = {40, -10, 7};
+  int largeBottomLeft[3] = {-10, 40, 7};
+  int largeBottomRight[3] = {40, 40, 7};
+  int largeExtent[6] = {0, 29, 0, 29, 7, 7};
+  if (TestPaintExtent(largeTopLeft, largeTopRight, largeBottomLeft, largeBottomRight,
+                      largeExtent) != EXIT_SUCCESS)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -23,6 +23,8 @@
 #include <QFileDialog>
 #include <QApplication>
 #include <QClipboard>
+#include <QDebug>
+#include <QProgressDialog>
 #include <QStringBuilder>
 
 // C++ includes
@@ -41,9 +43,11 @@
 // MRML includes
 #include "vtkMRMLTransformNode.h"
 #include "vtkMRMLTransformDisplayNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLScene.h"
 
 // VTK includes
+#include <vtkCommand.h>
 #include <vtkNew.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransform.h>
@@ -61,6 +65,7 @@ public:
   vtkMRMLTransformNode*         MRMLTransformNode;
   QAction*                      CopyAction;
   QAction*                      PasteAction;
+  QProgressDialog*              ConvertProgressDialog;
 };
 
 //-----------------------------------------------------------------------------
@@ -70,6 +75,7 @@ qSlicerTransformsModuleWidgetPrivate::qSlicerTransformsModuleWidgetPrivate(qSlic
   this->MRMLTransformNode = 0;
   this->CopyAction = 0;
   this->PasteAction = 0;
+  this->ConvertProgressDialog = 0;
 }
 //-----------------------------------------------------------------------------
 vtkSlicerTransformLogic* qSlicerTransformsModuleWidgetPrivate::logic()const
@@ -150,6 +156,14 @@ void qSlicerTransformsModuleWidget::setup()
                 SIGNAL(clicked()),
                 SLOT(split()));
 
+  // Connect convert section
+  this->connect(d->ConvertReferenceVolumeNodeComboBox,
+                SIGNAL(currentNodeChanged(vtkMRMLNode*)),
+                SLOT(updateConvertButtonState()));
+  this->connect(d->ConvertPushButton,
+                SIGNAL(clicked()),
+                SLOT(convert()));
+
   // Connect node selector with module itself
   this->connect(d->TransformNodeSelector,
                 SIGNAL(currentNodeChanged(vtkMRMLNode*)),
@@ -240,6 +254,9 @@ void qSlicerTransformsModuleWidget::onNodeSelected(vtkMRMLNode* node)
 
   d->SplitPushButton->setVisible(isCompositeTransform);
 
+  d->ConvertPushButton->setEnabled(transformNode != 0
+    && d->ConvertReferenceVolumeNodeComboBox->currentNode() != 0);
+
   QStringList nodeTypes;
   // If no transform node, it would show the entire scene, lets shown none
   // instead.
@@ -543,3 +560,93 @@ void qSlicerTransformsModuleWidget::onTransformableSectionClicked(bool clicked)
     d->BottomSpacer->changeSize(1,1, QSizePolicy::Fixed, QSizePolicy::Expanding);
     }
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformsModuleWidget::updateConvertButtonState()
+{
+  Q_D(qSlicerTransformsModuleWidget);
+  d->ConvertPushButton->setEnabled(d->MRMLTransformNode != 0
+    && d->ConvertReferenceVolumeNodeComboBox->currentNode() != 0);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformsModuleWidget::convert()
+{
+  Q_D(qSlicerTransformsModuleWidget);
+  vtkMRMLVolumeNode* referenceVolumeNode = vtkMRMLVolumeNode::SafeDownCast(
+    d->ConvertReferenceVolumeNodeComboBox->currentNode());
+  if (!d->MRMLTransformNode || !referenceVolumeNode || !d->logic())
+    {
+    return;
+    }
+  vtkMRMLDisplayableNode* roiNode = vtkMRMLDisplayableNode::SafeDownCast(
+    d->ConvertRoiNodeComboBox->currentNode());
+
+  // 0 means the spacing of the reference volume
+  double spacingValue = d->ConvertSpacingSpinBox->value();
+  double outputSpacing[3] = { spacingValue, spacingValue, spacingValue };
+  double* outputSpacingPtr = (spacingValue > 0.0 ? outputSpacing : NULL);
+
+  QApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
+
+  this->qvtkConnect(d->logic(), vtkCommand::ProgressEvent, this, SLOT(onConvertProgress(vtkObject*, void*)));
+  d->ConvertProgressDialog = new QProgressDialog(tr("Converting transform..."), tr("Cancel"), 0, 100, this);
+  d->ConvertProgressDialog->setWindowModality(Qt::WindowModal);
+  d->ConvertProgressDialog->setMinimumDuration(150);
+  d->ConvertProgressDialog->setValue(0);
+
+  bool success = false;
+  switch (d->ConvertOutputComboBox->currentIndex())
+    {
+    case 0:
+    case 1:
+      {
+      bool magnitude = (d->ConvertOutputComboBox->currentIndex() == 0);
+      success = (d->logic()->CreateDisplacementVolumeFromTransform(d->MRMLTransformNode,
+        referenceVolumeNode, magnitude, roiNode, outputSpacingPtr) != NULL);
+      break;
+      }
+    case 2:
+      {
+      vtkMRMLTransformNode* gridTransformNode = d->logic()->ConvertToGridTransform(d->MRMLTransformNode,
+        referenceVolumeNode, roiNode, outputSpacingPtr);
+      success = (gridTransformNode != NULL);
+      if (gridTransformNode)
+        {
+        d->TransformNodeSelector->setCurrentNode(gridTransformNode);
+        }
+      break;
+      }
+    default:
+      break;
+    }
+  bool aborted = d->logic()->GetAbortConversion();
+
+  this->qvtkDisconnect(d->logic(), vtkCommand::ProgressEvent, this, SLOT(onConvertProgress(vtkObject*, void*)));
+  delete d->ConvertProgressDialog;
+  d->ConvertProgressDialog = 0;
+
+  QApplication::restoreOverrideCursor();
+
+  if (!success && !aborted)
+    {
+    qWarning() << "qSlicerTransformsModuleWidget::convert failed: the transform could not be sampled on the reference volume";
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerTransformsModuleWidget::onConvertProgress(vtkObject* vtkNotUsed(caller), void* callData)
+{
+  Q_D(qSlicerTransformsModuleWidget);
+  double* progress = reinterpret_cast<double*>(callData);
+  if (!d->ConvertProgressDialog || !progress)
+    {
+    return;
+    }
+  d->ConvertProgressDialog->setValue(static_cast<int>((*progress) * 100.0));
+  QApplication::processEvents();
+  if (d->ConvertProgressDialog->wasCanceled())
+    {
+    d->logic()->SetAbortConversion(true);
+    }
+}
@@ -29,6 +29,7 @@
 
 class vtkMatrix4x4;
 class vtkMRMLNode;
+class vtkObject;
 class qSlicerTransformsModuleWidgetPrivate;
 
 class Q_SRPlan_QTMODULES_TRANSFORMS_EXPORT qSlicerTransformsModuleWidget :
@@ -57,6 +58,11 @@ public slots:
   /// Split composite transform to its components
   void split();
 
+  /// Sample the current transform on the reference volume of the convert section
+  /// into a displacement volume or a grid transform.
+  /// A progress dialog lets the user cancel the conversion.
+  void convert();
+
 protected:
 
   virtual void setup();
@@ -77,6 +83,9 @@ protected slots:
   void onDisplaySectionClicked(bool);
   void onTransformableSectionClicked(bool);
 
+  void updateConvertButtonState();
+  void onConvertProgress(vtkObject* caller, void* callData);
+
 protected:
   ///
   /// Convenient method to return the coordinate system currently selected